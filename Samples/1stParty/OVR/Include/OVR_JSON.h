@@ -58,6 +58,7 @@ Notes       :
 #include <string>
 #include <list>
 #include <fstream>
+#include <functional>
 
 #include "OVR_Types.h"
 #include "OVR_Math.h"
@@ -166,6 +167,162 @@ inline const char* ParseHex(unsigned* val, unsigned digits, const char* str) {
     return str;
 }
 
+//-----------------------------------------------------------------------------
+// Parses a JSON number into *value.
+// Returns the first character after the number.
+inline const char* ParseNumber(const char* num, double* value) {
+    double n = 0, sign = 1, scale = 0;
+    int subscale = 0, signsubscale = 1;
+
+    // Could use sscanf for this?
+    if (*num == '-') {
+        sign = -1, num++; // Has sign?
+    }
+    if (*num == '0') {
+        num++; // is zero
+    }
+
+    if (*num >= '1' && *num <= '9') {
+        do {
+            n = (n * 10.0) + (*num++ - '0');
+        } while (*num >= '0' && *num <= '9'); // Number?
+    }
+
+    if (*num == '.' && num[1] >= '0' && num[1] <= '9') {
+        num++;
+        do {
+            n = (n * 10.0) + (*num++ - '0');
+            scale--;
+        } while (*num >= '0' && *num <= '9'); // Fractional part?
+    }
+
+    if (*num == 'e' || *num == 'E') // Exponent?
+    {
+        num++;
+        if (*num == '+') {
+            num++;
+        } else if (*num == '-') {
+            signsubscale = -1;
+            num++; // With sign?
+        }
+
+        while (*num >= '0' && *num <= '9') {
+            subscale = (subscale * 10) + (*num++ - '0'); // Number?
+        }
+    }
+
+    // Number = +/- number.fraction * 10^+/- exponent
+    *value = sign * n * pow(10.0, (scale + subscale * signsubscale));
+
+    return num;
+}
+
+//-----------------------------------------------------------------------------
+// Un-escapes the body of a JSON string, starting just after the opening quote,
+// into out. The output is never longer than the input, so out may point into
+// the input buffer as long as it is before ptr. Stores the end of the output in
+// *outEnd and returns a pointer to the closing quote (or the terminator).
+inline const char* UnescapeString(const char* ptr, char* out, char** outEnd) {
+    const char* p;
+    char* ptr2 = out;
+    int len = 0;
+    unsigned uc, uc2;
+
+    while (*ptr != '\"' && *ptr) {
+        if (*ptr != '\\') {
+            *ptr2++ = *ptr++;
+        } else {
+            ptr++;
+            switch (*ptr) {
+                case 'b':
+                    *ptr2++ = '\b';
+                    break;
+                case 'f':
+                    *ptr2++ = '\f';
+                    break;
+                case 'n':
+                    *ptr2++ = '\n';
+                    break;
+                case 'r':
+                    *ptr2++ = '\r';
+                    break;
+                case 't':
+                    *ptr2++ = '\t';
+                    break;
+
+                // Transcode utf16 to utf8.
+                case 'u':
+
+                    // Get the unicode char.
+                    p = ParseHex(&uc, 4, ptr + 1);
+                    if (ptr != p)
+                        ptr = p - 1;
+
+                    if ((uc >= 0xDC00 && uc <= 0xDFFF) || uc == 0)
+                        break; // Check for invalid.
+
+                    // UTF16 surrogate pairs.
+                    if (uc >= 0xD800 && uc <= 0xDBFF) {
+                        if (ptr[1] != '\\' || ptr[2] != 'u')
+                            break; // Missing second-half of surrogate.
+
+                        p = ParseHex(&uc2, 4, ptr + 3);
+                        if (ptr != p)
+                            ptr = p - 1;
+
+                        if (uc2 < 0xDC00 || uc2 > 0xDFFF)
+                            break; // Invalid second-half of surrogate.
+
+                        uc = 0x10000 + (((uc & 0x3FF) << 10) | (uc2 & 0x3FF));
+                    }
+
+                    len = 4;
+
+                    if (uc < 0x80)
+                        len = 1;
+                    else if (uc < 0x800)
+                        len = 2;
+                    else if (uc < 0x10000)
+                        len = 3;
+
+                    ptr2 += len;
+
+                    switch (len) {
+                        case 4:
+                            *--ptr2 = static_cast<char>((uc | 0x80) & 0xBF);
+                            uc >>= 6;
+                            [[fallthrough]];
+                        case 3:
+                            *--ptr2 = static_cast<char>((uc | 0x80) & 0xBF);
+                            uc >>= 6;
+                            [[fallthrough]];
+                        case 2:
+                            *--ptr2 = static_cast<char>((uc | 0x80) & 0xBF);
+                            uc >>= 6;
+                            [[fallthrough]];
+                        case 1:
+                            *--ptr2 = (char)(uc | firstByteMark[len]);
+                            // no break
+                    }
+                    ptr2 += len;
+                    break;
+
+                default:
+                    if (*ptr) {
+                        *ptr2++ = *ptr;
+                    }
+                    break;
+            }
+            if (*ptr) {
+                ptr++;
+            }
+        }
+    }
+
+    *outEnd = ptr2;
+    return ptr;
+}
+
 //-----------------------------------------------------------------------------
 // Render the string provided to an escaped version that can be printed.
 inline char* PrintString(const char* str) {
@@ -263,6 +420,10 @@ class JSON {
     JSON(JSONItemType itemType = JSON_Object) : Type(itemType), dValue(0.0) {}
     ~JSON() {}
 
+    JSONItemType GetType() const {
+        return Type;
+    }
+
     // *** Creation of NEW JSON objects
 
     static std::shared_ptr<JSON> CreateObject() {
@@ -643,52 +804,10 @@ class JSON {
     }
     const char* parseNumber(const char* num) {
         const char* num_start = num;
-        double n = 0, sign = 1, scale = 0;
-        int subscale = 0, signsubscale = 1;
-
-        // Could use sscanf for this?
-        if (*num == '-') {
-            sign = -1, num++; // Has sign?
-        }
-        if (*num == '0') {
-            num++; // is zero
-        }
-
-        if (*num >= '1' && *num <= '9') {
-            do {
-                n = (n * 10.0) + (*num++ - '0');
-            } while (*num >= '0' && *num <= '9'); // Number?
-        }
-
-        if (*num == '.' && num[1] >= '0' && num[1] <= '9') {
-            num++;
-            do {
-                n = (n * 10.0) + (*num++ - '0');
-                scale--;
-            } while (*num >= '0' && *num <= '9'); // Fractional part?
-        }
-
-        if (*num == 'e' || *num == 'E') // Exponent?
-        {
-            num++;
-            if (*num == '+') {
-                num++;
-            } else if (*num == '-') {
-                signsubscale = -1;
-                num++; // With sign?
-            }
-
-            while (*num >= '0' && *num <= '9') {
-                subscale = (subscale * 10) + (*num++ - '0'); // Number?
-            }
-        }
-
-        // Number = +/- number.fraction * 10^+/- exponent
-        n = sign * n * pow(10.0, (scale + subscale * signsubscale));
+        num = ParseNumber(num, &dValue);
 
         // Assign parsed value.
         Type = JSON_Number;
-        dValue = n;
         Value.assign(num_start, num - num_start);
 
         return num;
@@ -789,11 +908,8 @@ class JSON {
     }
     const char* parseString(const char* str, const char** perror) {
         const char* ptr = str + 1;
-        const char* p;
-        char* ptr2;
         char* out;
         int len = 0;
-        unsigned uc, uc2;
 
         if (*str != '\"') {
             return AssignError(perror, "Syntax Error: Missing quote");
@@ -818,101 +934,10 @@ class JSON {
         if (!out)
             return 0;
 
-        ptr = str + 1;
-        ptr2 = out;
-
-        while (*ptr != '\"' && *ptr) {
-            if (*ptr != '\\') {
-                *ptr2++ = *ptr++;
-            } else {
-                ptr++;
-                switch (*ptr) {
-                    case 'b':
-                        *ptr2++ = '\b';
-                        break;
-                    case 'f':
-                        *ptr2++ = '\f';
-                        break;
-                    case 'n':
-                        *ptr2++ = '\n';
-                        break;
-                    case 'r':
-                        *ptr2++ = '\r';
-                        break;
-                    case 't':
-                        *ptr2++ = '\t';
-                        break;
-
-                    // Transcode utf16 to utf8.
-                    case 'u':
-
-                        // Get the unicode char.
-                        p = ParseHex(&uc, 4, ptr + 1);
-                        if (ptr != p)
-                            ptr = p - 1;
-
-                        if ((uc >= 0xDC00 && uc <= 0xDFFF) || uc == 0)
-                            break; // Check for invalid.
-
-                        // UTF16 surrogate pairs.
-                        if (uc >= 0xD800 && uc <= 0xDBFF) {
-                            if (ptr[1] != '\\' || ptr[2] != 'u')
-                                break; // Missing second-half of surrogate.
-
-                            p = ParseHex(&uc2, 4, ptr + 3);
-                            if (ptr != p)
-                                ptr = p - 1;
-
-                            if (uc2 < 0xDC00 || uc2 > 0xDFFF)
-                                break; // Invalid second-half of surrogate.
-
-                            uc = 0x10000 + (((uc & 0x3FF) << 10) | (uc2 & 0x3FF));
-                        }
-
-                        len = 4;
-
-                        if (uc < 0x80)
-                            len = 1;
-                        else if (uc < 0x800)
-                            len = 2;
-                        else if (uc < 0x10000)
-                            len = 3;
-
-                        ptr2 += len;
-
-                        switch (len) {
-                            case 4:
-                                *--ptr2 = static_cast<char>((uc | 0x80) & 0xBF);
-                                uc >>= 6;
-                                [[fallthrough]];
-                            case 3:
-                                *--ptr2 = static_cast<char>((uc | 0x80) & 0xBF);
-                                uc >>= 6;
-                                [[fallthrough]];
-                            case 2:
-                                *--ptr2 = static_cast<char>((uc | 0x80) & 0xBF);
-                                uc >>= 6;
-                                [[fallthrough]];
-                            case 1:
-                                *--ptr2 = (char)(uc | firstByteMark[len]);
-                                // no break
-                        }
-                        ptr2 += len;
-                        break;
-
-                    default:
-                        if (*ptr) {
-                            *ptr2++ = *ptr;
-                        }
-                        break;
-                }
-                if (*ptr) {
-                    ptr++;
-                }
-            }
-        }
+        char* outEnd = out;
+        ptr = UnescapeString(str + 1, out, &outEnd);
 
-        *ptr2 = 0;
+        *outEnd = 0;
         if (*ptr == '\"')
             ptr++;
 
@@ -1130,7 +1155,834 @@ class JSON {
         return out;
     }
 
-    friend class JsonReader;
+    template <typename NodeRef>
+    friend class JsonReaderT;
+};
+
+//-----------------------------------------------------------------------------
+// ***** JsonPullParser
+
+// JSONToken describes the event most recently returned by JsonPullParser.
+enum JSONToken {
+    JSON_Token_Error = 0,
+    JSON_Token_EndOfDocument = 1,
+    JSON_Token_BeginObject = 2,
+    JSON_Token_EndObject = 3,
+    JSON_Token_BeginArray = 4,
+    JSON_Token_EndArray = 5,
+    JSON_Token_Name = 6,
+    JSON_Token_Null = 7,
+    JSON_Token_Bool = 8,
+    JSON_Token_Number = 9,
+    JSON_Token_String = 10
+};
+
+// Event based (pull) JSON parser. Each call to Next() reads one token from the
+// text, so a loader can fill in its own data structures while it walks the
+// text once, without building a tree first. Strings are un-escaped in place in
+// a private copy of the text, so GetString() pointers remain valid for the
+// lifetime of the parser, and parsing does not allocate per value.
+//
+// This is an example of how the indices of a simplified triangle model can be read:
+//
+//	JsonPullParser parser( text, textLength );
+//	if ( parser.Next() == JSON_Token_BeginObject )
+//	{
+//		while ( parser.NextMember() )
+//		{
+//			if ( OVR_strcmp( parser.GetString(), "indices" ) != 0 )
+//			{
+//				parser.SkipValue();
+//				continue;
+//			}
+//			if ( parser.Next() == JSON_Token_BeginArray )
+//			{
+//				while ( parser.NextElement() )
+//				{
+//					if ( parser.GetToken() == JSON_Token_Number )
+//					{
+//						indices.push_back( (int)parser.GetNumber() );
+//					}
+//					parser.SkipValue();
+//				}
+//			}
+//		}
+//	}
+//	if ( parser.GetToken() == JSON_Token_Error ) ...
+//
+// SkipValue() skips whatever value starts at the current token. If the current
+// token is a member name, it skips the value of that member.
+
+class JsonPullParser {
+   public:
+    JsonPullParser(const char* buff, const size_t length)
+        : Ptr(nullptr),
+          Token(JSON_Token_Error),
+          State(STATE_VALUE),
+          String(nullptr),
+          Number(0.0),
+          Error(nullptr) {
+        if (buff == nullptr) {
+            Error = "Error: Invalid buffer";
+            return;
+        }
+        Text.resize(length + 1);
+        memcpy(Text.data(), buff, length);
+        Text[length] = '\0';
+        Ptr = Text.data();
+        Token = JSON_Token_EndOfDocument; // anything but an error
+    }
+    explicit JsonPullParser(const char* buff)
+        : JsonPullParser(buff, (buff != nullptr) ? OVR_strlen(buff) : 0) {}
+
+    // Reads the next token.
+    JSONToken Next() {
+        if (Error != nullptr) {
+            return Token = JSON_Token_Error;
+        }
+
+        Ptr = skipWhitespace(Ptr);
+        switch (State) {
+            case STATE_VALUE:
+                return readValue();
+            case STATE_FIRST_MEMBER:
+                if (*Ptr == '}') {
+                    Ptr++;
+                    return endContainer(JSON_Token_EndObject);
+                }
+                return readName();
+            case STATE_FIRST_ELEMENT:
+                if (*Ptr == ']') {
+                    Ptr++;
+                    return endContainer(JSON_Token_EndArray);
+                }
+                return readValue();
+            case STATE_NEXT:
+                if (Stack.back() == JSON_Object) {
+                    if (*Ptr == '}') {
+                        Ptr++;
+                        return endContainer(JSON_Token_EndObject);
+                    }
+                    if (*Ptr != ',') {
+                        return setError("Syntax Error: Missing closing brace");
+                    }
+                    Ptr = skipWhitespace(Ptr + 1);
+                    return readName();
+                } else {
+                    if (*Ptr == ']') {
+                        Ptr++;
+                        return endContainer(JSON_Token_EndArray);
+                    }
+                    if (*Ptr != ',') {
+                        return setError("Syntax Error: Missing ending bracket");
+                    }
+                    Ptr = skipWhitespace(Ptr + 1);
+                    return readValue();
+                }
+            case STATE_DONE:
+                break;
+        }
+        return Token = JSON_Token_EndOfDocument;
+    }
+
+    JSONToken GetToken() const {
+        return Token;
+    }
+    // Name of a JSON_Token_Name or value of a JSON_Token_String.
+    const char* GetString() const {
+        OVR_ASSERT(Token == JSON_Token_Name || Token == JSON_Token_String);
+        return String;
+    }
+    // Value of a JSON_Token_Number or JSON_Token_Bool.
+    double GetNumber() const {
+        OVR_ASSERT(Token == JSON_Token_Number || Token == JSON_Token_Bool);
+        return Number;
+    }
+    bool GetBool() const {
+        OVR_ASSERT(Token == JSON_Token_Number || Token == JSON_Token_Bool);
+        return Number != 0.0;
+    }
+    // Returns a description of the syntax error, or nullptr if there is none.
+    const char* GetError() const {
+        return Error;
+    }
+    // Number of objects and arrays that are currently open.
+    size_t GetDepth() const {
+        return Stack.size();
+    }
+
+    // Skips the value that starts at the current token. Returns false on error.
+    bool SkipValue() {
+        if (Token == JSON_Token_Name) {
+            Next();
+        }
+        if (Token == JSON_Token_BeginObject || Token == JSON_Token_BeginArray) {
+            const size_t depth = Stack.size();
+            while (Stack.size() >= depth) {
+                if (Next() == JSON_Token_Error) {
+                    break;
+                }
+            }
+        }
+        return Token != JSON_Token_Error;
+    }
+
+    // Advances to the next member of the current object and returns true if there
+    // is one. The member name can be retrieved with GetString().
+    bool NextMember() {
+        return Next() == JSON_Token_Name;
+    }
+    // Advances to the first token of the next element of the current array and
+    // returns true if there is one.
+    bool NextElement() {
+        const JSONToken token = Next();
+        return token != JSON_Token_EndArray && token != JSON_Token_Error;
+    }
+
+    // Reads the next value. A value of any other type is skipped and the default is returned.
+    bool ReadBool(const bool defaultValue = false) {
+        Next();
+        if (Token == JSON_Token_Bool || Token == JSON_Token_Number) {
+            return Number != 0.0;
+        }
+        SkipValue();
+        return defaultValue;
+    }
+    double ReadDouble(const double defaultValue = 0.0) {
+        Next();
+        if (Token == JSON_Token_Number) {
+            return Number;
+        }
+        SkipValue();
+        return defaultValue;
+    }
+    float ReadFloat(const float defaultValue = 0.0f) {
+        return static_cast<float>(ReadDouble(defaultValue));
+    }
+    int32_t ReadInt32(const int32_t defaultValue = 0) {
+        return static_cast<int32_t>(ReadDouble(defaultValue));
+    }
+    const char* ReadString(const char* defaultValue = "") {
+        Next();
+        if (Token == JSON_Token_String) {
+            return String;
+        }
+        SkipValue();
+        return defaultValue;
+    }
+    // Reads an array of numbers, storing at most maxCount of them.
+    // Returns the number of elements stored.
+    int ReadNumberArray(double* elements, const int maxCount) {
+        int count = 0;
+        if (Next() != JSON_Token_BeginArray) {
+            SkipValue();
+            return 0;
+        }
+        while (NextElement()) {
+            if (Token == JSON_Token_Number && count < maxCount) {
+                elements[count++] = Number;
+            } else {
+                SkipValue();
+            }
+        }
+        return count;
+    }
+
+   private:
+    enum ParserState {
+        STATE_VALUE, // expecting a value
+        STATE_FIRST_MEMBER, // after '{'
+        STATE_FIRST_ELEMENT, // after '['
+        STATE_NEXT, // after a member or element
+        STATE_DONE // after the root value
+    };
+
+    std::vector<char> Text;
+    std::vector<uint8_t> Stack; // JSON_Object or JSON_Array for every open container
+    char* Ptr;
+    JSONToken Token;
+    ParserState State;
+    const char* String;
+    double Number;
+    const char* Error;
+
+    friend class JsonDocument;
+
+    static char* skipWhitespace(char* in) {
+        while (*in && (unsigned char)*in <= ' ')
+            in++;
+        return in;
+    }
+
+    JSONToken setError(const char* error) {
+        Error = error;
+        return Token = JSON_Token_Error;
+    }
+
+    void valueDone() {
+        State = Stack.empty() ? STATE_DONE : STATE_NEXT;
+    }
+
+    JSONToken endContainer(const JSONToken token) {
+        Stack.pop_back();
+        valueDone();
+        return Token = token;
+    }
+
+    JSONToken readValue() {
+        if (!strncmp(Ptr, "null", 4)) {
+            Ptr += 4;
+            valueDone();
+            return Token = JSON_Token_Null;
+        }
+        if (!strncmp(Ptr, "false", 5)) {
+            Ptr += 5;
+            Number = 0.0;
+            valueDone();
+            return Token = JSON_Token_Bool;
+        }
+        if (!strncmp(Ptr, "true", 4)) {
+            Ptr += 4;
+            Number = 1.0;
+            valueDone();
+            return Token = JSON_Token_Bool;
+        }
+        if (*Ptr == '\"') {
+            if (!readString()) {
+                return Token;
+            }
+            valueDone();
+            return Token = JSON_Token_String;
+        }
+        if (*Ptr == '-' || (*Ptr >= '0' && *Ptr <= '9')) {
+            Ptr = const_cast<char*>(ParseNumber(Ptr, &Number));
+            valueDone();
+            return Token = JSON_Token_Number;
+        }
+        if (*Ptr == '[') {
+            Ptr++;
+            Stack.push_back(JSON_Array);
+            State = STATE_FIRST_ELEMENT;
+            return Token = JSON_Token_BeginArray;
+        }
+        if (*Ptr == '{') {
+            Ptr++;
+            Stack.push_back(JSON_Object);
+            State = STATE_FIRST_MEMBER;
+            return Token = JSON_Token_BeginObject;
+        }
+        return setError("Syntax Error: Invalid syntax");
+    }
+
+    JSONToken readName() {
+        if (!readString()) {
+            return Token;
+        }
+        Ptr = skipWhitespace(Ptr);
+        if (*Ptr != ':') {
+            return setError("Syntax Error: Missing colon");
+        }
+        Ptr++;
+        State = STATE_VALUE;
+        return Token = JSON_Token_Name;
+    }
+
+    // Un-escapes the string in place and null-terminates it.
+    bool readString() {
+        if (*Ptr != '\"') {
+            setError("Syntax Error: Missing quote");
+            return false;
+        }
+
+        char* outEnd = Ptr;
+        char* end = const_cast<char*>(UnescapeString(Ptr + 1, Ptr, &outEnd));
+        if (*end == '\0') {
+            setError("Syntax Error: Missing quote");
+            return false;
+        }
+        *outEnd = '\0';
+        String = Ptr;
+        Ptr = end + 1;
+        return true;
+    }
+};
+
+class JsonValue;
+
+//-----------------------------------------------------------------------------
+// ***** JsonDocument
+
+// JsonDocument is an immutable, read-only alternative to the JSON tree that is
+// built in a single arena. All nodes are stored in one contiguous array and the
+// children of each object or array are stored next to each other, so indexed
+// access is constant time and walking the document does not chase pointers.
+// Names and string values are un-escaped in place in a private copy of the
+// source text, so parsing does not allocate per string either. Objects with
+// many members can optionally carry a hash index for constant time lookup by
+// name.
+//
+// Nodes are accessed through JsonValue handles, which provide the same read
+// interface as JSON and can be walked with JsonReaderT just like a JSON tree:
+//
+//	std::shared_ptr<JsonDocument> doc = JsonDocument::Parse( text );
+//	const JsonDocumentReader model( doc->GetRoot() );
+//
+// The document must outlive all JsonValue handles and readers that refer to it.
+
+class JsonDocument {
+   public:
+    static constexpr uint32_t InvalidIndex = 0xFFFFFFFF;
+    // Objects with at least this many members get a hash index when requested.
+    static constexpr uint32_t MinIndexedMembers = 8;
+
+    struct Node {
+        JSONItemType Type;
+        uint32_t ChildCount;
+        uint32_t FirstChild; // children of a node are stored contiguously
+        uint32_t HashIndex; // offset of the name hash table in HashTables, or InvalidIndex
+        uint32_t NameOffset; // null-terminated name in Text, or InvalidIndex
+        uint32_t ValueOffset; // null-terminated string value in Text, or InvalidIndex
+        double dValue;
+    };
+
+    JsonDocument() {}
+
+    // Creates a new document from parsing length bytes of the given buffer. The buffer
+    // does not need to be null-terminated. Returns a null pointer and fills in *perror
+    // in case of parse error.
+    static std::shared_ptr<JsonDocument> Parse(
+        const char* buff,
+        const size_t length,
+        const char** perror = nullptr,
+        const bool buildNameIndex = true) {
+        JsonPullParser parser(buff, length);
+        return Parse(parser, nullptr, perror, buildNameIndex);
+    }
+
+    // Creates a new document from parsing the given null-terminated string.
+    static std::shared_ptr<JsonDocument> Parse(const char* buff, const char** perror = nullptr) {
+        return Parse(buff, (buff != nullptr) ? OVR_strlen(buff) : 0, perror);
+    }
+
+    // Called for every member of the root object, with the parser positioned on the
+    // member name. If the handler reads the member value from the parser it returns
+    // true and the member is left out of the document. Otherwise it returns false
+    // without touching the parser and the member is added to the document.
+    typedef std::function<bool(const char* name, JsonPullParser& parser)> MemberHandler;
+
+    // Creates a new document from the parser, which must not have been advanced yet.
+    // This allows large members of the root object to be streamed straight into the
+    // data structures of the caller, while the rest of the document is kept for
+    // random access. The document takes over the text of the parser.
+    static std::shared_ptr<JsonDocument> Parse(
+        JsonPullParser& parser,
+        const MemberHandler& memberHandler,
+        const char** perror = nullptr,
+        const bool buildNameIndex = true) {
+        if (perror) {
+            *perror = 0;
+        }
+        if (parser.GetToken() == JSON_Token_Error) {
+            AssignError(perror, parser.GetError());
+            return nullptr;
+        }
+        if (parser.Text.size() >= InvalidIndex) {
+            AssignError(perror, "Error: Invalid buffer");
+            return nullptr;
+        }
+
+        std::shared_ptr<JsonDocument> doc = std::make_shared<JsonDocument>();
+        doc->BuildNameIndex = buildNameIndex;
+        doc->TextBase = parser.Text.data();
+
+        // A rough guess that avoids most of the re-allocations for typical documents.
+        doc->Nodes.reserve(parser.Text.size() / 16 + 1);
+        doc->Nodes.resize(1); // the root is always the first node
+        doc->Pending.resize(1);
+        initNode(doc->Pending[0]);
+
+        parser.Next();
+        if (!doc->parseValue(parser, 0, memberHandler)) {
+            AssignError(
+                perror,
+                (parser.GetError() != nullptr) ? parser.GetError()
+                                               : "Syntax Error: Invalid syntax");
+            return nullptr;
+        }
+
+        doc->Nodes[0] = doc->Pending[0];
+        doc->Pending.clear();
+        doc->Pending.shrink_to_fit();
+        doc->Text = std::move(parser.Text);
+        doc->TextBase = nullptr;
+        return doc;
+    }
+
+    JsonValue GetRoot() const;
+
+    size_t GetNodeCount() const {
+        return Nodes.size();
+    }
+    const Node& GetNode(const uint32_t index) const {
+        return Nodes[index];
+    }
+    const char* GetText(const uint32_t offset) const {
+        if (offset == InvalidIndex) {
+            return "";
+        }
+        return (TextBase != nullptr) ? TextBase + offset : &Text[offset];
+    }
+
+    // Returns the index of the first member of the object with the given name,
+    // or InvalidIndex if there is no such member.
+    uint32_t FindChild(const uint32_t parentIndex, const char* name) const {
+        const Node& parent = Nodes[parentIndex];
+        if (parent.HashIndex != InvalidIndex) {
+            const uint32_t* table = &HashTables[parent.HashIndex];
+            const uint32_t mask = table[0] - 1;
+            for (uint32_t slot = HashName(name) & mask;; slot = (slot + 1) & mask) {
+                const uint32_t entry = table[1 + slot];
+                if (entry == 0) {
+                    return InvalidIndex;
+                }
+                const uint32_t childIndex = parent.FirstChild + entry - 1;
+                if (OVR_strcmp(GetText(Nodes[childIndex].NameOffset), name) == 0) {
+                    return childIndex;
+                }
+            }
+        }
+        for (uint32_t i = 0; i < parent.ChildCount; i++) {
+            if (OVR_strcmp(GetText(Nodes[parent.FirstChild + i].NameOffset), name) == 0) {
+                return parent.FirstChild + i;
+            }
+        }
+        return InvalidIndex;
+    }
+
+    // Returns the number of bytes used by the document.
+    size_t GetMemoryUsage() const {
+        return sizeof(*this) + Text.capacity() + Nodes.capacity() * sizeof(Node) +
+            HashTables.capacity() * sizeof(uint32_t);
+    }
+
+   private:
+    std::vector<char> Text;
+    std::vector<Node> Nodes;
+    std::vector<uint32_t> HashTables;
+    std::vector<Node> Pending; // children of the containers that are still being parsed
+    const char* TextBase = nullptr; // text of the parser while the document is being built
+    bool BuildNameIndex = true;
+
+    // FNV-1a
+    static uint32_t HashName(const char* name) {
+        uint32_t hash = 2166136261u;
+        for (; *name != '\0'; name++) {
+            hash = (hash ^ (uint8_t)*name) * 16777619u;
+        }
+        return hash;
+    }
+
+    static void initNode(Node& node) {
+        node.Type = JSON_None;
+        node.ChildCount = 0;
+        node.FirstChild = 0;
+        node.HashIndex = InvalidIndex;
+        node.NameOffset = InvalidIndex;
+        node.ValueOffset = InvalidIndex;
+        node.dValue = 0.0;
+    }
+
+    // Moves the pending children starting at firstPending into the node array,
+    // and links them to their parent.
+    void closeContainer(const uint32_t parentIndex, const size_t firstPending) {
+        const uint32_t childCount = static_cast<uint32_t>(Pending.size() - firstPending);
+        const uint32_t firstChild = static_cast<uint32_t>(Nodes.size());
+        Nodes.insert(Nodes.end(), Pending.begin() + firstPending, Pending.end());
+        Pending.resize(firstPending);
+
+        Node& parent = Pending[parentIndex];
+        parent.FirstChild = firstChild;
+        parent.ChildCount = childCount;
+
+        if (BuildNameIndex && parent.Type == JSON_Object && childCount >= MinIndexedMembers) {
+            uint32_t tableSize = 1;
+            while (tableSize < childCount * 2) {
+                tableSize <<= 1;
+            }
+            parent.HashIndex = static_cast<uint32_t>(HashTables.size());
+            HashTables.resize(HashTables.size() + 1 + tableSize, 0);
+            uint32_t* table = &HashTables[parent.HashIndex];
+            table[0] = tableSize;
+            for (uint32_t i = 0; i < childCount; i++) {
+                uint32_t slot = HashName(GetText(Nodes[firstChild + i].NameOffset)) &
+                    (tableSize - 1);
+                while (table[1 + slot] != 0) {
+                    slot = (slot + 1) & (tableSize - 1);
+                }
+                table[1 + slot] = i + 1;
+            }
+        }
+    }
+
+    uint32_t textOffset(const char* str) const {
+        return static_cast<uint32_t>(str - TextBase);
+    }
+
+    // Parses the value that starts at the current token of the parser into Pending[nodeIndex].
+    bool parseValue(
+        JsonPullParser& parser,
+        const uint32_t nodeIndex,
+        const MemberHandler& memberHandler = nullptr) {
+        switch (parser.GetToken()) {
+            case JSON_Token_Null:
+                Pending[nodeIndex].Type = JSON_Null;
+                return true;
+            case JSON_Token_Bool:
+                Pending[nodeIndex].Type = JSON_Bool;
+                Pending[nodeIndex].dValue = parser.GetNumber();
+                return true;
+            case JSON_Token_Number:
+                Pending[nodeIndex].Type = JSON_Number;
+                Pending[nodeIndex].dValue = parser.GetNumber();
+                return true;
+            case JSON_Token_String:
+                Pending[nodeIndex].Type = JSON_String;
+                Pending[nodeIndex].ValueOffset = textOffset(parser.GetString());
+                return true;
+            case JSON_Token_BeginArray: {
+                Pending[nodeIndex].Type = JSON_Array;
+                const size_t firstPending = Pending.size();
+                while (parser.NextElement()) {
+                    Pending.emplace_back();
+                    initNode(Pending.back());
+                    if (!parseValue(parser, static_cast<uint32_t>(Pending.size() - 1))) {
+                        return false;
+                    }
+                }
+                if (parser.GetToken() == JSON_Token_Error) {
+                    return false;
+                }
+                closeContainer(nodeIndex, firstPending);
+                return true;
+            }
+            case JSON_Token_BeginObject: {
+                Pending[nodeIndex].Type = JSON_Object;
+                const size_t firstPending = Pending.size();
+                while (parser.NextMember()) {
+                    if (memberHandler && memberHandler(parser.GetString(), parser)) {
+                        if (parser.GetToken() == JSON_Token_Error) {
+                            return false;
+                        }
+                        continue;
+                    }
+                    Pending.emplace_back();
+                    initNode(Pending.back());
+                    const uint32_t childIndex = static_cast<uint32_t>(Pending.size() - 1);
+                    Pending[childIndex].NameOffset = textOffset(parser.GetString());
+                    parser.Next();
+                    if (!parseValue(parser, childIndex)) {
+                        return false;
+                    }
+                }
+                if (parser.GetToken() == JSON_Token_Error) {
+                    return false;
+                }
+                closeContainer(nodeIndex, firstPending);
+                return true;
+            }
+            default:
+                return false;
+        }
+    }
+};
+
+//-----------------------------------------------------------------------------
+// ***** JsonValue
+
+// Lightweight handle to a node of a JsonDocument. It behaves like a pointer to a
+// JSON node so code can be written the same way for both representations.
+
+class JsonValue {
+   public:
+    JsonValue() : Document(nullptr), Index(0) {}
+    JsonValue(std::nullptr_t) : Document(nullptr), Index(0) {}
+    JsonValue(const JsonDocument* document, const uint32_t index)
+        : Document(index != JsonDocument::InvalidIndex ? document : nullptr), Index(index) {}
+
+    const JsonValue* operator->() const {
+        return this;
+    }
+    explicit operator bool() const {
+        return Document != nullptr;
+    }
+    bool operator==(std::nullptr_t) const {
+        return Document == nullptr;
+    }
+    bool operator!=(std::nullptr_t) const {
+        return Document != nullptr;
+    }
+
+    const JsonDocument* GetDocument() const {
+        return Document;
+    }
+    uint32_t GetIndex() const {
+        return Index;
+    }
+
+    JSONItemType GetType() const {
+        return GetNode().Type;
+    }
+    const char* GetName() const {
+        return Document->GetText(GetNode().NameOffset);
+    }
+
+    // *** Object Member Access
+
+    unsigned GetItemCount() const {
+        return GetNode().ChildCount;
+    }
+    JsonValue GetItemByIndex(unsigned index) const {
+        const JsonDocument::Node& node = GetNode();
+        if (index >= node.ChildCount) {
+            return nullptr;
+        }
+        return JsonValue(Document, node.FirstChild + index);
+    }
+    JsonValue GetItemByName(const char* name) const {
+        return JsonValue(Document, Document->FindChild(Index, name));
+    }
+
+    // Value access with range checking where possible.
+    bool GetBoolValue() const {
+        const JsonDocument::Node& node = GetNode();
+        OVR_ASSERT((node.Type == JSON_Number) || (node.Type == JSON_Bool));
+        OVR_ASSERT(node.dValue == 0.0 || node.dValue == 1.0); // if this hits, value is out of range
+        return (node.dValue != 0.0);
+    }
+    int32_t GetInt32Value() const {
+        const JsonDocument::Node& node = GetNode();
+        OVR_ASSERT(node.Type == JSON_Number);
+        OVR_ASSERT(node.dValue >= INT_MIN && node.dValue <= INT_MAX); // value is out of range
+        return (int32_t)node.dValue;
+    }
+    int64_t GetInt64Value() const {
+        const JsonDocument::Node& node = GetNode();
+        OVR_ASSERT(node.Type == JSON_Number);
+        OVR_ASSERT(
+            node.dValue >= -9007199254740992LL &&
+            node.dValue <= 9007199254740992LL); // 2^53 - if this hits, value is out of range
+        return (int64_t)node.dValue;
+    }
+    float GetFloatValue() const {
+        const JsonDocument::Node& node = GetNode();
+        OVR_ASSERT(node.Type == JSON_Number);
+        OVR_ASSERT(node.dValue >= -FLT_MAX && node.dValue <= FLT_MAX); // too large for a float
+        OVR_ASSERT(
+            node.dValue == 0 || node.dValue <= -FLT_MIN ||
+            node.dValue >= FLT_MIN); // if the number is too small to be represented as a float
+        return (float)node.dValue;
+    }
+    double GetDoubleValue() const {
+        OVR_ASSERT(GetNode().Type == JSON_Number);
+        return GetNode().dValue;
+    }
+    // Returns an empty string for anything but a string.
+    const char* GetStringValue() const {
+        OVR_ASSERT(GetNode().Type == JSON_String || GetNode().Type == JSON_Null);
+        return Document->GetText(GetNode().ValueOffset);
+    }
+
+    // *** Array Element Access
+
+    int GetArraySize() const {
+        return (GetNode().Type == JSON_Array) ? static_cast<int>(GetNode().ChildCount) : 0;
+    }
+    double GetArrayNumber(int index) const {
+        if (GetNode().Type == JSON_Array) {
+            const JsonValue number = GetItemByIndex(index);
+            return number ? number.GetNode().dValue : 0.0;
+        } else {
+            return 0;
+        }
+    }
+    const char* GetArrayString(int index) const {
+        if (GetNode().Type == JSON_Array) {
+            const JsonValue string = GetItemByIndex(index);
+            return string ? string.GetStringValue() : nullptr;
+        } else {
+            return nullptr;
+        }
+    }
+
+   private:
+    const JsonDocument* Document;
+    uint32_t Index;
+
+    const JsonDocument::Node& GetNode() const {
+        return Document->GetNode(Index);
+    }
+};
+
+inline JsonValue JsonDocument::GetRoot() const {
+    return JsonValue(this, 0);
+}
+
+//-----------------------------------------------------------------------------
+// ***** JsonReaderTraits
+
+// Describes how JsonReaderT iterates over the children of a node.
+
+template <typename NodeRef>
+struct JsonReaderTraits;
+
+template <>
+struct JsonReaderTraits<std::shared_ptr<JSON>> {
+    typedef std::list<std::shared_ptr<JSON>>::iterator ChildIterator;
+
+    static ChildIterator Begin(const std::shared_ptr<JSON>& parent) {
+        return parent->Children.begin();
+    }
+    static ChildIterator End(const std::shared_ptr<JSON>& parent) {
+        return parent->Children.end();
+    }
+    static std::shared_ptr<JSON> Get(const std::shared_ptr<JSON>&, ChildIterator child) {
+        return *child;
+    }
+    static const char* GetName(const std::shared_ptr<JSON>&, ChildIterator child) {
+        return (*child)->Name.c_str();
+    }
+    static ChildIterator Find(const std::shared_ptr<JSON>& parent, const char* name) {
+        for (auto c = parent->Children.begin(); c != parent->Children.end(); ++c) {
+            if (OVR_strcmp((*c)->Name.c_str(), name) == 0) {
+                return c;
+            }
+        }
+        return parent->Children.end();
+    }
+};
+
+template <>
+struct JsonReaderTraits<JsonValue> {
+    typedef uint32_t ChildIterator; // node index
+
+    static ChildIterator Begin(const JsonValue& parent) {
+        return parent.GetDocument()->GetNode(parent.GetIndex()).FirstChild;
+    }
+    static ChildIterator End(const JsonValue& parent) {
+        const JsonDocument::Node& node = parent.GetDocument()->GetNode(parent.GetIndex());
+        return node.FirstChild + node.ChildCount;
+    }
+    static JsonValue Get(const JsonValue& parent, ChildIterator child) {
+        return JsonValue(parent.GetDocument(), child);
+    }
+    static const char* GetName(const JsonValue& parent, ChildIterator child) {
+        const JsonDocument* doc = parent.GetDocument();
+        return doc->GetText(doc->GetNode(child).NameOffset);
+    }
+    static ChildIterator Find(const JsonValue& parent, const char* name) {
+        const uint32_t child = parent.GetDocument()->FindChild(parent.GetIndex(), name);
+        return (child != JsonDocument::InvalidIndex) ? child : End(parent);
+    }
 };
 
 //-----------------------------------------------------------------------------
@@ -1155,6 +2007,10 @@ class JSON {
 // Either way this class will do the right thing as long as the JSON tree is
 // considered const and is not changed underneath this class.
 //
+// The reader works the same way on a JSON tree (JsonReader) and on a
+// JsonDocument (JsonDocumentReader). Reading a JsonDocument out of order
+// uses the hash index of the object, if it has one.
+//
 // This is an example of how this class can be used to load a simplified indexed
 // triangle model:
 //
@@ -1188,17 +2044,21 @@ class JSON {
 //  // shared_ptr will free resources when it goes out of scope
 //
 
-class JsonReader {
+template <typename NodeRef>
+class JsonReaderT {
    public:
-    JsonReader(const std::shared_ptr<JSON> json) : Parent(json) {
+    typedef JsonReaderTraits<NodeRef> Traits;
+    typedef typename Traits::ChildIterator ChildIterator;
+
+    JsonReaderT(const NodeRef json) : Parent(json), Child() {
         if (Parent) {
-            Child = Parent->Children.begin();
+            Child = Traits::Begin(Parent);
         }
     }
 
-    JsonReader(std::list<std::shared_ptr<JSON>>::iterator it) : JsonReader(*it) {}
+    JsonReaderT(std::list<std::shared_ptr<JSON>>::iterator it) : JsonReaderT(*it) {}
 
-    const std::shared_ptr<JSON> AsParent() const {
+    const NodeRef AsParent() const {
         return Parent;
     }
 
@@ -1206,116 +2066,117 @@ class JsonReader {
         return Parent != nullptr;
     }
     bool IsObject() const {
-        return Parent != nullptr && Parent->Type == JSON_Object;
+        return Parent != nullptr && Parent->GetType() == JSON_Object;
     }
     bool IsArray() const {
-        return Parent != nullptr && Parent->Type == JSON_Array;
+        return Parent != nullptr && Parent->GetType() == JSON_Array;
     }
     bool IsEndOfArray() const {
         OVR_ASSERT(Parent != nullptr);
-        return (Child == Parent->Children.end());
+        return (Child == Traits::End(Parent));
     }
 
-    std::list<std::shared_ptr<JSON>>::iterator GetFirstChild() const {
-        return Parent->Children.begin();
+    ChildIterator GetFirstChild() const {
+        return Traits::Begin(Parent);
     }
-    std::list<std::shared_ptr<JSON>>::iterator GetNextChild(
-        std::list<std::shared_ptr<JSON>>::iterator& child) const {
+    ChildIterator GetNextChild(ChildIterator& child) const {
         auto childClone = child;
         ++childClone;
         return childClone;
     }
 
-    const std::shared_ptr<JSON> GetChildByName(const char* childName) const {
+    const NodeRef GetChildByName(const char* childName) const {
         assert(IsObject());
 
         // Check if the the cached child pointer is valid.
-        if (Child != Parent->Children.end()) {
-            if (OVR_strcmp((*Child)->Name.c_str(), childName) == 0) {
-                const std::shared_ptr<JSON> c = *Child;
+        if (Child != Traits::End(Parent)) {
+            if (OVR_strcmp(Traits::GetName(Parent, Child), childName) == 0) {
+                const NodeRef c = Traits::Get(Parent, Child);
                 ++Child; // Cache the next child.
                 return c;
             }
         }
-        // Itereate over all children.
-        for (auto c = Parent->Children.begin(); c != Parent->Children.end(); ++c) {
-            if (OVR_strcmp((*c)->Name.c_str(), childName) == 0) {
-                Child = c; // Cache the next child.
-                return *c;
-            }
+        // Look up the child by name.
+        const ChildIterator c = Traits::Find(Parent, childName);
+        if (c != Traits::End(Parent)) {
+            Child = c; // Cache the next child.
+            return Traits::Get(Parent, c);
         }
-        return 0;
+        return NodeRef();
     }
     bool GetChildBoolByName(const char* childName, const bool defaultValue = false) const {
-        const std::shared_ptr<JSON> c = GetChildByName(childName);
+        const NodeRef c = GetChildByName(childName);
         return (c != nullptr) ? c->GetBoolValue() : defaultValue;
     }
     int32_t GetChildInt32ByName(const char* childName, const int32_t defaultValue = 0) const {
-        const std::shared_ptr<JSON> c = GetChildByName(childName);
+        const NodeRef c = GetChildByName(childName);
         return (c != nullptr) ? c->GetInt32Value() : defaultValue;
     }
     int64_t GetChildInt64ByName(const char* childName, const int64_t defaultValue = 0) const {
-        const std::shared_ptr<JSON> c = GetChildByName(childName);
+        const NodeRef c = GetChildByName(childName);
         return (c != nullptr) ? c->GetInt64Value() : defaultValue;
     }
     float GetChildFloatByName(const char* childName, const float defaultValue = 0.0f) const {
-        const std::shared_ptr<JSON> c = GetChildByName(childName);
+        const NodeRef c = GetChildByName(childName);
         return (c != nullptr) ? c->GetFloatValue() : defaultValue;
     }
     double GetChildDoubleByName(const char* childName, const double defaultValue = 0.0) const {
-        const std::shared_ptr<JSON> c = GetChildByName(childName);
+        const NodeRef c = GetChildByName(childName);
         return (c != nullptr) ? c->GetDoubleValue() : defaultValue;
     }
     const std::string GetChildStringByName(
         const char* childName,
         const std::string& defaultValue = std::string("")) const {
-        const std::shared_ptr<JSON> c = GetChildByName(childName);
-        return std::string(
-            (c != nullptr && c->Type != JSON_Null) ? c->GetStringValue() : defaultValue);
+        const NodeRef c = GetChildByName(childName);
+        return (c != nullptr && c->GetType() != JSON_Null) ? std::string(c->GetStringValue())
+                                                           : defaultValue;
     }
 
-    const std::shared_ptr<JSON> GetNextArrayElement() const {
+    const NodeRef GetNextArrayElement() const {
         assert(IsArray());
 
         // Check if the the cached child pointer is valid.
-        if (Child != Parent->Children.end()) {
-            const std::shared_ptr<JSON> c = *Child;
+        if (Child != Traits::End(Parent)) {
+            const NodeRef c = Traits::Get(Parent, Child);
             ++Child; // Cache the next child.
             return c;
         }
-        return nullptr;
+        return NodeRef();
     }
 
     bool GetNextArrayBool(const bool defaultValue = false) const {
-        const std::shared_ptr<JSON> c = GetNextArrayElement();
+        const NodeRef c = GetNextArrayElement();
         return (c != nullptr) ? c->GetBoolValue() : defaultValue;
     }
     int32_t GetNextArrayInt32(const int32_t defaultValue = 0) const {
-        const std::shared_ptr<JSON> c = GetNextArrayElement();
+        const NodeRef c = GetNextArrayElement();
         return (c != nullptr) ? c->GetInt32Value() : defaultValue;
     }
     int64_t GetNextArrayInt64(const int64_t defaultValue = 0) const {
-        const std::shared_ptr<JSON> c = GetNextArrayElement();
+        const NodeRef c = GetNextArrayElement();
         return (c != nullptr) ? c->GetInt64Value() : defaultValue;
     }
     float GetNextArrayFloat(const float defaultValue = 0.0f) const {
-        const std::shared_ptr<JSON> c = GetNextArrayElement();
+        const NodeRef c = GetNextArrayElement();
         return (c != nullptr) ? c->GetFloatValue() : defaultValue;
     }
     double GetNextArrayDouble(const double defaultValue = 0.0) const {
-        const std::shared_ptr<JSON> c = GetNextArrayElement();
+        const NodeRef c = GetNextArrayElement();
         return (c != nullptr) ? c->GetDoubleValue() : defaultValue;
     }
     const std::string GetNextArrayString(const std::string& defaultValue = std::string("")) const {
-        const std::shared_ptr<JSON> c = GetNextArrayElement();
-        return std::string((c != nullptr) ? c->GetStringValue() : defaultValue);
+        const NodeRef c = GetNextArrayElement();
+        return (c != nullptr) ? std::string(c->GetStringValue()) : defaultValue;
     }
 
    private:
-    std::shared_ptr<JSON> Parent;
-    mutable std::list<std::shared_ptr<JSON>>::iterator Child; // cached child pointer (iterator)
+    NodeRef Parent;
+    mutable ChildIterator Child; // cached child pointer (iterator)
 };
 
+typedef JsonReaderT<std::shared_ptr<JSON>> JsonReader;
+typedef JsonReaderT<JsonValue> JsonDocumentReader;
+
 } // namespace OVR
 
 #endif // OVR_JSON_h
@@ -0,0 +1,124 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * Licensed under the Oculus SDK License Agreement (the "License");
+ * you may not use the Oculus SDK except in compliance with the License,
+ * which is provided at the time of installation or download, or which
+ * otherwise accompanies this software in either electronic or hard copy form.
+ *
+ * You may obtain a copy of the License at
+ * https://developer.oculus.com/licenses/oculussdk/
+ *
+ * Unless required by applicable law or agreed to in writing, the Oculus SDK
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/*******************************************************************************
+
+Filename    :   FramePipeline.cpp
+Content     :   Order of the frame steps of the main loop, with optional pipelining.
+Language    :   C++
+
+*******************************************************************************/
+
+#include "FramePipeline.h"
+
+namespace OVRFW {
+
+ovrFramePipeline::~ovrFramePipeline() {
+    Stop();
+}
+
+void ovrFramePipeline::RunFrame(const int64_t frameIndex, const bool pipelined) {
+    const int slot = CurrentSlot;
+    if (!HaveSimulatedFrame) {
+        SimulateFrame(slot, frameIndex, !pipelined);
+    }
+    HaveSimulatedFrame = false;
+
+    if (pipelined) {
+        // Simulate the next frame on the simulation thread while this one is ended.
+        CurrentSlot = (CurrentSlot + 1) % MAX_FRAME_SLOTS;
+        StartSimulation(CurrentSlot, frameIndex + 1);
+    }
+
+    // A pipelined frame is begun only once the previous frame has been ended.
+    if (!Begun[slot]) {
+        Steps.BeginFrame(slot);
+        Begun[slot] = true;
+    }
+    Steps.EndFrame(slot);
+
+    if (pipelined) {
+        // Wait here so the caller never handles events during the simulation.
+        FinishSimulation();
+        HaveSimulatedFrame = true;
+    }
+}
+
+void ovrFramePipeline::Stop() {
+    if (SimulationThread.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(SimulationMutex);
+            SimulationExit = true;
+            SimulationWork.notify_one();
+        }
+        SimulationThread.join();
+    }
+    HaveSimulatedFrame = false;
+}
+
+void ovrFramePipeline::SimulateFrame(
+    const int slot,
+    const int64_t frameIndex,
+    const bool beginFrame) {
+    Steps.WaitFrame(slot);
+    Begun[slot] = beginFrame;
+    if (beginFrame) {
+        Steps.BeginFrame(slot);
+    }
+    Steps.UpdateFrame(slot, frameIndex);
+}
+
+void ovrFramePipeline::StartSimulation(const int slot, const int64_t frameIndex) {
+    if (!SimulationThread.joinable()) {
+        SimulationExit = false;
+        SimulationThread = std::thread(&ovrFramePipeline::SimulationThreadFunction, this);
+    }
+    std::lock_guard<std::mutex> lock(SimulationMutex);
+    SimulationSlot = slot;
+    SimulationFrameIndex = frameIndex;
+    SimulationWork.notify_one();
+}
+
+void ovrFramePipeline::FinishSimulation() {
+    std::unique_lock<std::mutex> lock(SimulationMutex);
+    SimulationDone.wait(lock, [this] { return SimulationSlot < 0; });
+}
+
+void ovrFramePipeline::SimulationThreadFunction() {
+    Steps.SimulationThreadStart();
+
+    std::unique_lock<std::mutex> lock(SimulationMutex);
+    for (;;) {
+        SimulationWork.wait(lock, [this] { return SimulationSlot >= 0 || SimulationExit; });
+        if (SimulationExit) {
+            break;
+        }
+        const int slot = SimulationSlot;
+        const int64_t frameIndex = SimulationFrameIndex;
+        lock.unlock();
+        SimulateFrame(slot, frameIndex, false);
+        lock.lock();
+        SimulationSlot = -1;
+        SimulationDone.notify_one();
+    }
+    lock.unlock();
+
+    Steps.SimulationThreadStop();
+}
+
+} // namespace OVRFW
@@ -0,0 +1,102 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * Licensed under the Oculus SDK License Agreement (the "License");
+ * you may not use the Oculus SDK except in compliance with the License,
+ * which is provided at the time of installation or download, or which
+ * otherwise accompanies this software in either electronic or hard copy form.
+ *
+ * You may obtain a copy of the License at
+ * https://developer.oculus.com/licenses/oculussdk/
+ *
+ * Unless required by applicable law or agreed to in writing, the Oculus SDK
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/*******************************************************************************
+
+Filename    :   FramePipeline.h
+Content     :   Order of the frame steps of the main loop, with optional pipelining.
+Language    :   C++
+
+*******************************************************************************/
+
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+namespace OVRFW {
+
+// The steps of a frame, implemented by the application loop. Each frame is held in one of
+// ovrFramePipeline::MAX_FRAME_SLOTS slots. WaitFrame and UpdateFrame of a pipelined frame run on
+// the simulation thread, the other steps always run on the thread that calls RunFrame.
+class ovrFrameSteps {
+   public:
+    virtual ~ovrFrameSteps() {}
+
+    // xrWaitFrame for the frame in the slot.
+    virtual void WaitFrame(const int slot) = 0;
+    // xrBeginFrame for the frame last waited for in the slot.
+    virtual void BeginFrame(const int slot) = 0;
+    // Locates the views and runs the application input and Update for the frame.
+    virtual void UpdateFrame(const int slot, const int64_t frameIndex) = 0;
+    // Renders the frame and submits it with xrEndFrame.
+    virtual void EndFrame(const int slot) = 0;
+
+    // Called on the simulation thread when it starts and before it exits.
+    virtual void SimulationThreadStart() {}
+    virtual void SimulationThreadStop() {}
+};
+
+// Runs the frame steps in order. Without pipelining each frame is waited for, begun, updated and
+// ended in that order. With pipelining frame N+1 is waited for and updated on a simulation
+// thread while frame N is ended, and a frame is only begun once the previous one has been
+// ended, so at most two frames are in flight. The mode can change from one frame to the next.
+class ovrFramePipeline {
+   public:
+    static const int MAX_FRAME_SLOTS = 2;
+
+    explicit ovrFramePipeline(ovrFrameSteps& steps) : Steps(steps) {}
+    ~ovrFramePipeline();
+
+    // Ends the frame with the given index, waiting for and updating it first unless the previous
+    // pipelined call already did. When pipelined is set, the next frame is simulated while this
+    // one is ended, and is ready when this returns.
+    void RunFrame(const int64_t frameIndex, const bool pipelined);
+
+    // Drops a frame that was simulated ahead but not ended, for example because the session
+    // stopped. The next RunFrame waits for a new frame.
+    void DropSimulatedFrame() {
+        HaveSimulatedFrame = false;
+    }
+
+    // Joins the simulation thread and drops a frame simulated ahead.
+    void Stop();
+
+   private:
+    void SimulateFrame(const int slot, const int64_t frameIndex, const bool beginFrame);
+    void StartSimulation(const int slot, const int64_t frameIndex);
+    void FinishSimulation();
+    void SimulationThreadFunction();
+
+    ovrFrameSteps& Steps;
+    int CurrentSlot = 0;
+    bool HaveSimulatedFrame = false; // the current slot was simulated by the previous RunFrame
+    bool Begun[MAX_FRAME_SLOTS] = {}; // BeginFrame was called for the frame in the slot
+
+    std::thread SimulationThread;
+    std::mutex SimulationMutex;
+    std::condition_variable SimulationWork;
+    std::condition_variable SimulationDone;
+    int SimulationSlot = -1; // slot the simulation thread is working on
+    int64_t SimulationFrameIndex = 0;
+    bool SimulationExit = false;
+};
+
+} // namespace OVRFW
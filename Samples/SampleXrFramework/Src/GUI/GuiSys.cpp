@@ -30,6 +30,7 @@ Authors     :   Jonathan E. Wright
 #include "Render/TextureManager.h"
 
 #include "Misc/Log.h"
+#include "OVR_PerfTimer.h"
 
 #include "FrameParams.h"
 
@@ -726,7 +727,7 @@ void OvrGuiSysLocal::Frame(
     const ovrApplFrameIn& vrFrame,
     Matrix4f const& centerViewMatrix,
     Matrix4f const& traceMat) {
-    /// OVR_PERF_TIMER( OvrGuiSys_Frame );
+    OVR_PERF_TIMER(OvrGuiSys_Frame);
 
     if (!IsInitialized || SkipFrame) {
         assert(IsInitialized);
@@ -744,6 +745,9 @@ void OvrGuiSysLocal::Frame(
         RecenterCount = currentRecenterCount;
     }
 
+    // create the textures that finished decoding before menus are updated with them
+    TextureManager->Update();
+
     // draw info text
     if (InfoText.EndFrame >= LastVrFrameNumber) {
         Vector3f viewPos = GetViewMatrixPosition(lastViewMatrix);
@@ -769,7 +773,7 @@ void OvrGuiSysLocal::Frame(
     }
 
     {
-        /// OVR_PERF_TIMER( OvrGuiSys_Frame_Menus_Frame );
+        OVR_PERF_TIMER(OvrGuiSys_Frame_Menus_Frame);
         // go backwards through the list so we can use unordered remove when a menu finishes closing
         for (int i = static_cast<int>(ActiveMenus.size()) - 1; i >= 0; --i) {
             VRMenu* curMenu = ActiveMenus[i];
@@ -787,17 +791,17 @@ void OvrGuiSysLocal::Frame(
     }
 
     {
-        /// OVR_PERF_TIMER( OvrGuiSys_GazeCursor_Frame );
+        OVR_PERF_TIMER(OvrGuiSys_GazeCursor_Frame);
         GazeCursor->Frame(centerViewMatrix, traceMat, vrFrame.DeltaSeconds);
     }
 
     {
-        /// OVR_PERF_TIMER( OvrGuiSys_Frame_Font_Finish );
+        OVR_PERF_TIMER(OvrGuiSys_Frame_Font_Finish);
         DefaultFontSurface->Finish(centerViewMatrix);
     }
 
     {
-        /// OVR_PERF_TIMER( OvrGuiSys_Frame_MenuMgr_Finish );
+        OVR_PERF_TIMER(OvrGuiSys_Frame_MenuMgr_Finish);
         MenuMgr->Finish(centerViewMatrix);
     }
 
@@ -192,8 +192,9 @@ void ovrArmModel::Update(
     Skeleton.TransformLocal(FootPose, 0);
 
     /// Update the joints for beam rendering
+    const std::vector<Posef>& worldPoses = Skeleton.GetWorldSpacePoses();
     for (int i = 0; i < (int)TransformedJoints.size(); ++i) {
-        TransformedJoints[i].Pose = Skeleton.GetWorldSpacePoses()[i];
+        TransformedJoints[i].Pose = worldPoses[i];
     }
     outPose = TransformedJoints[static_cast<int>(TransformedJoints.size()) - 1].Pose;
 }
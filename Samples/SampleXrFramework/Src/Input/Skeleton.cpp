@@ -26,13 +26,83 @@ Authors     :   Jonathan E. Wright
 ************************************************************************************/
 
 #include "Skeleton.h"
+#include <algorithm>
 #include <cassert>
 
 using OVR::Posef;
 
 namespace OVRFW {
 
-ovrSkeleton::ovrSkeleton() : WorldSpaceDirty(true) {}
+Posef ovrJointPosesSoA::Get(const int i) const {
+    const ovrJointPoseBlock& b = Blocks[static_cast<unsigned>(i) / ovrJointPoseBlock::WIDTH];
+    const unsigned lane = static_cast<unsigned>(i) % ovrJointPoseBlock::WIDTH;
+    return Posef(
+        OVR::Quatf(b.Rx[lane], b.Ry[lane], b.Rz[lane], b.Rw[lane]),
+        OVR::Vector3f(b.Tx[lane], b.Ty[lane], b.Tz[lane]));
+}
+
+void ovrJointPosesSoA::Set(const int i, const Posef& pose) {
+    ovrJointPoseBlock& b = Blocks[static_cast<unsigned>(i) / ovrJointPoseBlock::WIDTH];
+    const unsigned lane = static_cast<unsigned>(i) % ovrJointPoseBlock::WIDTH;
+    b.Rx[lane] = pose.Rotation.x;
+    b.Ry[lane] = pose.Rotation.y;
+    b.Rz[lane] = pose.Rotation.z;
+    b.Rw[lane] = pose.Rotation.w;
+    b.Tx[lane] = pose.Translation.x;
+    b.Ty[lane] = pose.Translation.y;
+    b.Tz[lane] = pose.Translation.z;
+}
+
+/// world = parent * local for one block of independent joints, reading the parents from their
+/// slots in worldBlocks. The parents are gathered into a local block that stays in registers;
+/// writing them to memory first and loading them back as vectors stalls on store forwarding.
+/// The math is straight-line float code over fixed-width lanes, so the compiler emits one
+/// NEON / SSE op per component. Matches Posef::operator*, including the conjugate rotation for
+/// non-unit quaternions.
+static void ComposePoses(
+    const ovrJointPoseBlock* __restrict worldBlocks,
+    const int* __restrict parentSlots,
+    const ovrJointPoseBlock& __restrict l,
+    ovrJointPoseBlock& __restrict o) {
+    ovrJointPoseBlock p;
+    for (int i = 0; i < ovrJointPoseBlock::WIDTH; ++i) {
+        const int parent = parentSlots[i];
+        const ovrJointPoseBlock& b = worldBlocks[parent / ovrJointPoseBlock::WIDTH];
+        const int lane = parent % ovrJointPoseBlock::WIDTH;
+        p.Rx[i] = b.Rx[lane];
+        p.Ry[i] = b.Ry[lane];
+        p.Rz[i] = b.Rz[lane];
+        p.Rw[i] = b.Rw[lane];
+        p.Tx[i] = b.Tx[lane];
+        p.Ty[i] = b.Ty[lane];
+        p.Tz[i] = b.Tz[lane];
+    }
+
+    for (int i = 0; i < ovrJointPoseBlock::WIDTH; ++i) {
+        const float x = p.Rx[i];
+        const float y = p.Ry[i];
+        const float z = p.Rz[i];
+        const float w = p.Rw[i];
+
+        o.Rx[i] = w * l.Rx[i] + x * l.Rw[i] + y * l.Rz[i] - z * l.Ry[i];
+        o.Ry[i] = w * l.Ry[i] - x * l.Rz[i] + y * l.Rw[i] + z * l.Rx[i];
+        o.Rz[i] = w * l.Rz[i] + x * l.Ry[i] - y * l.Rx[i] + z * l.Rw[i];
+        o.Rw[i] = w * l.Rw[i] - x * l.Rx[i] - y * l.Ry[i] - z * l.Rz[i];
+
+        // q * v * q^-1 = (w^2 - u.u) v + 2 (u.v) u + 2 w (u x v)
+        const float vx = l.Tx[i];
+        const float vy = l.Ty[i];
+        const float vz = l.Tz[i];
+        const float s = w * w - (x * x + y * y + z * z);
+        const float d = 2.0f * (x * vx + y * vy + z * vz);
+        const float w2 = 2.0f * w;
+        o.Tx[i] = s * vx + d * x + w2 * (y * vz - z * vy) + p.Tx[i];
+        o.Ty[i] = s * vy + d * y + w2 * (z * vx - x * vz) + p.Ty[i];
+        o.Tz[i] = s * vz + d * z + w2 * (x * vy - y * vx) + p.Tz[i];
+    }
+}
+
+ovrSkeleton::ovrSkeleton() {}
 
 const ovrJoint& ovrSkeleton::GetJoint(int const idx) const {
     assert(idx >= 0 && idx < static_cast<int>(Joints.size()));
@@ -46,71 +116,194 @@ int ovrSkeleton::GetParentIndex(int const idx) const {
     return Joints[idx].ParentIndex;
 }
 
+const std::vector<Posef>& ovrSkeleton::GetLocalSpacePoses() const {
+    for (int slot = 0; slot < static_cast<int>(Dirty.size()); ++slot) {
+        if (Dirty[slot] & LOCAL_CHANGED) {
+            Dirty[slot] &= ~LOCAL_CHANGED;
+            if (SlotJoint[slot] >= 0) {
+                LocalSpacePoses[SlotJoint[slot]] = LocalSoA.Get(slot);
+            }
+        }
+    }
+    return LocalSpacePoses;
+}
+
+const std::vector<Posef>& ovrSkeleton::GetWorldSpacePoses(bool updateFromLocal) const {
+    if (updateFromLocal) {
+        UpdateWorldFromLocal();
+    }
+    for (const int block : StaleWorldBlocks) {
+        const ovrJointPoseBlock& b = WorldSoA.Blocks[block];
+        const int* slotJoint = &SlotJoint[block * ovrJointPoseBlock::WIDTH];
+        for (int lane = 0; lane < ovrJointPoseBlock::WIDTH; ++lane) {
+            if (slotJoint[lane] >= 0) {
+                WorldSpacePoses[slotJoint[lane]] = Posef(
+                    OVR::Quatf(b.Rx[lane], b.Ry[lane], b.Rz[lane], b.Rw[lane]),
+                    OVR::Vector3f(b.Tx[lane], b.Ty[lane], b.Tz[lane]));
+            }
+        }
+        WorldBlockStale[block] = 0;
+    }
+    StaleWorldBlocks.clear();
+    return WorldSpacePoses;
+}
+
 void ovrSkeleton::SetJoints(const std::vector<ovrJoint>& newJoints) {
     Joints = newJoints;
-    LocalSpacePoses.resize(Joints.size());
-    WorldSpacePoses.resize(Joints.size());
+    const int numJoints = static_cast<int>(Joints.size());
+    const int width = ovrJointPoseBlock::WIDTH;
 
-    /// Set local
-    for (int i = 0; i < (int)Joints.size(); ++i) {
-        LocalSpacePoses[i] = Joints[i].Pose;
+    /// Depth of each joint; parents that are out of range or form a cycle count as roots
+    std::vector<int> depth(numJoints, 0);
+    int maxDepth = -1;
+    for (int i = 0; i < numJoints; ++i) {
+        int d = 0;
+        for (int p = Joints[i].ParentIndex; p >= 0 && p < numJoints && d < numJoints;
+             p = Joints[p].ParentIndex) {
+            ++d;
+        }
+        depth[i] = (d < numJoints) ? d : 0;
+        maxDepth = std::max(maxDepth, depth[i]);
+    }
+
+    /// Stable counting sort by depth, so joints keep their relative order within a level.
+    /// Every level is rounded up to whole blocks.
+    LevelStart.assign(maxDepth + 2, 0);
+    for (int i = 0; i < numJoints; ++i) {
+        LevelStart[depth[i] + 1]++;
+    }
+    for (int l = 1; l < (int)LevelStart.size(); ++l) {
+        LevelStart[l] = LevelStart[l - 1] + (LevelStart[l] + width - 1) / width * width;
+    }
+    const int numSlots = LevelStart.back();
+    std::vector<int> cursor(LevelStart.begin(), LevelStart.end() - 1);
+    SlotJoint.assign(numSlots, -1);
+    JointSlot.resize(numJoints);
+    SlotLevel.resize(numSlots);
+    for (int l = 0; l < (int)LevelStart.size() - 1; ++l) {
+        std::fill(SlotLevel.begin() + LevelStart[l], SlotLevel.begin() + LevelStart[l + 1], l);
+    }
+    for (int i = 0; i < numJoints; ++i) {
+        const int slot = cursor[depth[i]]++;
+        SlotJoint[slot] = i;
+        JointSlot[i] = slot;
+    }
+    ParentSlot.assign(numSlots, -1);
+    for (int i = 0; i < numJoints; ++i) {
+        if (depth[i] > 0) {
+            ParentSlot[JointSlot[i]] = JointSlot[Joints[i].ParentIndex];
+        }
+    }
+    /// Padding shares the parent of the first joint in its block, which is never padding
+    for (int slot = 0; slot < numSlots; ++slot) {
+        if (SlotJoint[slot] < 0) {
+            ParentSlot[slot] = ParentSlot[slot / width * width];
+        }
+    }
+
+    const int numBlocks = numSlots / width;
+    LocalSoA.Resize(numSlots);
+    WorldSoA.Resize(numSlots);
+    LocalSpacePoses.resize(numJoints);
+    WorldSpacePoses.resize(numJoints);
+    WorldBlockStale.assign(numBlocks, 0);
+    StaleWorldBlocks.clear();
+    StaleWorldBlocks.reserve(numBlocks);
+
+    /// Set local; padding stays the identity so every lane holds a valid pose
+    for (int slot = 0; slot < numSlots; ++slot) {
+        LocalSoA.Set(slot, Posef());
+    }
+    for (int i = 0; i < numJoints; ++i) {
+        LocalSoA.Set(JointSlot[i], Joints[i].Pose);
     }
 
     /// Set World
-    WorldSpaceDirty = true;
+    Dirty.assign(numSlots, WORLD_DIRTY | LOCAL_CHANGED);
     UpdateWorldFromLocal();
 }
 
 void ovrSkeleton::UpdateWorldFromLocal() const {
-    if (false == WorldSpaceDirty) {
+    /// Nothing above the level of the first dirty slot needs updating
+    const auto first = std::find_if(
+        Dirty.begin(), Dirty.end(), [](const uint8_t d) { return (d & WORLD_DIRTY) != 0; });
+    if (first == Dirty.end()) {
         return;
     }
+    const int firstDirty = static_cast<int>(first - Dirty.begin());
+
+    const int width = ovrJointPoseBlock::WIDTH;
+    const int numLevels = static_cast<int>(LevelStart.size()) - 1;
+    for (int level = SlotLevel[firstDirty]; level < numLevels; ++level) {
+        for (int block = LevelStart[level] / width; block < LevelStart[level + 1] / width;
+             ++block) {
+            /// Propagate dirtiness down from the previous level
+            uint8_t dirty = 0;
+            for (int slot = block * width; slot < (block + 1) * width; ++slot) {
+                if (level > 0) {
+                    Dirty[slot] |= Dirty[ParentSlot[slot]] & WORLD_DIRTY;
+                }
+                dirty |= Dirty[slot] & WORLD_DIRTY;
+            }
+            if (!dirty) {
+                continue;
+            }
 
-    assert(Joints.size() == LocalSpacePoses.size());
-    assert(Joints.size() == WorldSpacePoses.size());
-    for (int i = 0; i < (int)Joints.size(); ++i) {
-        WorldSpacePoses[i] = (Joints[i].ParentIndex < 0)
-            ? LocalSpacePoses[i]
-            : (WorldSpacePoses[Joints[i].ParentIndex] * LocalSpacePoses[i]);
+            /// The local and world poses are read and written in place. The clean lanes of the
+            /// block come out unchanged.
+            if (level == 0) {
+                WorldSoA.Blocks[block] = LocalSoA.Blocks[block];
+            } else {
+                ComposePoses(
+                    WorldSoA.Blocks.data(),
+                    &ParentSlot[block * width],
+                    LocalSoA.Blocks[block],
+                    WorldSoA.Blocks[block]);
+            }
+            if (!WorldBlockStale[block]) {
+                WorldBlockStale[block] = 1;
+                StaleWorldBlocks.push_back(block);
+            }
+        }
     }
-    WorldSpaceDirty = false;
-}
 
-void ovrSkeleton::TransformLocal(const OVR::Posef& t, int idx) {
-    assert(idx >= 0 && idx < static_cast<int>(Joints.size()));
-    if (idx >= 0 && idx < static_cast<int>(Joints.size())) {
-        LocalSpacePoses[idx] = Joints[idx].Pose * t;
-        WorldSpaceDirty = true;
+    for (int slot = firstDirty; slot < static_cast<int>(Dirty.size()); ++slot) {
+        Dirty[slot] &= ~WORLD_DIRTY;
     }
 }
 
-void ovrSkeleton::UpdateLocalRotation(const OVR::Quatf& q, int idx) {
+void ovrSkeleton::TransformLocal(const OVR::Posef& t, int idx) {
     assert(idx >= 0 && idx < static_cast<int>(Joints.size()));
     if (idx >= 0 && idx < static_cast<int>(Joints.size())) {
-        LocalSpacePoses[idx].Rotation = q;
-        WorldSpaceDirty = true;
+        const int slot = JointSlot[idx];
+        LocalSoA.Set(slot, Joints[idx].Pose * t);
+        SetLocalDirty(slot);
     }
 }
 
-void ovrSkeleton::UpdateLocalTranslation(const OVR::Vector3f& t, int idx) {
-    assert(idx >= 0 && idx < static_cast<int>(Joints.size()));
-    LocalSpacePoses[idx].Translation = t;
-    WorldSpaceDirty = true;
+void ovrSkeleton::UpdateLocalPoses(const OVR::Posef* poses, int count) {
+    assert(count == static_cast<int>(Joints.size()));
+    count = std::min(count, static_cast<int>(Joints.size()));
+    for (int i = 0; i < count; ++i) {
+        LocalSoA.Set(JointSlot[i], poses[i]);
+    }
+    std::fill(Dirty.begin(), Dirty.end(), WORLD_DIRTY | LOCAL_CHANGED);
 }
 
 void ovrSkeleton::TransformWorld(const OVR::Posef& t, int idx) {
     assert(idx >= 0 && idx < static_cast<int>(Joints.size()));
     if (idx >= 0 && idx < static_cast<int>(Joints.size())) {
-        WorldSpacePoses[idx] = t;
-        const int paretnIndex = Joints[idx].ParentIndex;
-        if (paretnIndex < 0) {
+        const int slot = JointSlot[idx];
+        if (ParentSlot[slot] < 0) {
             // the root remains the same
-            LocalSpacePoses[idx] = t;
+            LocalSoA.Set(slot, t);
         } else {
-            const Posef& parentPose = WorldSpacePoses[paretnIndex];
-            LocalSpacePoses[idx] = parentPose.Inverted() * WorldSpacePoses[idx];
+            // the parent's world pose must be current before expressing t relative to it
+            UpdateWorldFromLocal();
+            const Posef parentPose = WorldSoA.Get(ParentSlot[slot]);
+            LocalSoA.Set(slot, parentPose.Inverted() * t);
         }
-        WorldSpaceDirty = true;
+        SetLocalDirty(slot);
     }
 }
 
@@ -27,6 +27,8 @@ Authors     :   Jonathan E. Wright, Federico Schliemann
 
 #pragma once
 
+#include <cassert>
+#include <cstdint>
 #include <vector>
 
 #include "OVR_Math.h"
@@ -50,6 +52,48 @@ class ovrJoint {
     int ParentIndex; // index of this joint's parent
 };
 
+/// Four joint poses with each component stored in its own lane array, so a block maps directly
+/// onto a 128-bit NEON / SSE register per component.
+struct ovrJointPoseBlock {
+    static const int WIDTH = 4;
+
+    float Rx[WIDTH];
+    float Ry[WIDTH];
+    float Rz[WIDTH];
+    float Rw[WIDTH];
+    float Tx[WIDTH];
+    float Ty[WIDTH];
+    float Tz[WIDTH];
+};
+
+/// Structure-of-arrays storage for a set of joint poses, laid out as consecutive blocks of
+/// four so the batched local->world pass streams through whole blocks at a time.
+class ovrJointPosesSoA {
+   public:
+    void Resize(const int count) {
+        Blocks.resize((count + ovrJointPoseBlock::WIDTH - 1) / ovrJointPoseBlock::WIDTH);
+    }
+    OVR::Posef Get(const int i) const;
+    void Set(const int i, const OVR::Posef& pose);
+    void SetRotation(const int i, const OVR::Quatf& q) {
+        ovrJointPoseBlock& b = Blocks[static_cast<unsigned>(i) / ovrJointPoseBlock::WIDTH];
+        const unsigned lane = static_cast<unsigned>(i) % ovrJointPoseBlock::WIDTH;
+        b.Rx[lane] = q.x;
+        b.Ry[lane] = q.y;
+        b.Rz[lane] = q.z;
+        b.Rw[lane] = q.w;
+    }
+    void SetTranslation(const int i, const OVR::Vector3f& t) {
+        ovrJointPoseBlock& b = Blocks[static_cast<unsigned>(i) / ovrJointPoseBlock::WIDTH];
+        const unsigned lane = static_cast<unsigned>(i) % ovrJointPoseBlock::WIDTH;
+        b.Tx[lane] = t.x;
+        b.Ty[lane] = t.y;
+        b.Tz[lane] = t.z;
+    }
+
+    std::vector<ovrJointPoseBlock> Blocks;
+};
+
 class ovrSkeleton {
    public:
     ovrSkeleton();
@@ -59,37 +103,71 @@ class ovrSkeleton {
     const std::vector<ovrJoint>& GetJoints() const {
         return Joints;
     }
-    const std::vector<OVR::Posef>& GetLocalSpacePoses() const {
-        return LocalSpacePoses;
-    }
-    const std::vector<OVR::Posef>& GetWorldSpacePoses(bool updateFromLocal = true) const {
-        if (updateFromLocal) {
-            UpdateWorldFromLocal();
-        }
-        return WorldSpacePoses;
-    }
+    const std::vector<OVR::Posef>& GetLocalSpacePoses() const;
+    const std::vector<OVR::Posef>& GetWorldSpacePoses(bool updateFromLocal = true) const;
     void SetJoints(const std::vector<ovrJoint>& newJoints);
     void TransformLocal(const OVR::Posef& t, int idx);
     void TransformWorld(const OVR::Posef& t, int idx);
-    void UpdateLocalRotation(const OVR::Quatf& q, int idx);
-    void UpdateLocalTranslation(const OVR::Vector3f& t, int idx);
+    /// The per-joint setters are called for many joints every frame, so they are inline and
+    /// only write the lanes of the joint and its dirty flag.
+    void UpdateLocalRotation(const OVR::Quatf& q, int idx) {
+        assert(idx >= 0 && idx < static_cast<int>(JointSlot.size()));
+        if (idx >= 0 && idx < static_cast<int>(JointSlot.size())) {
+            const int slot = JointSlot[idx];
+            LocalSoA.SetRotation(slot, q);
+            SetLocalDirty(slot);
+        }
+    }
+    void UpdateLocalTranslation(const OVR::Vector3f& t, int idx) {
+        assert(idx >= 0 && idx < static_cast<int>(JointSlot.size()));
+        const int slot = JointSlot[idx];
+        LocalSoA.SetTranslation(slot, t);
+        SetLocalDirty(slot);
+    }
+    /// Replaces the local pose of every joint at once, e.g. from a body or hand tracker.
+    void UpdateLocalPoses(const OVR::Posef* poses, int count);
 
    private:
+    /// Flags in Dirty
+    static constexpr uint8_t WORLD_DIRTY = 1; // the world pose of the slot needs recomputing
+    static constexpr uint8_t LOCAL_CHANGED = 2; // LocalSpacePoses lacks the slot's local pose
+
+    void SetLocalDirty(int slot) {
+        Dirty[slot] = WORLD_DIRTY | LOCAL_CHANGED;
+    }
     void UpdateWorldFromLocal() const;
 
     /// Essentially a BIND pose for the skeleton
     std::vector<ovrJoint> Joints;
 
-    /// Current skeleton state for each joint
-    std::vector<OVR::Posef> LocalSpacePoses;
+    /// Joints sorted by depth in the hierarchy. Every parent lands in an earlier level than
+    /// its children, so each level can be evaluated as one independent batch. Each level
+    /// starts on a block boundary and is padded to whole blocks with identity poses.
+    /// These arrays are all indexed by slot (position in evaluation order), not joint index.
+    std::vector<int> SlotJoint; // slot -> joint index, or -1 for padding
+    std::vector<int> JointSlot; // joint index -> slot
+    std::vector<int> ParentSlot; // slot -> parent slot, or -1 for roots
+    std::vector<int> LevelStart; // first slot of each depth level, plus one past the end
+    std::vector<int> SlotLevel; // slot -> depth level
+
+    /// Current skeleton state for each joint, by slot
+    ovrJointPosesSoA LocalSoA;
 
-    /// These two are semantically `const` but in practice lazily updated whenever
+    /// These are semantically `const` but in practice lazily updated whenever
     /// UpdateWorldFromLocal is called on the const GetWorldSpacePoses method.
-    /// The expectation is that calling any of the Transform methods will update LocalSpacePoses
-    /// instantly and invalidate WorldSpaceDirty so that they can be lazily updated on demand.
-    /// Declaring them mutable lets them change inside a `const` method deliberately.
+    /// The expectation is that calling any of the Transform methods will update LocalSoA
+    /// instantly and flag the joint in Dirty, so that the joint and its subtree can be
+    /// lazily updated on demand. Declaring them mutable lets them change inside a `const`
+    /// method deliberately.
+    mutable ovrJointPosesSoA WorldSoA;
+    mutable std::vector<uint8_t> Dirty; // WORLD_DIRTY and LOCAL_CHANGED per slot
+
+    /// The poses by joint index are only built when they are read, from the slots changed
+    /// and the blocks recomputed since the last read.
+    mutable std::vector<OVR::Posef> LocalSpacePoses;
     mutable std::vector<OVR::Posef> WorldSpacePoses;
-    mutable bool WorldSpaceDirty;
+    mutable std::vector<uint8_t> WorldBlockStale; // per block
+    mutable std::vector<int> StaleWorldBlocks;
 };
 
 } // namespace OVRFW
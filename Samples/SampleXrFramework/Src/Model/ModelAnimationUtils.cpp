@@ -218,4 +218,16 @@ void ApplyAnimation(ModelState& modelState, int animationIndex) {
     }
 }
 
+void ApplyMorphTargets(ModelNodeState& nodeState) {
+    Model* model = nodeState.node->model;
+    if (model == nullptr) {
+        return;
+    }
+    for (ModelSurface& surface : model->surfaces) {
+        if (surface.morphTargets.Evaluate(nodeState.weights)) {
+            surface.morphTargets.Upload(surface.surfaceDef.geo);
+        }
+    }
+}
+
 } // namespace OVRFW
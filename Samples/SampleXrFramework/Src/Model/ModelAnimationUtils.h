@@ -33,4 +33,9 @@ namespace OVRFW {
 
 void ApplyAnimation(ModelState& modelState, int animationIndex);
 
+// Morphs the surfaces of the node's model to the node's weights, e.g. after ApplyAnimation
+// changed them, and updates the vertex buffers of the ones that changed. Must be called on the
+// thread that owns the GL context.
+void ApplyMorphTargets(ModelNodeState& nodeState);
+
 } // namespace OVRFW
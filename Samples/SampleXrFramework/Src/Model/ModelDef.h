@@ -28,12 +28,14 @@ Authors     :   John Carmack, J.M.P. van Waveren
 #pragma once
 
 #include <functional>
+#include <memory>
 #include <string>
 #include <vector>
 #include <cstdint>
 
 #include "Render/GlProgram.h"
 #include "Render/GlTexture.h"
+#include "Render/MorphTargets.h"
 #include "Render/SurfaceRender.h"
 #include "ModelCollision.h"
 #include "ModelTrace.h"
@@ -49,13 +51,17 @@ struct MaterialParms {
           EnableDiffuseAniso(false),
           EnableEmissiveLodClamp(true),
           Transparent(false),
-          PolygonOffset(false) {}
+          PolygonOffset(false),
+          BuildTraceModel(false),
+          OptimizeGeometry(true) {}
 
     bool UseSrgbTextureFormats; // use sRGB textures
     bool EnableDiffuseAniso; // enable anisotropic filtering on the diffuse texture
     bool EnableEmissiveLodClamp; // enable LOD clamp on the emissive texture to avoid light bleeding
     bool Transparent; // surfaces with this material flag need to render in a transparent pass
     bool PolygonOffset; // render with polygon offset enabled
+    bool BuildTraceModel; // build the ModelFile::TraceModel kd-tree from the meshes when loading
+    bool OptimizeGeometry; // reorder mesh vertices and triangles for the GPU when loading
     std::function<bool(ModelFile&, const std::string&)> ImageUriHandler; // custom image URI handler
 };
 
@@ -95,8 +101,19 @@ enum ModelComponentType {
 struct ModelBuffer {
     ModelBuffer() : byteLength(0) {}
 
+    const uint8_t* GetData() const {
+        return (externalData != nullptr) ? externalData : bufferData.data();
+    }
+    bool IsEmpty() const {
+        return externalData == nullptr && bufferData.empty();
+    }
+
     std::string name;
     std::vector<uint8_t> bufferData;
+    // When set, the buffer contents are read in place from memory owned by externalDataOwner,
+    // for instance a memory mapped glb file, and bufferData is left empty.
+    const uint8_t* externalData = nullptr;
+    std::shared_ptr<const void> externalDataOwner;
     size_t byteLength;
     ModelComponentType componentType = MODEL_COMPONENT_TYPE_UNSIGNED_BYTE;
     int componentCount;
@@ -249,8 +266,10 @@ struct ModelSurface {
 
     const ModelMaterial* material; // material used to render this surface
     ovrSurfaceDef surfaceDef;
-    VertexAttribs attribs; // Only populated if morph targets are used
-    std::vector<VertexAttribs> targets;
+    MorphTargets morphTargets; // empty if the mesh has no morph targets
+    // Bounds of the bind pose vertices weighted to each skin joint, indexed by the vertex joint
+    // indices. Only populated for skinned surfaces, and used to cull them as they animate.
+    std::vector<OVR::Bounds3f> jointBounds;
 };
 
 struct Model {
@@ -579,7 +598,7 @@ struct ModelGlPrograms {
 
 struct ModelGeo {
     std::vector<OVR::Vector3f> positions;
-    std::vector<TriangleIndex> indices;
+    std::vector<TriangleIndex32> indices; // 32-bit, all surfaces together can exceed 16 bits
 };
 
 } // namespace OVRFW
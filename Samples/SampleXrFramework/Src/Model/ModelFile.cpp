@@ -34,6 +34,7 @@ Authors     :   John Carmack, J.M.P. van Waveren
 #include "OVR_Std.h"
 
 #include "Misc/Log.h"
+#include "System.h"
 
 using OVR::Bounds3f;
 using OVR::Matrix4f;
@@ -66,6 +67,8 @@ ModelFile::~ModelFile() {
 
     for (int i = 0; i < static_cast<int>(Buffers.size()); i++) {
         Buffers[i].bufferData.clear();
+        Buffers[i].externalData = nullptr;
+        Buffers[i].externalDataOwner = nullptr;
     }
 }
 
@@ -174,6 +177,48 @@ void LoadModelFileTexture(
     model.Textures.push_back(tex);
 }
 
+void LoadModelFileTextures(
+    ModelFile& model,
+    std::vector<ModelTextureFile>& files,
+    const MaterialParms& materialParms) {
+    const TextureFlags_t flags =
+        (materialParms.UseSrgbTextureFormats ? TextureFlags_t(TEXTUREFLAG_USE_SRGB)
+                                             : TextureFlags_t());
+    std::vector<ovrDecodedTexture> decoded(files.size());
+    ParallelFor(static_cast<int>(files.size()), [&](int i) {
+        if (!DecodeTextureFromBuffer(
+                files[i].name.c_str(),
+                files[i].data,
+                files[i].size,
+                files[i].owner,
+                flags,
+                decoded[i])) {
+            decoded[i] = ovrDecodedTexture();
+        }
+        files[i].owner = nullptr;
+    });
+
+    for (int i = 0; i < static_cast<int>(files.size()); i++) {
+        ModelTexture tex;
+        tex.name = files[i].name.substr(0, files[i].name.rfind('.'));
+        if (!decoded[i].FileName.empty()) {
+            tex.texid = CreateTextureFromDecoded(decoded[i]);
+        }
+        decoded[i] = ovrDecodedTexture();
+        if (!tex.texid.IsValid()) {
+            // empty or undecodable files get the default texture, like LoadTextureFromBuffer
+            LoadModelFileTexture(model, files[i].name.c_str(), nullptr, 0, materialParms);
+            continue;
+        }
+        // file name metadata for enabling clamp mode
+        if (strstr(files[i].name.c_str(), "_c.")) {
+            MakeTextureClamped(tex.texid);
+        }
+        model.Textures.push_back(tex);
+    }
+    files.clear();
+}
+
 static ModelFile* LoadZippedModelFile(
     unzFile zfp,
     const char* fileName,
@@ -398,6 +443,25 @@ ModelFile* LoadModelFile(
     const MaterialParms& materialParms) {
     ALOG("LoadModelFile %s", fileName);
 
+    // Determine wether it's a glb binary file, or if it is a zipped up ovrscene.
+    if (strstr(fileName, ".glb") != nullptr) {
+        // The model buffers reference the mapped file in place, so the mapping is kept alive
+        // for as long as the model.
+        auto mapping = std::make_shared<zlib_mmap_opaque>();
+        if (!mmap_open_opaque(fileName, *mapping)) {
+            ALOGW("could not map file %s", fileName);
+            return nullptr;
+        }
+        return LoadModelFile_glB(
+            fileName,
+            (const char*)mapping->data,
+            mapping->len,
+            programs,
+            materialParms,
+            nullptr,
+            mapping);
+    }
+
     zlib_mmap_opaque zlib_opaque;
 
     // Map and open the zip file
@@ -406,12 +470,6 @@ ModelFile* LoadModelFile(
         return nullptr;
     }
 
-    // Determine wether it's a glb binary file, or if it is a zipped up ovrscene.
-    if (strstr(fileName, ".glb") != nullptr) {
-        return LoadModelFile_glB(
-            fileName, (char*)zlib_opaque.data, zlib_opaque.len, programs, materialParms);
-    }
-
     unzFile zfp = open_opaque(zlib_opaque, fileName);
     if (!zfp) {
         ALOGW("could not open file %s", fileName);
@@ -469,6 +527,24 @@ ModelFile* LoadModelFileFromOtherApplicationPackage(
     const char* nameInZip,
     const ModelGlPrograms& programs,
     const MaterialParms& materialParms) {
+    // glb files stored uncompressed in the package are loaded in place.
+    if (strstr(nameInZip, ".glb") != nullptr) {
+        const uint8_t* data = nullptr;
+        size_t length = 0;
+        std::shared_ptr<const void> mapping =
+            ovr_MapFileFromOtherApplicationPackage(zipFile, nameInZip, data, length);
+        if (mapping != nullptr) {
+            return LoadModelFile_glB(
+                nameInZip,
+                (const char*)data,
+                static_cast<int>(length),
+                programs,
+                materialParms,
+                nullptr,
+                mapping);
+        }
+    }
+
     void* buffer;
     int bufferLength;
 
@@ -509,11 +585,10 @@ ModelFile* LoadModelFile(
 }
 
 uint8_t* ModelAccessor::BufferData() const {
-    if (bufferView == nullptr || bufferView->buffer == nullptr ||
-        bufferView->buffer->bufferData.empty()) {
+    if (bufferView == nullptr || bufferView->buffer == nullptr || bufferView->buffer->IsEmpty()) {
         return nullptr;
     }
-    return (uint8_t*)bufferView->buffer->bufferData.data() + bufferView->byteOffset + byteOffset;
+    return (uint8_t*)bufferView->buffer->GetData() + bufferView->byteOffset + byteOffset;
 }
 
 void ModelNode::SetLocalTransform(const Matrix4f matrix) {
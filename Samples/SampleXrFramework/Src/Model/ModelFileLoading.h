@@ -29,6 +29,7 @@ Authors     :   John Carmack, J.M.P. van Waveren
 #include "ModelFile.h"
 
 #include <math.h>
+#include <memory>
 #include <vector>
 
 #include "OVR_Math.h"
@@ -54,6 +55,24 @@ void LoadModelFileTexture(
     const int size,
     const MaterialParms& materialParms);
 
+// An image file of a model that has been read but not decoded yet.
+// The file is not copied: data points into memory that owner keeps alive, or that the caller
+// keeps alive while the textures load if owner is null.
+struct ModelTextureFile {
+    std::string name;
+    const uint8_t* data = nullptr; // null for the default texture
+    size_t size = 0;
+    std::shared_ptr<const void> owner;
+};
+
+// Same as calling LoadModelFileTexture for each file in order, but the files are decoded in place
+// on the worker threads first, so only the GL uploads run on the calling thread. The files are
+// released.
+void LoadModelFileTextures(
+    ModelFile& model,
+    std::vector<ModelTextureFile>& files,
+    const MaterialParms& materialParms);
+
 bool LoadModelFile_OvrScene(
     ModelFile* modelPtr,
     unzFile zfp,
@@ -74,11 +93,14 @@ bool LoadModelFile_glTF_OvrScene(
     const MaterialParms& materialParms,
     ModelGeo* outModelGeo = nullptr);
 
+// If fileDataOwner is set, the model buffers reference fileData in place instead of copying it
+// and keep fileDataOwner alive.
 ModelFile* LoadModelFile_glB(
     const char* fileName,
     const char* fileData,
     const int fileDataLength,
     const ModelGlPrograms& programs,
     const MaterialParms& materialParms,
-    ModelGeo* outModelGeo = nullptr);
+    ModelGeo* outModelGeo = nullptr,
+    const std::shared_ptr<const void>& fileDataOwner = nullptr);
 } // namespace OVRFW
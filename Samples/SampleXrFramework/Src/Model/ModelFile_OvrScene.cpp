@@ -330,10 +330,10 @@ bool LoadModelFile_OvrScene_Json(
                             modelSurface.surfaceDef.geo.localBounds,
                             surface.GetChildStringByName("bounds").c_str());
 
-                        TriangleIndex indexOffset = 0;
+                        TriangleIndex32 indexOffset = 0;
                         if (outModelGeo != nullptr) {
                             indexOffset =
-                                static_cast<TriangleIndex>((*outModelGeo).positions.size());
+                                static_cast<TriangleIndex32>((*outModelGeo).positions.size());
                         }
                         //
                         // Vertices
@@ -393,13 +393,6 @@ bool LoadModelFile_OvrScene_Json(
                                 vertices.GetChildStringByName("jointWeights").c_str(),
                                 bin,
                                 vertexCount);
-
-                            if (outModelGeo != nullptr) {
-                                for (int i = 0; i < static_cast<int>(attribs.position.size());
-                                     ++i) {
-                                    (*outModelGeo).positions.push_back(attribs.position[i]);
-                                }
-                            }
                         }
 
                         //
@@ -422,7 +415,21 @@ bool LoadModelFile_OvrScene_Json(
                                 indexCount);
                         }
 
+                        if (materialParms.OptimizeGeometry) {
+                            GeometryOptimizeParms parms;
+                            // blended surfaces are drawn in the order of their triangles
+                            parms.reorderTriangles = materialType == MATERIAL_TYPE_OPAQUE &&
+                                !materialParms.Transparent;
+                            std::vector<TriangleIndex32> indices32(indices.begin(), indices.end());
+                            if (!OptimizeGeometry(attribs, indices32, parms).empty()) {
+                                indices.assign(indices32.begin(), indices32.end());
+                            }
+                        }
+
                         if (outModelGeo != nullptr) {
+                            for (int i = 0; i < static_cast<int>(attribs.position.size()); ++i) {
+                                (*outModelGeo).positions.push_back(attribs.position[i]);
+                            }
                             for (int i = 0; i < static_cast<int>(indices.size()); ++i) {
                                 (*outModelGeo).indices.push_back(indices[i] + indexOffset);
                             }
@@ -433,7 +440,8 @@ bool LoadModelFile_OvrScene_Json(
                         // attributes are known.
                         //
 
-                        modelSurface.surfaceDef.geo.Create(attribs, indices);
+                        modelSurface.surfaceDef.geo.Create(
+                            attribs, indices, VertexLayout::Compact(attribs));
 
                         const char* materialTypeString = "opaque";
                         OVR_UNUSED(
@@ -670,11 +678,6 @@ bool LoadModelFile_OvrScene_Json(
             traceModel.header.numNodes = raytrace_model.GetChildInt32ByName("numNodes");
             traceModel.header.numLeafs = raytrace_model.GetChildInt32ByName("numLeafs");
             traceModel.header.numOverflow = raytrace_model.GetChildInt32ByName("numOverflow");
-            if (!traceModel.Validate(true)) {
-                // this is a fatal error so that a model file from an untrusted source is never able
-                // to cause out-of-bounds reads.
-                ALOGE_FAIL("Invalid model data");
-            }
 
             OVR::StringUtils::StringTo(
                 traceModel.header.bounds, raytrace_model.GetChildStringByName("bounds").c_str());
@@ -742,6 +745,12 @@ bool LoadModelFile_OvrScene_Json(
                 raytrace_model.GetChildStringByName("overflow").c_str(),
                 bin,
                 traceModel.header.numOverflow);
+
+            if (!traceModel.Validate(true)) {
+                // this is a fatal error so that a model file from an untrusted source is never able
+                // to cause out-of-bounds reads.
+                ALOGE_FAIL("Invalid model data");
+            }
         }
     }
 
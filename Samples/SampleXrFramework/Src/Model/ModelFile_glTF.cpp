@@ -32,6 +32,7 @@ Authors     :   John Carmack, J.M.P. van Waveren
 #include "OVR_JSON.h"
 
 #include "Misc/Log.h"
+#include "System.h"
 
 #include <unordered_map>
 
@@ -76,6 +77,9 @@ namespace OVRFW {
 #define GLTF_BINARY_CHUNKTYPE_JSON 0x4E4F534A
 #define GLTF_BINARY_CHUNKTYPE_BINARY 0x004E4942
 
+// glTF files are read through an arena-backed JsonDocument instead of a JSON tree.
+typedef OVR::JsonDocumentReader JsonReader;
+
 typedef struct glTFBinaryHeader {
     uint32_t magic;
     uint32_t version;
@@ -127,22 +131,25 @@ static uint8_t* ReadFileBufferFromZipFile(
     return nullptr;
 }
 
-static void ParseIntArray(int* elements, const int count, const OVR::JsonReader arrayNode) {
-    int i = 0;
-    if (arrayNode.IsArray()) {
-        while (!arrayNode.IsEndOfArray() && i < count) {
-            auto node = arrayNode.GetNextArrayElement();
-            elements[i] = node->GetInt32Value();
-            i++;
-        }
-    }
+// True if a buffer from ReadBufferFromZipFile was read in place from fileData, otherwise it was
+// allocated with new[].
+static bool IsInFileData(const uint8_t* buffer, const char* fileData, const int fileDataLength) {
+    const char* data = (const char*)buffer;
+    return fileData != nullptr && data >= fileData && data < fileData + fileDataLength;
+}
 
-    for (; i < count; i++) {
-        elements[i] = 0;
+// Returns the owner of a buffer from ReadBufferFromZipFile, or null if it was read in place.
+static std::shared_ptr<const void>
+OwnZipFileBuffer(const uint8_t* buffer, const char* fileData, const int fileDataLength) {
+    if (buffer == nullptr || IsInFileData(buffer, fileData, fileDataLength)) {
+        return nullptr;
     }
+    return std::shared_ptr<const void>(buffer, [](const void* p) {
+        delete[] static_cast<const uint8_t*>(p);
+    });
 }
 
-static void ParseFloatArray(float* elements, const int count, OVR::JsonReader arrayNode) {
+static void ParseFloatArray(float* elements, const int count, JsonReader arrayNode) {
     int i = 0;
     if (arrayNode.IsArray()) {
         while (!arrayNode.IsEndOfArray() && i < count) {
@@ -157,6 +164,251 @@ static void ParseFloatArray(float* elements, const int count, OVR::JsonReader ar
     }
 }
 
+// The buffers, bufferViews and accessors arrays hold most of the JSON values of large glTF files.
+// They are read straight from the JSON stream into the model while the rest of the file is kept
+// in a JsonDocument. The arrays may appear in any order, so references between them are stored
+// as indices and resolved once the whole file has been read.
+struct glTFStreamedArrays {
+    struct Buffer {
+        std::string name;
+        std::string uri;
+        int byteLength = -1;
+    };
+
+    std::vector<Buffer> buffers;
+    std::vector<int> bufferViewBuffers; // buffer index for each of modelFile.BufferViews
+    std::vector<int> accessorBufferViews; // bufferView index for each of modelFile.Accessors
+    bool loaded = true;
+};
+
+static ModelAccessorType ParseAccessorType(const char* type, int& componentCount) {
+    if (OVR::OVR_stricmp(type, "SCALAR") == 0) {
+        componentCount = 1;
+        return ACCESSOR_SCALAR;
+    } else if (OVR::OVR_stricmp(type, "VEC2") == 0) {
+        componentCount = 2;
+        return ACCESSOR_VEC2;
+    } else if (OVR::OVR_stricmp(type, "VEC3") == 0) {
+        componentCount = 3;
+        return ACCESSOR_VEC3;
+    } else if (OVR::OVR_stricmp(type, "VEC4") == 0) {
+        componentCount = 4;
+        return ACCESSOR_VEC4;
+    } else if (OVR::OVR_stricmp(type, "MAT2") == 0) {
+        componentCount = 4;
+        return ACCESSOR_MAT2;
+    } else if (OVR::OVR_stricmp(type, "MAT3") == 0) {
+        componentCount = 9;
+        return ACCESSOR_MAT3;
+    } else if (OVR::OVR_stricmp(type, "MAT4") == 0) {
+        componentCount = 16;
+        return ACCESSOR_MAT4;
+    }
+    componentCount = 0;
+    return ACCESSOR_UNKNOWN;
+}
+
+static void StreamBuffers(OVR::JsonPullParser& parser, glTFStreamedArrays& streamed) {
+    if (parser.Next() != OVR::JSON_Token_BeginArray) {
+        parser.SkipValue();
+        return;
+    }
+    while (parser.NextElement()) {
+        if (parser.GetToken() != OVR::JSON_Token_BeginObject) {
+            parser.SkipValue();
+            continue;
+        }
+        glTFStreamedArrays::Buffer buffer;
+        while (parser.NextMember()) {
+            const char* name = parser.GetString();
+            if (OVR::OVR_strcmp(name, "name") == 0) {
+                buffer.name = parser.ReadString();
+            } else if (OVR::OVR_strcmp(name, "uri") == 0) {
+                buffer.uri = parser.ReadString();
+            } else if (OVR::OVR_strcmp(name, "byteLength") == 0) {
+                buffer.byteLength = parser.ReadInt32(-1);
+            } else {
+                parser.SkipValue();
+            }
+        }
+        streamed.buffers.push_back(buffer);
+    }
+}
+
+static void
+StreamBufferViews(OVR::JsonPullParser& parser, ModelFile& modelFile, glTFStreamedArrays& streamed) {
+    if (parser.Next() != OVR::JSON_Token_BeginArray) {
+        parser.SkipValue();
+        return;
+    }
+    while (parser.NextElement()) {
+        if (parser.GetToken() != OVR::JSON_Token_BeginObject) {
+            parser.SkipValue();
+            continue;
+        }
+        ModelBufferView newBufferView;
+        int buffer = 0;
+        while (parser.NextMember()) {
+            const char* name = parser.GetString();
+            if (OVR::OVR_strcmp(name, "name") == 0) {
+                newBufferView.name = parser.ReadString();
+            } else if (OVR::OVR_strcmp(name, "buffer") == 0) {
+                buffer = parser.ReadInt32();
+            } else if (OVR::OVR_strcmp(name, "byteOffset") == 0) {
+                newBufferView.byteOffset = parser.ReadInt32();
+            } else if (OVR::OVR_strcmp(name, "byteLength") == 0) {
+                newBufferView.byteLength = parser.ReadInt32();
+            } else if (OVR::OVR_strcmp(name, "byteStride") == 0) {
+                newBufferView.byteStride = parser.ReadInt32();
+            } else if (OVR::OVR_strcmp(name, "target") == 0) {
+                newBufferView.target = parser.ReadInt32();
+            } else {
+                parser.SkipValue();
+            }
+        }
+
+        if (newBufferView.byteStride < 0 || newBufferView.byteStride > 255) {
+            ALOGW("Error: Invalid byeStride in gltfBufferView");
+            streamed.loaded = false;
+        }
+        if (newBufferView.target < 0) {
+            ALOGW("Error: Invalid target in gltfBufferView");
+            streamed.loaded = false;
+        }
+
+        modelFile.BufferViews.push_back(newBufferView);
+        streamed.bufferViewBuffers.push_back(buffer);
+    }
+}
+
+static void
+StreamAccessors(OVR::JsonPullParser& parser, ModelFile& modelFile, glTFStreamedArrays& streamed) {
+    if (parser.Next() != OVR::JSON_Token_BeginArray) {
+        parser.SkipValue();
+        return;
+    }
+    while (parser.NextElement()) {
+        if (parser.GetToken() != OVR::JSON_Token_BeginObject) {
+            parser.SkipValue();
+            continue;
+        }
+        ModelAccessor newGltfAccessor;
+        int bufferView = 0;
+        std::string type;
+        double min[MAX_MODEL_ACCESSOR_COMPONENT_SIZE];
+        double max[MAX_MODEL_ACCESSOR_COMPONENT_SIZE];
+        int minCount = -1;
+        int maxCount = -1;
+        while (parser.NextMember()) {
+            const char* name = parser.GetString();
+            if (OVR::OVR_strcmp(name, "name") == 0) {
+                newGltfAccessor.name = parser.ReadString();
+            } else if (OVR::OVR_strcmp(name, "bufferView") == 0) {
+                bufferView = parser.ReadInt32();
+            } else if (OVR::OVR_strcmp(name, "byteOffset") == 0) {
+                newGltfAccessor.byteOffset = parser.ReadInt32();
+            } else if (OVR::OVR_strcmp(name, "componentType") == 0) {
+                newGltfAccessor.componentType = parser.ReadInt32();
+            } else if (OVR::OVR_strcmp(name, "count") == 0) {
+                newGltfAccessor.count = parser.ReadInt32();
+            } else if (OVR::OVR_strcmp(name, "type") == 0) {
+                type = parser.ReadString();
+            } else if (OVR::OVR_strcmp(name, "normalized") == 0) {
+                newGltfAccessor.normalized = parser.ReadBool();
+            } else if (OVR::OVR_strcmp(name, "min") == 0) {
+                minCount = parser.ReadNumberArray(min, MAX_MODEL_ACCESSOR_COMPONENT_SIZE);
+            } else if (OVR::OVR_strcmp(name, "max") == 0) {
+                maxCount = parser.ReadNumberArray(max, MAX_MODEL_ACCESSOR_COMPONENT_SIZE);
+            } else {
+                parser.SkipValue();
+            }
+        }
+
+        int componentCount = 0;
+        newGltfAccessor.type = ParseAccessorType(type.c_str(), componentCount);
+        if (newGltfAccessor.type == ACCESSOR_UNKNOWN) {
+            ALOGW("Error: Invalid type in gltfAccessor");
+            streamed.loaded = false;
+        }
+
+        if (minCount >= 0 && maxCount >= 0) {
+            switch (newGltfAccessor.componentType) {
+                case GL_BYTE:
+                case GL_UNSIGNED_BYTE:
+                case GL_SHORT:
+                case GL_UNSIGNED_SHORT:
+                case GL_UNSIGNED_INT:
+                    for (int i = 0; i < componentCount; i++) {
+                        newGltfAccessor.intMin[i] = (i < minCount) ? (int)min[i] : 0;
+                        newGltfAccessor.intMax[i] = (i < maxCount) ? (int)max[i] : 0;
+                    }
+                    break;
+                case GL_FLOAT:
+                    for (int i = 0; i < componentCount; i++) {
+                        newGltfAccessor.floatMin[i] = (i < minCount) ? (float)min[i] : 0.0f;
+                        newGltfAccessor.floatMax[i] = (i < maxCount) ? (float)max[i] : 0.0f;
+                    }
+                    break;
+                default:
+                    ALOGW("Error: Invalid componentType in gltfAccessor");
+                    streamed.loaded = false;
+            }
+            newGltfAccessor.minMaxSet = true;
+        }
+
+        modelFile.Accessors.push_back(newGltfAccessor);
+        streamed.accessorBufferViews.push_back(bufferView);
+    }
+}
+
+// JsonDocument::MemberHandler for the root object of a glTF file.
+static bool StreamArray(
+    const char* name,
+    OVR::JsonPullParser& parser,
+    ModelFile& modelFile,
+    glTFStreamedArrays& streamed) {
+    if (OVR::OVR_strcmp(name, "buffers") == 0) {
+        StreamBuffers(parser, streamed);
+        return true;
+    } else if (OVR::OVR_strcmp(name, "bufferViews") == 0) {
+        StreamBufferViews(parser, modelFile, streamed);
+        return true;
+    } else if (OVR::OVR_strcmp(name, "accessors") == 0) {
+        StreamAccessors(parser, modelFile, streamed);
+        return true;
+    }
+    return false;
+}
+
+// Parses the glTF JSON, streaming the large arrays into the model.
+static std::shared_ptr<OVR::JsonDocument> ParseglTFJson(
+    const char* json,
+    const size_t jsonLength,
+    ModelFile& modelFile,
+    glTFStreamedArrays& streamed,
+    const char** error) {
+    OVR::JsonPullParser parser(json, jsonLength);
+    return OVR::JsonDocument::Parse(
+        parser,
+        [&modelFile, &streamed](const char* name, OVR::JsonPullParser& p) {
+            return StreamArray(name, p, modelFile, streamed);
+        },
+        error);
+}
+
+// Links the buffer views to the buffers, once all buffers are loaded.
+static bool ResolveBufferViews(ModelFile& modelFile, const glTFStreamedArrays& streamed) {
+    for (size_t i = 0; i < modelFile.BufferViews.size(); i++) {
+        const int buffer = streamed.bufferViewBuffers[i];
+        if (buffer < 0 || buffer >= (const int)modelFile.Buffers.size()) {
+            ALOGW("Error: Invalid buffer Index in gltfBufferView");
+            return false;
+        }
+        modelFile.BufferViews[i].buffer = &modelFile.Buffers[buffer];
+    }
+    return true;
+}
+
 static size_t getComponentCount(ModelAccessorType type) {
     switch (type) {
         case ACCESSOR_SCALAR:
@@ -265,7 +517,7 @@ bool ReadSurfaceDataFromAccessor(
             const size_t startIndex = append ? out.size() : 0;
             out.resize(startIndex + accessor->count);
             int valueCount = (int)(accessor->count);
-            const char* src = (char*)buffer->bufferData.data() + offset;
+            const char* src = (const char*)buffer->GetData() + offset;
             if (accessor->componentType != componentType) {
                 if (componentType == MODEL_COMPONENT_TYPE_FLOAT) {
                     float* dst = (float*)&out[0];
@@ -423,7 +675,7 @@ bool ReadSurfaceDataFromAccessor(
                                         *(int16_t*)valueDst = (int16_t)value;
                                         break;
                                     case MODEL_COMPONENT_TYPE_UNSIGNED_SHORT:
-                                        *(uint8_t*)valueDst = (uint16_t)value;
+                                        *(uint16_t*)valueDst = (uint16_t)value;
                                         break;
                                     case MODEL_COMPONENT_TYPE_UNSIGNED_INT:
                                         *(uint32_t*)valueDst = (uint32_t)value;
@@ -435,7 +687,7 @@ bool ReadSurfaceDataFromAccessor(
                 }
             } else {
                 if (readStride == (int)srcValueSize) {
-                    memcpy(&out[startIndex], buffer->bufferData.data() + offset, srcRequiredSize);
+                    memcpy(&out[startIndex], src, srcRequiredSize);
                 } else {
                     char* dst = (char*)&out[0];
                     for (int i = 0; i < valueCount; i++) {
@@ -452,7 +704,7 @@ bool ReadSurfaceDataFromAccessor(
 }
 
 bool ReadVertexAttributes(
-    const OVR::JsonReader& attributes,
+    const JsonReader& attributes,
     ModelFile& modelFile,
     VertexAttribs& attribs,
     bool isMorphTarget) {
@@ -596,10 +848,213 @@ bool ReadVertexAttributes(
     return loaded;
 }
 
+// Bounds the vertices weighted to each joint, so the skinned bounds can be recalculated from the
+// joint matrices every frame.
+static void CalculateJointBounds(const VertexAttribs& attribs, std::vector<Bounds3f>& jointBounds) {
+    jointBounds.clear();
+    for (int v = 0; v < static_cast<int>(attribs.position.size()); v++) {
+        for (int i = 0; i < 4; i++) {
+            const int jointIndex = attribs.jointIndices[v][i];
+            if (attribs.jointWeights[v][i] <= 0.0f || jointIndex < 0) {
+                continue;
+            }
+            if (jointIndex >= static_cast<int>(jointBounds.size())) {
+                jointBounds.resize(jointIndex + 1, Bounds3f(Bounds3f::Init));
+            }
+            jointBounds[jointIndex].AddPoint(attribs.position[v]);
+        }
+    }
+}
+
+// Creates the geometry of a surface, in the layout its morph targets update if it has any.
+template <typename T>
+static void CreateSurfaceGeometry(
+    ModelSurface& surface,
+    const VertexAttribs& attribs,
+    const std::vector<T>& indices) {
+    GlGeometry& geo = surface.surfaceDef.geo;
+    if (surface.morphTargets.IsEmpty()) {
+        geo.Create(attribs, indices, VertexLayout::Compact(attribs));
+    } else {
+        geo.Create(attribs, indices, surface.morphTargets.GetVertexLayout());
+        geo.localBounds = surface.morphTargets.GetBounds();
+    }
+}
+
+// Vertex and index data of a single glTF primitive, decoded from its accessors.
+struct glTFDecodedPrimitive {
+    VertexAttribs attribs;
+    // Dense morph targets, only kept for primitives that may be split into sub-meshes.
+    std::vector<VertexAttribs> targets;
+    MorphTargets morphTargets;
+    std::vector<TriangleIndex32> indices;
+    std::vector<Bounds3f> jointBounds; // empty if the primitive is not skinned
+    GeometryOptimizeStats optimizeStats;
+    bool optimized = false;
+    bool loaded = false;
+};
+
+// Only reads the JSON, the accessors and the buffers, so primitives can be decoded in parallel.
+static bool DecodePrimitive(
+    const OVR::JsonValue primitiveValue,
+    ModelFile& modelFile,
+    const MaterialParms& materialParms,
+    glTFDecodedPrimitive& decoded) {
+    const JsonReader primitive(primitiveValue);
+    if (!primitive.IsObject()) {
+        ALOGW("Error: Invalid gltfPrimitive");
+        return false;
+    }
+
+    // VERTICES
+    const JsonReader attributes(primitive.GetChildByName("attributes"));
+    if (!attributes.IsObject()) {
+        return false; // reported when the surface is created
+    }
+    VertexAttribs& attribs = decoded.attribs;
+    bool loaded = ReadVertexAttributes(attributes, modelFile, attribs, false /*isMorphTarget*/);
+
+    // MORPH TARGETS
+    const JsonReader targets(primitive.GetChildByName("targets"));
+    if (targets.IsValid()) {
+        if (!targets.IsArray()) {
+            ALOGW("Error: Invalid targets on primitive");
+            loaded = false;
+        }
+
+        while (loaded && !targets.IsEndOfArray()) {
+            const JsonReader target(targets.GetNextArrayElement());
+            VertexAttribs targetAttribs;
+            loaded = ReadVertexAttributes(target, modelFile, targetAttribs, true /*isMorphTarget*/);
+            if (loaded) {
+                // for each morph target attribute, an original attribute MUST be present in the
+                // mesh primitive
+#define CHECK_ATTRIB_COUNT(ATTRIB)                                                               \
+    if (!targetAttribs.ATTRIB.empty() && targetAttribs.ATTRIB.size() != attribs.ATTRIB.size()) { \
+        ALOGW("Error: target " #ATTRIB " count mismatch on gltfPrimitive");                      \
+        loaded = false;                                                                          \
+    }
+                CHECK_ATTRIB_COUNT(position);
+                CHECK_ATTRIB_COUNT(normal);
+                CHECK_ATTRIB_COUNT(tangent);
+                CHECK_ATTRIB_COUNT(color);
+                CHECK_ATTRIB_COUNT(uv0);
+                CHECK_ATTRIB_COUNT(uv1);
+#undef CHECK_ATTRIB_COUNT
+                decoded.targets.emplace_back(std::move(targetAttribs));
+            }
+        }
+    }
+
+    // TRIANGLES
+    const int indicesIndex = primitive.GetChildInt32ByName("indices", -1);
+    if (indicesIndex < 0 || indicesIndex >= static_cast<int>(modelFile.Accessors.size())) {
+        ALOGW("Error: Invalid indices index on gltfPrimitive");
+        loaded = false;
+    } else if (
+        modelFile.Accessors[indicesIndex].componentType != MODEL_COMPONENT_TYPE_UNSIGNED_BYTE &&
+        modelFile.Accessors[indicesIndex].componentType != MODEL_COMPONENT_TYPE_UNSIGNED_SHORT &&
+        modelFile.Accessors[indicesIndex].componentType != MODEL_COMPONENT_TYPE_UNSIGNED_INT) {
+        ALOGW(
+            "Error: Invalid componentType %d for indices on gltfPrimitive",
+            modelFile.Accessors[indicesIndex].componentType);
+        loaded = false;
+    }
+
+    // read as 32-bit, the geometry is stored with 16-bit indices if they fit
+    if (loaded) {
+        ReadSurfaceDataFromAccessor(
+            decoded.indices,
+            modelFile,
+            indicesIndex,
+            ACCESSOR_SCALAR,
+            GL_UNSIGNED_INT,
+            -1,
+            false);
+    }
+
+    // OPTIMIZE
+    const int mode = primitive.GetChildInt32ByName("mode", GlGeometry::kPrimitiveTypeTriangles);
+    if (loaded && materialParms.OptimizeGeometry && mode == GlGeometry::kPrimitiveTypeTriangles) {
+        GeometryOptimizeParms parms;
+        // Vertices that only differ in a morph target must stay apart, and code that drives
+        // the targets may address their vertices by index.
+        parms.deduplicate = decoded.targets.empty();
+        parms.renumberVertices = decoded.targets.empty();
+        // blended surfaces are drawn in the order of their triangles
+        const int materialIndex = primitive.GetChildInt32ByName("material", -1);
+        const bool blended = materialParms.Transparent ||
+            (materialIndex >= 0 && materialIndex < static_cast<int>(modelFile.Materials.size()) &&
+             modelFile.Materials[materialIndex].alphaMode != ALPHA_MODE_OPAQUE);
+        parms.reorderTriangles = !blended;
+
+        const std::vector<TriangleIndex32> remap =
+            OptimizeGeometry(attribs, decoded.indices, parms, &decoded.optimizeStats);
+        decoded.optimized = !remap.empty();
+        if (decoded.optimized && parms.renumberVertices) {
+            for (VertexAttribs& target : decoded.targets) {
+                target = GatherVertexAttribs(target, remap);
+            }
+        }
+    }
+
+    // Morph targets are kept as sparse deltas. Primitives that may be split keep the dense
+    // targets until it is known whether the deltas are needed per sub-mesh.
+    if (loaded && !decoded.targets.empty() &&
+        static_cast<int>(attribs.position.size()) <= GlGeometry::MAX_GEOMETRY_VERTICES) {
+        decoded.morphTargets.Build(attribs, decoded.targets);
+        decoded.targets = std::vector<VertexAttribs>();
+    }
+
+    const bool skinned =
+        (attribs.jointIndices.size() == attribs.position.size() &&
+         attribs.jointWeights.size() == attribs.position.size());
+    if (loaded && skinned) {
+        CalculateJointBounds(attribs, decoded.jointBounds);
+    }
+
+    return loaded;
+}
+
+// Positions and indices of a single mesh, kept when the trace model is built.
+struct glTFTraceGeo {
+    std::vector<Vector3f> positions;
+    std::vector<int> indices;
+};
+
+// Builds modelFile.TraceModel from the meshes of all nodes, transformed to model space.
+static void BuildTraceModel(ModelFile& modelFile, const std::vector<glTFTraceGeo>& traceGeos) {
+    std::vector<Vector3f> vertices;
+    std::vector<int> indices;
+    for (const ModelNode& node : modelFile.Nodes) {
+        if (node.model == nullptr) {
+            continue;
+        }
+        const size_t modelIndex = static_cast<size_t>(node.model - modelFile.Models.data());
+        if (modelIndex >= traceGeos.size()) {
+            continue;
+        }
+        const glTFTraceGeo& geo = traceGeos[modelIndex];
+        const Matrix4f transform = node.GetGlobalTransform();
+        const int firstVertex = static_cast<int>(vertices.size());
+        for (const Vector3f& position : geo.positions) {
+            vertices.push_back(transform.Transform(position));
+        }
+        for (const int index : geo.indices) {
+            indices.push_back(firstVertex + index);
+        }
+    }
+
+    if (!modelFile.TraceModel.Build(vertices, std::vector<Vector2f>(), indices)) {
+        ALOGW("Could not build the trace model for '%s'", modelFile.FileName.c_str());
+    }
+}
+
 // Requires the buffers and images to already be loaded in the model
 bool LoadModelFile_glTF_Json(
     ModelFile& modelFile,
-    const char* modelsJson,
+    const OVR::JsonDocument& json,
+    const glTFStreamedArrays& streamed,
     const ModelGlPrograms& programs,
     const MaterialParms& materialParms,
     ModelGeo* outModelGeo) {
@@ -608,16 +1063,14 @@ bool LoadModelFile_glTF_Json(
 
     bool loaded = true;
 
-    const char* error = nullptr;
-    auto json = OVR::JSON::Parse(modelsJson, &error);
-    if (json == nullptr) {
-        ALOG("LoadModelFile_glTF_Json: Error loading %s : %s", modelFile.FileName.c_str(), error);
-        loaded = false;
-    } else {
-        const OVR::JsonReader models(json);
+    {
+        // One entry per model, only filled in when the trace model is built.
+        std::vector<glTFTraceGeo> traceGeos;
+
+        const JsonReader models(json.GetRoot());
         if (models.IsObject()) {
             if (loaded) { // ASSET
-                const OVR::JsonReader asset(models.GetChildByName("asset"));
+                const JsonReader asset(models.GetChildByName("asset"));
                 if (!asset.IsObject()) {
                     ALOGW("Error: No asset on gltfSceneFile");
                     loaded = false;
@@ -634,94 +1087,26 @@ bool LoadModelFile_glTF_Json(
             } // END ASSET
 
             if (loaded) { // ACCESSORS
-                LOGV("Loading accessors");
-                const OVR::JsonReader accessors(models.GetChildByName("accessors"));
-                if (accessors.IsArray()) {
-                    while (!accessors.IsEndOfArray() && loaded) {
-                        const OVR::JsonReader accessor(accessors.GetNextArrayElement());
-                        if (accessor.IsObject()) {
-                            ModelAccessor newGltfAccessor;
-
-                            newGltfAccessor.name = accessor.GetChildStringByName("name");
-                            const int bufferView = accessor.GetChildInt32ByName("bufferView");
-                            newGltfAccessor.byteOffset = accessor.GetChildInt32ByName("byteOffset");
-                            newGltfAccessor.componentType =
-                                accessor.GetChildInt32ByName("componentType");
-                            newGltfAccessor.count = accessor.GetChildInt32ByName("count");
-                            const std::string type = accessor.GetChildStringByName("type");
-                            newGltfAccessor.normalized = accessor.GetChildBoolByName("normalized");
-
-                            if (bufferView < 0 ||
-                                bufferView >= (const int)modelFile.BufferViews.size()) {
-                                ALOGW("Error: Invalid bufferView Index in gltfAccessor");
-                                loaded = false;
-                            }
-
-                            int componentCount = 0;
-                            if (OVR::OVR_stricmp(type.c_str(), "SCALAR") == 0) {
-                                newGltfAccessor.type = ACCESSOR_SCALAR;
-                                componentCount = 1;
-                            } else if (OVR::OVR_stricmp(type.c_str(), "VEC2") == 0) {
-                                newGltfAccessor.type = ACCESSOR_VEC2;
-                                componentCount = 2;
-                            } else if (OVR::OVR_stricmp(type.c_str(), "VEC3") == 0) {
-                                newGltfAccessor.type = ACCESSOR_VEC3;
-                                componentCount = 3;
-                            } else if (OVR::OVR_stricmp(type.c_str(), "VEC4") == 0) {
-                                newGltfAccessor.type = ACCESSOR_VEC4;
-                                componentCount = 4;
-                            } else if (OVR::OVR_stricmp(type.c_str(), "MAT2") == 0) {
-                                newGltfAccessor.type = ACCESSOR_MAT2;
-                                componentCount = 4;
-                            } else if (OVR::OVR_stricmp(type.c_str(), "MAT3") == 0) {
-                                newGltfAccessor.type = ACCESSOR_MAT3;
-                                componentCount = 9;
-                            } else if (OVR::OVR_stricmp(type.c_str(), "MAT4") == 0) {
-                                newGltfAccessor.type = ACCESSOR_MAT4;
-                                componentCount = 16;
-                            } else {
-                                ALOGW("Error: Invalid type in gltfAccessor");
-                                loaded = false;
-                            }
-
-                            auto min = accessor.GetChildByName("min");
-                            auto max = accessor.GetChildByName("max");
-                            if (min != nullptr && max != nullptr) {
-                                switch (newGltfAccessor.componentType) {
-                                    case GL_BYTE:
-                                    case GL_UNSIGNED_BYTE:
-                                    case GL_SHORT:
-                                    case GL_UNSIGNED_SHORT:
-                                    case GL_UNSIGNED_INT:
-                                        ParseIntArray(newGltfAccessor.intMin, componentCount, min);
-                                        ParseIntArray(newGltfAccessor.intMax, componentCount, max);
-                                        break;
-                                    case GL_FLOAT:
-                                        ParseFloatArray(
-                                            newGltfAccessor.floatMin, componentCount, min);
-                                        ParseFloatArray(
-                                            newGltfAccessor.floatMax, componentCount, max);
-                                        break;
-                                    default:
-                                        ALOGW("Error: Invalid componentType in gltfAccessor");
-                                        loaded = false;
-                                }
-                                newGltfAccessor.minMaxSet = true;
-                            }
-
-                            newGltfAccessor.bufferView = &modelFile.BufferViews[bufferView];
-                            modelFile.Accessors.push_back(newGltfAccessor);
-                        }
+                // The accessors themselves were streamed while parsing.
+                LOGV("Resolving accessors");
+                for (size_t i = 0; i < modelFile.Accessors.size(); i++) {
+                    const int bufferView = streamed.accessorBufferViews[i];
+                    if (bufferView < 0 ||
+                        bufferView >= (const int)modelFile.BufferViews.size()) {
+                        ALOGW("Error: Invalid bufferView Index in gltfAccessor");
+                        loaded = false;
+                        break;
                     }
+                    modelFile.Accessors[i].bufferView = &modelFile.BufferViews[bufferView];
                 }
             } // END ACCESSORS
 
             if (loaded) { // SAMPLERS
                 LOGV("Loading samplers");
-                const OVR::JsonReader samplers(models.GetChildByName("samplers"));
+                const JsonReader samplers(models.GetChildByName("samplers"));
                 if (samplers.IsArray()) {
                     while (!samplers.IsEndOfArray() && loaded) {
-                        const OVR::JsonReader sampler(samplers.GetNextArrayElement());
+                        const JsonReader sampler(samplers.GetNextArrayElement());
                         if (sampler.IsObject()) {
                             ModelSampler newGltfSampler;
 
@@ -777,20 +1162,20 @@ bool LoadModelFile_glTF_Json(
 
             if (loaded) { // TEXTURES
                 LOGV("Loading textures");
-                const OVR::JsonReader textures(models.GetChildByName("textures"));
+                const JsonReader textures(models.GetChildByName("textures"));
                 if (textures.IsArray() && loaded) {
                     while (!textures.IsEndOfArray()) {
-                        const OVR::JsonReader texture(textures.GetNextArrayElement());
+                        const JsonReader texture(textures.GetNextArrayElement());
                         if (texture.IsObject()) {
                             ModelTextureWrapper newGltfTexture;
 
                             newGltfTexture.name = texture.GetChildStringByName("name");
                             const int sampler = texture.GetChildInt32ByName("sampler", -1);
                             int image = texture.GetChildInt32ByName("source", -1);
-                            const OVR::JsonReader textureExtensions =
+                            const JsonReader textureExtensions =
                                 texture.GetChildByName("extensions");
                             if (textureExtensions.IsObject()) {
-                                const OVR::JsonReader basisuExtension =
+                                const JsonReader basisuExtension =
                                     textureExtensions.GetChildByName("KHR_texture_basisu");
                                 if (basisuExtension.IsObject()) {
                                     image = basisuExtension.GetChildInt32ByName("source", image);
@@ -829,10 +1214,10 @@ bool LoadModelFile_glTF_Json(
 
             if (loaded) { // MATERIALS
                 LOGV("Loading materials");
-                const OVR::JsonReader materials(models.GetChildByName("materials"));
+                const JsonReader materials(models.GetChildByName("materials"));
                 if (materials.IsArray() && loaded) {
                     while (!materials.IsEndOfArray()) {
-                        const OVR::JsonReader material(materials.GetNextArrayElement());
+                        const JsonReader material(materials.GetNextArrayElement());
                         if (material.IsObject()) {
                             ModelMaterial newGltfMaterial;
 
@@ -873,7 +1258,7 @@ bool LoadModelFile_glTF_Json(
                                 material.GetChildBoolByName("doubleSided", false);
 
                             // pbrMetallicRoughness
-                            const OVR::JsonReader pbrMetallicRoughness =
+                            const JsonReader pbrMetallicRoughness =
                                 material.GetChildByName("pbrMetallicRoughness");
                             if (pbrMetallicRoughness.IsObject()) {
                                 auto baseColorFactor =
@@ -894,7 +1279,7 @@ bool LoadModelFile_glTF_Json(
                                         baseColorFactor->GetItemByIndex(3)->GetFloatValue();
                                 }
 
-                                const OVR::JsonReader baseColorTexture =
+                                const JsonReader baseColorTexture =
                                     pbrMetallicRoughness.GetChildByName("baseColorTexture");
                                 if (baseColorTexture.IsObject()) {
                                     int index = baseColorTexture.GetChildInt32ByName("index", -1);
@@ -916,7 +1301,7 @@ bool LoadModelFile_glTF_Json(
                                     pbrMetallicRoughness.GetChildFloatByName(
                                         "roughnessFactor", 1.0f);
 
-                                const OVR::JsonReader metallicRoughnessTexture =
+                                const JsonReader metallicRoughnessTexture =
                                     pbrMetallicRoughness.GetChildByName("metallicRoughnessTexture");
                                 if (metallicRoughnessTexture.IsObject()) {
                                     int index =
@@ -934,7 +1319,7 @@ bool LoadModelFile_glTF_Json(
                             }
 
                             // normalTexture
-                            const OVR::JsonReader normalTexture =
+                            const JsonReader normalTexture =
                                 material.GetChildByName("normalTexture");
                             if (normalTexture.IsObject()) {
                                 int index = normalTexture.GetChildInt32ByName("index", -1);
@@ -952,7 +1337,7 @@ bool LoadModelFile_glTF_Json(
                             }
 
                             // occlusionTexture
-                            const OVR::JsonReader occlusionTexture =
+                            const JsonReader occlusionTexture =
                                 material.GetChildByName("occlusionTexture");
                             if (occlusionTexture.IsObject()) {
                                 int index = occlusionTexture.GetChildInt32ByName("index", -1);
@@ -970,7 +1355,7 @@ bool LoadModelFile_glTF_Json(
                             }
 
                             // emissiveTexture
-                            const OVR::JsonReader emissiveTexture =
+                            const JsonReader emissiveTexture =
                                 material.GetChildByName("emissiveTexture");
                             if (emissiveTexture.IsObject()) {
                                 int index = emissiveTexture.GetChildInt32ByName("index", -1);
@@ -984,7 +1369,7 @@ bool LoadModelFile_glTF_Json(
                             }
 
                             // detailTexture
-                            const OVR::JsonReader detailTexture =
+                            const JsonReader detailTexture =
                                 material.GetChildByName("detailTexture");
                             if (detailTexture.IsObject()) {
                                 int index = detailTexture.GetChildInt32ByName("index", -1);
@@ -1011,24 +1396,84 @@ bool LoadModelFile_glTF_Json(
 
             if (loaded) { // MODELS (gltf mesh)
                 LOGV("Loading meshes");
-                const OVR::JsonReader meshes(models.GetChildByName("meshes"));
+                const JsonReader meshes(models.GetChildByName("meshes"));
+
+                // Decode the vertex and index data of all primitives on the worker threads first,
+                // the surfaces and their GL objects are created below on this thread. The GL
+                // objects stay in this pass rather than a separate one because callers get a
+                // finished ModelFile back, so this function must run on the GL thread.
+                std::vector<OVR::JsonValue> primitiveValues;
+                if (meshes.IsArray()) {
+                    const JsonReader meshList(meshes.AsParent());
+                    while (!meshList.IsEndOfArray()) {
+                        const JsonReader mesh(meshList.GetNextArrayElement());
+                        if (mesh.IsObject()) {
+                            const JsonReader primitives(mesh.GetChildByName("primitives"));
+                            if (primitives.IsArray()) {
+                                while (!primitives.IsEndOfArray()) {
+                                    primitiveValues.push_back(primitives.GetNextArrayElement());
+                                }
+                            }
+                        }
+                    }
+                }
+                std::vector<glTFDecodedPrimitive> decodedPrimitives(primitiveValues.size());
+                ParallelFor(static_cast<int>(primitiveValues.size()), [&](int i) {
+                    decodedPrimitives[i].loaded = DecodePrimitive(
+                        primitiveValues[i], modelFile, materialParms, decodedPrimitives[i]);
+                });
+                {
+                    int optimizedCount = 0;
+                    int cachedCount = 0;
+                    int64_t triangleCount = 0;
+                    int64_t verticesBefore = 0;
+                    int64_t verticesAfter = 0;
+                    double missesBefore = 0.0;
+                    double missesAfter = 0.0;
+                    for (const glTFDecodedPrimitive& decoded : decodedPrimitives) {
+                        if (decoded.optimized) {
+                            const GeometryOptimizeStats& stats = decoded.optimizeStats;
+                            optimizedCount++;
+                            cachedCount += stats.fromDiskCache ? 1 : 0;
+                            triangleCount += stats.triangleCount;
+                            verticesBefore += stats.verticesBefore;
+                            verticesAfter += stats.verticesAfter;
+                            missesBefore += stats.acmrBefore * stats.triangleCount;
+                            missesAfter += stats.acmrAfter * stats.triangleCount;
+                        }
+                    }
+                    if (triangleCount > 0) {
+                        ALOG(
+                            "Optimized %d primitives (%d from cache): %lld -> %lld vertices, "
+                            "ACMR %.3f -> %.3f",
+                            optimizedCount,
+                            cachedCount,
+                            (long long)verticesBefore,
+                            (long long)verticesAfter,
+                            missesBefore / triangleCount,
+                            missesAfter / triangleCount);
+                    }
+                }
+                size_t nextDecodedPrimitive = 0;
+
                 if (meshes.IsArray()) {
                     while (!meshes.IsEndOfArray() && loaded) {
-                        const OVR::JsonReader mesh(meshes.GetNextArrayElement());
+                        const JsonReader mesh(meshes.GetNextArrayElement());
                         if (mesh.IsObject()) {
                             Model newGltfModel;
+                            glTFTraceGeo traceGeo;
 
                             newGltfModel.name = mesh.GetChildStringByName("name");
 
                             { // SURFACES (gltf primitive)
-                                const OVR::JsonReader primitives(mesh.GetChildByName("primitives"));
+                                const JsonReader primitives(mesh.GetChildByName("primitives"));
                                 if (!primitives.IsArray()) {
                                     ALOGW("Error: no primitives on gltfMesh");
                                     loaded = false;
                                 }
 
                                 while (!primitives.IsEndOfArray() && loaded) {
-                                    const OVR::JsonReader primitive(
+                                    const JsonReader primitive(
                                         primitives.GetNextArrayElement());
 
                                     ModelSurface newGltfSurface;
@@ -1067,99 +1512,64 @@ bool LoadModelFile_glTF_Json(
                                         loaded = false;
                                     }
 
-                                    const OVR::JsonReader attributes(
+                                    const JsonReader attributes(
                                         primitive.GetChildByName("attributes"));
                                     if (!attributes.IsObject()) {
                                         ALOGW("Error: no attributes on gltfPrimitive");
                                         loaded = false;
                                     }
 
-                                    TriangleIndex outGeoIndexOffset = 0;
+                                    TriangleIndex32 outGeoIndexOffset = 0;
                                     if (outModelGeo != nullptr) {
-                                        outGeoIndexOffset = static_cast<TriangleIndex>(
+                                        outGeoIndexOffset = static_cast<TriangleIndex32>(
                                             (*outModelGeo).positions.size());
                                     }
 
-                                    // VERTICES
-                                    VertexAttribs attribs;
-                                    loaded = ReadVertexAttributes(
-                                        attributes, modelFile, attribs, false /*isMorphTarget*/);
-
-                                    // MORPH TARGETS
-                                    const OVR::JsonReader targets(
-                                        primitive.GetChildByName("targets"));
-                                    if (targets.IsValid()) {
-                                        if (!targets.IsArray()) {
-                                            ALOGW("Error: Invalid targets on primitive");
-                                            loaded = false;
-                                        }
-
-                                        while (!targets.IsEndOfArray() && loaded) {
-                                            const OVR::JsonReader target(
-                                                targets.GetNextArrayElement());
-                                            VertexAttribs targetAttribs;
-                                            loaded = ReadVertexAttributes(
-                                                target,
-                                                modelFile,
-                                                targetAttribs,
-                                                true /*isMorphTarget*/);
-                                            if (loaded) {
-                                                // for each morph target attribute, an original
-                                                // attribute MUST be present in the mesh primitive
-#define CHECK_ATTRIB_COUNT(ATTRIB)                                                               \
-    if (!targetAttribs.ATTRIB.empty() && targetAttribs.ATTRIB.size() != attribs.ATTRIB.size()) { \
-        ALOGW("Error: target " #ATTRIB " count mismatch on gltfPrimitive");                      \
-        loaded = false;                                                                          \
-    }
-                                                CHECK_ATTRIB_COUNT(position);
-                                                CHECK_ATTRIB_COUNT(normal);
-                                                CHECK_ATTRIB_COUNT(tangent);
-                                                CHECK_ATTRIB_COUNT(color);
-                                                CHECK_ATTRIB_COUNT(uv0);
-                                                CHECK_ATTRIB_COUNT(uv1);
-#undef CHECK_ATTRIB_COUNT
-                                                newGltfSurface.targets.emplace_back(
-                                                    std::move(targetAttribs));
-                                            }
-                                        }
-                                    }
-
-                                    // TRIANGLES
-                                    std::vector<TriangleIndex> indices;
-                                    const int indicesIndex =
-                                        primitive.GetChildInt32ByName("indices", -1);
-                                    if (indicesIndex < 0 ||
-                                        indicesIndex >=
-                                            static_cast<int>(modelFile.Accessors.size())) {
-                                        ALOGW("Error: Invalid indices index on gltfPrimitive");
+                                    glTFDecodedPrimitive& decoded =
+                                        decodedPrimitives[nextDecodedPrimitive++];
+                                    if (!decoded.loaded) {
                                         loaded = false;
                                     }
-
-                                    // Reduced severity to warning: this doesn't break most data
-                                    // types, but can cause unexpected results.
-                                    if (modelFile.Accessors[indicesIndex].componentType !=
-                                        GL_UNSIGNED_SHORT) {
-                                        ALOGW(
-                                            "Warning: Currently, only componentType of %d supported for indices, %d requested",
-                                            GL_UNSIGNED_SHORT,
-                                            modelFile.Accessors[indicesIndex].componentType);
+                                    VertexAttribs attribs = std::move(decoded.attribs);
+                                    const std::vector<VertexAttribs> targets =
+                                        std::move(decoded.targets);
+                                    newGltfSurface.morphTargets = std::move(decoded.morphTargets);
+                                    const std::vector<TriangleIndex32>& indices =
+                                        decoded.indices;
+
+                                    // Primitives too large for 16-bit indices get 32-bit
+                                    // indices, or are split into 16-bit sub-meshes on devices
+                                    // that prefer those.
+                                    const int vertexCount =
+                                        static_cast<int>(attribs.position.size());
+                                    std::vector<GeometrySplit> splits;
+                                    if (vertexCount > GlGeometry::MAX_GEOMETRY_VERTICES) {
+                                        splits = SplitTriangles(indices, vertexCount);
+                                        if (!PreferSplitGeometry(splits, vertexCount)) {
+                                            splits.clear();
+                                        }
                                     }
-
-                                    if (loaded) {
-                                        ReadSurfaceDataFromAccessor(
-                                            indices,
-                                            modelFile,
-                                            primitive.GetChildInt32ByName("indices", -1),
-                                            ACCESSOR_SCALAR,
-                                            GL_UNSIGNED_SHORT,
-                                            -1,
-                                            false);
+                                    if (splits.empty()) {
+                                        if (!targets.empty()) {
+                                            newGltfSurface.morphTargets.Build(attribs, targets);
+                                        }
+                                        CreateSurfaceGeometry(newGltfSurface, attribs, indices);
+                                    }
+                                    if (materialParms.BuildTraceModel) {
+                                        const int firstVertex =
+                                            static_cast<int>(traceGeo.positions.size());
+                                        traceGeo.positions.insert(
+                                            traceGeo.positions.end(),
+                                            attribs.position.begin(),
+                                            attribs.position.end());
+                                        for (const TriangleIndex32 index : indices) {
+                                            traceGeo.indices.push_back(firstVertex + index);
+                                        }
                                     }
-
-                                    newGltfSurface.surfaceDef.geo.Create(attribs, indices);
                                     bool skinned =
                                         (attribs.jointIndices.size() == attribs.position.size() &&
                                          attribs.jointWeights.size() == attribs.position.size());
+                                    newGltfSurface.jointBounds = std::move(decoded.jointBounds);
 
                                     if (outModelGeo != nullptr) {
                                         for (int i = 0; i < static_cast<int>(indices.size()); ++i) {
@@ -1306,19 +1716,42 @@ bool LoadModelFile_glTF_Json(
                                             .cullEnable = false;
                                     }
 
-                                    // Retain original vertex data if we use morph targets
-                                    if (!newGltfSurface.targets.empty()) {
-                                        newGltfSurface.attribs = std::move(attribs);
+                                    // one surface per sub-mesh, sharing the material and state
+                                    for (const GeometrySplit& split : splits) {
+                                        ModelSurface splitSurface = newGltfSurface;
+                                        VertexAttribs splitAttribs =
+                                            GatherVertexAttribs(attribs, split.vertices);
+                                        if (!targets.empty()) {
+                                            std::vector<VertexAttribs> splitTargets;
+                                            for (const VertexAttribs& target : targets) {
+                                                splitTargets.emplace_back(
+                                                    GatherVertexAttribs(target, split.vertices));
+                                            }
+                                            splitSurface.morphTargets.Build(
+                                                splitAttribs, splitTargets);
+                                        }
+                                        CreateSurfaceGeometry(
+                                            splitSurface, splitAttribs, split.indices);
+                                        if (skinned) {
+                                            CalculateJointBounds(
+                                                splitAttribs, splitSurface.jointBounds);
+                                        }
+                                        newGltfModel.surfaces.emplace_back(
+                                            std::move(splitSurface));
+                                    }
+
+                                    if (splits.empty()) {
+                                        newGltfModel.surfaces.emplace_back(
+                                            std::move(newGltfSurface));
                                     }
-                                    newGltfModel.surfaces.emplace_back(std::move(newGltfSurface));
                                 }
                             } // END SURFACES
 
                             // all primitives MUST have the same number of morph targets in the same
                             // order
                             for (const auto& surface : newGltfModel.surfaces) {
-                                if (newGltfModel.surfaces[0].targets.size() !=
-                                    surface.targets.size()) {
+                                if (newGltfModel.surfaces[0].morphTargets.GetTargetCount() !=
+                                    surface.morphTargets.GetTargetCount()) {
                                     ALOGW(
                                         "Error: not all primitives have the same number of morph targets");
                                     loaded = false;
@@ -1327,14 +1760,15 @@ bool LoadModelFile_glTF_Json(
 
                             { // WEIGHTS (optional)
                                 if (loaded) {
-                                    const OVR::JsonReader weights(mesh.GetChildByName("weights"));
+                                    const JsonReader weights(mesh.GetChildByName("weights"));
                                     if (weights.IsArray()) {
                                         while (!weights.IsEndOfArray()) {
                                             newGltfModel.weights.push_back(
                                                 weights.GetNextArrayFloat(0.0f));
                                         }
-                                        if (newGltfModel.weights.size() !=
-                                            newGltfModel.surfaces[0].targets.size()) {
+                                        if (static_cast<int>(newGltfModel.weights.size()) !=
+                                            newGltfModel.surfaces[0]
+                                                .morphTargets.GetTargetCount()) {
                                             ALOGW(
                                                 "Error: mesh weights and morph target count mismatch");
                                             loaded = false;
@@ -1343,12 +1777,17 @@ bool LoadModelFile_glTF_Json(
                                         // when weights is undefined, the default targets' weights
                                         // are zeros
                                         newGltfModel.weights.resize(
-                                            newGltfModel.surfaces[0].targets.size(), 0.0f);
+                                            newGltfModel.surfaces[0]
+                                                .morphTargets.GetTargetCount(),
+                                            0.0f);
                                     }
                                 }
                             } // END WEIGHTS
 
                             modelFile.Models.emplace_back(std::move(newGltfModel));
+                            if (materialParms.BuildTraceModel) {
+                                traceGeos.emplace_back(std::move(traceGeo));
+                            }
                         }
                     }
                 }
@@ -1357,10 +1796,10 @@ bool LoadModelFile_glTF_Json(
             if (loaded) { // CAMERAS
                           // #TODO: best way to expose cameras to apps?
                 LOGV("Loading cameras");
-                const OVR::JsonReader cameras(models.GetChildByName("cameras"));
+                const JsonReader cameras(models.GetChildByName("cameras"));
                 if (cameras.IsArray() && loaded) {
                     while (!cameras.IsEndOfArray()) {
-                        const OVR::JsonReader camera(cameras.GetNextArrayElement());
+                        const JsonReader camera(cameras.GetNextArrayElement());
                         if (camera.IsObject()) {
                             ModelCamera newGltfCamera;
 
@@ -1381,7 +1820,7 @@ bool LoadModelFile_glTF_Json(
                             }
 
                             if (newGltfCamera.type == MODEL_CAMERA_TYPE_ORTHOGRAPHIC) {
-                                const OVR::JsonReader orthographic(
+                                const JsonReader orthographic(
                                     camera.GetChildByName("orthographic"));
                                 if (!orthographic.IsObject()) {
                                     ALOGW(
@@ -1406,7 +1845,7 @@ bool LoadModelFile_glTF_Json(
                                 }
                             } else // MODEL_CAMERA_TYPE_PERSPECTIVE
                             {
-                                const OVR::JsonReader perspective(
+                                const JsonReader perspective(
                                     camera.GetChildByName("perspective"));
                                 if (!perspective.IsObject()) {
                                     ALOGW("Error: No perspective object on perspective gltfCamera");
@@ -1442,18 +1881,18 @@ bool LoadModelFile_glTF_Json(
             if (loaded) { // NODES
                 LOGV("Loading nodes");
                 auto pNodes = models.GetChildByName("nodes");
-                const OVR::JsonReader nodes(pNodes);
+                const JsonReader nodes(pNodes);
                 if (nodes.IsArray() && loaded) {
                     modelFile.Nodes.resize(pNodes->GetItemCount());
 
                     int nodeIndex = 0;
                     while (!nodes.IsEndOfArray()) {
-                        const OVR::JsonReader node(nodes.GetNextArrayElement());
+                        const JsonReader node(nodes.GetNextArrayElement());
                         if (node.IsObject()) {
                             ModelNode* pGltfNode = &modelFile.Nodes[nodeIndex];
 
                             pGltfNode->name = node.GetChildStringByName("name");
-                            const OVR::JsonReader matrixReader = node.GetChildByName("matrix");
+                            const JsonReader matrixReader = node.GetChildByName("matrix");
                             if (matrixReader.IsArray()) {
                                 Matrix4f matrix;
                                 ParseFloatArray(matrix.M[0], 16, matrixReader);
@@ -1579,7 +2018,7 @@ bool LoadModelFile_glTF_Json(
 
                                 // initialize morph target weights
                                 if (!pGltfNode->model->weights.empty()) {
-                                    const OVR::JsonReader weightsReader(
+                                    const JsonReader weightsReader(
                                         node.GetChildByName("weights"));
                                     if (weightsReader.IsArray()) {
                                         // use node weights if it is defined
@@ -1608,7 +2047,7 @@ bool LoadModelFile_glTF_Json(
                                 pGltfNode->scale);
                             pGltfNode->SetLocalTransform(localTransform);
 
-                            const OVR::JsonReader children = node.GetChildByName("children");
+                            const JsonReader children = node.GetChildByName("children");
                             if (children.IsArray()) {
                                 while (!children.IsEndOfArray()) {
                                     auto child = children.GetNextArrayElement();
@@ -1637,23 +2076,23 @@ bool LoadModelFile_glTF_Json(
             if (loaded) { // ANIMATIONS
                 LOGV("loading Animations");
                 auto animationsJSON = models.GetChildByName("animations");
-                const OVR::JsonReader animations = animationsJSON;
+                const JsonReader animations = animationsJSON;
                 if (animations.IsArray()) {
                     int animationCount = 0;
                     while (!animations.IsEndOfArray() && loaded) {
                         modelFile.Animations.resize(animationsJSON->GetArraySize());
-                        const OVR::JsonReader animation(animations.GetNextArrayElement());
+                        const JsonReader animation(animations.GetNextArrayElement());
                         if (animation.IsObject()) {
                             ModelAnimation& modelAnimation = modelFile.Animations[animationCount];
 
                             modelAnimation.name = animation.GetChildStringByName("name");
 
                             // ANIMATION SAMPLERS
-                            const OVR::JsonReader samplers = animation.GetChildByName("samplers");
+                            const JsonReader samplers = animation.GetChildByName("samplers");
                             if (samplers.IsArray()) {
                                 while (!samplers.IsEndOfArray() && loaded) {
                                     ModelAnimationSampler modelAnimationSampler;
-                                    const OVR::JsonReader sampler = samplers.GetNextArrayElement();
+                                    const JsonReader sampler = samplers.GetNextArrayElement();
                                     if (sampler.IsObject()) {
                                         int inputIndex = sampler.GetChildInt32ByName("input", -1);
                                         if (inputIndex < 0 ||
@@ -1730,10 +2169,10 @@ bool LoadModelFile_glTF_Json(
                             } // END ANIMATION SAMPLERS
 
                             // ANIMATION CHANNELS
-                            const OVR::JsonReader channels = animation.GetChildByName("channels");
+                            const JsonReader channels = animation.GetChildByName("channels");
                             if (channels.IsArray()) {
                                 while (!channels.IsEndOfArray() && loaded) {
-                                    const OVR::JsonReader channel = channels.GetNextArrayElement();
+                                    const JsonReader channel = channels.GetNextArrayElement();
                                     if (channel.IsObject()) {
                                         ModelAnimationChannel modelAnimationChannel;
 
@@ -1752,7 +2191,7 @@ bool LoadModelFile_glTF_Json(
                                                 &modelAnimation.samplers[samplerIndex];
                                         }
 
-                                        const OVR::JsonReader target =
+                                        const JsonReader target =
                                             channel.GetChildByName("target");
                                         if (target.IsObject()) {
                                             // not required so -1 means do not do animation.
@@ -1804,8 +2243,9 @@ bool LoadModelFile_glTF_Json(
                                                     auto node =
                                                         modelFile
                                                             .Nodes[modelAnimationChannel.nodeIndex];
-                                                    outputCount /=
-                                                        node.model->surfaces[0].targets.size();
+                                                    outputCount /= node.model->surfaces[0]
+                                                                       .morphTargets
+                                                                       .GetTargetCount();
                                                 }
 
                                                 if (sampler->interpolation ==
@@ -1877,7 +2317,7 @@ bool LoadModelFile_glTF_Json(
                                             loaded = false;
                                         }
 
-                                        const OVR::JsonReader extras =
+                                        const JsonReader extras =
                                             channel.GetChildByName("extras");
                                         if (extras.IsObject()) {
                                             // additive index only make sense for weights
@@ -1910,52 +2350,45 @@ bool LoadModelFile_glTF_Json(
             } // END ANIMATIONS
 
             if (loaded) { // ANIMATION TIMELINES
-                // create the timelines
-                for (int i = 0; i < static_cast<int>(modelFile.Animations.size()); i++) {
-                    for (int j = 0; j < static_cast<int>(modelFile.Animations[i].samplers.size());
-                         j++) {
-                        // if there isn't already a timeline with this accessor,
-                        // create a new one.
-                        ModelAnimationSampler& sampler = modelFile.Animations[i].samplers[j];
-                        bool foundTimeLine = false;
-                        for (int timeLineIndex = 0;
-                             timeLineIndex < static_cast<int>(modelFile.AnimationTimeLines.size());
-                             timeLineIndex++) {
-                            if (modelFile.AnimationTimeLines[timeLineIndex].accessor ==
-                                sampler.input) {
-                                foundTimeLine = true;
-                                sampler.timeLineIndex = timeLineIndex;
-                                break;
-                            }
+                // one timeline per distinct input accessor, initialized on the worker threads
+                std::unordered_map<const ModelAccessor*, int> timeLineOfAccessor;
+                std::vector<const ModelAccessor*> timeLineAccessors;
+                for (ModelAnimation& animation : modelFile.Animations) {
+                    for (ModelAnimationSampler& sampler : animation.samplers) {
+                        const auto found = timeLineOfAccessor.emplace(
+                            sampler.input, static_cast<int>(timeLineAccessors.size()));
+                        if (found.second) {
+                            timeLineAccessors.push_back(sampler.input);
                         }
+                        sampler.timeLineIndex = found.first->second;
+                    }
+                }
 
-                        if (!foundTimeLine) {
-                            ModelAnimationTimeLine timeline;
-                            timeline.Initialize(sampler.input);
-                            if (static_cast<int>(modelFile.AnimationTimeLines.size()) == 0) {
-                                modelFile.animationStartTime = timeline.startTime;
-                                modelFile.animationEndTime = timeline.endTime;
-                            } else {
-                                modelFile.animationStartTime = std::min<float>(
-                                    modelFile.animationStartTime, timeline.startTime);
-                                modelFile.animationEndTime =
-                                    std::max<float>(modelFile.animationEndTime, timeline.endTime);
-                            }
+                modelFile.AnimationTimeLines.resize(timeLineAccessors.size());
+                ParallelFor(static_cast<int>(timeLineAccessors.size()), [&](int i) {
+                    modelFile.AnimationTimeLines[i].Initialize(timeLineAccessors[i]);
+                });
 
-                            modelFile.AnimationTimeLines.push_back(timeline);
-                            sampler.timeLineIndex =
-                                static_cast<int>(modelFile.AnimationTimeLines.size()) - 1;
-                        }
+                for (int i = 0; i < static_cast<int>(modelFile.AnimationTimeLines.size()); i++) {
+                    const ModelAnimationTimeLine& timeline = modelFile.AnimationTimeLines[i];
+                    if (i == 0) {
+                        modelFile.animationStartTime = timeline.startTime;
+                        modelFile.animationEndTime = timeline.endTime;
+                    } else {
+                        modelFile.animationStartTime =
+                            std::min<float>(modelFile.animationStartTime, timeline.startTime);
+                        modelFile.animationEndTime =
+                            std::max<float>(modelFile.animationEndTime, timeline.endTime);
                     }
                 }
             } // END ANIMATION TIMELINES
 
             if (loaded) { // SKINS
                 LOGV("Loading skins");
-                const OVR::JsonReader skins(models.GetChildByName("skins"));
+                const JsonReader skins(models.GetChildByName("skins"));
                 if (skins.IsArray()) {
                     while (!skins.IsEndOfArray() && loaded) {
-                        const OVR::JsonReader skin(skins.GetNextArrayElement());
+                        const JsonReader skin(skins.GetNextArrayElement());
                         if (skin.IsObject()) {
                             ModelSkin newSkin;
 
@@ -1985,7 +2418,7 @@ bool LoadModelFile_glTF_Json(
                                 }
                             }
 
-                            const OVR::JsonReader joints = skin.GetChildByName("joints");
+                            const JsonReader joints = skin.GetChildByName("joints");
                             if (joints.IsArray()) {
                                 while (!joints.IsEndOfArray() && loaded) {
                                     int jointIndex = joints.GetNextArrayInt32(-1);
@@ -2046,16 +2479,16 @@ bool LoadModelFile_glTF_Json(
 
             if (loaded) { // SCENES
                 LOGV("Loading scenes");
-                const OVR::JsonReader scenes(models.GetChildByName("scenes"));
+                const JsonReader scenes(models.GetChildByName("scenes"));
                 if (scenes.IsArray()) {
                     while (!scenes.IsEndOfArray() && loaded) {
-                        const OVR::JsonReader scene(scenes.GetNextArrayElement());
+                        const JsonReader scene(scenes.GetNextArrayElement());
                         if (scene.IsObject()) {
                             ModelSubScene newGltfScene;
 
                             newGltfScene.name = scene.GetChildStringByName("name");
 
-                            const OVR::JsonReader nodes = scene.GetChildByName("nodes");
+                            const JsonReader nodes = scene.GetChildByName("nodes");
                             if (nodes.IsArray()) {
                                 while (!nodes.IsEndOfArray()) {
                                     const int nodeIndex = nodes.GetNextArrayInt32();
@@ -2093,6 +2526,10 @@ bool LoadModelFile_glTF_Json(
                 }
             }
 
+            if (loaded && materialParms.BuildTraceModel) {
+                BuildTraceModel(modelFile, traceGeos);
+            }
+
             // print out the scene info
             if (loaded) {
                 LOGV("Model Loaded:     '%s'", modelFile.FileName.c_str());
@@ -2140,6 +2577,7 @@ bool LoadModelFile_glTF_OvrScene(
     // Since we are doing a zip file, we are going to parse through the zip file many times to find
     // the different data points.
     const char* gltfJson = nullptr;
+    size_t gltfJsonLength = 0;
     {
         // LOGCPUTIME( "Loading GLTF file" );
         for (int ret = unzGoToFirstFile(zfp); ret == UNZ_OK; ret = unzGoToNextFile(zfp)) {
@@ -2164,6 +2602,7 @@ bool LoadModelFile_glTF_OvrScene(
 
                 if (gltfJson == nullptr) {
                     gltfJson = (const char*)buffer;
+                    gltfJsonLength = finfo.uncompressed_size;
                 } else {
                     ALOGW("LoadModelFile_glTF_OvrScene: multiple .gltf files found %s", fileName);
                     delete[] buffer;
@@ -2176,7 +2615,8 @@ bool LoadModelFile_glTF_OvrScene(
     bool loaded = true;
 
     const char* error = nullptr;
-    auto json = OVR::JSON::Parse(gltfJson, &error);
+    glTFStreamedArrays streamed;
+    auto json = ParseglTFJson(gltfJson, gltfJsonLength, modelFile, streamed, &error);
     if (json == nullptr) {
         ALOGW(
             "LoadModelFile_glTF_OvrScene: Error loading %s : %s",
@@ -2184,7 +2624,8 @@ bool LoadModelFile_glTF_OvrScene(
             error);
         loaded = false;
     } else {
-        const OVR::JsonReader models(json);
+        loaded = streamed.loaded;
+        const JsonReader models(json->GetRoot());
         if (models.IsObject()) {
             // Buffers BufferViews and Images need access to the data location, in this case the zip
             // file.
@@ -2193,115 +2634,86 @@ bool LoadModelFile_glTF_OvrScene(
             if (loaded) { // BUFFERS
                 // LOGCPUTIME( "Loading buffers" );
                 // gather all the buffers, and try to load them from the zip file.
-                const OVR::JsonReader buffers(models.GetChildByName("buffers"));
-                if (buffers.IsArray()) {
-                    while (!buffers.IsEndOfArray() && loaded) {
-                        const OVR::JsonReader bufferReader(buffers.GetNextArrayElement());
-                        if (bufferReader.IsObject()) {
-                            ModelBuffer newGltfBuffer;
-
-                            const std::string name = bufferReader.GetChildStringByName("name");
-                            const std::string uri = bufferReader.GetChildStringByName("uri");
-                            newGltfBuffer.byteLength =
-                                bufferReader.GetChildInt32ByName("byteLength", -1);
-
-                            // #TODO: proper uri reading.  right now, assuming its a file name.
-                            if (OVR::OVR_stricmp(uri.c_str() + (uri.length() - 4), ".bin") != 0) {
-                                // #TODO: support loading buffers from data other then a bin file.
-                                // i.e. inline buffers etc.
-                                ALOGW("Loading buffers other then bin files currently unsupported");
-                                loaded = false;
-                            }
-                            int bufferLength = 0;
-                            uint8_t* tempbuffer = ReadFileBufferFromZipFile(
-                                zfp, uri.c_str(), bufferLength, (const uint8_t*)fileData);
-                            if (tempbuffer == nullptr) {
-                                ALOGW("could not load buffer for gltfBuffer");
-                                loaded = false;
-                            } else {
-                                // ensure the buffer is aligned.
-                                size_t alignedBufferSize = (bufferLength / 4 + 1) * 4;
-                                newGltfBuffer.bufferData.resize(alignedBufferSize);
-                                memcpy(newGltfBuffer.bufferData.data(), tempbuffer, bufferLength);
-                            }
+                for (const glTFStreamedArrays::Buffer& buffer : streamed.buffers) {
+                    if (!loaded) {
+                        break;
+                    }
+                    ModelBuffer newGltfBuffer;
 
-                            if (newGltfBuffer.byteLength > (size_t)bufferLength) {
-                                ALOGW(
-                                    "%d byteLength > bufferLength loading gltfBuffer %d",
-                                    (int)newGltfBuffer.byteLength,
-                                    bufferLength);
-                                loaded = false;
-                            }
+                    const std::string& name = buffer.name;
+                    const std::string& uri = buffer.uri;
+                    newGltfBuffer.byteLength = buffer.byteLength;
 
-                            const char* bufferName;
-                            if (!name.empty()) {
-                                bufferName = name.c_str();
-                            } else {
-                                bufferName = uri.c_str();
-                            }
+                    // #TODO: proper uri reading.  right now, assuming its a file name.
+                    if (OVR::OVR_stricmp(uri.c_str() + (uri.length() - 4), ".bin") != 0) {
+                        // #TODO: support loading buffers from data other then a bin file.
+                        // i.e. inline buffers etc.
+                        ALOGW("Loading buffers other then bin files currently unsupported");
+                        loaded = false;
+                    }
+                    int bufferLength = 0;
+                    uint8_t* tempbuffer = ReadFileBufferFromZipFile(
+                        zfp, uri.c_str(), bufferLength, (const uint8_t*)fileData);
+                    if (tempbuffer == nullptr) {
+                        ALOGW("could not load buffer for gltfBuffer");
+                        loaded = false;
+                    } else {
+                        // ensure the buffer is aligned.
+                        size_t alignedBufferSize = (bufferLength / 4 + 1) * 4;
+                        newGltfBuffer.bufferData.resize(alignedBufferSize);
+                        memcpy(newGltfBuffer.bufferData.data(), tempbuffer, bufferLength);
+                        if (!IsInFileData(tempbuffer, fileData, fileDataLength)) {
+                            delete[] tempbuffer;
+                        }
+                    }
 
-                            newGltfBuffer.name = bufferName;
+                    if (newGltfBuffer.byteLength > (size_t)bufferLength) {
+                        ALOGW(
+                            "%d byteLength > bufferLength loading gltfBuffer %d",
+                            (int)newGltfBuffer.byteLength,
+                            bufferLength);
+                        loaded = false;
+                    }
 
-                            modelFile.Buffers.push_back(newGltfBuffer);
-                        }
+                    const char* bufferName;
+                    if (!name.empty()) {
+                        bufferName = name.c_str();
+                    } else {
+                        bufferName = uri.c_str();
                     }
+
+                    newGltfBuffer.name = bufferName;
+
+                    modelFile.Buffers.push_back(newGltfBuffer);
                 }
             } // END BUFFERS
 
             if (loaded) { // BUFFERVIEW
-                LOGV("Loading bufferviews");
-                const OVR::JsonReader bufferViews(models.GetChildByName("bufferViews"));
-                if (bufferViews.IsArray()) {
-                    while (!bufferViews.IsEndOfArray() && loaded) {
-                        const OVR::JsonReader bufferview(bufferViews.GetNextArrayElement());
-                        if (bufferview.IsObject()) {
-                            ModelBufferView newBufferView;
-
-                            newBufferView.name = bufferview.GetChildStringByName("name");
-                            const int buffer = bufferview.GetChildInt32ByName("buffer");
-                            newBufferView.byteOffset = bufferview.GetChildInt32ByName("byteOffset");
-                            newBufferView.byteLength = bufferview.GetChildInt32ByName("byteLength");
-                            newBufferView.byteStride = bufferview.GetChildInt32ByName("byteStride");
-                            newBufferView.target = bufferview.GetChildInt32ByName("target");
-
-                            if (buffer < 0 || buffer >= (const int)modelFile.Buffers.size()) {
-                                ALOGW("Error: Invalid buffer Index in gltfBufferView");
-                                loaded = false;
-                            }
-                            if (newBufferView.byteStride < 0 || newBufferView.byteStride > 255) {
-                                ALOGW("Error: Invalid byeStride in gltfBufferView");
-                                loaded = false;
-                            }
-                            if (newBufferView.target < 0) {
-                                ALOGW("Error: Invalid target in gltfBufferView");
-                                loaded = false;
-                            }
-
-                            newBufferView.buffer = &modelFile.Buffers[buffer];
-                            modelFile.BufferViews.push_back(newBufferView);
-                        }
-                    }
-                }
+                LOGV("Resolving bufferviews");
+                loaded = ResolveBufferViews(modelFile, streamed);
             } // END BUFFERVIEWS
 
             if (loaded) { // IMAGES
                 // LOGCPUTIME( "Loading image textures" );
                 // gather all the images, and try to load them from the zip file.
-                const OVR::JsonReader images(models.GetChildByName("images"));
+                // The files are read here because the zip file can only be read from one
+                // thread, and decoded in parallel by LoadModelFileTextures.
+                std::vector<ModelTextureFile> textureFiles;
+                const JsonReader images(models.GetChildByName("images"));
                 if (images.IsArray()) {
                     while (!images.IsEndOfArray()) {
-                        const OVR::JsonReader image(images.GetNextArrayElement());
+                        const JsonReader image(images.GetNextArrayElement());
                         if (image.IsObject()) {
                             const std::string name = image.GetChildStringByName("name");
                             const std::string uri = image.GetChildStringByName("uri");
                             int bufferView = image.GetChildInt32ByName("bufferView", -1);
+                            ModelTextureFile textureFile;
                             if (bufferView >= 0) {
                                 // #TODO: support bufferView index for image files.
                                 ALOGW(
                                     "Loading images from bufferView currently unsupported, defaulting image");
                                 // Create a default texture.
-                                LoadModelFileTexture(
-                                    modelFile, "DefaultImage", nullptr, 0, materialParms);
+                                textureFile.name = "DefaultImage";
                             } else {
                                 // check to make sure the image is ktx.
                                 if (OVR::OVR_stricmp(uri.c_str() + (uri.length() - 4), ".ktx") !=
@@ -2311,35 +2723,24 @@ bool LoadModelFile_glTF_OvrScene(
                                     ALOGW(
                                         "Loading images other then ktx is not advised. %s",
                                         uri.c_str());
+                                }
 
-                                    int bufferLength = 0;
-                                    uint8_t* buffer = ReadFileBufferFromZipFile(
-                                        zfp, uri.c_str(), bufferLength, (const uint8_t*)fileData);
-                                    const char* imageName = uri.c_str();
-
-                                    LoadModelFileTexture(
-                                        modelFile,
-                                        imageName,
-                                        (const char*)buffer,
-                                        bufferLength,
-                                        materialParms);
-                                } else {
-                                    int bufferLength = 0;
-                                    uint8_t* buffer = ReadFileBufferFromZipFile(
-                                        zfp, uri.c_str(), bufferLength, (const uint8_t*)fileData);
-                                    const char* imageName = uri.c_str();
-
-                                    LoadModelFileTexture(
-                                        modelFile,
-                                        imageName,
-                                        (const char*)buffer,
-                                        bufferLength,
-                                        materialParms);
+                                int bufferLength = 0;
+                                uint8_t* buffer = ReadFileBufferFromZipFile(
+                                    zfp, uri.c_str(), bufferLength, (const uint8_t*)fileData);
+                                textureFile.name = uri;
+                                if (buffer != nullptr) {
+                                    textureFile.data = buffer;
+                                    textureFile.size = bufferLength;
+                                    textureFile.owner =
+                                        OwnZipFileBuffer(buffer, fileData, fileDataLength);
                                 }
                             }
+                            textureFiles.push_back(std::move(textureFile));
                         }
                     }
                 }
+                LoadModelFileTextures(modelFile, textureFiles, materialParms);
             } // END images
             // End of section dependent on zip file.
         } else {
@@ -2348,13 +2749,13 @@ bool LoadModelFile_glTF_OvrScene(
         }
 
         if (loaded) {
-            loaded =
-                LoadModelFile_glTF_Json(modelFile, gltfJson, programs, materialParms, outModelGeo);
+            loaded = LoadModelFile_glTF_Json(
+                modelFile, *json, streamed, programs, materialParms, outModelGeo);
         }
     }
 
     if (gltfJson != nullptr && (gltfJson < fileData || gltfJson > fileData + fileDataLength)) {
-        delete gltfJson;
+        delete[] gltfJson;
     }
 
     return loaded;
@@ -2366,7 +2767,8 @@ ModelFile* LoadModelFile_glB(
     const int fileDataLength,
     const ModelGlPrograms& programs,
     const MaterialParms& materialParms,
-    ModelGeo* outModelGeo) {
+    ModelGeo* outModelGeo,
+    const std::shared_ptr<const void>& fileDataOwner) {
     // LOGCPUTIME( "LoadModelFile_glB" );
 
     ModelFile* modelFilePtr = new ModelFile;
@@ -2422,12 +2824,17 @@ ModelFile* LoadModelFile_glB(
             loaded = false;
         }
 
-        std::shared_ptr<OVR::JSON> json = nullptr;
-        const char* gltfJson = nullptr;
+        if (chunkLength > fileDataRemainingLength) {
+            ALOGW("Error: glb JSON chunk length greater then remaining buffer");
+            loaded = false;
+        }
+
+        glTFStreamedArrays streamed;
+        std::shared_ptr<OVR::JsonDocument> json = nullptr;
         if (loaded) {
             const char* error = nullptr;
-            gltfJson = &fileData[fileDataIndex];
-            json = OVR::JSON::Parse(gltfJson, &error);
+            json = ParseglTFJson(
+                &fileData[fileDataIndex], chunkLength, modelFile, streamed, &error);
             fileDataIndex += chunkLength;
             fileDataRemainingLength -= chunkLength;
 
@@ -2437,6 +2844,8 @@ ModelFile* LoadModelFile_glB(
                     modelFilePtr->FileName.c_str(),
                     error);
                 loaded = false;
+            } else {
+                loaded = streamed.loaded;
             }
         }
 
@@ -2471,7 +2880,7 @@ ModelFile* LoadModelFile_glB(
         }
 
         if (loaded) {
-            const OVR::JsonReader models(json);
+            const JsonReader models(json->GetRoot());
             if (models.IsObject()) {
                 // Buffers BufferViews and Images need access to the data location, in this case the
                 // buffer inside the glb file.
@@ -2480,109 +2889,78 @@ ModelFile* LoadModelFile_glB(
                 if (loaded) { // BUFFERS
                     LOGV("Loading buffers");
                     // gather all the buffers, and try to load them from the zip file.
-                    const OVR::JsonReader buffers(models.GetChildByName("buffers"));
-                    if (buffers.IsArray()) {
-                        while (!buffers.IsEndOfArray() && loaded) {
-                            if (static_cast<int>(modelFile.Buffers.size()) > 0) {
-                                ALOGW("Error: glB file contains more then one buffer");
-                                loaded = false;
-                            }
-
-                            const OVR::JsonReader bufferReader(buffers.GetNextArrayElement());
-                            if (bufferReader.IsObject() && loaded) {
-                                ModelBuffer newGltfBuffer;
+                    for (const glTFStreamedArrays::Buffer& streamedBuffer : streamed.buffers) {
+                        if (!loaded) {
+                            break;
+                        }
+                        if (static_cast<int>(modelFile.Buffers.size()) > 0) {
+                            ALOGW("Error: glB file contains more then one buffer");
+                            loaded = false;
+                            break;
+                        }
 
-                                const std::string name = bufferReader.GetChildStringByName("name");
-                                const std::string uri = bufferReader.GetChildStringByName("uri");
-                                newGltfBuffer.byteLength =
-                                    bufferReader.GetChildInt32ByName("byteLength", -1);
+                        ModelBuffer newGltfBuffer;
 
-                                //  #TODO: proper uri reading.  right now, assuming its a file name.
-                                if (!uri.empty()) {
-                                    ALOGW(
-                                        "Loading buffers with an uri currently unsupported in glb");
-                                    loaded = false;
-                                }
+                        const std::string& name = streamedBuffer.name;
+                        const std::string& uri = streamedBuffer.uri;
+                        newGltfBuffer.byteLength = streamedBuffer.byteLength;
 
-                                if (newGltfBuffer.byteLength > (size_t)bufferLength) {
-                                    ALOGW(
-                                        "%d byteLength > bufferLength loading gltfBuffer %d",
-                                        (int)newGltfBuffer.byteLength,
-                                        bufferLength);
-                                    loaded = false;
-                                }
+                        //  #TODO: proper uri reading.  right now, assuming its a file name.
+                        if (!uri.empty()) {
+                            ALOGW("Loading buffers with an uri currently unsupported in glb");
+                            loaded = false;
+                        }
 
-                                // ensure the buffer is aligned.
-                                size_t alignedBufferSize = (bufferLength / 4 + 1) * 4;
-                                newGltfBuffer.bufferData.resize(alignedBufferSize);
-                                memcpy(
-                                    newGltfBuffer.bufferData.data(),
-                                    buffer,
-                                    newGltfBuffer.byteLength);
-
-                                const char* bufferName;
-                                if (!name.empty()) {
-                                    bufferName = name.c_str();
-                                } else {
-                                    bufferName = "glB_Buffer";
-                                }
+                        if (newGltfBuffer.byteLength > (size_t)bufferLength) {
+                            ALOGW(
+                                "%d byteLength > bufferLength loading gltfBuffer %d",
+                                (int)newGltfBuffer.byteLength,
+                                bufferLength);
+                            loaded = false;
+                        }
 
-                                newGltfBuffer.name = bufferName;
+                        if (fileDataOwner != nullptr && ((uintptr_t)buffer & 3) == 0) {
+                            // reference the binary chunk in place.
+                            newGltfBuffer.externalData = (const uint8_t*)buffer;
+                            newGltfBuffer.externalDataOwner = fileDataOwner;
+                        } else {
+                            // ensure the buffer is aligned.
+                            size_t alignedBufferSize = (bufferLength / 4 + 1) * 4;
+                            newGltfBuffer.bufferData.resize(alignedBufferSize);
+                            memcpy(
+                                newGltfBuffer.bufferData.data(),
+                                buffer,
+                                newGltfBuffer.byteLength);
+                        }
 
-                                modelFile.Buffers.push_back(newGltfBuffer);
-                            }
+                        const char* bufferName;
+                        if (!name.empty()) {
+                            bufferName = name.c_str();
+                        } else {
+                            bufferName = "glB_Buffer";
                         }
+
+                        newGltfBuffer.name = bufferName;
+
+                        modelFile.Buffers.push_back(newGltfBuffer);
                     }
                 } // END BUFFERS
 
                 if (loaded) { // BUFFERVIEW
-                    LOGV("Loading bufferviews");
-                    const OVR::JsonReader bufferViews(models.GetChildByName("bufferViews"));
-                    if (bufferViews.IsArray()) {
-                        while (!bufferViews.IsEndOfArray() && loaded) {
-                            const OVR::JsonReader bufferview(bufferViews.GetNextArrayElement());
-                            if (bufferview.IsObject()) {
-                                ModelBufferView newBufferView;
-
-                                newBufferView.name = bufferview.GetChildStringByName("name");
-                                const int bufferIndex = bufferview.GetChildInt32ByName("buffer");
-                                newBufferView.byteOffset =
-                                    bufferview.GetChildInt32ByName("byteOffset");
-                                newBufferView.byteLength =
-                                    bufferview.GetChildInt32ByName("byteLength");
-                                newBufferView.byteStride =
-                                    bufferview.GetChildInt32ByName("byteStride");
-                                newBufferView.target = bufferview.GetChildInt32ByName("target");
-
-                                if (bufferIndex < 0 ||
-                                    bufferIndex >= (const int)modelFile.Buffers.size()) {
-                                    ALOGW("Error: Invalid buffer Index in gltfBufferView");
-                                    loaded = false;
-                                }
-                                if (newBufferView.byteStride < 0 ||
-                                    newBufferView.byteStride > 255) {
-                                    ALOGW("Error: Invalid byeStride in gltfBufferView");
-                                    loaded = false;
-                                }
-                                if (newBufferView.target < 0) {
-                                    ALOGW("Error: Invalid target in gltfBufferView");
-                                    loaded = false;
-                                }
-
-                                newBufferView.buffer = &modelFile.Buffers[bufferIndex];
-                                modelFile.BufferViews.push_back(newBufferView);
-                            }
-                        }
-                    }
+                    LOGV("Resolving bufferviews");
+                    loaded = ResolveBufferViews(modelFile, streamed);
                 } // END BUFFERVIEWS
 
                 if (loaded) { // IMAGES
                     LOGV("Loading image textures");
                     // gather all the images, and try to load them from the zip file.
-                    const OVR::JsonReader images(models.GetChildByName("images"));
+                    // Decoded in parallel by LoadModelFileTextures, textures from a custom
+                    // handler are created in between in the same order as the images.
+                    std::vector<ModelTextureFile> textureFiles;
+                    const JsonReader images(models.GetChildByName("images"));
                     if (images.IsArray()) {
                         while (!images.IsEndOfArray()) {
-                            const OVR::JsonReader image(images.GetNextArrayElement());
+                            const JsonReader image(images.GetNextArrayElement());
                             if (image.IsObject()) {
                                 const std::string name = image.GetChildStringByName("name");
                                 const std::string uri = image.GetChildStringByName("uri");
@@ -2597,10 +2975,7 @@ ModelFile* LoadModelFile_glB(
                                     bufferView < static_cast<int>(modelFile.BufferViews.size())) {
                                     ModelBufferView* pBufferView =
                                         &modelFile.BufferViews[bufferView];
-                                    int imageBufferLength = (int)pBufferView->byteLength;
-                                    uint8_t* imageBuffer =
-                                        (uint8_t*)pBufferView->buffer->bufferData.data() +
-                                        pBufferView->byteOffset;
+                                    const ModelBuffer* imageBuffer = pBufferView->buffer;
 
                                     std::string path = name;
                                     const char* ext = strrchr(mimeType.c_str(), '/');
@@ -2609,26 +2984,36 @@ ModelFile* LoadModelFile_glB(
                                         path += ext + 1;
                                     }
 
-                                    LoadModelFileTexture(
-                                        modelFile,
-                                        path.c_str(),
-                                        (const char*)imageBuffer,
-                                        imageBufferLength,
-                                        materialParms);
-                                } else if (
-                                    materialParms.ImageUriHandler &&
-                                    materialParms.ImageUriHandler(modelFile, uri)) {
-                                    LOGV("LoadModelFile_glB: uri processed by custom handler");
+                                    // decoded in place, the model buffers outlive the load
+                                    ModelTextureFile textureFile;
+                                    textureFile.name = path;
+                                    textureFile.data =
+                                        imageBuffer->GetData() + pBufferView->byteOffset;
+                                    textureFile.size = pBufferView->byteLength;
+                                    textureFile.owner = imageBuffer->externalDataOwner;
+                                    textureFiles.push_back(std::move(textureFile));
+                                } else if (materialParms.ImageUriHandler) {
+                                    LoadModelFileTextures(modelFile, textureFiles, materialParms);
+                                    if (materialParms.ImageUriHandler(modelFile, uri)) {
+                                        LOGV("LoadModelFile_glB: uri processed by custom handler");
+                                    } else {
+                                        ALOGW(
+                                            "Loading images from othen then bufferView currently unsupported in glBfd, defaulting image");
+                                        LoadModelFileTexture(
+                                            modelFile, "DefaultImage", nullptr, 0, materialParms);
+                                    }
                                 } else {
                                     ALOGW(
                                         "Loading images from othen then bufferView currently unsupported in glBfd, defaulting image");
                                     // Create a default texture.
-                                    LoadModelFileTexture(
-                                        modelFile, "DefaultImage", nullptr, 0, materialParms);
+                                    ModelTextureFile textureFile;
+                                    textureFile.name = "DefaultImage";
+                                    textureFiles.push_back(std::move(textureFile));
                                 }
                             }
                         }
                     }
+                    LoadModelFileTextures(modelFile, textureFiles, materialParms);
                 } // END images
 
                 // End of section dependent on buffer data in the glB file.
@@ -2636,8 +3021,8 @@ ModelFile* LoadModelFile_glB(
         }
 
         if (loaded) {
-            loaded =
-                LoadModelFile_glTF_Json(modelFile, gltfJson, programs, materialParms, outModelGeo);
+            loaded = LoadModelFile_glTF_Json(
+                modelFile, *json, streamed, programs, materialParms, outModelGeo);
         }
     }
 
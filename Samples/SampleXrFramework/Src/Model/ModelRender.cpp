@@ -28,9 +28,19 @@ Authors     :   John Carmack
 #include "ModelRender.h"
 
 #include <stdlib.h>
+#include <string.h>
 #include <algorithm>
 
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define CULL_NEON
+#elif defined(OVR_CPU_X86_64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define CULL_SSE2
+#endif
+
 #include "Misc/Log.h"
+#include "System.h"
 
 using OVR::Bounds3f;
 using OVR::Matrix4f;
@@ -40,169 +50,440 @@ using OVR::Vector4f;
 
 namespace OVRFW {
 
-// Returns 0 if the bounds is culled by the mvp, otherwise returns the max W
-// value of the bounds corners so it can be sorted into roughly front to back
-// order for more efficient Z cull.  Sorting bounds in increasing order of
-// their farthest W value usually makes characters and objects draw before
-// the environments they are in, and draws sky boxes last, which is what we want.
-static float BoundsSortCullKey(const Bounds3f& bounds, const Matrix4f& mvp) {
-    // Always cull empty bounds, which can be used to disable a surface.
-    // Don't just check a single axis, or billboards would be culled.
-    if (bounds.b[1].x == bounds.b[0].x && bounds.b[1].y == bounds.b[0].y) {
-        return 0;
-    }
+// Surfaces are culled and keyed four at a time, with the bounds and matrices transposed so each
+// lane of a cull4_t holds one surface.
+#if defined(CULL_NEON)
+typedef float32x4_t cull4_t;
 
-    // Not very efficient code...
-    Vector4f c[8];
-    for (int i = 0; i < 8; i++) {
-        Vector4f world;
-        world.x = bounds.b[(i & 1)].x;
-        world.y = bounds.b[(i & 2) >> 1].y;
-        world.z = bounds.b[(i & 4) >> 2].z;
-        world.w = 1.0f;
+static inline cull4_t Load4(const float* p) {
+    return vld1q_f32(p);
+}
 
-        c[i] = mvp.Transform(world);
-    }
+static inline void Store4(float* p, const cull4_t a) {
+    vst1q_f32(p, a);
+}
 
-    int i;
-    for (i = 0; i < 8; i++) {
-        if (c[i].x > -c[i].w) {
-            break;
-        }
-    }
-    if (i == 8) {
-        return 0; // all off one side
-    }
-    for (i = 0; i < 8; i++) {
-        if (c[i].x < c[i].w) {
-            break;
-        }
-    }
-    if (i == 8) {
-        return 0; // all off one side
+static inline cull4_t Splat4(const float f) {
+    return vdupq_n_f32(f);
+}
+
+static inline cull4_t Add4(const cull4_t a, const cull4_t b) {
+    return vaddq_f32(a, b);
+}
+
+static inline cull4_t Sub4(const cull4_t a, const cull4_t b) {
+    return vsubq_f32(a, b);
+}
+
+static inline cull4_t Mul4(const cull4_t a, const cull4_t b) {
+    return vmulq_f32(a, b);
+}
+
+static inline cull4_t Abs4(const cull4_t a) {
+    return vabsq_f32(a);
+}
+
+static inline cull4_t Max4(const cull4_t a, const cull4_t b) {
+    return vmaxq_f32(a, b);
+}
+
+// All bits set in the lanes where a > b.
+static inline cull4_t Greater4(const cull4_t a, const cull4_t b) {
+    return vreinterpretq_f32_u32(vcgtq_f32(a, b));
+}
+
+static inline cull4_t And4(const cull4_t a, const cull4_t b) {
+    return vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(a), vreinterpretq_u32_f32(b)));
+}
+
+static inline cull4_t Or4(const cull4_t a, const cull4_t b) {
+    return vreinterpretq_f32_u32(vorrq_u32(vreinterpretq_u32_f32(a), vreinterpretq_u32_f32(b)));
+}
+
+static inline void Transpose4(cull4_t& a, cull4_t& b, cull4_t& c, cull4_t& d) {
+    const float32x4x2_t ab = vtrnq_f32(a, b);
+    const float32x4x2_t cd = vtrnq_f32(c, d);
+    a = vcombine_f32(vget_low_f32(ab.val[0]), vget_low_f32(cd.val[0]));
+    b = vcombine_f32(vget_low_f32(ab.val[1]), vget_low_f32(cd.val[1]));
+    c = vcombine_f32(vget_high_f32(ab.val[0]), vget_high_f32(cd.val[0]));
+    d = vcombine_f32(vget_high_f32(ab.val[1]), vget_high_f32(cd.val[1]));
+}
+#elif defined(CULL_SSE2)
+typedef __m128 cull4_t;
+
+static inline cull4_t Load4(const float* p) {
+    return _mm_loadu_ps(p);
+}
+
+static inline void Store4(float* p, const cull4_t a) {
+    _mm_storeu_ps(p, a);
+}
+
+static inline cull4_t Splat4(const float f) {
+    return _mm_set1_ps(f);
+}
+
+static inline cull4_t Add4(const cull4_t a, const cull4_t b) {
+    return _mm_add_ps(a, b);
+}
+
+static inline cull4_t Sub4(const cull4_t a, const cull4_t b) {
+    return _mm_sub_ps(a, b);
+}
+
+static inline cull4_t Mul4(const cull4_t a, const cull4_t b) {
+    return _mm_mul_ps(a, b);
+}
+
+static inline cull4_t Abs4(const cull4_t a) {
+    return _mm_and_ps(a, _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF)));
+}
+
+static inline cull4_t Max4(const cull4_t a, const cull4_t b) {
+    return _mm_max_ps(a, b);
+}
+
+// All bits set in the lanes where a > b.
+static inline cull4_t Greater4(const cull4_t a, const cull4_t b) {
+    return _mm_cmpgt_ps(a, b);
+}
+
+static inline cull4_t And4(const cull4_t a, const cull4_t b) {
+    return _mm_and_ps(a, b);
+}
+
+static inline cull4_t Or4(const cull4_t a, const cull4_t b) {
+    return _mm_or_ps(a, b);
+}
+
+static inline void Transpose4(cull4_t& a, cull4_t& b, cull4_t& c, cull4_t& d) {
+    _MM_TRANSPOSE4_PS(a, b, c, d);
+}
+#else
+struct cull4_t {
+    uint32_t v[4];
+};
+
+static inline float Lane(const cull4_t& a, const int i) {
+    float f;
+    memcpy(&f, &a.v[i], sizeof(f));
+    return f;
+}
+
+static inline void SetLane(cull4_t& a, const int i, const float f) {
+    memcpy(&a.v[i], &f, sizeof(f));
+}
+
+static inline cull4_t Load4(const float* p) {
+    cull4_t r;
+    memcpy(r.v, p, sizeof(r.v));
+    return r;
+}
+
+static inline void Store4(float* p, const cull4_t a) {
+    memcpy(p, a.v, sizeof(a.v));
+}
+
+static inline cull4_t Splat4(const float f) {
+    cull4_t r;
+    for (int i = 0; i < 4; i++) {
+        SetLane(r, i, f);
     }
+    return r;
+}
 
-    for (i = 0; i < 8; i++) {
-        if (c[i].y > -c[i].w) {
-            break;
-        }
+static inline cull4_t Add4(const cull4_t a, const cull4_t b) {
+    cull4_t r;
+    for (int i = 0; i < 4; i++) {
+        SetLane(r, i, Lane(a, i) + Lane(b, i));
     }
-    if (i == 8) {
-        return 0; // all off one side
+    return r;
+}
+
+static inline cull4_t Sub4(const cull4_t a, const cull4_t b) {
+    cull4_t r;
+    for (int i = 0; i < 4; i++) {
+        SetLane(r, i, Lane(a, i) - Lane(b, i));
     }
-    for (i = 0; i < 8; i++) {
-        if (c[i].y < c[i].w) {
-            break;
-        }
+    return r;
+}
+
+static inline cull4_t Mul4(const cull4_t a, const cull4_t b) {
+    cull4_t r;
+    for (int i = 0; i < 4; i++) {
+        SetLane(r, i, Lane(a, i) * Lane(b, i));
     }
-    if (i == 8) {
-        return 0; // all off one side
+    return r;
+}
+
+static inline cull4_t Abs4(const cull4_t a) {
+    cull4_t r;
+    for (int i = 0; i < 4; i++) {
+        r.v[i] = a.v[i] & 0x7FFFFFFF;
     }
+    return r;
+}
 
-    for (i = 0; i < 8; i++) {
-        if (c[i].z > -c[i].w) {
-            break;
-        }
+static inline cull4_t Max4(const cull4_t a, const cull4_t b) {
+    cull4_t r;
+    for (int i = 0; i < 4; i++) {
+        SetLane(r, i, std::max(Lane(a, i), Lane(b, i)));
     }
-    if (i == 8) {
-        return 0; // all off one side
+    return r;
+}
+
+// All bits set in the lanes where a > b.
+static inline cull4_t Greater4(const cull4_t a, const cull4_t b) {
+    cull4_t r;
+    for (int i = 0; i < 4; i++) {
+        r.v[i] = (Lane(a, i) > Lane(b, i)) ? 0xFFFFFFFF : 0;
     }
-    for (i = 0; i < 8; i++) {
-        if (c[i].z < c[i].w) {
-            break;
-        }
+    return r;
+}
+
+static inline cull4_t And4(const cull4_t a, const cull4_t b) {
+    cull4_t r;
+    for (int i = 0; i < 4; i++) {
+        r.v[i] = a.v[i] & b.v[i];
     }
-    if (i == 8) {
-        return 0; // all off one side
+    return r;
+}
+
+static inline cull4_t Or4(const cull4_t a, const cull4_t b) {
+    cull4_t r;
+    for (int i = 0; i < 4; i++) {
+        r.v[i] = a.v[i] | b.v[i];
     }
+    return r;
+}
 
-    // calculate the farthest W point for front to back sorting
-    float maxW = 0;
-    for (i = 0; i < 8; i++) {
-        const float w = c[i].w;
-        if (w > maxW) {
-            maxW = w;
+static inline void Transpose4(cull4_t& a, cull4_t& b, cull4_t& c, cull4_t& d) {
+    cull4_t* rows[4] = {&a, &b, &c, &d};
+    for (int i = 0; i < 4; i++) {
+        for (int j = i + 1; j < 4; j++) {
+            std::swap(rows[i]->v[j], rows[j]->v[i]);
         }
     }
-
-    return maxW; // couldn't cull
 }
+#endif
+
+// Lists of at least PARALLEL_CULL_COUNT surfaces are culled in chunks of CULL_CHUNK_SIZE on the
+// worker threads. Shorter lists take less time to cull than waking the workers.
+static const int PARALLEL_CULL_COUNT = 4096;
+static const int CULL_CHUNK_SIZE = 256;
 
 struct bsort_t {
     float key;
-    Matrix4f modelMatrix;
-    const std::vector<Matrix4f>* joints;
+    Bounds3f bounds;
+    const Matrix4f* modelMatrix;
     const ovrSurfaceDef* surface;
     bool transparent;
+    bool allowCulling;
+};
 
-    bool operator<(const bsort_t& b2) const {
-        const bsort_t& b1 = *this;
-        bool trans1 = b1.transparent;
-        bool trans2 = b2.transparent;
-        if (trans1 == trans2) {
-            float f1 = b1.key;
-            float f2 = b2.key;
-            if (!trans1) {
-                // both are solid, sort front-to-back
-                return (f1 < f2);
-            } else {
-                // both are transparent, sort back-to-front
-                return (f2 < f1);
+// Sets the key of each surface to 0 if its bounds are culled by the mvp, otherwise to the max W
+// value of the bounds corners so it can be sorted into roughly front to back order for more
+// efficient Z cull. Sorting bounds in increasing order of their farthest W value usually makes
+// characters and objects draw before the environments they are in, and draws sky boxes last,
+// which is what we want.
+//
+// Instead of transforming all 8 corners, each clip plane is tested in object space against the
+// bounds center and extents. All corners are outside a plane exactly when the corner closest to
+// the inside, center + extents * sign( normal ), is outside, and the farthest W is found the same
+// way.
+static void BoundsSortCullKeys(bsort_t* surfaces, const int count, const Matrix4f& vpMatrix) {
+    cull4_t vp[16];
+    for (int j = 0; j < 16; j++) {
+        vp[j] = Splat4(vpMatrix.M[j >> 2][j & 3]);
+    }
+    const cull4_t zero = Splat4(0.0f);
+    const cull4_t half = Splat4(0.5f);
+
+    for (int first = 0; first < count; first += 4) {
+        const int blockSize = std::min(4, count - first);
+
+        // model[r * 4 + i] gets row r of surface i, which the transposes turn into element (r, c)
+        // of the four surfaces in model[r * 4 + c]. Missing surfaces of the last block repeat
+        // the last surface.
+        cull4_t model[16];
+        cull4_t lo[4];
+        cull4_t hi[4];
+        for (int i = 0; i < 4; i++) {
+            const bsort_t& s = surfaces[first + std::min(i, blockSize - 1)];
+            for (int r = 0; r < 4; r++) {
+                model[r * 4 + i] = Load4(s.modelMatrix->M[r]);
+            }
+            // b[0].x b[0].y b[0].z b[1].x and b[0].z b[1].x b[1].y b[1].z
+            lo[i] = Load4(&s.bounds.b[0].x);
+            hi[i] = Load4(&s.bounds.b[0].z);
+        }
+        for (int r = 0; r < 4; r++) {
+            Transpose4(model[r * 4 + 0], model[r * 4 + 1], model[r * 4 + 2], model[r * 4 + 3]);
+        }
+        Transpose4(lo[0], lo[1], lo[2], lo[3]);
+        Transpose4(hi[0], hi[1], hi[2], hi[3]);
+
+        const cull4_t centerX = Mul4(Add4(lo[0], hi[1]), half);
+        const cull4_t centerY = Mul4(Add4(lo[1], hi[2]), half);
+        const cull4_t centerZ = Mul4(Add4(lo[2], hi[3]), half);
+        const cull4_t extentX = Mul4(Sub4(hi[1], lo[0]), half);
+        const cull4_t extentY = Mul4(Sub4(hi[2], lo[1]), half);
+        const cull4_t extentZ = Mul4(Sub4(hi[3], lo[2]), half);
+
+        cull4_t m[16];
+        for (int r = 0; r < 4; r++) {
+            for (int c = 0; c < 4; c++) {
+                m[r * 4 + c] = Add4(
+                    Add4(Mul4(vp[r * 4 + 0], model[0 + c]), Mul4(vp[r * 4 + 1], model[4 + c])),
+                    Add4(Mul4(vp[r * 4 + 2], model[8 + c]), Mul4(vp[r * 4 + 3], model[12 + c])));
+            }
+        }
+
+        // Always cull empty bounds, which can be used to disable a surface.
+        // Don't just check a single axis, or billboards would be culled.
+        cull4_t visible = Or4(Greater4(Abs4(extentX), zero), Greater4(Abs4(extentY), zero));
+
+        // The clip planes are w + x, w - x, w + y, w - y, w + z and w - z.
+        for (int plane = 0; plane < 6; plane++) {
+            const int row = (plane >> 1) * 4;
+            cull4_t n[4];
+            for (int c = 0; c < 4; c++) {
+                n[c] = (plane & 1) ? Sub4(m[12 + c], m[row + c]) : Add4(m[12 + c], m[row + c]);
             }
+            const cull4_t distance = Add4(
+                Add4(Mul4(n[0], centerX), Mul4(n[1], centerY)), Add4(Mul4(n[2], centerZ), n[3]));
+            const cull4_t radius = Add4(
+                Add4(Mul4(Abs4(n[0]), extentX), Mul4(Abs4(n[1]), extentY)),
+                Mul4(Abs4(n[2]), extentZ));
+            visible = And4(visible, Greater4(Add4(distance, radius), zero));
         }
-        // otherwise, one is solid and one is translucent... the solid is always rendered first
-        return !trans1;
-    };
+
+        // calculate the farthest W point for front to back sorting
+        const cull4_t centerW = Add4(
+            Add4(Mul4(m[12], centerX), Mul4(m[13], centerY)), Add4(Mul4(m[14], centerZ), m[15]));
+        const cull4_t extentW = Add4(
+            Add4(Mul4(Abs4(m[12]), extentX), Mul4(Abs4(m[13]), extentY)),
+            Mul4(Abs4(m[14]), extentZ));
+        const cull4_t maxW = Add4(centerW, extentW);
+
+        float key[4];
+        Store4(key, And4(visible, Max4(maxW, zero)));
+        for (int i = 0; i < blockSize; i++) {
+            surfaces[first + i].key = key[i];
+        }
+    }
+}
+
+// Working lists of BuildModelSurfaceList.
+struct ovrModelSurfaceLists {
+    std::vector<bsort_t> bsort;
+    std::vector<Matrix4f> nodeMatrices;
+    std::vector<Matrix4f> jointMatrices;
+    std::vector<ovrDrawSortItem> sortItems;
+    std::vector<ovrDrawSortItem> tempItems;
 };
 
+// Solid surfaces sort before transparent surfaces. Solid surfaces are grouped by state and sort
+// front-to-back within a group, transparent surfaces sort back-to-front. The keys are never
+// negative, so their bit patterns sort the same way as the float values.
+static uint64_t SurfaceSortKey(const bsort_t& s) {
+    uint32_t bits;
+    memcpy(&bits, &s.key, sizeof(bits));
+    return DrawSortKey(*s.surface, 0, s.transparent ? ~bits : bits);
+}
+
+// Calculates the skin joint matrices of a skinned node relative to the node itself, which is the
+// space its surfaces are drawn and culled in.
+static bool CalculateSkinMatrices(
+    const ModelNodeState& nodeState,
+    std::vector<Matrix4f>& jointMatrices) {
+    const ModelState* state = nodeState.state;
+    const int skinIndex = nodeState.node->skinIndex;
+    if (state == nullptr || state->mf == nullptr || skinIndex < 0 ||
+        skinIndex >= static_cast<int>(state->mf->Skins.size())) {
+        return false;
+    }
+
+    const ModelSkin& skin = state->mf->Skins[skinIndex];
+    const int numJoints = static_cast<int>(skin.jointIndexes.size());
+    const Matrix4f inverseNodeTransform = nodeState.GetGlobalTransform().Inverted();
+
+    jointMatrices.resize(numJoints);
+    for (int j = 0; j < numJoints; j++) {
+        const Matrix4f jointTransform =
+            inverseNodeTransform * state->nodeStates[skin.jointIndexes[j]].GetGlobalTransform();
+        if (j < static_cast<int>(skin.inverseBindMatrices.size())) {
+            jointMatrices[j] = jointTransform * skin.inverseBindMatrices[j];
+        } else {
+            jointMatrices[j] = jointTransform;
+        }
+    }
+    return true;
+}
+
+// Each skinned vertex is a weighted average of the vertex transformed by its joints, so it stays
+// inside the union of the per-joint vertex bounds transformed by their joint matrices.
+static bool CalculateSkinnedBounds(
+    const ModelSurface& surface,
+    const std::vector<Matrix4f>& jointMatrices,
+    Bounds3f& bounds) {
+    if (surface.jointBounds.empty() || surface.jointBounds.size() > jointMatrices.size()) {
+        return false;
+    }
+
+    bounds.Clear();
+    for (int j = 0; j < static_cast<int>(surface.jointBounds.size()); j++) {
+        const Bounds3f& jointBounds = surface.jointBounds[j];
+        if (jointBounds.IsInverted()) {
+            continue; // no vertices weighted to this joint
+        }
+        bounds = Bounds3f::Union(bounds, Bounds3f::Transform(jointMatrices[j], jointBounds));
+    }
+    return !bounds.IsInverted();
+}
+
+bool CalculateSkinnedSurfaceBounds(
+    const ModelNodeState& nodeState,
+    const ModelSurface& surface,
+    Bounds3f& bounds) {
+    std::vector<Matrix4f> jointMatrices;
+    return CalculateSkinMatrices(nodeState, jointMatrices) &&
+        CalculateSkinnedBounds(surface, jointMatrices, bounds);
+}
+
 void BuildModelSurfaceList(
     std::vector<ovrDrawSurface>& surfaceList,
     const std::vector<ModelNodeState*>& emitNodes,
     const std::vector<ovrDrawSurface>& emitSurfaces,
     const Matrix4f& viewMatrix,
     const Matrix4f& projectionMatrix) {
-    // A mobile GPU will be in trouble if it draws more than this.
-    static const int MAX_DRAW_SURFACES = 1024;
-    bsort_t bsort[MAX_DRAW_SURFACES];
+    // Reused from frame to frame to avoid allocations.
+    static thread_local ovrModelSurfaceLists threadLists;
+    ovrModelSurfaceLists& lists = threadLists;
+    std::vector<bsort_t>& bsort = lists.bsort;
+    std::vector<Matrix4f>& nodeMatrices = lists.nodeMatrices;
+    std::vector<Matrix4f>& jointMatrices = lists.jointMatrices;
 
     const Matrix4f vpMatrix = projectionMatrix * viewMatrix;
 
-    int numSurfaces = 0;
+    bsort.clear();
+    // Sized up front, the surfaces point at the matrices of their nodes.
+    nodeMatrices.resize(emitNodes.size());
 
     for (int nodeNum = 0; nodeNum < static_cast<int>(emitNodes.size()); nodeNum++) {
         const ModelNodeState& nodeState = *emitNodes[nodeNum];
         if (nodeState.GetNode() != nullptr && nodeState.GetNode()->model != nullptr) {
-            // #TODO currently we aren't properly updating the geo local bounds for skinned animated
-            // objects.  Fix that.
-            bool allowCulling = true;
-            if (nodeState.node->skinIndex >= 0) {
-                allowCulling = false;
-            }
+            nodeMatrices[nodeNum] = nodeState.GetGlobalTransform();
+            // Skinned surfaces are culled with bounds calculated from the current joint matrices.
+            const bool skinned = (nodeState.node->skinIndex >= 0);
+            const bool haveJointMatrices =
+                skinned && CalculateSkinMatrices(nodeState, jointMatrices);
 
             if (nodeState.GetNode()->model != nullptr) {
                 const Model& modelDef = *nodeState.GetNode()->model;
                 for (int surfaceNum = 0; surfaceNum < static_cast<int>(modelDef.surfaces.size());
                      surfaceNum++) {
                     const ovrSurfaceDef& surfaceDef = modelDef.surfaces[surfaceNum].surfaceDef;
-                    const float sort = BoundsSortCullKey(
-                        surfaceDef.geo.localBounds, vpMatrix * nodeState.GetGlobalTransform());
-                    if (sort == 0) {
-                        if (allowCulling) {
-                            if (LogRenderSurfaces) {
-                                ALOG("Culled %s", surfaceDef.surfaceName.c_str());
-                            }
-                            continue;
-                        } else {
-                            if (LogRenderSurfaces) {
-                                ALOG("Skipped Culling of %s", surfaceDef.surfaceName.c_str());
-                            }
-                        }
-                    }
-
-                    if (numSurfaces == MAX_DRAW_SURFACES) {
-                        break;
-                    }
-
                     /*
                                         // Update the Joint Uniform Buffer
                                         if ( nodeState.node->skinIndex >= 0 )
@@ -259,13 +540,24 @@ void BuildModelSurfaceList(
                                         }
                     */
 
-                    bsort[numSurfaces].key = sort;
-                    bsort[numSurfaces].modelMatrix = nodeState.GetGlobalTransform();
-                    bsort[numSurfaces].surface = &surfaceDef;
-                    bsort[numSurfaces].transparent =
-                        (surfaceDef.graphicsCommand.GpuState.blendEnable !=
-                         ovrGpuState::BLEND_DISABLE);
-                    numSurfaces++;
+                    bsort_t& s = bsort.emplace_back();
+                    s.key = 0.0f;
+                    s.bounds = surfaceDef.geo.localBounds;
+                    s.modelMatrix = &nodeMatrices[nodeNum];
+                    s.surface = &surfaceDef;
+                    s.transparent = (surfaceDef.graphicsCommand.GpuState.blendEnable !=
+                                     ovrGpuState::BLEND_DISABLE);
+                    s.allowCulling = true;
+                    if (skinned) {
+                        // Surfaces that can't be bounded are always drawn.
+                        const ModelSurface& surface = modelDef.surfaces[surfaceNum];
+                        Bounds3f skinnedBounds;
+                        s.allowCulling = haveJointMatrices &&
+                            CalculateSkinnedBounds(surface, jointMatrices, skinnedBounds);
+                        if (s.allowCulling) {
+                            s.bounds = skinnedBounds;
+                        }
+                    }
                 }
             }
         }
@@ -274,39 +566,58 @@ void BuildModelSurfaceList(
     for (int i = 0; i < static_cast<int>(emitSurfaces.size()); i++) {
         const ovrDrawSurface& drawSurf = emitSurfaces[i];
         const ovrSurfaceDef& surfaceDef = *drawSurf.surface;
-        const float sort =
-            BoundsSortCullKey(surfaceDef.geo.localBounds, vpMatrix * drawSurf.modelMatrix);
-        if (sort == 0) {
-            if (LogRenderSurfaces) {
-                ALOG("Culled %s", surfaceDef.surfaceName.c_str());
-            }
-            continue;
-        }
+        bsort_t& s = bsort.emplace_back();
+        s.key = 0.0f;
+        s.bounds = surfaceDef.geo.localBounds;
+        s.modelMatrix = &drawSurf.modelMatrix;
+        s.surface = &surfaceDef;
+        s.transparent =
+            (surfaceDef.graphicsCommand.GpuState.blendEnable != ovrGpuState::BLEND_DISABLE);
+        s.allowCulling = true;
+    }
 
-        if (numSurfaces == MAX_DRAW_SURFACES) {
-            break;
-        }
+    const int numCandidates = static_cast<int>(bsort.size());
+    if (numCandidates >= PARALLEL_CULL_COUNT) {
+        const int numChunks = (numCandidates + CULL_CHUNK_SIZE - 1) / CULL_CHUNK_SIZE;
+        ParallelFor(numChunks, [&](int chunk) {
+            const int first = chunk * CULL_CHUNK_SIZE;
+            const int count = std::min(CULL_CHUNK_SIZE, numCandidates - first);
+            BoundsSortCullKeys(bsort.data() + first, count, vpMatrix);
+        });
+    } else {
+        BoundsSortCullKeys(bsort.data(), numCandidates, vpMatrix);
+    }
 
-        bsort[numSurfaces].key = sort;
-        bsort[numSurfaces].modelMatrix = drawSurf.modelMatrix;
-        bsort[numSurfaces].surface = &surfaceDef;
-        bsort[numSurfaces].transparent =
-            (surfaceDef.graphicsCommand.GpuState.blendEnable != ovrGpuState::BLEND_DISABLE);
-        numSurfaces++;
+    std::vector<ovrDrawSortItem>& sortItems = lists.sortItems;
+    sortItems.clear();
+    for (int i = 0; i < numCandidates; i++) {
+        const bsort_t& s = bsort[i];
+        if (s.key == 0.0f) {
+            if (s.allowCulling) {
+                if (LogRenderSurfaces) {
+                    ALOG("Culled %s", s.surface->surfaceName.c_str());
+                }
+                continue;
+            } else {
+                if (LogRenderSurfaces) {
+                    ALOG("Skipped Culling of %s", s.surface->surfaceName.c_str());
+                }
+            }
+        }
+        sortItems.push_back({SurfaceSortKey(s), i});
     }
 
-    // sort by the far W and transparency
-    // IMPORTANT: use a stable sort so surfaces with identical bounds
-    // will sort consistently from frame to frame, rather than randomly
-    // as happens with qsort.
-    std::stable_sort(bsort, bsort + numSurfaces);
+    // sort by transparency, state and the far W
+    RadixSortDrawKeys(sortItems, lists.tempItems);
 
     // ----TODO_DRAWEYEVIEW : don't overwrite surfaces which may have already been added to the
     // surfaceList.
+    const int numSurfaces = static_cast<int>(sortItems.size());
     surfaceList.resize(numSurfaces);
     for (int i = 0; i < numSurfaces; i++) {
-        surfaceList[i].modelMatrix = bsort[i].modelMatrix;
-        surfaceList[i].surface = bsort[i].surface;
+        const bsort_t& s = bsort[sortItems[i].index];
+        surfaceList[i].modelMatrix = *s.modelMatrix;
+        surfaceList[i].surface = s.surface;
     }
 }
 
@@ -36,8 +36,9 @@ Authors     :   John Carmack
 namespace OVRFW {
 // The model surfaces are culled and added to the sorted surface list.
 // Application specific surfaces from the emit list are also added to the sorted surface list.
-// The surface list is sorted such that opaque surfaces come first, sorted front-to-back,
-// and transparent surfaces come last, sorted back-to-front.
+// The surface list is sorted with DrawSortKey such that opaque surfaces come first, grouped by
+// program and textures and sorted front-to-back within a group, and transparent surfaces come
+// last, sorted back-to-front.
 void BuildModelSurfaceList(
     std::vector<ovrDrawSurface>& surfaceList,
     const std::vector<ModelNodeState*>& emitNodes,
@@ -45,4 +46,12 @@ void BuildModelSurfaceList(
     const OVR::Matrix4f& viewMatrix,
     const OVR::Matrix4f& projectionMatrix);
 
+// Calculates the bounds of a surface of a skinned node in the current pose of the skin, in the
+// space of the node, which is what BuildModelSurfaceList culls the surface with. Returns false if
+// the surface can't be bounded, in which case it is never culled.
+bool CalculateSkinnedSurfaceBounds(
+    const ModelNodeState& nodeState,
+    const ModelSurface& surface,
+    OVR::Bounds3f& bounds);
+
 } // namespace OVRFW
@@ -173,7 +173,7 @@ bool ModelTrace::Validate(const bool fullVerify) const {
     invalid |= header.numNodes != static_cast<int>(nodes.size());
     invalid |= header.numLeafs != static_cast<int>(leafs.size());
     invalid |= header.numOverflow != static_cast<int>(overflow.size());
-    if (!invalid) {
+    if (invalid) {
         ALOG("ModelTrace::Verify - invalid header");
         return false;
     }
@@ -212,7 +212,7 @@ bool ModelTrace::Validate(const bool fullVerify) const {
             }
         }
         const int numTris = static_cast<int>(indices.size()) / 3;
-        if (numTris * 3 != static_cast<int>(indices.size()) * 3) {
+        if (numTris * 3 != static_cast<int>(indices.size())) {
             ALOG("ModelTrace::Verify - Orphaned indices");
             return false;
         }
@@ -252,9 +252,10 @@ bool ModelTrace::Validate(const bool fullVerify) const {
                 }
             }
         }
-        // verify overflow list doesn't point to any out-of-range triangles
+        // verify overflow list doesn't point to any out-of-range triangles, -1 ends the list of a
+        // leaf
         for (int i = 0; i < static_cast<int>(overflow.size()); ++i) {
-            if (overflow[i] < 0 || overflow[i] >= numTris) {
+            if (overflow[i] < -1 || overflow[i] >= numTris) {
                 ALOG(
                     "ModelTrace::Verify - overflow index %i value %i is out of range, max %i",
                     i,
@@ -278,56 +279,349 @@ bool ModelTrace::Validate(const bool fullVerify) const {
     return true;
 }
 
-traceResult_t ModelTrace::Trace(const Vector3f& start, const Vector3f& end) const {
-    // in debug, at least warn programmers if they're loading a model
-    // that fails simple validation.
-    assert(Validate(false));
+/*
 
-    traceResult_t result;
-    result.triangleIndex = -1;
-    result.fraction = 1.0f;
-    result.uv = Vector2f(0.0f);
-    result.normal = Vector3f(0.0f);
+    On building fast kd-Trees for Ray Tracing, and on doing that in O(N log N)
+    Ingo Wald, Vlastimil Havran
+    IEEE Symposium on Interactive Ray Tracing, 2006
 
-    const Vector3f rayDelta = end - start;
-    const float rayLengthSqr = rayDelta.LengthSq();
-    const float rayLengthRcp = OVR::RcpSqrt(rayLengthSqr);
-    const float rayLength = rayLengthSqr * rayLengthRcp;
-    const Vector3f rayDir = rayDelta * rayLengthRcp;
+    The split planes are chosen with the surface area heuristic using a sweep over the sorted
+    triangle bound events of each axis. Triangles are classified by their bounds clipped to the
+    node, which is conservative. The ropes of each leaf point at the node on the other side of
+    each face of the leaf, they are not pushed down to the adjacent leaves.
 
-    const float rcpRayDirX = (fabsf(rayDir.x) > MATH_FLOAT_SMALLEST_NON_DENORMAL)
-        ? (1.0f / rayDir.x)
-        : MATH_FLOAT_HUGE_NUMBER;
-    const float rcpRayDirY = (fabsf(rayDir.y) > MATH_FLOAT_SMALLEST_NON_DENORMAL)
-        ? (1.0f / rayDir.y)
-        : MATH_FLOAT_HUGE_NUMBER;
-    const float rcpRayDirZ = (fabsf(rayDir.z) > MATH_FLOAT_SMALLEST_NON_DENORMAL)
-        ? (1.0f / rayDir.z)
-        : MATH_FLOAT_HUGE_NUMBER;
+*/
 
-    const float sX = (header.bounds.GetMins()[0] - start.x) * rcpRayDirX;
-    const float sY = (header.bounds.GetMins()[1] - start.y) * rcpRayDirY;
-    const float sZ = (header.bounds.GetMins()[2] - start.z) * rcpRayDirZ;
+const float RT_KDTREE_TRAVERSAL_COST = 1.0f;
+const float RT_KDTREE_INTERSECTION_COST = 1.5f;
+const float RT_KDTREE_EMPTY_BONUS = 0.2f;
+const int RT_KDTREE_MAX_DEPTH = 40;
 
-    const float tX = (header.bounds.GetMaxs()[0] - start.x) * rcpRayDirX;
-    const float tY = (header.bounds.GetMaxs()[1] - start.y) * rcpRayDirY;
-    const float tZ = (header.bounds.GetMaxs()[2] - start.z) * rcpRayDirZ;
+class KdTreeBuilder {
+   public:
+    KdTreeBuilder(ModelTrace& trace) : Trace(trace) {}
 
-    const float minX = std::min(sX, tX);
-    const float minY = std::min(sY, tY);
-    const float minZ = std::min(sZ, tZ);
+    void BuildNode(
+        const int nodeIndex,
+        const Bounds3f& cell,
+        const std::vector<int>& triangles,
+        const int (&ropes)[6],
+        const int depth);
 
-    const float maxX = std::max(sX, tX);
-    const float maxY = std::max(sY, tY);
-    const float maxZ = std::max(sZ, tZ);
+    std::vector<Bounds3f> TriangleBounds;
 
-    const float t0 = std::max(minX, std::max(minY, minZ));
-    const float t1 = std::min(maxX, std::min(maxY, maxZ));
+   private:
+    enum eventType_t { EVENT_END, EVENT_PLANAR, EVENT_START };
 
-    if (t0 >= t1) {
-        return result;
+    struct event_t {
+        float position;
+        int type;
+
+        bool operator<(const event_t& other) const {
+            return (position < other.position) ||
+                (position == other.position && type < other.type);
+        }
+    };
+
+    bool FindSplit(
+        const Bounds3f& cell,
+        const std::vector<int>& triangles,
+        int& splitAxis,
+        float& splitPosition);
+    void MakeLeaf(
+        const int nodeIndex,
+        const Bounds3f& cell,
+        const std::vector<int>& triangles,
+        const int (&ropes)[6]);
+
+    ModelTrace& Trace;
+    std::vector<event_t> Events;
+};
+
+static float HalfSurfaceArea(const Bounds3f& b) {
+    const Vector3f size = b.GetSize();
+    return size.x * size.y + size.y * size.z + size.z * size.x;
+}
+
+bool KdTreeBuilder::FindSplit(
+    const Bounds3f& cell,
+    const std::vector<int>& triangles,
+    int& splitAxis,
+    float& splitPosition) {
+    const float cellArea = HalfSurfaceArea(cell);
+    if (cellArea <= 0.0f) {
+        return false;
+    }
+    const float rcpCellArea = 1.0f / cellArea;
+    const int numTriangles = static_cast<int>(triangles.size());
+
+    // Splitting has to beat the cost of intersecting all triangles in a single leaf.
+    float bestCost = RT_KDTREE_INTERSECTION_COST * numTriangles;
+    bool found = false;
+
+    for (int axis = 0; axis < 3; axis++) {
+        const float cellMin = cell.GetMins()[axis];
+        const float cellMax = cell.GetMaxs()[axis];
+        if (cellMax <= cellMin) {
+            continue;
+        }
+
+        Events.clear();
+        for (const int triangle : triangles) {
+            const Bounds3f& b = TriangleBounds[triangle];
+            const float triMin = std::max(b.GetMins()[axis], cellMin);
+            const float triMax = std::min(b.GetMaxs()[axis], cellMax);
+            if (triMin == triMax) {
+                Events.push_back({triMin, EVENT_PLANAR});
+            } else {
+                Events.push_back({triMin, EVENT_START});
+                Events.push_back({triMax, EVENT_END});
+            }
+        }
+        std::sort(Events.begin(), Events.end());
+
+        // A triangle goes left if it starts before the plane or lies in it, and right if it ends
+        // after the plane.
+        int numLeft = 0;
+        int numRight = numTriangles;
+        const int numEvents = static_cast<int>(Events.size());
+        for (int i = 0; i < numEvents;) {
+            const float position = Events[i].position;
+            int numEnding = 0;
+            int numPlanar = 0;
+            int numStarting = 0;
+            for (; i < numEvents && Events[i].position == position &&
+                 Events[i].type == EVENT_END;
+                 i++) {
+                numEnding++;
+            }
+            for (; i < numEvents && Events[i].position == position &&
+                 Events[i].type == EVENT_PLANAR;
+                 i++) {
+                numPlanar++;
+            }
+            for (; i < numEvents && Events[i].position == position &&
+                 Events[i].type == EVENT_START;
+                 i++) {
+                numStarting++;
+            }
+
+            numRight -= numEnding + numPlanar;
+
+            if (position > cellMin && position < cellMax) {
+                Vector3f leftMaxs = cell.GetMaxs();
+                Vector3f rightMins = cell.GetMins();
+                leftMaxs[axis] = position;
+                rightMins[axis] = position;
+                const float leftArea = HalfSurfaceArea(Bounds3f(cell.GetMins(), leftMaxs));
+                const float rightArea = HalfSurfaceArea(Bounds3f(rightMins, cell.GetMaxs()));
+
+                const int leftCount = numLeft + numPlanar;
+                const int rightCount = numRight;
+                const float bonus =
+                    (leftCount == 0 || rightCount == 0) ? (1.0f - RT_KDTREE_EMPTY_BONUS) : 1.0f;
+                const float cost = bonus *
+                    (RT_KDTREE_TRAVERSAL_COST +
+                     RT_KDTREE_INTERSECTION_COST * rcpCellArea *
+                         (leftArea * leftCount + rightArea * rightCount));
+                if (cost < bestCost) {
+                    bestCost = cost;
+                    splitAxis = axis;
+                    splitPosition = position;
+                    found = true;
+                }
+            }
+
+            numLeft += numStarting + numPlanar;
+        }
     }
 
+    return found;
+}
+
+void KdTreeBuilder::MakeLeaf(
+    const int nodeIndex,
+    const Bounds3f& cell,
+    const std::vector<int>& triangles,
+    const int (&ropes)[6]) {
+    kdtree_leaf_t leaf;
+    for (int i = 0; i < 6; i++) {
+        leaf.ropes[i] = ropes[i];
+    }
+    leaf.bounds = cell;
+
+    const int numTriangles = static_cast<int>(triangles.size());
+    if (numTriangles <= RT_KDTREE_MAX_LEAF_TRIANGLES) {
+        for (int i = 0; i < RT_KDTREE_MAX_LEAF_TRIANGLES; i++) {
+            leaf.triangles[i] = (i < numTriangles) ? triangles[i] : -1;
+        }
+    } else {
+        // Store all triangles in the overflow list, terminated with -1.
+        leaf.triangles[0] = static_cast<int>(0x80000000u | (unsigned)Trace.overflow.size());
+        for (int i = 1; i < RT_KDTREE_MAX_LEAF_TRIANGLES; i++) {
+            leaf.triangles[i] = -1;
+        }
+        Trace.overflow.insert(Trace.overflow.end(), triangles.begin(), triangles.end());
+        Trace.overflow.push_back(-1);
+    }
+
+    Trace.nodes[nodeIndex].data = (static_cast<unsigned int>(Trace.leafs.size()) << 3) | 1;
+    Trace.nodes[nodeIndex].dist = 0.0f;
+    Trace.leafs.push_back(leaf);
+}
+
+void KdTreeBuilder::BuildNode(
+    const int nodeIndex,
+    const Bounds3f& cell,
+    const std::vector<int>& triangles,
+    const int (&ropes)[6],
+    const int depth) {
+    int axis = 0;
+    float position = 0.0f;
+    if (triangles.empty() || depth >= RT_KDTREE_MAX_DEPTH ||
+        !FindSplit(cell, triangles, axis, position)) {
+        MakeLeaf(nodeIndex, cell, triangles, ropes);
+        return;
+    }
+
+    std::vector<int> leftTriangles;
+    std::vector<int> rightTriangles;
+    for (const int triangle : triangles) {
+        const Bounds3f& b = TriangleBounds[triangle];
+        const float triMin = std::max(b.GetMins()[axis], cell.GetMins()[axis]);
+        const float triMax = std::min(b.GetMaxs()[axis], cell.GetMaxs()[axis]);
+        if (triMin < position || (triMin == position && triMax == position)) {
+            leftTriangles.push_back(triangle);
+        }
+        if (triMax > position) {
+            rightTriangles.push_back(triangle);
+        }
+    }
+
+    const int leftIndex = static_cast<int>(Trace.nodes.size());
+    Trace.nodes.emplace_back();
+    Trace.nodes.emplace_back();
+    Trace.nodes[nodeIndex].data = (static_cast<unsigned int>(leftIndex) << 3) | (axis << 1);
+    Trace.nodes[nodeIndex].dist = position;
+
+    Vector3f leftMaxs = cell.GetMaxs();
+    Vector3f rightMins = cell.GetMins();
+    leftMaxs[axis] = position;
+    rightMins[axis] = position;
+
+    // The split plane is the max face of the left child and the min face of the right child.
+    int leftRopes[6];
+    int rightRopes[6];
+    for (int i = 0; i < 6; i++) {
+        leftRopes[i] = ropes[i];
+        rightRopes[i] = ropes[i];
+    }
+    leftRopes[axis * 2 + 1] = leftIndex + 1;
+    rightRopes[axis * 2 + 0] = leftIndex;
+
+    BuildNode(leftIndex, Bounds3f(cell.GetMins(), leftMaxs), leftTriangles, leftRopes, depth + 1);
+    BuildNode(
+        leftIndex + 1, Bounds3f(rightMins, cell.GetMaxs()), rightTriangles, rightRopes, depth + 1);
+}
+
+bool ModelTrace::Build(
+    const std::vector<Vector3f>& vertices_,
+    const std::vector<Vector2f>& uvs_,
+    const std::vector<int>& indices_) {
+    if (!uvs_.empty() && uvs_.size() != vertices_.size()) {
+        ALOG("ModelTrace::Build - model must have no uvs, or the same number of uvs as vertices");
+        return false;
+    }
+    const int numTriangles = static_cast<int>(indices_.size()) / 3;
+    for (int i = 0; i < numTriangles * 3; i++) {
+        if (indices_[i] < 0 || indices_[i] >= static_cast<int>(vertices_.size())) {
+            ALOG("ModelTrace::Build - index %i value %i is out of range", i, indices_[i]);
+            return false;
+        }
+    }
+
+    vertices = vertices_;
+    uvs = uvs_;
+    indices.assign(indices_.begin(), indices_.begin() + numTriangles * 3);
+    nodes.clear();
+    leafs.clear();
+    overflow.clear();
+
+    KdTreeBuilder builder(*this);
+    builder.TriangleBounds.resize(numTriangles);
+    std::vector<int> triangles(numTriangles);
+    Bounds3f bounds(Bounds3f::Init);
+    for (int i = 0; i < numTriangles; i++) {
+        Bounds3f& b = builder.TriangleBounds[i];
+        b.Clear();
+        b.AddPoint(vertices[indices[i * 3 + 0]]);
+        b.AddPoint(vertices[indices[i * 3 + 1]]);
+        b.AddPoint(vertices[indices[i * 3 + 2]]);
+        bounds.AddPoint(b.GetMins());
+        bounds.AddPoint(b.GetMaxs());
+        triangles[i] = i;
+    }
+    if (numTriangles == 0) {
+        bounds = Bounds3f(Vector3f(0.0f), Vector3f(0.0f));
+    }
+    // Pad the bounds so rays still enter the tree of a flat model.
+    bounds = Bounds3f(bounds.GetMins() - Vector3f(0.0001f), bounds.GetMaxs() + Vector3f(0.0001f));
+
+    const int ropes[6] = {-1, -1, -1, -1, -1, -1};
+    nodes.emplace_back();
+    builder.BuildNode(0, bounds, triangles, ropes, 0);
+
+    header.numVertices = static_cast<int>(vertices.size());
+    header.numUvs = static_cast<int>(uvs.size());
+    header.numIndices = static_cast<int>(indices.size());
+    header.numNodes = static_cast<int>(nodes.size());
+    header.numLeafs = static_cast<int>(leafs.size());
+    header.numOverflow = static_cast<int>(overflow.size());
+    header.bounds = bounds;
+
+    return true;
+}
+
+static float RcpRayDir(const float d) {
+    return (fabsf(d) > MATH_FLOAT_SMALLEST_NON_DENORMAL) ? (1.0f / d) : MATH_FLOAT_HUGE_NUMBER;
+}
+
+void ModelTrace::SetHitResult(
+    traceResult_t& result,
+    const float distance,
+    const float rayLengthRcp,
+    const Vector2f& uv) const {
+    result.fraction = distance * rayLengthRcp;
+    // return default uvs if the model has no uvs
+    if (static_cast<int>(uvs.size()) == 0) {
+        result.uv = Vector2f(0.0f, 0.0f);
+    } else {
+        result.uv = uvs[indices[result.triangleIndex + 0]] * (1.0f - uv.x - uv.y) +
+            uvs[indices[result.triangleIndex + 1]] * uv.x +
+            uvs[indices[result.triangleIndex + 2]] * uv.y;
+    }
+    const Vector3f d1 =
+        vertices[indices[result.triangleIndex + 1]] - vertices[indices[result.triangleIndex + 0]];
+    const Vector3f d2 =
+        vertices[indices[result.triangleIndex + 2]] - vertices[indices[result.triangleIndex + 0]];
+    result.normal = d1.Cross(d2).Normalized();
+}
+
+// Walks the tree for a ray that overlaps the model bounds between t0 and t1.
+traceResult_t ModelTrace::TraceRay(
+    const Vector3f& start,
+    const Vector3f& rayDir,
+    const Vector3f& rcpRayDir,
+    const float rayLength,
+    const float rayLengthRcp,
+    const float t0,
+    const float t1) const {
+    traceResult_t result;
+    result.triangleIndex = -1;
+    result.fraction = 1.0f;
+    result.uv = Vector2f(0.0f);
+    result.normal = Vector3f(0.0f);
+
     float entryDistance = std::max(t0, 0.0f);
     float bestDistance = std::min(t1 + 0.00001f, rayLength);
     Vector2f uv;
@@ -344,12 +638,12 @@ traceResult_t ModelTrace::Trace(const Vector3f& start, const Vector3f& end) cons
             // on the ray direction.
             const int nodePlane = ((currentNode->data >> 1) & 3);
             int child;
-            if (rayEntryPoint[nodePlane] - currentNode->dist < 0.00001f) {
+            if (rayEntryPoint[nodePlane] - currentNode->dist < -0.00001f) {
                 child = 0;
             } else if (rayEntryPoint[nodePlane] - currentNode->dist > 0.00001f) {
                 child = 1;
             } else {
-                child = (rayDelta[nodePlane] > 0.0f);
+                child = (rayDir[nodePlane] > 0.0f);
             }
             currentNode = &nodes[(currentNode->data >> 3) + child];
         }
@@ -396,13 +690,13 @@ traceResult_t ModelTrace::Trace(const Vector3f& start, const Vector3f& end) cons
         }
 
         // Calculate the distance along the ray where the next leaf is entered.
-        const float sXX = (currentLeaf->bounds.GetMins()[0] - start.x) * rcpRayDirX;
-        const float sYY = (currentLeaf->bounds.GetMins()[1] - start.y) * rcpRayDirY;
-        const float sZZ = (currentLeaf->bounds.GetMins()[2] - start.z) * rcpRayDirZ;
+        const float sXX = (currentLeaf->bounds.GetMins()[0] - start.x) * rcpRayDir.x;
+        const float sYY = (currentLeaf->bounds.GetMins()[1] - start.y) * rcpRayDir.y;
+        const float sZZ = (currentLeaf->bounds.GetMins()[2] - start.z) * rcpRayDir.z;
 
-        const float tXX = (currentLeaf->bounds.GetMaxs()[0] - start.x) * rcpRayDirX;
-        const float tYY = (currentLeaf->bounds.GetMaxs()[1] - start.y) * rcpRayDirY;
-        const float tZZ = (currentLeaf->bounds.GetMaxs()[2] - start.z) * rcpRayDirZ;
+        const float tXX = (currentLeaf->bounds.GetMaxs()[0] - start.x) * rcpRayDir.x;
+        const float tYY = (currentLeaf->bounds.GetMaxs()[1] - start.y) * rcpRayDir.y;
+        const float tZZ = (currentLeaf->bounds.GetMaxs()[2] - start.z) * rcpRayDir.z;
 
         const float maxXX = std::max(sXX, tXX);
         const float maxYY = std::max(sYY, tYY);
@@ -413,10 +707,12 @@ traceResult_t ModelTrace::Trace(const Vector3f& start, const Vector3f& end) cons
             break;
         }
 
-        // Calculate the exit plane.
-        const int exitX = (0 << 1) | ((sXX < tXX) ? 1 : 0);
-        const int exitY = (1 << 1) | ((sYY < tYY) ? 1 : 0);
-        const int exitZ = (2 << 1) | ((sZZ < tZZ) ? 1 : 0);
+        // Calculate the exit plane. The side follows the ray direction, because a leaf around
+        // planar triangles can have zero width, and then both of its faces are at the same
+        // distance.
+        const int exitX = (0 << 1) | ((rcpRayDir.x > 0.0f) ? 1 : 0);
+        const int exitY = (1 << 1) | ((rcpRayDir.y > 0.0f) ? 1 : 0);
+        const int exitZ = (2 << 1) | ((rcpRayDir.z > 0.0f) ? 1 : 0);
         const int exitPlane =
             (maxXX < maxYY) ? (maxXX < maxZZ ? exitX : exitZ) : (maxYY < maxZZ ? exitY : exitZ);
 
@@ -430,25 +726,145 @@ traceResult_t ModelTrace::Trace(const Vector3f& start, const Vector3f& end) cons
     }
 
     if (result.triangleIndex != -1) {
-        result.fraction = bestDistance * rayLengthRcp;
-        // return default uvs if the model has no uvs
-        if (static_cast<int>(uvs.size()) == 0) {
-            result.uv = Vector2f(0.0f, 0.0f);
-        } else {
-            result.uv = uvs[indices[result.triangleIndex + 0]] * (1.0f - uv.x - uv.y) +
-                uvs[indices[result.triangleIndex + 1]] * uv.x +
-                uvs[indices[result.triangleIndex + 2]] * uv.y;
-        }
-        const Vector3f d1 = vertices[indices[result.triangleIndex + 1]] -
-            vertices[indices[result.triangleIndex + 0]];
-        const Vector3f d2 = vertices[indices[result.triangleIndex + 2]] -
-            vertices[indices[result.triangleIndex + 0]];
-        result.normal = d1.Cross(d2).Normalized();
+        SetHitResult(result, bestDistance, rayLengthRcp, uv);
     }
 
     return result;
 }
 
+traceResult_t ModelTrace::Trace(const Vector3f& start, const Vector3f& end) const {
+    // in debug, at least warn programmers if they're loading a model
+    // that fails simple validation.
+    assert(Validate(false));
+
+    traceResult_t result;
+    result.triangleIndex = -1;
+    result.fraction = 1.0f;
+    result.uv = Vector2f(0.0f);
+    result.normal = Vector3f(0.0f);
+
+    const Vector3f rayDelta = end - start;
+    const float rayLengthSqr = rayDelta.LengthSq();
+    const float rayLengthRcp = OVR::RcpSqrt(rayLengthSqr);
+    const float rayLength = rayLengthSqr * rayLengthRcp;
+    const Vector3f rayDir = rayDelta * rayLengthRcp;
+
+    const Vector3f rcpRayDir(RcpRayDir(rayDir.x), RcpRayDir(rayDir.y), RcpRayDir(rayDir.z));
+
+    const float sX = (header.bounds.GetMins()[0] - start.x) * rcpRayDir.x;
+    const float sY = (header.bounds.GetMins()[1] - start.y) * rcpRayDir.y;
+    const float sZ = (header.bounds.GetMins()[2] - start.z) * rcpRayDir.z;
+
+    const float tX = (header.bounds.GetMaxs()[0] - start.x) * rcpRayDir.x;
+    const float tY = (header.bounds.GetMaxs()[1] - start.y) * rcpRayDir.y;
+    const float tZ = (header.bounds.GetMaxs()[2] - start.z) * rcpRayDir.z;
+
+    const float minX = std::min(sX, tX);
+    const float minY = std::min(sY, tY);
+    const float minZ = std::min(sZ, tZ);
+
+    const float maxX = std::max(sX, tX);
+    const float maxY = std::max(sY, tY);
+    const float maxZ = std::max(sZ, tZ);
+
+    const float t0 = std::max(minX, std::max(minY, minZ));
+    const float t1 = std::min(maxX, std::min(maxY, maxZ));
+
+    // The ray misses the bounds, or starts beyond them.
+    if (t0 >= t1 || t1 < 0.0f) {
+        return result;
+    }
+
+    return TraceRay(start, rayDir, rcpRayDir, rayLength, rayLengthRcp, t0, t1);
+}
+
+// Rays are set up and tested against the model bounds in packets of this many rays. The packet
+// is kept in a structure-of-arrays layout so the compiler can vectorize the loops over it.
+static const int RT_TRACE_PACKET_SIZE = 8;
+
+void ModelTrace::TraceBatch(
+    const Vector3f* starts,
+    const Vector3f* ends,
+    const int count,
+    traceResult_t* results) const {
+    assert(Validate(false));
+
+    const Vector3f boundsMins = header.bounds.GetMins();
+    const Vector3f boundsMaxs = header.bounds.GetMaxs();
+
+    for (int first = 0; first < count; first += RT_TRACE_PACKET_SIZE) {
+        const int packetSize = std::min(RT_TRACE_PACKET_SIZE, count - first);
+
+        float startX[RT_TRACE_PACKET_SIZE];
+        float startY[RT_TRACE_PACKET_SIZE];
+        float startZ[RT_TRACE_PACKET_SIZE];
+        float dirX[RT_TRACE_PACKET_SIZE];
+        float dirY[RT_TRACE_PACKET_SIZE];
+        float dirZ[RT_TRACE_PACKET_SIZE];
+        float lengthRcp[RT_TRACE_PACKET_SIZE];
+
+        // Unused lanes trace a zero length ray, which never reaches the tree.
+        for (int i = 0; i < RT_TRACE_PACKET_SIZE; i++) {
+            const bool used = i < packetSize;
+            startX[i] = used ? starts[first + i].x : 0.0f;
+            startY[i] = used ? starts[first + i].y : 0.0f;
+            startZ[i] = used ? starts[first + i].z : 0.0f;
+            dirX[i] = used ? ends[first + i].x - startX[i] : 0.0f;
+            dirY[i] = used ? ends[first + i].y - startY[i] : 0.0f;
+            dirZ[i] = used ? ends[first + i].z - startZ[i] : 0.0f;
+        }
+
+        float rcpX[RT_TRACE_PACKET_SIZE];
+        float rcpY[RT_TRACE_PACKET_SIZE];
+        float rcpZ[RT_TRACE_PACKET_SIZE];
+        float t0[RT_TRACE_PACKET_SIZE];
+        float t1[RT_TRACE_PACKET_SIZE];
+
+        for (int i = 0; i < RT_TRACE_PACKET_SIZE; i++) {
+            const float lengthSqr = dirX[i] * dirX[i] + dirY[i] * dirY[i] + dirZ[i] * dirZ[i];
+            lengthRcp[i] = (lengthSqr > 0.0f) ? 1.0f / sqrtf(lengthSqr) : 0.0f;
+            dirX[i] *= lengthRcp[i];
+            dirY[i] *= lengthRcp[i];
+            dirZ[i] *= lengthRcp[i];
+
+            rcpX[i] = RcpRayDir(dirX[i]);
+            rcpY[i] = RcpRayDir(dirY[i]);
+            rcpZ[i] = RcpRayDir(dirZ[i]);
+
+            const float sX = (boundsMins.x - startX[i]) * rcpX[i];
+            const float sY = (boundsMins.y - startY[i]) * rcpY[i];
+            const float sZ = (boundsMins.z - startZ[i]) * rcpZ[i];
+            const float tX = (boundsMaxs.x - startX[i]) * rcpX[i];
+            const float tY = (boundsMaxs.y - startY[i]) * rcpY[i];
+            const float tZ = (boundsMaxs.z - startZ[i]) * rcpZ[i];
+
+            t0[i] = std::max(std::min(sX, tX), std::max(std::min(sY, tY), std::min(sZ, tZ)));
+            t1[i] = std::min(std::max(sX, tX), std::min(std::max(sY, tY), std::max(sZ, tZ)));
+        }
+
+        for (int i = 0; i < packetSize; i++) {
+            traceResult_t& result = results[first + i];
+            // Rays that miss the bounds, start beyond them or have zero length are done.
+            if (t0[i] >= t1[i] || t1[i] < 0.0f || lengthRcp[i] == 0.0f) {
+                result.triangleIndex = -1;
+                result.fraction = 1.0f;
+                result.uv = Vector2f(0.0f);
+                result.normal = Vector3f(0.0f);
+                continue;
+            }
+            const float rayLength = 1.0f / lengthRcp[i];
+            result = TraceRay(
+                Vector3f(startX[i], startY[i], startZ[i]),
+                Vector3f(dirX[i], dirY[i], dirZ[i]),
+                Vector3f(rcpX[i], rcpY[i], rcpZ[i]),
+                rayLength,
+                lengthRcp[i],
+                t0[i],
+                t1[i]);
+        }
+    }
+}
+
 traceResult_t ModelTrace::Trace_Exhaustive(const Vector3f& start, const Vector3f& end) const {
     // in debug, at least warn programmers if they're loading a model
     // that fails simple validation.
@@ -495,20 +911,7 @@ traceResult_t ModelTrace::Trace_Exhaustive(const Vector3f& start, const Vector3f
     }
 
     if (result.triangleIndex != -1) {
-        result.fraction = bestDistance * rayLengthRcp;
-        // return default uvs if the model has no uvs
-        if (static_cast<int>(uvs.size()) == 0) {
-            result.uv = Vector2f(0.0f, 0.0f);
-        } else {
-            result.uv = uvs[indices[result.triangleIndex + 0]] * (1.0f - uv.x - uv.y) +
-                uvs[indices[result.triangleIndex + 1]] * uv.x +
-                uvs[indices[result.triangleIndex + 2]] * uv.y;
-        }
-        const Vector3f d1 = vertices[indices[result.triangleIndex + 1]] -
-            vertices[indices[result.triangleIndex + 0]];
-        const Vector3f d2 = vertices[indices[result.triangleIndex + 2]] -
-            vertices[indices[result.triangleIndex + 0]];
-        result.normal = d1.Cross(d2).Normalized();
+        SetHitResult(result, bestDistance, rayLengthRcp, uv);
     }
 
     return result;
@@ -73,9 +73,24 @@ class ModelTrace {
 
     bool Validate(const bool fullVerify) const;
 
+    // Builds the KD-Tree for the given triangles using the surface area heuristic. The uvs are
+    // optional, if present there must be one per vertex. Replaces any previously loaded tree.
+    bool Build(
+        const std::vector<OVR::Vector3f>& vertices,
+        const std::vector<OVR::Vector2f>& uvs,
+        const std::vector<int>& indices);
+
     traceResult_t Trace(const OVR::Vector3f& start, const OVR::Vector3f& end) const;
     traceResult_t Trace_Exhaustive(const OVR::Vector3f& start, const OVR::Vector3f& end) const;
 
+    // Traces 'count' segments at once. The ray setup and the test against the model bounds are
+    // done a packet of rays at a time, only the rays that touch the model walk the tree.
+    void TraceBatch(
+        const OVR::Vector3f* starts,
+        const OVR::Vector3f* ends,
+        const int count,
+        traceResult_t* results) const;
+
     void PrintStatsToLog() const;
 
    public:
@@ -87,6 +102,21 @@ class ModelTrace {
     std::vector<kdtree_leaf_t> leafs;
     std::vector<int> overflow; // this is a flat array that stores extra triangle indices for leaves
                                // with > RT_KDTREE_MAX_LEAF_TRIANGLES
+
+   private:
+    traceResult_t TraceRay(
+        const OVR::Vector3f& start,
+        const OVR::Vector3f& rayDir,
+        const OVR::Vector3f& rcpRayDir,
+        const float rayLength,
+        const float rayLengthRcp,
+        const float t0,
+        const float t1) const;
+    void SetHitResult(
+        traceResult_t& result,
+        const float distance,
+        const float rayLengthRcp,
+        const OVR::Vector2f& uv) const;
 };
 
 } // namespace OVRFW
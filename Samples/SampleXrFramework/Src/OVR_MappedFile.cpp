@@ -28,7 +28,8 @@ Authors     :   Chris Taylor
 #include "OVR_MappedFile.h"
 #include "OVR_Types.h"
 
-#if defined(OVR_OS_ANDROID)
+// Memory mapping through mmap, on every platform but windows.
+#if !defined(OVR_OS_WIN32)
 
 #if defined(OVR_OS_ANDROID)
 // disable warnings on implicit type conversion where value may be changed by conversion for
@@ -229,4 +230,4 @@ void MappedView::Close() {
 
 } // namespace OVRFW
 
-#endif // defined(OVR_OS_ANDROID)
+#endif // !defined(OVR_OS_WIN32)
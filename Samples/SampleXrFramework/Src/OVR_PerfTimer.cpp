@@ -0,0 +1,354 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * Licensed under the Oculus SDK License Agreement (the "License");
+ * you may not use the Oculus SDK except in compliance with the License,
+ * which is provided at the time of installation or download, or which
+ * otherwise accompanies this software in either electronic or hard copy form.
+ *
+ * You may obtain a copy of the License at
+ * https://developer.oculus.com/licenses/oculussdk/
+ *
+ * Unless required by applicable law or agreed to in writing, the Oculus SDK
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/*******************************************************************************
+
+Filename    :   OVR_PerfTimer.cpp
+Content     :   Scoped CPU timers with per-frame statistics and trace export.
+Created     :   October 18, 2026
+Language    :   C++
+
+*******************************************************************************/
+
+#include "OVR_PerfTimer.h"
+
+#include "OVR_FileSys.h"
+#include "OVR_Stream.h"
+#include "System.h"
+#include "Misc/Log.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace OVRFW {
+
+struct ovrPerfEvent {
+    const char* Name;
+    double StartTime;
+    double EndTime;
+    int Depth; // number of enclosing scopes on the same thread
+};
+
+// Each thread writes its scopes into its own ring buffer. The lock is only contended while the
+// frame statistics are aggregated or a trace is exported.
+struct ovrPerfThreadBuffer {
+    static const int MAX_EVENTS = 16384; // must be a power of two
+
+    explicit ovrPerfThreadBuffer(const int threadId) : ThreadId(threadId), Events(MAX_EVENTS) {}
+
+    std::mutex Mutex;
+    const int ThreadId;
+    int Depth = 0; // only used by the owning thread
+    uint64_t Head = 0; // number of events ever written
+    uint64_t Aggregated = 0; // number of events added to the frame statistics
+    std::vector<ovrPerfEvent> Events;
+};
+
+// Per-frame durations of one timer name over the recent frames, in milliseconds.
+struct ovrPerfHistory {
+    static const int MAX_FRAMES = 128;
+
+    double Durations[MAX_FRAMES] = {};
+    int NumFrames = 0;
+    int Next = 0;
+
+    void Add(const double duration) {
+        Durations[Next] = duration;
+        Next = (Next + 1) % MAX_FRAMES;
+        NumFrames = (NumFrames < MAX_FRAMES) ? NumFrames + 1 : MAX_FRAMES;
+    }
+};
+
+struct ovrPerfFrameMarker {
+    int64_t FrameIndex;
+    double Time;
+};
+
+class ovrPerfTimers {
+   public:
+    static ovrPerfTimers& Get() {
+        // Never destroyed, so timers in threads that outlive static destruction stay valid.
+        static ovrPerfTimers* timers = new ovrPerfTimers();
+        return *timers;
+    }
+
+    ovrPerfThreadBuffer* GetThreadBuffer() {
+        static thread_local ovrPerfThreadBuffer* threadBuffer = nullptr;
+        if (threadBuffer == nullptr) {
+            // Buffers are kept when their thread exits so its events can still be exported.
+            std::lock_guard<std::mutex> lock(Mutex);
+            Buffers.emplace_back(new ovrPerfThreadBuffer(static_cast<int>(Buffers.size()) + 1));
+            threadBuffer = Buffers.back().get();
+        }
+        return threadBuffer;
+    }
+
+    std::atomic<bool> Enabled{false};
+
+    // Returns the index of the named timer in History. Names are interned by their text, so
+    // equal literals at different addresses, as in different libraries, are one timer.
+    int GetTimerIndex(const char* name) {
+        auto it = TimerIndicesByAddress.find(name);
+        if (it != TimerIndicesByAddress.end()) {
+            return it->second;
+        }
+        auto inserted = TimerIndices.emplace(name, static_cast<int>(History.size()));
+        if (inserted.second) {
+            TimerNames.push_back(name);
+            History.emplace_back();
+            FrameDurations.push_back(-1.0);
+        }
+        TimerIndicesByAddress.emplace(name, inserted.first->second);
+        return inserted.first->second;
+    }
+
+    std::mutex Mutex; // guards everything below
+    std::vector<std::unique_ptr<ovrPerfThreadBuffer>> Buffers;
+    std::unordered_map<std::string, int> TimerIndices;
+    std::unordered_map<const char*, int> TimerIndicesByAddress;
+    std::vector<std::string> TimerNames;
+    std::vector<ovrPerfHistory> History;
+    std::vector<double> FrameDurations; // per timer, negative if it didn't run in the frame
+    std::vector<int> FrameTimers; // timers that ran in the frame, reused scratch
+    static const int MAX_FRAME_MARKERS = 256;
+    ovrPerfFrameMarker FrameMarkers[MAX_FRAME_MARKERS] = {};
+    uint64_t NumFrameMarkers = 0;
+};
+
+void SetPerfTimersEnabled(const bool enabled) {
+    ovrPerfTimers::Get().Enabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool GetPerfTimersEnabled() {
+    return ovrPerfTimers::Get().Enabled.load(std::memory_order_relaxed);
+}
+
+ovrScopedPerfTimer::ovrScopedPerfTimer(const char* name) : Name(name), StartTime(-1.0) {
+    ovrPerfTimers& timers = ovrPerfTimers::Get();
+    if (!timers.Enabled.load(std::memory_order_relaxed)) {
+        return;
+    }
+    timers.GetThreadBuffer()->Depth++;
+    StartTime = GetTimeInSeconds();
+}
+
+ovrScopedPerfTimer::~ovrScopedPerfTimer() {
+    if (StartTime < 0.0) {
+        return;
+    }
+    const double endTime = GetTimeInSeconds();
+    ovrPerfThreadBuffer* buffer = ovrPerfTimers::Get().GetThreadBuffer();
+    buffer->Depth--;
+
+    std::lock_guard<std::mutex> lock(buffer->Mutex);
+    ovrPerfEvent& event = buffer->Events[buffer->Head & (ovrPerfThreadBuffer::MAX_EVENTS - 1)];
+    event.Name = Name;
+    event.StartTime = StartTime;
+    event.EndTime = endTime;
+    event.Depth = buffer->Depth;
+    buffer->Head++;
+}
+
+void PerfTimersBeginFrame(const int64_t frameIndex) {
+    ovrPerfTimers& timers = ovrPerfTimers::Get();
+    if (!timers.Enabled.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(timers.Mutex);
+
+    timers.FrameMarkers[timers.NumFrameMarkers % ovrPerfTimers::MAX_FRAME_MARKERS] = {
+        frameIndex, GetTimeInSeconds()};
+    timers.NumFrameMarkers++;
+
+    timers.FrameTimers.clear();
+    for (auto& buffer : timers.Buffers) {
+        std::lock_guard<std::mutex> bufferLock(buffer->Mutex);
+        const uint64_t oldest = (buffer->Head > ovrPerfThreadBuffer::MAX_EVENTS)
+            ? buffer->Head - ovrPerfThreadBuffer::MAX_EVENTS
+            : 0;
+        for (uint64_t i = std::max(buffer->Aggregated, oldest); i < buffer->Head; i++) {
+            const ovrPerfEvent& event =
+                buffer->Events[i & (ovrPerfThreadBuffer::MAX_EVENTS - 1)];
+            const int timer = timers.GetTimerIndex(event.Name);
+            if (timers.FrameDurations[timer] < 0.0) {
+                timers.FrameDurations[timer] = 0.0;
+                timers.FrameTimers.push_back(timer);
+            }
+            timers.FrameDurations[timer] += (event.EndTime - event.StartTime) * 1000.0;
+        }
+        buffer->Aggregated = buffer->Head;
+    }
+
+    for (const int timer : timers.FrameTimers) {
+        timers.History[timer].Add(timers.FrameDurations[timer]);
+        timers.FrameDurations[timer] = -1.0;
+    }
+}
+
+void CalculatePerfStats(const double* durations, const int count, ovrPerfStats& stats) {
+    stats = ovrPerfStats();
+    if (count <= 0) {
+        return;
+    }
+    std::vector<double> sorted(durations, durations + count);
+    std::sort(sorted.begin(), sorted.end());
+
+    // nearest-rank percentiles
+    auto percentile = [&](const int p) { return sorted[std::max(0, (p * count + 99) / 100 - 1)]; };
+
+    double sum = 0.0;
+    for (const double duration : sorted) {
+        sum += duration;
+    }
+    stats.NumFrames = count;
+    stats.Mean = sum / count;
+    stats.P50 = percentile(50);
+    stats.P90 = percentile(90);
+    stats.P99 = percentile(99);
+    stats.Max = sorted.back();
+}
+
+bool GetPerfStats(const char* name, ovrPerfStats& stats) {
+    ovrPerfTimers& timers = ovrPerfTimers::Get();
+    std::lock_guard<std::mutex> lock(timers.Mutex);
+
+    auto it = timers.TimerIndices.find(name);
+    if (it == timers.TimerIndices.end()) {
+        stats = ovrPerfStats();
+        return false;
+    }
+    const ovrPerfHistory& history = timers.History[it->second];
+    CalculatePerfStats(history.Durations, history.NumFrames, stats);
+    return stats.NumFrames > 0;
+}
+
+void LogPerfStats() {
+    std::vector<std::string> names;
+    {
+        ovrPerfTimers& timers = ovrPerfTimers::Get();
+        std::lock_guard<std::mutex> lock(timers.Mutex);
+        names = timers.TimerNames;
+    }
+    std::sort(names.begin(), names.end());
+
+    for (const std::string& name : names) {
+        ovrPerfStats stats;
+        if (GetPerfStats(name.c_str(), stats)) {
+            ALOG(
+                "PerfTimer %-40s frames %3d mean %7.3f p50 %7.3f p90 %7.3f p99 %7.3f max %7.3f ms",
+                name.c_str(),
+                stats.NumFrames,
+                stats.Mean,
+                stats.P50,
+                stats.P90,
+                stats.P99,
+                stats.Max);
+        }
+    }
+}
+
+static void AppendJsonString(std::string& out, const char* s) {
+    out += '"';
+    for (; *s != '\0'; s++) {
+        if (*s == '"' || *s == '\\') {
+            out += '\\';
+        }
+        out += *s;
+    }
+    out += '"';
+}
+
+bool ExportPerfTrace(ovrFileSys& fileSys, const char* uri) {
+    std::string json = "{\"traceEvents\":[\n";
+    char temp[256];
+    bool first = true;
+    auto separator = [&]() {
+        if (!first) {
+            json += ",\n";
+        }
+        first = false;
+    };
+
+    {
+        ovrPerfTimers& timers = ovrPerfTimers::Get();
+        std::lock_guard<std::mutex> lock(timers.Mutex);
+
+        // Chrome traces use microseconds.
+        for (auto& buffer : timers.Buffers) {
+            std::lock_guard<std::mutex> bufferLock(buffer->Mutex);
+            const uint64_t oldest = (buffer->Head > ovrPerfThreadBuffer::MAX_EVENTS)
+                ? buffer->Head - ovrPerfThreadBuffer::MAX_EVENTS
+                : 0;
+            for (uint64_t i = oldest; i < buffer->Head; i++) {
+                const ovrPerfEvent& event =
+                    buffer->Events[i & (ovrPerfThreadBuffer::MAX_EVENTS - 1)];
+                separator();
+                json += "{\"name\":";
+                AppendJsonString(json, event.Name);
+                snprintf(
+                    temp,
+                    sizeof(temp),
+                    ",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f"
+                    ",\"args\":{\"depth\":%d}}",
+                    buffer->ThreadId,
+                    event.StartTime * 1e6,
+                    (event.EndTime - event.StartTime) * 1e6,
+                    event.Depth);
+                json += temp;
+            }
+        }
+
+        const uint64_t numMarkers =
+            std::min<uint64_t>(timers.NumFrameMarkers, ovrPerfTimers::MAX_FRAME_MARKERS);
+        for (uint64_t i = timers.NumFrameMarkers - numMarkers; i < timers.NumFrameMarkers; i++) {
+            const ovrPerfFrameMarker& marker =
+                timers.FrameMarkers[i % ovrPerfTimers::MAX_FRAME_MARKERS];
+            separator();
+            snprintf(
+                temp,
+                sizeof(temp),
+                "{\"name\":\"Frame %lld\",\"ph\":\"i\",\"s\":\"g\",\"pid\":1,\"tid\":0"
+                ",\"ts\":%.3f}",
+                static_cast<long long>(marker.FrameIndex),
+                marker.Time * 1e6);
+            json += temp;
+        }
+    }
+    json += "\n]}\n";
+
+    ovrStream* stream = fileSys.OpenStream(uri, OVR_STREAM_MODE_WRITE);
+    if (stream == nullptr) {
+        ALOGW("ExportPerfTrace: failed to open '%s' for writing", uri);
+        return false;
+    }
+    const bool written = stream->Write(json.data(), json.size());
+    fileSys.CloseStream(stream);
+    if (!written) {
+        ALOGW("ExportPerfTrace: failed to write '%s'", uri);
+    }
+    return written;
+}
+
+} // namespace OVRFW
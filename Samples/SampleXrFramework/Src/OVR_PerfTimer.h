@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * Licensed under the Oculus SDK License Agreement (the "License");
+ * you may not use the Oculus SDK except in compliance with the License,
+ * which is provided at the time of installation or download, or which
+ * otherwise accompanies this software in either electronic or hard copy form.
+ *
+ * You may obtain a copy of the License at
+ * https://developer.oculus.com/licenses/oculussdk/
+ *
+ * Unless required by applicable law or agreed to in writing, the Oculus SDK
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/*******************************************************************************
+
+Filename    :   OVR_PerfTimer.h
+Content     :   Scoped CPU timers with per-frame statistics and trace export.
+Created     :   October 18, 2026
+Language    :   C++
+
+*******************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+
+namespace OVRFW {
+
+class ovrFileSys;
+
+// Durations of one timer name over the recent frames, in milliseconds. A frame's duration is
+// the sum of all scopes with that name that ended during the frame, on any thread.
+struct ovrPerfStats {
+    int NumFrames = 0; // frames in which the timer ran
+    double Mean = 0.0;
+    double P50 = 0.0;
+    double P90 = 0.0;
+    double P99 = 0.0;
+    double Max = 0.0;
+};
+
+// Timers record nothing until enabled, so the instrumentation can stay in release builds. A
+// disabled timer costs a relaxed atomic load.
+void SetPerfTimersEnabled(const bool enabled);
+bool GetPerfTimersEnabled();
+
+// Marks the start of a frame. Aggregates the scopes that ended since the previous call into the
+// per-frame statistics. Call from one thread only, once per frame.
+void PerfTimersBeginFrame(const int64_t frameIndex);
+
+// Returns false if the named timer has not run in the recent frames.
+bool GetPerfStats(const char* name, ovrPerfStats& stats);
+
+// The statistics GetPerfStats reports for the given per-frame durations. The percentiles are
+// nearest-rank.
+void CalculatePerfStats(const double* durations, const int count, ovrPerfStats& stats);
+
+// Logs the statistics of every timer that ran in the recent frames.
+void LogPerfStats();
+
+// Writes the scopes still held in the per-thread ring buffers as Chrome trace event JSON,
+// which chrome://tracing and Perfetto load directly. Returns false if the file can't be written.
+bool ExportPerfTrace(ovrFileSys& fileSys, const char* uri);
+
+// Times the enclosing scope. Scopes nest per thread. The name must be a string literal or
+// otherwise outlive the process's use of the timers. Scopes with the same name text are one
+// timer, whichever literal they use.
+class ovrScopedPerfTimer {
+   public:
+    explicit ovrScopedPerfTimer(const char* name);
+    ~ovrScopedPerfTimer();
+
+    ovrScopedPerfTimer(const ovrScopedPerfTimer&) = delete;
+    ovrScopedPerfTimer& operator=(const ovrScopedPerfTimer&) = delete;
+
+   private:
+    const char* Name;
+    double StartTime; // negative if the timers were disabled when the scope started
+};
+
+} // namespace OVRFW
+
+#define OVR_PERF_TIMER_CONCAT_(a, b) a##b
+#define OVR_PERF_TIMER_CONCAT(a, b) OVR_PERF_TIMER_CONCAT_(a, b)
+
+// Times the rest of the enclosing scope under the given name, for example:
+//     OVR_PERF_TIMER( LoadTexture_FromFile );
+#define OVR_PERF_TIMER(name) \
+    OVRFW::ovrScopedPerfTimer OVR_PERF_TIMER_CONCAT(perfTimer_, __LINE__)(#name)
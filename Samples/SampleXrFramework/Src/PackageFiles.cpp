@@ -29,6 +29,7 @@ Authors     :   John Carmack
 
 #include "Misc/Log.h"
 #include "OVR_Std.h"
+#include "OVR_MappedFile.h"
 
 #include <unzip.h>
 
@@ -36,12 +37,20 @@ Authors     :   John Carmack
 #include <fcntl.h>
 
 #if !defined(OVR_OS_WIN32)
+#include <dirent.h>
 #include <unistd.h>
 #endif
 
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <cstring>
+#include <ctype.h>
 #include <thread>
 #include <mutex>
 #include <functional>
+#include <string>
+#include <unordered_map>
 
 namespace OVRFW {
 
@@ -62,8 +71,832 @@ OvrApkFile::~OvrApkFile() {
 // Functions for reading assets from other application packages
 //--------------------------------------------------------------
 
+// Central directory entry of a file in a package.
+struct ovrPackageEntry {
+    uint64_t localHeaderOffset = 0;
+    uint64_t compressedSize = 0;
+    uint64_t uncompressedSize = 0;
+    uint32_t crc = 0;
+    uint16_t method = 0;
+};
+
+// Hashed index of a package's central directory, built once when the package is opened.
+// Files are read with pread on a private descriptor and inflated by the calling thread, so
+// concurrent reads don't need a lock.
+class ovrPackageIndex {
+   public:
+    ovrPackageIndex() : Fd(-1) {}
+    ~ovrPackageIndex();
+
+    bool Open(const char* path);
+
+    const std::string& GetPath() const {
+        return Path;
+    }
+
+    // The lookup is case insensitive like unzLocateFile.
+    const ovrPackageEntry* Find(const char* nameInZip) const;
+
+    bool GetDataOffset(const ovrPackageEntry& entry, uint64_t& offset) const;
+
+    // Reads and, if needed, inflates the entry into a buffer of entry.uncompressedSize bytes.
+    bool ReadData(const ovrPackageEntry& entry, void* buffer) const;
+
+   private:
+    bool ReadAt(void* buffer, const size_t size, const uint64_t offset) const;
+
+    std::string Path;
+    int Fd;
+    std::unordered_map<std::string, ovrPackageEntry> Entries;
+};
+
+static const uint32_t ZIP_LOCAL_HEADER_SIGNATURE = 0x04034b50;
+static const uint32_t ZIP_CENTRAL_HEADER_SIGNATURE = 0x02014b50;
+static const uint32_t ZIP_END_OF_DIRECTORY_SIGNATURE = 0x06054b50;
+static const uint32_t ZIP64_END_OF_DIRECTORY_SIGNATURE = 0x06064b50;
+static const uint32_t ZIP64_END_OF_DIRECTORY_LOCATOR_SIGNATURE = 0x07064b50;
+static const int ZIP_LOCAL_HEADER_SIZE = 30;
+static const int ZIP_CENTRAL_HEADER_SIZE = 46;
+static const int ZIP_END_OF_DIRECTORY_SIZE = 22;
+static const int ZIP64_END_OF_DIRECTORY_SIZE = 56;
+static const int ZIP64_END_OF_DIRECTORY_LOCATOR_SIZE = 20;
+static const int ZIP_MAX_COMMENT_SIZE = 0xFFFF;
+
+static uint16_t ReadLE16(const uint8_t* p) {
+    return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+static uint32_t ReadLE32(const uint8_t* p) {
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+        (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+static uint64_t ReadLE64(const uint8_t* p) {
+    return static_cast<uint64_t>(ReadLE32(p)) | (static_cast<uint64_t>(ReadLE32(p + 4)) << 32);
+}
+
+static std::string PackageEntryKey(std::string key) {
+    for (char& c : key) {
+        c = static_cast<char>(tolower(static_cast<unsigned char>(c)));
+    }
+    return key;
+}
+
+ovrPackageIndex::~ovrPackageIndex() {
+#if !defined(OVR_OS_WIN32)
+    if (Fd >= 0) {
+        close(Fd);
+    }
+#endif
+}
+
+bool ovrPackageIndex::ReadAt(void* buffer, const size_t size, const uint64_t offset) const {
+#if !defined(OVR_OS_WIN32)
+    uint8_t* dst = static_cast<uint8_t*>(buffer);
+    size_t done = 0;
+    while (done < size) {
+        const ssize_t r = pread(Fd, dst + done, size - done, static_cast<off_t>(offset + done));
+        if (r <= 0) {
+            return false;
+        }
+        done += static_cast<size_t>(r);
+    }
+    return true;
+#else
+    return false;
+#endif // !defined(OVR_OS_WIN32)
+}
+
+bool ovrPackageIndex::Open(const char* path) {
+#if !defined(OVR_OS_WIN32)
+    Path = path;
+    Fd = open(path, O_RDONLY);
+    if (Fd < 0) {
+        return false;
+    }
+    struct stat s = {};
+    if (fstat(Fd, &s) == -1 || s.st_size < ZIP_END_OF_DIRECTORY_SIZE) {
+        return false;
+    }
+    const uint64_t fileSize = static_cast<uint64_t>(s.st_size);
+
+    // The end of central directory record is followed by a comment of up to 64k.
+    const uint64_t tailSize = std::min<uint64_t>(
+        fileSize, ZIP_END_OF_DIRECTORY_SIZE + ZIP_MAX_COMMENT_SIZE);
+    std::vector<uint8_t> tail(tailSize);
+    if (!ReadAt(tail.data(), tail.size(), fileSize - tailSize)) {
+        return false;
+    }
+    int64_t eocd = -1;
+    for (int64_t i = static_cast<int64_t>(tailSize) - ZIP_END_OF_DIRECTORY_SIZE; i >= 0; i--) {
+        if (ReadLE32(&tail[i]) == ZIP_END_OF_DIRECTORY_SIGNATURE) {
+            eocd = i;
+            break;
+        }
+    }
+    if (eocd < 0) {
+        ALOGW("No central directory found in '%s'", path);
+        return false;
+    }
+
+    uint64_t numEntries = ReadLE16(&tail[eocd + 10]);
+    uint64_t directorySize = ReadLE32(&tail[eocd + 12]);
+    uint64_t directoryOffset = ReadLE32(&tail[eocd + 16]);
+
+    // Packages with too many entries or too large to describe use the zip64 record instead.
+    if (numEntries == 0xFFFF || directorySize == 0xFFFFFFFF || directoryOffset == 0xFFFFFFFF) {
+        const uint64_t eocdOffset = fileSize - tailSize + eocd;
+        uint8_t locator[ZIP64_END_OF_DIRECTORY_LOCATOR_SIZE];
+        uint8_t record[ZIP64_END_OF_DIRECTORY_SIZE];
+        if (eocdOffset < sizeof(locator) ||
+            !ReadAt(locator, sizeof(locator), eocdOffset - sizeof(locator)) ||
+            ReadLE32(locator) != ZIP64_END_OF_DIRECTORY_LOCATOR_SIGNATURE ||
+            !ReadAt(record, sizeof(record), ReadLE64(locator + 8)) ||
+            ReadLE32(record) != ZIP64_END_OF_DIRECTORY_SIGNATURE) {
+            ALOGW("Bad zip64 central directory in '%s'", path);
+            return false;
+        }
+        numEntries = ReadLE64(record + 32);
+        directorySize = ReadLE64(record + 40);
+        directoryOffset = ReadLE64(record + 48);
+    }
+    if (directoryOffset + directorySize > fileSize) {
+        ALOGW("Bad central directory in '%s'", path);
+        return false;
+    }
+
+    std::vector<uint8_t> directory(directorySize);
+    if (!ReadAt(directory.data(), directory.size(), directoryOffset)) {
+        return false;
+    }
+
+    Entries.reserve(numEntries);
+    const uint8_t* p = directory.data();
+    const uint8_t* end = p + directory.size();
+    for (uint64_t i = 0; i < numEntries; i++) {
+        if (end - p < ZIP_CENTRAL_HEADER_SIZE || ReadLE32(p) != ZIP_CENTRAL_HEADER_SIGNATURE) {
+            ALOGW("Bad central directory entry %d in '%s'", static_cast<int>(i), path);
+            return false;
+        }
+        const int nameLength = ReadLE16(p + 28);
+        const int extraLength = ReadLE16(p + 30);
+        const int commentLength = ReadLE16(p + 32);
+        if (end - p < ZIP_CENTRAL_HEADER_SIZE + nameLength + extraLength + commentLength) {
+            ALOGW("Truncated central directory in '%s'", path);
+            return false;
+        }
+
+        ovrPackageEntry entry;
+        entry.method = ReadLE16(p + 10);
+        entry.crc = ReadLE32(p + 16);
+        entry.compressedSize = ReadLE32(p + 20);
+        entry.uncompressedSize = ReadLE32(p + 24);
+        entry.localHeaderOffset = ReadLE32(p + 42);
+
+        // Sizes and offsets that don't fit in 32 bits are in the zip64 extra field, in order.
+        const uint8_t* extra = p + ZIP_CENTRAL_HEADER_SIZE + nameLength;
+        const uint8_t* extraEnd = extra + extraLength;
+        while (extraEnd - extra >= 4) {
+            const uint16_t id = ReadLE16(extra);
+            const uint16_t size = ReadLE16(extra + 2);
+            const uint8_t* field = extra + 4;
+            const uint8_t* fieldEnd = std::min(field + size, extraEnd);
+            if (id == 0x0001) {
+                uint64_t* values[3] = {
+                    &entry.uncompressedSize, &entry.compressedSize, &entry.localHeaderOffset};
+                for (uint64_t* value : values) {
+                    if (*value == 0xFFFFFFFF && fieldEnd - field >= 8) {
+                        *value = ReadLE64(field);
+                        field += 8;
+                    }
+                }
+            }
+            extra = fieldEnd;
+        }
+
+        const char* name = reinterpret_cast<const char*>(p + ZIP_CENTRAL_HEADER_SIZE);
+        // Keep the first of any names that only differ in case, like unzLocateFile.
+        Entries.emplace(PackageEntryKey(std::string(name, nameLength)), entry);
+
+        p += ZIP_CENTRAL_HEADER_SIZE + nameLength + extraLength + commentLength;
+    }
+    return true;
+#else
+    // No equivalent of other application package on windows.
+    OVR_UNUSED(path);
+    return false;
+#endif // !defined(OVR_OS_WIN32)
+}
+
+const ovrPackageEntry* ovrPackageIndex::Find(const char* nameInZip) const {
+    auto it = Entries.find(PackageEntryKey(nameInZip));
+    return (it != Entries.end()) ? &it->second : nullptr;
+}
+
+bool ovrPackageIndex::GetDataOffset(const ovrPackageEntry& entry, uint64_t& offset) const {
+    // The local header can have a different extra field than the central directory.
+    uint8_t header[ZIP_LOCAL_HEADER_SIZE];
+    if (!ReadAt(header, sizeof(header), entry.localHeaderOffset) ||
+        ReadLE32(header) != ZIP_LOCAL_HEADER_SIGNATURE) {
+        return false;
+    }
+    offset = entry.localHeaderOffset + ZIP_LOCAL_HEADER_SIZE + ReadLE16(header + 26) +
+        ReadLE16(header + 28);
+    return true;
+}
+
+bool ovrPackageIndex::ReadData(const ovrPackageEntry& entry, void* buffer) const {
+    uint64_t offset = 0;
+    if (!GetDataOffset(entry, offset)) {
+        return false;
+    }
+
+    if (entry.method == 0) {
+        if (entry.compressedSize != entry.uncompressedSize) {
+            return false;
+        }
+        return ReadAt(buffer, static_cast<size_t>(entry.uncompressedSize), offset);
+    }
+
+    if (entry.method != Z_DEFLATED) {
+        return false;
+    }
+
+    // Inflate the raw deflate stream in chunks, so the compressed data is never fully resident.
+    static const size_t CHUNK_SIZE = 32 * 1024;
+    uint8_t chunk[CHUNK_SIZE];
+
+    z_stream stream = {};
+    if (inflateInit2(&stream, -MAX_WBITS) != Z_OK) {
+        return false;
+    }
+    stream.next_out = static_cast<Bytef*>(buffer);
+    stream.avail_out = static_cast<uInt>(entry.uncompressedSize);
+
+    uint64_t remaining = entry.compressedSize;
+    int ret = Z_OK;
+    while (ret == Z_OK && remaining > 0) {
+        const size_t size = static_cast<size_t>(std::min<uint64_t>(remaining, CHUNK_SIZE));
+        if (!ReadAt(chunk, size, offset)) {
+            break;
+        }
+        offset += size;
+        remaining -= size;
+        stream.next_in = chunk;
+        stream.avail_in = static_cast<uInt>(size);
+        ret = inflate(&stream, (remaining == 0) ? Z_FINISH : Z_NO_FLUSH);
+        if (ret == Z_BUF_ERROR && stream.avail_out != 0) {
+            ret = Z_OK; // needs more input
+        }
+    }
+    const bool ok = (ret == Z_STREAM_END && stream.total_out == entry.uncompressedSize);
+    inflateEnd(&stream);
+    return ok;
+}
+
+// Indices of the open packages, keyed by their unzip handle.
+static std::mutex PackageIndicesMutex;
+static std::unordered_map<void*, std::shared_ptr<const ovrPackageIndex>> PackageIndices;
+
+static std::shared_ptr<const ovrPackageIndex> FindPackageIndex(void* zipFile) {
+    std::lock_guard<std::mutex> mutex(PackageIndicesMutex);
+    auto it = PackageIndices.find(zipFile);
+    return (it != PackageIndices.end()) ? it->second : nullptr;
+}
+
+// Packages without an index, such as all packages on Windows, are read through their unzip
+// handle, which has a single current file, so these reads are serialized.
+static std::mutex PackageFileMutex;
+
+static bool UnzipFileExists(void* zipFile, const char* nameInZip) {
+    std::lock_guard<std::mutex> mutex(PackageFileMutex);
+
+    const int locateRet = unzLocateFile(zipFile, nameInZip, 2 /* case insensitive */);
+    if (locateRet != UNZ_OK) {
+        return false;
+    }
+
+    const int openRet = unzOpenCurrentFile(zipFile);
+    if (openRet != UNZ_OK) {
+        ALOGW("Error opening file '%s' from apk!", nameInZip);
+        return false;
+    }
+
+    unzCloseCurrentFile(zipFile);
+
+    return true;
+}
+
+static bool UnzipReadFile(
+    void* zipFile,
+    const char* nameInZip,
+    int& length,
+    void*& buffer,
+    const std::function<void*(const size_t size)>& allocBuffer,
+    const std::function<void(void* buffer)>& freeBuffer) {
+    std::lock_guard<std::mutex> mutex(PackageFileMutex);
+
+    const int locateRet = unzLocateFile(zipFile, nameInZip, 2 /* case insensitive */);
+    if (locateRet != UNZ_OK) {
+        ALOG("File '%s' not found in apk!", nameInZip);
+        return false;
+    }
+
+    unz_file_info info;
+    const int getRet = unzGetCurrentFileInfo(zipFile, &info, nullptr, 0, nullptr, 0, nullptr, 0);
+    if (getRet != UNZ_OK) {
+        ALOGW("File info error reading '%s' from apk!", nameInZip);
+        return false;
+    }
+    if (info.uncompressed_size > static_cast<uLong>(INT_MAX)) {
+        ALOGW("File '%s' is too large to read from apk!", nameInZip);
+        return false;
+    }
+
+    const int openRet = unzOpenCurrentFile(zipFile);
+    if (openRet != UNZ_OK) {
+        ALOGW("Error opening file '%s' from apk!", nameInZip);
+        return false;
+    }
+
+    length = static_cast<int>(info.uncompressed_size);
+    buffer = allocBuffer(length);
+
+    const int readRet = unzReadCurrentFile(zipFile, buffer, length);
+    unzCloseCurrentFile(zipFile);
+    if (readRet != length) {
+        ALOGW("Error reading file '%s' from apk!", nameInZip);
+        freeBuffer(buffer);
+        length = 0;
+        buffer = nullptr;
+        return false;
+    }
+
+    return true;
+}
+
+struct ovrMappedPackageFile {
+    MappedFile File;
+    MappedView View;
+};
+
+//--------------------------------------------------------------
+// Extraction cache
+//--------------------------------------------------------------
+
+// Compressed files are extracted to CachePath under a name made from their CRC and size, so
+// identical files share an entry across packages and package versions. A manifest records the
+// size and last use of each entry, and the least recently used entries are evicted to keep the
+// cache within its budget. The use order is saved whenever the manifest is rewritten for an
+// addition or eviction. Cached files are checked against the CRC the first time they are used
+// in a session. Files the application derives and writes to CachePath can be added to the
+// manifest, so they count against the same budget.
+class ovrPackageCache {
+   public:
+    ovrPackageCache()
+        : Budget(DEFAULT_BUDGET), TotalSize(0), UseCounter(0), Loaded(false), Cancel(false) {}
+    ~ovrPackageCache();
+
+    void SetBudget(const size_t maxBytes);
+
+    bool Read(
+        const ovrPackageEntry& entry,
+        int& length,
+        void*& buffer,
+        const std::function<void*(const size_t size)>& allocBuffer,
+        const std::function<void(void* buffer)>& freeBuffer);
+    std::shared_ptr<const void>
+    Map(const ovrPackageEntry& entry, const uint8_t*& data, size_t& length);
+    void Write(const ovrPackageEntry& entry, const void* buffer, const char* nameInZip);
+
+    // Files written to the cache path by the application, see ovr_AddApplicationCacheFile.
+    static std::string GetFileName(const std::string& key);
+    void AddFile(const std::string& name);
+    bool UseFile(const std::string& name);
+
+    void Prefetch(
+        const std::shared_ptr<const ovrPackageIndex>& index,
+        const std::vector<std::string>& namesInZip);
+    void WaitForPrefetch();
+
+   private:
+    static const size_t DEFAULT_BUDGET = 256 * 1024 * 1024;
+
+    struct ovrCacheItem {
+        uint64_t size;
+        uint64_t lastUse;
+        bool verified; // CRC checked this session
+    };
+
+    static std::string GetKey(const ovrPackageEntry& entry);
+
+    // These must be called with the mutex locked.
+    void LoadManifest();
+    void RemoveLegacyFiles();
+    void SaveManifest();
+    ovrCacheItem* Touch(const std::string& key);
+    void Remove(const std::string& key);
+    void Evict(const std::string& keep);
+
+    // Returns false and removes the file if the contents don't match the entry.
+    bool Verify(const std::string& key, const ovrPackageEntry& entry, const void* data);
+
+    std::mutex Mutex;
+    size_t Budget;
+    uint64_t TotalSize;
+    uint64_t UseCounter;
+    bool Loaded;
+    std::unordered_map<std::string, ovrCacheItem> Items;
+
+    std::thread PrefetchThread;
+    std::atomic<bool> Cancel;
+};
+
+static ovrPackageCache PackageCache;
+
+ovrPackageCache::~ovrPackageCache() {
+    Cancel = true;
+    WaitForPrefetch();
+}
+
+std::string ovrPackageCache::GetKey(const ovrPackageEntry& entry) {
+    char key[64];
+    snprintf(
+        key,
+        sizeof(key),
+        "%08x-%llx",
+        (unsigned)entry.crc,
+        (unsigned long long)entry.uncompressedSize);
+    return key;
+}
+
+std::string ovrPackageCache::GetFileName(const std::string& key) {
+    return std::string(CachePath) + "/" + key + ".bin";
+}
+
+void ovrPackageCache::LoadManifest() {
+    if (Loaded) {
+        return;
+    }
+    Loaded = true;
+
+    const std::string manifestName = std::string(CachePath) + "/manifest.txt";
+    FILE* f = fopen(manifestName.c_str(), "r");
+    if (f == nullptr) {
+        RemoveLegacyFiles();
+        return;
+    }
+    char key[64];
+    unsigned long long size = 0;
+    unsigned long long lastUse = 0;
+    while (fscanf(f, "%63s %llu %llu", key, &size, &lastUse) == 3) {
+        // Drop entries whose file went missing or was truncated.
+        struct stat s = {};
+        if (stat(GetFileName(key).c_str(), &s) == -1 || (uint64_t)s.st_size != size) {
+            continue;
+        }
+        Items[key] = {size, lastUse, false};
+        TotalSize += size;
+        UseCounter = std::max<uint64_t>(UseCounter, lastUse);
+    }
+    fclose(f);
+}
+
+// Before the manifest, cache files were named after the CRC alone. Nothing reads them anymore
+// and they would never be evicted.
+void ovrPackageCache::RemoveLegacyFiles() {
+#if !defined(OVR_OS_WIN32)
+    DIR* dir = opendir(CachePath);
+    if (dir == nullptr) {
+        return;
+    }
+    while (const struct dirent* entry = readdir(dir)) {
+        const char* name = entry->d_name;
+        if (strlen(name) != 12 ||
+            (strcmp(name + 8, ".bin") != 0 && strcmp(name + 8, ".tmp") != 0)) {
+            continue;
+        }
+        bool hex = true;
+        for (int i = 0; i < 8; i++) {
+            hex = hex && isxdigit(static_cast<unsigned char>(name[i]));
+        }
+        if (hex) {
+            ALOG("Removing legacy cache file %s", name);
+            unlink((std::string(CachePath) + "/" + name).c_str());
+        }
+    }
+    closedir(dir);
+#endif // !defined(OVR_OS_WIN32)
+}
+
+void ovrPackageCache::SaveManifest() {
+    const std::string manifestName = std::string(CachePath) + "/manifest.txt";
+    const std::string tempName = manifestName + ".tmp";
+    FILE* f = fopen(tempName.c_str(), "w");
+    if (f == nullptr) {
+        ALOG("Failed to write cache manifest %s", tempName.c_str());
+        return;
+    }
+    for (const auto& it : Items) {
+        fprintf(
+            f,
+            "%s %llu %llu\n",
+            it.first.c_str(),
+            (unsigned long long)it.second.size,
+            (unsigned long long)it.second.lastUse);
+    }
+    fclose(f);
+    if (rename(tempName.c_str(), manifestName.c_str()) == -1) {
+        ALOG("Failed to rename cache manifest %s", tempName.c_str());
+    }
+}
+
+ovrPackageCache::ovrCacheItem* ovrPackageCache::Touch(const std::string& key) {
+    LoadManifest();
+    auto it = Items.find(key);
+    if (it == Items.end()) {
+        return nullptr;
+    }
+    it->second.lastUse = ++UseCounter;
+    return &it->second;
+}
+
+void ovrPackageCache::Remove(const std::string& key) {
+    // key may be the key of the item, which erasing it frees
+    const std::string fileName = GetFileName(key);
+    auto it = Items.find(key);
+    if (it != Items.end()) {
+        TotalSize -= it->second.size;
+        Items.erase(it);
+    }
+#if !defined(OVR_OS_WIN32)
+    unlink(fileName.c_str());
+#endif // !defined(OVR_OS_WIN32)
+}
+
+void ovrPackageCache::Evict(const std::string& keep) {
+    while (TotalSize > Budget && !Items.empty()) {
+        auto oldest = Items.end();
+        for (auto it = Items.begin(); it != Items.end(); ++it) {
+            if (it->first != keep &&
+                (oldest == Items.end() || it->second.lastUse < oldest->second.lastUse)) {
+                oldest = it;
+            }
+        }
+        if (oldest == Items.end()) {
+            break;
+        }
+        ALOG("Evicting cache file %s", oldest->first.c_str());
+        Remove(oldest->first);
+    }
+}
+
+void ovrPackageCache::SetBudget(const size_t maxBytes) {
+    std::lock_guard<std::mutex> mutex(Mutex);
+    Budget = maxBytes;
+    if (CachePath[0]) {
+        LoadManifest();
+        Evict(std::string());
+        SaveManifest();
+    }
+}
+
+bool ovrPackageCache::Verify(
+    const std::string& key,
+    const ovrPackageEntry& entry,
+    const void* data) {
+    {
+        std::lock_guard<std::mutex> mutex(Mutex);
+        auto it = Items.find(key);
+        if (it != Items.end() && it->second.verified) {
+            return true;
+        }
+    }
+    const uLong crc = crc32(
+        crc32(0L, Z_NULL, 0), static_cast<const Bytef*>(data), (uInt)entry.uncompressedSize);
+    std::lock_guard<std::mutex> mutex(Mutex);
+    if (crc != entry.crc) {
+        ALOG("Cache file %s failed CRC check", key.c_str());
+        Remove(key);
+        SaveManifest();
+        return false;
+    }
+    auto it = Items.find(key);
+    if (it != Items.end()) {
+        it->second.verified = true;
+    }
+    return true;
+}
+
+bool ovrPackageCache::Read(
+    const ovrPackageEntry& entry,
+    int& length,
+    void*& buffer,
+    const std::function<void*(const size_t size)>& allocBuffer,
+    const std::function<void(void* buffer)>& freeBuffer) {
+#if !defined(OVR_OS_WIN32)
+    if (!CachePath[0]) {
+        return false;
+    }
+    const std::string key = GetKey(entry);
+    {
+        std::lock_guard<std::mutex> mutex(Mutex);
+        if (Touch(key) == nullptr) {
+            return false;
+        }
+    }
+
+    const int fd = open(GetFileName(key).c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::lock_guard<std::mutex> mutex(Mutex);
+        Remove(key);
+        return false;
+    }
+    length = (int)entry.uncompressedSize;
+    buffer = allocBuffer(length);
+    const int r = read(fd, buffer, length);
+    close(fd);
+    if (r != length) {
+        ALOG("Cache file %s only read %i != %i", key.c_str(), r, length);
+    }
+    if (r != length || !Verify(key, entry, buffer)) {
+        freeBuffer(buffer);
+        length = 0;
+        buffer = nullptr;
+        return false;
+    }
+    return true;
+#else
+    return false;
+#endif // !defined(OVR_OS_WIN32)
+}
+
+std::shared_ptr<const void>
+ovrPackageCache::Map(const ovrPackageEntry& entry, const uint8_t*& data, size_t& length) {
+    if (!CachePath[0] || entry.uncompressedSize == 0 || entry.uncompressedSize > UINT32_MAX) {
+        return nullptr;
+    }
+    const std::string key = GetKey(entry);
+    {
+        std::lock_guard<std::mutex> mutex(Mutex);
+        if (Touch(key) == nullptr) {
+            return nullptr;
+        }
+    }
+
+    auto mapped = std::make_shared<ovrMappedPackageFile>();
+    if (!mapped->File.OpenRead(GetFileName(key).c_str()) || !mapped->View.Open(&mapped->File) ||
+        mapped->View.MapView(0, (uint32_t)entry.uncompressedSize) == nullptr) {
+        return nullptr;
+    }
+    if (!Verify(key, entry, mapped->View.GetFront())) {
+        return nullptr;
+    }
+    data = mapped->View.GetFront();
+    length = (size_t)entry.uncompressedSize;
+    return mapped;
+}
+
+void ovrPackageCache::Write(
+    const ovrPackageEntry& entry,
+    const void* buffer,
+    const char* nameInZip) {
+#if !defined(OVR_OS_WIN32)
+    if (!CachePath[0] || entry.uncompressedSize > Budget) {
+        return;
+    }
+    const std::string key = GetKey(entry);
+    {
+        std::lock_guard<std::mutex> mutex(Mutex);
+        if (Touch(key) != nullptr) {
+            return; // already cached by another reader
+        }
+    }
+
+    const uLong crc = crc32(
+        crc32(0L, Z_NULL, 0), static_cast<const Bytef*>(buffer), (uInt)entry.uncompressedSize);
+    if (crc != entry.crc) {
+        ALOG("Not caching %s, CRC mismatch", nameInZip);
+        return;
+    }
+
+    // Concurrent writers of the same file each use their own temporary file.
+    static std::atomic<int> tempCounter(0);
+    const std::string tempName = std::string(CachePath) + "/" + key + "." +
+        std::to_string(getpid()) + "." + std::to_string(tempCounter++) + ".tmp";
+    const std::string cacheName = GetFileName(key);
+    const int length = (int)entry.uncompressedSize;
+
+    const int fd = open(tempName.c_str(), O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR);
+    if (fd < 0) {
+        ALOG("Failed to open new cache file for %s: %s", nameInZip, tempName.c_str());
+        return;
+    }
+    const int r = write(fd, buffer, length);
+    close(fd);
+    if (r != length) {
+        ALOG("Only wrote %i of %i for cached %s", r, length, nameInZip);
+        unlink(tempName.c_str());
+        return;
+    }
+    if (rename(tempName.c_str(), cacheName.c_str()) == -1) {
+        ALOG("Failed to rename cache file for %s", nameInZip);
+        unlink(tempName.c_str());
+        return;
+    }
+    ALOG("Cache file generated for %s", nameInZip);
+
+    std::lock_guard<std::mutex> mutex(Mutex);
+    LoadManifest();
+    if (Items.find(key) == Items.end()) {
+        Items[key] = {entry.uncompressedSize, ++UseCounter, true};
+        TotalSize += entry.uncompressedSize;
+    }
+    Evict(key);
+    SaveManifest();
+#else
+    OVR_UNUSED(entry);
+    OVR_UNUSED(buffer);
+    OVR_UNUSED(nameInZip);
+#endif // !defined(OVR_OS_WIN32)
+}
+
+void ovrPackageCache::AddFile(const std::string& name) {
+    struct stat s = {};
+    if (!CachePath[0] || stat(GetFileName(name).c_str(), &s) == -1) {
+        return;
+    }
+    std::lock_guard<std::mutex> mutex(Mutex);
+    LoadManifest();
+    auto it = Items.find(name);
+    if (it != Items.end()) {
+        TotalSize -= it->second.size;
+    }
+    Items[name] = {(uint64_t)s.st_size, ++UseCounter, true};
+    TotalSize += s.st_size;
+    Evict(name);
+    SaveManifest();
+}
+
+bool ovrPackageCache::UseFile(const std::string& name) {
+    if (!CachePath[0]) {
+        return false;
+    }
+    std::lock_guard<std::mutex> mutex(Mutex);
+    return Touch(name) != nullptr;
+}
+
+void ovrPackageCache::Prefetch(
+    const std::shared_ptr<const ovrPackageIndex>& index,
+    const std::vector<std::string>& namesInZip) {
+    WaitForPrefetch();
+    if (index == nullptr || !CachePath[0]) {
+        return;
+    }
+    Cancel = false;
+    PrefetchThread = std::thread([this, index, namesInZip]() {
+        std::vector<uint8_t> buffer;
+        for (const std::string& name : namesInZip) {
+            if (Cancel) {
+                break;
+            }
+            // Stored files don't need the cache, they are read or mapped in place.
+            const ovrPackageEntry* entry = index->Find(name.c_str());
+            if (entry == nullptr || entry->method == 0 ||
+                entry->uncompressedSize > static_cast<uint64_t>(INT_MAX)) {
+                continue;
+            }
+            {
+                std::lock_guard<std::mutex> mutex(Mutex);
+                if (Touch(GetKey(*entry)) != nullptr) {
+                    continue;
+                }
+            }
+            buffer.resize((size_t)entry->uncompressedSize);
+            if (!index->ReadData(*entry, buffer.data())) {
+                ALOGW("Error prefetching file '%s' from apk!", name.c_str());
+                continue;
+            }
+            Write(*entry, buffer.data(), name.c_str());
+        }
+    });
+}
+
+void ovrPackageCache::WaitForPrefetch() {
+    if (PrefetchThread.joinable()) {
+        PrefetchThread.join();
+    }
+}
+
 void* ovr_OpenOtherApplicationPackage(const char* packageCodePath) {
     void* zipFile = unzOpen(packageCodePath);
+    if (zipFile != nullptr) {
+        auto index = std::make_shared<ovrPackageIndex>();
+        if (index->Open(packageCodePath)) {
+            std::lock_guard<std::mutex> mutex(PackageIndicesMutex);
+            PackageIndices[zipFile] = index;
+        }
+    }
 
 // enable the following block if you need to see the list of files in the application package
 // This is useful for finding a file added in one of the res/ sub-folders (necesary if you want
@@ -91,29 +924,25 @@ void ovr_CloseOtherApplicationPackage(void*& zipFile) {
     if (zipFile == nullptr) {
         return;
     }
+    {
+        std::lock_guard<std::mutex> mutex(PackageIndicesMutex);
+        PackageIndices.erase(zipFile);
+    }
     unzClose(zipFile);
     zipFile = nullptr;
 }
 
-static std::mutex PackageFileMutex;
-
 bool ovr_OtherPackageFileExists(void* zipFile, const char* nameInZip) {
-    std::lock_guard<std::mutex> mutex(PackageFileMutex);
-
-    const int locateRet = unzLocateFile(zipFile, nameInZip, 2 /* case insensitive */);
-    if (locateRet != UNZ_OK) {
-        ALOG("File '%s' not found in apk!", nameInZip);
+    if (zipFile == nullptr) {
         return false;
     }
-
-    const int openRet = unzOpenCurrentFile(zipFile);
-    if (openRet != UNZ_OK) {
-        ALOGW("Error opening file '%s' from apk!", nameInZip);
+    auto index = FindPackageIndex(zipFile);
+    const bool exists = (index != nullptr) ? (index->Find(nameInZip) != nullptr)
+                                           : UnzipFileExists(zipFile, nameInZip);
+    if (!exists) {
+        ALOG("File '%s' not found in apk!", nameInZip);
         return false;
     }
-
-    unzCloseCurrentFile(zipFile);
-
     return true;
 }
 
@@ -130,73 +959,34 @@ static bool ovr_ReadFileFromOtherApplicationPackageInternal(
         return false;
     }
 
-#if !defined(OVR_OS_WIN32)
-    std::lock_guard<std::mutex> mutex(PackageFileMutex);
-
-    const int locateRet = unzLocateFile(zipFile, nameInZip, 2 /* case insensitive */);
+    auto index = FindPackageIndex(zipFile);
+    if (index == nullptr) {
+        return UnzipReadFile(zipFile, nameInZip, length, buffer, allocBuffer, freeBuffer);
+    }
 
-    if (locateRet != UNZ_OK) {
+#if !defined(OVR_OS_WIN32)
+    const ovrPackageEntry* entry = index->Find(nameInZip);
+    if (entry == nullptr) {
         ALOG("File '%s' not found in apk!", nameInZip);
         return false;
     }
 
-    unz_file_info info;
-    const int getRet = unzGetCurrentFileInfo(zipFile, &info, nullptr, 0, nullptr, 0, nullptr, 0);
-
-    if (getRet != UNZ_OK) {
-        ALOGW("File info error reading '%s' from apk!", nameInZip);
+    if (entry->uncompressedSize > static_cast<uint64_t>(INT_MAX)) {
+        ALOGW("File '%s' is too large to read from apk!", nameInZip);
         return false;
     }
 
-    // Check for an already extracted cache file based on the CRC if
-    // the file is compressed.
-    if (info.compression_method != 0 && CachePath[0]) {
-        char cacheName[1024];
-        snprintf(cacheName, sizeof(cacheName), "%s/%08x.bin", CachePath, (unsigned)info.crc);
-        const int fd = open(cacheName, O_RDONLY);
-        if (fd > 0) {
-            struct stat s = {};
-
-            if (fstat(fd, &s) != -1) {
-                //				LOG( "Loading cached file for: %s", nameInZip );
-                length = s.st_size;
-                if (length != (int)info.uncompressed_size) {
-                    ALOG(
-                        "Cached file for %s has length %i != %lu",
-                        nameInZip,
-                        length,
-                        info.uncompressed_size);
-                    // Fall through to normal load.
-                } else {
-                    buffer = allocBuffer(length);
-                    const int r = read(fd, buffer, length);
-                    close(fd);
-                    if (r != length) {
-                        ALOG("Cached file for %s only read %i != %i", nameInZip, r, length);
-                        freeBuffer(buffer);
-                        // Fall through to normal load.
-                    } else { // Got the cached file.
-                        return true;
-                    }
-                }
-            }
-            close(fd);
-        }
-    } else {
-        //		LOG( "Not compressed: %s", nameInZip );
-    }
-
-    const int openRet = unzOpenCurrentFile(zipFile);
-    if (openRet != UNZ_OK) {
-        ALOGW("Error opening file '%s' from apk!", nameInZip);
-        return false;
+    // Check for an already extracted cache file if the file is compressed.
+    if (entry->method != 0 &&
+        PackageCache.Read(*entry, length, buffer, allocBuffer, freeBuffer)) {
+        return true;
     }
 
-    length = info.uncompressed_size;
+    // Stored files are read and deflated files are inflated on this thread, without a lock.
+    length = (int)entry->uncompressedSize;
     buffer = allocBuffer(length);
 
-    const int readRet = unzReadCurrentFile(zipFile, buffer, length);
-    if (readRet != length) {
+    if (!index->ReadData(*entry, buffer)) {
         ALOGW("Error reading file '%s' from apk!", nameInZip);
         freeBuffer(buffer);
         length = 0;
@@ -204,36 +994,14 @@ static bool ovr_ReadFileFromOtherApplicationPackageInternal(
         return false;
     }
 
-    unzCloseCurrentFile(zipFile);
-
     // Optionally write out to the cache directory
-    if (info.compression_method != 0 && CachePath[0]) {
-        char tempName[1024];
-        snprintf(tempName, sizeof(tempName), "%s/%08x.tmp", CachePath, (unsigned)info.crc);
-
-        char cacheName[1024];
-        snprintf(cacheName, sizeof(cacheName), "%s/%08x.bin", CachePath, (unsigned)info.crc);
-        const int fd = open(tempName, O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR);
-        if (fd > 0) {
-            const int r = write(fd, buffer, length);
-            close(fd);
-            if (r == length) {
-                if (rename(tempName, cacheName) == -1) {
-                    ALOG("Failed to rename cache file for %s", nameInZip);
-                } else {
-                    ALOG("Cache file generated for %s", nameInZip);
-                }
-            } else {
-                ALOG("Only wrote %i of %i for cached %s", r, length, nameInZip);
-            }
-        } else {
-            ALOG("Failed to open new cache file for %s: %s", nameInZip, tempName);
-        }
+    if (entry->method != 0) {
+        PackageCache.Write(*entry, buffer, nameInZip);
     }
 
     return true;
 #else
-    // No equivalent of other application package on windows.
+    // The index is never built on windows.
     return false;
 #endif // !defined(OVR_OS_WIN32)
 }
@@ -272,6 +1040,60 @@ bool ovr_ReadFileFromOtherApplicationPackage(
         zipFile, nameInZip, length, buffer, allocBuffer, freeBuffer);
 }
 
+std::shared_ptr<const void> ovr_MapFileFromOtherApplicationPackage(
+    void* zipFile,
+    const char* nameInZip,
+    const uint8_t*& data,
+    size_t& length) {
+    data = nullptr;
+    length = 0;
+    if (zipFile == nullptr) {
+        return nullptr;
+    }
+
+#if !defined(OVR_OS_WIN32)
+    auto index = FindPackageIndex(zipFile);
+    if (index == nullptr) {
+        return nullptr;
+    }
+    const ovrPackageEntry* entry = index->Find(nameInZip);
+    if (entry == nullptr) {
+        return nullptr;
+    }
+    // Compressed files can only be mapped once they are in the extraction cache.
+    if (entry->method != 0) {
+        return PackageCache.Map(*entry, data, length);
+    }
+    if (entry->uncompressedSize == 0 || entry->uncompressedSize > UINT32_MAX) {
+        return nullptr;
+    }
+    uint64_t dataOffset = 0;
+    if (!index->GetDataOffset(*entry, dataOffset)) {
+        return nullptr;
+    }
+    const size_t fileOffset = (size_t)dataOffset;
+    const size_t fileLength = (size_t)entry->uncompressedSize;
+    const std::string& packagePath = index->GetPath();
+
+    auto mapped = std::make_shared<ovrMappedPackageFile>();
+    if (!mapped->File.OpenRead(packagePath.c_str()) || !mapped->View.Open(&mapped->File)) {
+        ALOGW("Failed to open '%s' for mapping '%s'", packagePath.c_str(), nameInZip);
+        return nullptr;
+    }
+    // MapView rounds the offset down to the allocation granularity.
+    if (mapped->View.MapView(fileOffset, (uint32_t)fileLength) == nullptr) {
+        ALOGW("Failed to map '%s' from apk!", nameInZip);
+        return nullptr;
+    }
+
+    data = mapped->View.GetFront() + (fileOffset - mapped->View.GetOffset());
+    length = fileLength;
+    return mapped;
+#else
+    return nullptr;
+#endif // !defined(OVR_OS_WIN32)
+}
+
 //--------------------------------------------------------------
 // Functions for reading assets from this process's application package
 //--------------------------------------------------------------
@@ -304,4 +1126,28 @@ bool ovr_ReadFileFromApplicationPackage(const char* nameInZip, std::vector<uint8
     return ovr_ReadFileFromOtherApplicationPackage(packageZipFile, nameInZip, buffer);
 }
 
+void ovr_SetApplicationPackageCacheBudget(const size_t maxBytes) {
+    PackageCache.SetBudget(maxBytes);
+}
+
+std::string ovr_GetApplicationCacheFileName(const char* name) {
+    return ovrPackageCache::GetFileName(name);
+}
+
+void ovr_AddApplicationCacheFile(const char* name) {
+    PackageCache.AddFile(name);
+}
+
+bool ovr_UseApplicationCacheFile(const char* name) {
+    return PackageCache.UseFile(name);
+}
+
+void ovr_PrefetchFilesFromApplicationPackage(const std::vector<std::string>& namesInZip) {
+    PackageCache.Prefetch(FindPackageIndex(packageZipFile), namesInZip);
+}
+
+void ovr_WaitForApplicationPackagePrefetch() {
+    PackageCache.WaitForPrefetch();
+}
+
 } // namespace OVRFW
@@ -27,6 +27,10 @@ Authors     :   John Carmack
 
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
 #include <vector>
 
 // The application package is the moral equivalent of the filesystem, so
@@ -67,7 +71,9 @@ void* ovr_OpenOtherApplicationPackage(const char* packageName);
 // Call this to close another application package after loading resources from it.
 void ovr_CloseOtherApplicationPackage(void*& zipFile);
 
-// These are probably NOT thread safe!
+// The central directory of the package is indexed when it is opened, so files can be looked up
+// and read from multiple threads at once. Where there is no index, such as on windows, files
+// are looked up and read through minizip one at a time.
 bool ovr_OtherPackageFileExists(void* zipFile, const char* nameInZip);
 
 // Returns NULL buffer if the file is not found.
@@ -81,6 +87,16 @@ bool ovr_ReadFileFromOtherApplicationPackage(
     const char* nameInZip,
     std::vector<uint8_t>& buffer);
 
+// Maps a file that is stored uncompressed in the package straight from the package file, or a
+// compressed file from the extraction cache. The data stays valid for as long as the returned
+// handle is referenced. Returns nullptr if the file is not found, is compressed and not cached
+// yet, or cannot be mapped.
+std::shared_ptr<const void> ovr_MapFileFromOtherApplicationPackage(
+    void* zipFile,
+    const char* nameInZip,
+    const uint8_t*& data,
+    size_t& length);
+
 //--------------------------------------------------------------
 // Functions for reading assets from this process's application package
 //--------------------------------------------------------------
@@ -96,11 +112,30 @@ const char* ovr_GetApplicationPackageCachePath();
 
 // App.cpp calls this very shortly after startup.
 // If cachePath is not NULL, compressed files that are read will be written
-// out to the cachePath with the CRC as the filename so they can be read
+// out to the cachePath with the CRC and size as the filename so they can be read
 // back in much faster.
 void ovr_OpenApplicationPackage(const char* packageName, const char* cachePath);
 
-// These are probably NOT thread safe!
+// Limits the total size of the extraction cache. The least recently used files are evicted
+// when it is exceeded.
+void ovr_SetApplicationPackageCacheBudget(const size_t maxBytes);
+
+// Files the application derives and writes to the cache path itself, such as optimized
+// geometry, share the budget and eviction of the extraction cache once added. name is the file
+// name without its ".bin" extension. Add the file after writing it under its file name.
+std::string ovr_GetApplicationCacheFileName(const char* name);
+void ovr_AddApplicationCacheFile(const char* name);
+// Marks an added file as used. Returns false if the cache doesn't hold it.
+bool ovr_UseApplicationCacheFile(const char* name);
+
+// Extracts the compressed files in namesInZip to the cache on a background thread, for example
+// while a splash screen is shown, so later reads and maps are served from the cache. Starting a
+// new prefetch waits for the previous one. Call from a single thread.
+void ovr_PrefetchFilesFromApplicationPackage(const std::vector<std::string>& namesInZip);
+
+// Blocks until the current prefetch has finished.
+void ovr_WaitForApplicationPackagePrefetch();
+
 bool ovr_PackageFileExists(const char* nameInZip);
 
 // Returns NULL buffer if the file is not found.
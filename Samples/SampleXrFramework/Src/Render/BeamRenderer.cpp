@@ -27,6 +27,7 @@ Authors     :   Jonathan E. Wright
 
 #include "BeamRenderer.h"
 #include "TextureAtlas.h"
+#include "GlStreamBuffer.h"
 
 using OVR::Matrix4f;
 using OVR::Posef;
@@ -94,7 +95,7 @@ float ovrBeamRenderer::LIFETIME_INFINITE = FLT_MAX;
 
 //==============================
 // ovrBeamRenderer::ovrBeamRenderer
-ovrBeamRenderer::ovrBeamRenderer() : MaxBeams(0) {}
+ovrBeamRenderer::ovrBeamRenderer() : MaxBeams(0), StreamedFrame(-1) {}
 
 //==============================
 // ovrBeamRenderer::ovrBeamRenderer
@@ -124,12 +125,8 @@ void ovrBeamRenderer::Init(const int maxBeams, const bool depthTest) {
             OVRFW::GlProgram::Build(BeamVertexSrc, ParametricFragmentSrc, nullptr, 0);
     }
 
-    const int numVerts = maxBeams * 4;
-
+    // vertices are streamed every frame, the geometry only owns the indices
     VertexAttribs attr;
-    attr.position.resize(numVerts);
-    attr.uv0.resize(numVerts);
-    attr.color.resize(numVerts);
 
     // the indices will never change once we've set them up; we just won't necessarily
     // use all of the index buffer to render.
@@ -351,13 +348,14 @@ void ovrBeamRenderer::FrameInternal(
         Surf.graphicsCommand.Program = ParametricProgram;
     }
 
-    VertexAttribs attr;
-    attr.position.resize(ActiveBeams.size() * 4);
-    attr.color.resize(ActiveBeams.size() * 4);
-    attr.uv0.resize(ActiveBeams.size() * 4);
-
     const Vector3f viewPos = GetViewMatrixPosition(centerViewMatrix);
 
+    // write the quads straight into the vertex stream; the mapped memory is write-only
+    GlStreamBuffer& stream = GetVertexStreamBuffer();
+    const GlStreamBuffer::Allocation alloc =
+        stream.Map(ActiveBeams.size() * 4 * sizeof(colorTexVertex_t));
+    colorTexVertex_t* verts = static_cast<colorTexVertex_t*>(alloc.data);
+
     int quadIndex = 0;
     for (int i = 0; i < static_cast<int>(ActiveBeams.size()); ++i) {
         const handle_t beamHandle = ActiveBeams[i];
@@ -375,6 +373,9 @@ void ovrBeamRenderer::FrameInternal(
             i--;
             continue;
         }
+        if (verts == nullptr) {
+            continue;
+        }
 
         // Vector describing length and direction of beam (but not position)
         const Vector3f beamVector = cur.EndPos - cur.StartPos;
@@ -390,28 +391,26 @@ void ovrBeamRenderer::FrameInternal(
         const float t = static_cast<float>(frame.PredictedDisplayTime - cur.StartTime);
 
         const Vector4f color = EaseFunctions[cur.EaseFunc](cur.InitialColor, t / cur.LifeTime);
-        const Vector2f uvOfs(0.0f);
-
-        attr.position[quadIndex * 4 + 0] = cur.StartPos + cross;
-        attr.position[quadIndex * 4 + 1] = cur.StartPos - cross;
-        attr.position[quadIndex * 4 + 2] = cur.EndPos + cross;
-        attr.position[quadIndex * 4 + 3] = cur.EndPos - cross;
-        attr.color[quadIndex * 4 + 0] = color;
-        attr.color[quadIndex * 4 + 1] = color;
-        attr.color[quadIndex * 4 + 2] = color;
-        attr.color[quadIndex * 4 + 3] = color;
-        attr.uv0[quadIndex * 4 + 0] = Vector2f(cur.TexCoords[0].x, cur.TexCoords[0].y) + uvOfs;
-        attr.uv0[quadIndex * 4 + 1] = Vector2f(cur.TexCoords[1].x, cur.TexCoords[0].y) + uvOfs;
-        attr.uv0[quadIndex * 4 + 2] = Vector2f(cur.TexCoords[0].x, cur.TexCoords[1].y) + uvOfs;
-        attr.uv0[quadIndex * 4 + 3] = Vector2f(cur.TexCoords[1].x, cur.TexCoords[1].y) + uvOfs;
+
+        colorTexVertex_t* v = verts + quadIndex * 4;
+        v[0] = {cur.StartPos + cross, color, Vector2f(cur.TexCoords[0].x, cur.TexCoords[0].y)};
+        v[1] = {cur.StartPos - cross, color, Vector2f(cur.TexCoords[1].x, cur.TexCoords[0].y)};
+        v[2] = {cur.EndPos + cross, color, Vector2f(cur.TexCoords[0].x, cur.TexCoords[1].y)};
+        v[3] = {cur.EndPos - cross, color, Vector2f(cur.TexCoords[1].x, cur.TexCoords[1].y)};
 
         quadIndex++;
     }
+    stream.Unmap();
 
     // Surf.graphicsCommand.GpuState.polygonMode = GL_LINE;
     Surf.graphicsCommand.GpuState.cullEnable = false;
+    Surf.geo.vertexCount = quadIndex * 4;
     Surf.geo.indexCount = quadIndex * 6;
-    Surf.geo.Update(attr);
+    if (quadIndex > 0) {
+        Surf.geo.BindVertexStream(
+            alloc.buffer, alloc.offset, colorTexVertex_t::GetStreamLayout(), VertexLayout::Full());
+    }
+    StreamedFrame = stream.GetFrameIndex();
 }
 
 //==============================
@@ -420,13 +419,13 @@ void ovrBeamRenderer::RenderEyeView(
     const Matrix4f& /*viewMatrix*/,
     const Matrix4f& /*projMatrix*/,
     std::vector<ovrDrawSurface>& surfaceList) {
-    if (Surf.geo.indexCount > 0) {
+    if (Surf.geo.indexCount > 0 && StreamedFrame == GetVertexStreamBuffer().GetFrameIndex()) {
         surfaceList.push_back(ovrDrawSurface(ModelMatrix, &Surf));
     }
 }
 
 void ovrBeamRenderer::Render(std::vector<ovrDrawSurface>& surfaceList) {
-    if (Surf.geo.indexCount > 0) {
+    if (Surf.geo.indexCount > 0 && StreamedFrame == GetVertexStreamBuffer().GetFrameIndex()) {
         surfaceList.push_back(ovrDrawSurface(ModelMatrix, &Surf));
     }
 }
@@ -165,6 +165,7 @@ class ovrBeamRenderer {
     GlProgram TextureProgram;
     GlProgram ParametricProgram;
     OVR::Matrix4f ModelMatrix;
+    int64_t StreamedFrame; // stream frame the vertices were written in, see GlStreamBuffer
 };
 
 } // namespace OVRFW
@@ -27,6 +27,7 @@ Authors     :   Jonathan E. Wright
 
 #include "BillBoardRenderer.h"
 #include "TextureAtlas.h"
+#include "GlStreamBuffer.h"
 
 using OVR::Matrix4f;
 using OVR::Posef;
@@ -95,7 +96,7 @@ float ovrBillBoardRenderer::LIFETIME_INFINITE = FLT_MAX;
 
 //==============================
 // ovrBillBoardRenderer::ovrBillBoardRenderer
-ovrBillBoardRenderer::ovrBillBoardRenderer() : MaxBillBoards(0) {}
+ovrBillBoardRenderer::ovrBillBoardRenderer() : MaxBillBoards(0), StreamedFrame(-1) {}
 
 //==============================
 // ovrBillBoardRenderer::ovrBillBoardRenderer
@@ -125,12 +126,8 @@ void ovrBillBoardRenderer::Init(const int maxBillBoards, const bool depthTest) {
             OVRFW::GlProgram::Build(BillBoardVertexSrc, ParametricFragmentSrc, nullptr, 0);
     }
 
-    const int numVerts = maxBillBoards * 4;
-
+    // vertices are streamed every frame, the geometry only owns the indices
     VertexAttribs attr;
-    attr.position.resize(numVerts);
-    attr.uv0.resize(numVerts);
-    attr.color.resize(numVerts);
 
     // the indices will never change once we've set them up; we just won't necessarily
     // use all of the index buffer to render.
@@ -345,14 +342,15 @@ void ovrBillBoardRenderer::FrameInternal(
         Surf.graphicsCommand.Program = ParametricProgram;
     }
 
-    VertexAttribs attr;
-    attr.position.resize(ActiveBillBoards.size() * 4);
-    attr.color.resize(ActiveBillBoards.size() * 4);
-    attr.uv0.resize(ActiveBillBoards.size() * 4);
-
     const Vector3f viewPos = GetViewMatrixPosition(centerViewMatrix);
     const Vector3f viewUp = Vector3f(0.0f, 1.0f, 0.0f);
 
+    // write the quads straight into the vertex stream; the mapped memory is write-only
+    GlStreamBuffer& stream = GetVertexStreamBuffer();
+    const GlStreamBuffer::Allocation alloc =
+        stream.Map(ActiveBillBoards.size() * 4 * sizeof(colorTexVertex_t));
+    colorTexVertex_t* verts = static_cast<colorTexVertex_t*>(alloc.data);
+
     int quadIndex = 0;
     for (int i = 0; i < static_cast<int>(ActiveBillBoards.size()); ++i) {
         const handle_t billboardHandle = ActiveBillBoards[i];
@@ -370,6 +368,9 @@ void ovrBillBoardRenderer::FrameInternal(
             i--;
             continue;
         }
+        if (verts == nullptr) {
+            continue;
+        }
 
         const Vector3f viewForward = (cur.Pos - viewPos).Normalized();
         const Vector3f viewRight = viewForward.Cross(viewUp).Normalized();
@@ -380,28 +381,26 @@ void ovrBillBoardRenderer::FrameInternal(
         const float t = static_cast<float>(frame.PredictedDisplayTime - cur.StartTime);
 
         const Vector4f color = EaseFunctions[cur.EaseFunc](cur.InitialColor, t / cur.LifeTime);
-        const Vector2f uvOfs(0.0f);
-
-        attr.position[quadIndex * 4 + 0] = cur.Pos + up - right;
-        attr.position[quadIndex * 4 + 1] = cur.Pos - up - right;
-        attr.position[quadIndex * 4 + 2] = cur.Pos + up + right;
-        attr.position[quadIndex * 4 + 3] = cur.Pos - up + right;
-        attr.color[quadIndex * 4 + 0] = color;
-        attr.color[quadIndex * 4 + 1] = color;
-        attr.color[quadIndex * 4 + 2] = color;
-        attr.color[quadIndex * 4 + 3] = color;
-        attr.uv0[quadIndex * 4 + 0] = Vector2f(cur.TexCoords[0].x, cur.TexCoords[0].y) + uvOfs;
-        attr.uv0[quadIndex * 4 + 1] = Vector2f(cur.TexCoords[1].x, cur.TexCoords[0].y) + uvOfs;
-        attr.uv0[quadIndex * 4 + 2] = Vector2f(cur.TexCoords[0].x, cur.TexCoords[1].y) + uvOfs;
-        attr.uv0[quadIndex * 4 + 3] = Vector2f(cur.TexCoords[1].x, cur.TexCoords[1].y) + uvOfs;
+
+        colorTexVertex_t* v = verts + quadIndex * 4;
+        v[0] = {cur.Pos + up - right, color, Vector2f(cur.TexCoords[0].x, cur.TexCoords[0].y)};
+        v[1] = {cur.Pos - up - right, color, Vector2f(cur.TexCoords[1].x, cur.TexCoords[0].y)};
+        v[2] = {cur.Pos + up + right, color, Vector2f(cur.TexCoords[0].x, cur.TexCoords[1].y)};
+        v[3] = {cur.Pos - up + right, color, Vector2f(cur.TexCoords[1].x, cur.TexCoords[1].y)};
 
         quadIndex++;
     }
+    stream.Unmap();
 
     // Surf.graphicsCommand.GpuState.polygonMode = GL_LINE;
     Surf.graphicsCommand.GpuState.cullEnable = false;
+    Surf.geo.vertexCount = quadIndex * 4;
     Surf.geo.indexCount = quadIndex * 6;
-    Surf.geo.Update(attr);
+    if (quadIndex > 0) {
+        Surf.geo.BindVertexStream(
+            alloc.buffer, alloc.offset, colorTexVertex_t::GetStreamLayout(), VertexLayout::Full());
+    }
+    StreamedFrame = stream.GetFrameIndex();
 }
 
 //==============================
@@ -410,13 +409,13 @@ void ovrBillBoardRenderer::RenderEyeView(
     const Matrix4f& /*viewMatrix*/,
     const Matrix4f& /*projMatrix*/,
     std::vector<ovrDrawSurface>& surfaceList) {
-    if (Surf.geo.indexCount > 0) {
+    if (Surf.geo.indexCount > 0 && StreamedFrame == GetVertexStreamBuffer().GetFrameIndex()) {
         surfaceList.push_back(ovrDrawSurface(ModelMatrix, &Surf));
     }
 }
 
 void ovrBillBoardRenderer::Render(std::vector<ovrDrawSurface>& surfaceList) {
-    if (Surf.geo.indexCount > 0) {
+    if (Surf.geo.indexCount > 0 && StreamedFrame == GetVertexStreamBuffer().GetFrameIndex()) {
         surfaceList.push_back(ovrDrawSurface(ModelMatrix, &Surf));
     }
 }
@@ -34,6 +34,8 @@ Authors     :   Jonathan E. Wright
 #include "BitmapFont.h"
 
 #include <algorithm>
+#include <atomic>
+#include <unordered_map>
 
 #include <math.h>
 
@@ -45,6 +47,8 @@ Authors     :   Jonathan E. Wright
 #include "GlProgram.h"
 #include "GlTexture.h"
 #include "GlGeometry.h"
+#include "GlStreamBuffer.h"
+#include "RadixSort.h"
 
 #include "OVR_FileSys.h"
 #include "OVR_Uri.h"
@@ -194,17 +198,35 @@ bool AppendUriPath(
 
 namespace OVRFW {
 
+// FontPivot.w selects how the vertex is oriented around the pivot in FontPivot.xyz:
+// 1 = as is, 2 = facing the center eye, 3 = aligned with the center eye including roll.
+// The pivot defaults to ( 0, 0, 0, 1 ) when the attribute isn't enabled.
 static char const* FontSingleTextureVertexShaderSrc = R"glsl(
 	attribute vec4 Position;
 	attribute vec2 TexCoord;
 	attribute vec4 VertexColor;
 	attribute vec4 FontParms;
+	attribute vec4 FontPivot;
+	uniform highp mat4 BillboardMatrix;
 	varying highp vec2 oTexCoord;
 	varying lowp vec4 oColor;
 	varying vec4 oFontParms;
 	void main()
 	{
-	    gl_Position = TransformVertex( Position );
+	    highp vec3 local = Position.xyz;
+	    if ( FontPivot.w > 2.5 )
+	    {
+	        local = mat3( BillboardMatrix ) * local;
+	    }
+	    else if ( FontPivot.w > 1.5 )
+	    {
+	        highp vec3 zBasis = normalize( BillboardMatrix[3].xyz - FontPivot.xyz );
+	        highp vec3 xBasis = cross( BillboardMatrix[1].xyz, zBasis );
+	        xBasis = dot( xBasis, xBasis ) > 1e-8 ? normalize( xBasis ) : BillboardMatrix[0].xyz;
+	        highp vec3 yBasis = cross( zBasis, xBasis );
+	        local = xBasis * local.x + yBasis * local.y + zBasis * local.z;
+	    }
+	    gl_Position = TransformVertex( vec4( FontPivot.xyz + local, 1.0 ) );
 	    oTexCoord = TexCoord;
 	    oColor = VertexColor;
 	    oFontParms = FontParms;
@@ -329,7 +351,8 @@ const float FontInfoType::DEFAULT_SCALE_FACTOR = 512.0f;
 
 class BitmapFontLocal : public BitmapFont {
    public:
-    BitmapFontLocal() : FontTexture(), ImageWidth(0), ImageHeight(0) {}
+    BitmapFontLocal()
+        : FontTexture(), ImageWidth(0), ImageHeight(0), Generation(NextGeneration()) {}
     ~BitmapFontLocal() {
         FreeTexture(FontTexture);
         GlProgram::Free(FontProgram);
@@ -415,16 +438,27 @@ class BitmapFontLocal : public BitmapFont {
     const GlTexture& GetFontTexture() const {
         return FontTexture;
     }
+    // Changes whenever the font is loaded, so layouts made with an earlier load (or by a freed
+    // font at the same address) are not reused.
+    uint32_t GetGeneration() const {
+        return Generation;
+    }
 
    private:
     FontInfoType FontInfo;
     GlTexture FontTexture;
     int ImageWidth;
     int ImageHeight;
+    uint32_t Generation;
 
     GlProgram FontProgram;
 
    private:
+    static uint32_t NextGeneration() {
+        static std::atomic<uint32_t> generation(0);
+        return ++generation;
+    }
+
     bool LoadImage(ovrFileSys& fileSys, char const* uri);
     bool LoadImageFromBuffer(
         char const* imageName,
@@ -550,7 +584,9 @@ class VertexBlockType {
         : Font(nullptr),
           Verts(nullptr),
           NumVerts(0),
+          OwnsVerts(true),
           Pivot(0.0f),
+          Radius(0.0f),
           Rotation(),
           Billboard(true),
           TrackRoll(false) {}
@@ -559,7 +595,9 @@ class VertexBlockType {
         : Font(nullptr),
           Verts(nullptr),
           NumVerts(0),
+          OwnsVerts(true),
           Pivot(0.0f),
+          Radius(0.0f),
           Rotation(),
           Billboard(true),
           TrackRoll(false) {
@@ -575,11 +613,15 @@ class VertexBlockType {
         if (&other == this) {
             return;
         }
-        delete[] Verts;
+        if (OwnsVerts) {
+            delete[] Verts;
+        }
         Font = other.Font;
         Verts = other.Verts;
         NumVerts = other.NumVerts;
+        OwnsVerts = other.OwnsVerts;
         Pivot = other.Pivot;
+        Radius = other.Radius;
         Rotation = other.Rotation;
         Billboard = other.Billboard;
         TrackRoll = other.TrackRoll;
@@ -598,28 +640,55 @@ class VertexBlockType {
         bool const trackRoll)
         : Font(&font),
           NumVerts(numVerts),
+          OwnsVerts(true),
           Pivot(pivot),
+          Radius(0.0f),
           Rotation(rot),
           Billboard(billboard),
           TrackRoll(trackRoll) {
         Verts = new fontVertex_t[numVerts];
     }
 
+    // references vertices owned by a cached text layout
+    VertexBlockType(
+        BitmapFont const& font,
+        fontVertex_t* verts,
+        int const numVerts,
+        Vector3f const& pivot,
+        float const radius,
+        Quatf const& rot,
+        bool const billboard,
+        bool const trackRoll)
+        : Font(&font),
+          Verts(verts),
+          NumVerts(numVerts),
+          OwnsVerts(false),
+          Pivot(pivot),
+          Radius(radius),
+          Rotation(rot),
+          Billboard(billboard),
+          TrackRoll(trackRoll) {}
+
     ~VertexBlockType() {
         Free();
     }
 
     void Free() {
         Font = nullptr;
-        delete[] Verts;
+        if (OwnsVerts) {
+            delete[] Verts;
+        }
         Verts = nullptr;
         NumVerts = 0;
+        OwnsVerts = true;
     }
 
     mutable BitmapFont const* Font; // the font used to render text into this vertex block
     mutable fontVertex_t* Verts; // the vertices
     mutable int NumVerts; // the number of vertices in the block
+    mutable bool OwnsVerts; // false if the vertices belong to a cached text layout
     Vector3f Pivot; // postion this vertex block can be rotated around
+    float Radius; // distance of the farthest vertex from the pivot, for bounds
     Quatf Rotation; // additional rotation to apply
     bool Billboard; // true to always face the camera
     bool TrackRoll; // if true, when billboarded, roll with the camera
@@ -814,6 +883,7 @@ VertexBlockType DrawTextToVertexBlock(
     fontVertex_t* v = vb.Verts;
     char const* p = text;
     size_t i = 0;
+    float radiusSq = 0.0f;
 
     UpdateFormat(fontInfo, fontParms, &p, format, vertexParms);
     uint32_t charCode = UTF8Util::DecodeNextChar(&p);
@@ -883,12 +953,17 @@ VertexBlockType DrawTextToVertexBlock(
         // advance to start of next char
         curPos += r * (g.AdvanceX * xScale);
 
+        for (int j = 0; j < 4; j++) {
+            radiusSq = std::max(radiusSq, v[i * 4 + j].xyz.LengthSq());
+        }
+
         UpdateFormat(fontInfo, fontParms, &p, format, vertexParms);
     }
 
     if (toNextLine) {
         *toNextLine -= lineInc;
     }
+    vb.Radius = sqrtf(radiusSq);
 
 #if defined(OVR_BUILD_DEBUG)
 ///	ALOG( "DrawTextToVertexBlock: drawn %d vertices lineInc = ", vb.NumVerts );
@@ -954,6 +1029,116 @@ ovrSurfaceDef BitmapFontLocal::TextSurface(
     return s;
 }
 
+//==============================================================
+// ovrTextLayout
+// The vertex block for a string drawn with a given font, parms, orientation, scale and color.
+// Vertices are relative to the pivot, so a layout is reused wherever the same text is drawn.
+class ovrTextLayout {
+   public:
+    ovrTextLayout()
+        : Font(nullptr),
+          FontGeneration(0),
+          Scale(0.0f),
+          Normal(0.0f),
+          Up(0.0f),
+          Color(0.0f),
+          Radius(0.0f),
+          ToNextLine(0.0f),
+          LastFrame(0) {}
+
+    static uint64_t Hash(
+        BitmapFont const& font,
+        fontParms_t const& parms,
+        Vector3f const& normal,
+        Vector3f const& up,
+        float const scale,
+        Vector4f const& color,
+        char const* text);
+
+    bool Matches(
+        BitmapFont const& font,
+        fontParms_t const& parms,
+        Vector3f const& normal,
+        Vector3f const& up,
+        float const scale,
+        Vector4f const& color,
+        char const* text) const {
+        return Font == &font && FontGeneration == AsLocal(font).GetGeneration() &&
+            Parms.AlignHoriz == parms.AlignHoriz &&
+            Parms.AlignVert == parms.AlignVert && Parms.Billboard == parms.Billboard &&
+            Parms.TrackRoll == parms.TrackRoll && Parms.AlphaCenter == parms.AlphaCenter &&
+            Parms.ColorCenter == parms.ColorCenter && Normal == normal && Up == up &&
+            Scale == scale && Color == color && Text == text;
+    }
+
+    BitmapFont const* Font;
+    uint32_t FontGeneration;
+    fontParms_t Parms;
+    std::string Text;
+    float Scale;
+    Vector3f Normal;
+    Vector3f Up;
+    Vector4f Color;
+    std::vector<fontVertex_t> Verts;
+    float Radius;
+    Vector3f ToNextLine;
+    uint32_t LastFrame; // last frame the layout was drawn, unused layouts are evicted
+};
+
+//==============================
+// ovrTextLayout::Hash
+// FNV-1a over the text and everything the vertices depend on.
+uint64_t ovrTextLayout::Hash(
+    BitmapFont const& font,
+    fontParms_t const& parms,
+    Vector3f const& normal,
+    Vector3f const& up,
+    float const scale,
+    Vector4f const& color,
+    char const* text) {
+    uint64_t hash = 14695981039346656037ULL;
+    auto hashBytes = [&hash](void const* data, size_t const size) {
+        uint8_t const* bytes = static_cast<uint8_t const*>(data);
+        for (size_t i = 0; i < size; ++i) {
+            hash = (hash ^ bytes[i]) * 1099511628211ULL;
+        }
+    };
+    for (char const* p = text; *p != '\0'; ++p) {
+        hash = (hash ^ static_cast<uint8_t>(*p)) * 1099511628211ULL;
+    }
+    BitmapFont const* fontPtr = &font;
+    int const align[4] = {parms.AlignHoriz, parms.AlignVert, parms.Billboard, parms.TrackRoll};
+    float const values[13] = {
+        parms.AlphaCenter,
+        parms.ColorCenter,
+        normal.x,
+        normal.y,
+        normal.z,
+        up.x,
+        up.y,
+        up.z,
+        scale,
+        color.x,
+        color.y,
+        color.z,
+        color.w};
+    uint32_t const generation = AsLocal(font).GetGeneration();
+    hashBytes(&fontPtr, sizeof(fontPtr));
+    hashBytes(&generation, sizeof(generation));
+    hashBytes(align, sizeof(align));
+    hashBytes(values, sizeof(values));
+    return hash;
+}
+
+//==============================================================
+// vbSort_t
+// small structure that is used to sort vertex blocks by their distance to the camera
+//==============================================================
+struct vbSort_t {
+    int VertexBlockIndex;
+    float DistanceSquared;
+};
+
 //==================================================================================================
 // BitmapFontSurfaceLocal
 //
@@ -1019,17 +1204,30 @@ class BitmapFontSurfaceLocal : public BitmapFontSurface {
     // This limitation may not exist anymore now that ModelMatrix is no longer a member.
     BitmapFontSurfaceLocal& operator=(BitmapFontSurfaceLocal const& rhs);
 
-    mutable ovrSurfaceDef FontSurfaceDef;
+    // Font indices are 16 bit, so text that doesn't fit in one surface continues in the next.
+    static constexpr int MAX_SURFACE_VERTICES = GlGeometry::MAX_GEOMETRY_VERTICES;
 
-    fontVertex_t* Vertices; // vertices that are written to the VBO. Fixed size to not overflow VBO
-    int MaxVertices;
-    int MaxIndices;
-    int CurVertex; // reset every Render()
-    int CurIndex; // reset every Render()
+    void InitSurface(ovrSurfaceDef& surfaceDef, int const numVertices) const;
+
+    mutable std::vector<ovrSurfaceDef> FontSurfaceDefs;
+
+    // staging for the vertices when the vertex stream can't be mapped, grows as needed
+    std::vector<fontVertex_t> Vertices;
+    std::vector<vbSort_t> VertexBlockSort;
+    std::vector<vbSort_t> VertexBlockSortTemp;
+    Matrix4f BillboardMatrix; // inverse of the center view matrix, used by the vertex shader
+    int InitialVertices;
+    bool CullEnabled;
     bool Initialized;
 
     std::vector<VertexBlockType>
         VertexBlocks; // each pointer in the array points to an allocated block ov
+
+    // Layouts of the strings drawn recently, keyed by ovrTextLayout::Hash. Static labels are
+    // laid out once and only transformed in Finish() after that.
+    std::unordered_map<uint64_t, ovrTextLayout> TextLayouts;
+    uint32_t FrameNumber; // incremented by Finish()
+    int64_t StreamedFrame; // stream frame the vertices were written in, -1 if not streamed
 };
 
 //==================================================================================================
@@ -1062,17 +1260,6 @@ bool FontInfoType::Load(ovrFileSys& fileSys, char const* uri) {
 //==============================
 // FontInfoType::LoadFromBuffer
 bool FontInfoType::LoadFromBuffer(void const* buffer, size_t const bufferSize) {
-    char const* errorMsg = nullptr;
-    std::shared_ptr<OVR::JSON> jsonRoot =
-        OVR::JSON::Parse(reinterpret_cast<char const*>(buffer), &errorMsg);
-    if (jsonRoot == nullptr) {
-        ALOGW("OVR::JSON Error: %s", (errorMsg != nullptr) ? errorMsg : "<NULL>");
-        ALOG(
-            "FontInfoType::LoadFromBuffer FAIL OVR::JSON ERROR = '%s' ",
-            (errorMsg != nullptr) ? errorMsg : "<NULL>");
-        return false;
-    }
-
     int32_t maxCharCode = -1;
     // currently we're only supporting the first unicode plane up to 65k. If we were to support
     // other planes we could conceivably end up with a very sparse 1,114,111 byte type for mapping
@@ -1081,44 +1268,144 @@ bool FontInfoType::LoadFromBuffer(void const* buffer, size_t const bufferSize) {
     // characters.
     static const int MAX_GLYPHS = 0xffff;
 
-    // load the glyphs
-    const OVR::JsonReader jsonGlyphs(jsonRoot);
-    if (!jsonGlyphs.IsObject()) {
+    // The font is read in a single pass over the text, so members may appear in any order.
+    // Glyphs are stored unscaled and scaled once the natural width and height are known.
+    OVR::JsonPullParser parser(reinterpret_cast<char const*>(buffer), bufferSize);
+    if (parser.Next() != OVR::JSON_Token_BeginObject) {
+        char const* errorMsg = parser.GetError();
+        ALOGW("OVR::JSON Error: %s", (errorMsg != nullptr) ? errorMsg : "<NULL>");
         ALOG("FontInfoType::LoadFromBuffer FAIL ==> jsonGlyphs.IsObject() = FALSE ");
         return false;
     }
 
-    // OVR::JSON doesn't have ints so cast from float to an int
-    int Version = static_cast<int>(jsonGlyphs.GetChildFloatByName("Version"));
+    int Version = 0;
+    int numGlyphs = 0;
+    float horizontalPad = 0.0f;
+    float verticalPad = 0.0f;
+    float fontHeight = 0.0f;
+    Glyphs.clear();
+
+    while (parser.NextMember()) {
+        char const* name = parser.GetString();
+        if (OVR::OVR_strcmp(name, "Version") == 0) {
+            // OVR::JSON doesn't have ints so cast from float to an int
+            Version = static_cast<int>(parser.ReadFloat());
+        } else if (OVR::OVR_strcmp(name, "FontName") == 0) {
+            FontName = parser.ReadString();
+        } else if (OVR::OVR_strcmp(name, "CommandLine") == 0) {
+            CommandLine = parser.ReadString();
+        } else if (OVR::OVR_strcmp(name, "ImageFileName") == 0) {
+            ImageFileName = parser.ReadString();
+        } else if (OVR::OVR_strcmp(name, "NumGlyphs") == 0) {
+            numGlyphs = parser.ReadInt32();
+        } else if (OVR::OVR_strcmp(name, "NaturalWidth") == 0) {
+            NaturalWidth = parser.ReadFloat();
+        } else if (OVR::OVR_strcmp(name, "NaturalHeight") == 0) {
+            NaturalHeight = parser.ReadFloat();
+        } else if (OVR::OVR_strcmp(name, "HorizontalPad") == 0) {
+            horizontalPad = parser.ReadFloat();
+        } else if (OVR::OVR_strcmp(name, "VerticalPad") == 0) {
+            verticalPad = parser.ReadFloat();
+        } else if (OVR::OVR_strcmp(name, "FontHeight") == 0) {
+            fontHeight = parser.ReadFloat();
+        } else if (OVR::OVR_strcmp(name, "CenterOffset") == 0) {
+            CenterOffset = parser.ReadFloat();
+        } else if (OVR::OVR_strcmp(name, "TweakScale") == 0) {
+            TweakScale = parser.ReadFloat(1.0f);
+        } else if (OVR::OVR_strcmp(name, "EdgeWidth") == 0) {
+            EdgeWidth = parser.ReadFloat(32.0f);
+        } else if (OVR::OVR_strcmp(name, "Weights") == 0) {
+            if (parser.Next() != OVR::JSON_Token_BeginArray) {
+                parser.SkipValue();
+                continue;
+            }
+            while (parser.NextElement()) {
+                if (parser.GetToken() != OVR::JSON_Token_BeginObject) {
+                    parser.SkipValue();
+                    continue;
+                }
+                ovrFontWeight w;
+                while (parser.NextMember()) {
+                    if (OVR::OVR_strcmp(parser.GetString(), "AlphaCenterOffset") == 0) {
+                        w.AlphaCenterOffset = parser.ReadFloat();
+                    } else if (OVR::OVR_strcmp(parser.GetString(), "ColorCenterOffset") == 0) {
+                        w.ColorCenterOffset = parser.ReadFloat();
+                    } else {
+                        parser.SkipValue();
+                    }
+                }
+                FontWeights.push_back(w);
+            }
+        } else if (OVR::OVR_strcmp(name, "Glyphs") == 0) {
+            if (parser.Next() != OVR::JSON_Token_BeginArray) {
+                parser.SkipValue();
+                continue;
+            }
+            while (parser.NextElement()) {
+                if (parser.GetToken() != OVR::JSON_Token_BeginObject) {
+                    parser.SkipValue();
+                    continue;
+                }
+                Glyphs.emplace_back();
+                FontGlyphType& g = Glyphs.back();
+                while (parser.NextMember()) {
+                    char const* glyphMember = parser.GetString();
+                    if (OVR::OVR_strcmp(glyphMember, "CharCode") == 0) {
+                        g.CharCode = parser.ReadInt32();
+                    } else if (OVR::OVR_strcmp(glyphMember, "X") == 0) {
+                        g.X = parser.ReadFloat();
+                    } else if (OVR::OVR_strcmp(glyphMember, "Y") == 0) {
+                        g.Y = parser.ReadFloat();
+                    } else if (OVR::OVR_strcmp(glyphMember, "Width") == 0) {
+                        g.Width = parser.ReadFloat();
+                    } else if (OVR::OVR_strcmp(glyphMember, "Height") == 0) {
+                        g.Height = parser.ReadFloat();
+                    } else if (OVR::OVR_strcmp(glyphMember, "AdvanceX") == 0) {
+                        g.AdvanceX = parser.ReadFloat();
+                    } else if (OVR::OVR_strcmp(glyphMember, "AdvanceY") == 0) {
+                        g.AdvanceY = parser.ReadFloat();
+                    } else if (OVR::OVR_strcmp(glyphMember, "BearingX") == 0) {
+                        g.BearingX = parser.ReadFloat();
+                    } else if (OVR::OVR_strcmp(glyphMember, "BearingY") == 0) {
+                        g.BearingY = parser.ReadFloat();
+                    } else {
+                        parser.SkipValue();
+                    }
+                }
+            }
+        } else {
+            parser.SkipValue();
+        }
+    }
+
+    if (parser.GetToken() == OVR::JSON_Token_Error) {
+        char const* errorMsg = parser.GetError();
+        ALOGW("OVR::JSON Error: %s", (errorMsg != nullptr) ? errorMsg : "<NULL>");
+        ALOG(
+            "FontInfoType::LoadFromBuffer FAIL OVR::JSON ERROR = '%s' ",
+            (errorMsg != nullptr) ? errorMsg : "<NULL>");
+        return false;
+    }
+
     if (Version != FNT_FILE_VERSION) {
         ALOG("FontInfoType::LoadFromBuffer FAIL ==> Version != FNT_FILE_VERSION ");
         return false;
     }
 
-    FontName = jsonGlyphs.GetChildStringByName("FontName");
-    CommandLine = jsonGlyphs.GetChildStringByName("CommandLine");
-    ImageFileName = jsonGlyphs.GetChildStringByName("ImageFileName");
-    const int numGlyphs = jsonGlyphs.GetChildInt32ByName("NumGlyphs");
     if (numGlyphs < 0 || numGlyphs > MAX_GLYPHS) {
         OVR_ASSERT(numGlyphs > 0 && numGlyphs <= MAX_GLYPHS);
         ALOG("FontInfoType::LoadFromBuffer FAIL ==> numGlyphs < 0 || numGlyphs > MAX_GLYPHS ");
         return false;
     }
 
-    NaturalWidth = jsonGlyphs.GetChildFloatByName("NaturalWidth");
-    NaturalHeight = jsonGlyphs.GetChildFloatByName("NaturalHeight");
-
     // we scale everything after loading integer values from the OVR::JSON file because the OVR
     // OVR::JSON writer loses precision on floats
     float nwScale = 1.0f / NaturalWidth;
     float nhScale = 1.0f / NaturalHeight;
 
-    HorizontalPad = jsonGlyphs.GetChildFloatByName("HorizontalPad") * nwScale;
-    VerticalPad = jsonGlyphs.GetChildFloatByName("VerticalPad") * nhScale;
-    FontHeight = jsonGlyphs.GetChildFloatByName("FontHeight") * nhScale;
-    CenterOffset = jsonGlyphs.GetChildFloatByName("CenterOffset");
-    TweakScale = jsonGlyphs.GetChildFloatByName("TweakScale", 1.0f);
-    EdgeWidth = jsonGlyphs.GetChildFloatByName("EdgeWidth", 32.0f);
+    HorizontalPad = horizontalPad * nwScale;
+    VerticalPad = verticalPad * nhScale;
+    FontHeight = fontHeight * nhScale;
 
 #if defined(OVR_BUILD_DEBUG)
     ALOG("FontName = %s", FontName.c_str());
@@ -1141,79 +1428,40 @@ bool FontInfoType::LoadFromBuffer(void const* buffer, size_t const bufferSize) {
     }
     /// HACK: end hack
 
-    const OVR::JsonReader jsonWeightArray(jsonGlyphs.GetChildByName("Weights"));
-    if (jsonWeightArray.IsValid()) {
-#if defined(OVR_BUILD_DEBUG)
-        ALOG("jsonWeightArray valid");
-#endif
-
-        for (; !jsonWeightArray.IsEndOfArray();) {
-            const OVR::JsonReader jsonWeight(jsonWeightArray.GetNextArrayElement());
-            if (jsonWeight.IsObject()) {
-                ovrFontWeight w;
-                w.AlphaCenterOffset = jsonWeight.GetChildFloatByName("AlphaCenterOffset");
-                w.ColorCenterOffset = jsonWeight.GetChildFloatByName("ColorCenterOffset");
-                FontWeights.push_back(w);
-            }
-        }
-    }
-
-#if defined(OVR_BUILD_DEBUG)
-    ALOG("jsonWeightArray DONE");
-#endif
-
+    // Only the first numGlyphs glyphs are used.
+    const int loadedGlyphs = std::min<int>(numGlyphs, static_cast<int>(Glyphs.size()));
     Glyphs.resize(numGlyphs);
-    const OVR::JsonReader jsonGlyphArray(jsonGlyphs.GetChildByName("Glyphs"));
 
     double oWidth = 0.0;
     double oHeight = 0.0;
 
-    if (jsonGlyphArray.IsArray()) {
-        for (int i = 0; i < static_cast<int>(Glyphs.size()) && !jsonGlyphArray.IsEndOfArray();
-             i++) {
-            const OVR::JsonReader jsonGlyph(jsonGlyphArray.GetNextArrayElement());
-            if (jsonGlyph.IsObject()) {
-                FontGlyphType& g = Glyphs[i];
-                g.CharCode = jsonGlyph.GetChildInt32ByName("CharCode");
-                g.X = jsonGlyph.GetChildFloatByName("X");
-                g.Y = jsonGlyph.GetChildFloatByName("Y");
-                g.Width = jsonGlyph.GetChildFloatByName("Width");
-                g.Height = jsonGlyph.GetChildFloatByName("Height");
-                g.AdvanceX = jsonGlyph.GetChildFloatByName("AdvanceX");
-                g.AdvanceY = jsonGlyph.GetChildFloatByName("AdvanceY");
-                g.BearingX = jsonGlyph.GetChildFloatByName("BearingX");
-                g.BearingY = jsonGlyph.GetChildFloatByName("BearingY");
-
-                if (g.CharCode == 'O') {
-                    oWidth = g.Width;
-                    oHeight = g.Height;
-                }
+    for (int i = 0; i < loadedGlyphs; i++) {
+        FontGlyphType& g = Glyphs[i];
 
-                g.X *= nwScale;
-                g.Y *= nhScale;
-                g.Width *= nwScale;
-                g.Height *= nhScale;
-                g.AdvanceX *= nwScale;
-                g.AdvanceY *= nhScale;
-                g.BearingX *= nwScale;
-                g.BearingY *= nhScale;
-
-                float const ascent = g.BearingY;
-                float const descent = g.Height - g.BearingY;
-                if (ascent > MaxAscent) {
-                    MaxAscent = ascent;
-                }
-                if (descent > MaxDescent) {
-                    MaxDescent = descent;
-                }
-
-#if defined(OVR_BUILD_DEBUG)
-///				ALOG( "Glyphs[%d] --> X=%.3f Y=%.3f CharCode=%d", i, g.X, g.Y, g.CharCode );
-#endif
+        if (g.CharCode == 'O') {
+            oWidth = g.Width;
+            oHeight = g.Height;
+        }
 
-                maxCharCode = std::max<int32_t>(maxCharCode, g.CharCode);
-            }
+        g.X *= nwScale;
+        g.Y *= nhScale;
+        g.Width *= nwScale;
+        g.Height *= nhScale;
+        g.AdvanceX *= nwScale;
+        g.AdvanceY *= nhScale;
+        g.BearingX *= nwScale;
+        g.BearingY *= nhScale;
+
+        float const ascent = g.BearingY;
+        float const descent = g.Height - g.BearingY;
+        if (ascent > MaxAscent) {
+            MaxAscent = ascent;
         }
+        if (descent > MaxDescent) {
+            MaxDescent = descent;
+        }
+
+        maxCharCode = std::max<int32_t>(maxCharCode, g.CharCode);
     }
 
 #if defined(OVR_BUILD_DEBUG)
@@ -1434,6 +1682,8 @@ bool BitmapFontLocal::Load(ovrFileSys& fileSys, char const* uri) {
 
     ALOG("Load Uri = %s", uri);
 
+    Generation = NextGeneration();
+
     if (!ovrUri::ParseUri(
             uri,
             scheme,
@@ -1486,6 +1736,7 @@ bool BitmapFontLocal::Load(ovrFileSys& fileSys, char const* uri) {
     if (FontProgram.VertexShader == 0 || FontProgram.FragmentShader == 0) {
         static ovrProgramParm fontUniformParms[] = {
             {.Name = "Texture0", .Type = ovrProgramParmType::TEXTURE_SAMPLED},
+            {.Name = "BillboardMatrix", .Type = ovrProgramParmType::FLOAT_MATRIX4},
         };
         FontProgram = GlProgram::Build(
             FontSingleTextureVertexShaderSrc,
@@ -2049,63 +2300,57 @@ void BitmapFontLocal::TruncateText(std::string& inOutText, int const maxLines) c
 //==============================
 // BitmapFontSurfaceLocal::BitmapFontSurface
 BitmapFontSurfaceLocal::BitmapFontSurfaceLocal()
-    : Vertices(nullptr),
-      MaxVertices(0),
-      MaxIndices(0),
-      CurVertex(0),
-      CurIndex(0),
-      Initialized(false) {}
+    : InitialVertices(0),
+      CullEnabled(true),
+      Initialized(false),
+      FrameNumber(0),
+      StreamedFrame(-1) {}
 
 //==============================
 // BitmapFontSurfaceLocal::~BitmapFontSurfaceLocal
 BitmapFontSurfaceLocal::~BitmapFontSurfaceLocal() {
-    FontSurfaceDef.geo.Free();
-    delete[] Vertices;
-    Vertices = nullptr;
+    for (auto& surfaceDef : FontSurfaceDefs) {
+        surfaceDef.geo.Free();
+    }
 }
 
 //==============================
 // BitmapFontSurfaceLocal::Init
-// Initializes the surface VBO
+// Initializes the surface VBO. maxVertices is only the initial size, the VBOs grow as needed.
 void BitmapFontSurfaceLocal::Init(const int maxVertices) {
-    OVR_ASSERT(
-        FontSurfaceDef.geo.vertexBuffer == 0 && FontSurfaceDef.geo.indexBuffer == 0 &&
-        FontSurfaceDef.geo.vertexArrayObject == 0);
-    OVR_ASSERT(Vertices == nullptr);
-    if (Vertices != nullptr) {
-        delete[] Vertices;
-        Vertices = nullptr;
-    }
+    OVR_ASSERT(FontSurfaceDefs.empty());
     OVR_ASSERT(maxVertices % 4 == 0);
 
-    MaxVertices = maxVertices;
-    MaxIndices = (maxVertices / 4) * 6;
+    InitialVertices = std::min(std::max(maxVertices, 4), MAX_SURFACE_VERTICES);
+    Vertices.reserve(InitialVertices);
 
-    Vertices = new fontVertex_t[maxVertices];
-
-    CurVertex = 0;
-    CurIndex = 0;
-
-    Bounds3f localBounds(Bounds3f::Init);
-    FontSurfaceDef.geo = FontGeometryCreate(Vertices, MaxVertices, localBounds);
-    FontSurfaceDef.geo.indexCount = 0; // if there's anything to render this will be modified
-    FontSurfaceDef.surfaceName = "font";
-
-    // FontSurfaceDef.graphicsCommand.GpuState.blendMode = GL_FUNC_ADD;
-    FontSurfaceDef.graphicsCommand.GpuState.blendSrc = ovrGpuState::kGL_SRC_ALPHA;
-    FontSurfaceDef.graphicsCommand.GpuState.blendDst = ovrGpuState::kGL_ONE_MINUS_SRC_ALPHA;
-    FontSurfaceDef.graphicsCommand.GpuState.blendEnable = ovrGpuState::BLEND_ENABLE;
-    FontSurfaceDef.graphicsCommand.GpuState.frontFace = ovrGpuState::kGL_CCW;
-    FontSurfaceDef.graphicsCommand.GpuState.depthEnable = true;
-    FontSurfaceDef.graphicsCommand.GpuState.depthMaskEnable = false;
-    FontSurfaceDef.graphicsCommand.GpuState.polygonOffsetEnable = false;
-    FontSurfaceDef.graphicsCommand.GpuState.cullEnable = true;
+    FontSurfaceDefs.resize(1);
+    InitSurface(FontSurfaceDefs[0], InitialVertices);
 
     Initialized = true;
 
     ALOG("BitmapFontSurfaceLocal::Init: success");
 }
 
+//==============================
+// BitmapFontSurfaceLocal::InitSurface
+void BitmapFontSurfaceLocal::InitSurface(ovrSurfaceDef& surfaceDef, int const numVertices) const {
+    Bounds3f localBounds(Bounds3f::Init);
+    surfaceDef.geo = FontGeometryCreate(nullptr, numVertices, localBounds);
+    surfaceDef.geo.indexCount = 0; // if there's anything to render this will be modified
+    surfaceDef.surfaceName = "font";
+
+    // surfaceDef.graphicsCommand.GpuState.blendMode = GL_FUNC_ADD;
+    surfaceDef.graphicsCommand.GpuState.blendSrc = ovrGpuState::kGL_SRC_ALPHA;
+    surfaceDef.graphicsCommand.GpuState.blendDst = ovrGpuState::kGL_ONE_MINUS_SRC_ALPHA;
+    surfaceDef.graphicsCommand.GpuState.blendEnable = ovrGpuState::BLEND_ENABLE;
+    surfaceDef.graphicsCommand.GpuState.frontFace = ovrGpuState::kGL_CCW;
+    surfaceDef.graphicsCommand.GpuState.depthEnable = true;
+    surfaceDef.graphicsCommand.GpuState.depthMaskEnable = false;
+    surfaceDef.graphicsCommand.GpuState.polygonOffsetEnable = false;
+    surfaceDef.graphicsCommand.GpuState.cullEnable = CullEnabled;
+}
+
 //==============================
 // BitmapFontSurfaceLocal::DrawText3D
 Vector3f BitmapFontSurfaceLocal::DrawText3D(
@@ -2124,10 +2369,48 @@ Vector3f BitmapFontSurfaceLocal::DrawText3D(
     if (text == nullptr || text[0] == '\0') {
         return Vector3f::ZERO; // nothing to do here, move along
     }
+
+    uint64_t const hash = ovrTextLayout::Hash(font, parms, normal, up, scale, color, text);
+    auto it = TextLayouts.find(hash);
+    if (it != TextLayouts.end() &&
+        it->second.Matches(font, parms, normal, up, scale, color, text)) {
+        ovrTextLayout& layout = it->second;
+        layout.LastFrame = FrameNumber;
+        if (!layout.Verts.empty()) {
+            VertexBlocks.push_back(VertexBlockType(
+                font,
+                layout.Verts.data(),
+                static_cast<int>(layout.Verts.size()),
+                pos,
+                layout.Radius,
+                Quatf(),
+                parms.Billboard,
+                parms.TrackRoll));
+        }
+        return layout.ToNextLine;
+    }
+
     Vector3f toNextLine;
     VertexBlockType vb =
         DrawTextToVertexBlock(font, parms, pos, normal, up, scale, color, text, &toNextLine);
 
+    // on a hash collision the cached layout is kept and this text is laid out every frame
+    if (it == TextLayouts.end()) {
+        ovrTextLayout& layout = TextLayouts[hash];
+        layout.Font = &font;
+        layout.FontGeneration = AsLocal(font).GetGeneration();
+        layout.Parms = parms;
+        layout.Text = text;
+        layout.Scale = scale;
+        layout.Normal = normal;
+        layout.Up = up;
+        layout.Color = color;
+        layout.Verts.assign(vb.Verts, vb.Verts + vb.NumVerts);
+        layout.Radius = vb.Radius;
+        layout.ToNextLine = toNextLine;
+        layout.LastFrame = FrameNumber;
+    }
+
     // add the new vertex block to the array of vertex blocks
     VertexBlocks.push_back(vb);
 
@@ -2194,118 +2477,149 @@ Vector3f BitmapFontSurfaceLocal::DrawTextBillboarded3Df(
     return DrawTextBillboarded3D(font, parms, pos, scale, color, buffer);
 }
 
-//==============================================================
-// vbSort_t
-// small structure that is used to sort vertex blocks by their distance to the camera
-//==============================================================
-struct vbSort_t {
-    int VertexBlockIndex;
-    float DistanceSquared;
-};
-
 //==============================
-// VertexBlockSortFn
-// sort function for vertex blocks
-int VertexBlockSortFn(void const* a, void const* b) {
-    return ftoi(((vbSort_t const*)a)->DistanceSquared - ((vbSort_t const*)b)->DistanceSquared);
+// RadixSortVertexBlocks
+// Sorts the vertex blocks from near to far. The sort is stable so blocks at the same distance
+// don't swap from frame to frame.
+static void RadixSortVertexBlocks(std::vector<vbSort_t>& blocks, std::vector<vbSort_t>& temp) {
+    RadixSort(blocks, temp, 32, [](vbSort_t const& b) { return RadixSortKey(b.DistanceSquared); });
 }
 
 //==============================
 // BitmapFontSurfaceLocal::Finish
-// transform all vertex blocks into the vertices array so they're ready to be uploaded to the VBO
-// We don't have to do this for each eye because the billboarded surfaces are sorted / aligned
-// based on the center view matrix's view direction.
+// Copy all vertex blocks into the vertex stream, or into the vertices array to be uploaded to the
+// VBOs if the stream can't be mapped.
+// Each vertex carries the pivot and billboard mode of its block, and the vertex shader orients
+// the billboarded blocks. We don't have to do this for each eye because the billboarded surfaces
+// are sorted / aligned based on the center view matrix's view direction.
 void BitmapFontSurfaceLocal::Finish(Matrix4f const& viewMatrix) {
     // SPAM( "BitmapFontSurfaceLocal::Finish" );
 
-    FontSurfaceDef.geo.localBounds.Clear();
-
-    Matrix4f invViewMatrix = viewMatrix.Inverted(); // if the view is never scaled or sheared we
-                                                    // could use Transposed() here instead
-    Vector3f viewPos = invViewMatrix.GetTranslation();
-    Vector3f viewUp = GetViewMatrixUp(viewMatrix);
+    BillboardMatrix = viewMatrix.Inverted(); // if the view is never scaled or sheared we
+                                             // could use Transposed() here instead
+    Vector3f const viewPos = BillboardMatrix.GetTranslation();
 
     // sort vertex blocks indices based on distance to pivot
-    int const MAX_VERTEX_BLOCKS = 256;
-    vbSort_t vbSort[MAX_VERTEX_BLOCKS];
-    int const n = VertexBlocks.size();
-    for (int i = 0; i < n; ++i) {
-        vbSort[i].VertexBlockIndex = i;
-        VertexBlockType& vb = VertexBlocks[i];
-        vbSort[i].DistanceSquared = (vb.Pivot - viewPos).LengthSq();
+    int const numBlocks = static_cast<int>(VertexBlocks.size());
+    VertexBlockSort.resize(numBlocks);
+    int maxVerts = 0;
+    for (int i = 0; i < numBlocks; ++i) {
+        VertexBlockType const& vb = VertexBlocks[i];
+        VertexBlockSort[i].VertexBlockIndex = i;
+        VertexBlockSort[i].DistanceSquared = (vb.Pivot - viewPos).LengthSq();
+        maxVerts += vb.NumVerts;
+    }
+
+    RadixSortVertexBlocks(VertexBlockSort, VertexBlockSortTemp);
+
+    int const maxSurfaces = (maxVerts + MAX_SURFACE_VERTICES - 1) / MAX_SURFACE_VERTICES;
+    while (static_cast<int>(FontSurfaceDefs.size()) < maxSurfaces) {
+        FontSurfaceDefs.emplace_back();
+        InitSurface(FontSurfaceDefs.back(), InitialVertices);
+    }
+    for (auto& surfaceDef : FontSurfaceDefs) {
+        surfaceDef.geo.localBounds.Clear();
+    }
+
+    // The stream is write-only memory, so each vertex is assembled locally and stored once.
+    GlStreamBuffer& stream = GetVertexStreamBuffer();
+    GlStreamBuffer::Allocation const alloc = stream.Map(maxVerts * sizeof(fontVertex_t));
+    bool const streamed = alloc.data != nullptr;
+    fontVertex_t* vertices = static_cast<fontVertex_t*>(alloc.data);
+    if (!streamed) {
+        if (static_cast<int>(Vertices.size()) < maxVerts) {
+            Vertices.resize(maxVerts);
+        }
+        vertices = Vertices.data();
     }
 
-    qsort(vbSort, n, sizeof(vbSort[0]), VertexBlockSortFn);
-
-    // transform the vertex blocks into the vertices array
-    CurIndex = 0;
-    CurVertex = 0;
-
     // TODO:
     // To add multiple-font-per-surface support, we need to add a 3rd component to s and t,
     // then get the font for each vertex block, and set the texture index on each vertex in
     // the third texture coordinate.
-    for (int i = 0; i < static_cast<int>(VertexBlocks.size()); ++i) {
-        VertexBlockType& vb = VertexBlocks[vbSort[i].VertexBlockIndex];
-        Matrix4f transform;
+    int numVerts = 0;
+    for (int i = 0; i < numBlocks; ++i) {
+        VertexBlockType& vb = VertexBlocks[VertexBlockSort[i].VertexBlockIndex];
+        float mode = 1.0f;
         if (vb.Billboard) {
             if (vb.TrackRoll) {
-                transform = invViewMatrix;
+                mode = 3.0f;
             } else {
-                Vector3f textNormal = viewPos - vb.Pivot;
-                float const len = textNormal.Length();
-                if (len < MATH_FLOAT_SMALLEST_NON_DENORMAL) {
+                // the text normal is undefined when the pivot is at the eye
+                float const minDistanceSquared = 1e-6f; // 1 mm
+                if (VertexBlockSort[i].DistanceSquared < minDistanceSquared) {
                     vb.Free();
                     continue;
                 }
-                textNormal *= 1.0f / len;
-                transform = Matrix4f::CreateFromBasisVectors(textNormal, viewUp * -1.0f);
+                mode = 2.0f;
             }
-            transform.SetTranslation(vb.Pivot);
-        } else {
-            transform.SetIdentity();
-            transform.SetTranslation(vb.Pivot);
         }
 
+        Vector4f const pivot(vb.Pivot.x, vb.Pivot.y, vb.Pivot.z, mode);
+        fontVertex_t* dst = vertices + numVerts;
         for (int j = 0; j < vb.NumVerts; j++) {
-            fontVertex_t const& v = vb.Verts[j];
-            Vector3f const position = transform.Transform(v.xyz);
-
-            // If you hit this assert you're likely trying to draw
-            // too much text for the current buffer size,
-            // most likely need to update the value
-            // passed to fontSurface->Init() in OvrGuiSysLocal::Init
-            //
-            // Note: Vertices is *not* a dynamic std::vector
-            // because it gets copies into GPU memory, which is reserved
-            // separately. If you decide to make this system dynamic
-            // remember to scale re-allocate the OpenGL VBOs as well
-            if (CurVertex >= MaxVertices) {
-                OVR_FAIL(
-                    "Application tried to draw more text than there is buffer for. "
-                    "This failure protects agains a buffer overflow");
-            }
-
-            Vertices[CurVertex].xyz = position;
-            Vertices[CurVertex].s = v.s;
-            Vertices[CurVertex].t = v.t;
-            *(std::uint32_t*)(&Vertices[CurVertex].rgba[0]) = *(std::uint32_t*)(&v.rgba[0]);
-            *(std::uint32_t*)(&Vertices[CurVertex].fontParms[0]) =
-                *(std::uint32_t*)(&v.fontParms[0]);
-            CurVertex++;
+            fontVertex_t v = vb.Verts[j];
+            v.pivot = pivot;
+            dst[j] = v;
+        }
 
-            FontSurfaceDef.geo.localBounds.AddPoint(position);
+        // the block may straddle two surfaces
+        Vector3f const extent(vb.Radius);
+        int const firstSurface = numVerts / MAX_SURFACE_VERTICES;
+        int const lastSurface = (numVerts + std::max(vb.NumVerts, 1) - 1) / MAX_SURFACE_VERTICES;
+        for (int j = firstSurface; j <= lastSurface; j++) {
+            FontSurfaceDefs[j].geo.localBounds.AddPoint(vb.Pivot - extent);
+            FontSurfaceDefs[j].geo.localBounds.AddPoint(vb.Pivot + extent);
         }
-        CurIndex += (vb.NumVerts / 2) * 3;
+
+        numVerts += vb.NumVerts;
         // free this vertex block
         vb.Free();
     }
+    if (streamed) {
+        stream.Unmap();
+    }
     // remove all elements from the vertex block (but don't free the memory since it's likely to be
     // needed on the next frame.
     VertexBlocks.clear();
 
-    // Update Geometry
-    FontGeometryUpdate(FontSurfaceDef.geo, Vertices, CurVertex, CurIndex);
+    // Evict layouts that have not been drawn for a few frames, so text that changes every frame
+    // doesn't accumulate. Layouts used this frame are never evicted while blocks point at them.
+    uint32_t const MAX_UNUSED_FRAMES = 8;
+    for (auto it = TextLayouts.begin(); it != TextLayouts.end();) {
+        if (FrameNumber - it->second.LastFrame > MAX_UNUSED_FRAMES) {
+            it = TextLayouts.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    FrameNumber++;
+
+    // Update Geometry, growing the surfaces that are too small. The index buffers are sized by
+    // the surface, the VBOs are only used when the vertices aren't streamed.
+    for (int i = 0; i < static_cast<int>(FontSurfaceDefs.size()); ++i) {
+        GlGeometry& geo = FontSurfaceDefs[i].geo;
+        int const first = i * MAX_SURFACE_VERTICES;
+        int const count = std::max(0, std::min(numVerts - first, MAX_SURFACE_VERTICES));
+        if (count == 0) {
+            geo.indexCount = 0;
+            continue;
+        }
+        if (count > geo.vertexCount) {
+            int const newVertexCount = std::min(
+                std::max(count, geo.vertexCount * 2), MAX_SURFACE_VERTICES);
+            Bounds3f localBounds = geo.localBounds;
+            geo.Free();
+            geo = FontGeometryCreate(nullptr, newVertexCount, localBounds);
+        }
+        if (streamed) {
+            size_t const offset = alloc.offset + first * sizeof(fontVertex_t);
+            FontGeometryBindStream(geo, alloc.buffer, offset, (count / 2) * 3);
+        } else {
+            FontGeometryUpdate(geo, Vertices.data() + first, count, (count / 2) * 3);
+        }
+    }
+    StreamedFrame = streamed ? stream.GetFrameIndex() : -1;
 }
 
 //==============================
@@ -2313,22 +2627,33 @@ void BitmapFontSurfaceLocal::Finish(Matrix4f const& viewMatrix) {
 void BitmapFontSurfaceLocal::AppendSurfaceList(
     BitmapFont const& font,
     std::vector<ovrDrawSurface>& surfaceList) const {
-    if (FontSurfaceDef.geo.indexCount == 0) {
+    // streamed vertices are only valid in the frame Finish() wrote them
+    if (StreamedFrame >= 0 && StreamedFrame != GetVertexStreamBuffer().GetFrameIndex()) {
         return;
     }
 
-    ovrDrawSurface drawSurf;
+    for (auto& surfaceDef : FontSurfaceDefs) {
+        if (surfaceDef.geo.indexCount == 0) {
+            continue;
+        }
+
+        ovrDrawSurface drawSurf;
 
-    FontSurfaceDef.graphicsCommand.Program = AsLocal(font).GetFontProgram();
-    FontSurfaceDef.graphicsCommand.UniformData[0].Data = (void*)&AsLocal(font).GetFontTexture();
+        surfaceDef.graphicsCommand.Program = AsLocal(font).GetFontProgram();
+        surfaceDef.graphicsCommand.UniformData[0].Data = (void*)&AsLocal(font).GetFontTexture();
+        surfaceDef.graphicsCommand.UniformData[1].Data = (void*)&BillboardMatrix;
 
-    drawSurf.surface = &FontSurfaceDef;
+        drawSurf.surface = &surfaceDef;
 
-    surfaceList.push_back(drawSurf);
+        surfaceList.push_back(drawSurf);
+    }
 }
 
 void BitmapFontSurfaceLocal::SetCullEnabled(const bool enabled) {
-    FontSurfaceDef.graphicsCommand.GpuState.cullEnable = enabled;
+    CullEnabled = enabled;
+    for (auto& surfaceDef : FontSurfaceDefs) {
+        surfaceDef.graphicsCommand.GpuState.cullEnable = enabled;
+    }
 }
 
 //==============================
@@ -28,7 +28,9 @@ Authors     :   Jonathan E. Wright
 #include "DebugLines.h"
 #include "GlGeometry.h"
 #include "GlProgram.h"
+#include "GlStreamBuffer.h"
 
+#include <algorithm>
 #include <cstdlib>
 
 using OVR::Bounds3f;
@@ -60,6 +62,20 @@ static const char* DebugLineFragmentSrc = R"glsl(
 	}
 )glsl";
 
+// Vertex the lines are streamed in every frame.
+struct debugLineVertex_t {
+    Vector3f position;
+    Vector4f color;
+
+    static VertexStreamLayout GetStreamLayout() {
+        VertexStreamLayout stream;
+        stream.position = offsetof(debugLineVertex_t, position);
+        stream.color = offsetof(debugLineVertex_t, color);
+        stream.stride = sizeof(debugLineVertex_t);
+        return stream;
+    }
+};
+
 //==============================================================
 // OvrDebugLinesLocal
 //
@@ -163,7 +179,7 @@ void OvrDebugLinesLocal::Init(float lineWidth) {
     for (LineIndex_t i = 0; i < MAX_INDICES; ++i) {
         indices.push_back(i);
     }
-    // Vertex buffers are allocated based on the vector capacity
+    // CPU side storage for the lines, they are streamed to the GPU when drawn
     NonDepthTested.Attr.position.reserve(MAX_INDICES);
     DepthTested.Attr.position.reserve(MAX_INDICES);
     NonDepthTested.Attr.color.reserve(MAX_INDICES);
@@ -201,11 +217,31 @@ void OvrDebugLinesLocal::Shutdown() {
 void OvrDebugLinesLocal::AppendSurfaceList(std::vector<ovrDrawSurface>& surfaceList) {
     for (int j = 0; j < 2; j++) {
         DebugLines_t& dl = j == 0 ? NonDepthTested : DepthTested;
-        int verts = dl.Attr.position.size();
+        // the index buffer only covers MAX_DEBUG_LINES lines
+        const int maxVerts = MAX_DEBUG_LINES * 2;
+        const int verts = std::min(static_cast<int>(dl.Attr.position.size()), maxVerts);
         if (verts == 0) {
             continue;
         }
-        dl.Surf.geo.Update(dl.Attr);
+
+        // interleave the lines straight into the vertex stream
+        GlStreamBuffer& stream = GetVertexStreamBuffer();
+        const GlStreamBuffer::Allocation alloc = stream.Map(verts * sizeof(debugLineVertex_t));
+        debugLineVertex_t* dst = static_cast<debugLineVertex_t*>(alloc.data);
+        if (dst == nullptr) {
+            continue;
+        }
+        for (int i = 0; i < verts; i++) {
+            dst[i] = {dl.Attr.position[i], dl.Attr.color[i]};
+        }
+        stream.Unmap();
+
+        dl.Surf.geo.BindVertexStream(
+            alloc.buffer,
+            alloc.offset,
+            debugLineVertex_t::GetStreamLayout(),
+            VertexLayout::Full());
+        dl.Surf.geo.vertexCount = verts;
         dl.Surf.geo.indexCount = verts;
         surfaceList.push_back(dl.DrawSurf);
     }
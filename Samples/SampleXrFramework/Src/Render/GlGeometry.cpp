@@ -30,6 +30,8 @@ Authors     :   John Carmack, J.M.P. van Waveren
 #include "Misc/Log.h"
 #include "Egl.h"
 
+#include <algorithm>
+
 using OVR::Bounds3f;
 using OVR::Vector2f;
 using OVR::Vector3f;
@@ -42,62 +44,140 @@ using OVR::Vector4f;
  */
 namespace OVRFW {
 
-unsigned GlGeometry::IndexType = (sizeof(TriangleIndex) == 2) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
-
-template <typename _attrib_type_>
-void PackVertexAttribute(
-    std::vector<uint8_t>& packed,
-    const std::vector<_attrib_type_>& attrib,
+static void SetVertexAttribute(
     const int glLocation,
-    const int glType,
-    const int glComponents) {
-    if (attrib.size() > 0) {
-        const size_t offset = packed.size();
-        const size_t size = attrib.size() * sizeof(attrib[0]);
-
-        packed.resize(offset + size);
-        memcpy(&packed[offset], attrib.data(), size);
-
-        glEnableVertexAttribArray(glLocation);
-        glVertexAttribPointer(
-            glLocation, glComponents, glType, false, sizeof(attrib[0]), (void*)(offset));
-    } else {
+    const int offset,
+    const int stride,
+    const VertexFormat format,
+    const int components) {
+    if (offset < 0) {
         glDisableVertexAttribArray(glLocation);
+        return;
+    }
+
+    GLint size = components;
+    GLenum type = GL_FLOAT;
+    GLboolean normalized = GL_FALSE;
+    switch (format) {
+        case VertexFormat::Float32:
+            break;
+        case VertexFormat::Float16:
+            type = GL_HALF_FLOAT;
+            break;
+        case VertexFormat::Unorm16:
+            type = GL_UNSIGNED_SHORT;
+            normalized = GL_TRUE;
+            break;
+        case VertexFormat::Unorm8:
+            type = GL_UNSIGNED_BYTE;
+            normalized = GL_TRUE;
+            break;
+        case VertexFormat::Snorm10:
+            // packed formats are always 4 components; shaders read xyz and ignore w
+            size = 4;
+            type = GL_INT_2_10_10_10_REV;
+            normalized = GL_TRUE;
+            break;
+        case VertexFormat::Int32:
+            type = GL_INT;
+            break;
+        case VertexFormat::Uint8:
+            type = GL_UNSIGNED_BYTE;
+            break;
     }
+
+    glEnableVertexAttribArray(glLocation);
+    glVertexAttribPointer(glLocation, size, type, normalized, stride, (void*)(size_t)offset);
 }
 
-void GlGeometry::Create(const VertexAttribs& attribs, const std::vector<TriangleIndex>& indices) {
-    vertexCount = attribs.position.size();
+static void SetVertexAttributes(
+    const VertexStreamLayout& s,
+    const VertexLayout& layout,
+    const size_t baseOffset = 0) {
+    auto at = [baseOffset](const int offset) {
+        return offset < 0 ? -1 : static_cast<int>(baseOffset + offset);
+    };
+    SetVertexAttribute(
+        VERTEX_ATTRIBUTE_LOCATION_POSITION, at(s.position), s.stride, VertexFormat::Float32, 3);
+    SetVertexAttribute(
+        VERTEX_ATTRIBUTE_LOCATION_NORMAL, at(s.normal), s.stride, layout.normal, 3);
+    SetVertexAttribute(
+        VERTEX_ATTRIBUTE_LOCATION_TANGENT, at(s.tangent), s.stride, layout.tangent, 3);
+    SetVertexAttribute(
+        VERTEX_ATTRIBUTE_LOCATION_BINORMAL, at(s.binormal), s.stride, layout.binormal, 3);
+    SetVertexAttribute(VERTEX_ATTRIBUTE_LOCATION_COLOR, at(s.color), s.stride, layout.color, 4);
+    SetVertexAttribute(VERTEX_ATTRIBUTE_LOCATION_UV0, at(s.uv0), s.stride, layout.uv0, 2);
+    SetVertexAttribute(VERTEX_ATTRIBUTE_LOCATION_UV1, at(s.uv1), s.stride, layout.uv1, 2);
+    SetVertexAttribute(
+        VERTEX_ATTRIBUTE_LOCATION_JOINT_INDICES,
+        at(s.jointIndices),
+        s.stride,
+        layout.jointIndices,
+        4);
+    SetVertexAttribute(
+        VERTEX_ATTRIBUTE_LOCATION_JOINT_WEIGHTS,
+        at(s.jointWeights),
+        s.stride,
+        layout.jointWeights,
+        4);
+}
+
+void GlGeometry::Create(
+    const VertexAttribs& attribs,
+    const std::vector<TriangleIndex>& indices,
+    const VertexLayout& layout) {
+    indexType = kIndexTypeUnsignedShort;
+    indexCount = indices.size();
+    CreateBuffers(attribs, indices.data(), indices.size() * sizeof(indices[0]), layout);
+}
+
+void GlGeometry::Create(
+    const VertexAttribs& attribs,
+    const std::vector<TriangleIndex32>& indices,
+    const VertexLayout& layout) {
+    // 16-bit indices take half the memory and fetch bandwidth
+    const TriangleIndex32 maxIndex =
+        indices.empty() ? 0 : *std::max_element(indices.begin(), indices.end());
+    if (maxIndex < static_cast<TriangleIndex32>(MAX_GEOMETRY_VERTICES)) {
+        const std::vector<TriangleIndex> indices16(indices.begin(), indices.end());
+        Create(attribs, indices16, layout);
+        return;
+    }
+    indexType = kIndexTypeUnsignedInt;
     indexCount = indices.size();
+    CreateBuffers(attribs, indices.data(), indices.size() * sizeof(indices[0]), layout);
+}
+
+void GlGeometry::CreateBuffers(
+    const VertexAttribs& attribs,
+    const void* indices,
+    const size_t indexBytes,
+    const VertexLayout& layout) {
+    vertexCount = attribs.position.size();
+    vertexLayout = layout;
 
     const bool t = enableGeometryTransfom;
-    std::vector<OVR::Vector3f> position;
-    std::vector<OVR::Vector3f> normal;
-    std::vector<OVR::Vector3f> tangent;
-    std::vector<OVR::Vector3f> binormal;
+    VertexAttribs transformed;
 
     /// we asked for incoming transfom
     if (t) {
-        position.resize(attribs.position.size());
-        normal.resize(attribs.normal.size());
-        tangent.resize(attribs.position.size());
-        binormal.resize(attribs.binormal.size());
+        transformed = attribs;
 
         /// Positions use 4x4
         for (size_t i = 0; i < attribs.position.size(); ++i) {
-            position[i] = geometryTransfom.Transform(attribs.position[i]);
+            transformed.position[i] = geometryTransfom.Transform(attribs.position[i]);
         }
 
         /// TBN use 3x3
         const OVR::Matrix3f nt = OVR::Matrix3f(geometryTransfom).Inverse().Transposed();
         for (size_t i = 0; i < attribs.normal.size(); ++i) {
-            normal[i] = nt.Transform(attribs.normal[i]).Normalized();
+            transformed.normal[i] = nt.Transform(attribs.normal[i]).Normalized();
         }
         for (size_t i = 0; i < attribs.tangent.size(); ++i) {
-            tangent[i] = nt.Transform(attribs.tangent[i]).Normalized();
+            transformed.tangent[i] = nt.Transform(attribs.tangent[i]).Normalized();
         }
         for (size_t i = 0; i < attribs.binormal.size(); ++i) {
-            binormal[i] = nt.Transform(attribs.binormal[i]).Normalized();
+            transformed.binormal[i] = nt.Transform(attribs.binormal[i]).Normalized();
         }
     }
 
@@ -108,31 +188,13 @@ void GlGeometry::Create(const VertexAttribs& attribs, const std::vector<Triangle
     glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
 
     std::vector<uint8_t> packed;
-    PackVertexAttribute(
-        packed, t ? position : attribs.position, VERTEX_ATTRIBUTE_LOCATION_POSITION, GL_FLOAT, 3);
-    PackVertexAttribute(
-        packed, t ? normal : attribs.normal, VERTEX_ATTRIBUTE_LOCATION_NORMAL, GL_FLOAT, 3);
-    PackVertexAttribute(
-        packed, t ? tangent : attribs.tangent, VERTEX_ATTRIBUTE_LOCATION_TANGENT, GL_FLOAT, 3);
-    PackVertexAttribute(
-        packed, t ? binormal : attribs.binormal, VERTEX_ATTRIBUTE_LOCATION_BINORMAL, GL_FLOAT, 3);
-    PackVertexAttribute(packed, attribs.color, VERTEX_ATTRIBUTE_LOCATION_COLOR, GL_FLOAT, 4);
-    PackVertexAttribute(packed, attribs.uv0, VERTEX_ATTRIBUTE_LOCATION_UV0, GL_FLOAT, 2);
-    PackVertexAttribute(packed, attribs.uv1, VERTEX_ATTRIBUTE_LOCATION_UV1, GL_FLOAT, 2);
-    PackVertexAttribute(
-        packed, attribs.jointIndices, VERTEX_ATTRIBUTE_LOCATION_JOINT_INDICES, GL_INT, 4);
-    PackVertexAttribute(
-        packed, attribs.jointWeights, VERTEX_ATTRIBUTE_LOCATION_JOINT_WEIGHTS, GL_FLOAT, 4);
-    // clang-format off
+    const VertexStreamLayout stream = PackVertexAttribs(t ? transformed : attribs, layout, packed);
+    SetVertexAttributes(stream, layout);
 
     glBufferData(GL_ARRAY_BUFFER, packed.size() * sizeof(packed[0]), packed.data(), GL_STATIC_DRAW);
 
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
-    glBufferData(
-        GL_ELEMENT_ARRAY_BUFFER,
-        indices.size() * sizeof(indices[0]),
-        indices.data(),
-        GL_STATIC_DRAW);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexBytes, indices, GL_STATIC_DRAW);
 
     glBindVertexArray(0);
 
@@ -160,17 +222,8 @@ void GlGeometry::Update(const VertexAttribs& attribs, const bool updateBounds) {
     glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
 
     std::vector<uint8_t> packed;
-    PackVertexAttribute(packed, attribs.position, VERTEX_ATTRIBUTE_LOCATION_POSITION, GL_FLOAT, 3);
-    PackVertexAttribute(packed, attribs.normal, VERTEX_ATTRIBUTE_LOCATION_NORMAL, GL_FLOAT, 3);
-    PackVertexAttribute(packed, attribs.tangent, VERTEX_ATTRIBUTE_LOCATION_TANGENT, GL_FLOAT, 3);
-    PackVertexAttribute(packed, attribs.binormal, VERTEX_ATTRIBUTE_LOCATION_BINORMAL, GL_FLOAT, 3);
-    PackVertexAttribute(packed, attribs.color, VERTEX_ATTRIBUTE_LOCATION_COLOR, GL_FLOAT, 4);
-    PackVertexAttribute(packed, attribs.uv0, VERTEX_ATTRIBUTE_LOCATION_UV0, GL_FLOAT, 2);
-    PackVertexAttribute(packed, attribs.uv1, VERTEX_ATTRIBUTE_LOCATION_UV1, GL_FLOAT, 2);
-    PackVertexAttribute(
-        packed, attribs.jointIndices, VERTEX_ATTRIBUTE_LOCATION_JOINT_INDICES, GL_INT, 4);
-    PackVertexAttribute(
-        packed, attribs.jointWeights, VERTEX_ATTRIBUTE_LOCATION_JOINT_WEIGHTS, GL_FLOAT, 4);
+    const VertexStreamLayout stream = PackVertexAttribs(attribs, vertexLayout, packed);
+    SetVertexAttributes(stream, vertexLayout);
 
     glBufferData(GL_ARRAY_BUFFER, packed.size() * sizeof(packed[0]), packed.data(), GL_STATIC_DRAW);
 
@@ -182,6 +235,24 @@ void GlGeometry::Update(const VertexAttribs& attribs, const bool updateBounds) {
     }
 }
 
+void GlGeometry::UpdateVertexRange(const void* packed, const size_t offset, const size_t size) {
+    glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+    glBufferSubData(GL_ARRAY_BUFFER, offset, size, packed);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void GlGeometry::BindVertexStream(
+    const uint32_t buffer,
+    const size_t offset,
+    const VertexStreamLayout& stream,
+    const VertexLayout& layout) {
+    glBindVertexArray(vertexArrayObject);
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    SetVertexAttributes(stream, layout, offset);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
 void GlGeometry::Free() {
     glDeleteVertexArrays(1, &vertexArrayObject);
     glDeleteBuffers(1, &indexBuffer);
@@ -192,33 +263,42 @@ void GlGeometry::Free() {
     vertexArrayObject = 0;
     vertexCount = 0;
     indexCount = 0;
+    indexType = kIndexTypeUnsignedShort;
 
     localBounds.Clear();
 }
 
-// Sets up VB and VAO for font drawing
-GlGeometry FontGeometryCreate(fontVertex_t* verts, int numVerts, OVR::Bounds3f& localBounds) {
-    GlGeometry Geo;
-
-    const int maxQuads = numVerts / 4;
-    Geo.indexCount = maxQuads * 6;
-    Geo.vertexCount = maxQuads * 4;
-
-    Geo.localBounds = localBounds;
-
-    // font VAO
-    glGenVertexArrays(1, &Geo.vertexArrayObject);
-    glBindVertexArray(Geo.vertexArrayObject);
+bool PreferSplitGeometry(const std::vector<GeometrySplit>& splits, const int vertexCount) {
+    // The driver's recommended vertex count for a single draw. Only split for devices that
+    // recommend draws small enough for 16-bit indices.
+    static GLint maxElementsVertices = -1;
+    if (maxElementsVertices < 0) {
+        maxElementsVertices = 0;
+        glGetIntegerv(GL_MAX_ELEMENTS_VERTICES, &maxElementsVertices);
+    }
+    if (maxElementsVertices <= 0 || maxElementsVertices > GlGeometry::MAX_GEOMETRY_VERTICES) {
+        return false;
+    }
 
-    // vertex buffer
-    const int vertexByteCount = Geo.vertexCount * sizeof(fontVertex_t);
-    glGenBuffers(1, &Geo.vertexBuffer);
-    glBindBuffer(GL_ARRAY_BUFFER, Geo.vertexBuffer);
-    glBufferData(GL_ARRAY_BUFFER, vertexByteCount, nullptr, GL_DYNAMIC_DRAW);
+    // Vertices duplicated on the seams are transformed once per sub-mesh. Keep the shared
+    // 32-bit mesh if the seams would add more than a quarter to the vertex count.
+    size_t splitVertices = 0;
+    for (const GeometrySplit& split : splits) {
+        splitVertices += split.vertices.size();
+    }
+    return splitVertices * 4 <= static_cast<size_t>(vertexCount) * 5;
+}
 
+// Font vertex attributes of the VAO and GL_ARRAY_BUFFER that are currently bound
+static void SetFontVertexAttributes(const size_t baseOffset) {
     glEnableVertexAttribArray(VERTEX_ATTRIBUTE_LOCATION_POSITION); // x, y and z
     glVertexAttribPointer(
-        VERTEX_ATTRIBUTE_LOCATION_POSITION, 3, GL_FLOAT, GL_FALSE, sizeof(fontVertex_t), nullptr);
+        VERTEX_ATTRIBUTE_LOCATION_POSITION,
+        3,
+        GL_FLOAT,
+        GL_FALSE,
+        sizeof(fontVertex_t),
+        (void*)baseOffset);
 
     glEnableVertexAttribArray(VERTEX_ATTRIBUTE_LOCATION_UV0); // s and t
     glVertexAttribPointer(
@@ -227,7 +307,7 @@ GlGeometry FontGeometryCreate(fontVertex_t* verts, int numVerts, OVR::Bounds3f&
         GL_FLOAT,
         GL_FALSE,
         sizeof(fontVertex_t),
-        (void*)offsetof(fontVertex_t, s));
+        (void*)(baseOffset + offsetof(fontVertex_t, s)));
 
     glEnableVertexAttribArray(VERTEX_ATTRIBUTE_LOCATION_COLOR); // color
     glVertexAttribPointer(
@@ -236,7 +316,7 @@ GlGeometry FontGeometryCreate(fontVertex_t* verts, int numVerts, OVR::Bounds3f&
         GL_UNSIGNED_BYTE,
         GL_TRUE,
         sizeof(fontVertex_t),
-        (void*)offsetof(fontVertex_t, rgba));
+        (void*)(baseOffset + offsetof(fontVertex_t, rgba)));
 
     glDisableVertexAttribArray(VERTEX_ATTRIBUTE_LOCATION_UV1);
 
@@ -247,7 +327,39 @@ GlGeometry FontGeometryCreate(fontVertex_t* verts, int numVerts, OVR::Bounds3f&
         GL_UNSIGNED_BYTE,
         GL_TRUE,
         sizeof(fontVertex_t),
-        (void*)offsetof(fontVertex_t, fontParms));
+        (void*)(baseOffset + offsetof(fontVertex_t, fontParms)));
+
+    glEnableVertexAttribArray(VERTEX_ATTRIBUTE_LOCATION_FONT_PIVOT); // block pivot and billboard
+    glVertexAttribPointer(
+        VERTEX_ATTRIBUTE_LOCATION_FONT_PIVOT,
+        4,
+        GL_FLOAT,
+        GL_FALSE,
+        sizeof(fontVertex_t),
+        (void*)(baseOffset + offsetof(fontVertex_t, pivot)));
+}
+
+// Sets up VB and VAO for font drawing
+GlGeometry FontGeometryCreate(fontVertex_t* verts, int numVerts, OVR::Bounds3f& localBounds) {
+    GlGeometry Geo;
+
+    const int maxQuads = numVerts / 4;
+    Geo.indexCount = maxQuads * 6;
+    Geo.vertexCount = maxQuads * 4;
+
+    Geo.localBounds = localBounds;
+
+    // font VAO
+    glGenVertexArrays(1, &Geo.vertexArrayObject);
+    glBindVertexArray(Geo.vertexArrayObject);
+
+    // vertex buffer
+    const int vertexByteCount = Geo.vertexCount * sizeof(fontVertex_t);
+    glGenBuffers(1, &Geo.vertexBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, Geo.vertexBuffer);
+    glBufferData(GL_ARRAY_BUFFER, vertexByteCount, nullptr, GL_DYNAMIC_DRAW);
+
+    SetFontVertexAttributes(0);
 
     fontIndex_t* indices = new fontIndex_t[Geo.indexCount];
     const int indexByteCount = Geo.indexCount * sizeof(fontIndex_t);
@@ -272,10 +384,12 @@ GlGeometry FontGeometryCreate(fontVertex_t* verts, int numVerts, OVR::Bounds3f&
 
     delete[] indices;
 
-    glBindVertexArray(Geo.vertexArrayObject);
-    glBindBuffer(GL_ARRAY_BUFFER, Geo.vertexBuffer);
-    glBufferSubData(GL_ARRAY_BUFFER, 0, numVerts * sizeof(fontVertex_t), (void*)verts);
-    glBindVertexArray(0);
+    if (verts != nullptr) {
+        glBindVertexArray(Geo.vertexArrayObject);
+        glBindBuffer(GL_ARRAY_BUFFER, Geo.vertexBuffer);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, numVerts * sizeof(fontVertex_t), (void*)verts);
+        glBindVertexArray(0);
+    }
 
     return Geo;
 }
@@ -285,7 +399,22 @@ void FontGeometryUpdate(GlGeometry& geo, fontVertex_t* verts, int numVerts, int
     glBindVertexArray(geo.vertexArrayObject);
     glBindBuffer(GL_ARRAY_BUFFER, geo.vertexBuffer);
     glBufferSubData(GL_ARRAY_BUFFER, 0, numVerts * sizeof(fontVertex_t), (void*)verts);
+    // the vertices may have been streamed from another buffer before
+    SetFontVertexAttributes(0);
+    glBindVertexArray(0);
+    geo.indexCount = numIndices;
+}
+
+void FontGeometryBindStream(
+    GlGeometry& geo,
+    const uint32_t buffer,
+    const size_t offset,
+    int numIndices) {
+    glBindVertexArray(geo.vertexArrayObject);
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    SetFontVertexAttributes(offset);
     glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
     geo.indexCount = numIndices;
 }
 
@@ -27,6 +27,8 @@ Authors     :   John Carmack
 
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <vector>
 #include "OVR_Math.h"
 
@@ -44,28 +46,158 @@ struct VertexAttribs {
     std::vector<OVR::Vector4f> jointWeights;
 };
 
+// Storage format of one vertex attribute in the interleaved vertex buffer. The vertex fetch
+// expands every format back to floats, so shaders don't depend on which one was chosen.
+enum class VertexFormat : uint8_t {
+    Float32, // 32-bit float per component
+    Float16, // 16-bit half float per component
+    Unorm16, // [0, 1] as normalized 16-bit unsigned per component
+    Unorm8, // [0, 1] as normalized 8-bit unsigned per component
+    Snorm10, // [-1, 1] xyz packed into one normalized 10-10-10-2 word
+    Int32, // 32-bit integer per component
+    Uint8, // 0 to 255 as 8-bit unsigned integer per component
+};
+
+// Per-attribute formats used to pack VertexAttribs into the vertex buffer.
+// Positions are always stored as 32-bit floats.
+struct VertexLayout {
+    VertexFormat normal = VertexFormat::Float32;
+    VertexFormat tangent = VertexFormat::Float32;
+    VertexFormat binormal = VertexFormat::Float32;
+    VertexFormat color = VertexFormat::Float32;
+    VertexFormat uv0 = VertexFormat::Float32;
+    VertexFormat uv1 = VertexFormat::Float32;
+    VertexFormat jointIndices = VertexFormat::Int32;
+    VertexFormat jointWeights = VertexFormat::Float32;
+
+    // Full precision, exactly what VertexAttribs holds.
+    static VertexLayout Full() {
+        return VertexLayout();
+    }
+    // The smallest format per attribute whose range covers the data: 10-10-10-2 for unit
+    // vectors, unorm8 colors, unorm16 or half float UVs, u8 joint indices and unorm16 weights.
+    // Any attribute with values out of range for its compact format stays at full precision.
+    static VertexLayout Compact(const VertexAttribs& attribs);
+};
+
+// Byte offset of each attribute within one interleaved vertex, -1 if it is not stored.
+struct VertexStreamLayout {
+    int position = -1;
+    int normal = -1;
+    int tangent = -1;
+    int binormal = -1;
+    int color = -1;
+    int uv0 = -1;
+    int uv1 = -1;
+    int jointIndices = -1;
+    int jointWeights = -1;
+    int stride = 0;
+};
+
+// Interleaves attribs into a single vertex stream in the given layout. An attribute is stored
+// if it is not empty; vertices past the end of a shorter attribute array are zero filled.
+VertexStreamLayout PackVertexAttribs(
+    const VertexAttribs& attribs,
+    const VertexLayout& layout,
+    std::vector<uint8_t>& packed);
+
+// Bytes one vertex of attribs takes when packed in the given layout.
+int GetPackedVertexSize(const VertexAttribs& attribs, const VertexLayout& layout);
+
+// Writes one attribute value of components floats in the given format, e.g. into a vertex
+// packed by PackVertexAttribs at the offset from its VertexStreamLayout.
+void PackVertexComponents(
+    uint8_t* dst,
+    const float* src,
+    const int components,
+    const VertexFormat format);
+
+// Conversions used for the compact formats.
+uint16_t EncodeFloat16(const float f);
+float DecodeFloat16(const uint16_t h);
+uint32_t EncodeSnorm10(const OVR::Vector3f& v);
+OVR::Vector3f DecodeSnorm10(const uint32_t packed);
+
 using TriangleIndex = uint16_t;
+// Indices of meshes with more vertices than TriangleIndex can address.
+using TriangleIndex32 = uint32_t;
+
+// Steps of OptimizeGeometry.
+struct GeometryOptimizeParms {
+    GeometryOptimizeParms()
+        : deduplicate(true),
+          reorderTriangles(true),
+          reduceOverdraw(true),
+          renumberVertices(true),
+          useDiskCache(true) {}
+
+    bool deduplicate; // merge vertices whose attributes are all identical
+    bool reorderTriangles; // leave off when the draw order matters, e.g. for blended surfaces
+    bool reduceOverdraw; // draw outward facing patches first, only with reorderTriangles
+    bool renumberVertices; // leave off when code outside the model addresses vertices by index
+    bool useDiskCache; // keep the result of large meshes in the application cache path
+};
+
+// Results of OptimizeGeometry. ACMR is the average number of post-transform vertex cache
+// misses per triangle, for a FIFO cache of GEOMETRY_CACHE_SIZE vertices.
+struct GeometryOptimizeStats {
+    GeometryOptimizeStats()
+        : triangleCount(0),
+          verticesBefore(0),
+          verticesAfter(0),
+          acmrBefore(0.0f),
+          acmrAfter(0.0f),
+          fromDiskCache(false) {}
+
+    int triangleCount;
+    int verticesBefore;
+    int verticesAfter;
+    float acmrBefore;
+    float acmrAfter;
+    bool fromDiskCache;
+};
 
 // Font specific vertex
 
 struct fontVertex_t {
-    fontVertex_t() : xyz(0.0f), s(0.0f), t(0.0f), rgba(), fontParms() {}
+    fontVertex_t()
+        : xyz(0.0f), s(0.0f), t(0.0f), rgba(), fontParms(), pivot(0.0f, 0.0f, 0.0f, 1.0f) {}
 
     OVR::Vector3f xyz;
     float s;
     float t;
     std::uint8_t rgba[4];
     std::uint8_t fontParms[4];
+    OVR::Vector4f pivot; // xyz is added to xyz after billboarding, w is the billboard mode
 };
 
 using fontIndex_t = TriangleIndex;
 
+// Vertex of the beam, billboard and ribbon renderers, which write their vertices straight into
+// the vertex stream (see GlStreamBuffer) every frame.
+struct colorTexVertex_t {
+    OVR::Vector3f position;
+    OVR::Vector4f color;
+    OVR::Vector2f uv0;
+
+    static VertexStreamLayout GetStreamLayout() {
+        VertexStreamLayout stream;
+        stream.position = offsetof(colorTexVertex_t, position);
+        stream.color = offsetof(colorTexVertex_t, color);
+        stream.uv0 = offsetof(colorTexVertex_t, uv0);
+        stream.stride = sizeof(colorTexVertex_t);
+        return stream;
+    }
+};
+
 class GlGeometry {
    public:
     static constexpr uint32_t kPrimitiveTypePoints = 0x0000; /* GL_POINTS */
     static constexpr uint32_t kPrimitiveTypeLines = 0x0001; /* GL_LINES */
     static constexpr uint32_t kPrimitiveTypeTriangles = 0x0004; /* GL_TRIANGLES */
     static constexpr uint32_t kPrimitiveTypeTriangleFan = 0x0006; /* GL_TRIANGLE_FAN */
+    static constexpr uint32_t kIndexTypeUnsignedShort = 0x1403; /* GL_UNSIGNED_SHORT */
+    static constexpr uint32_t kIndexTypeUnsignedInt = 0x1405; /* GL_UNSIGNED_INT */
 
    public:
     GlGeometry()
@@ -73,6 +205,7 @@ class GlGeometry {
           indexBuffer(0),
           vertexArrayObject(0),
           primitiveType(kPrimitiveTypeTriangles),
+          indexType(kIndexTypeUnsignedShort),
           vertexCount(0),
           indexCount(0),
           localBounds(OVR::Bounds3f::Init) {}
@@ -82,6 +215,7 @@ class GlGeometry {
           indexBuffer(0),
           vertexArrayObject(0),
           primitiveType(kPrimitiveTypeTriangles),
+          indexType(kIndexTypeUnsignedShort),
           vertexCount(0),
           indexCount(0),
           localBounds(OVR::Bounds3f::Init) {
@@ -89,8 +223,29 @@ class GlGeometry {
     }
 
     // Create the VAO and vertex and index buffers from arrays of data.
-    void Create(const VertexAttribs& attribs, const std::vector<TriangleIndex>& indices);
+    // The attributes are interleaved into one vertex buffer using the given layout.
+    void Create(
+        const VertexAttribs& attribs,
+        const std::vector<TriangleIndex>& indices,
+        const VertexLayout& layout = VertexLayout::Full());
+    // Same with 32-bit indices. They are stored as 16-bit indices when every index fits.
+    void Create(
+        const VertexAttribs& attribs,
+        const std::vector<TriangleIndex32>& indices,
+        const VertexLayout& layout = VertexLayout::Full());
+    // Repacks the vertex buffer with the layout it was created with.
     void Update(const VertexAttribs& attribs, const bool updateBounds = true);
+    // Overwrites size bytes of the vertex buffer at offset with vertices already packed in the
+    // layout it was created with, for vertices that change every frame such as morphed ones.
+    void UpdateVertexRange(const void* packed, const size_t offset, const size_t size);
+
+    // Points the VAO at vertices in another buffer, such as an allocation in a GlStreamBuffer,
+    // instead of this geometry's own vertex buffer. The index buffer is unchanged.
+    void BindVertexStream(
+        const uint32_t buffer,
+        const size_t offset,
+        const VertexStreamLayout& stream,
+        const VertexLayout& layout);
 
     // Free the buffers and VAO, assuming that they are strictly for this geometry.
     // We could save some overhead by packing an entire model into a single buffer, but
@@ -98,6 +253,13 @@ class GlGeometry {
     // This is not in the destructor to allow objects of this class to be passed by value.
     void Free();
 
+   private:
+    void CreateBuffers(
+        const VertexAttribs& attribs,
+        const void* indices,
+        const size_t indexBytes,
+        const VertexLayout& layout);
+
    public:
     static constexpr int32_t MAX_GEOMETRY_VERTICES = 1 << (sizeof(TriangleIndex) * 8);
     static constexpr int32_t MAX_GEOMETRY_INDICES = 1024 * 1024 * 3;
@@ -109,8 +271,6 @@ class GlGeometry {
         return MAX_GEOMETRY_INDICES;
     }
 
-    static unsigned IndexType; // GL_UNSIGNED_SHORT, GL_UNSIGNED_INT, etc.
-
     class TransformScope {
        public:
         explicit TransformScope(const OVR::Matrix4f m, bool enableTransfom = true) {
@@ -145,6 +305,11 @@ class GlGeometry {
         VertexAttribs attribs;
         std::vector<TriangleIndex> indices;
         OVR::Matrix4f transform;
+
+        // Runs OptimizeGeometry on the attributes and indices.
+        void Optimize(
+            const GeometryOptimizeParms& parms = GeometryOptimizeParms(),
+            GeometryOptimizeStats* stats = nullptr);
     };
 
    public:
@@ -152,13 +317,68 @@ class GlGeometry {
     uint32_t indexBuffer;
     uint32_t vertexArrayObject;
     uint32_t primitiveType; // GL_TRIANGLES / GL_LINES / GL_POINTS / etc
+    uint32_t indexType; // GL_UNSIGNED_SHORT or GL_UNSIGNED_INT, chosen by Create()
     int32_t vertexCount;
     int32_t indexCount;
     OVR::Bounds3f localBounds;
+    VertexLayout vertexLayout;
+};
+
+// Sub-mesh of a mesh that was split to fit 16-bit indices.
+struct GeometrySplit {
+    std::vector<TriangleIndex32> vertices; // source mesh vertex of each sub-mesh vertex
+    std::vector<TriangleIndex> indices;
 };
 
+// Cuts a triangle list into sub-meshes of at most maxVertices vertices, keeping the triangle
+// order. Every sub-mesh stores a vertex once however many of its triangles share it, so only
+// the vertices on the seams between sub-meshes are duplicated. Triangles that reference a
+// vertex past vertexCount are dropped.
+std::vector<GeometrySplit> SplitTriangles(
+    const std::vector<TriangleIndex32>& indices,
+    const int vertexCount,
+    const int maxVertices = GlGeometry::MAX_GEOMETRY_VERTICES);
+
+// Copies the attributes of the given source vertices, e.g. of a GeometrySplit.
+VertexAttribs GatherVertexAttribs(
+    const VertexAttribs& attribs,
+    const std::vector<TriangleIndex32>& vertices);
+
+// True if a mesh of vertexCount vertices is better drawn as the given 16-bit sub-meshes than
+// as one geometry with 32-bit indices on this device. Must be called with a current context.
+bool PreferSplitGeometry(const std::vector<GeometrySplit>& splits, const int vertexCount);
+
+static const int GEOMETRY_CACHE_SIZE = 16;
+
+// Average post-transform vertex cache misses per triangle when drawing a triangle list.
+float CalculateACMR(
+    const std::vector<TriangleIndex32>& indices,
+    const int vertexCount,
+    const int cacheSize = GEOMETRY_CACHE_SIZE);
+
+// Rewrites a triangle list so the GPU fetches and transforms fewer vertices: identical vertices
+// are merged, triangles are ordered for the post-transform vertex cache and then in patches
+// that reduce overdraw, and vertices are renumbered in the order they are first used, which
+// also drops unused vertices. Does not touch GL, so it can run on loader threads.
+// Returns the source vertex of every output vertex, so data stored alongside the attributes,
+// such as morph targets, can be remapped with GatherVertexAttribs. Without renumberVertices the
+// vertices keep their order and the result is the identity. Returns an empty vector if the mesh
+// was left unchanged because it has no triangles or an index is out of range.
+std::vector<TriangleIndex32> OptimizeGeometry(
+    VertexAttribs& attribs,
+    std::vector<TriangleIndex32>& indices,
+    const GeometryOptimizeParms& parms = GeometryOptimizeParms(),
+    GeometryOptimizeStats* stats = nullptr);
+
+// verts may be null to only allocate the vertex buffer
 GlGeometry FontGeometryCreate(fontVertex_t* verts, int numVerts, OVR::Bounds3f& localBounds);
 void FontGeometryUpdate(GlGeometry& geo, fontVertex_t* verts, int numVerts, int numIndices);
+// Draws geo from font vertices written to another buffer, such as a GlStreamBuffer allocation
+void FontGeometryBindStream(
+    GlGeometry& geo,
+    const uint32_t buffer,
+    const size_t offset,
+    int numIndices);
 
 // Build it in a -1 to 1 range, which will be scaled to the appropriate
 // aspect ratio for each usage.
@@ -0,0 +1,625 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * Licensed under the Oculus SDK License Agreement (the "License");
+ * you may not use the Oculus SDK except in compliance with the License,
+ * which is provided at the time of installation or download, or which
+ * otherwise accompanies this software in either electronic or hard copy form.
+ *
+ * You may obtain a copy of the License at
+ * https://developer.oculus.com/licenses/oculussdk/
+ *
+ * Unless required by applicable law or agreed to in writing, the Oculus SDK
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/************************************************************************************
+
+Filename    :   GlGeometryOptimize.cpp
+Content     :   Load time reordering of meshes for vertex cache, overdraw and fetch locality.
+Language    :   C++
+
+*************************************************************************************/
+
+#include "GlGeometry.h"
+#include "Misc/Log.h"
+#include "PackageFiles.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+namespace OVRFW {
+
+static const TriangleIndex32 INVALID_VERTEX = ~static_cast<TriangleIndex32>(0);
+
+// Cache the triangle order is scored against. Larger than the cache the ACMR is reported for,
+// which works well across GPUs with different cache sizes.
+static const int FORSYTH_CACHE_SIZE = 32;
+// Patches are split where their running ACMR comes within this factor of the patch's ACMR.
+static const float OVERDRAW_ACMR_THRESHOLD = 1.05f;
+// Smaller meshes are optimized faster than their cache file is read.
+static const size_t DISK_CACHE_MIN_TRIANGLES = 4096;
+static const uint32_t DISK_CACHE_MAGIC = 0x4f454f47;
+static const uint32_t DISK_CACHE_VERSION = 1;
+
+//==============================================================
+// Hashing
+
+static const uint64_t FNV_OFFSET_BASIS = 0xcbf29ce484222325ull;
+static const uint64_t FNV_PRIME = 0x100000001b3ull;
+
+static uint64_t HashBytes(const void* data, const size_t size, uint64_t hash = FNV_OFFSET_BASIS) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ bytes[i]) * FNV_PRIME;
+    }
+    return hash;
+}
+
+template <typename T>
+static uint64_t HashArray(const std::vector<T>& values, uint64_t hash) {
+    const uint64_t count = values.size();
+    hash = HashBytes(&count, sizeof(count), hash);
+    return values.empty() ? hash : HashBytes(values.data(), values.size() * sizeof(T), hash);
+}
+
+//==============================================================
+// Vertex deduplication
+
+// Appends the value of one vertex of an attribute, zero past the end of a shorter array like
+// PackVertexAttribs does. Attributes that are not stored add nothing.
+template <typename T>
+static size_t AppendVertexKey(const std::vector<T>& src, const size_t v, uint8_t* key) {
+    if (src.empty()) {
+        return 0;
+    }
+    const T value = (v < src.size()) ? src[v] : T();
+    memcpy(key, &value, sizeof(T));
+    return sizeof(T);
+}
+
+static const size_t MAX_VERTEX_KEY_SIZE = 4 * sizeof(OVR::Vector3f) + 2 * sizeof(OVR::Vector4f) +
+    2 * sizeof(OVR::Vector2f) + sizeof(OVR::Vector4i);
+
+static size_t GetVertexKey(const VertexAttribs& attribs, const size_t v, uint8_t* key) {
+    size_t size = 0;
+    size += AppendVertexKey(attribs.position, v, key + size);
+    size += AppendVertexKey(attribs.normal, v, key + size);
+    size += AppendVertexKey(attribs.tangent, v, key + size);
+    size += AppendVertexKey(attribs.binormal, v, key + size);
+    size += AppendVertexKey(attribs.color, v, key + size);
+    size += AppendVertexKey(attribs.uv0, v, key + size);
+    size += AppendVertexKey(attribs.uv1, v, key + size);
+    size += AppendVertexKey(attribs.jointIndices, v, key + size);
+    size += AppendVertexKey(attribs.jointWeights, v, key + size);
+    return size;
+}
+
+// Returns the first vertex with the same attributes as each vertex. Values are compared
+// bitwise, so e.g. 0 and -0 are different.
+static std::vector<TriangleIndex32> FindUniqueVertices(const VertexAttribs& attribs) {
+    const size_t vertexCount = attribs.position.size();
+    std::vector<TriangleIndex32> unique(vertexCount);
+
+    // open addressing, at most half full
+    size_t tableSize = 1;
+    while (tableSize < vertexCount * 2) {
+        tableSize *= 2;
+    }
+    const size_t mask = tableSize - 1;
+    std::vector<TriangleIndex32> table(tableSize, INVALID_VERTEX);
+
+    uint8_t key[MAX_VERTEX_KEY_SIZE];
+    uint8_t otherKey[MAX_VERTEX_KEY_SIZE];
+    for (size_t v = 0; v < vertexCount; v++) {
+        const size_t keySize = GetVertexKey(attribs, v, key);
+        size_t slot = static_cast<size_t>(HashBytes(key, keySize)) & mask;
+        unique[v] = static_cast<TriangleIndex32>(v);
+        while (table[slot] != INVALID_VERTEX) {
+            GetVertexKey(attribs, table[slot], otherKey);
+            if (memcmp(key, otherKey, keySize) == 0) {
+                unique[v] = table[slot];
+                break;
+            }
+            slot = (slot + 1) & mask;
+        }
+        if (unique[v] == v) {
+            table[slot] = static_cast<TriangleIndex32>(v);
+        }
+    }
+    return unique;
+}
+
+//==============================================================
+// Vertex cache
+
+// Simulates a FIFO cache with timestamps: a vertex is cached if it was added less than
+// cacheSize insertions ago. Returns the misses of one triangle.
+static int UpdateFifoCache(
+    const TriangleIndex32* tri,
+    std::vector<uint32_t>& timestamps,
+    uint32_t& timestamp,
+    const int cacheSize) {
+    int misses = 0;
+    for (int k = 0; k < 3; k++) {
+        if (timestamp - timestamps[tri[k]] > static_cast<uint32_t>(cacheSize)) {
+            timestamps[tri[k]] = timestamp++;
+            misses++;
+        }
+    }
+    return misses;
+}
+
+float CalculateACMR(
+    const std::vector<TriangleIndex32>& indices,
+    const int vertexCount,
+    const int cacheSize) {
+    const size_t triangleCount = indices.size() / 3;
+    if (triangleCount == 0 || vertexCount <= 0) {
+        return 0.0f;
+    }
+    std::vector<uint32_t> timestamps(vertexCount, 0);
+    uint32_t timestamp = cacheSize + 1;
+    size_t misses = 0;
+    for (size_t t = 0; t < triangleCount; t++) {
+        misses += UpdateFifoCache(&indices[t * 3], timestamps, timestamp, cacheSize);
+    }
+    return static_cast<float>(misses) / static_cast<float>(triangleCount);
+}
+
+// Tom Forsyth's "Linear-Speed Vertex Cache Optimisation": triangles are emitted greedily by
+// the score of their vertices, which favors vertices recently used and vertices with few
+// triangles left, so that each area of the mesh is finished before moving on.
+static void OptimizeVertexCache(std::vector<TriangleIndex32>& indices, const int vertexCount) {
+    const size_t triangleCount = indices.size() / 3;
+    const int MAX_VALENCE_SCORE = 32;
+
+    float cacheScore[FORSYTH_CACHE_SIZE];
+    for (int i = 0; i < FORSYTH_CACHE_SIZE; i++) {
+        // the last triangle's vertices get a fixed score so its order doesn't matter
+        cacheScore[i] = (i < 3)
+            ? 0.75f
+            : powf(1.0f - (i - 3) / static_cast<float>(FORSYTH_CACHE_SIZE - 3), 1.5f);
+    }
+    float valenceScore[MAX_VALENCE_SCORE + 1];
+    valenceScore[0] = 0.0f;
+    for (int i = 1; i <= MAX_VALENCE_SCORE; i++) {
+        valenceScore[i] = 2.0f / sqrtf(static_cast<float>(i));
+    }
+    auto vertexScore = [&](const int cachePosition, const uint32_t liveTriangles) {
+        if (liveTriangles == 0) {
+            return -1.0f;
+        }
+        const float score = (cachePosition >= 0) ? cacheScore[cachePosition] : 0.0f;
+        return score + valenceScore[std::min<uint32_t>(liveTriangles, MAX_VALENCE_SCORE)];
+    };
+
+    // triangles not yet emitted that use each vertex
+    std::vector<uint32_t> offsets(vertexCount + 1, 0);
+    for (const TriangleIndex32 v : indices) {
+        offsets[v + 1]++;
+    }
+    for (int v = 0; v < vertexCount; v++) {
+        offsets[v + 1] += offsets[v];
+    }
+    std::vector<uint32_t> liveTriangles(vertexCount, 0);
+    std::vector<uint32_t> adjacency(indices.size());
+    for (size_t t = 0; t < triangleCount; t++) {
+        for (int k = 0; k < 3; k++) {
+            const TriangleIndex32 v = indices[t * 3 + k];
+            adjacency[offsets[v] + liveTriangles[v]++] = static_cast<uint32_t>(t);
+        }
+    }
+
+    std::vector<int> cachePosition(vertexCount, -1);
+    std::vector<float> score(vertexCount);
+    for (int v = 0; v < vertexCount; v++) {
+        score[v] = vertexScore(-1, liveTriangles[v]);
+    }
+    std::vector<float> triangleScore(triangleCount);
+    std::vector<uint8_t> emitted(triangleCount, 0);
+    int64_t best = -1;
+    float bestScore = -1.0f;
+    for (size_t t = 0; t < triangleCount; t++) {
+        const TriangleIndex32* tri = &indices[t * 3];
+        triangleScore[t] = score[tri[0]] + score[tri[1]] + score[tri[2]];
+        if (triangleScore[t] > bestScore) {
+            bestScore = triangleScore[t];
+            best = static_cast<int64_t>(t);
+        }
+    }
+
+    std::vector<TriangleIndex32> out;
+    out.reserve(indices.size());
+    TriangleIndex32 cache[FORSYTH_CACHE_SIZE + 3];
+    int cacheCount = 0;
+    size_t nextTriangle = 0;
+    for (size_t n = 0; n < triangleCount; n++) {
+        if (best < 0) {
+            // nothing in the cache is left to draw, continue with the next unused triangle
+            while (emitted[nextTriangle]) {
+                nextTriangle++;
+            }
+            best = static_cast<int64_t>(nextTriangle);
+        }
+        const TriangleIndex32* tri = &indices[best * 3];
+        out.insert(out.end(), tri, tri + 3);
+        emitted[best] = 1;
+
+        for (int k = 0; k < 3; k++) {
+            const TriangleIndex32 v = tri[k];
+            uint32_t* list = &adjacency[offsets[v]];
+            const uint32_t count = liveTriangles[v];
+            for (uint32_t i = 0; i < count; i++) {
+                if (list[i] == static_cast<uint32_t>(best)) {
+                    list[i] = list[count - 1];
+                    liveTriangles[v]--;
+                    break;
+                }
+            }
+        }
+
+        // the triangle's vertices move to the front, the others are pushed back
+        TriangleIndex32 newCache[FORSYTH_CACHE_SIZE + 3];
+        int newCount = 0;
+        for (int k = 0; k < 3; k++) {
+            if (std::find(newCache, newCache + newCount, tri[k]) == newCache + newCount) {
+                newCache[newCount++] = tri[k];
+            }
+        }
+        for (int i = 0; i < cacheCount; i++) {
+            if (cache[i] != tri[0] && cache[i] != tri[1] && cache[i] != tri[2]) {
+                newCache[newCount++] = cache[i];
+            }
+        }
+
+        // rescore the vertices that moved, including the ones that fell out of the cache, and
+        // pick the best triangle among the ones that use them
+        for (int i = 0; i < newCount; i++) {
+            const TriangleIndex32 v = newCache[i];
+            cachePosition[v] = (i < FORSYTH_CACHE_SIZE) ? i : -1;
+            score[v] = vertexScore(cachePosition[v], liveTriangles[v]);
+        }
+        best = -1;
+        bestScore = -1.0f;
+        for (int i = 0; i < newCount; i++) {
+            const TriangleIndex32 v = newCache[i];
+            const uint32_t* list = &adjacency[offsets[v]];
+            for (uint32_t j = 0; j < liveTriangles[v]; j++) {
+                const uint32_t t = list[j];
+                const TriangleIndex32* other = &indices[t * 3];
+                triangleScore[t] = score[other[0]] + score[other[1]] + score[other[2]];
+                if (triangleScore[t] > bestScore) {
+                    bestScore = triangleScore[t];
+                    best = t;
+                }
+            }
+        }
+
+        cacheCount = std::min(newCount, FORSYTH_CACHE_SIZE);
+        std::copy(newCache, newCache + cacheCount, cache);
+    }
+    indices.swap(out);
+}
+
+//==============================================================
+// Overdraw
+
+// Pedro Sander et al., "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw":
+// the cache ordered triangles are cut into patches at points that barely change the ACMR, and
+// the patches are sorted so the ones facing away from the center of the mesh are drawn first,
+// as they are the most likely to occlude the others.
+static void OptimizeOverdraw(
+    std::vector<TriangleIndex32>& indices,
+    const std::vector<OVR::Vector3f>& positions) {
+    const size_t triangleCount = indices.size() / 3;
+    if (triangleCount < 2) {
+        return;
+    }
+    std::vector<uint32_t> timestamps(positions.size(), 0);
+    uint32_t timestamp = GEOMETRY_CACHE_SIZE + 1;
+
+    // A triangle with three misses usually starts a disjoint area of the mesh.
+    std::vector<size_t> hardStarts;
+    for (size_t t = 0; t < triangleCount; t++) {
+        const int misses =
+            UpdateFifoCache(&indices[t * 3], timestamps, timestamp, GEOMETRY_CACHE_SIZE);
+        if (t == 0 || misses == 3) {
+            hardStarts.push_back(t);
+        }
+    }
+    hardStarts.push_back(triangleCount);
+
+    std::vector<size_t> starts;
+    for (size_t h = 0; h + 1 < hardStarts.size(); h++) {
+        const size_t start = hardStarts[h];
+        const size_t end = hardStarts[h + 1];
+
+        timestamp += GEOMETRY_CACHE_SIZE + 1;
+        size_t misses = 0;
+        for (size_t t = start; t < end; t++) {
+            misses +=
+                UpdateFifoCache(&indices[t * 3], timestamps, timestamp, GEOMETRY_CACHE_SIZE);
+        }
+        const float threshold = OVERDRAW_ACMR_THRESHOLD * static_cast<float>(misses) /
+            static_cast<float>(end - start);
+
+        // cut the area where a patch reaches about the area's ACMR on its own
+        timestamp += GEOMETRY_CACHE_SIZE + 1;
+        starts.push_back(start);
+        size_t runningMisses = 0;
+        size_t runningTriangles = 0;
+        for (size_t t = start; t + 1 < end; t++) {
+            runningMisses +=
+                UpdateFifoCache(&indices[t * 3], timestamps, timestamp, GEOMETRY_CACHE_SIZE);
+            runningTriangles++;
+            if (runningMisses <= threshold * runningTriangles) {
+                starts.push_back(t + 1);
+                timestamp += GEOMETRY_CACHE_SIZE + 1;
+                runningMisses = 0;
+                runningTriangles = 0;
+            }
+        }
+    }
+    starts.push_back(triangleCount);
+
+    // area weighted centroid and normal of each patch
+    const size_t patchCount = starts.size() - 1;
+    std::vector<OVR::Vector3f> centroids(patchCount, OVR::Vector3f(0.0f));
+    std::vector<OVR::Vector3f> normals(patchCount, OVR::Vector3f(0.0f));
+    OVR::Vector3f meshCentroid(0.0f);
+    float meshArea = 0.0f;
+    for (size_t p = 0; p < patchCount; p++) {
+        float patchArea = 0.0f;
+        for (size_t t = starts[p]; t < starts[p + 1]; t++) {
+            const OVR::Vector3f& p0 = positions[indices[t * 3 + 0]];
+            const OVR::Vector3f& p1 = positions[indices[t * 3 + 1]];
+            const OVR::Vector3f& p2 = positions[indices[t * 3 + 2]];
+            const OVR::Vector3f normal = (p1 - p0).Cross(p2 - p0);
+            const float area = normal.Length();
+            centroids[p] += (p0 + p1 + p2) * (area / 3.0f);
+            normals[p] += normal;
+            patchArea += area;
+        }
+        meshCentroid += centroids[p];
+        meshArea += patchArea;
+        centroids[p] = (patchArea > 0.0f) ? centroids[p] / patchArea
+                                          : positions[indices[starts[p] * 3]];
+    }
+    if (meshArea > 0.0f) {
+        meshCentroid /= meshArea;
+    }
+
+    std::vector<float> sortKeys(patchCount);
+    std::vector<size_t> order(patchCount);
+    for (size_t p = 0; p < patchCount; p++) {
+        const float length = normals[p].Length();
+        sortKeys[p] =
+            (length > 0.0f) ? (centroids[p] - meshCentroid).Dot(normals[p]) / length : 0.0f;
+        order[p] = p;
+    }
+    std::stable_sort(order.begin(), order.end(), [&](const size_t a, const size_t b) {
+        return sortKeys[a] > sortKeys[b];
+    });
+
+    std::vector<TriangleIndex32> out;
+    out.reserve(indices.size());
+    for (const size_t p : order) {
+        out.insert(
+            out.end(), indices.begin() + starts[p] * 3, indices.begin() + starts[p + 1] * 3);
+    }
+    indices.swap(out);
+}
+
+//==============================================================
+// Disk cache
+
+// The result is cached as the vertex remap and the new indices, under a key made from the
+// source mesh and the parms, next to the package files extracted to the cache path. The files
+// are added to the package cache, which counts them against its budget and evicts them.
+struct ovrOptimizeCacheHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t key;
+    uint32_t vertexCount; // of the optimized mesh
+    uint32_t indexCount;
+};
+
+static uint64_t GetOptimizeCacheKey(
+    const VertexAttribs& attribs,
+    const std::vector<TriangleIndex32>& indices,
+    const GeometryOptimizeParms& parms) {
+    const uint8_t flags[4] = {
+        parms.deduplicate, parms.reorderTriangles, parms.reduceOverdraw, parms.renumberVertices};
+    uint64_t hash = HashBytes(&DISK_CACHE_VERSION, sizeof(DISK_CACHE_VERSION));
+    hash = HashBytes(flags, sizeof(flags), hash);
+    hash = HashArray(attribs.position, hash);
+    hash = HashArray(attribs.normal, hash);
+    hash = HashArray(attribs.tangent, hash);
+    hash = HashArray(attribs.binormal, hash);
+    hash = HashArray(attribs.color, hash);
+    hash = HashArray(attribs.uv0, hash);
+    hash = HashArray(attribs.uv1, hash);
+    hash = HashArray(attribs.jointIndices, hash);
+    hash = HashArray(attribs.jointWeights, hash);
+    return HashArray(indices, hash);
+}
+
+static std::string GetOptimizeCacheName(const uint64_t key) {
+    char name[64];
+    snprintf(name, sizeof(name), "geo-%016llx", (unsigned long long)key);
+    return name;
+}
+
+static bool ReadOptimizeCache(
+    const uint64_t key,
+    const size_t sourceVertexCount,
+    std::vector<TriangleIndex32>& remap,
+    std::vector<TriangleIndex32>& indices) {
+    const std::string name = GetOptimizeCacheName(key);
+    if (!ovr_UseApplicationCacheFile(name.c_str())) {
+        return false;
+    }
+    const std::string fileName = ovr_GetApplicationCacheFileName(name.c_str());
+    FILE* f = fopen(fileName.c_str(), "rb");
+    if (f == nullptr) {
+        return false;
+    }
+    ovrOptimizeCacheHeader header = {};
+    bool valid = fread(&header, sizeof(header), 1, f) == 1 && header.magic == DISK_CACHE_MAGIC &&
+        header.version == DISK_CACHE_VERSION && header.key == key &&
+        header.vertexCount <= sourceVertexCount && header.indexCount == indices.size();
+    if (valid) {
+        remap.resize(header.vertexCount);
+        std::vector<TriangleIndex32> cachedIndices(header.indexCount);
+        valid = fread(remap.data(), sizeof(TriangleIndex32), remap.size(), f) == remap.size() &&
+            fread(cachedIndices.data(), sizeof(TriangleIndex32), cachedIndices.size(), f) ==
+                cachedIndices.size();
+        for (size_t i = 0; valid && i < remap.size(); i++) {
+            valid = remap[i] < sourceVertexCount;
+        }
+        for (size_t i = 0; valid && i < cachedIndices.size(); i++) {
+            valid = cachedIndices[i] < header.vertexCount;
+        }
+        if (valid) {
+            indices.swap(cachedIndices);
+        }
+    }
+    fclose(f);
+    if (!valid) {
+        ALOG("Removing invalid geometry cache file %016llx", (unsigned long long)key);
+        remove(fileName.c_str());
+        remap.clear();
+    }
+    return valid;
+}
+
+static void WriteOptimizeCache(
+    const uint64_t key,
+    const std::vector<TriangleIndex32>& remap,
+    const std::vector<TriangleIndex32>& indices) {
+    // Concurrent loads of the same mesh each write their own temporary file.
+    static std::atomic<int> tempCounter(0);
+    const std::string name = GetOptimizeCacheName(key);
+    const std::string cacheName = ovr_GetApplicationCacheFileName(name.c_str());
+    const std::string tempName = cacheName + "." + std::to_string(tempCounter++) + ".tmp";
+
+    FILE* f = fopen(tempName.c_str(), "wb");
+    if (f == nullptr) {
+        ALOG("Failed to open new geometry cache file %s", tempName.c_str());
+        return;
+    }
+    ovrOptimizeCacheHeader header = {};
+    header.magic = DISK_CACHE_MAGIC;
+    header.version = DISK_CACHE_VERSION;
+    header.key = key;
+    header.vertexCount = static_cast<uint32_t>(remap.size());
+    header.indexCount = static_cast<uint32_t>(indices.size());
+    const bool written = fwrite(&header, sizeof(header), 1, f) == 1 &&
+        fwrite(remap.data(), sizeof(TriangleIndex32), remap.size(), f) == remap.size() &&
+        fwrite(indices.data(), sizeof(TriangleIndex32), indices.size(), f) == indices.size();
+    const bool closed = fclose(f) == 0;
+    if (!written || !closed || rename(tempName.c_str(), cacheName.c_str()) != 0) {
+        ALOG("Failed to write geometry cache file %s", cacheName.c_str());
+        remove(tempName.c_str());
+        return;
+    }
+    ovr_AddApplicationCacheFile(name.c_str());
+}
+
+//==============================================================
+// OptimizeGeometry
+
+std::vector<TriangleIndex32> OptimizeGeometry(
+    VertexAttribs& attribs,
+    std::vector<TriangleIndex32>& indices,
+    const GeometryOptimizeParms& parms,
+    GeometryOptimizeStats* stats) {
+    std::vector<TriangleIndex32> remap;
+    const size_t vertexCount = attribs.position.size();
+    if (indices.empty() || indices.size() % 3 != 0 || vertexCount >= INVALID_VERTEX) {
+        return remap;
+    }
+    for (const TriangleIndex32 index : indices) {
+        if (index >= vertexCount) {
+            return remap;
+        }
+    }
+
+    GeometryOptimizeStats result;
+    result.triangleCount = static_cast<int>(indices.size() / 3);
+    result.verticesBefore = static_cast<int>(vertexCount);
+    result.acmrBefore = CalculateACMR(indices, static_cast<int>(vertexCount));
+
+    const bool useDiskCache = parms.useDiskCache &&
+        ovr_GetApplicationPackageCachePath()[0] != '\0' &&
+        indices.size() / 3 >= DISK_CACHE_MIN_TRIANGLES;
+    const uint64_t key = useDiskCache ? GetOptimizeCacheKey(attribs, indices, parms) : 0;
+    result.fromDiskCache = useDiskCache && ReadOptimizeCache(key, vertexCount, remap, indices);
+
+    if (!result.fromDiskCache) {
+        if (parms.deduplicate) {
+            const std::vector<TriangleIndex32> unique = FindUniqueVertices(attribs);
+            for (TriangleIndex32& index : indices) {
+                index = unique[index];
+            }
+        }
+        if (parms.reorderTriangles) {
+            OptimizeVertexCache(indices, static_cast<int>(vertexCount));
+            if (parms.reduceOverdraw) {
+                OptimizeOverdraw(indices, attribs.position);
+            }
+        }
+
+        if (parms.renumberVertices) {
+            // number the vertices in the order they are first used
+            std::vector<TriangleIndex32> newIndex(vertexCount, INVALID_VERTEX);
+            for (TriangleIndex32& index : indices) {
+                if (newIndex[index] == INVALID_VERTEX) {
+                    newIndex[index] = static_cast<TriangleIndex32>(remap.size());
+                    remap.push_back(index);
+                }
+                index = newIndex[index];
+            }
+        } else {
+            remap.resize(vertexCount);
+            for (size_t i = 0; i < vertexCount; i++) {
+                remap[i] = static_cast<TriangleIndex32>(i);
+            }
+        }
+
+        if (useDiskCache) {
+            WriteOptimizeCache(key, remap, indices);
+        }
+    }
+
+    if (parms.renumberVertices) {
+        attribs = GatherVertexAttribs(attribs, remap);
+    }
+
+    result.verticesAfter = static_cast<int>(remap.size());
+    result.acmrAfter = CalculateACMR(indices, result.verticesAfter);
+    if (stats != nullptr) {
+        *stats = result;
+    }
+    return remap;
+}
+
+void GlGeometry::Descriptor::Optimize(
+    const GeometryOptimizeParms& parms,
+    GeometryOptimizeStats* stats) {
+    // the vertex count never grows, so the 16-bit indices still fit afterwards
+    std::vector<TriangleIndex32> indices32(indices.begin(), indices.end());
+    if (!OptimizeGeometry(attribs, indices32, parms, stats).empty()) {
+        indices.assign(indices32.begin(), indices32.end());
+    }
+}
+
+} // namespace OVRFW
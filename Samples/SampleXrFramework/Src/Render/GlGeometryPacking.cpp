@@ -0,0 +1,335 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * Licensed under the Oculus SDK License Agreement (the "License");
+ * you may not use the Oculus SDK except in compliance with the License,
+ * which is provided at the time of installation or download, or which
+ * otherwise accompanies this software in either electronic or hard copy form.
+ *
+ * You may obtain a copy of the License at
+ * https://developer.oculus.com/licenses/oculussdk/
+ *
+ * Unless required by applicable law or agreed to in writing, the Oculus SDK
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/************************************************************************************
+
+Filename    :   GlGeometryPacking.cpp
+Content     :   Interleaving and quantization of vertex attributes.
+Language    :   C++
+
+*************************************************************************************/
+
+#include "GlGeometry.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+using OVR::Vector2f;
+using OVR::Vector3f;
+using OVR::Vector4f;
+using OVR::Vector4i;
+
+namespace OVRFW {
+
+uint16_t EncodeFloat16(const float f) {
+    uint32_t x;
+    memcpy(&x, &f, sizeof(x));
+    const uint16_t sign = static_cast<uint16_t>((x >> 16) & 0x8000);
+    const uint32_t absx = x & 0x7FFFFFFF;
+
+    if (absx >= 0x7F800000) {
+        // infinity stays infinity, NaN stays a quiet NaN
+        return sign | 0x7C00 | (absx > 0x7F800000 ? 0x0200 : 0);
+    }
+    if (absx >= 0x477FF000) {
+        // rounds past the largest half (65504)
+        return sign | 0x7C00;
+    }
+    if (absx < 0x38800000) {
+        // below the smallest normal half (2^-14), becomes a subnormal or zero
+        if (absx <= 0x33000000) {
+            return sign;
+        }
+        const uint32_t exponent = absx >> 23;
+        const uint32_t mantissa = (absx & 0x007FFFFF) | 0x00800000;
+        const uint32_t shift = 126 - exponent;
+        uint32_t h = mantissa >> shift;
+        const uint32_t remainder = mantissa & ((1u << shift) - 1);
+        const uint32_t halfway = 1u << (shift - 1);
+        if (remainder > halfway || (remainder == halfway && (h & 1))) {
+            h++;
+        }
+        return sign | static_cast<uint16_t>(h);
+    }
+
+    // rebias the exponent from 127 to 15 and round the mantissa to nearest even;
+    // a carry out of the mantissa correctly bumps the exponent
+    uint32_t h = (absx - 0x38000000) >> 13;
+    const uint32_t remainder = absx & 0x1FFF;
+    if (remainder > 0x1000 || (remainder == 0x1000 && (h & 1))) {
+        h++;
+    }
+    return sign | static_cast<uint16_t>(h);
+}
+
+float DecodeFloat16(const uint16_t h) {
+    const uint32_t sign = static_cast<uint32_t>(h & 0x8000) << 16;
+    const uint32_t exponent = (h >> 10) & 0x1F;
+    const uint32_t mantissa = h & 0x03FF;
+
+    if (exponent == 0) {
+        const float f = static_cast<float>(mantissa) * (1.0f / 16777216.0f);
+        return sign ? -f : f;
+    }
+    const uint32_t x = (exponent == 31) ? (sign | 0x7F800000 | (mantissa << 13))
+                                        : (sign | ((exponent + 112) << 23) | (mantissa << 13));
+    float f;
+    memcpy(&f, &x, sizeof(f));
+    return f;
+}
+
+uint32_t EncodeSnorm10(const Vector3f& v) {
+    auto quantize = [](const float f) {
+        const int q = static_cast<int>(std::round(std::max(-1.0f, std::min(1.0f, f)) * 511.0f));
+        return static_cast<uint32_t>(q) & 0x3FF;
+    };
+    return quantize(v.x) | (quantize(v.y) << 10) | (quantize(v.z) << 20);
+}
+
+Vector3f DecodeSnorm10(const uint32_t packed) {
+    // same conversion the vertex fetch applies to GL_INT_2_10_10_10_REV
+    auto dequantize = [](const uint32_t bits) {
+        const int q = (bits & 0x200) ? static_cast<int>(bits) - 1024 : static_cast<int>(bits);
+        return std::max(-1.0f, static_cast<float>(q) / 511.0f);
+    };
+    return Vector3f(
+        dequantize(packed & 0x3FF), dequantize((packed >> 10) & 0x3FF), dequantize(packed >> 20));
+}
+
+static int GetAttributeSize(const VertexFormat format, const int components) {
+    int size = 0;
+    switch (format) {
+        case VertexFormat::Float32:
+        case VertexFormat::Int32:
+            size = 4 * components;
+            break;
+        case VertexFormat::Float16:
+        case VertexFormat::Unorm16:
+            size = 2 * components;
+            break;
+        case VertexFormat::Unorm8:
+        case VertexFormat::Uint8:
+            size = components;
+            break;
+        case VertexFormat::Snorm10:
+            size = 4;
+            break;
+    }
+    // keep every attribute 4 byte aligned for the vertex fetch
+    return (size + 3) & ~3;
+}
+
+static void WriteComponents(
+    uint8_t* dst,
+    const float* src,
+    const int components,
+    const VertexFormat format) {
+    switch (format) {
+        case VertexFormat::Float32:
+            memcpy(dst, src, components * sizeof(float));
+            break;
+        case VertexFormat::Float16:
+            for (int i = 0; i < components; i++) {
+                const uint16_t h = EncodeFloat16(src[i]);
+                memcpy(dst + i * sizeof(h), &h, sizeof(h));
+            }
+            break;
+        case VertexFormat::Unorm16:
+            for (int i = 0; i < components; i++) {
+                const float f = std::max(0.0f, std::min(1.0f, src[i]));
+                const uint16_t q = static_cast<uint16_t>(std::round(f * 65535.0f));
+                memcpy(dst + i * sizeof(q), &q, sizeof(q));
+            }
+            break;
+        case VertexFormat::Unorm8:
+            for (int i = 0; i < components; i++) {
+                const float f = std::max(0.0f, std::min(1.0f, src[i]));
+                dst[i] = static_cast<uint8_t>(std::round(f * 255.0f));
+            }
+            break;
+        case VertexFormat::Snorm10: {
+            const uint32_t p = EncodeSnorm10(Vector3f(src[0], src[1], src[2]));
+            memcpy(dst, &p, sizeof(p));
+            break;
+        }
+        case VertexFormat::Int32:
+            for (int i = 0; i < components; i++) {
+                const int32_t v = static_cast<int32_t>(src[i]);
+                memcpy(dst + i * sizeof(v), &v, sizeof(v));
+            }
+            break;
+        case VertexFormat::Uint8:
+            for (int i = 0; i < components; i++) {
+                dst[i] = static_cast<uint8_t>(std::max(0.0f, std::min(255.0f, src[i])));
+            }
+            break;
+    }
+}
+
+static void WriteComponents(
+    uint8_t* dst,
+    const int* src,
+    const int components,
+    const VertexFormat format) {
+    if (format == VertexFormat::Int32) {
+        memcpy(dst, src, components * sizeof(int));
+    } else if (format == VertexFormat::Uint8) {
+        for (int i = 0; i < components; i++) {
+            dst[i] = static_cast<uint8_t>(std::max(0, std::min(255, src[i])));
+        }
+    } else {
+        float f[4];
+        for (int i = 0; i < components; i++) {
+            f[i] = static_cast<float>(src[i]);
+        }
+        WriteComponents(dst, f, components, format);
+    }
+}
+
+template <typename _attrib_type_>
+static void PackAttribute(
+    std::vector<uint8_t>& packed,
+    const std::vector<_attrib_type_>& attrib,
+    const int vertexCount,
+    const int offset,
+    const int stride,
+    const int components,
+    const VertexFormat format) {
+    if (offset < 0) {
+        return;
+    }
+    const int count = std::min(static_cast<int>(attrib.size()), vertexCount);
+    for (int i = 0; i < count; i++) {
+        WriteComponents(&packed[i * stride + offset], &attrib[i].x, components, format);
+    }
+}
+
+static VertexStreamLayout GetStreamLayout(
+    const VertexAttribs& attribs,
+    const VertexLayout& layout) {
+    VertexStreamLayout stream;
+    auto add = [&stream](const bool present, const VertexFormat format, const int components) {
+        if (!present) {
+            return -1;
+        }
+        const int offset = stream.stride;
+        stream.stride += GetAttributeSize(format, components);
+        return offset;
+    };
+    stream.position = add(!attribs.position.empty(), VertexFormat::Float32, 3);
+    stream.normal = add(!attribs.normal.empty(), layout.normal, 3);
+    stream.tangent = add(!attribs.tangent.empty(), layout.tangent, 3);
+    stream.binormal = add(!attribs.binormal.empty(), layout.binormal, 3);
+    stream.color = add(!attribs.color.empty(), layout.color, 4);
+    stream.uv0 = add(!attribs.uv0.empty(), layout.uv0, 2);
+    stream.uv1 = add(!attribs.uv1.empty(), layout.uv1, 2);
+    stream.jointIndices = add(!attribs.jointIndices.empty(), layout.jointIndices, 4);
+    stream.jointWeights = add(!attribs.jointWeights.empty(), layout.jointWeights, 4);
+    return stream;
+}
+
+int GetPackedVertexSize(const VertexAttribs& attribs, const VertexLayout& layout) {
+    return GetStreamLayout(attribs, layout).stride;
+}
+
+void PackVertexComponents(
+    uint8_t* dst,
+    const float* src,
+    const int components,
+    const VertexFormat format) {
+    WriteComponents(dst, src, components, format);
+}
+
+VertexStreamLayout PackVertexAttribs(
+    const VertexAttribs& attribs,
+    const VertexLayout& layout,
+    std::vector<uint8_t>& packed) {
+    const VertexStreamLayout s = GetStreamLayout(attribs, layout);
+    const int n = static_cast<int>(attribs.position.size());
+
+    packed.assign(static_cast<size_t>(n) * s.stride, 0);
+    PackAttribute(packed, attribs.position, n, s.position, s.stride, 3, VertexFormat::Float32);
+    PackAttribute(packed, attribs.normal, n, s.normal, s.stride, 3, layout.normal);
+    PackAttribute(packed, attribs.tangent, n, s.tangent, s.stride, 3, layout.tangent);
+    PackAttribute(packed, attribs.binormal, n, s.binormal, s.stride, 3, layout.binormal);
+    PackAttribute(packed, attribs.color, n, s.color, s.stride, 4, layout.color);
+    PackAttribute(packed, attribs.uv0, n, s.uv0, s.stride, 2, layout.uv0);
+    PackAttribute(packed, attribs.uv1, n, s.uv1, s.stride, 2, layout.uv1);
+    PackAttribute(
+        packed, attribs.jointIndices, n, s.jointIndices, s.stride, 4, layout.jointIndices);
+    PackAttribute(
+        packed, attribs.jointWeights, n, s.jointWeights, s.stride, 4, layout.jointWeights);
+    return s;
+}
+
+template <typename _attrib_type_, typename _component_type_>
+static bool ComponentsInRange(
+    const std::vector<_attrib_type_>& attrib,
+    const int components,
+    const _component_type_ minValue,
+    const _component_type_ maxValue) {
+    for (const _attrib_type_& a : attrib) {
+        for (int i = 0; i < components; i++) {
+            // written so that NaN is out of range
+            if (!(a[i] >= minValue && a[i] <= maxValue)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+VertexLayout VertexLayout::Compact(const VertexAttribs& attribs) {
+    // a little slack for unit vectors that were normalized with float error
+    const float unitLimit = 1.0f + 1e-4f;
+    // half floats below 2.0 are accurate to 2^-11, about half a texel at 1024
+    const float halfUvLimit = 2.0f;
+
+    auto unitVectorFormat = [unitLimit](const std::vector<Vector3f>& v) {
+        return ComponentsInRange(v, 3, -unitLimit, unitLimit) ? VertexFormat::Snorm10
+                                                              : VertexFormat::Float32;
+    };
+    auto uvFormat = [halfUvLimit](const std::vector<Vector2f>& uv) {
+        if (ComponentsInRange(uv, 2, 0.0f, 1.0f)) {
+            return VertexFormat::Unorm16;
+        }
+        if (ComponentsInRange(uv, 2, -halfUvLimit, halfUvLimit)) {
+            return VertexFormat::Float16;
+        }
+        return VertexFormat::Float32;
+    };
+
+    VertexLayout layout;
+    layout.normal = unitVectorFormat(attribs.normal);
+    layout.tangent = unitVectorFormat(attribs.tangent);
+    layout.binormal = unitVectorFormat(attribs.binormal);
+    layout.color = ComponentsInRange(attribs.color, 4, 0.0f, 1.0f) ? VertexFormat::Unorm8
+                                                                    : VertexFormat::Float32;
+    layout.uv0 = uvFormat(attribs.uv0);
+    layout.uv1 = uvFormat(attribs.uv1);
+    layout.jointIndices = ComponentsInRange(attribs.jointIndices, 4, 0, 255)
+        ? VertexFormat::Uint8
+        : VertexFormat::Int32;
+    layout.jointWeights = ComponentsInRange(attribs.jointWeights, 4, 0.0f, 1.0f)
+        ? VertexFormat::Unorm16
+        : VertexFormat::Float32;
+    return layout;
+}
+
+} // namespace OVRFW
@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * Licensed under the Oculus SDK License Agreement (the "License");
+ * you may not use the Oculus SDK except in compliance with the License,
+ * which is provided at the time of installation or download, or which
+ * otherwise accompanies this software in either electronic or hard copy form.
+ *
+ * You may obtain a copy of the License at
+ * https://developer.oculus.com/licenses/oculussdk/
+ *
+ * Unless required by applicable law or agreed to in writing, the Oculus SDK
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/************************************************************************************
+
+Filename    :   GlGeometrySplit.cpp
+Content     :   Splitting of meshes that don't fit 16-bit indices.
+Language    :   C++
+
+*************************************************************************************/
+
+#include "GlGeometry.h"
+
+namespace OVRFW {
+
+std::vector<GeometrySplit> SplitTriangles(
+    const std::vector<TriangleIndex32>& indices,
+    const int vertexCount,
+    const int maxVertices) {
+    std::vector<GeometrySplit> splits;
+    if (vertexCount <= 0 || maxVertices < 3) {
+        return splits;
+    }
+
+    // Sub-mesh vertex of each source vertex, valid while owner matches the current sub-mesh.
+    std::vector<TriangleIndex> remap(vertexCount);
+    std::vector<int> owner(vertexCount, -1);
+
+    const size_t triangleCount = indices.size() / 3;
+    for (size_t t = 0; t < triangleCount; t++) {
+        const TriangleIndex32* tri = &indices[t * 3];
+        if (tri[0] >= static_cast<TriangleIndex32>(vertexCount) ||
+            tri[1] >= static_cast<TriangleIndex32>(vertexCount) ||
+            tri[2] >= static_cast<TriangleIndex32>(vertexCount)) {
+            continue;
+        }
+
+        // start a new sub-mesh if the vertices this triangle adds wouldn't fit
+        const int current = static_cast<int>(splits.size()) - 1;
+        int added = 0;
+        for (int k = 0; k < 3; k++) {
+            added += (owner[tri[k]] != current) ? 1 : 0;
+        }
+        if (current < 0 ||
+            static_cast<int>(splits[current].vertices.size()) + added > maxVertices) {
+            splits.emplace_back();
+        }
+
+        const int split = static_cast<int>(splits.size()) - 1;
+        GeometrySplit& s = splits.back();
+        for (int k = 0; k < 3; k++) {
+            const TriangleIndex32 v = tri[k];
+            if (owner[v] != split) {
+                owner[v] = split;
+                remap[v] = static_cast<TriangleIndex>(s.vertices.size());
+                s.vertices.push_back(v);
+            }
+            s.indices.push_back(remap[v]);
+        }
+    }
+    return splits;
+}
+
+template <typename T>
+static void GatherAttrib(
+    const std::vector<T>& src,
+    const std::vector<TriangleIndex32>& vertices,
+    std::vector<T>& dst) {
+    if (src.empty()) {
+        return;
+    }
+    dst.resize(vertices.size());
+    for (size_t i = 0; i < vertices.size(); i++) {
+        dst[i] = (vertices[i] < src.size()) ? src[vertices[i]] : T();
+    }
+}
+
+VertexAttribs GatherVertexAttribs(
+    const VertexAttribs& attribs,
+    const std::vector<TriangleIndex32>& vertices) {
+    VertexAttribs out;
+    GatherAttrib(attribs.position, vertices, out.position);
+    GatherAttrib(attribs.normal, vertices, out.normal);
+    GatherAttrib(attribs.tangent, vertices, out.tangent);
+    GatherAttrib(attribs.binormal, vertices, out.binormal);
+    GatherAttrib(attribs.color, vertices, out.color);
+    GatherAttrib(attribs.uv0, vertices, out.uv0);
+    GatherAttrib(attribs.uv1, vertices, out.uv1);
+    GatherAttrib(attribs.jointIndices, vertices, out.jointIndices);
+    GatherAttrib(attribs.jointWeights, vertices, out.jointWeights);
+    return out;
+}
+
+} // namespace OVRFW
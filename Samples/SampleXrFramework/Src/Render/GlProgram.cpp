@@ -67,6 +67,17 @@ static const char* VertexHeader =
 
 uniform highp mat4 ModelMatrix;
 
+// Consecutive draws of the same surface are merged into one instanced draw by
+// ovrSurfaceRender. While InstanceBatch is set, the model matrix of each instance
+// comes from this ubo instead of the ModelMatrix uniform. Redefining ModelMatrix
+// covers shaders that use it directly as well as TransformVertex.
+uniform lowp int InstanceBatch;
+layout(std140) uniform InstanceMatrices
+{
+	highp mat4 Models[MAX_BATCH_INSTANCES];
+} im;
+#define ModelMatrix ( InstanceBatch != 0 ? im.Models[gl_InstanceID] : ModelMatrix )
+
 // Use a ubo in v300 path to workaround corruption issue on Adreno 420+v300
 // when uniform array of matrices used.
 uniform SceneMatrices
@@ -131,6 +142,8 @@ CompileShader(GLenum shaderType, const char* directives, const char* src, GLint
         std::string("\n");
 
     if (shaderType == GL_VERTEX_SHADER) {
+        srcString += std::string("#define MAX_BATCH_INSTANCES ") +
+            std::to_string(GlProgram::MAX_BATCH_INSTANCES) + std::string("\n");
         srcString.append(VertexHeader);
     } else if (shaderType == GL_FRAGMENT_SHADER) {
         srcString.append(FragmentHeader);
@@ -271,6 +284,11 @@ GlProgram GlProgram::Build(
     glBindAttribLocation(p.Program, VERTEX_ATTRIBUTE_LOCATION_JOINT_INDICES, "JointIndices");
     glBindAttribLocation(p.Program, VERTEX_ATTRIBUTE_LOCATION_JOINT_WEIGHTS, "JointWeights");
     glBindAttribLocation(p.Program, VERTEX_ATTRIBUTE_LOCATION_FONT_PARMS, "FontParms");
+    glBindAttribLocation(p.Program, VERTEX_ATTRIBUTE_LOCATION_FONT_PIVOT, "FontPivot");
+    glBindAttribLocation(p.Program, VERTEX_ATTRIBUTE_LOCATION_INSTANCE_0, "Instance0");
+    glBindAttribLocation(p.Program, VERTEX_ATTRIBUTE_LOCATION_INSTANCE_1, "Instance1");
+    glBindAttribLocation(p.Program, VERTEX_ATTRIBUTE_LOCATION_INSTANCE_2, "Instance2");
+    glBindAttribLocation(p.Program, VERTEX_ATTRIBUTE_LOCATION_INSTANCE_3, "Instance3");
 
     //--------------------------
     // Link Program
@@ -315,6 +333,19 @@ GlProgram GlProgram::Build(
         p.ModelMatrix.Type = ovrProgramParmType::FLOAT_MATRIX4;
         p.ModelMatrix.Location = glGetUniformLocation(p.Program, "ModelMatrix");
         p.ModelMatrix.Binding = p.ModelMatrix.Location;
+
+        // Both are inactive when the vertex shader never reads the model matrix.
+        p.InstanceBatch.Type = ovrProgramParmType::INT;
+        p.InstanceBatch.Location = glGetUniformLocation(p.Program, "InstanceBatch");
+        p.InstanceBatch.Binding = p.InstanceBatch.Location;
+
+        p.InstanceMatrices.Type = ovrProgramParmType::BUFFER_UNIFORM;
+        p.InstanceMatrices.Location = glGetUniformBlockIndex(p.Program, "InstanceMatrices");
+        if (p.InstanceMatrices.Location >= 0) {
+            p.InstanceMatrices.Binding = p.numUniformBufferBindings++;
+            glUniformBlockBinding(
+                p.Program, p.InstanceMatrices.Location, p.InstanceMatrices.Binding);
+        }
     }
 
     glUseProgram(p.Program);
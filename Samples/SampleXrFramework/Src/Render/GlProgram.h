@@ -71,7 +71,13 @@ enum VertexAttributeLocation {
     VERTEX_ATTRIBUTE_LOCATION_UV1 = 6,
     VERTEX_ATTRIBUTE_LOCATION_JOINT_INDICES = 7,
     VERTEX_ATTRIBUTE_LOCATION_JOINT_WEIGHTS = 8,
-    VERTEX_ATTRIBUTE_LOCATION_FONT_PARMS = 9
+    VERTEX_ATTRIBUTE_LOCATION_FONT_PARMS = 9,
+    VERTEX_ATTRIBUTE_LOCATION_FONT_PIVOT = 10,
+    // per-instance attributes, set up with glVertexAttribDivisor by the geometry that uses them
+    VERTEX_ATTRIBUTE_LOCATION_INSTANCE_0 = 11,
+    VERTEX_ATTRIBUTE_LOCATION_INSTANCE_1 = 12,
+    VERTEX_ATTRIBUTE_LOCATION_INSTANCE_2 = 13,
+    VERTEX_ATTRIBUTE_LOCATION_INSTANCE_3 = 14
 };
 
 enum class ovrProgramParmType : char {
@@ -157,6 +163,9 @@ struct GlProgram {
 
     static const int MAX_VIEWS = 2;
     static const int SCENE_MATRICES_UBO_SIZE = 2 * sizeof(OVR::Matrix4f) * MAX_VIEWS;
+    // Maximum number of surfaces merged into a single instanced draw.
+    static const int MAX_BATCH_INSTANCES = 64;
+    static const int INSTANCE_MATRICES_UBO_SIZE = sizeof(OVR::Matrix4f) * MAX_BATCH_INSTANCES;
 
     unsigned int Program;
     unsigned int VertexShader;
@@ -170,6 +179,16 @@ struct GlProgram {
                               //   mat4 ViewMatrix[NUM_VIEWS];
                               //   mat4 ProjectionMatrix[NUM_VIEWS];
                               // } sm;
+    ovrUniform InstanceBatch; // uniform for "InstanceBatch", non-zero while drawing a batch
+    ovrUniform InstanceMatrices; // uniform for "InstanceMatrices" ubo :
+                                 // uniform InstanceMatrices {
+                                 //   mat4 Models[MAX_BATCH_INSTANCES];
+                                 // } im;
+
+    // True if draws with this program can be merged into instanced batches.
+    bool SupportsBatching() const {
+        return InstanceBatch.Location >= 0 && InstanceMatrices.Location >= 0;
+    }
 
     ovrUniform Uniforms[ovrUniform::MAX_UNIFORMS];
     int numTextureBindings;
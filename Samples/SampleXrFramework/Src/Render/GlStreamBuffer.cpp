@@ -0,0 +1,187 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * Licensed under the Oculus SDK License Agreement (the "License");
+ * you may not use the Oculus SDK except in compliance with the License,
+ * which is provided at the time of installation or download, or which
+ * otherwise accompanies this software in either electronic or hard copy form.
+ *
+ * You may obtain a copy of the License at
+ * https://developer.oculus.com/licenses/oculussdk/
+ *
+ * Unless required by applicable law or agreed to in writing, the Oculus SDK
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/************************************************************************************
+
+Filename    :   GlStreamBuffer.cpp
+Content     :   Ring buffer for vertex data that is rewritten every frame.
+Language    :   C++
+
+*************************************************************************************/
+
+#include "GlStreamBuffer.h"
+#include "Misc/Log.h"
+
+#include "Egl.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace OVRFW {
+
+// Sizes are powers of two so every power of two alignment up to this divides them.
+static const size_t STREAM_INITIAL_CAPACITY = 256 * 1024;
+static const size_t STREAM_MAX_CAPACITY = 64 * 1024 * 1024;
+// How long to block on the oldest frame once the ring can't grow any further.
+static const uint64_t STREAM_WAIT_NANOSECONDS = 100 * 1000 * 1000;
+
+//==============================================================
+// GlStreamBuffer
+
+GlStreamBuffer::GlStreamBuffer() : Buffer(0), FrameIndex(0), Mapped(false) {}
+
+GlStreamBuffer::Allocation GlStreamBuffer::Map(const size_t size, const size_t alignment) {
+    Allocation allocation;
+    assert(!Mapped);
+    if (Mapped || size == 0) {
+        return allocation;
+    }
+    if (Buffer == 0 && !Grow(size)) {
+        return allocation;
+    }
+
+    RetireFrames(false);
+
+    size_t offset = 0;
+    bool fits = Ring.Allocate(size, alignment, offset);
+    if (!fits && Ring.GetCapacity() < STREAM_MAX_CAPACITY) {
+        // the GPU is still reading everything that is left, grow rather than stall
+        fits = Grow(size) && Ring.Allocate(size, alignment, offset);
+    }
+    while (!fits && Ring.GetFramesInFlight() > 0) {
+        RetireFrames(true);
+        fits = Ring.Allocate(size, alignment, offset);
+    }
+    if (!fits) {
+        ALOGW("GlStreamBuffer: failed to allocate %zu bytes", size);
+        return allocation;
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, Buffer);
+    // fences guarantee the GPU is done with this range, so the map doesn't need to synchronize
+    void* data = glMapBufferRange(
+        GL_ARRAY_BUFFER,
+        offset,
+        size,
+        GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    if (data == nullptr) {
+        ALOGW("GlStreamBuffer: failed to map %zu bytes", size);
+        return allocation;
+    }
+
+    Mapped = true;
+    allocation.buffer = Buffer;
+    allocation.offset = offset;
+    allocation.data = data;
+    return allocation;
+}
+
+void GlStreamBuffer::Unmap() {
+    if (!Mapped) {
+        return;
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, Buffer);
+    if (!glUnmapBuffer(GL_ARRAY_BUFFER)) {
+        ALOGW("GlStreamBuffer: buffer contents were lost while mapped");
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    Mapped = false;
+}
+
+void GlStreamBuffer::EndFrame() {
+    assert(!Mapped);
+    FrameIndex++;
+    if (Buffer == 0 || !Ring.EndFrame()) {
+        return;
+    }
+    Fences.push_back(glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+}
+
+void GlStreamBuffer::Destroy() {
+    Unmap();
+    for (void* fence : Fences) {
+        glDeleteSync(static_cast<GLsync>(fence));
+    }
+    Fences.clear();
+    if (Buffer != 0) {
+        glDeleteBuffers(1, &Buffer);
+        Buffer = 0;
+    }
+    Ring.Reset(0);
+}
+
+void GlStreamBuffer::RetireFrames(const bool wait) {
+    while (!Fences.empty()) {
+        GLsync fence = static_cast<GLsync>(Fences.front());
+        const GLenum result = wait
+            ? glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, STREAM_WAIT_NANOSECONDS)
+            : glClientWaitSync(fence, 0, 0);
+        if (result == GL_TIMEOUT_EXPIRED) {
+            if (wait) {
+                ALOGW("GlStreamBuffer: timed out waiting for the GPU");
+            }
+            return;
+        }
+        // GL_WAIT_FAILED means the fence is unusable; don't hold the memory forever
+        glDeleteSync(fence);
+        Fences.pop_front();
+        Ring.RetireOldestFrame();
+        if (wait) {
+            return;
+        }
+    }
+}
+
+bool GlStreamBuffer::Grow(const size_t minSize) {
+    size_t capacity = std::max(Ring.GetCapacity() * 2, STREAM_INITIAL_CAPACITY);
+    while (capacity < minSize) {
+        capacity *= 2;
+    }
+    if (capacity > STREAM_MAX_CAPACITY) {
+        return false;
+    }
+
+    if (Buffer != 0) {
+        // Draws already submitted and vertex arrays still pointing at the old buffer keep it
+        // alive until they are done with it. Deleting it while a vertex array is bound would
+        // detach it from that vertex array, so unbind first.
+        glBindVertexArray(0);
+        glDeleteBuffers(1, &Buffer);
+        Buffer = 0;
+    }
+    for (void* fence : Fences) {
+        glDeleteSync(static_cast<GLsync>(fence));
+    }
+    Fences.clear();
+
+    glGenBuffers(1, &Buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, Buffer);
+    glBufferData(GL_ARRAY_BUFFER, capacity, nullptr, GL_STREAM_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    Ring.Reset(capacity);
+    ALOG("GlStreamBuffer: %zu bytes", capacity);
+    return true;
+}
+
+GlStreamBuffer& GetVertexStreamBuffer() {
+    static GlStreamBuffer streamBuffer;
+    return streamBuffer;
+}
+
+} // namespace OVRFW
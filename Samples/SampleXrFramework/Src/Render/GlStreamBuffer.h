@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * Licensed under the Oculus SDK License Agreement (the "License");
+ * you may not use the Oculus SDK except in compliance with the License,
+ * which is provided at the time of installation or download, or which
+ * otherwise accompanies this software in either electronic or hard copy form.
+ *
+ * You may obtain a copy of the License at
+ * https://developer.oculus.com/licenses/oculussdk/
+ *
+ * Unless required by applicable law or agreed to in writing, the Oculus SDK
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/************************************************************************************
+
+Filename    :   GlStreamBuffer.h
+Content     :   Ring buffer for vertex data that is rewritten every frame.
+Language    :   C++
+
+*************************************************************************************/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+
+namespace OVRFW {
+
+// Offset bookkeeping for a ring of GPU memory that is sub-allocated every frame. Positions
+// increase monotonically and wrap by the capacity, so the bytes the GPU may still be reading
+// are always the range [Tail, Head). Holds no GL state.
+class ovrStreamRing {
+   public:
+    ovrStreamRing() : Capacity(0), Head(0), Tail(0) {}
+
+    // Empties the ring; capacity must be a multiple of every alignment passed to Allocate.
+    void Reset(const size_t capacity);
+
+    // Returns false if size bytes can't be placed without overwriting a frame in flight.
+    // An allocation never straddles the end of the buffer.
+    bool Allocate(const size_t size, const size_t alignment, size_t& offset);
+
+    // Closes the current frame. Returns false if nothing was allocated since the last frame,
+    // in which case no frame was added.
+    bool EndFrame();
+
+    // Releases the oldest frame in flight once the GPU is done with it.
+    void RetireOldestFrame();
+
+    int GetFramesInFlight() const {
+        return static_cast<int>(FrameEnds.size());
+    }
+    size_t GetCapacity() const {
+        return Capacity;
+    }
+    // Bytes allocated but not yet retired, including this frame and padding.
+    size_t GetUsed() const {
+        return static_cast<size_t>(Head - Tail);
+    }
+
+   private:
+    size_t Capacity;
+    uint64_t Head; // end of the last allocation
+    uint64_t Tail; // start of the oldest frame in flight
+    std::deque<uint64_t> FrameEnds; // Head at the end of each frame in flight
+};
+
+// Streaming vertex buffer shared by renderers that rebuild their geometry every frame.
+// Each allocation is mapped unsynchronized and written directly; the frame's allocations are
+// fenced in EndFrame() and the space is reused only after the GPU has passed that fence.
+// When the ring is full it grows instead of stalling the CPU, up to a limit.
+//
+// Data written to the stream is valid for draws submitted before the next EndFrame(), so a
+// renderer that streams its vertices must write them again on every frame it draws.
+// All calls must be made on the thread that owns the GL context.
+class GlStreamBuffer {
+   public:
+    struct Allocation {
+        uint32_t buffer = 0; // GL_ARRAY_BUFFER to source the vertices from
+        size_t offset = 0; // byte offset of the allocation in buffer
+        void* data = nullptr; // mapped memory to write, nullptr if the allocation failed
+    };
+
+    GlStreamBuffer();
+
+    // Maps size bytes for writing. Must be followed by Unmap() before the next Map() or draw.
+    Allocation Map(const size_t size, const size_t alignment = 16);
+    void Unmap();
+
+    // Fences the allocations of this frame. Called once per frame after all its draws.
+    void EndFrame();
+
+    // Frees the buffer and fences; the next Map() creates them again.
+    void Destroy();
+
+    // Counts calls to EndFrame(), so a renderer can tell whether it streamed this frame.
+    int64_t GetFrameIndex() const {
+        return FrameIndex;
+    }
+
+   private:
+    void RetireFrames(const bool wait);
+    bool Grow(const size_t minSize);
+
+    ovrStreamRing Ring;
+    uint32_t Buffer;
+    std::deque<void*> Fences; // one GLsync per frame in flight, matching the ring
+    int64_t FrameIndex;
+    bool Mapped;
+};
+
+// The stream used by the framework's dynamic renderers.
+GlStreamBuffer& GetVertexStreamBuffer();
+
+} // namespace OVRFW
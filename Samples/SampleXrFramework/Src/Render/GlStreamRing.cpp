@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * Licensed under the Oculus SDK License Agreement (the "License");
+ * you may not use the Oculus SDK except in compliance with the License,
+ * which is provided at the time of installation or download, or which
+ * otherwise accompanies this software in either electronic or hard copy form.
+ *
+ * You may obtain a copy of the License at
+ * https://developer.oculus.com/licenses/oculussdk/
+ *
+ * Unless required by applicable law or agreed to in writing, the Oculus SDK
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/************************************************************************************
+
+Filename    :   GlStreamRing.cpp
+Content     :   Offset bookkeeping of the stream buffer ring. Nothing here makes GL calls.
+Language    :   C++
+
+*************************************************************************************/
+
+#include "GlStreamBuffer.h"
+
+#include <cassert>
+
+namespace OVRFW {
+
+void ovrStreamRing::Reset(const size_t capacity) {
+    Capacity = capacity;
+    Head = 0;
+    Tail = 0;
+    FrameEnds.clear();
+}
+
+bool ovrStreamRing::Allocate(const size_t size, const size_t alignment, size_t& offset) {
+    assert(alignment > 0 && (alignment & (alignment - 1)) == 0);
+    if (Capacity == 0 || size > Capacity) {
+        return false;
+    }
+    if (Head == Tail) {
+        // nothing in flight, start at the beginning so the whole buffer is usable
+        Head = Tail = 0;
+    }
+
+    uint64_t start = (Head + alignment - 1) & ~static_cast<uint64_t>(alignment - 1);
+    const uint64_t startOffset = start % Capacity;
+    if (startOffset + size > Capacity) {
+        // skip the rest of the buffer and start over at offset 0
+        start += Capacity - startOffset;
+    }
+    if (start + size - Tail > Capacity) {
+        return false;
+    }
+
+    offset = static_cast<size_t>(start % Capacity);
+    Head = start + size;
+    return true;
+}
+
+bool ovrStreamRing::EndFrame() {
+    const uint64_t frameStart = FrameEnds.empty() ? Tail : FrameEnds.back();
+    if (Head == frameStart) {
+        return false;
+    }
+    FrameEnds.push_back(Head);
+    return true;
+}
+
+void ovrStreamRing::RetireOldestFrame() {
+    assert(!FrameEnds.empty());
+    if (!FrameEnds.empty()) {
+        Tail = FrameEnds.front();
+        FrameEnds.pop_front();
+    }
+}
+
+} // namespace OVRFW
@@ -34,13 +34,7 @@ Authors     :   John Carmack
 #include "PackageFiles.h"
 #include "stb_image.h"
 
-// #define OVR_USE_PERF_TIMER
-#if defined(OVR_USE_PERF_TIMER)
 #include "OVR_PerfTimer.h"
-#else
-#define OVR_PERF_TIMER(x) \
-    { ; }
-#endif
 
 #include <algorithm>
 #include <fstream>
@@ -957,24 +951,24 @@ struct astcHeader {
     unsigned char zsize[3];
 };
 
-GlTexture LoadASTCTextureFromMemory(
-    uint8_t const* buffer,
-    const size_t bufferSize,
-    const int numPlanes,
-    const bool useSrgbFormat) {
+// Returns Texture_None if the buffer doesn't start with a supported 2D ASTC header.
+static eTextureFormat
+ParseASTCHeader(uint8_t const* buffer, const size_t bufferSize, int& width, int& height) {
+    if (bufferSize < sizeof(astcHeader)) {
+        ALOG("Invalid ASTC file");
+        return Texture_None;
+    }
     astcHeader const* header = reinterpret_cast<astcHeader const*>(buffer);
 
-    int const w =
+    width =
         ((int)header->xsize[2] << 16) | ((int)header->xsize[1] << 8) | ((int)header->xsize[0]);
-    int const h =
+    height =
         ((int)header->ysize[2] << 16) | ((int)header->ysize[1] << 8) | ((int)header->ysize[0]);
 
-    assert(numPlanes == 1 || numPlanes == 4);
-    OVR_UNUSED(numPlanes);
     if (header->blockDim_z != 1) {
         assert(header->blockDim_z == 1);
         ALOG("Only 2D ASTC textures are supported");
-        return GlTexture();
+        return Texture_None;
     }
 
     eTextureFormat format = Texture_None;
@@ -1023,6 +1017,22 @@ GlTexture LoadASTCTextureFromMemory(
     if (format == Texture_None) {
         assert(format != Texture_None);
         ALOG("Unhandled ASTC block size: %i x %i", header->blockDim_x, header->blockDim_y);
+    }
+    return format;
+}
+
+GlTexture LoadASTCTextureFromMemory(
+    uint8_t const* buffer,
+    const size_t bufferSize,
+    const int numPlanes,
+    const bool useSrgbFormat) {
+    assert(numPlanes == 1 || numPlanes == 4);
+    OVR_UNUSED(numPlanes);
+
+    int w = 0;
+    int h = 0;
+    const eTextureFormat format = ParseASTCHeader(buffer, bufferSize, w, h);
+    if (format == Texture_None) {
         return GlTexture();
     }
     return CreateGlTexture(
@@ -1337,20 +1347,25 @@ struct OVR_KTX_HEADER {
 };
 #pragma pack()
 
-GlTexture LoadTextureKTX(
+// Layout of the texture data in a KTX file.
+struct ovrKTXLayout {
+    eTextureFormat format;
+    int width;
+    int height;
+    int numFaces;
+    std::uint32_t mipCount;
+    uintptr_t startTex;
+};
+
+static bool ParseKTXHeader(
     const char* fileName,
     const unsigned char* buffer,
     const int bufferLength,
-    bool useSrgbFormat,
     bool noMipMaps,
-    int& width,
-    int& height) {
-    width = 0;
-    height = 0;
-
+    ovrKTXLayout& layout) {
     if (bufferLength < (int)(sizeof(OVR_KTX_HEADER))) {
         ALOG("%s: Invalid KTX file", fileName);
-        return GlTexture(0, 0, 0);
+        return false;
     }
 
     const char fileIdentifier[12] = {
@@ -1359,17 +1374,17 @@ GlTexture LoadTextureKTX(
     const OVR_KTX_HEADER& header = *(OVR_KTX_HEADER*)buffer;
     if (memcmp(header.identifier, fileIdentifier, sizeof(fileIdentifier)) != 0) {
         ALOG("%s: Invalid KTX file", fileName);
-        return GlTexture(0, 0, 0);
+        return false;
     }
     // only support little endian
     if (header.endianness != 0x04030201) {
         ALOG("%s: KTX file has wrong endianess", fileName);
-        return GlTexture(0, 0, 0);
+        return false;
     }
     // only support compressed or unsigned byte
     if (header.glType != 0 && header.glType != GL_UNSIGNED_BYTE) {
         ALOG("%s: KTX file has unsupported glType %d", fileName, header.glType);
-        return GlTexture(0, 0, 0);
+        return false;
     }
     // no support for texture arrays
     if (header.numberOfArrayElements != 0) {
@@ -1377,63 +1392,83 @@ GlTexture LoadTextureKTX(
             "%s: KTX file has unsupported number of array elements %d",
             fileName,
             header.numberOfArrayElements);
-        return GlTexture(0, 0, 0);
+        return false;
     }
 
     // derive the texture format from the GL format
-    eTextureFormat format = Texture_None;
-    if (!GlFormatToTextureFormat(format, header.glFormat, header.glInternalFormat)) {
+    layout.format = Texture_None;
+    if (!GlFormatToTextureFormat(layout.format, header.glFormat, header.glInternalFormat)) {
         ALOG(
             "%s: KTX file has unsupported glFormat %d, glInternalFormat %d",
             fileName,
             header.glFormat,
             header.glInternalFormat);
-        return GlTexture(0, 0, 0);
+        return false;
     }
 
     // skip the key value data
-    const uintptr_t startTex = sizeof(OVR_KTX_HEADER) + header.bytesOfKeyValueData;
-    if ((startTex < sizeof(OVR_KTX_HEADER)) || (startTex >= static_cast<size_t>(bufferLength))) {
+    layout.startTex = sizeof(OVR_KTX_HEADER) + header.bytesOfKeyValueData;
+    if ((layout.startTex < sizeof(OVR_KTX_HEADER)) ||
+        (layout.startTex >= static_cast<size_t>(bufferLength))) {
         ALOG("%s: Invalid KTX header sizes", fileName);
-        return GlTexture(0, 0, 0);
+        return false;
     }
 
-    width = header.pixelWidth;
-    height = header.pixelHeight;
+    if (header.numberOfFaces != 1 && header.numberOfFaces != 6) {
+        ALOG("%s: KTX file has unsupported number of faces %d", fileName, header.numberOfFaces);
+        return false;
+    }
 
-    const std::uint32_t mipCount = (noMipMaps)
+    layout.width = header.pixelWidth;
+    layout.height = header.pixelHeight;
+    layout.numFaces = header.numberOfFaces;
+    layout.mipCount = (noMipMaps)
         ? 1
         : std::max<std::uint32_t>(static_cast<std::uint32_t>(1u), header.numberOfMipmapLevels);
+    return true;
+}
+
+GlTexture LoadTextureKTX(
+    const char* fileName,
+    const unsigned char* buffer,
+    const int bufferLength,
+    bool useSrgbFormat,
+    bool noMipMaps,
+    int& width,
+    int& height) {
+    width = 0;
+    height = 0;
 
-    if (header.numberOfFaces == 1) {
+    ovrKTXLayout layout;
+    if (!ParseKTXHeader(fileName, buffer, bufferLength, noMipMaps, layout)) {
+        return GlTexture(0, 0, 0);
+    }
+
+    width = layout.width;
+    height = layout.height;
+
+    if (layout.numFaces == 1) {
         return CreateGlTexture(
             fileName,
-            format,
+            layout.format,
             width,
             height,
-            buffer + startTex,
-            bufferLength - startTex,
-            mipCount,
-            useSrgbFormat,
-            true);
-    } else if (header.numberOfFaces == 6) {
-        return CreateGlCubeTexture(
-            fileName,
-            format,
-            width,
-            height,
-            buffer + startTex,
-            bufferLength - startTex,
-            mipCount,
+            buffer + layout.startTex,
+            bufferLength - layout.startTex,
+            layout.mipCount,
             useSrgbFormat,
             true);
-    } else {
-        ALOG("%s: KTX file has unsupported number of faces %d", fileName, header.numberOfFaces);
     }
-
-    width = 0;
-    height = 0;
-    return GlTexture(0, 0, 0);
+    return CreateGlCubeTexture(
+        fileName,
+        layout.format,
+        width,
+        height,
+        buffer + layout.startTex,
+        bufferLength - layout.startTex,
+        layout.mipCount,
+        useSrgbFormat,
+        true);
 }
 
 struct OVR_KTX2_HEADER {
@@ -1449,12 +1484,11 @@ struct OVR_KTX2_HEADER {
     std::uint32_t supercompressionScheme;
 };
 
-GlTexture LoadTextureKTX2(
+// Loads a KTX2 file into a libktx texture, transcoding it to ASTC if needed. Makes no GL calls.
+static ktxTexture* LoadKTX2Texture(
     const char* fileName,
     const unsigned char* buffer,
     const int bufferLength,
-    bool useSrgbFormat,
-    bool noMipMaps,
     int& width,
     int& height) {
     width = 0;
@@ -1462,7 +1496,7 @@ GlTexture LoadTextureKTX2(
 
     if (bufferLength < (int)(sizeof(OVR_KTX2_HEADER))) {
         ALOG("%s: Invalid KTX2 file", fileName);
-        return GlTexture(0, 0, 0);
+        return nullptr;
     }
 
     const char fileIdentifier[12] = {
@@ -1471,7 +1505,7 @@ GlTexture LoadTextureKTX2(
     const OVR_KTX2_HEADER& header = *(OVR_KTX2_HEADER*)buffer;
     if (memcmp(header.identifier, fileIdentifier, sizeof(fileIdentifier)) != 0) {
         ALOG("%s: Invalid KTX2 file", fileName);
-        return GlTexture(0, 0, 0);
+        return nullptr;
     }
     // no support for texture arrays
     if (header.numberOfArrayElements != 0) {
@@ -1479,7 +1513,7 @@ GlTexture LoadTextureKTX2(
             "%s: KTX2 file has unsupported number of array elements %d",
             fileName,
             header.numberOfArrayElements);
-        return GlTexture(0, 0, 0);
+        return nullptr;
     }
 
     width = header.pixelWidth;
@@ -1491,7 +1525,7 @@ GlTexture LoadTextureKTX2(
         (const uint8_t*)buffer, bufferLength, KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT, &kTexture);
     if (result != KTX_SUCCESS) {
         ALOG("%s: KTX2 CreateFromMemory failed. result is %d", fileName, result);
-        return GlTexture(0, 0, 0);
+        return nullptr;
     }
 
     if (ktxTexture_NeedsTranscoding(kTexture)) {
@@ -1499,36 +1533,66 @@ GlTexture LoadTextureKTX2(
             (ktxTexture2*)kTexture, ktx_transcode_fmt_e::KTX_TTF_ASTC_4x4_RGBA, 0);
         if (result != KTX_SUCCESS) {
             ALOG("%s: Coudln't transcode ktx2 file to ASTC, ETC files not supported", fileName);
-            return GlTexture(0, 0, 0);
+            ktxTexture_Destroy(kTexture);
+            return nullptr;
         }
     }
+    return kTexture;
+}
 
+static GlTexture
+UploadKTX2Texture(const char* fileName, ktxTexture* kTexture, const int width, const int height) {
     GLuint texid = 0;
     GLenum target, glerror;
-    result = ktxTexture_GLUpload(kTexture, &texid, &target, &glerror);
+    const KTX_error_code result = ktxTexture_GLUpload(kTexture, &texid, &target, &glerror);
     if (result != KTX_SUCCESS) {
         ALOG("%s: GLUpload result failed. result is %d", fileName, result);
         return GlTexture(0, 0, 0);
-    } else {
-        return GlTexture(texid, target, width, height);
     }
+    return GlTexture(texid, target, width, height);
 }
 
-unsigned char* LoadImageToRGBABuffer(
+GlTexture LoadTextureKTX2(
     const char* fileName,
-    const unsigned char* inBuffer,
-    const size_t inBufferLen,
+    const unsigned char* buffer,
+    const int bufferLength,
+    bool useSrgbFormat,
+    bool noMipMaps,
     int& width,
     int& height) {
+    ktxTexture* kTexture = LoadKTX2Texture(fileName, buffer, bufferLength, width, height);
+    if (kTexture == nullptr) {
+        return GlTexture(0, 0, 0);
+    }
+    const GlTexture texId = UploadKTX2Texture(fileName, kTexture, width, height);
+    ktxTexture_Destroy(kTexture);
+    return texId;
+}
+
+static std::string GetLowerCaseExtension(const char* fileName) {
     std::string ext = GetExtension(fileName);
     const auto& loc = std::use_facet<std::ctype<char>>(std::locale());
     loc.tolower(&ext[0], &ext[0] + ext.length());
+    return ext;
+}
+
+static bool IsStbImageExtension(const std::string& ext) {
+    return ext == ".jpg" || ext == ".tga" || ext == ".png" || ext == ".bmp" || ext == ".psd" ||
+        ext == ".gif" || ext == ".hdr" || ext == ".pic";
+}
+
+unsigned char* LoadImageToRGBABuffer(
+    const char* fileName,
+    const unsigned char* inBuffer,
+    const size_t inBufferLen,
+    int& width,
+    int& height) {
+    std::string ext = GetLowerCaseExtension(fileName);
 
     width = 0;
     height = 0;
 
-    if (ext == ".jpg" || ext == ".tga" || ext == ".png" || ext == ".bmp" || ext == ".psd" ||
-        ext == ".gif" || ext == ".hdr" || ext == ".pic") {
+    if (IsStbImageExtension(ext)) {
         // Uncompressed files loaded by stb_image
         int comp;
         stbi_uc* image = stbi_load_from_memory(
@@ -1553,6 +1617,50 @@ static int MipLevelsForSize(int width, int height) {
     return levels;
 }
 
+// Decodes an image with stb_image to RGBA, applying the flags that modify the image.
+static stbi_uc* LoadStbImage(
+    const uint8_t* buffer,
+    const size_t bufferSize,
+    const TextureFlags_t& flags,
+    int& width,
+    int& height) {
+    int comp;
+    stbi_uc* image = stbi_load_from_memory(buffer, bufferSize, &width, &height, &comp, 4);
+    if (image == nullptr) {
+        ALOG("stbi_load_from_memory() failed!");
+        return nullptr;
+    }
+
+    // Optionally outline the border alpha.
+    if (flags & TEXTUREFLAG_ALPHA_BORDER) {
+        for (int i = 0; i < width; i++) {
+            image[i * 4 + 3] = 0;
+            image[((height - 1) * width + i) * 4 + 3] = 0;
+        }
+        for (int i = 0; i < height; i++) {
+            image[i * width * 4 + 3] = 0;
+            image[(i * width + width - 1) * 4 + 3] = 0;
+        }
+    }
+
+    // flip
+    if (flags & TEXTUREFLAG_FLIP_Y_ON_LOAD) {
+        std::vector<uint32_t> flipBuffer(width);
+        uint32_t* imageData = (uint32_t*)image;
+        uint32_t* bufferData = flipBuffer.data();
+        const int top = height - 1;
+        for (int y = 0; y < (height / 2); ++y) {
+            int t = top - y;
+            uint32_t* src = imageData + (y * width);
+            uint32_t* dst = imageData + (t * width);
+            memcpy(bufferData, src, width * sizeof(uint32_t));
+            memcpy(src, dst, width * sizeof(uint32_t));
+            memcpy(dst, bufferData, width * sizeof(uint32_t));
+        }
+    }
+    return image;
+}
+
 GlTexture LoadTextureFromBuffer(
     const char* fileName,
     const uint8_t* buffer,
@@ -1560,9 +1668,7 @@ GlTexture LoadTextureFromBuffer(
     const TextureFlags_t& flags,
     int& width,
     int& height) {
-    std::string ext = GetExtension(fileName);
-    const auto& loc = std::use_facet<std::ctype<char>>(std::locale());
-    loc.tolower(&ext[0], &ext[0] + ext.length());
+    std::string ext = GetLowerCaseExtension(fileName);
 
     // LOG( "Loading texture buffer %s (%s), length %i", fileName, ext.c_str(), buffer.Length );
 
@@ -1579,41 +1685,10 @@ GlTexture LoadTextureFromBuffer(
             buffer == nullptr ? nullptr : buffer,
             static_cast<int>(bufferSize));
 #endif
-    } else if (
-        ext == ".jpg" || ext == ".tga" || ext == ".png" || ext == ".bmp" || ext == ".psd" ||
-        ext == ".gif" || ext == ".hdr" || ext == ".pic") {
+    } else if (IsStbImageExtension(ext)) {
         // Uncompressed files loaded by stb_image
-        int comp;
-        stbi_uc* image = stbi_load_from_memory(buffer, bufferSize, &width, &height, &comp, 4);
+        stbi_uc* image = LoadStbImage(buffer, bufferSize, flags, width, height);
         if (image != nullptr) {
-            // Optionally outline the border alpha.
-            if (flags & TEXTUREFLAG_ALPHA_BORDER) {
-                for (int i = 0; i < width; i++) {
-                    image[i * 4 + 3] = 0;
-                    image[((height - 1) * width + i) * 4 + 3] = 0;
-                }
-                for (int i = 0; i < height; i++) {
-                    image[i * width * 4 + 3] = 0;
-                    image[(i * width + width - 1) * 4 + 3] = 0;
-                }
-            }
-
-            // flip
-            if (flags & TEXTUREFLAG_FLIP_Y_ON_LOAD) {
-                std::vector<uint32_t> flipBuffer(width);
-                uint32_t* imageData = (uint32_t*)image;
-                uint32_t* bufferData = flipBuffer.data();
-                const int top = height - 1;
-                for (int y = 0; y < (height / 2); ++y) {
-                    int t = top - y;
-                    uint32_t* src = imageData + (y * width);
-                    uint32_t* dst = imageData + (t * width);
-                    memcpy(bufferData, src, width * sizeof(uint32_t));
-                    memcpy(src, dst, width * sizeof(uint32_t));
-                    memcpy(dst, bufferData, width * sizeof(uint32_t));
-                }
-            }
-
             const size_t dataSize = GetOvrTextureSize(Texture_RGBA, width, height);
             texId = CreateGlTexture(
                 fileName,
@@ -1631,8 +1706,6 @@ GlTexture LoadTextureFromBuffer(
                 glGenerateMipmap(texId.target);
                 glTexParameteri(texId.target, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
             }
-        } else {
-            ALOG("stbi_load_from_memory() failed!");
         }
     } else if (ext == ".pvr") {
         texId = LoadTexturePVR(
@@ -1701,6 +1774,181 @@ GlTexture LoadTextureFromBuffer(
     return texId;
 }
 
+size_t ovrDecodedTexture::GetUploadSize() const {
+    return (Data != nullptr) ? DataSize : FileSize;
+}
+
+// Decodes decoded.File. Formats that don't need the file once decoded release it.
+static bool DecodeTextureFile(ovrDecodedTexture& decoded) {
+    const char* fileName = decoded.FileName.c_str();
+    const TextureFlags_t& flags = decoded.Flags;
+    decoded.UseSrgbFormat = flags & TEXTUREFLAG_USE_SRGB;
+    decoded.MipCount = 1;
+    decoded.NumFaces = 1;
+    auto releaseFile = [&decoded]() {
+        decoded.File = nullptr;
+        decoded.FileSize = 0;
+        decoded.FileData = std::vector<uint8_t>();
+        decoded.FileOwner = nullptr;
+    };
+
+    const std::string ext = GetLowerCaseExtension(fileName);
+    if (IsStbImageExtension(ext)) {
+        stbi_uc* image =
+            LoadStbImage(decoded.File, decoded.FileSize, flags, decoded.Width, decoded.Height);
+        releaseFile();
+        if (image == nullptr) {
+            return false;
+        }
+        decoded.Pixels = std::shared_ptr<uint8_t>(image, [](uint8_t* p) { free(p); });
+        decoded.Format = Texture_RGBA;
+        decoded.Data = image;
+        decoded.DataSize = GetOvrTextureSize(Texture_RGBA, decoded.Width, decoded.Height);
+        decoded.GenerateMipmaps = !(flags & TEXTUREFLAG_NO_MIPMAPS);
+        return true;
+    } else if (ext == ".ktx") {
+        ovrKTXLayout layout;
+        if (!ParseKTXHeader(
+                fileName,
+                decoded.File,
+                static_cast<int>(decoded.FileSize),
+                flags & TEXTUREFLAG_NO_MIPMAPS,
+                layout)) {
+            return false;
+        }
+        decoded.Format = layout.format;
+        decoded.Width = layout.width;
+        decoded.Height = layout.height;
+        decoded.MipCount = layout.mipCount;
+        decoded.NumFaces = layout.numFaces;
+        decoded.ImageSizeStored = true;
+        decoded.Data = decoded.File + layout.startTex;
+        decoded.DataSize = decoded.FileSize - layout.startTex;
+        return true;
+    } else if (ext == ".ktx2") {
+        ktxTexture* kTexture = LoadKTX2Texture(
+            fileName,
+            decoded.File,
+            static_cast<int>(decoded.FileSize),
+            decoded.Width,
+            decoded.Height);
+        releaseFile();
+        if (kTexture == nullptr) {
+            return false;
+        }
+        decoded.KtxTexture = std::shared_ptr<void>(
+            kTexture, [](void* p) { ktxTexture_Destroy(static_cast<ktxTexture*>(p)); });
+        decoded.DataSize = ktxTexture_GetDataSize(kTexture);
+        return true;
+    } else if (ext == ".astc") {
+        decoded.Format =
+            ParseASTCHeader(decoded.File, decoded.FileSize, decoded.Width, decoded.Height);
+        if (decoded.Format == Texture_None) {
+            return false;
+        }
+        decoded.Data = decoded.File + sizeof(struct astcHeader);
+        decoded.DataSize = decoded.FileSize - sizeof(struct astcHeader);
+        return true;
+    }
+
+    // Other formats are loaded from the file data when they are uploaded.
+    return true;
+}
+
+bool DecodeTextureFromBuffer(
+    const char* fileName,
+    std::vector<uint8_t> buffer,
+    const TextureFlags_t& flags,
+    ovrDecodedTexture& decoded) {
+    decoded = ovrDecodedTexture();
+    if (fileName == nullptr || buffer.empty()) {
+        return false;
+    }
+    decoded.FileName = fileName;
+    decoded.Flags = flags;
+    decoded.FileData = std::move(buffer);
+    decoded.File = decoded.FileData.data();
+    decoded.FileSize = decoded.FileData.size();
+    return DecodeTextureFile(decoded);
+}
+
+bool DecodeTextureFromBuffer(
+    const char* fileName,
+    const uint8_t* data,
+    const size_t size,
+    const std::shared_ptr<const void>& owner,
+    const TextureFlags_t& flags,
+    ovrDecodedTexture& decoded) {
+    decoded = ovrDecodedTexture();
+    if (fileName == nullptr || data == nullptr || size == 0) {
+        return false;
+    }
+    decoded.FileName = fileName;
+    decoded.Flags = flags;
+    decoded.File = data;
+    decoded.FileSize = size;
+    decoded.FileOwner = owner;
+    return DecodeTextureFile(decoded);
+}
+
+GlTexture CreateTextureFromDecoded(const ovrDecodedTexture& decoded) {
+    const char* fileName = decoded.FileName.c_str();
+    if (decoded.KtxTexture != nullptr) {
+        return UploadKTX2Texture(
+            fileName,
+            static_cast<ktxTexture*>(decoded.KtxTexture.get()),
+            decoded.Width,
+            decoded.Height);
+    }
+
+    if (decoded.Format == Texture_None) {
+        if (decoded.File == nullptr) {
+            return GlTexture();
+        }
+        int width = 0;
+        int height = 0;
+        return LoadTextureFromBuffer(
+            fileName,
+            decoded.File,
+            decoded.FileSize,
+            decoded.Flags | TextureFlags_t(TEXTUREFLAG_NO_DEFAULT),
+            width,
+            height);
+    }
+
+    GlTexture texId;
+    if (decoded.NumFaces == 6) {
+        texId = CreateGlCubeTexture(
+            fileName,
+            decoded.Format,
+            decoded.Width,
+            decoded.Height,
+            decoded.Data,
+            decoded.DataSize,
+            decoded.MipCount,
+            decoded.UseSrgbFormat,
+            decoded.ImageSizeStored);
+    } else {
+        texId = CreateGlTexture(
+            fileName,
+            decoded.Format,
+            decoded.Width,
+            decoded.Height,
+            decoded.Data,
+            decoded.DataSize,
+            decoded.MipCount,
+            decoded.UseSrgbFormat,
+            decoded.ImageSizeStored);
+    }
+    if (texId.IsValid() && decoded.GenerateMipmaps) {
+        glBindTexture(texId.target, texId.texture);
+        glGenerateMipmap(texId.target);
+        glTexParameteri(texId.target, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glBindTexture(texId.target, 0);
+    }
+    return texId;
+}
+
 GlTexture LoadTextureFromOtherApplicationPackage(
     void* zipFile,
     const char* nameInZip,
@@ -32,6 +32,8 @@ Authors     :   John Carmack
 #include "OVR_BitFlags.h"
 #include "OVR_FileSys.h"
 
+#include <memory>
+#include <string>
 #include <vector>
 
 // Explicitly using unsigned instead of GLUint / GLenum to avoid including GL headers
@@ -233,6 +235,72 @@ inline GlTexture LoadTextureFromBuffer(
     return LoadTextureFromBuffer(fileName, buffer.data(), buffer.size(), flags, width, height);
 }
 
+// A texture file decoded into memory, so it can be uploaded later by CreateTextureFromDecoded on
+// the thread that owns the GL context. Decoding makes no GL calls, so it can run on any thread.
+class ovrDecodedTexture {
+   public:
+    ovrDecodedTexture()
+        : Format(Texture_None),
+          Width(0),
+          Height(0),
+          MipCount(0),
+          NumFaces(0),
+          UseSrgbFormat(false),
+          ImageSizeStored(false),
+          GenerateMipmaps(false),
+          Data(nullptr),
+          DataSize(0),
+          File(nullptr),
+          FileSize(0) {}
+
+    // Number of bytes that will be handed to GL.
+    size_t GetUploadSize() const;
+
+    std::string FileName;
+    TextureFlags_t Flags;
+    eTextureFormat Format; // Texture_None if the file is loaded as a whole when uploaded
+    int Width;
+    int Height;
+    int MipCount;
+    int NumFaces;
+    bool UseSrgbFormat;
+    bool ImageSizeStored; // KTX layout with the size before each mip level
+    bool GenerateMipmaps;
+    const uint8_t* Data; // mip levels, points into File or Pixels
+    size_t DataSize;
+    // The file, for the formats that keep it, in FileData or in memory FileOwner keeps alive.
+    const uint8_t* File;
+    size_t FileSize;
+    std::vector<uint8_t> FileData;
+    std::shared_ptr<const void> FileOwner;
+    std::shared_ptr<uint8_t> Pixels;
+    std::shared_ptr<void> KtxTexture; // transcoded KTX2 texture, uploaded through libktx
+};
+
+// Decodes the stb_image formats to RGBA, and parses the KTX, KTX2 and ASTC containers,
+// transcoding KTX2 if needed. Other formats keep the file data and are loaded by
+// LoadTextureFromBuffer when uploaded. Returns false if the file can't be decoded.
+bool DecodeTextureFromBuffer(
+    const char* fileName,
+    std::vector<uint8_t> buffer,
+    const TextureFlags_t& flags,
+    ovrDecodedTexture& decoded);
+
+// Same as above for a file read in place, such as an image in a mapped glb file. Formats that
+// keep the file reference data instead of copying it, and hold on to owner. owner may be null if
+// data stays valid until the texture is created.
+bool DecodeTextureFromBuffer(
+    const char* fileName,
+    const uint8_t* data,
+    const size_t size,
+    const std::shared_ptr<const void>& owner,
+    const TextureFlags_t& flags,
+    ovrDecodedTexture& decoded);
+
+// Creates the GL texture for a decoded texture. Returns an invalid texture on failure, no default
+// texture is created.
+GlTexture CreateTextureFromDecoded(const ovrDecodedTexture& decoded);
+
 // Returns 0 if the file is not found.
 // For a file placed in the project assets folder, nameInZip would be
 // something like "assets/cube.pvr".
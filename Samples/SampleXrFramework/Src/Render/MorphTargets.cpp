@@ -0,0 +1,295 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * Licensed under the Oculus SDK License Agreement (the "License");
+ * you may not use the Oculus SDK except in compliance with the License,
+ * which is provided at the time of installation or download, or which
+ * otherwise accompanies this software in either electronic or hard copy form.
+ *
+ * You may obtain a copy of the License at
+ * https://developer.oculus.com/licenses/oculussdk/
+ *
+ * Unless required by applicable law or agreed to in writing, the Oculus SDK
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/************************************************************************************
+
+Filename    :   MorphTargets.cpp
+Content     :   Morph target (blend shape) evaluation with sparse quantized deltas.
+Language    :   C++
+
+*************************************************************************************/
+
+#include "MorphTargets.h"
+#include "Misc/Log.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define MORPH_NEON
+#elif defined(OVR_CPU_X86_64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define MORPH_SSE2
+#endif
+
+namespace OVRFW {
+
+static const float MAX_QUANTIZED_DELTA = 32767.0f;
+
+// result[slots[i]] += deltas[i] * scale, four components at a time.
+static void AccumulateDeltas(
+    OVR::Vector4f* result,
+    const uint32_t* slots,
+    const int16_t* deltas,
+    const size_t count,
+    const float scale) {
+#if defined(MORPH_NEON)
+    const float32x4_t s = vdupq_n_f32(scale);
+    for (size_t i = 0; i < count; i++) {
+        const float32x4_t d = vcvtq_f32_s32(vmovl_s16(vld1_s16(deltas + i * 4)));
+        float* r = &result[slots[i]].x;
+        vst1q_f32(r, vmlaq_f32(vld1q_f32(r), d, s));
+    }
+#elif defined(MORPH_SSE2)
+    const __m128 s = _mm_set1_ps(scale);
+    for (size_t i = 0; i < count; i++) {
+        const __m128i d16 = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(deltas + i * 4));
+        // sign extend to 32 bits by moving each value to the top half
+        const __m128 d = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(d16, d16), 16));
+        float* r = &result[slots[i]].x;
+        _mm_storeu_ps(r, _mm_add_ps(_mm_loadu_ps(r), _mm_mul_ps(d, s)));
+    }
+#else
+    for (size_t i = 0; i < count; i++) {
+        OVR::Vector4f& r = result[slots[i]];
+        const int16_t* d = deltas + i * 4;
+        r.x += d[0] * scale;
+        r.y += d[1] * scale;
+        r.z += d[2] * scale;
+        r.w += d[3] * scale;
+    }
+#endif
+}
+
+template <typename T>
+static OVR::Vector4f ToVector4(const T& value) {
+    OVR::Vector4f v(0.0f);
+    memcpy(&v.x, &value.x, sizeof(T));
+    return v;
+}
+
+template <typename T>
+void MorphTargets::BuildChannel(
+    const int channel,
+    std::vector<T> VertexAttribs::*attrib,
+    const VertexAttribs& base,
+    const std::vector<VertexAttribs>& targets,
+    const int streamOffset,
+    const VertexFormat format) {
+    static_assert(sizeof(T) <= sizeof(OVR::Vector4f), "at most four components");
+    ovrMorphChannel& c = Channels[channel];
+    c.components = static_cast<int>(sizeof(T) / sizeof(float));
+    c.streamOffset = streamOffset;
+    c.format = format;
+    const std::vector<T>& baseValues = base.*attrib;
+    if (streamOffset < 0 || static_cast<int>(baseValues.size()) != VertexCount) {
+        return;
+    }
+
+    // quantize the deltas of each target, keeping the vertices it moves
+    std::vector<uint8_t> moved(VertexCount, 0);
+    for (int t = 0; t < TargetCount; t++) {
+        const std::vector<T>& values = targets[t].*attrib;
+        if (static_cast<int>(values.size()) != VertexCount) {
+            continue;
+        }
+        float maxDelta = 0.0f;
+        for (const T& value : values) {
+            for (int k = 0; k < c.components; k++) {
+                maxDelta = std::max(maxDelta, fabsf(value[k]));
+            }
+        }
+        if (!(maxDelta > 0.0f) || !std::isfinite(maxDelta)) {
+            continue;
+        }
+
+        ovrMorphDeltas& deltas = Deltas[t * CHANNEL_COUNT + channel];
+        deltas.scale = maxDelta / MAX_QUANTIZED_DELTA;
+        const float invScale = MAX_QUANTIZED_DELTA / maxDelta;
+        for (int v = 0; v < VertexCount; v++) {
+            int16_t q[4] = {0, 0, 0, 0};
+            bool nonzero = false;
+            for (int k = 0; k < c.components; k++) {
+                // NaN is dropped, rounding error past the largest step is clamped
+                const float f = std::isnan(values[v][k]) ? 0.0f : values[v][k] * invScale;
+                q[k] = static_cast<int16_t>(
+                    lrintf(std::max(-MAX_QUANTIZED_DELTA, std::min(MAX_QUANTIZED_DELTA, f))));
+                nonzero |= (q[k] != 0);
+            }
+            if (nonzero) {
+                deltas.slots.push_back(static_cast<uint32_t>(v)); // renumbered below
+                deltas.deltas.insert(deltas.deltas.end(), q, q + 4);
+                moved[v] = 1;
+            }
+        }
+    }
+
+    std::vector<uint32_t> slotOfVertex(VertexCount, 0);
+    for (int v = 0; v < VertexCount; v++) {
+        if (moved[v]) {
+            slotOfVertex[v] = static_cast<uint32_t>(c.vertices.size());
+            c.vertices.push_back(static_cast<TriangleIndex32>(v));
+            c.base.push_back(ToVector4(baseValues[v]));
+        }
+    }
+    c.result = c.base;
+    for (int t = 0; t < TargetCount; t++) {
+        for (uint32_t& slot : Deltas[t * CHANNEL_COUNT + channel].slots) {
+            slot = slotOfVertex[slot];
+        }
+    }
+}
+
+void MorphTargets::Build(const VertexAttribs& base, const std::vector<VertexAttribs>& targets) {
+    Clear();
+    if (targets.empty() || base.position.empty()) {
+        return;
+    }
+    TargetCount = static_cast<int>(targets.size());
+    VertexCount = static_cast<int>(base.position.size());
+    Deltas.resize(static_cast<size_t>(TargetCount) * CHANNEL_COUNT);
+    Weights.assign(TargetCount, 0.0f);
+
+    // the compact formats could clamp the morphed values
+    Layout = VertexLayout::Compact(base);
+    for (const VertexAttribs& target : targets) {
+        Layout.normal = target.normal.empty() ? Layout.normal : VertexFormat::Float32;
+        Layout.tangent = target.tangent.empty() ? Layout.tangent : VertexFormat::Float32;
+        Layout.color = target.color.empty() ? Layout.color : VertexFormat::Float32;
+        Layout.uv0 = target.uv0.empty() ? Layout.uv0 : VertexFormat::Float32;
+        Layout.uv1 = target.uv1.empty() ? Layout.uv1 : VertexFormat::Float32;
+    }
+    const VertexStreamLayout stream = PackVertexAttribs(base, Layout, Packed);
+    Stride = stream.stride;
+
+    BuildChannel(
+        0, &VertexAttribs::position, base, targets, stream.position, VertexFormat::Float32);
+    BuildChannel(1, &VertexAttribs::normal, base, targets, stream.normal, Layout.normal);
+    BuildChannel(2, &VertexAttribs::tangent, base, targets, stream.tangent, Layout.tangent);
+    BuildChannel(3, &VertexAttribs::color, base, targets, stream.color, Layout.color);
+    BuildChannel(4, &VertexAttribs::uv0, base, targets, stream.uv0, Layout.uv0);
+    BuildChannel(5, &VertexAttribs::uv1, base, targets, stream.uv1, Layout.uv1);
+
+    int firstDirty = VertexCount;
+    int lastDirty = -1;
+    for (const ovrMorphChannel& c : Channels) {
+        if (!c.vertices.empty()) {
+            firstDirty = std::min(firstDirty, static_cast<int>(c.vertices.front()));
+            lastDirty = std::max(lastDirty, static_cast<int>(c.vertices.back()));
+        }
+    }
+    FirstDirty = (lastDirty >= 0) ? firstDirty : 0;
+    DirtyCount = (lastDirty >= 0) ? lastDirty - firstDirty + 1 : 0;
+
+    // With weights in [0, 1] each component is smallest when all of its negative deltas are
+    // added and largest when all of its positive deltas are.
+    for (const OVR::Vector3f& position : base.position) {
+        Bounds.AddPoint(position);
+    }
+    const ovrMorphChannel& positions = Channels[0];
+    std::vector<OVR::Vector4f> lo = positions.base;
+    std::vector<OVR::Vector4f> hi = positions.base;
+    for (int t = 0; t < TargetCount; t++) {
+        const ovrMorphDeltas& deltas = Deltas[t * CHANNEL_COUNT];
+        for (size_t i = 0; i < deltas.slots.size(); i++) {
+            for (int k = 0; k < 3; k++) {
+                const float d = deltas.deltas[i * 4 + k] * deltas.scale;
+                (d < 0.0f ? lo : hi)[deltas.slots[i]][k] += d;
+            }
+        }
+    }
+    for (size_t i = 0; i < lo.size(); i++) {
+        Bounds.AddPoint(OVR::Vector3f(lo[i].x, lo[i].y, lo[i].z));
+        Bounds.AddPoint(OVR::Vector3f(hi[i].x, hi[i].y, hi[i].z));
+    }
+}
+
+void MorphTargets::Clear() {
+    TargetCount = 0;
+    VertexCount = 0;
+    Stride = 0;
+    for (ovrMorphChannel& c : Channels) {
+        c = ovrMorphChannel();
+    }
+    Deltas.clear();
+    Weights.clear();
+    Packed.clear();
+    FirstDirty = 0;
+    DirtyCount = 0;
+    Layout = VertexLayout();
+    Bounds = OVR::Bounds3f(OVR::Bounds3f::Init);
+}
+
+bool MorphTargets::Evaluate(const std::vector<float>& weights) {
+    bool changed = false;
+    for (int t = 0; t < TargetCount; t++) {
+        const float w = (t < static_cast<int>(weights.size())) ? weights[t] : 0.0f;
+        changed |= (w != Weights[t]);
+        Weights[t] = w;
+    }
+    if (!changed) {
+        return false;
+    }
+
+    for (int channel = 0; channel < CHANNEL_COUNT; channel++) {
+        ovrMorphChannel& c = Channels[channel];
+        if (c.vertices.empty()) {
+            continue;
+        }
+        std::copy(c.base.begin(), c.base.end(), c.result.begin());
+        for (int t = 0; t < TargetCount; t++) {
+            const ovrMorphDeltas& deltas = Deltas[t * CHANNEL_COUNT + channel];
+            if (Weights[t] == 0.0f || deltas.slots.empty()) {
+                continue;
+            }
+            AccumulateDeltas(
+                c.result.data(),
+                deltas.slots.data(),
+                deltas.deltas.data(),
+                deltas.slots.size(),
+                Weights[t] * deltas.scale);
+        }
+
+        for (size_t i = 0; i < c.vertices.size(); i++) {
+            uint8_t* dst = &Packed[static_cast<size_t>(c.vertices[i]) * Stride + c.streamOffset];
+            if (c.format == VertexFormat::Float32) {
+                memcpy(dst, &c.result[i].x, c.components * sizeof(float));
+            } else {
+                PackVertexComponents(dst, &c.result[i].x, c.components, c.format);
+            }
+        }
+    }
+    return true;
+}
+
+void MorphTargets::Upload(GlGeometry& geo) const {
+    if (DirtyCount == 0) {
+        return;
+    }
+    if (geo.vertexCount != VertexCount) {
+        ALOGW("MorphTargets: geometry has %d vertices, expected %d", geo.vertexCount, VertexCount);
+        return;
+    }
+    const size_t offset = static_cast<size_t>(FirstDirty) * Stride;
+    geo.UpdateVertexRange(&Packed[offset], offset, static_cast<size_t>(DirtyCount) * Stride);
+    geo.localBounds = Bounds;
+}
+
+} // namespace OVRFW
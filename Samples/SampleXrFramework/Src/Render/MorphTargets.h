@@ -0,0 +1,130 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * Licensed under the Oculus SDK License Agreement (the "License");
+ * you may not use the Oculus SDK except in compliance with the License,
+ * which is provided at the time of installation or download, or which
+ * otherwise accompanies this software in either electronic or hard copy form.
+ *
+ * You may obtain a copy of the License at
+ * https://developer.oculus.com/licenses/oculussdk/
+ *
+ * Unless required by applicable law or agreed to in writing, the Oculus SDK
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/************************************************************************************
+
+Filename    :   MorphTargets.h
+Content     :   Morph target (blend shape) evaluation with sparse quantized deltas.
+Language    :   C++
+
+*************************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "OVR_Math.h"
+#include "GlGeometry.h"
+
+namespace OVRFW {
+
+// Morph targets of one mesh. The dense per vertex deltas of each target are stored as 16-bit
+// deltas of only the vertices the target moves, with one scale per target and attribute.
+// Evaluating adds up only the targets with a nonzero weight, and only for the vertices some
+// target moves, into a packed copy of the vertex buffer that is kept between evaluations, so
+// the vertex buffer can be updated without repacking the vertices that never move.
+//
+// Position, normal, tangent, color and texture coordinate targets are supported, which covers
+// what glTF allows.
+class MorphTargets {
+   public:
+    MorphTargets()
+        : TargetCount(0),
+          VertexCount(0),
+          Stride(0),
+          FirstDirty(0),
+          DirtyCount(0),
+          Bounds(OVR::Bounds3f::Init) {}
+
+    // Builds the sparse deltas from targets, each of which holds a delta per vertex of base
+    // for some of the attributes of base, like glTF morph targets. Does not touch GL, so it
+    // can run on loader threads.
+    void Build(const VertexAttribs& base, const std::vector<VertexAttribs>& targets);
+    void Clear();
+
+    bool IsEmpty() const {
+        return TargetCount == 0;
+    }
+    int GetTargetCount() const {
+        return TargetCount;
+    }
+
+    // Layout the geometry must be created with for Upload: the compact layout of the base
+    // attributes, with the morphed attributes kept at full precision.
+    const VertexLayout& GetVertexLayout() const {
+        return Layout;
+    }
+    // Bounds of the positions for any weights in [0, 1].
+    const OVR::Bounds3f& GetBounds() const {
+        return Bounds;
+    }
+
+    // Morphs the vertices to base + sum of weights[i] * target i. Returns false if the
+    // weights are the same as in the last call, so there is nothing to upload.
+    bool Evaluate(const std::vector<float>& weights);
+
+    // Copies the morphed vertices to geo, which must have been created from the base attributes
+    // with GetVertexLayout(), and sets its bounds to GetBounds(). Must be called on the thread
+    // that owns the GL context.
+    void Upload(GlGeometry& geo) const;
+
+   private:
+    static const int CHANNEL_COUNT = 6; // position, normal, tangent, color, uv0, uv1
+
+    // One morphed attribute, e.g. the positions.
+    struct ovrMorphChannel {
+        int components = 0;
+        int streamOffset = -1; // in the packed vertex
+        VertexFormat format = VertexFormat::Float32;
+        std::vector<TriangleIndex32> vertices; // moved by any target, ascending
+        std::vector<OVR::Vector4f> base; // unmorphed value of each of those vertices
+        std::vector<OVR::Vector4f> result; // morphed value of each of those vertices
+    };
+
+    // Deltas of one target for one channel.
+    struct ovrMorphDeltas {
+        float scale = 0.0f; // of one quantization step
+        std::vector<uint32_t> slots; // index in the channel's vertices
+        std::vector<int16_t> deltas; // four components per slot, unused ones are zero
+    };
+
+    template <typename T>
+    void BuildChannel(
+        const int channel,
+        std::vector<T> VertexAttribs::*attrib,
+        const VertexAttribs& base,
+        const std::vector<VertexAttribs>& targets,
+        const int streamOffset,
+        const VertexFormat format);
+
+    int TargetCount;
+    int VertexCount;
+    int Stride;
+    ovrMorphChannel Channels[CHANNEL_COUNT];
+    std::vector<ovrMorphDeltas> Deltas; // CHANNEL_COUNT per target
+    std::vector<float> Weights; // of the last evaluation
+    std::vector<uint8_t> Packed; // all vertices in Layout, morphed by the last evaluation
+    // range of vertices some target moves
+    int FirstDirty;
+    int DirtyCount;
+    VertexLayout Layout;
+    OVR::Bounds3f Bounds;
+};
+
+} // namespace OVRFW
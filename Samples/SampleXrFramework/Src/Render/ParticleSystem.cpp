@@ -28,10 +28,17 @@ Authors     :   Jonathan E. Wright
 #include "ParticleSystem.h"
 
 #include "TextureAtlas.h"
+#include "Render/Egl.h"
 #include "Render/GlGeometry.h"
+#include "Render/GlStreamBuffer.h"
+#include "Render/RadixSort.h"
+#include "OVR_PerfTimer.h"
 
+#include <algorithm>
 #include <cassert>
+#include <cstring>
 
+using OVR::Bounds3f;
 using OVR::Matrix4f;
 using OVR::Posef;
 using OVR::Quatf;
@@ -39,23 +46,44 @@ using OVR::Vector2f;
 using OVR::Vector3f;
 using OVR::Vector4f;
 
-inline Vector3f GetViewMatrixForward(Matrix4f const& m) {
-    return Vector3f(-m.M[2][0], -m.M[2][1], -m.M[2][2]).Normalized();
-}
-
 namespace OVRFW {
 
+// Each instance is a particle. The quad is oriented to face the view position, rolled by the
+// particle orientation and scaled in the vertex shader, so the CPU only writes one instance per
+// particle.
 static const char* particleVertexSrc = R"glsl(
 attribute vec4 Position;
 attribute vec2 TexCoord;
-attribute vec4 VertexColor;
+attribute vec4 Instance0;
+attribute vec4 Instance1;
+attribute vec4 Instance2;
+attribute vec4 Instance3;
+uniform highp mat4 ParticleViewMatrix;
 varying highp vec2 oTexCoord;
 varying lowp vec4 oColor;
 void main()
 {
-    gl_Position = TransformVertex( Position );
-    oTexCoord = TexCoord;
-    oColor = VertexColor;
+    // This always aligns the particle to the direction of the particle to the view
+    // position. This looks a little better than aligning with the view plane.
+    highp vec3 normal = ParticleViewMatrix[3].xyz - Instance0.xyz;
+    highp float normalLenSq = dot( normal, normal );
+    normal = normalLenSq > 0.0 ? normal * inversesqrt( normalLenSq ) : -ParticleViewMatrix[2].xyz;
+    highp vec3 xBasis = cross( vec3( 0.0, 1.0, 0.0 ), normal );
+    highp float xLenSq = dot( xBasis, xBasis );
+    // a normal parallel to up leaves the quad in the XY plane
+    bool parallel = xLenSq < 0.0002;
+    xBasis = parallel ? vec3( 1.0, 0.0, 0.0 ) : xBasis * inversesqrt( xLenSq );
+    highp vec3 yBasis = parallel ? vec3( 0.0, 1.0, 0.0 ) : cross( normal, xBasis );
+
+    highp float s = sin( Instance3.x );
+    highp float c = cos( Instance3.x );
+    highp vec2 corner = Position.xy * Instance0.w;
+    highp vec2 rotated = vec2( corner.x * c - corner.y * s, corner.x * s + corner.y * c );
+    highp vec3 worldPos = Instance0.xyz + xBasis * rotated.x + yBasis * rotated.y;
+
+    gl_Position = TransformVertex( vec4( worldPos, 1.0 ) );
+    oTexCoord = mix( Instance1.xy, Instance1.zw, TexCoord );
+    oColor = Instance2;
 }
 )glsl";
 
@@ -90,7 +118,38 @@ static Vector3f quadVertPos[4] = {
 
 static Vector2f quadUVs[4] = {{0.0f, 0.0f}, {1.0f, 0.0f}, {1.0f, 1.0f}, {0.0f, 1.0f}};
 
-ovrParticleSystem::ovrParticleSystem() : maxParticles_(0) {}
+struct instanceAttrib_t {
+    int Location;
+    int Size;
+    unsigned Type;
+    unsigned char Normalized;
+    size_t Offset;
+};
+static const instanceAttrib_t instanceAttribs[] = {
+    {VERTEX_ATTRIBUTE_LOCATION_INSTANCE_0,
+     4,
+     GL_FLOAT,
+     GL_FALSE,
+     offsetof(particleInstance_t, PositionScale)},
+    {VERTEX_ATTRIBUTE_LOCATION_INSTANCE_1,
+     4,
+     GL_FLOAT,
+     GL_FALSE,
+     offsetof(particleInstance_t, UvRect)},
+    {VERTEX_ATTRIBUTE_LOCATION_INSTANCE_2,
+     4,
+     GL_HALF_FLOAT,
+     GL_FALSE,
+     offsetof(particleInstance_t, Color)},
+    {VERTEX_ATTRIBUTE_LOCATION_INSTANCE_3,
+     1,
+     GL_FLOAT,
+     GL_FALSE,
+     offsetof(particleInstance_t, Orientation)},
+};
+
+ovrParticleSystem::ovrParticleSystem()
+    : maxParticles_(0), numSlots_(0), activeCount_(0), StreamedFrame(-1), SortParticles(false) {}
 
 ovrParticleSystem::~ovrParticleSystem() {
     Shutdown();
@@ -107,16 +166,18 @@ void ovrParticleSystem::Init(
     maxParticles_ = maxParticles;
 
     // free any existing particles
-    particles_.reserve(maxParticles);
+    numSlots_ = 0;
+    activeCount_ = 0;
+    freeParticles_.clear();
     freeParticles_.reserve(maxParticles);
-    activeParticles_.reserve(maxParticles);
 
     // create the geometry
-    CreateGeometry(maxParticles);
+    CreateGeometry();
 
     {
         OVRFW::ovrProgramParm uniformParms[] = {
             /// Vertex
+            {.Name = "ParticleViewMatrix", .Type = OVRFW::ovrProgramParmType::FLOAT_MATRIX4},
             /// Fragment
             {.Name = "Texture0", .Type = OVRFW::ovrProgramParmType::TEXTURE_SAMPLED},
         };
@@ -134,17 +195,36 @@ void ovrParticleSystem::Init(
 
     SurfaceDef.graphicsCommand.Program = Program;
     SurfaceDef.graphicsCommand.BindUniformTextures();
+    SurfaceDef.graphicsCommand.UniformData[0].Data = &ParticleViewMatrix;
 
     SurfaceDef.graphicsCommand.GpuState = gpuState;
 
     SortParticles = sortParticles;
 
-    derived_.reserve(maxParticles);
-    sortIndices_.reserve(maxParticles);
-    attr_.position.reserve(maxParticles * 4);
-    attr_.color.reserve(maxParticles * 4);
-    attr_.uv0.reserve(maxParticles * 4);
-    packedAttr_.reserve(maxParticles * 12 * 16 * 8);
+    const size_t n = maxParticles;
+    for (auto* v : {&invLifeTime_, &posX_,          &posY_,         &posZ_,       &velX_,
+                    &velY_,        &velZ_,          &halfAccX_,     &halfAccY_,   &halfAccZ_,
+                    &lifeTime_,    &initialOrientation_, &rotationRate_, &easeCurve_, &easeColor_,
+                    &scale_,       &age_,           &curX_,         &curY_,       &curZ_,
+                    &curOrientation_, &alphaScale_, &colorScale_,   &distanceSq_}) {
+        v->clear();
+        v->reserve(n);
+    }
+    active_.clear();
+    active_.reserve(n);
+    startTime_.clear();
+    startTime_.reserve(n);
+    initialColor_.clear();
+    initialColor_.reserve(n);
+    spriteIndex_.clear();
+    spriteIndex_.reserve(n);
+    activeSlots_.reserve(n);
+    sortIndices_.reserve(n);
+    sortTemp_.reserve(n);
+    unsortedInstances_.clear();
+    if (sortParticles) {
+        unsortedInstances_.reserve(n);
+    }
 }
 
 ovrGpuState ovrParticleSystem::GetDefaultGpuState() {
@@ -158,131 +238,227 @@ ovrGpuState ovrParticleSystem::GetDefaultGpuState() {
     return s;
 }
 
-int ParticleSortFn(void const* a, void const* b) {
-    if (static_cast<const particleSort_t*>(b)->DistanceSq <
-        static_cast<const particleSort_t*>(a)->DistanceSq) {
-        return -1;
+// Derives the current state of every particle slot from its age. Free slots are integrated too,
+// so the loop has no branches and the compiler can vectorize it.
+void ovrParticleSystem::IntegrateParticles(const double displayTime, const Vector3f& viewPos) {
+    const int n = numSlots_;
+    const double* startTime = startTime_.data();
+    const float* invLifeTime = invLifeTime_.data();
+    const float* posX = posX_.data();
+    const float* posY = posY_.data();
+    const float* posZ = posZ_.data();
+    const float* velX = velX_.data();
+    const float* velY = velY_.data();
+    const float* velZ = velZ_.data();
+    const float* halfAccX = halfAccX_.data();
+    const float* halfAccY = halfAccY_.data();
+    const float* halfAccZ = halfAccZ_.data();
+    const float* initialOrientation = initialOrientation_.data();
+    const float* rotationRate = rotationRate_.data();
+    const float* easeCurve = easeCurve_.data();
+    const float* easeColor = easeColor_.data();
+    float* age = age_.data();
+    float* curX = curX_.data();
+    float* curY = curY_.data();
+    float* curZ = curZ_.data();
+    float* curOrientation = curOrientation_.data();
+    float* alphaScale = alphaScale_.data();
+    float* colorScale = colorScale_.data();
+    float* distanceSq = distanceSq_.data();
+
+    for (int i = 0; i < n; ++i) {
+        const float t = static_cast<float>(displayTime - startTime[i]);
+        const float tSq = t * t;
+
+        // x = x0 + v0 * t + 0.5f * a * t^2
+        const float x = posX[i] + velX[i] * t + halfAccX[i] * tSq;
+        const float y = posY[i] + velY[i] * t + halfAccY[i] * tSq;
+        const float z = posZ[i] + velZ[i] * t + halfAccZ[i] * tSq;
+
+        // The in / out ease functions are 2 * t^n up to the middle of the life time and
+        // 1 - 2 * ( t - 0.5 )^n after it, see EaseFunctions.h.
+        const float u = t * invLifeTime[i];
+        const float e = (u <= 0.5f) ? u : u - 0.5f;
+        const float e2 = e * e;
+        const float curve = easeCurve[i];
+        const float power = (curve < 1.5f) ? e : ((curve < 2.5f) ? e2 : e2 * e);
+        const float eased = (u <= 0.5f) ? 2.0f * power : 1.0f - 2.0f * power;
+        const float s = (curve < 0.5f) ? 1.0f : eased;
+
+        const float dx = x - viewPos.x;
+        const float dy = y - viewPos.y;
+        const float dz = z - viewPos.z;
+
+        age[i] = t;
+        curX[i] = x;
+        curY[i] = y;
+        curZ[i] = z;
+        curOrientation[i] = rotationRate[i] * t + initialOrientation[i];
+        alphaScale[i] = s;
+        colorScale[i] = 1.0f + easeColor[i] * (s - 1.0f);
+        distanceSq[i] = dx * dx + dy * dy + dz * dz;
     }
-    return 1;
 }
 
-void ovrParticleSystem::Frame(
-    const OVRFW::ovrApplFrameIn& frame,
-    const ovrTextureAtlas* atlas,
-    const Matrix4f& centerEyeViewMatrix) {
-    // OVR_PERF_TIMER( ovrParticleSystem_Frame );
+// The squared distance keeps its exponent and 13 bits of mantissa, which orders particles down
+// to a relative distance of 2^-14 and sorts in two radix passes instead of three.
+static const int DEPTH_KEY_BITS = 22;
 
-    if (activeParticles_.empty()) {
-        return;
+// Frees expired particles and lists the active ones, with their depth keys when sorting.
+void ovrParticleSystem::CollectParticles() {
+    activeSlots_.resize(activeCount_);
+    int count = 0;
+    for (int i = 0; i < numSlots_; ++i) {
+        if (!active_[i]) {
+            continue;
+        }
+        if (age_[i] > lifeTime_[i]) {
+            // free expired particle
+            active_[i] = 0;
+            freeParticles_.push_back(handle_t(i));
+            continue;
+        }
+        activeSlots_[count++] = i;
+    }
+    activeCount_ = count;
+    activeSlots_.resize(count);
+
+    if (SortParticles) {
+        sortIndices_.resize(count);
+        for (int i = 0; i < count; ++i) {
+            particleSort_t& ps = sortIndices_[i];
+            ps.ActiveIndex = i;
+            ps.DepthKey = ~RadixSortKey(distanceSq_[activeSlots_[i]]) >> (32 - DEPTH_KEY_BITS);
+        }
     }
+}
 
-    // update particles
-    Matrix4f invViewMatrix = centerEyeViewMatrix.Inverted();
-    Vector3f viewPos = invViewMatrix.GetTranslation();
+// Sorts the particles from far to near.
+void ovrParticleSystem::SortParticlesByDistance() {
+    RadixSort(sortIndices_, sortTemp_, DEPTH_KEY_BITS, [](const particleSort_t& ps) {
+        return ps.DepthKey;
+    });
+}
 
-    int activeCount = 0;
+// Half float of a color channel, without the branches of EncodeFloat16. Negative channels and
+// channels below 2^-14, which can't be seen, become 0.
+static inline uint16_t ColorToFloat16(const float f) {
+    const float clamped = std::min(std::max(f, 0.0f), 65504.0f);
+    uint32_t x;
+    memcpy(&x, &clamped, sizeof(x));
+    // rebias the exponent from 127 to 15 and round the mantissa to nearest even
+    const uint32_t h = (x - 0x38000000u + 0x0FFFu + ((x >> 13) & 1u)) >> 13;
+    return static_cast<uint16_t>(x < 0x38800000u ? 0u : h);
+}
 
-    // update existing particles and its vertices, deriving the current state of each particle based
-    // on it's current age store the derived state of each particle in the derived array. Also, make
-    // another array that is just the index of each particle and its distance to the view position.
-    // This array will be sorted by distance and then used to index into the derived array the
-    // vertices are transformed.
+// Writes one instance per active particle in slot order. dst may be mapped GPU memory, so each
+// instance is assembled locally and stored once.
+void ovrParticleSystem::BuildInstances(const ovrTextureAtlas* atlas, particleInstance_t* dst) {
+    const int count = static_cast<int>(activeSlots_.size());
 
-    std::vector<particleDerived_t>& derived = derived_;
-    std::vector<particleSort_t>& sortIndices = sortIndices_;
-    derived.resize(activeParticles_.size());
-    sortIndices.resize(activeParticles_.size());
+    Bounds3f bounds(Bounds3f::Init);
+    for (int i = 0; i < count; ++i) {
+        const int index = activeSlots_[i];
+        particleInstance_t inst;
 
-    for (size_t i = 0; i < activeParticles_.size(); ++i) {
-        const handle_t handle = activeParticles_[i];
-        ovrParticle& p = particles_[handle.Get()];
+        const float scale = scale_[index];
+        inst.PositionScale = Vector4f(curX_[index], curY_[index], curZ_[index], scale);
+        inst.Orientation = curOrientation_[index];
 
-        if (frame.PredictedDisplayTime - p.StartTime > p.LifeTime) {
-            // free expired particle
-            p.StartTime = -1.0; // mark as unused
-            freeParticles_.push_back(handle);
-            // Swap this slot with the last item, order doesn't matter
-            activeParticles_.at(i) = activeParticles_.back();
-            activeParticles_.pop_back();
-            i--; // last particle was moved into current slot, so don't skip it
-            continue;
-        }
+        const Vector4f& c = initialColor_[index];
+        const float cs = colorScale_[index];
+        const float as = alphaScale_[index];
+        inst.Color[0] = ColorToFloat16(c.x * cs);
+        inst.Color[1] = ColorToFloat16(c.y * cs);
+        inst.Color[2] = ColorToFloat16(c.z * cs);
+        inst.Color[3] = ColorToFloat16(c.w * as);
 
-        float t = static_cast<float>(frame.PredictedDisplayTime - p.StartTime);
-        float tSq = t * t;
+        if (atlas != nullptr) {
+            // set UVs of this sprite in the atlas
+            const ovrTextureAtlas::ovrSpriteDef& sd = atlas->GetSpriteDef(spriteIndex_[index]);
+            inst.UvRect = Vector4f(sd.uvMins.x, sd.uvMins.y, sd.uvMaxs.x, sd.uvMaxs.y);
+        } else {
+            inst.UvRect = Vector4f(-1.0f, -1.0f, 1.0f, 1.0f);
+        }
 
-        particleDerived_t& d = derived[activeCount];
-        // x = x0 + v0 * t + 0.5f * a * t^2
-        d.Pos = p.InitialPosition + p.InitialVelocity * t + p.HalfAcceleration * tSq;
-        d.Orientation = (p.RotationRate * t) + p.InitialOrientation;
+        // the rotated quad stays inside a sphere of half its diagonal
+        const Vector3f pos(inst.PositionScale.x, inst.PositionScale.y, inst.PositionScale.z);
+        const Vector3f extent(scale * 0.7072f);
+        bounds.AddPoint(pos - extent);
+        bounds.AddPoint(pos + extent);
 
-        d.Color = EaseFunctions[p.EaseFunc](p.InitialColor, t / p.LifeTime);
+        dst[i] = inst;
+    }
+    SurfaceDef.geo.localBounds = bounds;
+}
 
-        d.Scale = p.InitialScale;
-        d.SpriteIndex = p.SpriteIndex;
+// Writes the instances built in slot order to dst in draw order.
+void ovrParticleSystem::CopySortedInstances(particleInstance_t* dst) const {
+    const int count = static_cast<int>(sortIndices_.size());
+    const particleInstance_t* src = unsortedInstances_.data();
+    for (int i = 0; i < count; ++i) {
+        dst[i] = src[sortIndices_[i].ActiveIndex];
+    }
+}
 
-        particleSort_t& ps = sortIndices[activeCount];
-        ps.ActiveIndex = activeCount;
-        ps.DistanceSq =
-            (d.Pos - viewPos).LengthSq(); // Dot( centerEyeViewMatrix.GetZBasis() );//.LengthSq();
+void ovrParticleSystem::Frame(
+    const OVRFW::ovrApplFrameIn& frame,
+    const ovrTextureAtlas* atlas,
+    const Matrix4f& centerEyeViewMatrix) {
+    OVR_PERF_TIMER(ovrParticleSystem_Frame);
 
-        activeCount++;
+    if (activeCount_ == 0) {
+        return;
     }
 
-    assert(activeParticles_.size() == (size_t)activeCount);
-
-    if (activeCount > 0) {
-        // sort by distance to view pos
-        if (SortParticles) {
-            qsort(&sortIndices[0], activeCount, sizeof(sortIndices[0]), ParticleSortFn);
-        }
+    // update particles
+    ParticleViewMatrix = centerEyeViewMatrix.Inverted();
+    const Vector3f viewPos = ParticleViewMatrix.GetTranslation();
 
-        attr_.position.resize(activeCount * 4);
-        attr_.color.resize(activeCount * 4);
-        attr_.uv0.resize(activeCount * 4);
-
-        // transform vertices for each particle quad
-        for (int i = 0; i < activeCount; ++i) {
-            particleSort_t const& si = sortIndices[i];
-            particleDerived_t const& p = derived[si.ActiveIndex];
-
-            // transform vertices on the CPU
-            Matrix4f rotMatrix = Matrix4f::RotationZ(p.Orientation);
-            // This always aligns the particle to the direction of the particle to the view
-            // position. This looks a little better but is more expensive and only really makes a
-            // difference for large particles.
-            Vector3f normal = (viewPos - p.Pos).Normalized();
-            if (normal.LengthSq() < 0.999f) {
-                normal = GetViewMatrixForward(centerEyeViewMatrix);
-            }
-            Matrix4f particleTransform =
-                Matrix4f::CreateFromBasisVectors(normal, Vector3f(0.0f, 1.0f, 0.0f));
-            particleTransform.SetTranslation(p.Pos);
-
-            for (int v = 0; v < 4; ++v) {
-                attr_.position[i * 4 + v] =
-                    particleTransform.Transform(rotMatrix.Transform(quadVertPos[v] * p.Scale));
-                attr_.color[i * 4 + v] = p.Color;
-            }
-
-            if (atlas != nullptr) {
-                // set UVs of this sprite in the atlas
-                const ovrTextureAtlas::ovrSpriteDef& sd = atlas->GetSpriteDef(p.SpriteIndex);
-                attr_.uv0[i * 4 + 0] = Vector2f(sd.uvMins.x, sd.uvMins.y);
-                attr_.uv0[i * 4 + 1] = Vector2f(sd.uvMaxs.x, sd.uvMins.y);
-                attr_.uv0[i * 4 + 2] = Vector2f(sd.uvMaxs.x, sd.uvMaxs.y);
-                attr_.uv0[i * 4 + 3] = Vector2f(sd.uvMins.x, sd.uvMaxs.y);
-            } else {
-                attr_.uv0[i * 4 + 0] = Vector2f(-1, -1);
-                attr_.uv0[i * 4 + 1] = Vector2f(1, -1);
-                attr_.uv0[i * 4 + 2] = Vector2f(1, 1);
-                attr_.uv0[i * 4 + 3] = Vector2f(-1, 1);
-            }
-        }
+    IntegrateParticles(frame.PredictedDisplayTime, viewPos);
+    CollectParticles();
+    if (activeCount_ == 0) {
+        return;
+    }
+    // sort by distance to view pos
+    if (SortParticles) {
+        SortParticlesByDistance();
+        unsortedInstances_.resize(activeCount_);
+        BuildInstances(atlas, unsortedInstances_.data());
     }
 
-    // update the geometry with new vertex attributes
-    SurfaceDef.geo.Update(attr_);
+    // write the instances straight into the vertex stream
+    GlStreamBuffer& stream = GetVertexStreamBuffer();
+    const GlStreamBuffer::Allocation alloc =
+        stream.Map(activeSlots_.size() * sizeof(particleInstance_t));
+    if (alloc.data == nullptr) {
+        SurfaceDef.numInstances = 0;
+        return;
+    }
+    particleInstance_t* const instances = static_cast<particleInstance_t*>(alloc.data);
+    if (SortParticles) {
+        CopySortedInstances(instances);
+    } else {
+        BuildInstances(atlas, instances);
+    }
+    stream.Unmap();
+
+    // point the instance attributes at this frame's instances
+    GL(glBindVertexArray(SurfaceDef.geo.vertexArrayObject));
+    GL(glBindBuffer(GL_ARRAY_BUFFER, alloc.buffer));
+    for (const auto& a : instanceAttribs) {
+        GL(glVertexAttribPointer(
+            a.Location,
+            a.Size,
+            a.Type,
+            a.Normalized,
+            sizeof(particleInstance_t),
+            reinterpret_cast<void*>(alloc.offset + a.Offset)));
+    }
+    GL(glBindVertexArray(0));
+    GL(glBindBuffer(GL_ARRAY_BUFFER, 0));
+    SurfaceDef.numInstances = static_cast<int>(activeSlots_.size());
+    StreamedFrame = stream.GetFrameIndex();
 }
 
 void ovrParticleSystem::Shutdown() {
@@ -297,8 +473,9 @@ void ovrParticleSystem::RenderEyeView(
     // OVR_UNUSED( viewMatrix );
     // OVR_UNUSED( projectionMatrix );
 
-    // Don't even add a surface if not needed
-    if (activeParticles_.empty()) {
+    // Don't even add a surface if not needed; the instances are only valid in the frame they
+    // were streamed
+    if (activeCount_ == 0 || StreamedFrame != GetVertexStreamBuffer().GetFrameIndex()) {
         return;
     }
 
@@ -309,6 +486,45 @@ void ovrParticleSystem::RenderEyeView(
     surfaceList.push_back(surf);
 }
 
+void ovrParticleSystem::SetParticle(
+    const int index,
+    const double startTime,
+    const Vector3f& position,
+    const float orientation,
+    const Vector3f& velocity,
+    const Vector3f& acceleration,
+    const Vector4f& color,
+    const ovrEaseFunc easeFunc,
+    const float rotationRate,
+    const float scale,
+    const float lifeTime,
+    const uint16_t spriteIndex) {
+    // ease curve and whether it applies to the color, indexed by ovrEaseFunc
+    static const float easeCurves[ovrEaseFunc::MAX] = {0.0f, 1.0f, 3.0f, 2.0f, 1.0f, 3.0f, 2.0f};
+    static const float easeColors[ovrEaseFunc::MAX] = {0.0f, 1.0f, 1.0f, 1.0f, 0.0f, 0.0f, 0.0f};
+
+    active_[index] = 1;
+    startTime_[index] = startTime;
+    lifeTime_[index] = lifeTime;
+    invLifeTime_[index] = (lifeTime > 0.0f) ? 1.0f / lifeTime : 0.0f;
+    posX_[index] = position.x;
+    posY_[index] = position.y;
+    posZ_[index] = position.z;
+    velX_[index] = velocity.x;
+    velY_[index] = velocity.y;
+    velZ_[index] = velocity.z;
+    halfAccX_[index] = acceleration.x * 0.5f;
+    halfAccY_[index] = acceleration.y * 0.5f;
+    halfAccZ_[index] = acceleration.z * 0.5f;
+    initialOrientation_[index] = orientation;
+    rotationRate_[index] = rotationRate;
+    easeCurve_[index] = easeCurves[easeFunc < ovrEaseFunc::MAX ? easeFunc : 0];
+    easeColor_[index] = easeColors[easeFunc < ovrEaseFunc::MAX ? easeFunc : 0];
+    initialColor_[index] = color;
+    scale_[index] = scale;
+    spriteIndex_[index] = spriteIndex;
+}
+
 ovrParticleSystem::handle_t ovrParticleSystem::AddParticle(
     const OVRFW::ovrApplFrameIn& frame,
     const Vector3f& initialPosition,
@@ -321,37 +537,46 @@ ovrParticleSystem::handle_t ovrParticleSystem::AddParticle(
     const float scale,
     const float lifeTime,
     const uint16_t spriteIndex) {
-    ovrParticle* p;
-
     handle_t particleHandle;
     if (!freeParticles_.empty()) {
         particleHandle = handle_t(freeParticles_[freeParticles_.size() - 1]);
         freeParticles_.pop_back();
-        activeParticles_.push_back(particleHandle);
         assert(particleHandle.IsValid());
-        assert((size_t)particleHandle.Get() < particles_.size());
-        p = &particles_[particleHandle.Get()];
+        assert(particleHandle.Get() < numSlots_);
     } else {
-        if (particles_.size() >= maxParticles_) {
-            return handle_t(); // adding more would overflow the VAO
+        if (static_cast<size_t>(numSlots_) >= maxParticles_) {
+            return handle_t(); // no free slots left
+        }
+        particleHandle = handle_t(numSlots_);
+        numSlots_++;
+        for (auto* v : {&invLifeTime_, &posX_,          &posY_,         &posZ_,       &velX_,
+                        &velY_,        &velZ_,          &halfAccX_,     &halfAccY_,   &halfAccZ_,
+                        &lifeTime_,    &initialOrientation_, &rotationRate_, &easeCurve_,
+                        &easeColor_,   &scale_,         &age_,          &curX_,       &curY_,
+                        &curZ_,        &curOrientation_, &alphaScale_,  &colorScale_,
+                        &distanceSq_}) {
+            v->resize(numSlots_);
         }
-        particleHandle = handle_t(particles_.size());
-        particles_.emplace_back();
-        activeParticles_.push_back(particleHandle);
-        p = &particles_[particles_.size() - 1];
+        active_.resize(numSlots_);
+        startTime_.resize(numSlots_);
+        initialColor_.resize(numSlots_);
+        spriteIndex_.resize(numSlots_);
     }
-
-    p->StartTime = frame.PredictedDisplayTime;
-    p->LifeTime = lifeTime;
-    p->InitialPosition = initialPosition;
-    p->InitialOrientation = initialOrientation;
-    p->InitialVelocity = initialVelocity;
-    p->HalfAcceleration = acceleration * 0.5f;
-    p->InitialColor = initialColor;
-    p->EaseFunc = easeFunc;
-    p->RotationRate = rotationRate;
-    p->InitialScale = scale;
-    p->SpriteIndex = spriteIndex;
+    activeCount_++;
+
+    SetParticle(
+        particleHandle.Get(),
+        frame.PredictedDisplayTime,
+        initialPosition,
+        initialOrientation,
+        initialVelocity,
+        acceleration,
+        initialColor,
+        easeFunc,
+        rotationRate,
+        scale,
+        lifeTime,
+        spriteIndex);
 
     return particleHandle;
 }
@@ -369,65 +594,53 @@ void ovrParticleSystem::UpdateParticle(
     const float scale,
     const float lifeTime,
     const uint16_t spriteIndex) {
-    if (!handle.IsValid() || (size_t)handle.Get() >= particles_.size()) {
-        assert(handle.IsValid() && (size_t)handle.Get() < particles_.size());
+    if (!handle.IsValid() || handle.Get() >= numSlots_ || !active_[handle.Get()]) {
+        assert(handle.IsValid() && handle.Get() < numSlots_);
         return;
     }
-    ovrParticle& p = particles_[handle.Get()];
-    p.InitialPosition = position;
-    p.InitialOrientation = orientation;
-    p.InitialVelocity = velocity;
-    p.HalfAcceleration = acceleration * 0.5f;
-    p.InitialColor = color;
-    p.EaseFunc = easeFunc;
-    p.RotationRate = rotationRate;
-    p.InitialScale = scale;
-    p.SpriteIndex = spriteIndex;
-    p.StartTime = frame.PredictedDisplayTime;
-    p.LifeTime = lifeTime;
+    SetParticle(
+        handle.Get(),
+        frame.PredictedDisplayTime,
+        position,
+        orientation,
+        velocity,
+        acceleration,
+        color,
+        easeFunc,
+        rotationRate,
+        scale,
+        lifeTime,
+        spriteIndex);
 }
 
 void ovrParticleSystem::RemoveParticle(const handle_t handle) {
-    if (!handle.IsValid() || (size_t)handle.Get() >= particles_.size()) {
+    if (!handle.IsValid() || handle.Get() >= numSlots_) {
         return;
     }
     // particle will get removed in the next update
-    particles_[handle.Get()].StartTime = -1.0; // mark as unused
-    particles_[handle.Get()].LifeTime = 0.0;
+    lifeTime_[handle.Get()] = -1.0f;
 }
 
-void ovrParticleSystem::CreateGeometry(const int maxParticles) {
+void ovrParticleSystem::CreateGeometry() {
     SurfaceDef.geo.Free();
 
+    // a single quad, instanced once per particle
     VertexAttribs attr;
-    const int numVerts = maxParticles * 4;
-
-    attr.position.resize(numVerts);
-    attr.normal.resize(numVerts);
-    attr.color.resize(numVerts);
-    attr.uv0.resize(numVerts);
-
-    std::vector<TriangleIndex> indices;
-    const int numIndices = maxParticles * 6;
-    indices.resize(numIndices);
-
-    for (int i = 0; i < maxParticles; ++i) {
-        for (int v = 0; v < 4; v++) {
-            attr.position[i * 4 + v] = quadVertPos[v];
-            attr.normal[i * 4 + v] = {0.0f, 0.0f, 1.0f};
-            attr.color[i * 4 + v] = {1.0f, 0.0f, 1.0f, 1.0f};
-            attr.uv0[i * 4 + v] = quadUVs[v];
-        }
-
-        indices[i * 6 + 0] = static_cast<uint16_t>(i * 4 + 0);
-        indices[i * 6 + 1] = static_cast<uint16_t>(i * 4 + 3);
-        indices[i * 6 + 2] = static_cast<uint16_t>(i * 4 + 1);
-        indices[i * 6 + 3] = static_cast<uint16_t>(i * 4 + 1);
-        indices[i * 6 + 4] = static_cast<uint16_t>(i * 4 + 3);
-        indices[i * 6 + 5] = static_cast<uint16_t>(i * 4 + 2);
+    for (int v = 0; v < 4; v++) {
+        attr.position.push_back(quadVertPos[v]);
+        attr.uv0.push_back(quadUVs[v]);
     }
-
+    std::vector<TriangleIndex> indices = {0, 3, 1, 1, 3, 2};
     SurfaceDef.geo.Create(attr, indices);
+
+    // the instances are streamed every frame, Frame() sets their attribute pointers
+    GL(glBindVertexArray(SurfaceDef.geo.vertexArrayObject));
+    for (const auto& a : instanceAttribs) {
+        GL(glEnableVertexAttribArray(a.Location));
+        GL(glVertexAttribDivisor(a.Location, 1));
+    }
+    GL(glBindVertexArray(0));
+    SurfaceDef.numInstances = 0;
 }
 
 } // namespace OVRFW
@@ -46,17 +46,17 @@ namespace OVRFW {
 
 class ovrTextureAtlas;
 
-struct particleDerived_t {
-    OVR::Vector3f Pos;
-    OVR::Vector4f Color;
+// Per-particle instance data. The vertex shader expands each instance into a camera facing quad.
+struct particleInstance_t {
+    OVR::Vector4f PositionScale; // xyz = position, w = scale
+    OVR::Vector4f UvRect; // sprite uv mins in xy, uv maxs in zw
+    uint16_t Color[4]; // half floats, so colors brighter than 1 still add up when blended
     float Orientation; // roll angle in radians
-    float Scale;
-    uint16_t SpriteIndex;
 };
 
 struct particleSort_t {
-    int ActiveIndex;
-    float DistanceSq;
+    int ActiveIndex; // index in the list of active particles
+    uint32_t DepthKey; // increases from far to near
 };
 
 //==============================================================
@@ -71,6 +71,9 @@ class ovrParticleSystem {
     virtual ~ovrParticleSystem();
 
     // specify sprite locations as a regular grid
+    // sortParticles draws from far to near, which alpha blending needs but the default additive
+    // blend does not. It adds about 60% to the CPU time of Frame(), so a system that is close to
+    // its budget unsorted won't fit it sorted.
     void Init(
         size_t maxParticles,
         const ovrTextureAtlas* atlas,
@@ -121,41 +124,82 @@ class ovrParticleSystem {
     static ovrGpuState GetDefaultGpuState();
 
    private:
-    void CreateGeometry(const int maxParticles);
+    void CreateGeometry();
+    void SetParticle(
+        const int index,
+        const double startTime,
+        const OVR::Vector3f& position,
+        const float orientation,
+        const OVR::Vector3f& velocity,
+        const OVR::Vector3f& acceleration,
+        const OVR::Vector4f& color,
+        const ovrEaseFunc easeFunc,
+        const float rotationRate,
+        const float scale,
+        const float lifeTime,
+        const uint16_t spriteIndex);
+
+    // CPU stages of Frame(), no GL calls
+    void IntegrateParticles(const double displayTime, const OVR::Vector3f& viewPos);
+    void CollectParticles();
+    void SortParticlesByDistance();
+    void BuildInstances(const ovrTextureAtlas* atlas, particleInstance_t* dst);
+    void CopySortedInstances(particleInstance_t* dst) const;
 
     int GetMaxParticles() const {
-        return SurfaceDef.geo.vertexCount / 4;
+        return static_cast<int>(maxParticles_);
     }
 
-    class ovrParticle {
-       public:
-        // empty constructor so we don't pay the price for double initialization
-        ovrParticle() {}
-
-        double StartTime; // time particle was created, negative means this particle is invalid
-        float LifeTime; // time particle should die
-        OVR::Vector3f InitialPosition; // initial position of the particle
-        float InitialOrientation; // initial orientation of the particle
-        OVR::Vector3f InitialVelocity; // initial velocity of the particle
-        OVR::Vector3f HalfAcceleration; // 1/2 the initial acceleration of the particle
-        OVR::Vector4f InitialColor; // initial color of the particle
-        float RotationRate; // rotation of the particle
-        float InitialScale; // initial scale of the particle
-        uint16_t SpriteIndex; // index of the sprite for this particle
-        ovrEaseFunc EaseFunc; // parametric function used to compute alpha
-    };
-
     size_t maxParticles_; // maximum allowd particles
-    std::vector<ovrParticle> particles_; // all active particles
+    int numSlots_; // number of particle slots ever used, active or free
+    int activeCount_; // number of active particles
     std::vector<handle_t> freeParticles_; // indices of free particles
-    std::vector<handle_t> activeParticles_; // indices of active particles
-    std::vector<particleDerived_t> derived_;
+
+    // Particle state in SoA arrays indexed by handle, so the per-frame integration is a plain loop
+    // over floats that the compiler vectorizes. The state that is only read for visible particles
+    // after sorting is kept per particle.
+    std::vector<uint8_t> active_; // 1 if the slot holds a particle
+    std::vector<double> startTime_; // time particle was created
+    std::vector<float> lifeTime_; // time particle should die, negative once removed
+    std::vector<float> invLifeTime_;
+    std::vector<float> posX_; // initial position of the particle
+    std::vector<float> posY_;
+    std::vector<float> posZ_;
+    std::vector<float> velX_; // initial velocity of the particle
+    std::vector<float> velY_;
+    std::vector<float> velZ_;
+    std::vector<float> halfAccX_; // 1/2 the initial acceleration of the particle
+    std::vector<float> halfAccY_;
+    std::vector<float> halfAccZ_;
+    std::vector<float> initialOrientation_;
+    std::vector<float> rotationRate_;
+    std::vector<float> easeCurve_; // 0 = none, 1 = linear, 2 = quadratic, 3 = cubic
+    std::vector<float> easeColor_; // 1 if the ease scales the color as well as alpha
+    std::vector<OVR::Vector4f> initialColor_;
+    std::vector<float> scale_;
+    std::vector<uint16_t> spriteIndex_;
+
+    // derived each frame by IntegrateParticles
+    std::vector<float> age_;
+    std::vector<float> curX_;
+    std::vector<float> curY_;
+    std::vector<float> curZ_;
+    std::vector<float> curOrientation_;
+    std::vector<float> alphaScale_;
+    std::vector<float> colorScale_;
+    std::vector<float> distanceSq_;
+
+    std::vector<int> activeSlots_; // slots of the active particles, in slot order
     std::vector<particleSort_t> sortIndices_;
-    std::vector<uint8_t> packedAttr_;
-    OVRFW::VertexAttribs attr_;
+    std::vector<particleSort_t> sortTemp_;
+    // When sorting, the instances are built in slot order, which reads the SoA arrays in order,
+    // and copied to the stream in draw order.
+    std::vector<particleInstance_t> unsortedInstances_;
+    int64_t StreamedFrame; // stream frame the instances were written in, see GlStreamBuffer
     GlProgram Program;
     ovrSurfaceDef SurfaceDef;
     OVR::Matrix4f ModelMatrix;
+    OVR::Matrix4f ParticleViewMatrix; // inverse of the center eye view matrix
     bool SortParticles;
 };
 
@@ -0,0 +1,125 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * Licensed under the Oculus SDK License Agreement (the "License");
+ * you may not use the Oculus SDK except in compliance with the License,
+ * which is provided at the time of installation or download, or which
+ * otherwise accompanies this software in either electronic or hard copy form.
+ *
+ * You may obtain a copy of the License at
+ * https://developer.oculus.com/licenses/oculussdk/
+ *
+ * Unless required by applicable law or agreed to in writing, the Oculus SDK
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/************************************************************************************
+
+Filename    :   RadixSort.h
+Content     :   Stable radix sort for the per-frame sorts of the renderers.
+Language    :   C++
+
+*************************************************************************************/
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace OVRFW {
+
+// Sort key for a float that is never negative, such as a squared distance. The bit patterns of
+// positive floats increase with their value; invert the key to sort in decreasing order.
+inline uint32_t RadixSortKey(const float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+// Stable LSD radix sort of items in increasing order of getKey(item), an unsigned integer that
+// must fit in keyBits bits. The keys are sorted 11 bits per pass, and a pass is skipped when
+// every key has the same digit. Short lists are merge sorted instead, because clearing and
+// summing the histograms would cost more than the sort. temp is scratch space; keep both vectors
+// from frame to frame to avoid allocations.
+template <typename T, typename GetKey>
+void RadixSort(std::vector<T>& items, std::vector<T>& temp, const int keyBits, GetKey getKey) {
+    static const int RADIX_BITS = 11;
+    static const int RADIX_SIZE = 1 << RADIX_BITS;
+    static const int MERGE_SORT_COUNT = 512;
+    static const int INSERTION_SORT_RUN = 16;
+
+    const int count = static_cast<int>(items.size());
+    if (count < 2) {
+        return;
+    }
+
+    if (count < MERGE_SORT_COUNT) {
+        // insertion sort runs, then merge them back and forth between items and temp
+        for (int first = 0; first < count; first += INSERTION_SORT_RUN) {
+            const int end = std::min(first + INSERTION_SORT_RUN, count);
+            for (int i = first + 1; i < end; i++) {
+                const T item = items[i];
+                const auto key = getKey(item);
+                int j = i;
+                for (; j > first && getKey(items[j - 1]) > key; j--) {
+                    items[j] = items[j - 1];
+                }
+                items[j] = item;
+            }
+        }
+        if (count <= INSERTION_SORT_RUN) {
+            return;
+        }
+        temp.resize(count);
+        for (int width = INSERTION_SORT_RUN; width < count; width *= 2) {
+            for (int first = 0; first < count; first += 2 * width) {
+                const int middle = std::min(first + width, count);
+                const int end = std::min(first + 2 * width, count);
+                int a = first;
+                int b = middle;
+                int dst = first;
+                while (a < middle && b < end) {
+                    temp[dst++] = (getKey(items[b]) < getKey(items[a])) ? items[b++] : items[a++];
+                }
+                while (a < middle) {
+                    temp[dst++] = items[a++];
+                }
+                while (b < end) {
+                    temp[dst++] = items[b++];
+                }
+            }
+            items.swap(temp);
+        }
+        return;
+    }
+
+    temp.resize(count);
+    const int passes = (keyBits + RADIX_BITS - 1) / RADIX_BITS;
+    for (int pass = 0; pass < passes; pass++) {
+        const int shift = pass * RADIX_BITS;
+        int offsets[RADIX_SIZE] = {};
+        for (int i = 0; i < count; i++) {
+            offsets[(getKey(items[i]) >> shift) & (RADIX_SIZE - 1)]++;
+        }
+        if (offsets[(getKey(items[0]) >> shift) & (RADIX_SIZE - 1)] == count) {
+            continue;
+        }
+        int sum = 0;
+        for (int i = 0; i < RADIX_SIZE; i++) {
+            const int c = offsets[i];
+            offsets[i] = sum;
+            sum += c;
+        }
+        for (int i = 0; i < count; i++) {
+            temp[offsets[(getKey(items[i]) >> shift) & (RADIX_SIZE - 1)]++] = items[i];
+        }
+        items.swap(temp);
+    }
+}
+
+} // namespace OVRFW
@@ -32,6 +32,7 @@ Authors     :   Jonathan E. Wright
 
 #include "OVR_Math.h"
 #include "Render/GlTexture.h"
+#include "Render/GlStreamBuffer.h"
 #include "Misc/Log.h"
 
 using OVR::Matrix4f;
@@ -90,16 +91,13 @@ static GlTexture CreateRibbonTexture() {
 }
 
 ovrRibbon::ovrRibbon(const ovrPointList& pointList, const float width, const Vector4f& color)
-    : HalfWidth(width), Color(color) {
+    : HalfWidth(width), Color(color), StreamedFrame(-1) {
     // initialize the surface geometry
     const int maxPoints = pointList.GetMaxPoints();
     const int maxQuads = (maxPoints - 1);
-    const int numVerts = maxQuads * 4;
 
+    // vertices are streamed every frame, the geometry only owns the indices
     VertexAttribs attr;
-    attr.position.resize(numVerts);
-    attr.color.resize(numVerts);
-    attr.uv0.resize(numVerts);
 
     // the indices will never change
     const int numIndices = maxQuads * 6;
@@ -190,16 +188,21 @@ void ovrRibbon::Update(
     const ovrPointList& pointList,
     const OVR::Matrix4f& centerViewMatrix,
     const bool invertAlpha) {
+    Surface.geo.indexCount = 0;
     if (pointList.GetCurPoints() <= 1) {
         return;
     }
 
-    VertexAttribs attr;
     const int curPoints = pointList.GetCurPoints();
     const int numVerts = (curPoints - 1) * 4;
-    attr.position.resize(numVerts);
-    attr.color.resize(numVerts);
-    attr.uv0.resize(numVerts);
+
+    // write the vertices straight into the vertex stream, in order and without reading back
+    GlStreamBuffer& stream = GetVertexStreamBuffer();
+    const GlStreamBuffer::Allocation alloc = stream.Map(numVerts * sizeof(colorTexVertex_t));
+    colorTexVertex_t* verts = static_cast<colorTexVertex_t*>(alloc.data);
+    if (verts == nullptr) {
+        return;
+    }
 
     Vector3f eyeFwd(GetViewMatrixForward(centerViewMatrix));
     int numQuads = 0;
@@ -229,12 +232,14 @@ void ovrRibbon::Update(
     float alpha = calcAlpha(curEdge, pointList.GetCurPoints(), invertAlpha);
 
     // cur edge
-    attr.position[(numQuads * 4) + 0] = *curPoint + (edgeDir * HalfWidth);
-    attr.color[(numQuads * 4) + 0] = Vector4f(Color.x, Color.y, Color.z, alpha);
-    attr.position[(numQuads * 4) + 1] = *curPoint - (edgeDir * HalfWidth);
-    attr.color[(numQuads * 4) + 1] = Vector4f(Color.x, Color.y, Color.z, alpha);
-    attr.uv0[(numQuads * 4) + 0] = OVR::Vector2f(0.0f, 0.0f);
-    attr.uv0[(numQuads * 4) + 1] = OVR::Vector2f(0.0f, 1.0f);
+    verts[(numQuads * 4) + 0] = {
+        *curPoint + (edgeDir * HalfWidth),
+        Vector4f(Color.x, Color.y, Color.z, alpha),
+        OVR::Vector2f(0.0f, 0.0f)};
+    verts[(numQuads * 4) + 1] = {
+        *curPoint - (edgeDir * HalfWidth),
+        Vector4f(Color.x, Color.y, Color.z, alpha),
+        OVR::Vector2f(0.0f, 1.0f)};
 
     for (;;) {
         curPoint = &pointList.Get(curIdx);
@@ -245,13 +250,14 @@ void ovrRibbon::Update(
         alpha = calcAlpha(curEdge, pointList.GetCurPoints(), invertAlpha);
 
         // current quad next edge
-        attr.position[(numQuads * 4) + 2] = *nextPoint + (edgeDir * HalfWidth * alpha);
-        attr.color[(numQuads * 4) + 2] = Vector4f(Color.x, Color.y, Color.z, alpha);
-        attr.position[(numQuads * 4) + 3] = *nextPoint - (edgeDir * HalfWidth * alpha);
-        attr.color[(numQuads * 4) + 3] = Vector4f(Color.x, Color.y, Color.z, alpha);
-
-        attr.uv0[(numQuads * 4) + 2] = OVR::Vector2f(1.0f, 0.0f);
-        attr.uv0[(numQuads * 4) + 3] = OVR::Vector2f(1.0f, 1.0f);
+        verts[(numQuads * 4) + 2] = {
+            *nextPoint + (edgeDir * HalfWidth * alpha),
+            Vector4f(Color.x, Color.y, Color.z, alpha),
+            OVR::Vector2f(1.0f, 0.0f)};
+        verts[(numQuads * 4) + 3] = {
+            *nextPoint - (edgeDir * HalfWidth * alpha),
+            Vector4f(Color.x, Color.y, Color.z, alpha),
+            OVR::Vector2f(1.0f, 1.0f)};
 
         curIdx = nextIdx;
         nextIdx = pointList.GetNext(nextIdx);
@@ -264,22 +270,29 @@ void ovrRibbon::Update(
         alpha = calcAlpha(curEdge, pointList.GetCurPoints(), invertAlpha);
 
         // next quad first edge
-        attr.position[(numQuads * 4) + 0] = *nextPoint + (edgeDir * HalfWidth * alpha);
-        attr.color[(numQuads * 4) + 0] = Vector4f(Color.x, Color.y, Color.z, alpha);
-        attr.position[(numQuads * 4) + 1] = *nextPoint - (edgeDir * HalfWidth * alpha);
-        attr.color[(numQuads * 4) + 1] = Vector4f(Color.x, Color.y, Color.z, alpha);
-        attr.uv0[(numQuads * 4) + 0] = OVR::Vector2f(0.0f, 0.0f);
-        attr.uv0[(numQuads * 4) + 1] = OVR::Vector2f(0.0f, 1.0f);
+        verts[(numQuads * 4) + 0] = {
+            *nextPoint + (edgeDir * HalfWidth * alpha),
+            Vector4f(Color.x, Color.y, Color.z, alpha),
+            OVR::Vector2f(0.0f, 0.0f)};
+        verts[(numQuads * 4) + 1] = {
+            *nextPoint - (edgeDir * HalfWidth * alpha),
+            Vector4f(Color.x, Color.y, Color.z, alpha),
+            OVR::Vector2f(0.0f, 1.0f)};
     }
+    stream.Unmap();
 
     // ALOG( "Ribbon: %i points, %i edges, %i quads", pointList.GetCurPoints(), curEdge, numQuads );
-    // update the vertices
-    Surface.geo.Update(attr, false);
+    // point the geometry at the vertices
+    Surface.geo.BindVertexStream(
+        alloc.buffer, alloc.offset, colorTexVertex_t::GetStreamLayout(), VertexLayout::Full());
+    Surface.geo.vertexCount = numVerts;
     Surface.geo.indexCount = numQuads * 6;
+    StreamedFrame = stream.GetFrameIndex();
 }
 
 void ovrRibbon::GenerateSurfaceList(std::vector<ovrDrawSurface>& surfaceList) const {
-    if (Surface.geo.indexCount == 0) {
+    // the streamed vertices are only valid in the frame Update() wrote them
+    if (Surface.geo.indexCount == 0 || StreamedFrame != GetVertexStreamBuffer().GetFrameIndex()) {
         return;
     }
 
@@ -56,6 +56,7 @@ class ovrRibbon {
     OVR::Vector4f Color;
     ovrSurfaceDef Surface;
     GlTexture Texture;
+    int64_t StreamedFrame; // stream frame the vertices were written in, see GlStreamBuffer
 };
 
 } // namespace OVRFW
@@ -46,8 +46,6 @@ using OVR::Vector4f;
 
 namespace OVRFW {
 
-bool LogRenderSurfaces = false; // Do not check in set to true!
-
 static void
 ChangeGpuState(const ovrGpuState oldState, const ovrGpuState newState, bool force = false) {
     if (force || newState.blendEnable != oldState.blendEnable) {
@@ -136,7 +134,11 @@ ChangeGpuState(const ovrGpuState oldState, const ovrGpuState newState, bool forc
     // extend as needed
 }
 
-ovrSurfaceRender::ovrSurfaceRender() : CurrentSceneMatricesIdx(0) {}
+ovrSurfaceRender::ovrSurfaceRender()
+    : CurrentSceneMatricesIdx(0),
+      CurrentInstanceMatricesIdx(0),
+      UniformBufferOffsetAlignment(256),
+      NumUniformShadows(0) {}
 
 ovrSurfaceRender::~ovrSurfaceRender() {}
 
@@ -146,12 +148,27 @@ void ovrSurfaceRender::Init() {
     }
 
     CurrentSceneMatricesIdx = 0;
+
+    for (int i = 0; i < MAX_INSTANCE_MATRICES_UBOS; i++) {
+        InstanceMatrices[i].Create(
+            GLBUFFER_TYPE_UNIFORM,
+            INSTANCE_MATRICES * sizeof(Matrix4f) + GlProgram::INSTANCE_MATRICES_UBO_SIZE,
+            nullptr);
+    }
+    CurrentInstanceMatricesIdx = 0;
+
+    GLint alignment = 0;
+    GL(glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment));
+    UniformBufferOffsetAlignment = std::max(alignment, 1);
 }
 
 void ovrSurfaceRender::Shutdown() {
     for (int i = 0; i < MAX_SCENEMATRICES_UBOS; i++) {
         SceneMatrices[i].Destroy();
     }
+    for (int i = 0; i < MAX_INSTANCE_MATRICES_UBOS; i++) {
+        InstanceMatrices[i].Destroy();
+    }
 }
 
 int ovrSurfaceRender::UpdateSceneMatrices(
@@ -213,6 +230,72 @@ int ovrSurfaceRender::UpdateSceneMatrices(
     return CurrentSceneMatricesIdx;
 }
 
+void ovrSurfaceRender::BuildBatches(const std::vector<ovrDrawSurface>& surfaceList) {
+    Batches.clear();
+
+    const int numSurfaces = static_cast<int>(surfaceList.size());
+    const int capacity = INSTANCE_MATRICES * sizeof(Matrix4f);
+    char* matricesBuffer = nullptr;
+    bool mapFailed = false;
+    int offset = 0;
+
+    for (int first = 0; first < numSurfaces;) {
+        ovrSurfaceBatch batch = {first, BatchLength(surfaceList, first), -1};
+        if (batch.Count > 1) {
+            const int size = batch.Count * static_cast<int>(sizeof(Matrix4f));
+            if (matricesBuffer == nullptr && !mapFailed) {
+                // Only map a buffer when there is something to batch.
+                CurrentInstanceMatricesIdx =
+                    (CurrentInstanceMatricesIdx + 1) % MAX_INSTANCE_MATRICES_UBOS;
+                matricesBuffer = static_cast<char*>(
+                    InstanceMatrices[CurrentInstanceMatricesIdx].MapBuffer());
+                mapFailed = (matricesBuffer == nullptr);
+            }
+            if (matricesBuffer == nullptr || offset + size > capacity) {
+                // out of room, the remaining copies are drawn one at a time
+                batch.Count = 1;
+            } else {
+                batch.Offset = offset;
+                for (int i = 0; i < batch.Count; i++) {
+                    // Transpose the matrices before passing to GL, like the ModelMatrix uniform.
+                    const Matrix4f transposed = surfaceList[first + i].modelMatrix.Transposed();
+                    memcpy(matricesBuffer + offset, &transposed, sizeof(Matrix4f));
+                    offset += sizeof(Matrix4f);
+                }
+                offset = ((offset + UniformBufferOffsetAlignment - 1) /
+                          UniformBufferOffsetAlignment) *
+                    UniformBufferOffsetAlignment;
+            }
+        }
+        Batches.push_back(batch);
+        first += batch.Count;
+    }
+
+    if (matricesBuffer != nullptr) {
+        InstanceMatrices[CurrentInstanceMatricesIdx].UnmapBuffer();
+    }
+}
+
+ovrSurfaceRender::ovrUniformShadow& ovrSurfaceRender::GetUniformShadow(
+    const unsigned int program) {
+    for (int i = 0; i < NumUniformShadows; i++) {
+        if (UniformShadows[i].Program == program) {
+            return UniformShadows[i];
+        }
+    }
+    if (NumUniformShadows >= static_cast<int>(UniformShadows.size())) {
+        UniformShadows.resize(NumUniformShadows + 1);
+    }
+    ovrUniformShadow& shadow = UniformShadows[NumUniformShadows++];
+    shadow.Program = program;
+    shadow.ViewID = -1;
+    shadow.ModelMatrixValid = false;
+    for (int i = 0; i < ovrUniform::MAX_UNIFORMS; i++) {
+        shadow.Valid[i] = false;
+    }
+    return shadow;
+}
+
 // Renders a list of pointers to models in order.
 ovrDrawCounters ovrSurfaceRender::RenderSurfaceList(
     const std::vector<ovrDrawSurface>& surfaceList,
@@ -229,16 +312,26 @@ ovrDrawCounters ovrSurfaceRender::RenderSurfaceList(
     GLuint currentBuffers[ovrUniform::MAX_UNIFORMS] = {};
     GLuint currentTextures[ovrUniform::MAX_UNIFORMS] = {};
     GLuint currentProgramObject = 0;
+    ovrUniformShadow* shadow = nullptr;
+
+    // Uniform values may have been changed outside of this function, so only shadow the
+    // values sent during this call.
+    NumUniformShadows = 0;
 
     const int sceneMatricesIdx =
         UpdateSceneMatrices(&viewMatrix, &projectionMatrix, GlProgram::MAX_VIEWS /* num eyes */);
 
+    // Merge consecutive draws of the same surface into instanced draws.
+    BuildBatches(surfaceList);
+
     // counters
     ovrDrawCounters counters;
 
     // Loop through all the surfaces
-    for (const ovrDrawSurface& drawSurface : surfaceList) {
+    for (const ovrSurfaceBatch& batch : Batches) {
+        const ovrDrawSurface& drawSurface = surfaceList[batch.First];
         const ovrSurfaceDef& surfaceDef = *drawSurface.surface;
+        const bool batched = (batch.Offset >= 0);
         const ovrGraphicsCommand& cmd = surfaceDef.graphicsCommand;
 
         if (cmd.Program.IsValid()) {
@@ -252,22 +345,78 @@ ovrDrawCounters ovrSurfaceRender::RenderSurfaceList(
 
                 currentProgramObject = cmd.Program.Program;
                 GL(glUseProgram(cmd.Program.Program));
+                shadow = &GetUniformShadow(cmd.Program.Program);
             }
 
+            // Returns true if the uniform value differs from the shadow copy and updates it.
+            auto uniformChanged = [&](const int i, const size_t size) {
+                assert(size <= sizeof(shadow->Values[i]));
+                const void* data = cmd.UniformData[i].Data;
+                if (shadow->Valid[i] && memcmp(shadow->Values[i], data, size) == 0) {
+                    counters.numParameterSkips++;
+                    return false;
+                }
+                memcpy(shadow->Values[i], data, size);
+                shadow->Valid[i] = true;
+                counters.numParameterUpdates++;
+                return true;
+            };
+
             // Update globally defined system level uniforms.
             {
-                if (cmd.Program.ViewID.Location >= 0) // not defined when multiview enabled
-                {
+                if (cmd.Program.ViewID.Location >= 0 && shadow->ViewID != eye) {
+                    // not defined when multiview enabled
+                    shadow->ViewID = eye;
                     GL(glUniform1i(cmd.Program.ViewID.Location, eye));
                 }
-                GL(glUniformMatrix4fv(
-                    cmd.Program.ModelMatrix.Location, 1, GL_TRUE, drawSurface.modelMatrix.M[0]));
-
-                if (cmd.Program.SceneMatrices.Location >= 0) {
-                    GL(glBindBufferBase(
+                if (batched) {
+                    GL(glBindBufferRange(
                         GL_UNIFORM_BUFFER,
-                        cmd.Program.SceneMatrices.Binding,
-                        SceneMatrices[sceneMatricesIdx].GetBuffer()));
+                        cmd.Program.InstanceMatrices.Binding,
+                        InstanceMatrices[CurrentInstanceMatricesIdx].GetBuffer(),
+                        batch.Offset,
+                        GlProgram::INSTANCE_MATRICES_UBO_SIZE));
+                    // a range of the buffer is bound, so don't match it against whole buffers
+                    currentBuffers[cmd.Program.InstanceMatrices.Binding] = 0;
+                    GL(glUniform1i(cmd.Program.InstanceBatch.Location, 1));
+                } else {
+                    if (!shadow->ModelMatrixValid ||
+                        !(shadow->ModelMatrix == drawSurface.modelMatrix)) {
+                        shadow->ModelMatrixValid = true;
+                        shadow->ModelMatrix = drawSurface.modelMatrix;
+                        GL(glUniformMatrix4fv(
+                            cmd.Program.ModelMatrix.Location,
+                            1,
+                            GL_TRUE,
+                            drawSurface.modelMatrix.M[0]));
+                    }
+                    if (cmd.Program.InstanceMatrices.Location >= 0) {
+                        // The block is active even though InstanceBatch is 0, and GL needs a
+                        // range of its size bound for every draw. The start of the current
+                        // buffer is bound, and currentBuffers holds it while nothing else is.
+                        const int binding = cmd.Program.InstanceMatrices.Binding;
+                        const GLuint buffer =
+                            InstanceMatrices[CurrentInstanceMatricesIdx].GetBuffer();
+                        if (currentBuffers[binding] != buffer) {
+                            counters.numBufferBinds++;
+                            currentBuffers[binding] = buffer;
+                            GL(glBindBufferRange(
+                                GL_UNIFORM_BUFFER,
+                                binding,
+                                buffer,
+                                0,
+                                GlProgram::INSTANCE_MATRICES_UBO_SIZE));
+                        }
+                    }
+                }
+                if (cmd.Program.SceneMatrices.Location >= 0) {
+                    const int binding = cmd.Program.SceneMatrices.Binding;
+                    const GLuint buffer = SceneMatrices[sceneMatricesIdx].GetBuffer();
+                    if (currentBuffers[binding] != buffer) {
+                        counters.numBufferBinds++;
+                        currentBuffers[binding] = buffer;
+                        GL(glBindBufferBase(GL_UNIFORM_BUFFER, binding, buffer));
+                    }
                 }
             }
 
@@ -275,12 +424,12 @@ ovrDrawCounters ovrSurfaceRender::RenderSurfaceList(
             bool uniformsDone = false;
             {
                 for (int i = 0; i < ovrUniform::MAX_UNIFORMS && !uniformsDone; ++i) {
-                    counters.numParameterUpdates++;
                     const int parmLocation = cmd.Program.Uniforms[i].Location;
+                    const bool haveValue = parmLocation >= 0 && cmd.UniformData[i].Data != nullptr;
 
                     switch (cmd.Program.Uniforms[i].Type) {
                         case ovrProgramParmType::INT: {
-                            if (parmLocation >= 0 && cmd.UniformData[i].Data != nullptr) {
+                            if (haveValue && uniformChanged(i, sizeof(int))) {
                                 GL(glUniform1iv(
                                     parmLocation,
                                     1,
@@ -288,7 +437,7 @@ ovrDrawCounters ovrSurfaceRender::RenderSurfaceList(
                             }
                         } break;
                         case ovrProgramParmType::INT_VECTOR2: {
-                            if (parmLocation >= 0 && cmd.UniformData[i].Data != nullptr) {
+                            if (haveValue && uniformChanged(i, 2 * sizeof(int))) {
                                 GL(glUniform2iv(
                                     parmLocation,
                                     1,
@@ -296,7 +445,7 @@ ovrDrawCounters ovrSurfaceRender::RenderSurfaceList(
                             }
                         } break;
                         case ovrProgramParmType::INT_VECTOR3: {
-                            if (parmLocation >= 0 && cmd.UniformData[i].Data != nullptr) {
+                            if (haveValue && uniformChanged(i, 3 * sizeof(int))) {
                                 GL(glUniform3iv(
                                     parmLocation,
                                     1,
@@ -304,7 +453,7 @@ ovrDrawCounters ovrSurfaceRender::RenderSurfaceList(
                             }
                         } break;
                         case ovrProgramParmType::INT_VECTOR4: {
-                            if (parmLocation >= 0 && cmd.UniformData[i].Data != nullptr) {
+                            if (haveValue && uniformChanged(i, 4 * sizeof(int))) {
                                 GL(glUniform4iv(
                                     parmLocation,
                                     1,
@@ -312,14 +461,14 @@ ovrDrawCounters ovrSurfaceRender::RenderSurfaceList(
                             }
                         } break;
                         case ovrProgramParmType::FLOAT: {
-                            if (parmLocation >= 0 && cmd.UniformData[i].Data != nullptr) {
+                            if (haveValue && uniformChanged(i, sizeof(float))) {
                                 GL(glUniform1f(
                                     parmLocation,
                                     *static_cast<const float*>(cmd.UniformData[i].Data)));
                             }
                         } break;
                         case ovrProgramParmType::FLOAT_VECTOR2: {
-                            if (parmLocation >= 0 && cmd.UniformData[i].Data != nullptr) {
+                            if (haveValue && uniformChanged(i, 2 * sizeof(float))) {
                                 GL(glUniform2fv(
                                     parmLocation,
                                     1,
@@ -327,7 +476,7 @@ ovrDrawCounters ovrSurfaceRender::RenderSurfaceList(
                             }
                         } break;
                         case ovrProgramParmType::FLOAT_VECTOR3: {
-                            if (parmLocation >= 0 && cmd.UniformData[i].Data != nullptr) {
+                            if (haveValue && uniformChanged(i, 3 * sizeof(float))) {
                                 GL(glUniform3fv(
                                     parmLocation,
                                     1,
@@ -335,7 +484,7 @@ ovrDrawCounters ovrSurfaceRender::RenderSurfaceList(
                             }
                         } break;
                         case ovrProgramParmType::FLOAT_VECTOR4: {
-                            if (parmLocation >= 0 && cmd.UniformData[i].Data != nullptr) {
+                            if (haveValue && uniformChanged(i, 4 * sizeof(float))) {
                                 GL(glUniform4fv(
                                     parmLocation,
                                     1,
@@ -343,31 +492,32 @@ ovrDrawCounters ovrSurfaceRender::RenderSurfaceList(
                             }
                         } break;
                         case ovrProgramParmType::FLOAT_MATRIX4: {
-                            if (parmLocation >= 0 && cmd.UniformData[i].Data != nullptr) {
-                                if (cmd.UniformData[i].Count > 1) {
-                                    /// FIXME: setting glUniformMatrix4fv transpose to GL_TRUE for
-                                    /// an array of matrices produces garbage using the Adreno 420
-                                    /// OpenGL ES 3.0 driver.
-                                    static Matrix4f transposedJoints[MAX_JOINTS];
-                                    const int numJoints =
-                                        std::min<int>(cmd.UniformData[i].Count, MAX_JOINTS);
-                                    for (int j = 0; j < numJoints; j++) {
-                                        transposedJoints[j] =
-                                            static_cast<Matrix4f*>(cmd.UniformData[i].Data)[j]
-                                                .Transposed();
-                                    }
-                                    GL(glUniformMatrix4fv(
-                                        parmLocation,
-                                        numJoints,
-                                        GL_FALSE,
-                                        static_cast<const float*>(&transposedJoints[0].M[0][0])));
-                                } else {
-                                    GL(glUniformMatrix4fv(
-                                        parmLocation,
-                                        cmd.UniformData[i].Count,
-                                        GL_TRUE,
-                                        static_cast<const float*>(cmd.UniformData[i].Data)));
+                            if (haveValue && cmd.UniformData[i].Count > 1) {
+                                // Arrays of matrices are not shadowed.
+                                shadow->Valid[i] = false;
+                                counters.numParameterUpdates++;
+                                /// FIXME: setting glUniformMatrix4fv transpose to GL_TRUE for
+                                /// an array of matrices produces garbage using the Adreno 420
+                                /// OpenGL ES 3.0 driver.
+                                static Matrix4f transposedJoints[MAX_JOINTS];
+                                const int numJoints =
+                                    std::min<int>(cmd.UniformData[i].Count, MAX_JOINTS);
+                                for (int j = 0; j < numJoints; j++) {
+                                    transposedJoints[j] =
+                                        static_cast<Matrix4f*>(cmd.UniformData[i].Data)[j]
+                                            .Transposed();
                                 }
+                                GL(glUniformMatrix4fv(
+                                    parmLocation,
+                                    numJoints,
+                                    GL_FALSE,
+                                    static_cast<const float*>(&transposedJoints[0].M[0][0])));
+                            } else if (haveValue && uniformChanged(i, sizeof(Matrix4f))) {
+                                GL(glUniformMatrix4fv(
+                                    parmLocation,
+                                    cmd.UniformData[i].Count,
+                                    GL_TRUE,
+                                    static_cast<const float*>(cmd.UniformData[i].Data)));
                             }
                         } break;
                         case ovrProgramParmType::TEXTURE_SAMPLED: {
@@ -411,38 +561,50 @@ ovrDrawCounters ovrSurfaceRender::RenderSurfaceList(
         }
 
         counters.numDrawCalls++;
+        if (batched) {
+            counters.numBatchedDraws++;
+            counters.numBatchedSurfaces += batch.Count;
+        }
 
         if (LogRenderSurfaces) {
             ALOG(
-                "Drawing %s vao=%d vb=%d primitive=0x%04x indexCount=%d IndexType=0x%04x ",
+                "Drawing %s vao=%d vb=%d primitive=0x%04x indexCount=%d indexType=0x%04x "
+                "batch=%d",
                 surfaceDef.surfaceName.c_str(),
                 surfaceDef.geo.vertexArrayObject,
                 surfaceDef.geo.vertexBuffer,
                 surfaceDef.geo.primitiveType,
                 surfaceDef.geo.indexCount,
-                surfaceDef.geo.IndexType);
+                surfaceDef.geo.indexType,
+                batch.Count);
         }
 
         // Bind all the vertex and element arrays
         {
             GL(glBindVertexArray(surfaceDef.geo.vertexArrayObject));
 
-            if (surfaceDef.numInstances > 1) {
+            const int numInstances = batched ? batch.Count : surfaceDef.numInstances;
+            if (numInstances > 1) {
                 GL(glDrawElementsInstanced(
                     surfaceDef.geo.primitiveType,
                     surfaceDef.geo.indexCount,
-                    surfaceDef.geo.IndexType,
+                    surfaceDef.geo.indexType,
                     nullptr,
-                    surfaceDef.numInstances));
+                    numInstances));
             } else {
                 GL(glDrawElements(
                     surfaceDef.geo.primitiveType,
                     surfaceDef.geo.indexCount,
-                    surfaceDef.geo.IndexType,
+                    surfaceDef.geo.indexType,
                     nullptr));
             }
         }
 
+        if (batched) {
+            // uniform values persist in the program, so switch it back for single draws
+            GL(glUniform1i(surfaceDef.graphicsCommand.Program.InstanceBatch.Location, 0));
+        }
+
         GLCheckErrorsWithTitle(surfaceDef.surfaceName.c_str());
     }
 
@@ -27,6 +27,7 @@ Authors     :   John Carmack
 
 #pragma once
 
+#include <cstdint>
 #include <vector>
 #include <string>
 
@@ -68,7 +69,10 @@ struct ovrDrawCounters {
           numProgramBinds(0),
           numParameterUpdates(0),
           numTextureBinds(0),
-          numBufferBinds(0) {}
+          numBufferBinds(0),
+          numParameterSkips(0),
+          numBatchedDraws(0),
+          numBatchedSurfaces(0) {}
 
     int numElements;
     int numDrawCalls;
@@ -76,6 +80,9 @@ struct ovrDrawCounters {
     int numParameterUpdates; // MVP, etc
     int numTextureBinds;
     int numBufferBinds;
+    int numParameterSkips; // uniforms not sent because the program already had the value
+    int numBatchedDraws; // instanced draws made by merging surfaces
+    int numBatchedSurfaces; // surfaces drawn as part of those batches
 };
 
 struct ovrDrawSurface {
@@ -112,7 +119,36 @@ class ovrSurfaceRender {
         const OVR::Matrix4f& projectionMatrix,
         const int eye);
 
+    // Returns the number of surfaces starting at first that can be merged into a single
+    // instanced draw: consecutive draws of the same non-instanced surface with a program
+    // that reads its model matrix, up to GlProgram::MAX_BATCH_INSTANCES.
+    static int BatchLength(const std::vector<ovrDrawSurface>& surfaceList, const int first);
+
    private:
+    // Values last sent to the uniforms of a program during the current RenderSurfaceList.
+    // Uniform values are program state, so unchanged values are not sent again.
+    struct ovrUniformShadow {
+        unsigned int Program;
+        int ViewID;
+        bool ModelMatrixValid;
+        OVR::Matrix4f ModelMatrix;
+        bool Valid[ovrUniform::MAX_UNIFORMS];
+        uint8_t Values[ovrUniform::MAX_UNIFORMS][sizeof(OVR::Matrix4f)];
+    };
+
+    // Returns the shadow copy for the program, starting a new one on first use.
+    ovrUniformShadow& GetUniformShadow(const unsigned int program);
+
+    struct ovrSurfaceBatch {
+        int First; // index of the first surface in the surface list
+        int Count; // number of surfaces, 1 if not batched
+        int Offset; // byte offset of the model matrices in the InstanceMatrices UBO
+    };
+
+    // Splits the surface list into batches and writes the model matrices of every
+    // batch into the next InstanceMatrices UBO.
+    void BuildBatches(const std::vector<ovrDrawSurface>& surfaceList);
+
     // Returns the index of the updated SceneMatrices UBO.
     int UpdateSceneMatrices(
         const OVR::Matrix4f* viewMatrix,
@@ -130,8 +166,43 @@ class ovrSurfaceRender {
 
     OVR::Matrix4f CachedViewMatrix[GlProgram::MAX_VIEWS];
     OVR::Matrix4f CachedProjectionMatrix[GlProgram::MAX_VIEWS];
+
+    // Per-instance model matrices of batched draws, written once per RenderSurfaceList and
+    // bound per batch with glBindBufferRange. Single draws of programs with the block bind the
+    // start of the buffer, which they don't read. Each buffer has room for INSTANCE_MATRICES
+    // matrices plus a full block so the last batch can always bind a complete block.
+    static const int MAX_INSTANCE_MATRICES_UBOS = 8;
+    static const int INSTANCE_MATRICES = 1024;
+    int CurrentInstanceMatricesIdx;
+    int UniformBufferOffsetAlignment;
+    GlBuffer InstanceMatrices[MAX_INSTANCE_MATRICES_UBOS];
+    std::vector<ovrSurfaceBatch> Batches;
+
+    std::vector<ovrUniformShadow> UniformShadows;
+    int NumUniformShadows;
 };
 
+// Builds a 64 bit key for sorting a surface list. From the most significant bit:
+//   layer (4 bits), transparent (1 bit)
+//   opaque:      program (12 bits), texture set (15 bits), depth (32 bits)
+//   transparent: depth (32 bits), program (12 bits), texture set (15 bits)
+// Opaque surfaces are grouped by state to minimize program and texture changes. Transparent
+// surfaces keep their depth order so they still blend correctly. The depth is any value that
+// increases in the desired draw order within a layer, such as the bits of a positive float
+// distance, inverted for back-to-front.
+uint64_t DrawSortKey(const ovrSurfaceDef& surfaceDef, const uint32_t layer, const uint32_t depth);
+
+// A draw sort key and the index of the surface it was built for.
+struct ovrDrawSortItem {
+    uint64_t key;
+    int index;
+};
+
+// Sorts draw sort items by key, with a radix sort for long lists. Items with equal keys end up
+// in index order, which is list order when the indices increase through the list. temp is
+// scratch space.
+void RadixSortDrawKeys(std::vector<ovrDrawSortItem>& items, std::vector<ovrDrawSortItem>& temp);
+
 // Set this true for log spew from BuildDrawSurfaceList and RenderSurfaceList.
 extern bool LogRenderSurfaces;
 
@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * Licensed under the Oculus SDK License Agreement (the "License");
+ * you may not use the Oculus SDK except in compliance with the License,
+ * which is provided at the time of installation or download, or which
+ * otherwise accompanies this software in either electronic or hard copy form.
+ *
+ * You may obtain a copy of the License at
+ * https://developer.oculus.com/licenses/oculussdk/
+ *
+ * Unless required by applicable law or agreed to in writing, the Oculus SDK
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/************************************************************************************
+
+Filename    :   SurfaceSort.cpp
+Content     :   Draw sort keys, sorting and batching of surface lists. Nothing here
+                makes GL calls.
+Language    :   C++
+
+*************************************************************************************/
+
+#include "SurfaceRender.h"
+
+#include "GlTexture.h"
+#include "RadixSort.h"
+
+#include <algorithm>
+
+namespace OVRFW {
+
+bool LogRenderSurfaces = false; // Do not check in set to true!
+
+uint64_t DrawSortKey(const ovrSurfaceDef& surfaceDef, const uint32_t layer, const uint32_t depth) {
+    const ovrGraphicsCommand& cmd = surfaceDef.graphicsCommand;
+
+    // FNV-1a of the bound textures, folded to 15 bits. Like the draw, stop at the first unused
+    // uniform.
+    uint32_t textureHash = 2166136261u;
+    for (int i = 0; i < ovrUniform::MAX_UNIFORMS; ++i) {
+        const ovrProgramParmType type = cmd.Program.Uniforms[i].Type;
+        if (type == ovrProgramParmType::MAX) {
+            break;
+        }
+        if (type == ovrProgramParmType::TEXTURE_SAMPLED && cmd.UniformData[i].Data != nullptr) {
+            textureHash ^= static_cast<const GlTexture*>(cmd.UniformData[i].Data)->texture;
+            textureHash *= 16777619u;
+        }
+    }
+    const uint64_t textures = (textureHash ^ (textureHash >> 15)) & 0x7FFF;
+    const uint64_t program = cmd.Program.Program & 0xFFF;
+    const uint64_t transparent = (cmd.GpuState.blendEnable != ovrGpuState::BLEND_DISABLE);
+
+    uint64_t key = (static_cast<uint64_t>(layer & 0xF) << 60) | (transparent << 59);
+    if (transparent) {
+        key |= (static_cast<uint64_t>(depth) << 27) | (program << 15) | textures;
+    } else {
+        key |= (program << 47) | (textures << 32) | depth;
+    }
+    return key;
+}
+
+// Below this many items a comparison sort is faster than the histogram passes over the 64 bit
+// keys.
+static const size_t DRAW_KEY_COMPARISON_SORT_COUNT = 1024;
+
+// IMPORTANT: the sort is stable so surfaces with identical keys will sort consistently from
+// frame to frame.
+void RadixSortDrawKeys(std::vector<ovrDrawSortItem>& items, std::vector<ovrDrawSortItem>& temp) {
+    if (items.size() < DRAW_KEY_COMPARISON_SORT_COUNT) {
+        // the indices break ties, so equal keys stay in order without a stable sort
+        std::sort(
+            items.begin(), items.end(), [](const ovrDrawSortItem& a, const ovrDrawSortItem& b) {
+                return a.key < b.key || (a.key == b.key && a.index < b.index);
+            });
+        return;
+    }
+    RadixSort(items, temp, 64, [](const ovrDrawSortItem& item) { return item.key; });
+}
+
+int ovrSurfaceRender::BatchLength(
+    const std::vector<ovrDrawSurface>& surfaceList,
+    const int first) {
+    const ovrSurfaceDef* surface = surfaceList[first].surface;
+    if (surface == nullptr || surface->numInstances > 1 ||
+        !surface->graphicsCommand.Program.SupportsBatching()) {
+        return 1;
+    }
+    const int end = std::min(
+        static_cast<int>(surfaceList.size()), first + GlProgram::MAX_BATCH_INSTANCES);
+    int last = first + 1;
+    while (last < end && surfaceList[last].surface == surface) {
+        last++;
+    }
+    return last - first;
+}
+
+} // namespace OVRFW
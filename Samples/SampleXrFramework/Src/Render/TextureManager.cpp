@@ -28,12 +28,20 @@ Authors     :   Jonathan E. Wright
 #include "TextureManager.h"
 
 #include "Misc/Log.h"
-
+#include "OVR_PerfTimer.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
 #include <vector>
 #include <unordered_map>
 
 #include "OVR_FileSys.h"
 #include "PackageFiles.h"
+#include "System.h"
 
 namespace OVRFW {
 
@@ -90,6 +98,24 @@ class ovrTextureManagerImpl : public ovrTextureManager {
         ovrTextureFilter const filterType = FILTER_DEFAULT,
         ovrTextureWrap const wrapType = WRAP_DEFAULT) OVR_OVERRIDE;
 
+    virtual textureHandle_t LoadTextureAsync(
+        ovrFileSys& fileSys,
+        char const* uri,
+        ovrTextureFilter const filterType = FILTER_DEFAULT,
+        ovrTextureWrap const wrapType = WRAP_DEFAULT,
+        ovrTextureLoadCallback const& callback = nullptr) OVR_OVERRIDE;
+    virtual textureHandle_t LoadTextureAsync(
+        char const* uri,
+        void const* buffer,
+        size_t const bufferSize,
+        ovrTextureFilter const filterType = FILTER_DEFAULT,
+        ovrTextureWrap const wrapType = WRAP_DEFAULT,
+        ovrTextureLoadCallback const& callback = nullptr) OVR_OVERRIDE;
+
+    virtual void Update() OVR_OVERRIDE;
+    virtual void SetUploadBudget(size_t const bytesPerFrame) OVR_OVERRIDE;
+    virtual ovrTextureLoadState GetLoadState(textureHandle_t const handle) const OVR_OVERRIDE;
+
     virtual void FreeTexture(textureHandle_t const handle) OVR_OVERRIDE;
 
     virtual ovrManagedTexture GetTexture(textureHandle_t const handle) const OVR_OVERRIDE;
@@ -101,11 +127,54 @@ class ovrTextureManagerImpl : public ovrTextureManager {
     virtual void PrintStats() const OVR_OVERRIDE;
 
    private:
+    // A file read and decoded on a decode thread. The job id tells a job for a texture that was
+    // freed or loaded synchronously in the meantime from the current load of the same index.
+    struct ovrTextureLoadJob {
+        int Index = -1;
+        uint32_t JobId = 0;
+        std::string Uri;
+        ovrFileSys* FileSys = nullptr; // null if the file data is already in Buffer
+        std::vector<uint8_t> Buffer;
+        ovrDecodedTexture Decoded;
+        bool Success = false;
+    };
+
+    struct ovrPendingLoad {
+        uint32_t JobId = 0;
+        bool FromUri = false;
+        ovrTextureFilter FilterType = FILTER_DEFAULT;
+        ovrTextureWrap WrapType = WRAP_DEFAULT;
+        std::vector<ovrTextureLoadCallback> Callbacks;
+    };
+
+    // A callback waiting for the next Update().
+    struct ovrLoadNotification {
+        textureHandle_t Handle;
+        bool Success = false;
+        ovrTextureLoadCallback Callback;
+    };
+
     std::vector<ovrManagedTexture> Textures;
+    std::vector<ovrTextureLoadState> LoadStates; // parallel to Textures
     std::vector<int> FreeTextures;
     bool Initialized;
     std::unordered_map<std::string, int> UriHash;
 
+    // only touched on the GL thread
+    std::unordered_map<int, ovrPendingLoad> PendingLoads;
+    std::vector<ovrLoadNotification> Notifications;
+    uint32_t NextJobId;
+    size_t UploadBudget;
+    GlTexture Placeholder;
+
+    // shared with the decode threads
+    std::mutex JobMutex;
+    std::condition_variable JobAvailable;
+    std::deque<std::unique_ptr<ovrTextureLoadJob>> DecodeQueue;
+    std::deque<std::unique_ptr<ovrTextureLoadJob>> UploadQueue;
+    std::vector<std::thread> DecodeThreads;
+    bool ExitDecodeThreads;
+
     mutable int NumUriLoads;
     mutable int NumActualUriLoads;
     mutable int NumBufferLoads;
@@ -124,6 +193,22 @@ class ovrTextureManagerImpl : public ovrTextureManager {
     int IndexForHandle(textureHandle_t const handle) const;
     textureHandle_t AllocTexture();
 
+    textureHandle_t StartAsyncLoad(
+        char const* uri,
+        std::unique_ptr<ovrTextureLoadJob> job,
+        ovrTextureFilter const filterType,
+        ovrTextureWrap const wrapType,
+        ovrTextureLoadCallback const& callback);
+    bool AddLoadCallback(int const idx, ovrTextureLoadCallback const& callback);
+    void CompleteLoad(
+        int const idx,
+        GlTexture tex,
+        ovrTextureFilter const filterType,
+        ovrTextureWrap const wrapType);
+    void Notify(textureHandle_t const handle, bool const success, ovrTextureLoadCallback callback);
+    void DecodeThreadFunction();
+    void StopDecodeThreads();
+
     static void SetTextureWrapping(GlTexture& tex, ovrTextureWrap const wrapType);
     static void SetTextureFiltering(GlTexture& tex, ovrTextureFilter const filterType);
 };
@@ -132,6 +217,9 @@ class ovrTextureManagerImpl : public ovrTextureManager {
 // ovrTextureManagerImpl::
 ovrTextureManagerImpl::ovrTextureManagerImpl()
     : Initialized(false),
+      NextJobId(0),
+      UploadBudget(4 * 1024 * 1024),
+      ExitDecodeThreads(false),
       NumUriLoads(0),
       NumActualUriLoads(0),
       NumBufferLoads(0),
@@ -157,6 +245,11 @@ void ovrTextureManagerImpl::Init() {
 //==============================
 // ovrTextureManagerImpl::
 void ovrTextureManagerImpl::Shutdown() {
+    StopDecodeThreads();
+    PendingLoads.clear();
+    Notifications.clear();
+    DeleteTexture(Placeholder);
+
     for (auto& texture : Textures) {
         if (texture.IsValid()) {
             texture.Free();
@@ -164,6 +257,7 @@ void ovrTextureManagerImpl::Shutdown() {
     }
 
     Textures.resize(0);
+    LoadStates.resize(0);
     FreeTextures.resize(0);
     UriHash.clear();
 
@@ -173,7 +267,7 @@ void ovrTextureManagerImpl::Shutdown() {
 //==============================
 // ovrTextureManagerImpl::SetTextureWrapping
 void ovrTextureManagerImpl::SetTextureWrapping(GlTexture& tex, ovrTextureWrap const wrapType) {
-    /// OVR_PERF_TIMER( SetTextureWrapping );
+    OVR_PERF_TIMER(SetTextureWrapping);
     switch (wrapType) {
         case WRAP_DEFAULT:
             return;
@@ -192,7 +286,7 @@ void ovrTextureManagerImpl::SetTextureWrapping(GlTexture& tex, ovrTextureWrap co
 //==============================
 // ovrTextureManagerImpl::SetTextureFiltering
 void ovrTextureManagerImpl::SetTextureFiltering(GlTexture& tex, ovrTextureFilter const filterType) {
-    /// OVR_PERF_TIMER( SetTextureFiltering );
+    OVR_PERF_TIMER(SetTextureFiltering);
     switch (filterType) {
         case FILTER_DEFAULT:
             return;
@@ -229,12 +323,12 @@ textureHandle_t ovrTextureManagerImpl::LoadTexture(
     char const* uri,
     ovrTextureFilter const filterType,
     ovrTextureWrap const wrapType) {
-    /// OVR_PERF_TIMER( LoadTexture_FromFile );
+    OVR_PERF_TIMER(LoadTexture_FromFile);
 
     NumUriLoads++;
 
     int idx = FindTextureIndex(uri);
-    if (idx >= 0) {
+    if (idx >= 0 && LoadStates[idx] != LOAD_STATE_PENDING) {
         return Textures[idx].GetHandle();
     }
 
@@ -246,6 +340,12 @@ textureHandle_t ovrTextureManagerImpl::LoadTexture(
         return textureHandle_t();
     }
 
+    if (idx >= 0) {
+        // the caller needs the texture now, so finish the pending asynchronous load with it
+        CompleteLoad(idx, tex, filterType, wrapType);
+        return Textures[idx].GetHandle();
+    }
+
     textureHandle_t handle = AllocTexture();
     if (handle.IsValid()) {
         SetTextureWrapping(tex, wrapType);
@@ -253,6 +353,7 @@ textureHandle_t ovrTextureManagerImpl::LoadTexture(
 
         idx = IndexForHandle(handle);
         Textures[idx] = ovrManagedTexture(handle, uri, tex);
+        LoadStates[idx] = LOAD_STATE_LOADED;
         UriHash[std::string(uri)] = idx;
 
         NumActualUriLoads++;
@@ -269,12 +370,12 @@ textureHandle_t ovrTextureManagerImpl::LoadTexture(
     size_t const bufferSize,
     ovrTextureFilter const filterType,
     ovrTextureWrap const wrapType) {
-    /// OVR_PERF_TIMER( LoadTexture_FromBuffer );
+    OVR_PERF_TIMER(LoadTexture_FromBuffer);
 
     NumBufferLoads++;
 
     int idx = FindTextureIndex(uri);
-    if (idx >= 0) {
+    if (idx >= 0 && LoadStates[idx] != LOAD_STATE_PENDING) {
         return Textures[idx].GetHandle();
     }
 
@@ -298,16 +399,22 @@ textureHandle_t ovrTextureManagerImpl::LoadTexture(
         return textureHandle_t();
     }
 
+    if (idx >= 0) {
+        CompleteLoad(idx, tex, filterType, wrapType);
+        return Textures[idx].GetHandle();
+    }
+
     textureHandle_t handle = AllocTexture();
     if (handle.IsValid()) {
-        /// OVR_PERF_TIMER( LoadTexture_FromBuffer_IsValid );
+        OVR_PERF_TIMER(LoadTexture_FromBuffer_IsValid);
         SetTextureWrapping(tex, wrapType);
         SetTextureFiltering(tex, filterType);
 
         idx = IndexForHandle(handle);
         Textures[idx] = ovrManagedTexture(handle, uri, tex);
+        LoadStates[idx] = LOAD_STATE_LOADED;
         {
-            /// OVR_PERF_TIMER( LoadTexture_FromBuffer_Hash );
+            OVR_PERF_TIMER(LoadTexture_FromBuffer_Hash);
             UriHash[std::string(uri)] = idx;
         }
 
@@ -326,7 +433,7 @@ textureHandle_t ovrTextureManagerImpl::LoadRGBATexture(
     int const imageHeight,
     ovrTextureFilter const filterType,
     ovrTextureWrap const wrapType) {
-    /// OVR_PERF_TIMER( LoadRGBATexture_uri );
+    OVR_PERF_TIMER(LoadRGBATexture_uri);
 
     ALOG("LoadRGBATexture: uri = '%s' ", uri);
 
@@ -342,7 +449,7 @@ textureHandle_t ovrTextureManagerImpl::LoadRGBATexture(
 
     GlTexture tex;
     {
-        /// OVR_PERF_TIMER( LoadRGBATexture_uri_LoadRGBATextureFromMemory );
+        OVR_PERF_TIMER(LoadRGBATexture_uri_LoadRGBATextureFromMemory);
         tex = LoadRGBATextureFromMemory(
             static_cast<const unsigned char*>(imageData), imageWidth, imageHeight, false);
         if (!tex.IsValid()) {
@@ -354,14 +461,15 @@ textureHandle_t ovrTextureManagerImpl::LoadRGBATexture(
 
     textureHandle_t handle = AllocTexture();
     if (handle.IsValid()) {
-        /// OVR_PERF_TIMER( LoadRGBATexture_uri_IsValid );
+        OVR_PERF_TIMER(LoadRGBATexture_uri_IsValid);
         SetTextureWrapping(tex, wrapType);
         SetTextureFiltering(tex, filterType);
 
         idx = IndexForHandle(handle);
         Textures[idx] = ovrManagedTexture(handle, uri, tex);
+        LoadStates[idx] = LOAD_STATE_LOADED;
         {
-            /// OVR_PERF_TIMER( LoadRGBATexture_uri_Hash );
+            OVR_PERF_TIMER(LoadRGBATexture_uri_Hash);
             UriHash[std::string(uri)] = idx;
         }
         NumActualBufferLoads++;
@@ -378,7 +486,7 @@ textureHandle_t ovrTextureManagerImpl::LoadRGBATexture(
     int const imageHeight,
     ovrTextureFilter const filterType,
     ovrTextureWrap const wrapType) {
-    /// OVR_PERF_TIMER( LoadRGBATexture_icon );
+    OVR_PERF_TIMER(LoadRGBATexture_icon);
 
     NumBufferLoads++;
     if (imageData == nullptr || imageWidth <= 0 || imageHeight <= 0) {
@@ -392,7 +500,7 @@ textureHandle_t ovrTextureManagerImpl::LoadRGBATexture(
 
     GlTexture tex;
     {
-        /// OVR_PERF_TIMER( LoadRGBATexture_icon_LoadRGBATextureFromMemory );
+        OVR_PERF_TIMER(LoadRGBATexture_icon_LoadRGBATextureFromMemory);
         tex = LoadRGBATextureFromMemory(
             static_cast<const unsigned char*>(imageData), imageWidth, imageHeight, false);
         if (!tex.IsValid()) {
@@ -409,12 +517,293 @@ textureHandle_t ovrTextureManagerImpl::LoadRGBATexture(
 
         idx = IndexForHandle(handle);
         Textures[idx] = ovrManagedTexture(handle, iconId, tex);
+        LoadStates[idx] = LOAD_STATE_LOADED;
 
         NumActualBufferLoads++;
     }
     return handle;
 }
 
+//==============================
+// ovrTextureManagerImpl::LoadTextureAsync
+textureHandle_t ovrTextureManagerImpl::LoadTextureAsync(
+    ovrFileSys& fileSys,
+    char const* uri,
+    ovrTextureFilter const filterType,
+    ovrTextureWrap const wrapType,
+    ovrTextureLoadCallback const& callback) {
+    NumUriLoads++;
+
+    int idx = FindTextureIndex(uri);
+    if (idx >= 0 && AddLoadCallback(idx, callback)) {
+        return Textures[idx].GetHandle();
+    }
+
+    std::unique_ptr<ovrTextureLoadJob> job(new ovrTextureLoadJob());
+    job->FileSys = &fileSys;
+    return StartAsyncLoad(uri, std::move(job), filterType, wrapType, callback);
+}
+
+//==============================
+// ovrTextureManagerImpl::LoadTextureAsync
+textureHandle_t ovrTextureManagerImpl::LoadTextureAsync(
+    char const* uri,
+    void const* buffer,
+    size_t const bufferSize,
+    ovrTextureFilter const filterType,
+    ovrTextureWrap const wrapType,
+    ovrTextureLoadCallback const& callback) {
+    NumBufferLoads++;
+
+    int idx = FindTextureIndex(uri);
+    if (idx >= 0 && AddLoadCallback(idx, callback)) {
+        return Textures[idx].GetHandle();
+    }
+    if (buffer == nullptr || bufferSize == 0) {
+        return textureHandle_t();
+    }
+
+    std::unique_ptr<ovrTextureLoadJob> job(new ovrTextureLoadJob());
+    uint8_t const* bytes = static_cast<uint8_t const*>(buffer);
+    job->Buffer.assign(bytes, bytes + bufferSize);
+    return StartAsyncLoad(uri, std::move(job), filterType, wrapType, callback);
+}
+
+//==============================
+// ovrTextureManagerImpl::AddLoadCallback
+// Returns false if the texture at idx failed to load, so it should be loaded again. The callback
+// of a texture that is already loaded is called by the next Update(), like any other.
+bool ovrTextureManagerImpl::AddLoadCallback(int const idx, ovrTextureLoadCallback const& callback) {
+    if (LoadStates[idx] == LOAD_STATE_FAILED) {
+        return false;
+    }
+    if (callback) {
+        if (LoadStates[idx] == LOAD_STATE_PENDING) {
+            PendingLoads[idx].Callbacks.push_back(callback);
+        } else {
+            Notify(Textures[idx].GetHandle(), true, callback);
+        }
+    }
+    return true;
+}
+
+//==============================
+// ovrTextureManagerImpl::Notify
+void ovrTextureManagerImpl::Notify(
+    textureHandle_t const handle,
+    bool const success,
+    ovrTextureLoadCallback callback) {
+    ovrLoadNotification notification;
+    notification.Handle = handle;
+    notification.Success = success;
+    notification.Callback = std::move(callback);
+    Notifications.push_back(std::move(notification));
+}
+
+//==============================
+// ovrTextureManagerImpl::StartAsyncLoad
+textureHandle_t ovrTextureManagerImpl::StartAsyncLoad(
+    char const* uri,
+    std::unique_ptr<ovrTextureLoadJob> job,
+    ovrTextureFilter const filterType,
+    ovrTextureWrap const wrapType,
+    ovrTextureLoadCallback const& callback) {
+    if (!Placeholder.IsValid()) {
+        uint8_t const transparent[4] = {0, 0, 0, 0};
+        Placeholder = LoadRGBATextureFromMemory(transparent, 1, 1, false);
+    }
+
+    textureHandle_t handle = AllocTexture();
+    if (!handle.IsValid()) {
+        return handle;
+    }
+
+    int const idx = IndexForHandle(handle);
+    Textures[idx] = ovrManagedTexture(handle, uri, GlTexture());
+    LoadStates[idx] = LOAD_STATE_PENDING;
+    UriHash[std::string(uri)] = idx;
+
+    ovrPendingLoad& pending = PendingLoads[idx];
+    pending.JobId = ++NextJobId;
+    pending.FromUri = job->FileSys != nullptr;
+    pending.FilterType = filterType;
+    pending.WrapType = wrapType;
+    pending.Callbacks.clear();
+    if (callback) {
+        pending.Callbacks.push_back(callback);
+    }
+
+    job->Index = idx;
+    job->JobId = pending.JobId;
+    job->Uri = uri;
+    {
+        std::lock_guard<std::mutex> lock(JobMutex);
+        if (DecodeThreads.empty()) {
+            // decoding is mostly file IO and stb / basis transcoding, two threads keep up with
+            // the upload budget without competing with the frame jobs
+            int const numThreads = std::max(1, std::min(2, GetNumWorkerThreads()));
+            for (int i = 0; i < numThreads; ++i) {
+                DecodeThreads.emplace_back(&ovrTextureManagerImpl::DecodeThreadFunction, this);
+            }
+        }
+        DecodeQueue.push_back(std::move(job));
+    }
+    JobAvailable.notify_one();
+
+    return handle;
+}
+
+//==============================
+// ovrTextureManagerImpl::DecodeThreadFunction
+void ovrTextureManagerImpl::DecodeThreadFunction() {
+    for (;;) {
+        std::unique_ptr<ovrTextureLoadJob> job;
+        {
+            std::unique_lock<std::mutex> lock(JobMutex);
+            JobAvailable.wait(lock, [this] { return ExitDecodeThreads || !DecodeQueue.empty(); });
+            if (ExitDecodeThreads) {
+                return;
+            }
+            job = std::move(DecodeQueue.front());
+            DecodeQueue.pop_front();
+        }
+
+        bool haveData = true;
+        if (job->FileSys != nullptr) {
+            haveData = job->FileSys->ReadFile(job->Uri.c_str(), job->Buffer);
+        }
+        if (haveData) {
+            job->Success = DecodeTextureFromBuffer(
+                job->Uri.c_str(),
+                std::move(job->Buffer),
+                TextureFlags_t(TEXTUREFLAG_NO_DEFAULT),
+                job->Decoded);
+        }
+
+        std::lock_guard<std::mutex> lock(JobMutex);
+        UploadQueue.push_back(std::move(job));
+    }
+}
+
+//==============================
+// ovrTextureManagerImpl::StopDecodeThreads
+void ovrTextureManagerImpl::StopDecodeThreads() {
+    {
+        std::lock_guard<std::mutex> lock(JobMutex);
+        ExitDecodeThreads = true;
+    }
+    JobAvailable.notify_all();
+    for (auto& thread : DecodeThreads) {
+        thread.join();
+    }
+    DecodeThreads.clear();
+    DecodeQueue.clear();
+    UploadQueue.clear();
+    ExitDecodeThreads = false;
+}
+
+//==============================
+// ovrTextureManagerImpl::Update
+void ovrTextureManagerImpl::Update() {
+    size_t uploadedBytes = 0;
+    for (;;) {
+        std::unique_ptr<ovrTextureLoadJob> job;
+        {
+            std::lock_guard<std::mutex> lock(JobMutex);
+            if (UploadQueue.empty()) {
+                break;
+            }
+            // always upload at least one texture, so a texture over the budget can't stall
+            size_t const uploadSize = UploadQueue.front()->Decoded.GetUploadSize();
+            if (uploadedBytes > 0 && uploadedBytes + uploadSize > UploadBudget) {
+                break;
+            }
+            job = std::move(UploadQueue.front());
+            UploadQueue.pop_front();
+        }
+
+        auto it = PendingLoads.find(job->Index);
+        if (it == PendingLoads.end() || it->second.JobId != job->JobId) {
+            continue; // freed or loaded synchronously in the meantime
+        }
+
+        GlTexture tex;
+        if (job->Success) {
+            tex = CreateTextureFromDecoded(job->Decoded);
+            uploadedBytes += job->Decoded.GetUploadSize();
+        }
+        if (!tex.IsValid()) {
+            ALOG("LoadTextureAsync( '%s' ) failed!", job->Uri.c_str());
+        }
+        CompleteLoad(job->Index, tex, it->second.FilterType, it->second.WrapType);
+    }
+
+    // Callbacks may load or free textures, which queues callbacks for the next Update().
+    std::vector<ovrLoadNotification> notifications;
+    notifications.swap(Notifications);
+    for (auto const& notification : notifications) {
+        notification.Callback(notification.Handle, notification.Success);
+    }
+}
+
+//==============================
+// ovrTextureManagerImpl::CompleteLoad
+void ovrTextureManagerImpl::CompleteLoad(
+    int const idx,
+    GlTexture tex,
+    ovrTextureFilter const filterType,
+    ovrTextureWrap const wrapType) {
+    ovrPendingLoad pending;
+    auto it = PendingLoads.find(idx);
+    if (it != PendingLoads.end()) {
+        pending = std::move(it->second);
+        PendingLoads.erase(it);
+    }
+
+    textureHandle_t const handle = Textures[idx].GetHandle();
+    std::string const uri = Textures[idx].GetUri();
+    bool const success = tex.IsValid();
+    if (success) {
+        SetTextureWrapping(tex, wrapType);
+        SetTextureFiltering(tex, filterType);
+        Textures[idx] = ovrManagedTexture(handle, uri.c_str(), tex);
+        LoadStates[idx] = LOAD_STATE_LOADED;
+        if (pending.FromUri) {
+            NumActualUriLoads++;
+        } else {
+            NumActualBufferLoads++;
+        }
+    } else {
+        // the handle stays allocated until it is freed, but a new load of the uri tries again
+        LoadStates[idx] = LOAD_STATE_FAILED;
+        auto hashIt = UriHash.find(uri);
+        if (hashIt != UriHash.end() && hashIt->second == idx) {
+            UriHash.erase(hashIt);
+        }
+    }
+
+    for (auto& callback : pending.Callbacks) {
+        Notify(handle, success, std::move(callback));
+    }
+}
+
+//==============================
+// ovrTextureManagerImpl::SetUploadBudget
+void ovrTextureManagerImpl::SetUploadBudget(size_t const bytesPerFrame) {
+    UploadBudget = bytesPerFrame;
+}
+
+//==============================
+// ovrTextureManagerImpl::GetLoadState
+ovrTextureManager::ovrTextureLoadState ovrTextureManagerImpl::GetLoadState(
+    textureHandle_t const handle) const {
+    int idx = IndexForHandle(handle);
+    if (idx < 0 || idx >= static_cast<int>(LoadStates.size())) {
+        return LOAD_STATE_INVALID;
+    }
+    return LoadStates[idx];
+}
+
 //==============================
 // ovrTextureManagerImpl::GetTexture
 ovrManagedTexture ovrTextureManagerImpl::GetTexture(textureHandle_t const handle) const {
@@ -422,6 +811,9 @@ ovrManagedTexture ovrTextureManagerImpl::GetTexture(textureHandle_t const handle
     if (idx < 0) {
         return ovrManagedTexture();
     }
+    if (LoadStates[idx] == LOAD_STATE_PENDING) {
+        return ovrManagedTexture(handle, Textures[idx].GetUri().c_str(), Placeholder);
+    }
     return Textures[idx];
 }
 
@@ -432,6 +824,9 @@ GlTexture ovrTextureManagerImpl::GetGlTexture(textureHandle_t const handle) cons
     if (idx < 0) {
         return GlTexture();
     }
+    if (LoadStates[idx] == LOAD_STATE_PENDING) {
+        return Placeholder;
+    }
     return Textures[idx].GetTexture();
 }
 
@@ -440,9 +835,21 @@ GlTexture ovrTextureManagerImpl::GetGlTexture(textureHandle_t const handle) cons
 void ovrTextureManagerImpl::FreeTexture(textureHandle_t const handle) {
     int idx = IndexForHandle(handle);
     if (idx >= 0) {
-        if (Textures[idx].GetUri().empty()) {
-            UriHash.erase(Textures[idx].GetUri());
+        if (!Textures[idx].GetUri().empty()) {
+            auto it = UriHash.find(Textures[idx].GetUri());
+            if (it != UriHash.end() && it->second == idx) {
+                UriHash.erase(it);
+            }
         }
+        // a pending load is dropped by Update() once its job id no longer matches
+        PendingLoads.erase(idx);
+        Notifications.erase(
+            std::remove_if(
+                Notifications.begin(),
+                Notifications.end(),
+                [handle](ovrLoadNotification const& n) { return n.Handle == handle; }),
+            Notifications.end());
+        LoadStates[idx] = LOAD_STATE_INVALID;
         Textures[idx].Free();
         FreeTextures.push_back(idx);
     }
@@ -451,7 +858,7 @@ void ovrTextureManagerImpl::FreeTexture(textureHandle_t const handle) {
 //==============================
 // ovrTextureManagerImpl::FindTextureIndex
 int ovrTextureManagerImpl::FindTextureIndex(char const* uri) const {
-    /// OVR_PERF_TIMER( FindTextureIndex_uri );
+    OVR_PERF_TIMER(FindTextureIndex_uri);
 
     NumStringSearches++;
 
@@ -476,7 +883,7 @@ int ovrTextureManagerImpl::FindTextureIndex(char const* uri) const {
 //==============================
 // ovrTextureManagerImpl::FindTextureIndex
 int ovrTextureManagerImpl::FindTextureIndex(int const iconId) const {
-    /// OVR_PERF_TIMER( FindTextureIndex_iconId );
+    OVR_PERF_TIMER(FindTextureIndex_iconId);
 
     NumSearches++;
     if (!Textures.empty()) {
@@ -504,17 +911,19 @@ int ovrTextureManagerImpl::IndexForHandle(textureHandle_t const handle) const {
 //==============================
 // ovrTextureManagerImpl::AllocTexture
 textureHandle_t ovrTextureManagerImpl::AllocTexture() {
-    /// OVR_PERF_TIMER( AllocTexture );
+    OVR_PERF_TIMER(AllocTexture);
 
     if (!FreeTextures.empty()) {
         int idx = FreeTextures[static_cast<int>(FreeTextures.size()) - 1];
         FreeTextures.pop_back();
         Textures[idx] = ovrManagedTexture();
+        LoadStates[idx] = LOAD_STATE_INVALID;
         return textureHandle_t(idx);
     }
 
     int idx = static_cast<int>(Textures.size());
     Textures.push_back(ovrManagedTexture());
+    LoadStates.push_back(LOAD_STATE_INVALID);
 
     return textureHandle_t(idx);
 }
@@ -30,6 +30,7 @@ Authors     :   Jonathan E. Wright
 #include "OVR_TypesafeNumber.h"
 #include "GlTexture.h"
 
+#include <functional>
 #include <string>
 
 namespace OVRFW {
@@ -92,6 +93,18 @@ class ovrTextureManager {
         FILTER_MIPMAP_ANISOTROPIC16
 
     };
+    enum ovrTextureLoadState {
+        LOAD_STATE_INVALID, // the handle does not refer to a texture
+        LOAD_STATE_PENDING, // being decoded or waiting for upload, the placeholder is returned
+        LOAD_STATE_LOADED,
+        LOAD_STATE_FAILED // the handle stays allocated until it is freed
+    };
+
+    // Called from Update() when an asynchronous load completes or fails. A callback passed for a
+    // texture that is already loaded, or for a load that a synchronous load finishes, is also
+    // called by the next Update(), never from the load call itself.
+    using ovrTextureLoadCallback =
+        std::function<void(textureHandle_t const handle, bool const success)>;
 
     virtual ~ovrTextureManager() {}
 
@@ -127,6 +140,34 @@ class ovrTextureManager {
         ovrTextureFilter const filterType = FILTER_DEFAULT,
         ovrTextureWrap const wrapType = WRAP_DEFAULT) = 0;
 
+    // Asynchronous loads return a handle immediately. The file is read and decoded on a worker
+    // thread and the texture is created by Update(). Until then GetTexture() and GetGlTexture()
+    // return a 1x1 transparent placeholder. A synchronous load of the same uri finishes the load
+    // immediately. Freeing a pending handle cancels the load and its callbacks.
+    // Like the synchronous loads, these must be called on the GL thread: the first one creates the
+    // placeholder texture.
+    virtual textureHandle_t LoadTextureAsync(
+        class ovrFileSys& fileSys,
+        char const* uri,
+        ovrTextureFilter const filterType = FILTER_DEFAULT,
+        ovrTextureWrap const wrapType = WRAP_DEFAULT,
+        ovrTextureLoadCallback const& callback = nullptr) = 0;
+    // The buffer is copied, so the caller can free it as soon as this returns.
+    virtual textureHandle_t LoadTextureAsync(
+        char const* uri,
+        void const* buffer,
+        size_t const bufferSize,
+        ovrTextureFilter const filterType = FILTER_DEFAULT,
+        ovrTextureWrap const wrapType = WRAP_DEFAULT,
+        ovrTextureLoadCallback const& callback = nullptr) = 0;
+
+    // Creates the textures decoded since the last call, until the per-frame upload budget is
+    // used, then calls the load callbacks. At least one texture is created per call. Must be
+    // called on the GL thread.
+    virtual void Update() = 0;
+    virtual void SetUploadBudget(size_t const bytesPerFrame) = 0;
+    virtual ovrTextureLoadState GetLoadState(textureHandle_t const handle) const = 0;
+
     virtual void FreeTexture(textureHandle_t const handle) = 0;
 
     virtual ovrManagedTexture GetTexture(textureHandle_t const handle) const = 0;
@@ -30,6 +30,13 @@ Language    :   C++
 
 #include "time.h"
 
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
 namespace OVRFW {
 
 double GetTimeInSeconds() {
@@ -42,4 +49,113 @@ double GetTimeInSeconds() {
     return (now.tv_sec * 1e9 + now.tv_nsec) * 0.000000001;
 }
 
+int GetNumWorkerThreads() {
+    static const int numThreads = std::max(1, (int)std::thread::hardware_concurrency());
+    return numThreads;
+}
+
+// Worker threads are started on the first ParallelFor and live until the process exits.
+class ovrWorkerPool {
+   public:
+    ovrWorkerPool() {
+        for (int i = 1; i < GetNumWorkerThreads(); i++) {
+            Workers.emplace_back([this]() { WorkerThread(); });
+        }
+    }
+
+    ~ovrWorkerPool() {
+        {
+            std::lock_guard<std::mutex> lock(Mutex);
+            Exit = true;
+        }
+        WorkAvailable.notify_all();
+        for (auto& worker : Workers) {
+            worker.join();
+        }
+    }
+
+    bool TryRun(const int count, const std::function<void(int index)>& job) {
+        std::unique_lock<std::mutex> busy(BusyMutex, std::try_to_lock);
+        if (!busy.owns_lock()) {
+            return false;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(Mutex);
+            Job = &job;
+            Count = count;
+            Next = 0;
+            Active = static_cast<int>(Workers.size());
+            Generation++;
+        }
+        WorkAvailable.notify_all();
+
+        RunJobs(job, count);
+
+        std::unique_lock<std::mutex> lock(Mutex);
+        WorkDone.wait(lock, [this]() { return Active == 0; });
+        Job = nullptr;
+        return true;
+    }
+
+   private:
+    // Jobs can vary a lot in cost, so hand out one index at a time instead of fixed ranges.
+    void RunJobs(const std::function<void(int index)>& job, const int count) {
+        for (int i = Next++; i < count; i = Next++) {
+            job(i);
+        }
+    }
+
+    void WorkerThread() {
+        int lastGeneration = 0;
+        for (;;) {
+            const std::function<void(int index)>* job = nullptr;
+            int count = 0;
+            {
+                std::unique_lock<std::mutex> lock(Mutex);
+                WorkAvailable.wait(lock, [this, lastGeneration]() {
+                    return Exit || Generation != lastGeneration;
+                });
+                if (Exit) {
+                    return;
+                }
+                lastGeneration = Generation;
+                job = Job;
+                count = Count;
+            }
+
+            RunJobs(*job, count);
+
+            std::lock_guard<std::mutex> lock(Mutex);
+            if (--Active == 0) {
+                WorkDone.notify_one();
+            }
+        }
+    }
+
+    std::vector<std::thread> Workers;
+    std::mutex BusyMutex;
+    std::mutex Mutex;
+    std::condition_variable WorkAvailable;
+    std::condition_variable WorkDone;
+    const std::function<void(int index)>* Job = nullptr;
+    int Count = 0;
+    std::atomic<int> Next{0};
+    int Active = 0;
+    int Generation = 0;
+    bool Exit = false;
+};
+
+void ParallelFor(const int count, const std::function<void(int index)>& job) {
+    if (count > 1 && GetNumWorkerThreads() > 1) {
+        static ovrWorkerPool pool;
+        if (pool.TryRun(count, job)) {
+            return;
+        }
+    }
+    for (int i = 0; i < count; i++) {
+        job(i);
+    }
+}
+
 } // namespace OVRFW
@@ -30,8 +30,19 @@ Language	:   C++
 
 #include "Misc/Log.h"
 
+#include <functional>
+
 namespace OVRFW {
 
 double GetTimeInSeconds();
 
+// Number of threads ParallelFor will use, including the calling thread.
+int GetNumWorkerThreads();
+
+// Calls job( index ) for every index in [0, count) spread over the calling thread and a pool of
+// GetNumWorkerThreads() - 1 worker threads. Returns when all jobs have finished. If the pool is
+// already busy with another ParallelFor, the jobs run on the calling thread instead.
+// Jobs must not touch GL state or anything else bound to the calling thread.
+void ParallelFor(const int count, const std::function<void(int index)>& job);
+
 } // namespace OVRFW
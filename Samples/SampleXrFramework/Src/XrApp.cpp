@@ -27,6 +27,8 @@ Language    :   c++
 *******************************************************************************/
 
 #include "XrApp.h"
+#include "OVR_PerfTimer.h"
+#include "Render/GlStreamBuffer.h"
 
 #if defined(ANDROID)
 #include <android/window.h>
@@ -1126,6 +1128,7 @@ void XrApp::EndSession() {
     SessionEnd();
     OXR(xrDestroySession(Session));
 
+    OVRFW::GetVertexStreamBuffer().Destroy();
     ovrEgl_DestroyContext(&Egl);
 }
 
@@ -1371,9 +1374,13 @@ void XrApp::AppRenderFrame(const OVRFW::ovrApplFrameIn& in, OVRFW::ovrRendererOu
         localIn.RightRemoteJoystick.x = 0.0f;
         localIn.RightRemoteJoystick.y = 0.0f;
     }
-    Scene.Frame(localIn);
-    Scene.GenerateFrameSurfaceList(out.FrameMatrices, out.Surfaces);
+    {
+        OVR_PERF_TIMER(XrApp_SceneFrame);
+        Scene.Frame(localIn);
+        Scene.GenerateFrameSurfaceList(out.FrameMatrices, out.Surfaces);
+    }
     if (ShouldRender) {
+        OVR_PERF_TIMER(XrApp_Render);
         Render(in, out);
     }
 
@@ -1383,7 +1390,10 @@ void XrApp::AppRenderFrame(const OVRFW::ovrApplFrameIn& in, OVRFW::ovrRendererOu
         ovrFramebuffer_SetCurrent(frameBuffer);
 
         AppEyeGLStateSetup(in, frameBuffer, eye);
-        AppRenderEye(in, out, eye);
+        {
+            OVR_PERF_TIMER(XrApp_RenderEye);
+            AppRenderEye(in, out, eye);
+        }
 
         ovrFramebuffer_Resolve(frameBuffer);
         ovrFramebuffer_Release(frameBuffer);
@@ -1521,16 +1531,22 @@ void XrApp::MainLoop(MainLoopContext& loopContext) {
 
     while (!loopContext.ShouldExitMainLoop()) {
         frameCount++;
+        PerfTimersBeginFrame(frameCount);
 
         loopContext.HandleOsEvents();
 
-        HandleXrEvents();
+        {
+            OVR_PERF_TIMER(XrApp_HandleXrEvents);
+            HandleXrEvents();
+        }
 
         if (loopContext.IsExitRequested()) {
             break;
         }
 
         if (SessionActive == false) {
+            // a frame simulated for a stopped session is never submitted
+            FramePipeline.DropSimulatedFrame();
             continue;
         }
 
@@ -1542,114 +1558,183 @@ void XrApp::MainLoop(MainLoopContext& loopContext) {
             stageBoundsDirty = false;
         }
 
-        // NOTE: OpenXR does not use the concept of frame indices. Instead,
-        // XrWaitFrame returns the predicted display time.
-        XrFrameWaitInfo waitFrameInfo = {XR_TYPE_FRAME_WAIT_INFO};
+        // Returns with the simulation of the next pipelined frame done, so OS and OpenXR
+        // events are never handled during the simulation.
+        FramePipeline.RunFrame(frameCount, PipelinedFrames);
+    }
 
-        PreWaitFrame(waitFrameInfo);
+    FramePipeline.Stop();
+    EndSession();
+    Shutdown(loopContext.GetJavaContext());
+}
 
-        XrFrameState frameState = {XR_TYPE_FRAME_STATE};
+// Waits for the next frame into the slot.
+void XrApp::WaitFrame(const int slot) {
+    xrFrameSlot& frame = FrameSlots[slot];
 
-        OXR(xrWaitFrame(Session, &waitFrameInfo, &frameState));
+    // NOTE: OpenXR does not use the concept of frame indices. Instead,
+    // XrWaitFrame returns the predicted display time.
+    XrFrameWaitInfo waitFrameInfo = {XR_TYPE_FRAME_WAIT_INFO};
 
-        // Get the HMD pose, predicted for the middle of the time period during which
-        // the new eye images will be displayed. The number of frames predicted ahead
-        // depends on the pipeline depth of the engine and the synthesis rate.
-        // The better the prediction, the less black will be pulled in at the edges.
-        XrFrameBeginInfo beginFrameDesc = {XR_TYPE_FRAME_BEGIN_INFO};
-        OXR(xrBeginFrame(Session, &beginFrameDesc));
-        ShouldRender = frameState.shouldRender;
+    PreWaitFrame(waitFrameInfo);
 
-        XrSpaceLocation loc = {XR_TYPE_SPACE_LOCATION};
-        OXR(xrLocateSpace(HeadSpace, CurrentSpace, frameState.predictedDisplayTime, &loc));
-        XrPosef xfStageFromHead = loc.pose;
-        OXR(xrLocateSpace(HeadSpace, LocalSpace, frameState.predictedDisplayTime, &loc));
+    frame.FrameState = {XR_TYPE_FRAME_STATE};
 
-        XrViewState viewState = {XR_TYPE_VIEW_STATE};
+    {
+        OVR_PERF_TIMER(XrApp_xrWaitFrame);
+        OXR(xrWaitFrame(Session, &waitFrameInfo, &frame.FrameState));
+    }
+}
 
-        XrViewLocateInfo projectionInfo = {XR_TYPE_VIEW_LOCATE_INFO};
-        projectionInfo.viewConfigurationType = ViewportConfig.viewConfigurationType;
-        projectionInfo.displayTime = frameState.predictedDisplayTime;
-        projectionInfo.space = HeadSpace;
+void XrApp::BeginFrame(const int slot) {
+    XrFrameBeginInfo beginFrameDesc = {XR_TYPE_FRAME_BEGIN_INFO};
+    OXR(xrBeginFrame(Session, &beginFrameDesc));
+    ShouldRender = FrameSlots[slot].FrameState.shouldRender;
+}
 
-        uint32_t projectionCapacityInput = MAX_NUM_EYES;
-        uint32_t projectionCountOutput = projectionCapacityInput;
+// Locates the views of a frame that was waited for and runs the application Update for it.
+void XrApp::UpdateFrame(const int slot, const int64_t frameIndex) {
+    OVR_PERF_TIMER(XrApp_UpdateFrame);
+    xrFrameSlot& frame = FrameSlots[slot];
 
-        PreLocateViews(projectionInfo);
-        OXR(xrLocateViews(
-            Session,
-            &projectionInfo,
-            &viewState,
-            projectionCapacityInput,
-            &projectionCountOutput,
-            Projections));
-
-        OVRFW::ovrApplFrameIn in = {};
-        OVRFW::ovrRendererOutput out = {};
-        in.FrameIndex = frameCount;
-
-        /// time accounting
-        in.PredictedDisplayTime = FromXrTime(frameState.predictedDisplayTime);
-        if (PrevDisplayTime > 0) {
-            in.DeltaSeconds = FromXrTime(frameState.predictedDisplayTime - PrevDisplayTime);
-        }
-        PrevDisplayTime = frameState.predictedDisplayTime;
-
-        for (int eye = 0; eye < MAX_NUM_EYES; eye++) {
-            XrPosef xfHeadFromEye = Projections[eye].pose;
-            XrPosef xfStageFromEye{};
-            XrPosef_Multiply(&xfStageFromEye, &xfStageFromHead, &xfHeadFromEye);
-            XrPosef_Invert(&ViewTransform[eye], &xfStageFromEye);
-            XrMatrix4x4f viewMat{};
-            XrMatrix4x4f_CreateFromRigidTransform(&viewMat, &ViewTransform[eye]);
-            const XrFovf fov = Projections[eye].fov;
-            XrMatrix4x4f projMat;
-            XrMatrix4x4f_CreateProjectionFov(&projMat, GRAPHICS_OPENGL_ES, fov, 0.1f, 0.0f);
-            out.FrameMatrices.EyeView[eye] = FromXrMatrix4x4f(viewMat);
-            out.FrameMatrices.EyeProjection[eye] = FromXrMatrix4x4f(projMat);
-            in.Eye[eye].ViewMatrix = out.FrameMatrices.EyeView[eye];
-            in.Eye[eye].ProjectionMatrix = out.FrameMatrices.EyeProjection[eye];
-        }
+    const XrTime predictedDisplayTime = frame.FrameState.predictedDisplayTime;
+
+    // Get the HMD pose, predicted for the middle of the time period during which
+    // the new eye images will be displayed. The number of frames predicted ahead
+    // depends on the pipeline depth of the engine and the synthesis rate.
+    // The better the prediction, the less black will be pulled in at the edges.
+    XrSpaceLocation loc = {XR_TYPE_SPACE_LOCATION};
+    OXR(xrLocateSpace(HeadSpace, CurrentSpace, predictedDisplayTime, &loc));
+    XrPosef xfStageFromHead = loc.pose;
+    OXR(xrLocateSpace(HeadSpace, LocalSpace, predictedDisplayTime, &loc));
+
+    XrViewState viewState = {XR_TYPE_VIEW_STATE};
+
+    XrViewLocateInfo projectionInfo = {XR_TYPE_VIEW_LOCATE_INFO};
+    projectionInfo.viewConfigurationType = ViewportConfig.viewConfigurationType;
+    projectionInfo.displayTime = predictedDisplayTime;
+    projectionInfo.space = HeadSpace;
+
+    uint32_t projectionCapacityInput = MAX_NUM_EYES;
+    uint32_t projectionCountOutput = projectionCapacityInput;
+
+    for (int eye = 0; eye < MAX_NUM_EYES; eye++) {
+        frame.Projections[eye] = XrView{XR_TYPE_VIEW};
+    }
+
+    PreLocateViews(projectionInfo);
+    OXR(xrLocateViews(
+        Session,
+        &projectionInfo,
+        &viewState,
+        projectionCapacityInput,
+        &projectionCountOutput,
+        frame.Projections));
+
+    frame.In = {};
+    frame.Out.FrameMatrices = {};
+    frame.Out.Surfaces.clear();
+    OVRFW::ovrApplFrameIn& in = frame.In;
+    OVRFW::ovrRendererOutput& out = frame.Out;
+    in.FrameIndex = frameIndex;
+
+    /// time accounting
+    in.PredictedDisplayTime = FromXrTime(predictedDisplayTime);
+    if (PrevDisplayTime > 0) {
+        in.DeltaSeconds = FromXrTime(predictedDisplayTime - PrevDisplayTime);
+    }
+    PrevDisplayTime = predictedDisplayTime;
 
-        XrPosef centerView;
-        XrPosef_Invert(&centerView, &xfStageFromHead);
+    for (int eye = 0; eye < MAX_NUM_EYES; eye++) {
+        XrPosef xfHeadFromEye = frame.Projections[eye].pose;
+        XrPosef xfStageFromEye{};
+        XrPosef_Multiply(&xfStageFromEye, &xfStageFromHead, &xfHeadFromEye);
+        XrPosef_Invert(&frame.ViewTransform[eye], &xfStageFromEye);
         XrMatrix4x4f viewMat{};
-        XrMatrix4x4f_CreateFromRigidTransform(&viewMat, &centerView);
-        out.FrameMatrices.CenterView = FromXrMatrix4x4f(viewMat);
+        XrMatrix4x4f_CreateFromRigidTransform(&viewMat, &frame.ViewTransform[eye]);
+        const XrFovf fov = frame.Projections[eye].fov;
+        XrMatrix4x4f projMat;
+        XrMatrix4x4f_CreateProjectionFov(&projMat, GRAPHICS_OPENGL_ES, fov, 0.1f, 0.0f);
+        out.FrameMatrices.EyeView[eye] = FromXrMatrix4x4f(viewMat);
+        out.FrameMatrices.EyeProjection[eye] = FromXrMatrix4x4f(projMat);
+        in.Eye[eye].ViewMatrix = out.FrameMatrices.EyeView[eye];
+        in.Eye[eye].ProjectionMatrix = out.FrameMatrices.EyeProjection[eye];
+    }
 
-        // Input
+    XrPosef centerView;
+    XrPosef_Invert(&centerView, &xfStageFromHead);
+    XrMatrix4x4f viewMat{};
+    XrMatrix4x4f_CreateFromRigidTransform(&viewMat, &centerView);
+    out.FrameMatrices.CenterView = FromXrMatrix4x4f(viewMat);
+
+    // Input
+    {
+        OVR_PERF_TIMER(XrApp_HandleInput);
         HandleInput(in);
+    }
+}
 
-        LayerCount = 0;
-        memset(Layers, 0, sizeof(xrCompositorLayerUnion) * MAX_NUM_LAYERS);
+// Renders a frame that was begun and submits its layers.
+void XrApp::EndFrame(const int slot) {
+    OVR_PERF_TIMER(XrApp_EndFrame);
+    xrFrameSlot& frame = FrameSlots[slot];
 
-        // allow apps to submit a layer before the world view projection layer (uncommon)
-        PreProjectionAddLayer(Layers, LayerCount);
+    // The layer functions read the views of the frame being rendered.
+    for (int eye = 0; eye < MAX_NUM_EYES; eye++) {
+        Projections[eye] = frame.Projections[eye];
+        ViewTransform[eye] = frame.ViewTransform[eye];
+    }
 
-        // Render the world-view layer (projection)
-        AppRenderFrame(in, out);
-        ProjectionAddLayer(Layers, LayerCount);
+    LayerCount = 0;
+    memset(Layers, 0, sizeof(xrCompositorLayerUnion) * MAX_NUM_LAYERS);
 
-        // allow apps to submit a layer after the world view projection layer (uncommon)
-        PostProjectionAddLayer(Layers, LayerCount);
+    // allow apps to submit a layer before the world view projection layer (uncommon)
+    PreProjectionAddLayer(Layers, LayerCount);
 
-        // Compose the layers for this frame.
-        const XrCompositionLayerBaseHeader* layers[MAX_NUM_LAYERS] = {};
-        for (int i = 0; i < LayerCount; i++) {
-            layers[i] = (const XrCompositionLayerBaseHeader*)&Layers[i];
-        }
+    // Render the world-view layer (projection)
+    AppRenderFrame(frame.In, frame.Out);
+    // fence the vertices streamed for this frame so their space can be reused
+    OVRFW::GetVertexStreamBuffer().EndFrame();
+    ProjectionAddLayer(Layers, LayerCount);
+
+    // allow apps to submit a layer after the world view projection layer (uncommon)
+    PostProjectionAddLayer(Layers, LayerCount);
 
-        XrFrameEndInfo endFrameInfo = {XR_TYPE_FRAME_END_INFO};
-        endFrameInfo.displayTime = frameState.predictedDisplayTime;
-        endFrameInfo.environmentBlendMode = XR_ENVIRONMENT_BLEND_MODE_OPAQUE;
-        endFrameInfo.layerCount = LayerCount;
-        endFrameInfo.layers = layers;
-        PreEndFrame(endFrameInfo);
+    // Compose the layers for this frame.
+    const XrCompositionLayerBaseHeader* layers[MAX_NUM_LAYERS] = {};
+    for (int i = 0; i < LayerCount; i++) {
+        layers[i] = (const XrCompositionLayerBaseHeader*)&Layers[i];
+    }
+
+    XrFrameEndInfo endFrameInfo = {XR_TYPE_FRAME_END_INFO};
+    endFrameInfo.displayTime = frame.FrameState.predictedDisplayTime;
+    endFrameInfo.environmentBlendMode = XR_ENVIRONMENT_BLEND_MODE_OPAQUE;
+    endFrameInfo.layerCount = LayerCount;
+    endFrameInfo.layers = layers;
+    PreEndFrame(endFrameInfo);
+    {
+        OVR_PERF_TIMER(XrApp_xrEndFrame);
         OXR(xrEndFrame(Session, &endFrameInfo));
     }
+}
 
-    EndSession();
-    Shutdown(loopContext.GetJavaContext());
+void XrApp::SimulationThreadStart() {
+#if defined(ANDROID)
+    JNIEnv* env = nullptr;
+    if (Context.Vm != nullptr) {
+        (*Context.Vm).AttachCurrentThread(&env, nullptr);
+    }
+    // Note that AttachCurrentThread will reset the thread name.
+    prctl(PR_SET_NAME, (long)"XrApp::Sim", 0, 0, 0);
+#endif // defined(ANDROID)
+}
+
+void XrApp::SimulationThreadStop() {
+#if defined(ANDROID)
+    if (Context.Vm != nullptr) {
+        (*Context.Vm).DetachCurrentThread();
+    }
+#endif // defined(ANDROID)
 }
 
 void XrApp::ProjectionAddLayer(xrCompositorLayerUnion* layers, int& layerCount) {
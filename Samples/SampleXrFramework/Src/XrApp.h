@@ -39,6 +39,7 @@ Language    :   c++
 #include "System.h"
 #include "FrameParams.h"
 #include "OVR_FileSys.h"
+#include "FramePipeline.h"
 
 #include "Render/Egl.h"
 
@@ -281,7 +282,7 @@ class WindowsMainLoopContext : public MainLoopContext {
 };
 #endif
 
-class XrApp {
+class XrApp : private ovrFrameSteps {
    public:
     //============================
     // public interface
@@ -570,6 +571,24 @@ class XrApp {
     // Internal Render
     void RenderFrame(const ovrApplFrameIn& in, ovrRendererOutput& out);
 
+    // Everything needed to submit a frame once it has been simulated.
+    struct xrFrameSlot {
+        XrFrameState FrameState{XR_TYPE_FRAME_STATE};
+        XrView Projections[MAX_NUM_EYES];
+        XrPosef ViewTransform[MAX_NUM_EYES];
+        ovrApplFrameIn In;
+        ovrRendererOutput Out;
+    };
+
+    // The frame steps FramePipeline runs on FrameSlots. UpdateFrame locates the views and calls
+    // HandleInput, EndFrame calls AppRenderFrame and ends the frame with its layers.
+    void WaitFrame(const int slot) override;
+    void BeginFrame(const int slot) override;
+    void UpdateFrame(const int slot, const int64_t frameIndex) override;
+    void EndFrame(const int slot) override;
+    void SimulationThreadStart() override;
+    void SimulationThreadStop() override;
+
    public:
     OVR::Vector4f BackgroundColor;
     bool FreeMove{false};
@@ -601,6 +620,15 @@ class XrApp {
     // Note: This means input in ovrApplFrameIn won't be set
     bool SkipInputHandling = false;
 
+    // When set the simulation of the next frame (xrWaitFrame, input and Update()) runs on a
+    // separate thread while the current frame is rendered and submitted, so app CPU time no
+    // longer adds to the frame time. Update() then runs concurrently with AppRenderFrame() and
+    // Render() of the previous frame: it must not make GL calls, use the JNIEnv from the
+    // context, or modify state that rendering reads without double buffering it. When clear each
+    // frame is waited for, begun, updated and rendered in that order on the main thread.
+    // An app can set this in AppInit() or between frames.
+    bool PipelinedFrames = false;
+
     // An app can set this in AppInit() to change the resolution of the swapchain
     // allocated by the framework.
     float FramebufferResolutionScaleFactor{1.0f};
@@ -669,6 +697,10 @@ class XrApp {
     bool IsAppFocused = false;
     bool RunWhilePaused = false;
     bool ShouldRender = true;
+
+    // Frames are double buffered so one can be simulated while the other is submitted.
+    xrFrameSlot FrameSlots[ovrFramePipeline::MAX_FRAME_SLOTS];
+    ovrFramePipeline FramePipeline{*this};
 };
 
 } // namespace OVRFW
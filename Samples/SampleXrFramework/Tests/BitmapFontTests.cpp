@@ -0,0 +1,171 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * Licensed under the Oculus SDK License Agreement (the "License");
+ * you may not use the Oculus SDK except in compliance with the License,
+ * which is provided at the time of installation or download, or which
+ * otherwise accompanies this software in either electronic or hard copy form.
+ *
+ * You may obtain a copy of the License at
+ * https://developer.oculus.com/licenses/oculussdk/
+ *
+ * Unless required by applicable law or agreed to in writing, the Oculus SDK
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/************************************************************************************
+
+Filename    :   BitmapFontTests.cpp
+Content     :   Tests and benchmarks for the text layout cache of BitmapFontSurface.
+Language    :   C++
+
+*************************************************************************************/
+
+#include "FrameworkTest.h"
+
+#include "Render/BitmapFont.h"
+#include "OVR_FileSys.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace OVRFW;
+using OVR::Matrix4f;
+using OVR::Vector3f;
+using OVR::Vector4f;
+
+// Serves files from memory, which is all BitmapFont::Load needs.
+class ovrMemoryFileSys : public ovrFileSys {
+   public:
+    ovrStream* OpenStream(char const* uri, ovrStreamMode const mode) override {
+        return nullptr;
+    }
+    void CloseStream(ovrStream*& stream) override {}
+
+    bool ReadFile(char const* uri, std::vector<uint8_t>& outBuffer) override {
+        auto it = Files.find(uri);
+        if (it == Files.end()) {
+            return false;
+        }
+        outBuffer.assign(it->second.begin(), it->second.end());
+        return true;
+    }
+
+    bool FileExists(char const* uri) override {
+        return Files.find(uri) != Files.end();
+    }
+    bool GetLocalPathForURI(char const* uri, std::string& outputPath) override {
+        return false;
+    }
+
+    std::map<std::string, std::string> Files;
+};
+
+// A font with the printable ASCII glyphs, all the same size, and the given line height.
+static void AddFont(ovrMemoryFileSys& fileSys, const float fontHeight) {
+    std::string fnt = "{ \"Version\": 1, \"FontName\": \"test.fnt\", ";
+    fnt += "\"ImageFileName\": \"test.png\", \"NaturalWidth\": 512, \"NaturalHeight\": 512, ";
+    fnt += "\"FontHeight\": " + std::to_string(fontHeight) + ", \"NumGlyphs\": 95, \"Glyphs\": [";
+    for (int c = 32; c < 127; c++) {
+        const int x = (c - 32) % 16 * 32;
+        const int y = (c - 32) / 16 * 32;
+        fnt += (c > 32) ? ", " : "";
+        fnt += "{ \"CharCode\": " + std::to_string(c) + ", \"X\": " + std::to_string(x) +
+            ", \"Y\": " + std::to_string(y) +
+            ", \"Width\": 20, \"Height\": 24, \"AdvanceX\": 22, \"AdvanceY\": 0, "
+            "\"BearingX\": 1, \"BearingY\": 20 }";
+    }
+    fnt += "] }";
+    fileSys.Files["apk:///assets/test.fnt"] = fnt;
+    fileSys.Files["apk:///assets/test.png"] = "png";
+}
+
+static const char* FONT_URI = "apk:///assets/test.fnt";
+
+OVR_TEST(BitmapFont, ReloadedFontIsLaidOutAgain) {
+    ovrMemoryFileSys fileSys;
+    AddFont(fileSys, 24.0f);
+    BitmapFont* font = BitmapFont::Create();
+    OVR_CHECK(font->Load(fileSys, FONT_URI));
+
+    BitmapFontSurface* surface = BitmapFontSurface::Create();
+    surface->Init(1024);
+
+    const fontParms_t parms;
+    const Vector3f normal(0.0f, 0.0f, 1.0f);
+    const Vector3f up(0.0f, 1.0f, 0.0f);
+    const Vector4f color(1.0f);
+    const char* text = "first\nsecond";
+    const Vector3f first =
+        surface->DrawText3D(*font, parms, Vector3f(0.0f), normal, up, 1.0f, color, text);
+    const Vector3f cached =
+        surface->DrawText3D(*font, parms, Vector3f(1.0f), normal, up, 1.0f, color, text);
+    OVR_CHECK(first.y < 0.0f);
+    OVR_CHECK(cached == first);
+    surface->Finish(Matrix4f::Identity());
+
+    // Same font object and text, but twice the line height.
+    AddFont(fileSys, 48.0f);
+    OVR_CHECK(font->Load(fileSys, FONT_URI));
+    const Vector3f reloaded =
+        surface->DrawText3D(*font, parms, Vector3f(0.0f), normal, up, 1.0f, color, text);
+    OVR_CHECK_NEAR(reloaded.y, first.y * 2.0f, 1e-5f);
+    surface->Finish(Matrix4f::Identity());
+
+    BitmapFontSurface::Free(surface);
+    BitmapFont::Free(font);
+}
+
+// A panel of labels that don't change, the common case for menus. The first frame lays every
+// label out, the following ones reuse the cached layouts.
+OVR_BENCHMARK(BitmapFont, StaticStrings) {
+    ovrMemoryFileSys fileSys;
+    AddFont(fileSys, 24.0f);
+    BitmapFont* font = BitmapFont::Create();
+    font->Load(fileSys, FONT_URI);
+
+    const fontParms_t parms;
+    const Vector3f normal(0.0f, 0.0f, 1.0f);
+    const Vector3f up(0.0f, 1.0f, 0.0f);
+    const Vector4f color(1.0f);
+
+    for (const int count : {50, 200, 1000}) {
+        std::vector<std::string> labels(count);
+        for (int i = 0; i < count; i++) {
+            labels[i] = "Label " + std::to_string(i) + ": some static text";
+        }
+        auto drawFrame = [&](BitmapFontSurface* surface) {
+            for (int i = 0; i < count; i++) {
+                const Vector3f pos(static_cast<float>(i % 20), static_cast<float>(i / 20), -5.0f);
+                surface->DrawText3D(*font, parms, pos, normal, up, 1.0f, color, labels[i].c_str());
+            }
+            surface->Finish(Matrix4f::Identity());
+        };
+
+        const int runs = 20;
+        std::vector<BitmapFontSurface*> surfaces(runs);
+        for (BitmapFontSurface*& surface : surfaces) {
+            surface = BitmapFontSurface::Create();
+            surface->Init(1024);
+        }
+        int run = 0;
+        const double firstMs = OVRFW::Test::TimeBestOf(runs, [&]() { drawFrame(surfaces[run++]); });
+        const double cachedMs = OVRFW::Test::TimeBestOf(runs, [&]() { drawFrame(surfaces[0]); });
+        for (BitmapFontSurface*& surface : surfaces) {
+            BitmapFontSurface::Free(surface);
+        }
+
+        printf(
+            "%5d strings: first frame %7.3f ms, cached frame %7.3f ms (%.1fx)\n",
+            count,
+            firstMs,
+            cachedMs,
+            firstMs / cachedMs);
+    }
+
+    BitmapFont::Free(font);
+}
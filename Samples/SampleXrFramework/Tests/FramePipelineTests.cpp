@@ -0,0 +1,271 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * Licensed under the Oculus SDK License Agreement (the "License");
+ * you may not use the Oculus SDK except in compliance with the License,
+ * which is provided at the time of installation or download, or which
+ * otherwise accompanies this software in either electronic or hard copy form.
+ *
+ * You may obtain a copy of the License at
+ * https://developer.oculus.com/licenses/oculussdk/
+ *
+ * Unless required by applicable law or agreed to in writing, the Oculus SDK
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/************************************************************************************
+
+Filename    :   FramePipelineTests.cpp
+Content     :   Tests for the order of the frame steps against a fake OpenXR runtime.
+Language    :   C++
+
+*************************************************************************************/
+
+#include "FrameworkTest.h"
+
+#include "FramePipeline.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+using namespace OVRFW;
+
+// Stands in for xrWaitFrame, xrBeginFrame and xrEndFrame. The frames are identified by the
+// display times it predicts, and every call is checked against the frame loop rules: frames are
+// begun in the order they were waited for, only one frame is begun at a time, a frame is ended
+// once after it was begun, and at most two frames are in flight.
+class ovrFakeFrameRuntime {
+   public:
+    static const int64_t PERIOD = 13888889; // 72 Hz in nanoseconds
+
+    int64_t WaitFrame() {
+        std::lock_guard<std::mutex> lock(Mutex);
+        const int64_t displayTime = NextDisplayTime;
+        NextDisplayTime += PERIOD;
+        Waited.push_back(displayTime);
+        MaxInFlight = std::max(MaxInFlight, static_cast<int>(Waited.size()) + (Begun ? 1 : 0));
+        FrameWaited.notify_all();
+        return displayTime;
+    }
+
+    // Blocks until the next frame was waited for on another thread, which only happens if the
+    // frames overlap. Returns false if that doesn't happen within a second.
+    bool WaitForNextFrame() {
+        std::unique_lock<std::mutex> lock(Mutex);
+        return FrameWaited.wait_for(
+            lock, std::chrono::seconds(1), [this] { return !Waited.empty(); });
+    }
+
+    void BeginFrame(const int64_t displayTime) {
+        std::lock_guard<std::mutex> lock(Mutex);
+        Check(!Begun); // the previous frame was ended
+        Check(!Waited.empty() && Waited.front() == displayTime);
+        if (!Waited.empty()) {
+            Waited.pop_front();
+        }
+        Begun = true;
+        BegunTime = displayTime;
+    }
+
+    void EndFrame(const int64_t displayTime) {
+        std::lock_guard<std::mutex> lock(Mutex);
+        Check(Begun && BegunTime == displayTime);
+        Check(Ended.insert(displayTime).second);
+        Begun = false;
+    }
+
+    // Frames waited for or begun in a session are gone once it stops.
+    void StopSession() {
+        std::lock_guard<std::mutex> lock(Mutex);
+        Waited.clear();
+        Begun = false;
+    }
+
+    bool HasEnded(const int64_t displayTime) {
+        std::lock_guard<std::mutex> lock(Mutex);
+        return Ended.count(displayTime) != 0;
+    }
+
+    int Errors = 0;
+    int MaxInFlight = 0;
+
+   private:
+    void Check(const bool ok) {
+        Errors += ok ? 0 : 1;
+    }
+
+    std::mutex Mutex;
+    std::condition_variable FrameWaited;
+    int64_t NextDisplayTime = PERIOD;
+    std::deque<int64_t> Waited; // waited for and not begun yet
+    bool Begun = false;
+    int64_t BegunTime = 0;
+    std::set<int64_t> Ended;
+};
+
+// The frame steps of XrApp reduced to the frame calls and the frame state held in each slot.
+class ovrFakeFrameSteps : public ovrFrameSteps {
+   public:
+    explicit ovrFakeFrameSteps(ovrFakeFrameRuntime& runtime) : Runtime(runtime) {}
+
+    void WaitFrame(const int slot) override {
+        Slots[slot].DisplayTime = Runtime.WaitFrame();
+        Slots[slot].FrameIndex = -1;
+    }
+    void BeginFrame(const int slot) override {
+        Runtime.BeginFrame(Slots[slot].DisplayTime);
+    }
+    void UpdateFrame(const int slot, const int64_t frameIndex) override {
+        Slots[slot].FrameIndex = frameIndex;
+        if (std::this_thread::get_id() != MainThread) {
+            std::lock_guard<std::mutex> lock(Mutex);
+            SimulatedOffMainThread++;
+        }
+    }
+    void EndFrame(const int slot) override {
+        // a pipelined frame is ended while the next one is simulated
+        if (Overlap && !Runtime.WaitForNextFrame()) {
+            Stalls++;
+        }
+        Runtime.EndFrame(Slots[slot].DisplayTime);
+        Submitted.push_back(Slots[slot]);
+    }
+    void SimulationThreadStart() override {
+        ThreadStarts++;
+    }
+    void SimulationThreadStop() override {
+        ThreadStops++;
+    }
+
+    struct ovrFakeSlot {
+        int64_t DisplayTime = 0;
+        int64_t FrameIndex = -1; // -1 until the frame is updated
+    };
+
+    ovrFakeFrameRuntime& Runtime;
+    const std::thread::id MainThread = std::this_thread::get_id();
+    ovrFakeSlot Slots[ovrFramePipeline::MAX_FRAME_SLOTS];
+    std::vector<ovrFakeSlot> Submitted;
+    std::mutex Mutex;
+    bool Overlap = false; // the frame being ended is pipelined
+    int Stalls = 0; // pipelined frames ended without the next frame being waited for
+    int SimulatedOffMainThread = 0;
+    int ThreadStarts = 0;
+    int ThreadStops = 0;
+};
+
+// Every submitted frame was updated for the loop iteration that submitted it, and the display
+// times only move forward.
+static bool SubmittedInOrder(
+    const std::vector<ovrFakeFrameSteps::ovrFakeSlot>& submitted,
+    const std::vector<int64_t>& frameIndices) {
+    if (submitted.size() != frameIndices.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < submitted.size(); i++) {
+        if (submitted[i].FrameIndex != frameIndices[i] ||
+            (i > 0 && submitted[i].DisplayTime <= submitted[i - 1].DisplayTime)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+OVR_TEST(FramePipeline, SerialFramesRunInOrder) {
+    ovrFakeFrameRuntime runtime;
+    ovrFakeFrameSteps steps(runtime);
+    {
+        ovrFramePipeline pipeline(steps);
+        for (int64_t frame = 0; frame < 5; frame++) {
+            pipeline.RunFrame(frame, false);
+        }
+    }
+    OVR_CHECK(runtime.Errors == 0);
+    OVR_CHECK(runtime.MaxInFlight == 1);
+    OVR_CHECK(SubmittedInOrder(steps.Submitted, {0, 1, 2, 3, 4}));
+    // every display time was used, so no frame was waited for and skipped
+    OVR_CHECK(steps.Submitted.back().DisplayTime == 5 * ovrFakeFrameRuntime::PERIOD);
+    OVR_CHECK(steps.SimulatedOffMainThread == 0 && steps.ThreadStarts == 0);
+}
+
+OVR_TEST(FramePipeline, PipelinedFramesOverlap) {
+    ovrFakeFrameRuntime runtime;
+    ovrFakeFrameSteps steps(runtime);
+    steps.Overlap = true;
+    std::vector<int64_t> frames;
+    {
+        ovrFramePipeline pipeline(steps);
+        for (int64_t frame = 0; frame < 50; frame++) {
+            pipeline.RunFrame(frame, true);
+            frames.push_back(frame);
+        }
+    }
+    OVR_CHECK(runtime.Errors == 0);
+    OVR_CHECK(runtime.MaxInFlight == 2 && steps.Stalls == 0);
+    OVR_CHECK(SubmittedInOrder(steps.Submitted, frames));
+    // the first frame is simulated on the main thread, and the one simulated after the last is
+    // dropped when the pipeline stops
+    OVR_CHECK(steps.SimulatedOffMainThread == 50);
+    OVR_CHECK(!runtime.HasEnded(51 * ovrFakeFrameRuntime::PERIOD));
+    OVR_CHECK(steps.ThreadStarts == 1 && steps.ThreadStops == 1);
+}
+
+OVR_TEST(FramePipeline, SwitchingModesKeepsTheOrder) {
+    ovrFakeFrameRuntime runtime;
+    ovrFakeFrameSteps steps(runtime);
+    const bool pipelined[] = {
+        false, true, true, false, false, true, false, true, true, true, false};
+    std::vector<int64_t> frames;
+    {
+        ovrFramePipeline pipeline(steps);
+        for (int64_t frame = 0; frame < static_cast<int64_t>(sizeof(pipelined)); frame++) {
+            steps.Overlap = pipelined[frame];
+            pipeline.RunFrame(frame, pipelined[frame]);
+            frames.push_back(frame);
+        }
+    }
+    OVR_CHECK(runtime.Errors == 0);
+    OVR_CHECK(runtime.MaxInFlight == 2 && steps.Stalls == 0);
+    OVR_CHECK(SubmittedInOrder(steps.Submitted, frames));
+    // the frame simulated ahead of a serial frame is submitted, so no display time is skipped
+    OVR_CHECK(
+        steps.Submitted.back().DisplayTime ==
+        static_cast<int64_t>(sizeof(pipelined)) * ovrFakeFrameRuntime::PERIOD);
+}
+
+// The main loop drops the frame simulated ahead when the session stops, and skips its frame
+// indices until the session runs again.
+OVR_TEST(FramePipeline, SessionStopDropsTheSimulatedFrame) {
+    ovrFakeFrameRuntime runtime;
+    ovrFakeFrameSteps steps(runtime);
+    steps.Overlap = true;
+    {
+        ovrFramePipeline pipeline(steps);
+        for (int64_t frame = 0; frame < 3; frame++) {
+            pipeline.RunFrame(frame, true);
+        }
+        // frame 3 was simulated ahead
+        runtime.StopSession();
+        pipeline.DropSimulatedFrame();
+        for (int64_t frame = 5; frame < 8; frame++) {
+            pipeline.RunFrame(frame, true);
+        }
+        // frame 8 was simulated ahead when the loop exits
+        pipeline.Stop();
+    }
+    OVR_CHECK(runtime.Errors == 0);
+    OVR_CHECK(runtime.MaxInFlight == 2 && steps.Stalls == 0);
+    OVR_CHECK(SubmittedInOrder(steps.Submitted, {0, 1, 2, 5, 6, 7}));
+    OVR_CHECK(!runtime.HasEnded(4 * ovrFakeFrameRuntime::PERIOD));
+    OVR_CHECK(!runtime.HasEnded(8 * ovrFakeFrameRuntime::PERIOD));
+    OVR_CHECK(steps.ThreadStarts == 1 && steps.ThreadStops == 1);
+}
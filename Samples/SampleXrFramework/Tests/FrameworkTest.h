@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * Licensed under the Oculus SDK License Agreement (the "License");
+ * you may not use the Oculus SDK except in compliance with the License,
+ * which is provided at the time of installation or download, or which
+ * otherwise accompanies this software in either electronic or hard copy form.
+ *
+ * You may obtain a copy of the License at
+ * https://developer.oculus.com/licenses/oculussdk/
+ *
+ * Unless required by applicable law or agreed to in writing, the Oculus SDK
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/************************************************************************************
+
+Filename    :   FrameworkTest.h
+Content     :   Minimal test and benchmark registry for the headless framework tests.
+Language    :   C++
+
+*************************************************************************************/
+
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace OVRFW {
+namespace Test {
+
+// Adds a test or benchmark to the list main() runs. Names are "Suite.Name", and the command
+// line selects them by suite or by full name.
+class ovrTestRegistrar {
+   public:
+    ovrTestRegistrar(const char* name, void (*function)(), const bool isBenchmark);
+};
+
+// Marks the running test as failed.
+void ReportFailure(const char* file, const int line, const char* expression);
+
+// Heap use through operator new, so benchmarks can report allocations and peak memory.
+size_t GetAllocatedBytes();
+size_t GetPeakAllocatedBytes();
+void ResetPeakAllocatedBytes();
+uint64_t GetAllocationCount();
+
+// Calls function runs times and returns the fastest run in milliseconds.
+double TimeBestOf(const int runs, const std::function<void()>& function);
+
+// The memory of the last GlStreamBuffer::Map(), from Stubs/GlStubs.cpp.
+const void* GetLastStreamAllocation();
+
+// The bytes and the buffer offset of the last GlGeometry::UpdateVertexRange().
+const std::vector<uint8_t>& GetLastVertexUpdate(size_t& offset);
+
+// The files given to DecodeTextureFromBuffer() since the last call, in no particular order, and
+// the threads that decoded them.
+struct ovrDecodedFile {
+    std::string name;
+    const uint8_t* data;
+    size_t size;
+    std::thread::id thread;
+};
+std::vector<ovrDecodedFile> TakeDecodedFiles();
+// The file names of the decoded textures created on the GL thread since the last call.
+std::vector<std::string> TakeCreatedTextures();
+
+// A GL call recorded by the stubs, with its integer arguments.
+struct ovrGlCall {
+    std::string function;
+    int64_t args[5];
+};
+// The recorded GL calls since the last call, in order.
+std::vector<ovrGlCall> TakeGlCalls();
+
+// The memory of a GlBuffer, which the stubs keep after it is unmapped. Null if there is no such
+// buffer.
+const uint8_t* GetBufferMemory(const unsigned buffer);
+
+} // namespace Test
+} // namespace OVRFW
+
+#define OVR_TEST_REGISTER(SUITE, NAME, IS_BENCHMARK)                       \
+    static void SUITE##_##NAME();                                          \
+    static const OVRFW::Test::ovrTestRegistrar SUITE##_##NAME##_registrar( \
+        #SUITE "." #NAME, &SUITE##_##NAME, IS_BENCHMARK);                  \
+    static void SUITE##_##NAME()
+
+#define OVR_TEST(SUITE, NAME) OVR_TEST_REGISTER(SUITE, NAME, false)
+#define OVR_BENCHMARK(SUITE, NAME) OVR_TEST_REGISTER(SUITE, NAME, true)
+
+#define OVR_CHECK(EXPRESSION)                                                 \
+    do {                                                                      \
+        if (!(EXPRESSION)) {                                                  \
+            OVRFW::Test::ReportFailure(__FILE__, __LINE__, #EXPRESSION);      \
+        }                                                                     \
+    } while (0)
+
+#define OVR_CHECK_NEAR(A, B, EPSILON) OVR_CHECK(std::fabs((A) - (B)) <= (EPSILON))
@@ -0,0 +1,211 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * Licensed under the Oculus SDK License Agreement (the "License");
+ * you may not use the Oculus SDK except in compliance with the License,
+ * which is provided at the time of installation or download, or which
+ * otherwise accompanies this software in either electronic or hard copy form.
+ *
+ * You may obtain a copy of the License at
+ * https://developer.oculus.com/licenses/oculussdk/
+ *
+ * Unless required by applicable law or agreed to in writing, the Oculus SDK
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/************************************************************************************
+
+Filename    :   GlGeometryOptimizeTests.cpp
+Content     :   Tests and benchmarks for the vertex cache and overdraw optimization of meshes.
+Language    :   C++
+
+*************************************************************************************/
+
+#include "FrameworkTest.h"
+
+#include "Render/GlGeometry.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <random>
+#include <vector>
+
+using namespace OVRFW;
+using OVR::Vector2f;
+using OVR::Vector3f;
+
+struct ovrTestMesh {
+    VertexAttribs attribs;
+    std::vector<TriangleIndex32> indices;
+};
+
+// A grid of size x size cells on a wavy surface, with its triangles in random order the way
+// exporters that don't optimize often leave them.
+static ovrTestMesh MakeShuffledGrid(const int size) {
+    ovrTestMesh mesh;
+    for (int y = 0; y <= size; y++) {
+        for (int x = 0; x <= size; x++) {
+            const float fx = static_cast<float>(x) / size;
+            const float fy = static_cast<float>(y) / size;
+            mesh.attribs.position.push_back(Vector3f(fx, fy, 0.1f * std::sin(fx * 20.0f)));
+            mesh.attribs.uv0.push_back(Vector2f(fx, fy));
+        }
+    }
+    std::vector<std::array<TriangleIndex32, 3>> triangles;
+    const TriangleIndex32 row = static_cast<TriangleIndex32>(size + 1);
+    for (TriangleIndex32 y = 0; y < static_cast<TriangleIndex32>(size); y++) {
+        for (TriangleIndex32 x = 0; x < static_cast<TriangleIndex32>(size); x++) {
+            const TriangleIndex32 v = y * row + x;
+            triangles.push_back({v, v + 1, v + row});
+            triangles.push_back({v + row, v + 1, v + row + 1});
+        }
+    }
+    std::mt19937 rng(24);
+    std::shuffle(triangles.begin(), triangles.end(), rng);
+    for (const std::array<TriangleIndex32, 3>& triangle : triangles) {
+        mesh.indices.insert(mesh.indices.end(), triangle.begin(), triangle.end());
+    }
+    return mesh;
+}
+
+// The triangles as sorted position triples, each rotated to start at its smallest vertex so
+// the winding is kept.
+static std::vector<std::array<Vector3f, 3>> GetTriangles(const ovrTestMesh& mesh) {
+    const auto less = [](const Vector3f& a, const Vector3f& b) {
+        return a.x < b.x || (a.x == b.x && (a.y < b.y || (a.y == b.y && a.z < b.z)));
+    };
+    std::vector<std::array<Vector3f, 3>> triangles;
+    for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3) {
+        std::array<Vector3f, 3> t = {
+            mesh.attribs.position[mesh.indices[i + 0]],
+            mesh.attribs.position[mesh.indices[i + 1]],
+            mesh.attribs.position[mesh.indices[i + 2]]};
+        std::rotate(t.begin(), std::min_element(t.begin(), t.end(), less), t.end());
+        triangles.push_back(t);
+    }
+    std::sort(triangles.begin(), triangles.end(), [&](const auto& a, const auto& b) {
+        return std::lexicographical_compare(a.begin(), a.end(), b.begin(), b.end(), less);
+    });
+    return triangles;
+}
+
+static GeometryOptimizeParms NoDiskCache() {
+    GeometryOptimizeParms parms;
+    parms.useDiskCache = false;
+    return parms;
+}
+
+OVR_TEST(GlGeometryOptimize, ReordersForTheVertexCache) {
+    ovrTestMesh mesh = MakeShuffledGrid(100);
+    const std::vector<std::array<Vector3f, 3>> before = GetTriangles(mesh);
+    GeometryOptimizeStats stats;
+    const std::vector<TriangleIndex32> remap =
+        OptimizeGeometry(mesh.attribs, mesh.indices, NoDiskCache(), &stats);
+
+    OVR_CHECK(remap.size() == 101 * 101);
+    OVR_CHECK(stats.triangleCount == 20000 && stats.verticesAfter == 101 * 101);
+    // nearly every vertex of a shuffled grid misses, an ordered one shares most of them
+    OVR_CHECK(stats.acmrBefore > 2.5f);
+    OVR_CHECK(stats.acmrAfter < 0.8f);
+    OVR_CHECK(stats.acmrAfter == CalculateACMR(mesh.indices, stats.verticesAfter));
+    OVR_CHECK(GetTriangles(mesh) == before);
+
+    // the vertices are numbered in the order they are first used
+    TriangleIndex32 next = 0;
+    bool inOrder = true;
+    for (const TriangleIndex32 index : mesh.indices) {
+        inOrder = inOrder && index <= next;
+        next = std::max(next, index + 1);
+    }
+    OVR_CHECK(inOrder);
+}
+
+// Every triangle of the grid with its own copy of the vertices, and one vertex nothing uses.
+static ovrTestMesh MakeUnwelded(const ovrTestMesh& grid) {
+    ovrTestMesh mesh;
+    for (const TriangleIndex32 index : grid.indices) {
+        mesh.indices.push_back(static_cast<TriangleIndex32>(mesh.attribs.position.size()));
+        mesh.attribs.position.push_back(grid.attribs.position[index]);
+        mesh.attribs.uv0.push_back(grid.attribs.uv0[index]);
+    }
+    mesh.attribs.position.push_back(Vector3f(5.0f));
+    mesh.attribs.uv0.push_back(Vector2f(5.0f));
+    return mesh;
+}
+
+OVR_TEST(GlGeometryOptimize, MergesIdenticalVertices) {
+    const ovrTestMesh grid = MakeShuffledGrid(10);
+    ovrTestMesh mesh = MakeUnwelded(grid);
+    // a vertex that only differs in a texture coordinate stays apart
+    mesh.attribs.uv0[mesh.indices[7]].x += 0.5f;
+    const std::vector<std::array<Vector3f, 3>> before = GetTriangles(mesh);
+
+    GeometryOptimizeStats stats;
+    OptimizeGeometry(mesh.attribs, mesh.indices, NoDiskCache(), &stats);
+    OVR_CHECK(stats.verticesBefore == 600 + 1);
+    OVR_CHECK(stats.verticesAfter == 11 * 11 + 1);
+    OVR_CHECK(mesh.attribs.position.size() == 11 * 11 + 1);
+    OVR_CHECK(mesh.attribs.uv0.size() == 11 * 11 + 1);
+    OVR_CHECK(GetTriangles(mesh) == before);
+
+    // without deduplicate only the unused vertex is dropped
+    mesh = MakeUnwelded(grid);
+    GeometryOptimizeParms parms = NoDiskCache();
+    parms.deduplicate = false;
+    OptimizeGeometry(mesh.attribs, mesh.indices, parms, &stats);
+    OVR_CHECK(stats.verticesAfter == 600);
+}
+
+OVR_TEST(GlGeometryOptimize, KeepsTheVertexOrderWithoutRenumbering) {
+    ovrTestMesh mesh = MakeShuffledGrid(30);
+    const VertexAttribs attribs = mesh.attribs;
+    const std::vector<std::array<Vector3f, 3>> before = GetTriangles(mesh);
+    GeometryOptimizeParms parms = NoDiskCache();
+    parms.renumberVertices = false;
+    GeometryOptimizeStats stats;
+    const std::vector<TriangleIndex32> remap =
+        OptimizeGeometry(mesh.attribs, mesh.indices, parms, &stats);
+
+    bool identity = remap.size() == attribs.position.size();
+    for (size_t i = 0; identity && i < remap.size(); i++) {
+        identity = remap[i] == i;
+    }
+    OVR_CHECK(identity);
+    OVR_CHECK(mesh.attribs.position == attribs.position && mesh.attribs.uv0 == attribs.uv0);
+    OVR_CHECK(GetTriangles(mesh) == before);
+    OVR_CHECK(stats.acmrAfter < stats.acmrBefore);
+}
+
+OVR_TEST(GlGeometryOptimize, LeavesBadMeshesAlone) {
+    ovrTestMesh mesh = MakeShuffledGrid(4);
+    mesh.indices[10] = 25;
+    const ovrTestMesh bad = mesh;
+    OVR_CHECK(OptimizeGeometry(mesh.attribs, mesh.indices, NoDiskCache()).empty());
+    OVR_CHECK(mesh.indices == bad.indices && mesh.attribs.position == bad.attribs.position);
+
+    mesh.indices.resize(10);
+    OVR_CHECK(OptimizeGeometry(mesh.attribs, mesh.indices, NoDiskCache()).empty());
+    mesh.indices.clear();
+    OVR_CHECK(OptimizeGeometry(mesh.attribs, mesh.indices, NoDiskCache()).empty());
+}
+
+OVR_BENCHMARK(GlGeometryOptimize, OptimizeGeometry) {
+    for (const int size : {32, 100, 316}) {
+        const ovrTestMesh source = MakeShuffledGrid(size);
+        GeometryOptimizeStats stats;
+        const double ms = OVRFW::Test::TimeBestOf(3, [&]() {
+            ovrTestMesh mesh = source;
+            OptimizeGeometry(mesh.attribs, mesh.indices, NoDiskCache(), &stats);
+        });
+        printf(
+            "%7d triangles: %8.2f ms, ACMR %.3f -> %.3f\n",
+            stats.triangleCount,
+            ms,
+            stats.acmrBefore,
+            stats.acmrAfter);
+    }
+}
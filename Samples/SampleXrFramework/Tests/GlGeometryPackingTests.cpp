@@ -0,0 +1,221 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * Licensed under the Oculus SDK License Agreement (the "License");
+ * you may not use the Oculus SDK except in compliance with the License,
+ * which is provided at the time of installation or download, or which
+ * otherwise accompanies this software in either electronic or hard copy form.
+ *
+ * You may obtain a copy of the License at
+ * https://developer.oculus.com/licenses/oculussdk/
+ *
+ * Unless required by applicable law or agreed to in writing, the Oculus SDK
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/************************************************************************************
+
+Filename    :   GlGeometryPackingTests.cpp
+Content     :   Tests and benchmarks for the vertex attribute interleaving and quantization.
+Language    :   C++
+
+*************************************************************************************/
+
+#include "FrameworkTest.h"
+
+#include "Render/GlGeometry.h"
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <vector>
+
+using namespace OVRFW;
+using OVR::Vector2f;
+using OVR::Vector3f;
+using OVR::Vector4f;
+using OVR::Vector4i;
+
+// Skinned vertices with every attribute in the range of its compact format.
+static VertexAttribs MakeSkinnedAttribs(const int count) {
+    std::mt19937 rng(21);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    std::uniform_real_distribution<float> positive(0.0f, 1.0f);
+    auto unitVector = [&]() {
+        Vector3f v(unit(rng), unit(rng), unit(rng) + 2.0f);
+        return v.Normalized();
+    };
+    VertexAttribs attribs;
+    for (int i = 0; i < count; i++) {
+        attribs.position.push_back(Vector3f(unit(rng), unit(rng), unit(rng)) * 10.0f);
+        attribs.normal.push_back(unitVector());
+        attribs.tangent.push_back(unitVector());
+        attribs.binormal.push_back(unitVector());
+        attribs.color.push_back(Vector4f(positive(rng), positive(rng), positive(rng), 1.0f));
+        attribs.uv0.push_back(Vector2f(positive(rng), positive(rng)));
+        attribs.uv1.push_back(Vector2f(unit(rng), unit(rng)) * 1.9f);
+        attribs.jointIndices.push_back(Vector4i(i % 256, (i * 7) % 256, 3, 0));
+        const float w = positive(rng);
+        attribs.jointWeights.push_back(Vector4f(w, 1.0f - w, 0.0f, 0.0f));
+    }
+    return attribs;
+}
+
+template <typename T>
+static T Read(const uint8_t* src) {
+    T value;
+    memcpy(&value, src, sizeof(value));
+    return value;
+}
+
+OVR_TEST(GlGeometryPacking, Float16RoundTrip) {
+    // every finite half decodes to a float that encodes back to the same bits
+    int mismatches = 0;
+    for (uint32_t h = 0; h < 0x10000; h++) {
+        if ((h & 0x7C00) == 0x7C00) {
+            continue;
+        }
+        mismatches += (EncodeFloat16(DecodeFloat16(static_cast<uint16_t>(h))) == h) ? 0 : 1;
+    }
+    OVR_CHECK(mismatches == 0);
+
+    // floats round to the nearest half, within half a unit in the last place
+    std::mt19937 rng(16);
+    std::uniform_real_distribution<float> exponent(-14.0f, 15.0f);
+    int outOfTolerance = 0;
+    for (int i = 0; i < 100000; i++) {
+        const float f = std::exp2(exponent(rng)) * ((i & 1) ? -1.0f : 1.0f);
+        const float error = std::fabs(DecodeFloat16(EncodeFloat16(f)) - f);
+        outOfTolerance += (error <= std::fabs(f) * (1.0f / 2048.0f)) ? 0 : 1;
+    }
+    OVR_CHECK(outOfTolerance == 0);
+
+    OVR_CHECK(EncodeFloat16(0.0f) == 0x0000);
+    OVR_CHECK(EncodeFloat16(-0.0f) == 0x8000);
+    OVR_CHECK(EncodeFloat16(1.0f) == 0x3C00);
+    OVR_CHECK(EncodeFloat16(65504.0f) == 0x7BFF);
+    OVR_CHECK(EncodeFloat16(65520.0f) == 0x7C00); // rounds to infinity
+    OVR_CHECK(EncodeFloat16(-1e10f) == 0xFC00);
+    OVR_CHECK(EncodeFloat16(std::exp2(-24.0f)) == 0x0001); // smallest subnormal
+    OVR_CHECK(EncodeFloat16(std::exp2(-26.0f)) == 0x0000);
+    OVR_CHECK(std::isnan(DecodeFloat16(EncodeFloat16(std::numeric_limits<float>::quiet_NaN()))));
+}
+
+OVR_TEST(GlGeometryPacking, Snorm10RoundTrip) {
+    // every code but -512, which the vertex fetch clamps to -1, survives decoding
+    int mismatches = 0;
+    for (uint32_t q = 0; q < 1024; q++) {
+        if (q == 0x200) {
+            continue;
+        }
+        const uint32_t packed = q | (q << 10) | (q << 20);
+        mismatches += (EncodeSnorm10(DecodeSnorm10(packed)) == packed) ? 0 : 1;
+    }
+    OVR_CHECK(mismatches == 0);
+
+    std::mt19937 rng(10);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    float maxError = 0.0f;
+    for (int i = 0; i < 100000; i++) {
+        const Vector3f v(unit(rng), unit(rng), unit(rng));
+        const Vector3f d = DecodeSnorm10(EncodeSnorm10(v)) - v;
+        maxError = std::max(maxError, std::fabs(d.x));
+        maxError = std::max(maxError, std::max(std::fabs(d.y), std::fabs(d.z)));
+    }
+    OVR_CHECK(maxError <= 1.0f / 1022.0f);
+
+    // out of range values clamp
+    const Vector3f clamped = DecodeSnorm10(EncodeSnorm10(Vector3f(2.0f, -2.0f, 0.0f)));
+    OVR_CHECK(clamped.x == 1.0f && clamped.y == -1.0f && clamped.z == 0.0f);
+}
+
+OVR_TEST(GlGeometryPacking, CompactLayoutPicksFormatsByRange) {
+    VertexAttribs attribs = MakeSkinnedAttribs(100);
+    const VertexLayout compact = VertexLayout::Compact(attribs);
+    OVR_CHECK(compact.normal == VertexFormat::Snorm10);
+    OVR_CHECK(compact.tangent == VertexFormat::Snorm10);
+    OVR_CHECK(compact.binormal == VertexFormat::Snorm10);
+    OVR_CHECK(compact.color == VertexFormat::Unorm8);
+    OVR_CHECK(compact.uv0 == VertexFormat::Unorm16);
+    OVR_CHECK(compact.uv1 == VertexFormat::Float16);
+    OVR_CHECK(compact.jointIndices == VertexFormat::Uint8);
+    OVR_CHECK(compact.jointWeights == VertexFormat::Unorm16);
+    OVR_CHECK(GetPackedVertexSize(attribs, VertexLayout::Full()) == 112);
+    OVR_CHECK(GetPackedVertexSize(attribs, compact) == 48);
+
+    // a single value out of range keeps that attribute at full precision
+    attribs.normal[50] = Vector3f(0.0f, 2.0f, 0.0f);
+    attribs.color[7].x = 1.5f;
+    attribs.uv1[3].y = 2.5f;
+    attribs.jointIndices[9].w = 300;
+    attribs.jointWeights[1].z = std::numeric_limits<float>::quiet_NaN();
+    const VertexLayout full = VertexLayout::Compact(attribs);
+    OVR_CHECK(full.normal == VertexFormat::Float32);
+    OVR_CHECK(full.tangent == VertexFormat::Snorm10);
+    OVR_CHECK(full.color == VertexFormat::Float32);
+    OVR_CHECK(full.uv1 == VertexFormat::Float32);
+    OVR_CHECK(full.jointIndices == VertexFormat::Int32);
+    OVR_CHECK(full.jointWeights == VertexFormat::Float32);
+}
+
+OVR_TEST(GlGeometryPacking, PackedVerticesDecodeToTheAttributes) {
+    VertexAttribs attribs = MakeSkinnedAttribs(1000);
+    // a shorter array is zero filled past its end
+    attribs.uv1.resize(600);
+    const VertexLayout layout = VertexLayout::Compact(attribs);
+    std::vector<uint8_t> packed;
+    const VertexStreamLayout s = PackVertexAttribs(attribs, layout, packed);
+    OVR_CHECK(s.stride == 48);
+    OVR_CHECK(packed.size() == attribs.position.size() * s.stride);
+    if (s.stride != 48 || packed.size() != attribs.position.size() * s.stride) {
+        return;
+    }
+
+    int mismatches = 0;
+    for (size_t i = 0; i < attribs.position.size(); i++) {
+        const uint8_t* v = &packed[i * s.stride];
+        bool match = Read<Vector3f>(v + s.position) == attribs.position[i];
+        const Vector3f n = DecodeSnorm10(Read<uint32_t>(v + s.normal));
+        match = match && (n - attribs.normal[i]).Length() < 2.0f / 511.0f;
+        const Vector3f t = DecodeSnorm10(Read<uint32_t>(v + s.tangent));
+        match = match && (t - attribs.tangent[i]).Length() < 2.0f / 511.0f;
+        match = match && std::fabs(v[s.color] / 255.0f - attribs.color[i].x) <= 0.5f / 255.0f;
+        match = match && v[s.color + 3] == 255;
+        const uint16_t u = Read<uint16_t>(v + s.uv0);
+        match = match && std::fabs(u / 65535.0f - attribs.uv0[i].x) <= 0.5f / 65535.0f;
+        const float uv1 = DecodeFloat16(Read<uint16_t>(v + s.uv1 + 2));
+        const float expectedUv1 = (i < attribs.uv1.size()) ? attribs.uv1[i].y : 0.0f;
+        match = match && std::fabs(uv1 - expectedUv1) <= 1.0f / 2048.0f;
+        match = match && v[s.jointIndices] == attribs.jointIndices[i].x;
+        match = match && v[s.jointIndices + 1] == attribs.jointIndices[i].y;
+        const uint16_t w = Read<uint16_t>(v + s.jointWeights);
+        match = match && std::fabs(w / 65535.0f - attribs.jointWeights[i].x) <= 0.5f / 65535.0f;
+        mismatches += match ? 0 : 1;
+    }
+    OVR_CHECK(mismatches == 0);
+
+    // the full layout is a plain copy of the floats
+    const VertexStreamLayout f = PackVertexAttribs(attribs, VertexLayout::Full(), packed);
+    OVR_CHECK(Read<Vector4f>(&packed[5 * f.stride + f.color]) == attribs.color[5]);
+    OVR_CHECK(Read<Vector4i>(&packed[5 * f.stride + f.jointIndices]) == attribs.jointIndices[5]);
+}
+
+OVR_BENCHMARK(GlGeometryPacking, PackVertexAttribs) {
+    const VertexAttribs attribs = MakeSkinnedAttribs(100000);
+    std::vector<uint8_t> packed;
+    for (const bool compact : {false, true}) {
+        const VertexLayout layout =
+            compact ? VertexLayout::Compact(attribs) : VertexLayout::Full();
+        const double ms = OVRFW::Test::TimeBestOf(
+            5, [&]() { PackVertexAttribs(attribs, layout, packed); });
+        printf(
+            "100000 skinned vertices, %s layout: %6.2f ms, %3d bytes per vertex\n",
+            compact ? "compact" : "full   ",
+            ms,
+            GetPackedVertexSize(attribs, layout));
+    }
+}
@@ -0,0 +1,130 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * Licensed under the Oculus SDK License Agreement (the "License");
+ * you may not use the Oculus SDK except in compliance with the License,
+ * which is provided at the time of installation or download, or which
+ * otherwise accompanies this software in either electronic or hard copy form.
+ *
+ * You may obtain a copy of the License at
+ * https://developer.oculus.com/licenses/oculussdk/
+ *
+ * Unless required by applicable law or agreed to in writing, the Oculus SDK
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/************************************************************************************
+
+Filename    :   GlGeometrySplitTests.cpp
+Content     :   Tests and benchmarks for splitting meshes that don't fit 16-bit indices.
+Language    :   C++
+
+*************************************************************************************/
+
+#include "FrameworkTest.h"
+
+#include "Render/GlGeometry.h"
+
+#include <vector>
+
+using namespace OVRFW;
+using OVR::Vector2f;
+using OVR::Vector3f;
+
+// Two triangles per cell of a grid of size x size cells, row by row.
+static std::vector<TriangleIndex32> MakeGrid(const int size) {
+    std::vector<TriangleIndex32> indices;
+    const TriangleIndex32 row = static_cast<TriangleIndex32>(size + 1);
+    for (TriangleIndex32 y = 0; y < static_cast<TriangleIndex32>(size); y++) {
+        for (TriangleIndex32 x = 0; x < static_cast<TriangleIndex32>(size); x++) {
+            const TriangleIndex32 v = y * row + x;
+            indices.insert(indices.end(), {v, v + 1, v + row, v + row, v + 1, v + row + 1});
+        }
+    }
+    return indices;
+}
+
+// The triangles of the sub-meshes, back in source vertices and in order.
+static std::vector<TriangleIndex32> Unsplit(const std::vector<GeometrySplit>& splits) {
+    std::vector<TriangleIndex32> indices;
+    for (const GeometrySplit& split : splits) {
+        for (const TriangleIndex index : split.indices) {
+            indices.push_back(split.vertices[index]);
+        }
+    }
+    return indices;
+}
+
+OVR_TEST(GlGeometrySplit, SplitsKeepTheTrianglesInOrder) {
+    const int size = 300;
+    const int vertexCount = (size + 1) * (size + 1);
+    const std::vector<TriangleIndex32> indices = MakeGrid(size);
+    const std::vector<GeometrySplit> splits = SplitTriangles(indices, vertexCount);
+
+    OVR_CHECK(splits.size() == 2);
+    OVR_CHECK(Unsplit(splits) == indices);
+    size_t totalVertices = 0;
+    bool fits = true;
+    for (const GeometrySplit& split : splits) {
+        fits = fits && split.vertices.size() <= GlGeometry::MAX_GEOMETRY_VERTICES;
+        totalVertices += split.vertices.size();
+    }
+    OVR_CHECK(fits);
+    // only the row on the seam is stored twice
+    OVR_CHECK(totalVertices == static_cast<size_t>(vertexCount + size + 1));
+}
+
+OVR_TEST(GlGeometrySplit, SmallSplitsAndBadTriangles) {
+    std::vector<TriangleIndex32> indices = MakeGrid(20);
+    // a triangle past the last vertex is dropped, a trailing partial triangle is ignored
+    indices.insert(indices.begin() + 30, {5, 6, 441});
+    indices.push_back(1);
+
+    const std::vector<GeometrySplit> splits = SplitTriangles(indices, 21 * 21, 50);
+    bool fits = true;
+    for (const GeometrySplit& split : splits) {
+        fits = fits && split.vertices.size() <= 50 && !split.indices.empty();
+    }
+    OVR_CHECK(fits);
+    const std::vector<TriangleIndex32> grid = MakeGrid(20);
+    OVR_CHECK(Unsplit(splits) == grid);
+
+    OVR_CHECK(SplitTriangles(grid, 21 * 21, 2).empty());
+    OVR_CHECK(SplitTriangles(grid, 0).empty());
+}
+
+OVR_TEST(GlGeometrySplit, GatherVertexAttribs) {
+    VertexAttribs attribs;
+    for (int i = 0; i < 10; i++) {
+        attribs.position.push_back(Vector3f(static_cast<float>(i), 0.0f, 0.0f));
+    }
+    attribs.uv0.resize(5, Vector2f(0.5f, 0.5f));
+
+    const VertexAttribs gathered = GatherVertexAttribs(attribs, {9, 2, 7});
+    OVR_CHECK(gathered.position.size() == 3);
+    OVR_CHECK(gathered.position[0].x == 9.0f && gathered.position[2].x == 7.0f);
+    // a short array is zero filled, and missing attributes stay missing
+    OVR_CHECK(gathered.uv0.size() == 3);
+    OVR_CHECK(gathered.uv0[1] == Vector2f(0.5f, 0.5f) && gathered.uv0[0] == Vector2f(0.0f));
+    OVR_CHECK(gathered.normal.empty() && gathered.jointIndices.empty());
+}
+
+OVR_BENCHMARK(GlGeometrySplit, SplitTriangles) {
+    for (const int size : {256, 512, 1024}) {
+        const std::vector<TriangleIndex32> indices = MakeGrid(size);
+        const int vertexCount = (size + 1) * (size + 1);
+        size_t splitCount = 0;
+        const double ms = OVRFW::Test::TimeBestOf(3, [&]() {
+            splitCount = SplitTriangles(indices, vertexCount).size();
+        });
+        printf(
+            "%8d vertices, %8d triangles: %7.2f ms, %d sub-meshes\n",
+            vertexCount,
+            static_cast<int>(indices.size() / 3),
+            ms,
+            static_cast<int>(splitCount));
+    }
+}
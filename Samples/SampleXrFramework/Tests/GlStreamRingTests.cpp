@@ -0,0 +1,163 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * Licensed under the Oculus SDK License Agreement (the "License");
+ * you may not use the Oculus SDK except in compliance with the License,
+ * which is provided at the time of installation or download, or which
+ * otherwise accompanies this software in either electronic or hard copy form.
+ *
+ * You may obtain a copy of the License at
+ * https://developer.oculus.com/licenses/oculussdk/
+ *
+ * Unless required by applicable law or agreed to in writing, the Oculus SDK
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/************************************************************************************
+
+Filename    :   GlStreamRingTests.cpp
+Content     :   Tests and benchmarks for the offset bookkeeping of the stream buffer ring.
+Language    :   C++
+
+*************************************************************************************/
+
+#include "FrameworkTest.h"
+
+#include "Render/GlStreamBuffer.h"
+
+#include <deque>
+#include <random>
+#include <vector>
+
+using namespace OVRFW;
+
+OVR_TEST(GlStreamRing, AllocationsAreAlignedAndNeverStraddleTheEnd) {
+    ovrStreamRing ring;
+    ring.Reset(1024);
+    size_t offset = 1;
+    OVR_CHECK(ring.Allocate(100, 16, offset) && offset == 0);
+    OVR_CHECK(ring.Allocate(100, 16, offset) && offset == 112);
+    OVR_CHECK(ring.Allocate(10, 256, offset) && offset == 256);
+    OVR_CHECK(ring.EndFrame());
+    ring.RetireOldestFrame();
+
+    // with nothing in flight the ring starts over at 0
+    OVR_CHECK(ring.Allocate(600, 16, offset) && offset == 0);
+    OVR_CHECK(ring.EndFrame());
+    OVR_CHECK(ring.Allocate(292, 16, offset) && offset == 608);
+    OVR_CHECK(ring.EndFrame());
+    ring.RetireOldestFrame();
+
+    // 200 bytes don't fit after 900, so the allocation skips the 124 bytes up to the end
+    OVR_CHECK(ring.Allocate(200, 16, offset) && offset == 0);
+    OVR_CHECK(ring.GetUsed() == 1024 - 600 + 200);
+    OVR_CHECK(!ring.Allocate(1025, 16, offset));
+}
+
+OVR_TEST(GlStreamRing, FramesInFlightAreNeverOverwritten) {
+    ovrStreamRing ring;
+    ring.Reset(1024);
+    size_t offset = 0;
+    OVR_CHECK(ring.Allocate(600, 16, offset));
+    OVR_CHECK(ring.EndFrame());
+    OVR_CHECK(ring.GetFramesInFlight() == 1);
+
+    // the next frame only gets the space the first one doesn't use
+    OVR_CHECK(ring.Allocate(400, 16, offset) && offset == 608);
+    OVR_CHECK(!ring.Allocate(100, 16, offset));
+    OVR_CHECK(ring.EndFrame());
+    ring.RetireOldestFrame();
+    OVR_CHECK(ring.Allocate(100, 16, offset) && offset == 0);
+
+    // a frame without allocations adds nothing to retire
+    OVR_CHECK(ring.EndFrame());
+    OVR_CHECK(!ring.EndFrame());
+    OVR_CHECK(ring.GetFramesInFlight() == 2);
+    ring.RetireOldestFrame();
+    ring.RetireOldestFrame();
+    OVR_CHECK(ring.GetUsed() == 0);
+    OVR_CHECK(ring.Allocate(1024, 16, offset) && offset == 0);
+}
+
+// Streams random allocations with up to three frames in flight, the way GlStreamBuffer does
+// with its fences, and checks that no allocation overlaps one the GPU may still read.
+OVR_TEST(GlStreamRing, RandomFramesDoNotOverlap) {
+    const size_t capacity = 64 * 1024;
+    ovrStreamRing ring;
+    ring.Reset(capacity);
+    std::mt19937 rng(22);
+    std::uniform_int_distribution<size_t> sizes(1, 4096);
+    std::uniform_int_distribution<int> counts(0, 12);
+
+    struct ovrRange {
+        size_t first;
+        size_t end;
+    };
+    std::deque<std::vector<ovrRange>> inFlight;
+    std::vector<ovrRange> frame;
+    int overlaps = 0;
+    int misaligned = 0;
+    int failed = 0;
+    for (int f = 0; f < 10000; f++) {
+        frame.clear();
+        const int count = counts(rng);
+        for (int i = 0; i < count; i++) {
+            const size_t size = sizes(rng);
+            const size_t alignment = size_t(1) << (i % 7);
+            size_t offset = 0;
+            if (!ring.Allocate(size, alignment, offset)) {
+                failed++;
+                continue;
+            }
+            misaligned += (offset % alignment == 0 && offset + size <= capacity) ? 0 : 1;
+            const ovrRange range = {offset, offset + size};
+            auto overlapsRange = [&range](const ovrRange& other) {
+                return range.first < other.end && other.first < range.end;
+            };
+            for (const std::vector<ovrRange>& ranges : inFlight) {
+                for (const ovrRange& other : ranges) {
+                    overlaps += overlapsRange(other) ? 1 : 0;
+                }
+            }
+            for (const ovrRange& other : frame) {
+                overlaps += overlapsRange(other) ? 1 : 0;
+            }
+            frame.push_back(range);
+        }
+        if (ring.EndFrame()) {
+            inFlight.push_back(frame);
+        }
+        if (ring.GetFramesInFlight() > 3) {
+            ring.RetireOldestFrame();
+            inFlight.pop_front();
+        }
+    }
+    OVR_CHECK(overlaps == 0);
+    OVR_CHECK(misaligned == 0);
+    // four frames of up to 48 KB don't always fit in 64 KB, so some allocations must fail
+    OVR_CHECK(failed > 0);
+}
+
+OVR_BENCHMARK(GlStreamRing, Allocate) {
+    ovrStreamRing ring;
+    ring.Reset(4 * 1024 * 1024);
+    const int allocationsPerFrame = 1000;
+    const double ms = OVRFW::Test::TimeBestOf(20, [&]() {
+        size_t offset = 0;
+        for (int i = 0; i < allocationsPerFrame; i++) {
+            ring.Allocate(64 + (i & 255) * 4, 16, offset);
+        }
+        ring.EndFrame();
+        if (ring.GetFramesInFlight() > 2) {
+            ring.RetireOldestFrame();
+        }
+    });
+    printf(
+        "%d allocations per frame: %.4f ms, %.1f ns per allocation\n",
+        allocationsPerFrame,
+        ms,
+        ms * 1e6 / allocationsPerFrame);
+}
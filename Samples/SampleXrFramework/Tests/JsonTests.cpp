@@ -0,0 +1,400 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * Licensed under the Oculus SDK License Agreement (the "License");
+ * you may not use the Oculus SDK except in compliance with the License,
+ * which is provided at the time of installation or download, or which
+ * otherwise accompanies this software in either electronic or hard copy form.
+ *
+ * You may obtain a copy of the License at
+ * https://developer.oculus.com/licenses/oculussdk/
+ *
+ * Unless required by applicable law or agreed to in writing, the Oculus SDK
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/************************************************************************************
+
+Filename    :   JsonTests.cpp
+Content     :   Tests and benchmarks for the JSON tree, JsonDocument and JsonPullParser.
+Language    :   C++
+
+*************************************************************************************/
+
+#include "FrameworkTest.h"
+
+#include "OVR_JSON.h"
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+using OVR::JSON;
+using OVR::JsonDocument;
+using OVR::JsonPullParser;
+using OVR::JsonValue;
+
+// A glTF-like document with the arrays that dominate large scenes.
+static std::string MakeglTFJson(const int nodeCount) {
+    std::string json = "{\"asset\":{\"version\":\"2.0\",\"generator\":\"JsonTests\"},";
+    json += "\"accessors\":[";
+    for (int i = 0; i < nodeCount; i++) {
+        json += (i > 0) ? "," : "";
+        json += "{\"bufferView\":" + std::to_string(i) + ",\"byteOffset\":0,";
+        json += "\"componentType\":5126,\"count\":" + std::to_string(100 + i) + ",";
+        json += "\"type\":\"VEC3\",\"min\":[-1.5,-2.25,-3e-2],\"max\":[1.5,2.25,3e2]}";
+    }
+    json += "],\"nodes\":[";
+    for (int i = 0; i < nodeCount; i++) {
+        json += (i > 0) ? "," : "";
+        json += "{\"name\":\"node_" + std::to_string(i) + "\",\"mesh\":" + std::to_string(i);
+        json += ",\"translation\":[0.5,1,-2],\"rotation\":[0,0,0,1],\"scale\":[1,1,1]";
+        json += ",\"extras\":{\"visible\":true,\"tag\":null,\"label\":\"a \\\"b\\\" \\u00e9\"}}";
+    }
+    json += "]}";
+    return json;
+}
+
+static bool SameTree(const std::shared_ptr<JSON>& tree, const JsonValue& value) {
+    if (tree->GetType() != value.GetType() || tree->Name != value.GetName() ||
+        tree->GetItemCount() != value.GetItemCount()) {
+        return false;
+    }
+    if (tree->GetType() == OVR::JSON_Number) {
+        if (tree->GetDoubleValue() != value.GetDoubleValue()) {
+            return false;
+        }
+    } else if (tree->GetType() == OVR::JSON_Bool) {
+        if (tree->GetBoolValue() != value.GetBoolValue()) {
+            return false;
+        }
+    } else if (tree->GetType() == OVR::JSON_String) {
+        if (tree->GetStringValue() != value.GetStringValue()) {
+            return false;
+        }
+    }
+    unsigned index = 0;
+    for (const std::shared_ptr<JSON>& child : tree->Children) {
+        if (!SameTree(child, value.GetItemByIndex(index++))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Touches every value the way a loader would, so the walk is part of the benchmarks.
+static double SumNumbers(const std::shared_ptr<JSON>& node) {
+    double sum = (node->GetType() == OVR::JSON_Number) ? node->GetDoubleValue() : 0.0;
+    for (const std::shared_ptr<JSON>& child : node->Children) {
+        sum += SumNumbers(child);
+    }
+    return sum;
+}
+
+static double SumNumbers(const JsonValue& node) {
+    double sum = (node.GetType() == OVR::JSON_Number) ? node.GetDoubleValue() : 0.0;
+    for (unsigned i = 0; i < node.GetItemCount(); i++) {
+        sum += SumNumbers(node.GetItemByIndex(i));
+    }
+    return sum;
+}
+
+OVR_TEST(Json, DocumentMatchesTree) {
+    const std::string text = MakeglTFJson(20);
+    const std::shared_ptr<JSON> tree = JSON::Parse(text.c_str());
+    const std::shared_ptr<JsonDocument> doc = JsonDocument::Parse(text.c_str());
+    OVR_CHECK(tree != nullptr);
+    OVR_CHECK(doc != nullptr);
+    if (tree != nullptr && doc != nullptr) {
+        OVR_CHECK(SameTree(tree, doc->GetRoot()));
+        OVR_CHECK(SumNumbers(tree) == SumNumbers(doc->GetRoot()));
+    }
+}
+
+OVR_TEST(Json, NamedLookup) {
+    // enough members for a hash index, plus a duplicate name that must resolve to the first one
+    std::string text = "{";
+    for (int i = 0; i < 32; i++) {
+        text += "\"m" + std::to_string(i) + "\":" + std::to_string(i) + ",";
+    }
+    text += "\"m5\":-1,\"small\":{\"a\":1,\"b\":2}}";
+
+    for (const bool buildNameIndex : {true, false}) {
+        const std::shared_ptr<JsonDocument> doc =
+            JsonDocument::Parse(text.c_str(), text.length(), nullptr, buildNameIndex);
+        OVR_CHECK(doc != nullptr);
+        if (doc == nullptr) {
+            continue;
+        }
+        const JsonValue root = doc->GetRoot();
+        for (int i = 0; i < 32; i++) {
+            const JsonValue member = root.GetItemByName(("m" + std::to_string(i)).c_str());
+            OVR_CHECK(member != nullptr && member.GetInt32Value() == i);
+        }
+        OVR_CHECK(root.GetItemByName("missing") == nullptr);
+        OVR_CHECK(root.GetItemByName("small").GetItemByName("b").GetInt32Value() == 2);
+        OVR_CHECK(root.GetItemByName("small").GetItemByName("c") == nullptr);
+
+        const OVR::JsonDocumentReader reader(root);
+        OVR_CHECK(reader.GetChildInt32ByName("m31") == 31);
+        OVR_CHECK(reader.GetChildInt32ByName("missing", 7) == 7);
+    }
+}
+
+OVR_TEST(Json, StringsAndNumbers) {
+    const char* text =
+        "{\"s\":\"tab\\tquote\\\" \\u00e9\\u20ac\",\"n\":[0,-0.5,1e3,-2.5E-2,4294967296],"
+        "\"t\":true,\"f\":false,\"z\":null,\"e\":\"\",\"o\":{},\"a\":[]}";
+    const std::shared_ptr<JSON> tree = JSON::Parse(text);
+    const std::shared_ptr<JsonDocument> doc = JsonDocument::Parse(text);
+    OVR_CHECK(tree != nullptr && doc != nullptr);
+    if (tree == nullptr || doc == nullptr) {
+        return;
+    }
+    OVR_CHECK(SameTree(tree, doc->GetRoot()));
+    const JsonValue root = doc->GetRoot();
+    const char* expected = "tab\tquote\" \xC3\xA9\xE2\x82\xAC";
+    OVR_CHECK(strcmp(root.GetItemByName("s").GetStringValue(), expected) == 0);
+    OVR_CHECK(root.GetItemByName("n").GetArrayNumber(3) == -2.5e-2);
+    OVR_CHECK(root.GetItemByName("n").GetItemByIndex(4).GetInt64Value() == 4294967296ll);
+    OVR_CHECK(root.GetItemByName("t").GetBoolValue());
+    OVR_CHECK(root.GetItemByName("z").GetType() == OVR::JSON_Null);
+    OVR_CHECK(root.GetItemByName("o").GetItemCount() == 0);
+    OVR_CHECK(root.GetItemByName("a").GetArraySize() == 0);
+}
+
+OVR_TEST(Json, SyntaxErrors) {
+    const char* invalid[] = {"", "{", "[1,2", "{\"a\" 1}", "{\"a\":}", "\"open", "[1,]x"};
+    for (const char* text : invalid) {
+        const char* error = nullptr;
+        const std::shared_ptr<JsonDocument> doc = JsonDocument::Parse(text, &error);
+        OVR_CHECK(doc == nullptr);
+        OVR_CHECK(error != nullptr);
+    }
+}
+
+// Parse and walk time, heap allocations and peak heap use of a large glTF document.
+OVR_BENCHMARK(Json, ParseDocumentVsTree) {
+    const std::string text = MakeglTFJson(20000);
+    printf("  %.1f MB of JSON\n", text.length() / (1024.0 * 1024.0));
+
+    double treeSum = 0.0;
+    double docSum = 0.0;
+    const auto measure = [](const char* label, const std::function<void()>& parse) {
+        OVRFW::Test::ResetPeakAllocatedBytes();
+        const size_t baseBytes = OVRFW::Test::GetAllocatedBytes();
+        const uint64_t baseCount = OVRFW::Test::GetAllocationCount();
+        parse();
+        const uint64_t allocations = OVRFW::Test::GetAllocationCount() - baseCount;
+        const size_t peak = OVRFW::Test::GetPeakAllocatedBytes() - baseBytes;
+        const double ms = OVRFW::Test::TimeBestOf(5, parse);
+        printf(
+            "  %-14s %8.2f ms %10llu allocations %8.2f MB peak\n",
+            label,
+            ms,
+            (unsigned long long)allocations,
+            peak / (1024.0 * 1024.0));
+    };
+    measure("JSON", [&]() { treeSum = SumNumbers(JSON::Parse(text.c_str())); });
+    measure("JsonDocument", [&]() {
+        docSum = SumNumbers(JsonDocument::Parse(text.c_str())->GetRoot());
+    });
+    OVR_CHECK(treeSum == docSum);
+}
+
+OVR_TEST(JsonPullParser, Tokens) {
+    JsonPullParser parser("{ \"a\" : [1, true, null, \"s\\n\"], \"b\": {}, \"c\": [] }");
+    const OVR::JSONToken expected[] = {
+        OVR::JSON_Token_BeginObject,
+        OVR::JSON_Token_Name,
+        OVR::JSON_Token_BeginArray,
+        OVR::JSON_Token_Number,
+        OVR::JSON_Token_Bool,
+        OVR::JSON_Token_Null,
+        OVR::JSON_Token_String,
+        OVR::JSON_Token_EndArray,
+        OVR::JSON_Token_Name,
+        OVR::JSON_Token_BeginObject,
+        OVR::JSON_Token_EndObject,
+        OVR::JSON_Token_Name,
+        OVR::JSON_Token_BeginArray,
+        OVR::JSON_Token_EndArray,
+        OVR::JSON_Token_EndObject,
+        OVR::JSON_Token_EndOfDocument};
+    for (const OVR::JSONToken token : expected) {
+        OVR_CHECK(parser.Next() == token);
+        if (token == OVR::JSON_Token_Name && parser.GetDepth() == 1) {
+            OVR_CHECK(strlen(parser.GetString()) == 1);
+        }
+        if (token == OVR::JSON_Token_String) {
+            OVR_CHECK(strcmp(parser.GetString(), "s\n") == 0);
+        }
+    }
+    OVR_CHECK(parser.GetDepth() == 0);
+    OVR_CHECK(parser.GetError() == nullptr);
+}
+
+OVR_TEST(JsonPullParser, ReadAndSkip) {
+    JsonPullParser parser(
+        "{\"skip\":{\"x\":[1,[2,{\"y\":3}]]},\"n\":2.5,\"i\":-7,\"s\":\"str\","
+        "\"wrong\":\"not a number\",\"arr\":[1,\"x\",2,3,4],\"last\":true}");
+    OVR_CHECK(parser.Next() == OVR::JSON_Token_BeginObject);
+    int members = 0;
+    while (parser.NextMember()) {
+        const std::string name = parser.GetString();
+        members++;
+        if (name == "n") {
+            OVR_CHECK(parser.ReadDouble() == 2.5);
+        } else if (name == "i") {
+            OVR_CHECK(parser.ReadInt32() == -7);
+        } else if (name == "s") {
+            OVR_CHECK(strcmp(parser.ReadString(), "str") == 0);
+        } else if (name == "wrong") {
+            OVR_CHECK(parser.ReadFloat(-1.0f) == -1.0f);
+        } else if (name == "arr") {
+            double values[3] = {};
+            // the string is skipped, and elements past maxCount are read but not stored
+            OVR_CHECK(parser.ReadNumberArray(values, 3) == 3);
+            OVR_CHECK(values[0] == 1.0 && values[1] == 2.0 && values[2] == 3.0);
+        } else if (name == "last") {
+            OVR_CHECK(parser.ReadBool());
+        } else {
+            OVR_CHECK(parser.SkipValue());
+            OVR_CHECK(parser.GetDepth() == 1);
+        }
+    }
+    OVR_CHECK(members == 7);
+    OVR_CHECK(parser.GetToken() == OVR::JSON_Token_EndObject);
+    OVR_CHECK(parser.Next() == OVR::JSON_Token_EndOfDocument);
+}
+
+OVR_TEST(JsonPullParser, SyntaxErrors) {
+    const char* invalid[] = {"{\"a\":1 \"b\":2}", "[1 2]", "{1:2}", "[\"open]", "[tru]", "{\"a\"}"};
+    for (const char* text : invalid) {
+        JsonPullParser parser(text);
+        OVR_CHECK(parser.Next() != OVR::JSON_Token_Error);
+        OVR_CHECK(!parser.SkipValue());
+        OVR_CHECK(parser.GetError() != nullptr);
+        // an error is sticky
+        OVR_CHECK(parser.Next() == OVR::JSON_Token_Error);
+    }
+}
+
+// Accessor fields the glTF loader reads.
+struct ovrTestAccessor {
+    int bufferView = -1;
+    int count = 0;
+    double min[3] = {};
+    double max[3] = {};
+};
+
+template <typename NodeRef>
+static void ReadAccessors(const NodeRef& root, std::vector<ovrTestAccessor>& accessors) {
+    const OVR::JsonReaderT<NodeRef> model(root);
+    const OVR::JsonReaderT<NodeRef> list(model.GetChildByName("accessors"));
+    while (list.IsArray() && !list.IsEndOfArray()) {
+        const OVR::JsonReaderT<NodeRef> node(list.GetNextArrayElement());
+        ovrTestAccessor accessor;
+        accessor.bufferView = node.GetChildInt32ByName("bufferView", -1);
+        accessor.count = node.GetChildInt32ByName("count");
+        const OVR::JsonReaderT<NodeRef> min(node.GetChildByName("min"));
+        const OVR::JsonReaderT<NodeRef> max(node.GetChildByName("max"));
+        for (int i = 0; i < 3 && min.IsArray() && max.IsArray(); i++) {
+            accessor.min[i] = min.GetNextArrayDouble();
+            accessor.max[i] = max.GetNextArrayDouble();
+        }
+        accessors.push_back(accessor);
+    }
+}
+
+static void StreamAccessors(const std::string& text, std::vector<ovrTestAccessor>& accessors) {
+    JsonPullParser parser(text.c_str(), text.length());
+    if (parser.Next() != OVR::JSON_Token_BeginObject) {
+        return;
+    }
+    while (parser.NextMember()) {
+        if (strcmp(parser.GetString(), "accessors") != 0 ||
+            parser.Next() != OVR::JSON_Token_BeginArray) {
+            parser.SkipValue();
+            continue;
+        }
+        while (parser.NextElement()) {
+            ovrTestAccessor accessor;
+            while (parser.GetToken() != OVR::JSON_Token_Error && parser.NextMember()) {
+                const char* name = parser.GetString();
+                if (strcmp(name, "bufferView") == 0) {
+                    accessor.bufferView = parser.ReadInt32(-1);
+                } else if (strcmp(name, "count") == 0) {
+                    accessor.count = parser.ReadInt32();
+                } else if (strcmp(name, "min") == 0) {
+                    parser.ReadNumberArray(accessor.min, 3);
+                } else if (strcmp(name, "max") == 0) {
+                    parser.ReadNumberArray(accessor.max, 3);
+                } else {
+                    parser.SkipValue();
+                }
+            }
+            accessors.push_back(accessor);
+        }
+    }
+}
+
+static bool SameAccessors(
+    const std::vector<ovrTestAccessor>& a,
+    const std::vector<ovrTestAccessor>& b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); i++) {
+        if (a[i].bufferView != b[i].bufferView || a[i].count != b[i].count ||
+            memcmp(a[i].min, b[i].min, sizeof(a[i].min)) != 0 ||
+            memcmp(a[i].max, b[i].max, sizeof(a[i].max)) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+OVR_TEST(JsonPullParser, StreamMatchesTree) {
+    const std::string text = MakeglTFJson(50);
+    std::vector<ovrTestAccessor> fromTree;
+    std::vector<ovrTestAccessor> streamed;
+    ReadAccessors(JSON::Parse(text.c_str()), fromTree);
+    StreamAccessors(text, streamed);
+    OVR_CHECK(fromTree.size() == 50);
+    OVR_CHECK(SameAccessors(fromTree, streamed));
+}
+
+// Time and heap allocations to read the accessors of a large glTF document into an array, the
+// way the glTF loader did with the JSON tree and does now by streaming them.
+OVR_BENCHMARK(JsonPullParser, StreamVsTree) {
+    const std::string text = MakeglTFJson(20000);
+    std::vector<ovrTestAccessor> fromTree;
+    std::vector<ovrTestAccessor> fromDocument;
+    std::vector<ovrTestAccessor> streamed;
+    const auto measure = [](const char* label, const std::function<void()>& read) {
+        const uint64_t baseCount = OVRFW::Test::GetAllocationCount();
+        read();
+        const uint64_t allocations = OVRFW::Test::GetAllocationCount() - baseCount;
+        const double ms = OVRFW::Test::TimeBestOf(5, read);
+        printf("  %-14s %8.2f ms %10llu allocations\n", label, ms, (unsigned long long)allocations);
+    };
+    measure("JSON", [&]() {
+        fromTree.clear();
+        ReadAccessors(JSON::Parse(text.c_str()), fromTree);
+    });
+    measure("JsonDocument", [&]() {
+        fromDocument.clear();
+        const std::shared_ptr<JsonDocument> doc = JsonDocument::Parse(text.c_str());
+        ReadAccessors(doc->GetRoot(), fromDocument);
+    });
+    measure("JsonPullParser", [&]() {
+        streamed.clear();
+        StreamAccessors(text, streamed);
+    });
+    OVR_CHECK(SameAccessors(fromTree, fromDocument));
+    OVR_CHECK(SameAccessors(fromTree, streamed));
+}
@@ -0,0 +1,345 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * Licensed under the Oculus SDK License Agreement (the "License");
+ * you may not use the Oculus SDK except in compliance with the License,
+ * which is provided at the time of installation or download, or which
+ * otherwise accompanies this software in either electronic or hard copy form.
+ *
+ * You may obtain a copy of the License at
+ * https://developer.oculus.com/licenses/oculussdk/
+ *
+ * Unless required by applicable law or agreed to in writing, the Oculus SDK
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/************************************************************************************
+
+Filename    :   ModelFileTests.cpp
+Content     :   Tests for the parallel decoding of glb model files.
+Language    :   C++
+
+*************************************************************************************/
+
+#include "FrameworkTest.h"
+
+#include "Model/ModelFileLoading.h"
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace OVRFW;
+using OVR::Bounds3f;
+using OVR::Vector3f;
+
+// Writes the json and the binary chunk of a glb file.
+class ovrGlbWriter {
+   public:
+    int AddBufferView(const void* data, const size_t size) {
+        Bin.resize((Bin.size() + 3) & ~size_t(3), 0);
+        BinOffsets.push_back(Bin.size());
+        Bin.insert(Bin.end(), (const uint8_t*)data, (const uint8_t*)data + size);
+        AddItem(
+            BufferViews,
+            "{\"buffer\":0,\"byteOffset\":" + std::to_string(BinOffsets.back()) +
+                ",\"byteLength\":" + std::to_string(size) + "}");
+        return static_cast<int>(BinOffsets.size()) - 1;
+    }
+
+    int AddAccessor(
+        const int bufferView,
+        const int componentType,
+        const size_t count,
+        const char* type,
+        const std::string& minMax = std::string()) {
+        AddItem(
+            Accessors,
+            "{\"bufferView\":" + std::to_string(bufferView) +
+                ",\"componentType\":" + std::to_string(componentType) +
+                ",\"count\":" + std::to_string(count) + ",\"type\":\"" + type + "\"" + minMax +
+                "}");
+        return AccessorCount++;
+    }
+
+    std::vector<uint8_t> Write(const std::string& members) {
+        std::string json = "{\"asset\":{\"version\":\"2.0\"},\"buffers\":[{\"byteLength\":" +
+            std::to_string(Bin.size()) + "}],\"bufferViews\":[" + BufferViews +
+            "],\"accessors\":[" + Accessors + "]," + members + "}";
+        json.resize((json.size() + 3) & ~size_t(3), ' ');
+        Bin.resize((Bin.size() + 3) & ~size_t(3), 0);
+
+        std::vector<uint8_t> glb;
+        const uint32_t header[3] = {
+            0x46546C67, 2, static_cast<uint32_t>(12 + 8 + json.size() + 8 + Bin.size())};
+        const uint32_t jsonChunk[2] = {static_cast<uint32_t>(json.size()), 0x4E4F534A};
+        const uint32_t binChunk[2] = {static_cast<uint32_t>(Bin.size()), 0x004E4942};
+        Append(glb, header, sizeof(header));
+        Append(glb, jsonChunk, sizeof(jsonChunk));
+        Append(glb, json.data(), json.size());
+        Append(glb, binChunk, sizeof(binChunk));
+        BinStart = glb.size();
+        Append(glb, Bin.data(), Bin.size());
+        return glb;
+    }
+
+    // Where a buffer view is in the written file.
+    size_t GetFileOffset(const int bufferView) const {
+        return BinStart + BinOffsets[bufferView];
+    }
+
+   private:
+    static void AddItem(std::string& list, const std::string& item) {
+        list += (list.empty() ? "" : ",") + item;
+    }
+    static void Append(std::vector<uint8_t>& out, const void* data, const size_t size) {
+        out.insert(out.end(), (const uint8_t*)data, (const uint8_t*)data + size);
+    }
+
+    std::vector<uint8_t> Bin;
+    std::vector<size_t> BinOffsets;
+    size_t BinStart = 0;
+    std::string BufferViews;
+    std::string Accessors;
+    int AccessorCount = 0;
+};
+
+static const int kFloat = 0x1406;
+static const int kUnsignedShort = 0x1403;
+
+static std::string ToJson(const Vector3f& v) {
+    return "[" + std::to_string(v.x) + "," + std::to_string(v.y) + "," + std::to_string(v.z) +
+        "]";
+}
+
+struct ovrTestGlb {
+    std::vector<uint8_t> file;
+    std::vector<Bounds3f> meshBounds;
+    std::vector<size_t> meshIndexCounts;
+    std::vector<size_t> imageOffsets; // in the file
+    std::vector<size_t> imageSizes;
+    std::vector<std::vector<float>> timeLines;
+    std::vector<size_t> timeLineOffsets; // in the file
+};
+
+// Grids of different sizes and places, png images with made up contents, and an animation
+// with two timelines.
+static ovrTestGlb MakeGlb(const int meshCount, const int imageCount) {
+    ovrTestGlb glb;
+    ovrGlbWriter writer;
+    std::string meshes;
+    std::string nodes;
+    std::string sceneNodes;
+    for (int m = 0; m < meshCount; m++) {
+        const int size = 4 + m;
+        const uint16_t row = static_cast<uint16_t>(size + 1);
+        std::vector<Vector3f> positions;
+        std::vector<uint16_t> indices;
+        Bounds3f bounds(Bounds3f::Init);
+        for (int y = 0; y <= size; y++) {
+            for (int x = 0; x <= size; x++) {
+                positions.push_back(Vector3f(x * 0.5f + m, y * 0.25f - m, 0.125f * m * x));
+                bounds.AddPoint(positions.back());
+                if (x < size && y < size) {
+                    const uint16_t v = static_cast<uint16_t>(y * row + x);
+                    const uint16_t w = static_cast<uint16_t>(v + row);
+                    indices.insert(indices.end(), {v, uint16_t(v + 1), w});
+                    indices.insert(indices.end(), {w, uint16_t(v + 1), uint16_t(w + 1)});
+                }
+            }
+        }
+        glb.meshBounds.push_back(bounds);
+        glb.meshIndexCounts.push_back(indices.size());
+        const int position = writer.AddAccessor(
+            writer.AddBufferView(positions.data(), positions.size() * sizeof(Vector3f)),
+            kFloat,
+            positions.size(),
+            "VEC3",
+            ",\"min\":" + ToJson(bounds.b[0]) + ",\"max\":" + ToJson(bounds.b[1]));
+        const int index = writer.AddAccessor(
+            writer.AddBufferView(indices.data(), indices.size() * sizeof(uint16_t)),
+            kUnsignedShort,
+            indices.size(),
+            "SCALAR");
+        const std::string separator = (m > 0) ? "," : "";
+        meshes += separator + "{\"name\":\"mesh" + std::to_string(m) +
+            "\",\"primitives\":[{\"attributes\":{\"POSITION\":" + std::to_string(position) +
+            "},\"indices\":" + std::to_string(index) + ",\"material\":0}]}";
+        nodes += separator + "{\"mesh\":" + std::to_string(m) + "}";
+        sceneNodes += separator + std::to_string(m);
+    }
+
+    std::string images;
+    std::vector<int> imageViews;
+    for (int i = 0; i < imageCount; i++) {
+        std::vector<uint8_t> image(100 + 37 * i);
+        for (size_t b = 0; b < image.size(); b++) {
+            image[b] = static_cast<uint8_t>(b * 7 + i);
+        }
+        imageViews.push_back(writer.AddBufferView(image.data(), image.size()));
+        glb.imageSizes.push_back(image.size());
+        images += std::string((i > 0) ? "," : "") + "{\"name\":\"image" + std::to_string(i) +
+            "\",\"mimeType\":\"image/png\",\"bufferView\":" + std::to_string(imageViews.back()) +
+            "}";
+    }
+
+    // a fixed rate timeline and one with growing steps
+    std::string samplers;
+    std::string channels;
+    std::vector<int> timeLineViews;
+    const char* paths[] = {"translation", "scale"};
+    for (int t = 0; t < 2; t++) {
+        std::vector<float> times;
+        for (int k = 0; k < 5 + t * 3; k++) {
+            times.push_back(0.5f * t + k * (0.25f + 0.125f * t * k));
+        }
+        const std::vector<Vector3f> values(times.size(), Vector3f(1.0f));
+        timeLineViews.push_back(writer.AddBufferView(times.data(), times.size() * sizeof(float)));
+        const int input = writer.AddAccessor(timeLineViews.back(), kFloat, times.size(), "SCALAR");
+        const int output = writer.AddAccessor(
+            writer.AddBufferView(values.data(), values.size() * sizeof(Vector3f)),
+            kFloat,
+            values.size(),
+            "VEC3");
+        glb.timeLines.push_back(times);
+        const std::string separator = (t > 0) ? "," : "";
+        samplers += separator + "{\"input\":" + std::to_string(input) +
+            ",\"output\":" + std::to_string(output) + "}";
+        channels += separator + "{\"sampler\":" + std::to_string(t) +
+            ",\"target\":{\"node\":0,\"path\":\"" + paths[t] + "\"}}";
+    }
+
+    glb.file = writer.Write(
+        "\"materials\":[{\"name\":\"grid\"}],\"meshes\":[" + meshes + "],\"nodes\":[" + nodes + "],\"scenes\":[{\"nodes\":[" +
+        sceneNodes + "]}],\"scene\":0,\"images\":[" + images + "],\"animations\":[{" +
+        "\"samplers\":[" + samplers + "],\"channels\":[" + channels + "]}]");
+    for (const int view : imageViews) {
+        glb.imageOffsets.push_back(writer.GetFileOffset(view));
+    }
+    for (const int view : timeLineViews) {
+        glb.timeLineOffsets.push_back(writer.GetFileOffset(view));
+    }
+    return glb;
+}
+
+static MaterialParms TestMaterialParms() {
+    MaterialParms materialParms;
+    // keeps the disk cache out of the test
+    materialParms.OptimizeGeometry = false;
+    return materialParms;
+}
+
+// Loading is split between ParallelFor jobs for the primitives, images and timelines, and the
+// calling thread for the GL objects, which the stubs create without a context.
+OVR_TEST(ModelFile, LoadsGlbInPlace) {
+    const int meshCount = 12;
+    const int imageCount = 5;
+    const ovrTestGlb glb = MakeGlb(meshCount, imageCount);
+    auto file = std::make_shared<std::vector<uint8_t>>(glb.file);
+    const uint8_t* fileData = file->data();
+
+    GlProgram program = GlProgram::Build("", "", nullptr, 0);
+    const ModelGlPrograms programs(&program);
+    OVRFW::Test::TakeDecodedFiles();
+    ModelFile* model = LoadModelFile_glB(
+        "test.glb",
+        (const char*)fileData,
+        static_cast<int>(file->size()),
+        programs,
+        TestMaterialParms(),
+        nullptr,
+        file);
+    OVR_CHECK(model != nullptr);
+    if (model == nullptr) {
+        return;
+    }
+
+    // accessors and bounds
+    OVR_CHECK(model->Models.size() == meshCount);
+    for (int m = 0; m < meshCount && m < static_cast<int>(model->Models.size()); m++) {
+        const Model& mesh = model->Models[m];
+        OVR_CHECK(mesh.name == "mesh" + std::to_string(m));
+        OVR_CHECK(mesh.surfaces.size() == 1);
+        const GlGeometry& geo = mesh.surfaces[0].surfaceDef.geo;
+        OVR_CHECK(geo.indexCount == static_cast<int>(glb.meshIndexCounts[m]));
+        OVR_CHECK(geo.localBounds.b[0] == glb.meshBounds[m].b[0]);
+        OVR_CHECK(geo.localBounds.b[1] == glb.meshBounds[m].b[1]);
+    }
+    int boundedAccessors = 0;
+    for (const ModelAccessor& accessor : model->Accessors) {
+        if (accessor.minMaxSet) {
+            const Bounds3f& bounds = glb.meshBounds[boundedAccessors++];
+            for (int k = 0; k < 3; k++) {
+                OVR_CHECK_NEAR(accessor.floatMin[k], bounds.b[0][k], 1e-5f);
+                OVR_CHECK_NEAR(accessor.floatMax[k], bounds.b[1][k], 1e-5f);
+            }
+        }
+    }
+    OVR_CHECK(boundedAccessors == meshCount);
+
+    // the images are decoded where they are in the file
+    OVR_CHECK(model->Textures.size() == imageCount);
+    std::vector<OVRFW::Test::ovrDecodedFile> decoded = OVRFW::Test::TakeDecodedFiles();
+    std::sort(decoded.begin(), decoded.end(), [](const auto& a, const auto& b) {
+        return a.data < b.data;
+    });
+    OVR_CHECK(decoded.size() == imageCount);
+    for (int i = 0; i < imageCount && i < static_cast<int>(decoded.size()); i++) {
+        OVR_CHECK(decoded[i].name == "image" + std::to_string(i) + ".png");
+        OVR_CHECK(decoded[i].data == fileData + glb.imageOffsets[i]);
+        OVR_CHECK(decoded[i].size == glb.imageSizes[i]);
+        OVR_CHECK(model->Textures[i].name == "image" + std::to_string(i));
+        OVR_CHECK(model->Textures[i].texid.IsValid());
+    }
+
+    // timelines
+    OVR_CHECK(model->AnimationTimeLines.size() == 2);
+    for (int t = 0; t < 2 && t < static_cast<int>(model->AnimationTimeLines.size()); t++) {
+        const ModelAnimationTimeLine& timeLine = model->AnimationTimeLines[t];
+        const std::vector<float>& times = glb.timeLines[t];
+        OVR_CHECK(timeLine.sampleCount == static_cast<int>(times.size()));
+        OVR_CHECK((const uint8_t*)timeLine.sampleTimes == fileData + glb.timeLineOffsets[t]);
+        OVR_CHECK(timeLine.startTime == times.front());
+        OVR_CHECK(timeLine.endTime == times.back());
+    }
+    OVR_CHECK(model->animationStartTime == 0.0f);
+    OVR_CHECK(model->animationEndTime == glb.timeLines[1].back());
+
+    // the model holds on to the file, nothing else does
+    OVR_CHECK(file.use_count() > 1);
+    delete model;
+    OVR_CHECK(file.use_count() == 1);
+    GlProgram::Free(program);
+}
+
+// Without an owner the binary chunk is copied once into the model buffer, and the images are
+// decoded from that copy.
+OVR_TEST(ModelFile, LoadsGlbWithoutOwner) {
+    const ovrTestGlb glb = MakeGlb(3, 2);
+    GlProgram program = GlProgram::Build("", "", nullptr, 0);
+    OVRFW::Test::TakeDecodedFiles();
+    ModelFile* model = LoadModelFile_glB(
+        "test.glb",
+        (const char*)glb.file.data(),
+        static_cast<int>(glb.file.size()),
+        ModelGlPrograms(&program),
+        TestMaterialParms());
+    OVR_CHECK(model != nullptr);
+    if (model == nullptr) {
+        return;
+    }
+    OVR_CHECK(model->Buffers.size() == 1 && model->Buffers[0].externalDataOwner == nullptr);
+    const uint8_t* buffer = model->Buffers[0].GetData();
+    std::vector<OVRFW::Test::ovrDecodedFile> decoded = OVRFW::Test::TakeDecodedFiles();
+    OVR_CHECK(decoded.size() == 2);
+    for (const OVRFW::Test::ovrDecodedFile& image : decoded) {
+        OVR_CHECK(image.data >= buffer && image.data < buffer + model->Buffers[0].byteLength);
+    }
+    OVR_CHECK(model->Textures.size() == 2);
+    delete model;
+    GlProgram::Free(program);
+}
@@ -0,0 +1,425 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * Licensed under the Oculus SDK License Agreement (the "License");
+ * you may not use the Oculus SDK except in compliance with the License,
+ * which is provided at the time of installation or download, or which
+ * otherwise accompanies this software in either electronic or hard copy form.
+ *
+ * You may obtain a copy of the License at
+ * https://developer.oculus.com/licenses/oculussdk/
+ *
+ * Unless required by applicable law or agreed to in writing, the Oculus SDK
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/************************************************************************************
+
+Filename    :   ModelRenderTests.cpp
+Content     :   Tests and benchmarks for the culling and sorting of BuildModelSurfaceList.
+Language    :   C++
+
+*************************************************************************************/
+
+#include "FrameworkTest.h"
+
+#include "Model/ModelRender.h"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+using namespace OVRFW;
+using OVR::Bounds3f;
+using OVR::Matrix4f;
+using OVR::Quatf;
+using OVR::Vector3f;
+using OVR::Vector4f;
+
+// Surfaces scattered around the viewer, with a mix of programs, transparent surfaces and a few
+// empty bounds, which are always culled.
+static void MakeSurfaces(
+    const int count,
+    std::vector<ovrSurfaceDef>& surfaces,
+    std::vector<ovrDrawSurface>& emitSurfaces) {
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<float> position(-40.0f, 40.0f);
+    std::uniform_real_distribution<float> size(0.1f, 3.0f);
+    surfaces.resize(count);
+    emitSurfaces.resize(count);
+    for (int i = 0; i < count; i++) {
+        ovrSurfaceDef& surface = surfaces[i];
+        const Vector3f mins(-size(rng), -size(rng), -size(rng));
+        const Vector3f maxs = (i % 97 == 0) ? Vector3f(mins.x, mins.y, 1.0f)
+                                            : Vector3f(size(rng), size(rng), size(rng));
+        surface.geo.localBounds = Bounds3f(mins, maxs);
+        surface.graphicsCommand.Program.Program = 1 + (i % 5);
+        surface.graphicsCommand.GpuState.blendEnable =
+            (i % 7 == 0) ? ovrGpuState::BLEND_ENABLE : ovrGpuState::BLEND_DISABLE;
+        emitSurfaces[i] = ovrDrawSurface(
+            Matrix4f::Translation(position(rng), position(rng), position(rng)) *
+                Matrix4f::RotationY(position(rng)),
+            &surface);
+    }
+}
+
+static void MakeViewProjection(Matrix4f& viewMatrix, Matrix4f& projectionMatrix) {
+    viewMatrix = Matrix4f::LookAtRH(Vector3f(1, 2, 3), Vector3f(10, 0, -20), Vector3f(0, 1, 0));
+    projectionMatrix = Matrix4f::PerspectiveRH(OVR::DegreeToRad(90.0f), 1.0f, 0.1f, 100.0f);
+}
+
+// The culling and sorting BuildModelSurfaceList used to do: all 8 bounds corners through the
+// mvp, sorted with std::stable_sort on transparency and the farthest W.
+static float ReferenceCullKey(const Bounds3f& bounds, const Matrix4f& mvp) {
+    if (bounds.b[1].x == bounds.b[0].x && bounds.b[1].y == bounds.b[0].y) {
+        return 0.0f;
+    }
+    Vector4f c[8];
+    for (int i = 0; i < 8; i++) {
+        c[i] = mvp.Transform(Vector4f(
+            bounds.b[(i & 1)].x, bounds.b[(i & 2) >> 1].y, bounds.b[(i & 4) >> 2].z, 1.0f));
+    }
+    for (int axis = 0; axis < 3; axis++) {
+        bool allBelow = true;
+        bool allAbove = true;
+        for (int i = 0; i < 8; i++) {
+            allBelow = allBelow && !(c[i][axis] > -c[i].w);
+            allAbove = allAbove && !(c[i][axis] < c[i].w);
+        }
+        if (allBelow || allAbove) {
+            return 0.0f;
+        }
+    }
+    float maxW = 0.0f;
+    for (int i = 0; i < 8; i++) {
+        maxW = std::max(maxW, c[i].w);
+    }
+    return maxW;
+}
+
+struct referenceSort_t {
+    float key;
+    Matrix4f modelMatrix;
+    const ovrSurfaceDef* surface;
+    bool transparent;
+
+    bool operator<(const referenceSort_t& other) const {
+        if (transparent != other.transparent) {
+            return !transparent;
+        }
+        return transparent ? (key > other.key) : (key < other.key);
+    }
+};
+
+// Without the old cap of 1024 surfaces.
+static void ReferenceSurfaceList(
+    std::vector<ovrDrawSurface>& surfaceList,
+    std::vector<referenceSort_t>& sorted,
+    const std::vector<ovrDrawSurface>& emitSurfaces,
+    const Matrix4f& vpMatrix) {
+    sorted.clear();
+    for (const ovrDrawSurface& drawSurf : emitSurfaces) {
+        const ovrSurfaceDef& surface = *drawSurf.surface;
+        const float key =
+            ReferenceCullKey(surface.geo.localBounds, vpMatrix * drawSurf.modelMatrix);
+        if (key > 0.0f) {
+            sorted.push_back(
+                {key,
+                 drawSurf.modelMatrix,
+                 &surface,
+                 surface.graphicsCommand.GpuState.blendEnable != ovrGpuState::BLEND_DISABLE});
+        }
+    }
+    std::stable_sort(sorted.begin(), sorted.end());
+    surfaceList.resize(sorted.size());
+    for (size_t i = 0; i < sorted.size(); i++) {
+        surfaceList[i].modelMatrix = sorted[i].modelMatrix;
+        surfaceList[i].surface = sorted[i].surface;
+    }
+}
+
+OVR_TEST(ModelRender, CullMatchesCorners) {
+    // more surfaces than the old 1024 cap, and enough to be culled on the worker threads
+    std::vector<ovrSurfaceDef> surfaces;
+    std::vector<ovrDrawSurface> emitSurfaces;
+    MakeSurfaces(3000, surfaces, emitSurfaces);
+    Matrix4f viewMatrix;
+    Matrix4f projectionMatrix;
+    MakeViewProjection(viewMatrix, projectionMatrix);
+
+    std::vector<ovrDrawSurface> surfaceList;
+    BuildModelSurfaceList(surfaceList, {}, emitSurfaces, viewMatrix, projectionMatrix);
+    std::vector<ovrDrawSurface> reference;
+    std::vector<referenceSort_t> sorted;
+    ReferenceSurfaceList(reference, sorted, emitSurfaces, projectionMatrix * viewMatrix);
+
+    OVR_CHECK(reference.size() > 100 && reference.size() < emitSurfaces.size());
+    OVR_CHECK(surfaceList.size() == reference.size());
+
+    // The same surfaces are drawn, solid ones first.
+    std::vector<const ovrSurfaceDef*> expected;
+    std::vector<const ovrSurfaceDef*> actual;
+    for (const ovrDrawSurface& s : reference) {
+        expected.push_back(s.surface);
+    }
+    for (const ovrDrawSurface& s : surfaceList) {
+        actual.push_back(s.surface);
+    }
+    const auto isTransparent = [](const ovrSurfaceDef* s) {
+        return s->graphicsCommand.GpuState.blendEnable != ovrGpuState::BLEND_DISABLE;
+    };
+    OVR_CHECK(std::is_partitioned(actual.begin(), actual.end(), [&](const ovrSurfaceDef* s) {
+        return !isTransparent(s);
+    }));
+    // Transparent surfaces keep the back-to-front order exactly.
+    const auto firstTransparent = std::find_if(actual.begin(), actual.end(), isTransparent);
+    const auto expectedTransparent = std::find_if(expected.begin(), expected.end(), isTransparent);
+    OVR_CHECK(std::equal(firstTransparent, actual.end(), expectedTransparent, expected.end()));
+    std::sort(expected.begin(), expected.end());
+    std::sort(actual.begin(), actual.end());
+    OVR_CHECK(expected == actual);
+}
+
+OVR_TEST(ModelRender, SolidSurfacesGroupByProgram) {
+    std::vector<ovrSurfaceDef> surfaces;
+    std::vector<ovrDrawSurface> emitSurfaces;
+    MakeSurfaces(500, surfaces, emitSurfaces);
+    Matrix4f viewMatrix;
+    Matrix4f projectionMatrix;
+    MakeViewProjection(viewMatrix, projectionMatrix);
+
+    std::vector<ovrDrawSurface> surfaceList;
+    BuildModelSurfaceList(surfaceList, {}, emitSurfaces, viewMatrix, projectionMatrix);
+
+    // Each program of the solid surfaces is bound once, and its surfaces go front-to-back.
+    const Matrix4f vpMatrix = projectionMatrix * viewMatrix;
+    int programChanges = 0;
+    unsigned int program = 0;
+    float previousKey = 0.0f;
+    for (const ovrDrawSurface& s : surfaceList) {
+        const ovrGraphicsCommand& cmd = s.surface->graphicsCommand;
+        if (cmd.GpuState.blendEnable != ovrGpuState::BLEND_DISABLE) {
+            break;
+        }
+        const float key = ReferenceCullKey(s.surface->geo.localBounds, vpMatrix * s.modelMatrix);
+        if (cmd.Program.Program != program) {
+            program = cmd.Program.Program;
+            programChanges++;
+        } else {
+            OVR_CHECK(key >= previousKey * (1.0f - 1e-5f));
+        }
+        previousKey = key;
+    }
+    OVR_CHECK(programChanges == 5);
+}
+
+// A column of vertices from y = 0 to 2 skinned to two joints, the lower half to joint A at the
+// origin and the upper half to joint B at y = 1, blended around B. The skinned mesh node and
+// joint A are children of a root node, joint B is a child of joint A.
+struct ovrSkinnedColumn {
+    enum { ROOT, JOINT_A, JOINT_B, MESH };
+
+    ModelFile model;
+    ModelState state;
+    std::vector<Vector3f> positions;
+    std::vector<Vector4f> weights; // of joint A and B
+};
+
+static void MakeSkinnedColumn(ovrSkinnedColumn& column) {
+    ModelFile& mf = column.model;
+    mf.Nodes.resize(4);
+    mf.Nodes[ovrSkinnedColumn::ROOT].translation = Vector3f(0.0f, 0.0f, -2.0f);
+    mf.Nodes[ovrSkinnedColumn::ROOT].rotation = Quatf(Vector3f(0.0f, 1.0f, 0.0f), 0.3f);
+    mf.Nodes[ovrSkinnedColumn::ROOT].children = {ovrSkinnedColumn::JOINT_A, ovrSkinnedColumn::MESH};
+    mf.Nodes[ovrSkinnedColumn::JOINT_A].parentIndex = ovrSkinnedColumn::ROOT;
+    mf.Nodes[ovrSkinnedColumn::JOINT_A].children = {ovrSkinnedColumn::JOINT_B};
+    mf.Nodes[ovrSkinnedColumn::JOINT_B].parentIndex = ovrSkinnedColumn::JOINT_A;
+    mf.Nodes[ovrSkinnedColumn::JOINT_B].translation = Vector3f(0.0f, 1.0f, 0.0f);
+    mf.Nodes[ovrSkinnedColumn::MESH].parentIndex = ovrSkinnedColumn::ROOT;
+    mf.Nodes[ovrSkinnedColumn::MESH].skinIndex = 0;
+
+    for (int k = 0; k <= 8; k++) {
+        const float y = k * 0.25f;
+        const float a = std::min(std::max(1.5f - y, 0.0f), 1.0f);
+        for (const float x : {-0.1f, 0.1f}) {
+            column.positions.push_back(Vector3f(x, y, 0.0f));
+            column.weights.push_back(Vector4f(a, 1.0f - a, 0.0f, 0.0f));
+        }
+    }
+    mf.Models.resize(1);
+    mf.Models[0].surfaces.resize(1);
+    ModelSurface& surface = mf.Models[0].surfaces[0];
+    surface.jointBounds.assign(2, Bounds3f(Bounds3f::Init));
+    surface.surfaceDef.geo.localBounds.Clear();
+    for (size_t v = 0; v < column.positions.size(); v++) {
+        surface.surfaceDef.geo.localBounds.AddPoint(column.positions[v]);
+        for (int j = 0; j < 2; j++) {
+            if (column.weights[v][j] > 0.0f) {
+                surface.jointBounds[j].AddPoint(column.positions[v]);
+            }
+        }
+    }
+    mf.Nodes[ovrSkinnedColumn::MESH].model = &mf.Models[0];
+
+    column.state.GenerateStateFromModelFile(&mf);
+    for (ModelNodeState& nodeState : column.state.nodeStates) {
+        nodeState.CalculateLocalTransform();
+    }
+    column.state.nodeStates[ovrSkinnedColumn::ROOT].RecalculateMatrix();
+
+    // the bind pose is the pose the column is built in
+    ModelSkin skin;
+    const Matrix4f inverseMesh =
+        column.state.nodeStates[ovrSkinnedColumn::MESH].GetGlobalTransform().Inverted();
+    for (const int joint : {ovrSkinnedColumn::JOINT_A, ovrSkinnedColumn::JOINT_B}) {
+        skin.jointIndexes.push_back(joint);
+        skin.inverseBindMatrices.push_back(
+            (inverseMesh * column.state.nodeStates[joint].GetGlobalTransform()).Inverted());
+    }
+    mf.Skins.push_back(skin);
+}
+
+static void PoseSkinnedColumn(ovrSkinnedColumn& column, const Vector3f& translation) {
+    ModelNodeState& jointA = column.state.nodeStates[ovrSkinnedColumn::JOINT_A];
+    jointA.translation = translation;
+    jointA.rotation = Quatf(Vector3f(0.0f, 0.0f, 1.0f), 0.5f);
+    jointA.CalculateLocalTransform();
+    ModelNodeState& jointB = column.state.nodeStates[ovrSkinnedColumn::JOINT_B];
+    jointB.rotation = Quatf(Vector3f(1.0f, 0.0f, 1.0f).Normalized(), 1.5f);
+    jointB.CalculateLocalTransform();
+    column.state.nodeStates[ovrSkinnedColumn::ROOT].RecalculateMatrix();
+}
+
+// The skinned vertices in the space of the mesh node, the way the vertex shader skins them.
+static std::vector<Vector3f> GetSkinnedPositions(const ovrSkinnedColumn& column) {
+    const ModelSkin& skin = column.model.Skins[0];
+    const Matrix4f inverseMesh =
+        column.state.nodeStates[ovrSkinnedColumn::MESH].GetGlobalTransform().Inverted();
+    Matrix4f jointMatrices[2];
+    for (int j = 0; j < 2; j++) {
+        jointMatrices[j] = inverseMesh *
+            column.state.nodeStates[skin.jointIndexes[j]].GetGlobalTransform() *
+            skin.inverseBindMatrices[j];
+    }
+    std::vector<Vector3f> skinned;
+    for (size_t v = 0; v < column.positions.size(); v++) {
+        Vector3f p(0.0f);
+        for (int j = 0; j < 2; j++) {
+            p += jointMatrices[j].Transform(column.positions[v]) * column.weights[v][j];
+        }
+        skinned.push_back(p);
+    }
+    return skinned;
+}
+
+// Looks down -Z at target from 6 units away, with a 40 degree field of view.
+static void MakeViewProjectionAt(
+    const Vector3f& target,
+    Matrix4f& viewMatrix,
+    Matrix4f& projectionMatrix) {
+    viewMatrix = Matrix4f::LookAtRH(target + Vector3f(0, 0, 6), target, Vector3f(0, 1, 0));
+    projectionMatrix = Matrix4f::PerspectiveRH(OVR::DegreeToRad(40.0f), 1.0f, 0.1f, 100.0f);
+}
+
+OVR_TEST(ModelRender, SkinnedBoundsContainThePose) {
+    ovrSkinnedColumn column;
+    MakeSkinnedColumn(column);
+    const ModelNodeState& meshState = column.state.nodeStates[ovrSkinnedColumn::MESH];
+    const ModelSurface& surface = column.model.Models[0].surfaces[0];
+
+    // the bind pose gives back the bind pose bounds
+    Bounds3f bounds;
+    OVR_CHECK(CalculateSkinnedSurfaceBounds(meshState, surface, bounds));
+    const Bounds3f& bindBounds = surface.surfaceDef.geo.localBounds;
+    OVR_CHECK((bounds.b[0] - bindBounds.b[0]).Length() < 1e-5f);
+    OVR_CHECK((bounds.b[1] - bindBounds.b[1]).Length() < 1e-5f);
+
+    for (const Vector3f& translation :
+         {Vector3f(0.0f), Vector3f(6.0f, 0.0f, 0.0f), Vector3f(-2.0f, 3.0f, 1.0f)}) {
+        PoseSkinnedColumn(column, translation);
+        OVR_CHECK(CalculateSkinnedSurfaceBounds(meshState, surface, bounds));
+        bool contained = true;
+        for (const Vector3f& p : GetSkinnedPositions(column)) {
+            contained = contained && bounds.Contains(p, 1e-5f);
+        }
+        OVR_CHECK(contained);
+    }
+
+    // without joint bounds a skinned surface can't be bounded
+    ModelSurface unbounded;
+    OVR_CHECK(!CalculateSkinnedSurfaceBounds(meshState, unbounded, bounds));
+}
+
+OVR_TEST(ModelRender, SkinnedSurfacesCullInThePose) {
+    ovrSkinnedColumn column;
+    MakeSkinnedColumn(column);
+    const ModelNodeState& meshState = column.state.nodeStates[ovrSkinnedColumn::MESH];
+    const Matrix4f meshMatrix = meshState.GetGlobalTransform();
+    const Bounds3f& bindBounds = column.model.Models[0].surfaces[0].surfaceDef.geo.localBounds;
+    const Vector3f bindCenter = meshMatrix.Transform(bindBounds.GetCenter());
+    std::vector<ModelNodeState*> emitNodes;
+    column.state.nodeStates[ovrSkinnedColumn::ROOT].AddNodesToEmitList(emitNodes);
+
+    PoseSkinnedColumn(column, Vector3f(6.0f, 0.0f, 0.0f));
+    Vector3f posedCenter(0.0f);
+    const std::vector<Vector3f> skinned = GetSkinnedPositions(column);
+    for (const Vector3f& p : skinned) {
+        posedCenter += meshMatrix.Transform(p) / static_cast<float>(skinned.size());
+    }
+
+    // Looking at the posed column draws it, although its bind pose is out of view.
+    Matrix4f viewMatrix;
+    Matrix4f projectionMatrix;
+    MakeViewProjectionAt(posedCenter, viewMatrix, projectionMatrix);
+    OVR_CHECK(ReferenceCullKey(bindBounds, projectionMatrix * viewMatrix * meshMatrix) == 0.0f);
+    std::vector<ovrDrawSurface> surfaceList;
+    BuildModelSurfaceList(surfaceList, emitNodes, {}, viewMatrix, projectionMatrix);
+    OVR_CHECK(surfaceList.size() == 1 && surfaceList[0].modelMatrix == meshMatrix);
+
+    // Looking at the bind pose culls it, although its bind pose is in view.
+    MakeViewProjectionAt(bindCenter, viewMatrix, projectionMatrix);
+    OVR_CHECK(ReferenceCullKey(bindBounds, projectionMatrix * viewMatrix * meshMatrix) > 0.0f);
+    BuildModelSurfaceList(surfaceList, emitNodes, {}, viewMatrix, projectionMatrix);
+    OVR_CHECK(surfaceList.empty());
+
+    // A skinned surface that can't be bounded is never culled.
+    column.model.Models[0].surfaces[0].jointBounds.clear();
+    BuildModelSurfaceList(surfaceList, emitNodes, {}, viewMatrix, projectionMatrix);
+    OVR_CHECK(surfaceList.size() == 1);
+}
+
+// Surfaces per millisecond for culling and sorting the emit list, against the 8 corner
+// transform and std::stable_sort it replaced.
+OVR_BENCHMARK(ModelRender, BuildModelSurfaceList) {
+    Matrix4f viewMatrix;
+    Matrix4f projectionMatrix;
+    MakeViewProjection(viewMatrix, projectionMatrix);
+    const Matrix4f vpMatrix = projectionMatrix * viewMatrix;
+
+    for (const int count : {1000, 4000, 16000}) {
+        std::vector<ovrSurfaceDef> surfaces;
+        std::vector<ovrDrawSurface> emitSurfaces;
+        MakeSurfaces(count, surfaces, emitSurfaces);
+
+        std::vector<ovrDrawSurface> surfaceList;
+        std::vector<ovrDrawSurface> reference;
+        std::vector<referenceSort_t> sorted;
+        const int runs = 20;
+        const double buildMs = OVRFW::Test::TimeBestOf(runs, [&]() {
+            BuildModelSurfaceList(surfaceList, {}, emitSurfaces, viewMatrix, projectionMatrix);
+        });
+        const double referenceMs = OVRFW::Test::TimeBestOf(
+            runs, [&]() { ReferenceSurfaceList(reference, sorted, emitSurfaces, vpMatrix); });
+        printf(
+            "  %5d surfaces, %5d visible: BuildModelSurfaceList %8.0f surfaces/ms, "
+            "corners + stable_sort %8.0f surfaces/ms\n",
+            count,
+            static_cast<int>(surfaceList.size()),
+            count / buildMs,
+            count / referenceMs);
+        OVR_CHECK(surfaceList.size() == reference.size());
+    }
+}
@@ -0,0 +1,193 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * Licensed under the Oculus SDK License Agreement (the "License");
+ * you may not use the Oculus SDK except in compliance with the License,
+ * which is provided at the time of installation or download, or which
+ * otherwise accompanies this software in either electronic or hard copy form.
+ *
+ * You may obtain a copy of the License at
+ * https://developer.oculus.com/licenses/oculussdk/
+ *
+ * Unless required by applicable law or agreed to in writing, the Oculus SDK
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/************************************************************************************
+
+Filename    :   ModelTraceTests.cpp
+Content     :   Tests and benchmarks for the kd-tree builder and traces of ModelTrace.
+Language    :   C++
+
+*************************************************************************************/
+
+#include "FrameworkTest.h"
+
+#include "Model/ModelTrace.h"
+
+#include <random>
+#include <vector>
+
+using namespace OVRFW;
+using OVR::Vector2f;
+using OVR::Vector3f;
+
+// A bumpy sphere of about 2 * rings * segments triangles plus some scattered triangles, so the
+// tree has both dense and sparse regions.
+static void MakeTraceMesh(
+    const int rings,
+    const int segments,
+    std::vector<Vector3f>& vertices,
+    std::vector<Vector2f>& uvs,
+    std::vector<int>& indices) {
+    for (int r = 0; r <= rings; r++) {
+        for (int s = 0; s <= segments; s++) {
+            const float theta = r * MATH_FLOAT_PI / rings;
+            const float phi = s * MATH_FLOAT_TWOPI / segments;
+            const float radius = 1.0f + 0.05f * sinf(theta * 7.0f) * cosf(phi * 5.0f);
+            vertices.push_back(Vector3f(
+                radius * sinf(theta) * cosf(phi),
+                radius * cosf(theta),
+                radius * sinf(theta) * sinf(phi)));
+            uvs.push_back(Vector2f((float)s / segments, (float)r / rings));
+        }
+    }
+    for (int r = 0; r < rings; r++) {
+        for (int s = 0; s < segments; s++) {
+            const int v = r * (segments + 1) + s;
+            indices.insert(indices.end(), {v, v + segments + 1, v + segments + 2});
+            indices.insert(indices.end(), {v, v + segments + 2, v + 1});
+        }
+    }
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> position(-3.0f, 3.0f);
+    std::uniform_real_distribution<float> offset(-0.2f, 0.2f);
+    for (int t = 0; t < 200; t++) {
+        const Vector3f center(position(rng), position(rng), position(rng));
+        for (int k = 0; k < 3; k++) {
+            indices.push_back(static_cast<int>(vertices.size()));
+            vertices.push_back(center + Vector3f(offset(rng), offset(rng), offset(rng)));
+            uvs.push_back(Vector2f(0.0f, 0.0f));
+        }
+    }
+}
+
+static void MakeRays(const int count, std::vector<Vector3f>& starts, std::vector<Vector3f>& ends) {
+    std::mt19937 rng(11);
+    std::uniform_real_distribution<float> position(-4.0f, 4.0f);
+    for (int i = 0; i < count; i++) {
+        starts.push_back(Vector3f(position(rng), position(rng), position(rng)));
+        ends.push_back(Vector3f(position(rng), position(rng), position(rng)));
+    }
+}
+
+static bool SameHit(const traceResult_t& a, const traceResult_t& b) {
+    if ((a.triangleIndex < 0) != (b.triangleIndex < 0)) {
+        return false;
+    }
+    // a ray through a shared edge may report either triangle, but at the same distance
+    return a.triangleIndex < 0 || std::fabs(a.fraction - b.fraction) <= 1e-5f;
+}
+
+OVR_TEST(ModelTrace, MatchesExhaustive) {
+    std::vector<Vector3f> vertices;
+    std::vector<Vector2f> uvs;
+    std::vector<int> indices;
+    MakeTraceMesh(24, 48, vertices, uvs, indices);
+
+    ModelTrace trace;
+    OVR_CHECK(trace.Build(vertices, uvs, indices));
+    OVR_CHECK(trace.Validate(true));
+
+    std::vector<Vector3f> starts;
+    std::vector<Vector3f> ends;
+    MakeRays(2000, starts, ends);
+    std::vector<traceResult_t> batch(starts.size());
+    trace.TraceBatch(starts.data(), ends.data(), static_cast<int>(starts.size()), batch.data());
+
+    int hits = 0;
+    int mismatches = 0;
+    for (size_t i = 0; i < starts.size(); i++) {
+        const traceResult_t exhaustive = trace.Trace_Exhaustive(starts[i], ends[i]);
+        const traceResult_t single = trace.Trace(starts[i], ends[i]);
+        hits += (exhaustive.triangleIndex >= 0) ? 1 : 0;
+        mismatches += (SameHit(exhaustive, single) && SameHit(exhaustive, batch[i])) ? 0 : 1;
+    }
+    OVR_CHECK(hits > 100);
+    OVR_CHECK(mismatches == 0);
+}
+
+OVR_TEST(ModelTrace, DegenerateInput) {
+    // a model without triangles, and one with only a zero area triangle, still build a valid
+    // tree that nothing hits
+    ModelTrace empty;
+    OVR_CHECK(empty.Build({Vector3f(0, 0, 0)}, {}, {}));
+    OVR_CHECK(empty.Validate(true));
+    OVR_CHECK(empty.Trace(Vector3f(-1, -1, -1), Vector3f(1, 1, 1)).triangleIndex == -1);
+
+    ModelTrace line;
+    OVR_CHECK(line.Build({Vector3f(0, 0, 0), Vector3f(1, 0, 0), Vector3f(2, 0, 0)}, {}, {0, 1, 2}));
+    OVR_CHECK(line.Validate(true));
+    OVR_CHECK(line.Trace(Vector3f(0.5f, -1, 0), Vector3f(0.5f, 1, 0)).triangleIndex == -1);
+
+    // rays pointing away from the model never reach it
+    ModelTrace quad;
+    OVR_CHECK(quad.Build(
+        {Vector3f(-1, -1, 0), Vector3f(1, -1, 0), Vector3f(1, 1, 0), Vector3f(-1, 1, 0)},
+        {},
+        {0, 1, 2, 0, 2, 3}));
+    OVR_CHECK(quad.Trace(Vector3f(0, 0, 1), Vector3f(0, 0, 2)).triangleIndex == -1);
+    const traceResult_t hit = quad.Trace(Vector3f(0.1f, 0.2f, 1), Vector3f(0.1f, 0.2f, -1));
+    OVR_CHECK(hit.triangleIndex >= 0);
+    OVR_CHECK_NEAR(hit.fraction, 0.5f, 1e-5f);
+
+    // out of range indices and mismatched uvs are rejected
+    OVR_CHECK(!quad.Build({Vector3f(0, 0, 0)}, {}, {0, 0, 1}));
+    OVR_CHECK(!quad.Build({Vector3f(0, 0, 0)}, {Vector2f(0, 0), Vector2f(1, 1)}, {0, 0, 0}));
+}
+
+// Build time of the SAH kd-tree, and time per ray of the exhaustive trace, single traces
+// through the tree and batched traces.
+OVR_BENCHMARK(ModelTrace, TraceVsExhaustive) {
+    std::vector<Vector3f> vertices;
+    std::vector<Vector2f> uvs;
+    std::vector<int> indices;
+    MakeTraceMesh(128, 256, vertices, uvs, indices);
+    std::vector<Vector3f> starts;
+    std::vector<Vector3f> ends;
+    MakeRays(4096, starts, ends);
+    const int rayCount = static_cast<int>(starts.size());
+
+    ModelTrace trace;
+    const double buildMs =
+        OVRFW::Test::TimeBestOf(3, [&]() { trace.Build(vertices, uvs, indices); });
+    printf(
+        "  %d triangles, build %.2f ms, %d nodes %d leafs\n",
+        static_cast<int>(indices.size() / 3),
+        buildMs,
+        trace.header.numNodes,
+        trace.header.numLeafs);
+
+    int sum = 0;
+    const int exhaustiveRays = 256; // far too slow for all of them
+    const double exhaustiveMs = OVRFW::Test::TimeBestOf(1, [&]() {
+        for (int i = 0; i < exhaustiveRays; i++) {
+            sum += trace.Trace_Exhaustive(starts[i], ends[i]).triangleIndex;
+        }
+    });
+    const double singleMs = OVRFW::Test::TimeBestOf(3, [&]() {
+        for (int i = 0; i < rayCount; i++) {
+            sum += trace.Trace(starts[i], ends[i]).triangleIndex;
+        }
+    });
+    std::vector<traceResult_t> results(rayCount);
+    const double batchMs = OVRFW::Test::TimeBestOf(
+        3, [&]() { trace.TraceBatch(starts.data(), ends.data(), rayCount, results.data()); });
+    printf("  Trace_Exhaustive %10.3f us per ray\n", exhaustiveMs * 1000.0 / exhaustiveRays);
+    printf("  Trace            %10.3f us per ray\n", singleMs * 1000.0 / rayCount);
+    printf("  TraceBatch       %10.3f us per ray\n", batchMs * 1000.0 / rayCount);
+    OVR_CHECK(sum != 0);
+}
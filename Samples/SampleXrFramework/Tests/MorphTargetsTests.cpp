@@ -0,0 +1,259 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * Licensed under the Oculus SDK License Agreement (the "License");
+ * you may not use the Oculus SDK except in compliance with the License,
+ * which is provided at the time of installation or download, or which
+ * otherwise accompanies this software in either electronic or hard copy form.
+ *
+ * You may obtain a copy of the License at
+ * https://developer.oculus.com/licenses/oculussdk/
+ *
+ * Unless required by applicable law or agreed to in writing, the Oculus SDK
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/************************************************************************************
+
+Filename    :   MorphTargetsTests.cpp
+Content     :   Tests and benchmarks for the sparse morph target evaluation.
+Language    :   C++
+
+*************************************************************************************/
+
+#include "FrameworkTest.h"
+
+#include "Render/MorphTargets.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace OVRFW;
+using OVR::Vector2f;
+using OVR::Vector3f;
+
+static VertexAttribs MakeBase(const int count, std::mt19937& rng) {
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    VertexAttribs base;
+    for (int v = 0; v < count; v++) {
+        base.position.push_back(Vector3f(unit(rng), unit(rng), unit(rng)));
+        base.normal.push_back(Vector3f(unit(rng), unit(rng), 2.0f).Normalized());
+        base.uv0.push_back(Vector2f(0.5f + 0.4f * unit(rng), 0.5f));
+    }
+    return base;
+}
+
+// The vertices after Upload, which only sends the range the targets move.
+static std::vector<uint8_t> GetUploadedVertices(
+    const MorphTargets& morph,
+    const VertexAttribs& base,
+    VertexStreamLayout& stream) {
+    std::vector<uint8_t> packed;
+    stream = PackVertexAttribs(base, morph.GetVertexLayout(), packed);
+    GlGeometry geo;
+    geo.vertexCount = static_cast<int>(base.position.size());
+    morph.Upload(geo);
+    size_t offset = 0;
+    const std::vector<uint8_t>& update = OVRFW::Test::GetLastVertexUpdate(offset);
+    if (offset + update.size() <= packed.size()) {
+        std::copy(update.begin(), update.end(), packed.begin() + offset);
+    }
+    return packed;
+}
+
+template <typename T>
+static T
+ReadVertex(const std::vector<uint8_t>& packed, const int stride, const int v, const int at) {
+    T value;
+    memcpy(&value, &packed[static_cast<size_t>(v) * stride + at], sizeof(value));
+    return value;
+}
+
+// Deltas that are whole quantization steps of 2^-15 are stored exactly, so the SIMD evaluation
+// must match a scalar one that adds the same steps in the same order.
+OVR_TEST(MorphTargets, EvaluateMatchesScalar) {
+    const int vertexCount = 1000;
+    const int targetCount = 8;
+    const float step = 1.0f / 32768.0f;
+    std::mt19937 rng(25);
+    const VertexAttribs base = MakeBase(vertexCount, rng);
+    std::uniform_int_distribution<int> quantized(-32767, 32767);
+    std::vector<VertexAttribs> targets(targetCount);
+    for (int t = 0; t < targetCount; t++) {
+        VertexAttribs& target = targets[t];
+        target.position.resize(vertexCount, Vector3f(0.0f));
+        target.normal.resize(vertexCount, Vector3f(0.0f));
+        if (t % 2 == 0) {
+            target.uv0.resize(vertexCount, Vector2f(0.0f));
+        }
+        for (int v = (t * 37) % 4; v < vertexCount; v += 4 + t) {
+            for (int k = 0; k < 3; k++) {
+                target.position[v][k] = quantized(rng) * step;
+                target.normal[v][k] = quantized(rng) * step;
+            }
+            if (!target.uv0.empty()) {
+                target.uv0[v] = Vector2f(quantized(rng) * step, quantized(rng) * step);
+            }
+        }
+        // the largest delta sets the step
+        target.position[t].x = 32767.0f * step;
+        target.normal[t].y = -32767.0f * step;
+        if (!target.uv0.empty()) {
+            target.uv0[t].x = 32767.0f * step;
+        }
+    }
+    MorphTargets morph;
+    morph.Build(base, targets);
+    OVR_CHECK(morph.GetTargetCount() == targetCount);
+    OVR_CHECK(morph.GetVertexLayout().normal == VertexFormat::Float32);
+    OVR_CHECK(morph.GetVertexLayout().uv0 == VertexFormat::Float32);
+
+    const std::vector<float> weights = {0.25f, 0.0f, 1.0f, 0.7f, -0.5f, 0.0f, 0.125f, 0.9f};
+    OVR_CHECK(morph.Evaluate(weights));
+    VertexStreamLayout s;
+    const std::vector<uint8_t> packed = GetUploadedVertices(morph, base, s);
+
+    float maxError = 0.0f;
+    for (int v = 0; v < vertexCount; v++) {
+        Vector3f position = base.position[v];
+        Vector3f normal = base.normal[v];
+        Vector2f uv0 = base.uv0[v];
+        for (int t = 0; t < targetCount; t++) {
+            if (weights[t] == 0.0f) {
+                continue;
+            }
+            const float scale = weights[t] * step;
+            // the deltas are whole steps, so dividing by the step gives back the stored value
+            for (int k = 0; k < 3; k++) {
+                position[k] += (targets[t].position[v][k] / step) * scale;
+                normal[k] += (targets[t].normal[v][k] / step) * scale;
+            }
+            if (!targets[t].uv0.empty()) {
+                for (int k = 0; k < 2; k++) {
+                    uv0[k] += (targets[t].uv0[v][k] / step) * scale;
+                }
+            }
+        }
+        const Vector3f p = ReadVertex<Vector3f>(packed, s.stride, v, s.position);
+        const Vector3f n = ReadVertex<Vector3f>(packed, s.stride, v, s.normal);
+        const Vector2f uv = ReadVertex<Vector2f>(packed, s.stride, v, s.uv0);
+        maxError = std::max(maxError, (p - position).Length());
+        maxError = std::max(maxError, (n - normal).Length());
+        maxError = std::max(maxError, (uv - uv0).Length());
+    }
+    OVR_CHECK(maxError <= 1e-6f);
+}
+
+OVR_TEST(MorphTargets, EvaluateMatchesDenseTargets) {
+    const int vertexCount = 500;
+    const int targetCount = 16;
+    std::mt19937 rng(250);
+    const VertexAttribs base = MakeBase(vertexCount, rng);
+    std::uniform_real_distribution<float> delta(-0.02f, 0.02f);
+    std::vector<VertexAttribs> targets(targetCount);
+    for (int t = 0; t < targetCount; t++) {
+        targets[t].position.resize(vertexCount, Vector3f(0.0f));
+        // each target moves a region of the mesh, vertices past 400 never move
+        for (int v = t * 20; v < t * 20 + 80; v++) {
+            targets[t].position[v] = Vector3f(delta(rng), delta(rng), delta(rng));
+        }
+    }
+    MorphTargets morph;
+    morph.Build(base, targets);
+
+    std::uniform_real_distribution<float> weight(0.0f, 1.0f);
+    std::vector<float> weights(targetCount);
+    for (float& w : weights) {
+        w = weight(rng);
+    }
+    weights[3] = 0.0f;
+    OVR_CHECK(morph.Evaluate(weights));
+    OVR_CHECK(!morph.Evaluate(weights));
+    VertexStreamLayout s;
+    std::vector<uint8_t> packed = GetUploadedVertices(morph, base, s);
+
+    float maxError = 0.0f;
+    bool inBounds = true;
+    for (int v = 0; v < vertexCount; v++) {
+        double expected[3] = {base.position[v].x, base.position[v].y, base.position[v].z};
+        for (int t = 0; t < targetCount; t++) {
+            for (int k = 0; k < 3; k++) {
+                expected[k] += static_cast<double>(targets[t].position[v][k]) * weights[t];
+            }
+        }
+        const Vector3f p = ReadVertex<Vector3f>(packed, s.stride, v, s.position);
+        for (int k = 0; k < 3; k++) {
+            maxError = std::max(maxError, static_cast<float>(std::fabs(p[k] - expected[k])));
+        }
+        inBounds = inBounds && morph.GetBounds().Contains(p, 1e-5f);
+    }
+    // half a quantization step of each target
+    OVR_CHECK(maxError <= 1e-5f);
+    OVR_CHECK(inBounds);
+
+    // missing weights are zero, which gives back the base positions exactly
+    OVR_CHECK(morph.Evaluate(std::vector<float>()));
+    packed = GetUploadedVertices(morph, base, s);
+    int moved = 0;
+    for (int v = 0; v < vertexCount; v++) {
+        const Vector3f p = ReadVertex<Vector3f>(packed, s.stride, v, s.position);
+        moved += (p == base.position[v]) ? 0 : 1;
+    }
+    OVR_CHECK(moved == 0);
+}
+
+// 20000 vertices and 64 targets that each move 3% of the vertices, against the dense float
+// evaluation of the same targets.
+OVR_BENCHMARK(MorphTargets, Evaluate) {
+    const int vertexCount = 20000;
+    const int targetCount = 64;
+    std::mt19937 rng(3);
+    const VertexAttribs base = MakeBase(vertexCount, rng);
+    std::uniform_real_distribution<float> delta(-0.02f, 0.02f);
+    std::vector<VertexAttribs> targets(targetCount);
+    for (int t = 0; t < targetCount; t++) {
+        targets[t].position.resize(vertexCount, Vector3f(0.0f));
+        const int start = static_cast<int>(rng() % vertexCount);
+        for (int i = 0; i < vertexCount / 32; i++) {
+            targets[t].position[(start + i) % vertexCount] =
+                Vector3f(delta(rng), delta(rng), delta(rng));
+        }
+    }
+    MorphTargets morph;
+    morph.Build(base, targets);
+
+    for (const int active : {8, 64}) {
+        std::vector<float> weights(targetCount, 0.0f);
+        for (int t = 0; t < active; t++) {
+            weights[t * targetCount / active] = 0.5f;
+        }
+        int frame = 0;
+        const double sparseMs = OVRFW::Test::TimeBestOf(20, [&]() {
+            weights[0] = 0.01f * (++frame % 100);
+            morph.Evaluate(weights);
+        });
+        std::vector<Vector3f> positions;
+        const double denseMs = OVRFW::Test::TimeBestOf(20, [&]() {
+            positions = base.position;
+            for (int t = 0; t < targetCount; t++) {
+                if (weights[t] == 0.0f) {
+                    continue;
+                }
+                for (int v = 0; v < vertexCount; v++) {
+                    positions[v] += targets[t].position[v] * weights[t];
+                }
+            }
+        });
+        printf(
+            "%2d active targets: sparse %6.3f ms, dense scalar %6.3f ms\n",
+            active,
+            sparseMs,
+            denseMs);
+    }
+}
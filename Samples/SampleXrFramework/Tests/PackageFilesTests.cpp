@@ -0,0 +1,325 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * Licensed under the Oculus SDK License Agreement (the "License");
+ * you may not use the Oculus SDK except in compliance with the License,
+ * which is provided at the time of installation or download, or which
+ * otherwise accompanies this software in either electronic or hard copy form.
+ *
+ * You may obtain a copy of the License at
+ * https://developer.oculus.com/licenses/oculussdk/
+ *
+ * Unless required by applicable law or agreed to in writing, the Oculus SDK
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/************************************************************************************
+
+Filename    :   PackageFilesTests.cpp
+Content     :   Tests and benchmarks for the package index against minizip.
+Language    :   C++
+
+*************************************************************************************/
+
+#include "FrameworkTest.h"
+
+#include "PackageFiles.h"
+
+#include <unzip.h>
+#include <zip.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace OVRFW;
+
+struct ovrTestZipFile {
+    std::string name;
+    std::vector<uint8_t> data;
+    bool deflate;
+};
+
+// Stored random data, deflated text, an empty file and many small files for the lookups.
+static std::vector<ovrTestZipFile> MakeZipFiles(const int numSmallFiles) {
+    std::mt19937 rng(5);
+    std::vector<ovrTestZipFile> files;
+
+    ovrTestZipFile& stored = files.emplace_back();
+    stored.name = "assets/Stored.bin";
+    stored.deflate = false;
+    for (int i = 0; i < 100000; i++) {
+        stored.data.push_back(static_cast<uint8_t>(rng()));
+    }
+
+    ovrTestZipFile& deflated = files.emplace_back();
+    deflated.name = "assets/deflated.txt";
+    deflated.deflate = true;
+    for (int i = 0; deflated.data.size() < 300000; i++) {
+        const std::string line = "line " + std::to_string(i) + " of a compressible file\n";
+        deflated.data.insert(deflated.data.end(), line.begin(), line.end());
+    }
+
+    ovrTestZipFile& empty = files.emplace_back();
+    empty.name = "empty.txt";
+    empty.deflate = false;
+
+    for (int i = 0; i < numSmallFiles; i++) {
+        ovrTestZipFile& small = files.emplace_back();
+        small.name = "res/raw/file" + std::to_string(i) + ".json";
+        small.deflate = (i % 2) == 0;
+        const std::string text = "{ \"index\": " + std::to_string(i) + " }";
+        small.data.assign(text.begin(), text.end());
+    }
+    return files;
+}
+
+static bool WriteZip(const std::string& path, const std::vector<ovrTestZipFile>& files) {
+    zipFile zf = zipOpen(path.c_str(), APPEND_STATUS_CREATE);
+    if (zf == nullptr) {
+        return false;
+    }
+    bool ok = true;
+    for (const ovrTestZipFile& file : files) {
+        zip_fileinfo info = {};
+        ok = ok &&
+            zipOpenNewFileInZip(
+                zf,
+                file.name.c_str(),
+                &info,
+                nullptr,
+                0,
+                nullptr,
+                0,
+                nullptr,
+                file.deflate ? Z_DEFLATED : 0,
+                file.deflate ? Z_DEFAULT_COMPRESSION : 0) == ZIP_OK;
+        ok = ok && zipWriteInFileInZip(zf, file.data.data(), (unsigned)file.data.size()) == ZIP_OK;
+        ok = ok && zipCloseFileInZip(zf) == ZIP_OK;
+    }
+    return zipClose(zf, nullptr) == ZIP_OK && ok;
+}
+
+static std::string TestZipPath(const char* name) {
+    return (std::filesystem::temp_directory_path() / name).string();
+}
+
+// The reference: a linear, case insensitive unzLocateFile and a read through minizip.
+static bool UnzipRead(unzFile zf, const char* name, std::vector<uint8_t>& buffer) {
+    unz_file_info info;
+    if (unzLocateFile(zf, name, 2) != UNZ_OK ||
+        unzGetCurrentFileInfo(zf, &info, nullptr, 0, nullptr, 0, nullptr, 0) != UNZ_OK ||
+        unzOpenCurrentFile(zf) != UNZ_OK) {
+        return false;
+    }
+    buffer.resize(info.uncompressed_size);
+    const int read = unzReadCurrentFile(zf, buffer.data(), (unsigned)buffer.size());
+    unzCloseCurrentFile(zf);
+    return read == static_cast<int>(buffer.size());
+}
+
+OVR_TEST(PackageFiles, MatchesMinizip) {
+    const std::vector<ovrTestZipFile> files = MakeZipFiles(200);
+    const std::string path = TestZipPath("PackageFilesTests.zip");
+    OVR_CHECK(WriteZip(path, files));
+
+    void* package = ovr_OpenOtherApplicationPackage(path.c_str());
+    unzFile reference = unzOpen(path.c_str());
+    OVR_CHECK(package != nullptr && reference != nullptr);
+
+    for (const ovrTestZipFile& file : files) {
+        OVR_CHECK(ovr_OtherPackageFileExists(package, file.name.c_str()));
+        std::vector<uint8_t> data;
+        std::vector<uint8_t> expected;
+        OVR_CHECK(ovr_ReadFileFromOtherApplicationPackage(package, file.name.c_str(), data));
+        OVR_CHECK(UnzipRead(reference, file.name.c_str(), expected));
+        OVR_CHECK(data == file.data && expected == file.data);
+    }
+
+    // Lookups are case insensitive like unzLocateFile, and missing files are reported.
+    OVR_CHECK(ovr_OtherPackageFileExists(package, "ASSETS/stored.BIN"));
+    OVR_CHECK(!ovr_OtherPackageFileExists(package, "assets/missing.bin"));
+    OVR_CHECK(!ovr_OtherPackageFileExists(package, "assets"));
+    int length = -1;
+    void* buffer = nullptr;
+    OVR_CHECK(!ovr_ReadFileFromOtherApplicationPackage(package, "missing", length, buffer));
+    OVR_CHECK(length == 0 && buffer == nullptr);
+
+    // Stored files map straight out of the package, compressed files only through the cache.
+    const std::vector<uint8_t>& stored = files[0].data;
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+    std::shared_ptr<const void> view =
+        ovr_MapFileFromOtherApplicationPackage(package, files[0].name.c_str(), data, size);
+#if !defined(OVR_OS_WIN32)
+    OVR_CHECK(view != nullptr && size == stored.size());
+    OVR_CHECK(view != nullptr && memcmp(data, stored.data(), size) == 0);
+#endif
+    view = ovr_MapFileFromOtherApplicationPackage(package, files[1].name.c_str(), data, size);
+    OVR_CHECK(view == nullptr);
+
+    unzClose(reference);
+    ovr_CloseOtherApplicationPackage(package);
+    OVR_CHECK(package == nullptr);
+    OVR_CHECK(!ovr_OtherPackageFileExists(package, files[0].name.c_str()));
+    std::filesystem::remove(path);
+}
+
+OVR_TEST(PackageFiles, ConcurrentReads) {
+    const std::vector<ovrTestZipFile> files = MakeZipFiles(400);
+    const std::string path = TestZipPath("PackageFilesConcurrent.zip");
+    OVR_CHECK(WriteZip(path, files));
+    void* package = ovr_OpenOtherApplicationPackage(path.c_str());
+
+    std::atomic<int> mismatches(0);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&, t]() {
+            std::vector<uint8_t> data;
+            for (size_t i = t; i < files.size(); i += 2) {
+                const char* name = files[i].name.c_str();
+                if (!ovr_ReadFileFromOtherApplicationPackage(package, name, data) ||
+                    data != files[i].data) {
+                    mismatches++;
+                }
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    OVR_CHECK(mismatches == 0);
+
+    ovr_CloseOtherApplicationPackage(package);
+    std::filesystem::remove(path);
+}
+
+static bool FileExists(const std::filesystem::path& path) {
+    std::error_code error;
+    return std::filesystem::exists(path, error);
+}
+
+// The application package is opened once per process, so this is the only test that uses it.
+OVR_TEST(PackageFiles, ExtractionCache) {
+    const std::vector<ovrTestZipFile> files = MakeZipFiles(10);
+    const std::string path = TestZipPath("PackageFilesCache.zip");
+    OVR_CHECK(WriteZip(path, files));
+
+    // Files of the old CRC naming are removed when the cache is first used, others are kept.
+    const std::filesystem::path cache = std::filesystem::temp_directory_path() / "PackageCache";
+    std::filesystem::remove_all(cache);
+    std::filesystem::create_directories(cache);
+    for (const char* name : {"0badf00d.bin", "DEADBEEF.tmp", "notes.bin", "0badf00d.txt"}) {
+        FILE* f = fopen((cache / name).string().c_str(), "wb");
+        OVR_CHECK(f != nullptr && fwrite("x", 1, 1, f) == 1);
+        fclose(f);
+    }
+
+    ovr_OpenApplicationPackage(path.c_str(), cache.string().c_str());
+    std::vector<uint8_t> data;
+    const ovrTestZipFile& deflated = files[1];
+    OVR_CHECK(ovr_ReadFileFromApplicationPackage(deflated.name.c_str(), data));
+    OVR_CHECK(data == deflated.data);
+
+#if !defined(OVR_OS_WIN32)
+    OVR_CHECK(!FileExists(cache / "0badf00d.bin") && !FileExists(cache / "DEADBEEF.tmp"));
+    OVR_CHECK(FileExists(cache / "notes.bin") && FileExists(cache / "0badf00d.txt"));
+    OVR_CHECK(FileExists(cache / "manifest.txt"));
+
+    // The extracted file is read and mapped from the cache from now on.
+    const uint8_t* mapped = nullptr;
+    size_t size = 0;
+    std::shared_ptr<const void> view = ovr_MapFileFromOtherApplicationPackage(
+        ovr_GetApplicationPackageFile(), deflated.name.c_str(), mapped, size);
+    OVR_CHECK(view != nullptr && size == deflated.data.size());
+    OVR_CHECK(view != nullptr && memcmp(mapped, deflated.data.data(), size) == 0);
+    view = nullptr;
+
+    // A file the application writes to the cache is only used once it is added.
+    const std::string derived = ovr_GetApplicationCacheFileName("geo-test");
+    FILE* f = fopen(derived.c_str(), "wb");
+    OVR_CHECK(f != nullptr && fwrite(deflated.data.data(), 1, 100, f) == 100);
+    fclose(f);
+    OVR_CHECK(!ovr_UseApplicationCacheFile("geo-test"));
+    ovr_AddApplicationCacheFile("geo-test");
+    OVR_CHECK(ovr_UseApplicationCacheFile("geo-test"));
+
+    // Shrinking the budget evicts both.
+    int numCached = 0;
+    for (const auto& entry : std::filesystem::directory_iterator(cache)) {
+        numCached += (entry.path().filename().string().find('-') != std::string::npos);
+    }
+    OVR_CHECK(numCached == 2);
+    ovr_SetApplicationPackageCacheBudget(0);
+    numCached = 0;
+    for (const auto& entry : std::filesystem::directory_iterator(cache)) {
+        numCached += (entry.path().filename().string().find('-') != std::string::npos);
+    }
+    OVR_CHECK(numCached == 0);
+    OVR_CHECK(!ovr_UseApplicationCacheFile("geo-test"));
+#endif
+
+    // The cache path stays set for the process, so nothing else is cached in the removed folder.
+    ovr_SetApplicationPackageCacheBudget(0);
+    std::filesystem::remove_all(cache);
+}
+
+// Reads every small file of a package by name through the index, and through unzLocateFile
+// under one lock as the package reads used to, from one and from four threads.
+OVR_BENCHMARK(PackageFiles, IndexVsUnzLocateFile) {
+    const std::vector<ovrTestZipFile> files = MakeZipFiles(1000);
+    const std::string path = TestZipPath("PackageFilesBenchmark.zip");
+    OVR_CHECK(WriteZip(path, files));
+    void* package = ovr_OpenOtherApplicationPackage(path.c_str());
+    unzFile reference = unzOpen(path.c_str());
+    std::mutex referenceMutex;
+
+    const int numFiles = static_cast<int>(files.size());
+    for (const int numThreads : {1, 4}) {
+        const auto readAll = [&](const std::function<void(const std::string&)>& read) {
+            std::vector<std::thread> threads;
+            for (int t = 0; t < numThreads; t++) {
+                threads.emplace_back([&, t]() {
+                    for (int i = t; i < numFiles; i += numThreads) {
+                        read(files[i].name);
+                    }
+                });
+            }
+            for (std::thread& thread : threads) {
+                thread.join();
+            }
+        };
+        const double indexMs = OVRFW::Test::TimeBestOf(3, [&]() {
+            readAll([&](const std::string& name) {
+                std::vector<uint8_t> data;
+                ovr_ReadFileFromOtherApplicationPackage(package, name.c_str(), data);
+            });
+        });
+        const double unzipMs = OVRFW::Test::TimeBestOf(1, [&]() {
+            readAll([&](const std::string& name) {
+                std::lock_guard<std::mutex> lock(referenceMutex);
+                std::vector<uint8_t> data;
+                UnzipRead(reference, name.c_str(), data);
+            });
+        });
+        printf(
+            "  %d files, %d threads: index %8.1f files/ms, unzLocateFile %8.1f files/ms\n",
+            numFiles,
+            numThreads,
+            numFiles / indexMs,
+            numFiles / unzipMs);
+    }
+
+    unzClose(reference);
+    ovr_CloseOtherApplicationPackage(package);
+    std::filesystem::remove(path);
+}
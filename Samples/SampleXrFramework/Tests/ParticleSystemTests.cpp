@@ -0,0 +1,226 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * Licensed under the Oculus SDK License Agreement (the "License");
+ * you may not use the Oculus SDK except in compliance with the License,
+ * which is provided at the time of installation or download, or which
+ * otherwise accompanies this software in either electronic or hard copy form.
+ *
+ * You may obtain a copy of the License at
+ * https://developer.oculus.com/licenses/oculussdk/
+ *
+ * Unless required by applicable law or agreed to in writing, the Oculus SDK
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/************************************************************************************
+
+Filename    :   ParticleSystemTests.cpp
+Content     :   Tests and benchmarks for the CPU stages of ovrParticleSystem::Frame.
+Language    :   C++
+
+*************************************************************************************/
+
+#include "FrameworkTest.h"
+
+#include "Render/EaseFunctions.h"
+#include "Render/GlGeometry.h"
+#include "Render/ParticleSystem.h"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+using namespace OVRFW;
+using OVR::Matrix4f;
+using OVR::Vector3f;
+using OVR::Vector4f;
+
+struct ovrTestParticle {
+    double startTime;
+    Vector3f position;
+    Vector3f velocity;
+    Vector3f acceleration;
+    Vector4f color;
+    ovrEaseFunc easeFunc;
+    float orientation;
+    float rotationRate;
+    float scale;
+    float lifeTime;
+};
+
+// Particles started over the first second, some with colors brighter than 1.
+static std::vector<ovrTestParticle> MakeParticles(const int count) {
+    std::mt19937 rng(5);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    std::uniform_real_distribution<float> positive(0.0f, 1.0f);
+    std::vector<ovrTestParticle> particles(count);
+    for (int i = 0; i < count; i++) {
+        ovrTestParticle& p = particles[i];
+        p.startTime = positive(rng);
+        p.position = Vector3f(unit(rng), unit(rng), unit(rng)) * 10.0f;
+        p.velocity = Vector3f(unit(rng), unit(rng), unit(rng));
+        p.acceleration = Vector3f(0.0f, -9.8f * positive(rng), 0.0f);
+        p.color = Vector4f(positive(rng), positive(rng), positive(rng), positive(rng)) *
+            ((i % 5 == 0) ? 4.0f : 1.0f);
+        p.easeFunc = static_cast<ovrEaseFunc>(i % ovrEaseFunc::MAX);
+        p.orientation = unit(rng) * 3.0f;
+        p.rotationRate = unit(rng);
+        p.scale = 0.05f + positive(rng) * 0.2f;
+        p.lifeTime = 0.5f + positive(rng) * 3.0f;
+    }
+    return particles;
+}
+
+static void AddParticles(ovrParticleSystem& system, const std::vector<ovrTestParticle>& ps) {
+    ovrApplFrameIn frame;
+    for (const ovrTestParticle& p : ps) {
+        frame.PredictedDisplayTime = p.startTime;
+        system.AddParticle(
+            frame,
+            p.position,
+            p.orientation,
+            p.velocity,
+            p.acceleration,
+            p.color,
+            p.easeFunc,
+            p.rotationRate,
+            p.scale,
+            p.lifeTime,
+            0);
+    }
+}
+
+static int RunFrame(ovrParticleSystem& system, const double time, const Vector3f& viewPos) {
+    ovrApplFrameIn frame;
+    frame.PredictedDisplayTime = time;
+    system.Frame(frame, nullptr, Matrix4f::Translation(-viewPos));
+    std::vector<ovrDrawSurface> surfaces;
+    system.RenderEyeView(Matrix4f::Identity(), Matrix4f::Identity(), surfaces);
+    return surfaces.empty() ? 0 : surfaces[0].surface->numInstances;
+}
+
+// The instances match the particles integrated one at a time with the ease functions, drawn
+// from far to near, and colors are not clamped.
+OVR_TEST(ParticleSystem, MatchesReference) {
+    const int count = 3000;
+    const std::vector<ovrTestParticle> particles = MakeParticles(count);
+    ovrParticleSystem system;
+    system.Init(count, nullptr, ovrParticleSystem::GetDefaultGpuState(), true);
+    AddParticles(system, particles);
+
+    const double time = 1.5;
+    const Vector3f viewPos(1.0f, 2.0f, 3.0f);
+    const int numInstances = RunFrame(system, time, viewPos);
+
+    struct ovrExpected {
+        Vector3f position;
+        float orientation;
+        Vector4f color;
+        float distanceSq;
+    };
+    std::vector<ovrExpected> expected;
+    for (const ovrTestParticle& p : particles) {
+        const float t = static_cast<float>(time - p.startTime);
+        if (t > p.lifeTime) {
+            continue;
+        }
+        ovrExpected e;
+        e.position = p.position + p.velocity * t + p.acceleration * (0.5f * t * t);
+        e.orientation = p.orientation + p.rotationRate * t;
+        e.color = EaseFunctions[p.easeFunc](p.color, t / p.lifeTime);
+        e.distanceSq = (e.position - viewPos).LengthSq();
+        expected.push_back(e);
+    }
+    std::stable_sort(
+        expected.begin(), expected.end(), [](const ovrExpected& a, const ovrExpected& b) {
+            return a.distanceSq > b.distanceSq;
+        });
+
+    OVR_CHECK(numInstances == static_cast<int>(expected.size()));
+    if (numInstances != static_cast<int>(expected.size())) {
+        return;
+    }
+
+    const particleInstance_t* instances =
+        static_cast<const particleInstance_t*>(OVRFW::Test::GetLastStreamAllocation());
+    // The instances are drawn far to near down to the precision of the depth keys, so particles
+    // at nearly the same distance may trade places. They are compared in exact order.
+    std::vector<float> distanceSq(numInstances);
+    std::vector<int> order(numInstances);
+    int outOfOrder = 0;
+    for (int i = 0; i < numInstances; i++) {
+        const Vector4f& p = instances[i].PositionScale;
+        distanceSq[i] = (Vector3f(p.x, p.y, p.z) - viewPos).LengthSq();
+        order[i] = i;
+        outOfOrder += (i > 0 && distanceSq[i] > distanceSq[i - 1] * 1.0003f) ? 1 : 0;
+    }
+    OVR_CHECK(outOfOrder == 0);
+    std::stable_sort(order.begin(), order.end(), [&](const int a, const int b) {
+        return distanceSq[a] > distanceSq[b];
+    });
+
+    int mismatches = 0;
+    float maxColor = 0.0f;
+    for (int i = 0; i < numInstances; i++) {
+        const particleInstance_t& inst = instances[order[i]];
+        const ovrExpected& e = expected[i];
+        const Vector3f pos(inst.PositionScale.x, inst.PositionScale.y, inst.PositionScale.z);
+        bool match = (pos - e.position).Length() < 1e-4f;
+        match = match && std::fabs(inst.Orientation - e.orientation) < 1e-4f;
+        const float color[4] = {e.color.x, e.color.y, e.color.z, e.color.w};
+        for (int c = 0; c < 4; c++) {
+            const float decoded = DecodeFloat16(inst.Color[c]);
+            match = match && std::fabs(decoded - color[c]) <= 1e-3f * std::max(1.0f, color[c]);
+            maxColor = std::max(maxColor, decoded);
+        }
+        mismatches += match ? 0 : 1;
+    }
+    OVR_CHECK(mismatches == 0);
+    OVR_CHECK(maxColor > 1.0f);
+}
+
+OVR_TEST(ParticleSystem, ExpiredParticlesAreReused) {
+    const int count = 100;
+    std::vector<ovrTestParticle> particles = MakeParticles(count);
+    ovrParticleSystem system;
+    system.Init(count, nullptr, ovrParticleSystem::GetDefaultGpuState(), false);
+    AddParticles(system, particles);
+
+    // everything has expired by then, and the slots take a new set of particles
+    OVR_CHECK(RunFrame(system, 10.0, Vector3f(0.0f)) == 0);
+    for (ovrTestParticle& p : particles) {
+        p.startTime += 10.0;
+    }
+    AddParticles(system, particles);
+    OVR_CHECK(RunFrame(system, 10.2, Vector3f(0.0f)) == count);
+}
+
+OVR_BENCHMARK(ParticleSystem, Frame) {
+    for (const int count : {1000, 10000, 50000}) {
+        for (const bool sort : {false, true}) {
+            std::vector<ovrTestParticle> particles = MakeParticles(count);
+            for (ovrTestParticle& p : particles) {
+                p.lifeTime = 100.0f;
+            }
+            ovrParticleSystem system;
+            system.Init(count, nullptr, ovrParticleSystem::GetDefaultGpuState(), sort);
+            AddParticles(system, particles);
+
+            double time = 1.0;
+            const double ms = OVRFW::Test::TimeBestOf(20, [&]() {
+                time += 0.011;
+                RunFrame(system, time, Vector3f(0.0f, 1.6f, 0.0f));
+            });
+            printf(
+                "%6d particles, %s: %7.3f ms, %6.0f particles/ms\n",
+                count,
+                sort ? "sorted  " : "unsorted",
+                ms,
+                count / ms);
+        }
+    }
+}
@@ -0,0 +1,283 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * Licensed under the Oculus SDK License Agreement (the "License");
+ * you may not use the Oculus SDK except in compliance with the License,
+ * which is provided at the time of installation or download, or which
+ * otherwise accompanies this software in either electronic or hard copy form.
+ *
+ * You may obtain a copy of the License at
+ * https://developer.oculus.com/licenses/oculussdk/
+ *
+ * Unless required by applicable law or agreed to in writing, the Oculus SDK
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/************************************************************************************
+
+Filename    :   PerfTimerTests.cpp
+Content     :   Tests for the per-frame timer statistics and the trace export.
+Language    :   C++
+
+*************************************************************************************/
+
+#include "FrameworkTest.h"
+
+#include "OVR_FileSys.h"
+#include "OVR_JSON.h"
+#include "OVR_PerfTimer.h"
+#include "OVR_Stream_Impl.h"
+#include "System.h"
+
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace OVRFW;
+using OVR::JSON;
+
+// Keeps what is written to it in a string.
+class ovrStringStream : public ovrStream {
+   public:
+    ovrStringStream(const ovrUriScheme& scheme, std::string& out) : ovrStream(scheme), Out(out) {}
+
+   private:
+    bool GetLocalPathFromUri_Internal(const char* uri, std::string& outputPath) override {
+        return false;
+    }
+    bool Open_Internal(char const* uri, ovrStreamMode const mode) override {
+        Out.clear();
+        return mode == OVR_STREAM_MODE_WRITE;
+    }
+    void Close_Internal() override {}
+    void Flush_Internal() override {}
+    bool Read_Internal(
+        std::vector<uint8_t>& outBuffer,
+        size_t const bytesToRead,
+        size_t& outBytesRead) override {
+        return false;
+    }
+    bool ReadFile_Internal(std::vector<uint8_t>& outBuffer) override {
+        return false;
+    }
+    bool Write_Internal(void const* inBuffer, size_t const bytesToWrite) override {
+        Out.append(static_cast<const char*>(inBuffer), bytesToWrite);
+        return true;
+    }
+    size_t Tell_Internal() const override {
+        return Out.size();
+    }
+    size_t Length_Internal() const override {
+        return Out.size();
+    }
+    bool AtEnd_Internal() const override {
+        return true;
+    }
+
+    std::string& Out;
+};
+
+// Writes files into memory.
+class ovrStringFileSys : public ovrFileSys {
+   public:
+    ovrStream* OpenStream(char const* uri, ovrStreamMode const mode) override {
+        ovrStream* stream = new ovrStringStream(Scheme, Files[uri]);
+        if (!stream->Open(uri, mode)) {
+            delete stream;
+            return nullptr;
+        }
+        return stream;
+    }
+    void CloseStream(ovrStream*& stream) override {
+        if (stream != nullptr) {
+            stream->Close();
+            delete stream;
+            stream = nullptr;
+        }
+    }
+
+    bool ReadFile(char const* uri, std::vector<uint8_t>& outBuffer) override {
+        return false;
+    }
+    bool FileExists(char const* uri) override {
+        return Files.find(uri) != Files.end();
+    }
+    bool GetLocalPathForURI(char const* uri, std::string& outputPath) override {
+        return false;
+    }
+
+    ovrUriScheme_File Scheme{"mem"};
+    std::map<std::string, std::string> Files;
+};
+
+// Keeps the thread busy for at least the given time.
+static void Spin(const double seconds) {
+    const double end = GetTimeInSeconds() + seconds;
+    while (GetTimeInSeconds() < end) {
+    }
+}
+
+OVR_TEST(PerfTimer, NearestRankPercentiles) {
+    std::vector<double> durations;
+    for (int i = 100; i >= 1; i--) {
+        durations.push_back(i);
+    }
+    ovrPerfStats stats;
+    CalculatePerfStats(durations.data(), static_cast<int>(durations.size()), stats);
+    OVR_CHECK(stats.NumFrames == 100);
+    OVR_CHECK(stats.Mean == 50.5);
+    OVR_CHECK(stats.P50 == 50.0 && stats.P90 == 90.0 && stats.P99 == 99.0);
+    OVR_CHECK(stats.Max == 100.0);
+
+    // with few frames the high percentiles are the slowest frame
+    const double few[] = {4.0, 1.0, 3.0};
+    CalculatePerfStats(few, 3, stats);
+    OVR_CHECK(stats.NumFrames == 3 && stats.Mean == 8.0 / 3.0);
+    OVR_CHECK(stats.P50 == 3.0 && stats.P90 == 4.0 && stats.P99 == 4.0 && stats.Max == 4.0);
+
+    CalculatePerfStats(few, 0, stats);
+    OVR_CHECK(stats.NumFrames == 0 && stats.Max == 0.0);
+}
+
+// A frame's duration is the sum of the scopes that ended in it, and frames in which the timer
+// didn't run are not counted.
+OVR_TEST(PerfTimer, FramesSumTheirScopes) {
+    SetPerfTimersEnabled(true);
+    PerfTimersBeginFrame(0);
+    for (int frame = 1; frame <= 6; frame++) {
+        if (frame % 3 != 0) {
+            for (int i = 0; i < frame; i++) {
+                OVR_PERF_TIMER(PerfTimerTests_Sum);
+                Spin(0.0002);
+            }
+        }
+        PerfTimersBeginFrame(frame);
+    }
+    SetPerfTimersEnabled(false);
+
+    ovrPerfStats stats;
+    OVR_CHECK(GetPerfStats("PerfTimerTests_Sum", stats));
+    // frames 1, 2, 4 and 5 ran the timer that many times
+    OVR_CHECK(stats.NumFrames == 4);
+    OVR_CHECK(stats.Max >= 5 * 0.2 && stats.P50 >= 2 * 0.2);
+    OVR_CHECK(stats.Mean >= 3 * 0.2 && stats.Mean <= stats.Max);
+    OVR_CHECK(!GetPerfStats("PerfTimerTests_NeverRan", stats) && stats.NumFrames == 0);
+}
+
+// The same name in different literals, as when a header is used by two libraries, is one timer
+// with one duration per frame.
+OVR_TEST(PerfTimer, NamesAreInterned) {
+    static const char first[] = "PerfTimerTests_Interned";
+    static const char second[] = "PerfTimerTests_Interned";
+    OVR_CHECK(static_cast<const void*>(first) != static_cast<const void*>(second));
+
+    SetPerfTimersEnabled(true);
+    PerfTimersBeginFrame(0);
+    for (int frame = 1; frame <= 3; frame++) {
+        {
+            ovrScopedPerfTimer timer(first);
+            Spin(0.0002);
+        }
+        {
+            ovrScopedPerfTimer timer(second);
+            Spin(0.0002);
+        }
+        PerfTimersBeginFrame(frame);
+    }
+    SetPerfTimersEnabled(false);
+
+    ovrPerfStats stats;
+    OVR_CHECK(GetPerfStats("PerfTimerTests_Interned", stats));
+    OVR_CHECK(stats.NumFrames == 3);
+    OVR_CHECK(stats.P50 >= 2 * 0.2);
+}
+
+OVR_TEST(PerfTimer, DisabledTimersRecordNothing) {
+    SetPerfTimersEnabled(false);
+    PerfTimersBeginFrame(0);
+    {
+        OVR_PERF_TIMER(PerfTimerTests_Disabled);
+    }
+    SetPerfTimersEnabled(true);
+    PerfTimersBeginFrame(1);
+    SetPerfTimersEnabled(false);
+    ovrPerfStats stats;
+    OVR_CHECK(!GetPerfStats("PerfTimerTests_Disabled", stats));
+}
+
+// Nested scopes, a second thread and the frame markers in the Chrome trace JSON.
+OVR_TEST(PerfTimer, TraceExportNestsScopes) {
+    SetPerfTimersEnabled(true);
+    PerfTimersBeginFrame(1000);
+    {
+        OVR_PERF_TIMER(PerfTimerTests_Outer);
+        Spin(0.0002);
+        for (int i = 0; i < 2; i++) {
+            OVR_PERF_TIMER(PerfTimerTests_Inner);
+            Spin(0.0002);
+        }
+    }
+    std::thread worker([]() { OVR_PERF_TIMER(PerfTimerTests_Worker); });
+    worker.join();
+    PerfTimersBeginFrame(1001);
+    SetPerfTimersEnabled(false);
+
+    ovrStringFileSys fileSys;
+    OVR_CHECK(ExportPerfTrace(fileSys, "mem:///trace.json"));
+    const std::shared_ptr<JSON> trace = JSON::Parse(fileSys.Files["mem:///trace.json"].c_str());
+    OVR_CHECK(trace != nullptr);
+    const std::shared_ptr<JSON> events = trace ? trace->GetItemByName("traceEvents") : nullptr;
+    OVR_CHECK(events != nullptr);
+    if (events == nullptr) {
+        return;
+    }
+
+    struct ovrTraceEvent {
+        double ts;
+        double dur;
+        int tid;
+        int depth;
+    };
+    std::map<std::string, std::vector<ovrTraceEvent>> scopes;
+    int frameMarkers = 0;
+    for (const std::shared_ptr<JSON>& event : events->Children) {
+        const std::string name = event->GetItemByName("name")->GetStringValue();
+        const std::string phase = event->GetItemByName("ph")->GetStringValue();
+        if (phase == "i") {
+            frameMarkers += (name == "Frame 1000" || name == "Frame 1001") ? 1 : 0;
+        } else if (phase == "X" && name.compare(0, 15, "PerfTimerTests_") == 0) {
+            scopes[name].push_back(
+                {event->GetItemByName("ts")->GetDoubleValue(),
+                 event->GetItemByName("dur")->GetDoubleValue(),
+                 event->GetItemByName("tid")->GetInt32Value(),
+                 event->GetItemByName("args")->GetItemByName("depth")->GetInt32Value()});
+        }
+    }
+    OVR_CHECK(frameMarkers == 2);
+
+    const std::vector<ovrTraceEvent>& outer = scopes["PerfTimerTests_Outer"];
+    const std::vector<ovrTraceEvent>& inner = scopes["PerfTimerTests_Inner"];
+    const std::vector<ovrTraceEvent>& threaded = scopes["PerfTimerTests_Worker"];
+    OVR_CHECK(outer.size() == 1 && inner.size() == 2 && threaded.size() == 1);
+    if (outer.size() != 1 || inner.size() != 2 || threaded.size() != 1) {
+        return;
+    }
+    OVR_CHECK(outer[0].depth == 0);
+    // The inner scopes are one level down, in order, and within the outer scope. The times are
+    // microseconds rounded to nanoseconds.
+    const double rounding = 0.002;
+    bool nested = true;
+    for (const ovrTraceEvent& event : inner) {
+        nested = nested && event.depth == 1 && event.tid == outer[0].tid &&
+            event.ts >= outer[0].ts - rounding &&
+            event.ts + event.dur <= outer[0].ts + outer[0].dur + rounding;
+    }
+    OVR_CHECK(nested);
+    OVR_CHECK(inner[0].ts + inner[0].dur <= inner[1].ts + rounding);
+    OVR_CHECK(outer[0].dur >= 3 * 200.0);
+    OVR_CHECK(threaded[0].depth == 0 && threaded[0].tid != outer[0].tid);
+}
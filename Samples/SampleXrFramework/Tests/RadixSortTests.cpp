@@ -0,0 +1,158 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * Licensed under the Oculus SDK License Agreement (the "License");
+ * you may not use the Oculus SDK except in compliance with the License,
+ * which is provided at the time of installation or download, or which
+ * otherwise accompanies this software in either electronic or hard copy form.
+ *
+ * You may obtain a copy of the License at
+ * https://developer.oculus.com/licenses/oculussdk/
+ *
+ * Unless required by applicable law or agreed to in writing, the Oculus SDK
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/************************************************************************************
+
+Filename    :   RadixSortTests.cpp
+Content     :   Tests and benchmarks for RadixSort and the draw key sort built on it.
+Language    :   C++
+
+*************************************************************************************/
+
+#include "FrameworkTest.h"
+
+#include "Render/RadixSort.h"
+#include "Render/SurfaceRender.h"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+using namespace OVRFW;
+
+struct ovrDistanceItem {
+    float distanceSq;
+    int index;
+};
+
+static std::vector<ovrDistanceItem> MakeDistances(const int count, const int seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> distance(0.0f, 100.0f);
+    std::vector<ovrDistanceItem> items(count);
+    for (int i = 0; i < count; i++) {
+        // every fourth item repeats an earlier distance, to check the sort is stable
+        const float d = distance(rng);
+        items[i] = {(i % 4 == 3) ? items[i / 2].distanceSq : d * d, i};
+    }
+    return items;
+}
+
+static bool SameOrder(
+    const std::vector<ovrDistanceItem>& a,
+    const std::vector<ovrDistanceItem>& b) {
+    for (size_t i = 0; i < a.size(); i++) {
+        if (a[i].index != b[i].index) {
+            return false;
+        }
+    }
+    return a.size() == b.size();
+}
+
+OVR_TEST(RadixSort, MatchesStableSort) {
+    std::vector<ovrDistanceItem> temp;
+    for (const int count : {0, 1, 2, 3, 16, 17, 100, 511, 512, 5000}) {
+        std::vector<ovrDistanceItem> items = MakeDistances(count, count);
+
+        // near to far
+        std::vector<ovrDistanceItem> expected = items;
+        std::stable_sort(
+            expected.begin(),
+            expected.end(),
+            [](const ovrDistanceItem& a, const ovrDistanceItem& b) {
+                return a.distanceSq < b.distanceSq;
+            });
+        std::vector<ovrDistanceItem> sorted = items;
+        RadixSort(sorted, temp, 32, [](const ovrDistanceItem& item) {
+            return RadixSortKey(item.distanceSq);
+        });
+        OVR_CHECK(SameOrder(sorted, expected));
+
+        // far to near
+        std::stable_sort(
+            expected.begin(),
+            expected.end(),
+            [](const ovrDistanceItem& a, const ovrDistanceItem& b) {
+                return a.distanceSq > b.distanceSq;
+            });
+        sorted = items;
+        RadixSort(sorted, temp, 32, [](const ovrDistanceItem& item) {
+            return ~RadixSortKey(item.distanceSq);
+        });
+        OVR_CHECK(SameOrder(sorted, expected));
+    }
+}
+
+OVR_TEST(RadixSort, DrawKeys) {
+    std::mt19937_64 rng(7);
+    std::vector<ovrDrawSortItem> temp;
+    for (const int count : {2, 20, 300, 3000}) {
+        std::vector<ovrDrawSortItem> items(count);
+        for (int i = 0; i < count; i++) {
+            // few distinct states in the high bits, as the draw keys have
+            const uint64_t key = rng();
+            items[i] = {(key & 0xF80000000000FFFFull) | ((key >> 16) & 3) << 47, i};
+        }
+        std::vector<ovrDrawSortItem> expected = items;
+        std::stable_sort(
+            expected.begin(),
+            expected.end(),
+            [](const ovrDrawSortItem& a, const ovrDrawSortItem& b) { return a.key < b.key; });
+        RadixSortDrawKeys(items, temp);
+        bool same = true;
+        for (int i = 0; i < count; i++) {
+            same = same && (items[i].index == expected[i].index);
+        }
+        OVR_CHECK(same);
+    }
+}
+
+OVR_BENCHMARK(RadixSort, VersusStableSort) {
+    std::vector<ovrDistanceItem> temp;
+    for (const int count : {16, 64, 256, 511, 512, 1000, 10000, 100000}) {
+        const std::vector<ovrDistanceItem> items = MakeDistances(count, 1);
+        std::vector<ovrDistanceItem> sorted;
+        const int repeats = std::max(1, 200000 / count);
+
+        const double radixMs = OVRFW::Test::TimeBestOf(5, [&]() {
+            for (int r = 0; r < repeats; r++) {
+                sorted = items;
+                RadixSort(sorted, temp, 32, [](const ovrDistanceItem& item) {
+                    return RadixSortKey(item.distanceSq);
+                });
+            }
+        });
+        const double stableMs = OVRFW::Test::TimeBestOf(5, [&]() {
+            for (int r = 0; r < repeats; r++) {
+                sorted = items;
+                std::stable_sort(
+                    sorted.begin(),
+                    sorted.end(),
+                    [](const ovrDistanceItem& a, const ovrDistanceItem& b) {
+                        return a.distanceSq < b.distanceSq;
+                    });
+            }
+        });
+
+        printf(
+            "%6d items: radix %8.2f us, std::stable_sort %8.2f us (%.1fx)\n",
+            count,
+            radixMs * 1000.0 / repeats,
+            stableMs * 1000.0 / repeats,
+            stableMs / radixMs);
+    }
+}
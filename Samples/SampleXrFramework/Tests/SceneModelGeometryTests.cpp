@@ -0,0 +1,252 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * Licensed under the Oculus SDK License Agreement (the "License");
+ * you may not use the Oculus SDK except in compliance with the License,
+ * which is provided at the time of installation or download, or which
+ * otherwise accompanies this software in either electronic or hard copy form.
+ *
+ * You may obtain a copy of the License at
+ * https://developer.oculus.com/licenses/oculussdk/
+ *
+ * Unless required by applicable law or agreed to in writing, the Oculus SDK
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/************************************************************************************
+
+Filename    :   SceneModelGeometryTests.cpp
+Content     :   Tests and benchmarks for the mesh building of the XrSceneModel sample.
+Language    :   C++
+
+*************************************************************************************/
+
+#include "FrameworkTest.h"
+
+#include "SceneModelGeometry.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+static uint32_t Count(const std::vector<XrVector2f>& points) {
+    return static_cast<uint32_t>(points.size());
+}
+
+static float SignedArea(const std::vector<XrVector2f>& points) {
+    float area = 0.0f;
+    for (size_t i = 0, j = points.size() - 1; i < points.size(); j = i++) {
+        area += points[j].x * points[i].y - points[i].x * points[j].y;
+    }
+    return area * 0.5f;
+}
+
+static float TriangleArea(const XrVector2f& a, const XrVector2f& b, const XrVector2f& c) {
+    return 0.5f * ((b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x));
+}
+
+// The triangles cover the polygon exactly once if they all keep its winding and their areas
+// add up to its area. A fan of a concave polygon fails this.
+static bool CoversPolygon(
+    const std::vector<XrVector2f>& points,
+    const std::vector<uint32_t>& indices,
+    const uint32_t baseIndex) {
+    if (indices.size() % 3 != 0) {
+        return false;
+    }
+    const float area = SignedArea(points);
+    float sum = 0.0f;
+    for (size_t i = 0; i < indices.size(); i += 3) {
+        for (size_t j = 0; j < 3; j++) {
+            if (indices[i + j] < baseIndex || indices[i + j] - baseIndex >= points.size()) {
+                return false;
+            }
+        }
+        const float triangle = TriangleArea(
+            points[indices[i + 0] - baseIndex],
+            points[indices[i + 1] - baseIndex],
+            points[indices[i + 2] - baseIndex]);
+        if (triangle * area <= 0.0f) {
+            return false;
+        }
+        sum += triangle;
+    }
+    return std::fabs(sum - area) <= 1e-4f * std::fabs(area);
+}
+
+// A star shaped polygon with a random radius per vertex, concave almost everywhere.
+static std::vector<XrVector2f> MakeStar(const int count, std::mt19937& rng) {
+    std::uniform_real_distribution<float> radius(0.2f, 2.0f);
+    std::vector<XrVector2f> points(count);
+    for (int i = 0; i < count; i++) {
+        const float angle = 6.2831853f * static_cast<float>(i) / static_cast<float>(count);
+        const float r = radius(rng);
+        points[i] = XrVector2f{r * std::cos(angle), r * std::sin(angle)};
+    }
+    return points;
+}
+
+OVR_TEST(SceneModelGeometry, TriangulatesConcavePolygons) {
+    // an L shaped table top, counter-clockwise and clockwise
+    std::vector<XrVector2f> shape = {{0, 0}, {2, 0}, {2, 1}, {1, 1}, {1, 2}, {0, 2}};
+    for (int winding = 0; winding < 2; winding++) {
+        std::vector<uint32_t> indices;
+        OVR_CHECK(TriangulatePolygon(shape.data(), Count(shape), 10, indices));
+        OVR_CHECK(indices.size() == 3 * (shape.size() - 2));
+        OVR_CHECK(CoversPolygon(shape, indices, 10));
+        std::reverse(shape.begin(), shape.end());
+    }
+
+    std::mt19937 rng(18);
+    int failures = 0;
+    for (int i = 0; i < 200; i++) {
+        const std::vector<XrVector2f> star = MakeStar(3 + i % 60, rng);
+        std::vector<uint32_t> indices;
+        const bool ok = TriangulatePolygon(star.data(), Count(star), 0, indices);
+        failures += (ok && CoversPolygon(star, indices, 0)) ? 0 : 1;
+    }
+    OVR_CHECK(failures == 0);
+}
+
+OVR_TEST(SceneModelGeometry, DropsCollinearAndDegeneratePolygons) {
+    // the midpoints of the edges never end up in a triangle of zero area
+    const std::vector<XrVector2f> square = {
+        {0, 0}, {1, 0}, {2, 0}, {2, 1}, {2, 2}, {1, 2}, {0, 2}, {0, 1}};
+    std::vector<uint32_t> indices;
+    OVR_CHECK(TriangulatePolygon(square.data(), Count(square), 0, indices));
+    OVR_CHECK(CoversPolygon(square, indices, 0));
+
+    const std::vector<XrVector2f> line = {{0, 0}, {1, 1}, {2, 2}, {3, 3}};
+    indices.clear();
+    OVR_CHECK(!TriangulatePolygon(line.data(), Count(line), 0, indices));
+    OVR_CHECK(!TriangulatePolygon(line.data(), 2, 0, indices));
+    OVR_CHECK(indices.empty());
+}
+
+OVR_TEST(SceneModelGeometry, RangeAllocatorReusesFreedRanges) {
+    ovrSceneRangeAllocator allocator;
+    const uint32_t a = allocator.Allocate(10);
+    const uint32_t b = allocator.Allocate(20);
+    const uint32_t c = allocator.Allocate(30);
+    OVR_CHECK(a == 0 && b == 10 && c == 30 && allocator.Size() == 60);
+
+    // first fit into the hole, then the rest of the hole
+    allocator.Free(b, 20);
+    OVR_CHECK(allocator.Allocate(5) == 10);
+    OVR_CHECK(allocator.Allocate(15) == 15);
+    OVR_CHECK(allocator.Size() == 60);
+
+    // freed neighbours merge, and a free range at the end shrinks the buffer
+    allocator.Free(10, 5);
+    allocator.Free(15, 15);
+    allocator.Free(a, 10);
+    OVR_CHECK(allocator.Allocate(30) == 0);
+    allocator.Free(0, 30);
+    allocator.Free(c, 30);
+    OVR_CHECK(allocator.Size() == 0);
+}
+
+// A synthetic room of quads, each face its own pair of triangles over shared vertices.
+struct ovrTestRoom {
+    std::vector<XrVector3f> vertices;
+    std::vector<XrRoomMeshFaceMETA> faces;
+    std::vector<std::vector<uint32_t>> indices;
+    std::vector<XrRoomMeshFaceIndicesMETA> faceIndices;
+    std::vector<XrColor4f> colors;
+    XrRoomMeshMETA mesh{};
+};
+
+static void MakeRoom(const int faceCount, ovrTestRoom& room) {
+    for (int f = 0; f <= faceCount; f++) {
+        const float x = static_cast<float>(f);
+        room.vertices.push_back(XrVector3f{x, 0.0f, 0.0f});
+        room.vertices.push_back(XrVector3f{x, 2.5f, 0.0f});
+    }
+    room.faces.resize(faceCount);
+    room.indices.resize(faceCount);
+    room.faceIndices.resize(faceCount);
+    room.colors.resize(faceCount);
+    for (int f = 0; f < faceCount; f++) {
+        const uint32_t v = static_cast<uint32_t>(f * 2);
+        room.indices[f] = {v, v + 2, v + 1, v + 1, v + 2, v + 3};
+        room.faceIndices[f].indexCountOutput = static_cast<uint32_t>(room.indices[f].size());
+        room.faceIndices[f].indices = room.indices[f].data();
+        room.colors[f] = XrColor4f{static_cast<float>(f % 5) / 4.0f, 0.0f, 1.0f, 1.0f};
+    }
+    room.mesh.vertexCountOutput = static_cast<uint32_t>(room.vertices.size());
+    room.mesh.vertices = room.vertices.data();
+    room.mesh.faceCountOutput = static_cast<uint32_t>(faceCount);
+    room.mesh.faces = room.faces.data();
+}
+
+OVR_TEST(SceneModelGeometry, RoomMeshHasARangePerFace) {
+    ovrTestRoom room;
+    MakeRoom(4, room);
+    // a triangle with a vertex out of range and a trailing partial triangle are skipped
+    room.indices[1] = {2, 4, 3, 3, 4, 99, 4, 5};
+    room.faceIndices[1].indexCountOutput = 8;
+    room.faceIndices[1].indices = room.indices[1].data();
+    // a face without indices still gets its empty range
+    room.faceIndices[2].indexCountOutput = 0;
+
+    ovrSceneMeshData mesh;
+    std::vector<ovrSceneIndexRange> ranges;
+    BuildRoomMesh(room.mesh, room.faceIndices.data(), room.colors.data(), mesh, ranges);
+
+    OVR_CHECK(ranges.size() == 4);
+    OVR_CHECK(mesh.Indices.size() == 6 + 3 + 0 + 6);
+    OVR_CHECK(mesh.Vertices.size() == mesh.Indices.size());
+    if (ranges.size() != 4 || mesh.Vertices.size() != mesh.Indices.size()) {
+        return;
+    }
+    const uint32_t expectedCounts[4] = {6, 3, 0, 6};
+    uint32_t first = 0;
+    bool matches = true;
+    for (uint32_t f = 0; f < 4; f++) {
+        matches = matches && ranges[f].FirstIndex == first;
+        matches = matches && ranges[f].IndexCount == expectedCounts[f];
+        // every face has its own vertices in the face color
+        for (uint32_t i = first; i < first + ranges[f].IndexCount; i++) {
+            const ovrSceneVertex& vertex = mesh.Vertices[mesh.Indices[i]];
+            const XrVector3f& source = room.vertices[room.faceIndices[f].indices[i - first]];
+            matches = matches && vertex.Position.x == source.x && vertex.Position.y == source.y;
+            matches = matches &&
+                vertex.Color[0] == static_cast<uint8_t>(room.colors[f].r * 255.0f + 0.5f);
+        }
+        first += ranges[f].IndexCount;
+    }
+    OVR_CHECK(matches);
+}
+
+OVR_BENCHMARK(SceneModelGeometry, BuildRoomMesh) {
+    for (const int faceCount : {50, 200, 800}) {
+        ovrTestRoom room;
+        MakeRoom(faceCount, room);
+        ovrSceneMeshData mesh;
+        std::vector<ovrSceneIndexRange> ranges;
+        const double ms = OVRFW::Test::TimeBestOf(20, [&]() {
+            BuildRoomMesh(room.mesh, room.faceIndices.data(), room.colors.data(), mesh, ranges);
+        });
+        printf("%4d faces: %7.3f ms\n", faceCount, ms);
+    }
+}
+
+OVR_BENCHMARK(SceneModelGeometry, TriangulatePolygon) {
+    std::mt19937 rng(1);
+    for (const int count : {8, 32, 128, 512}) {
+        const std::vector<XrVector2f> star = MakeStar(count, rng);
+        std::vector<uint32_t> indices;
+        const int repeats = std::max(1, 20000 / (count * 4));
+        const double ms = OVRFW::Test::TimeBestOf(5, [&]() {
+            for (int r = 0; r < repeats; r++) {
+                indices.clear();
+                TriangulatePolygon(star.data(), Count(star), 0, indices);
+            }
+        });
+        printf("%4d boundary vertices: %8.2f us\n", count, ms * 1000.0 / repeats);
+    }
+}
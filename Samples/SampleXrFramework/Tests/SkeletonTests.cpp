@@ -0,0 +1,421 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * Licensed under the Oculus SDK License Agreement (the "License");
+ * you may not use the Oculus SDK except in compliance with the License,
+ * which is provided at the time of installation or download, or which
+ * otherwise accompanies this software in either electronic or hard copy form.
+ *
+ * You may obtain a copy of the License at
+ * https://developer.oculus.com/licenses/oculussdk/
+ *
+ * Unless required by applicable law or agreed to in writing, the Oculus SDK
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/************************************************************************************
+
+Filename    :   SkeletonTests.cpp
+Content     :   Tests for the batched skeleton pass against a per-joint Posef chain.
+Language    :   C++
+
+*************************************************************************************/
+
+#include "FrameworkTest.h"
+
+#include "Input/Skeleton.h"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+using namespace OVRFW;
+using OVR::Posef;
+using OVR::Quatf;
+using OVR::Vector3f;
+
+// The local and world poses kept as one Posef per joint, with every world pose recomputed when
+// it is read. Joints are evaluated in Order, so parents may come after their children.
+class ovrPosefSkeleton {
+   public:
+    explicit ovrPosefSkeleton(const std::vector<ovrJoint>& joints) : Joints(joints) {
+        for (const ovrJoint& joint : Joints) {
+            Local.push_back(joint.Pose);
+        }
+        World.resize(Joints.size());
+        std::vector<bool> placed(Joints.size(), false);
+        while (Order.size() < Joints.size()) {
+            for (int i = 0; i < static_cast<int>(Joints.size()); i++) {
+                const int parent = Joints[i].ParentIndex;
+                if (!placed[i] && (parent < 0 || placed[parent])) {
+                    placed[i] = true;
+                    Order.push_back(i);
+                }
+            }
+        }
+    }
+
+    const std::vector<Posef>& GetWorldSpacePoses() {
+        for (const int i : Order) {
+            const int parent = Joints[i].ParentIndex;
+            World[i] = (parent < 0) ? Local[i] : (World[parent] * Local[i]);
+        }
+        return World;
+    }
+
+    std::vector<ovrJoint> Joints;
+    std::vector<int> Order;
+    std::vector<Posef> Local;
+    std::vector<Posef> World;
+};
+
+static Quatf RandomRotation(std::mt19937& rng) {
+    std::uniform_real_distribution<float> component(-1.0f, 1.0f);
+    Quatf q(component(rng), component(rng), component(rng), component(rng) + 2.0f);
+    q.Normalize();
+    return q;
+}
+
+static Vector3f RandomTranslation(std::mt19937& rng) {
+    std::uniform_real_distribution<float> component(-0.1f, 0.1f);
+    return Vector3f(component(rng), component(rng), component(rng));
+}
+
+static Posef RandomPose(std::mt19937& rng) {
+    return Posef(RandomRotation(rng), RandomTranslation(rng));
+}
+
+// A random forest of count joints. The joints are numbered in a shuffled order, so parents are
+// not always listed before their children.
+static std::vector<ovrJoint> RandomJoints(std::mt19937& rng, const int count) {
+    std::vector<int> order(count);
+    for (int i = 0; i < count; i++) {
+        order[i] = i;
+    }
+    std::shuffle(order.begin(), order.end(), rng);
+    std::vector<ovrJoint> joints(count);
+    for (int k = 0; k < count; k++) {
+        // a few roots, and otherwise mostly long chains as in arms and fingers
+        const int roll = static_cast<int>(rng() % 8);
+        const int parent = (k == 0 || roll == 0)
+            ? -1
+            : order[(roll < 5) ? k - 1 : static_cast<int>(rng() % k)];
+        joints[order[k]] = ovrJoint("joint", OVR::Vector4f(1.0f), RandomPose(rng), parent);
+    }
+    return joints;
+}
+
+static bool PosesNear(const Posef& a, const Posef& b) {
+    const float epsilon = 1e-4f;
+    return std::fabs(a.Rotation.x - b.Rotation.x) <= epsilon &&
+        std::fabs(a.Rotation.y - b.Rotation.y) <= epsilon &&
+        std::fabs(a.Rotation.z - b.Rotation.z) <= epsilon &&
+        std::fabs(a.Rotation.w - b.Rotation.w) <= epsilon &&
+        (a.Translation - b.Translation).Length() <= epsilon;
+}
+
+static bool PosesEqual(const Posef& a, const Posef& b) {
+    return a.Rotation == b.Rotation && a.Translation == b.Translation;
+}
+
+static bool WorldMatches(const ovrSkeleton& skeleton, ovrPosefSkeleton& expected) {
+    const std::vector<Posef>& world = skeleton.GetWorldSpacePoses();
+    const std::vector<Posef>& expectedWorld = expected.GetWorldSpacePoses();
+    if (world.size() != expectedWorld.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < world.size(); i++) {
+        if (!PosesNear(world[i], expectedWorld[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+OVR_TEST(Skeleton, MatchesThePosefChain) {
+    std::mt19937 rng(20);
+    for (const int count : {0, 1, 2, 3, 4, 5, 8, 9, 26, 84}) {
+        for (int repeat = 0; repeat < 10; repeat++) {
+            const std::vector<ovrJoint> joints = RandomJoints(rng, count);
+            ovrSkeleton skeleton;
+            skeleton.SetJoints(joints);
+            ovrPosefSkeleton expected(joints);
+            OVR_CHECK(WorldMatches(skeleton, expected));
+
+            bool localMatches = skeleton.GetLocalSpacePoses().size() == joints.size();
+            for (int i = 0; localMatches && i < count; i++) {
+                localMatches = PosesEqual(skeleton.GetLocalSpacePoses()[i], joints[i].Pose);
+            }
+            OVR_CHECK(localMatches);
+        }
+    }
+}
+
+// Single joints change between reads. Only the subtrees of the changed joints are recomputed,
+// so every other world pose must come out exactly as before.
+OVR_TEST(Skeleton, SubtreeDirtyUpdates) {
+    std::mt19937 rng(21);
+    for (int repeat = 0; repeat < 20; repeat++) {
+        const int count = 1 + static_cast<int>(rng() % 84);
+        const std::vector<ovrJoint> joints = RandomJoints(rng, count);
+        ovrSkeleton skeleton;
+        skeleton.SetJoints(joints);
+        ovrPosefSkeleton expected(joints);
+
+        for (int step = 0; step < 50; step++) {
+            const std::vector<Posef> before = skeleton.GetWorldSpacePoses();
+            std::vector<bool> changed(count, false);
+            const int updates = 1 + static_cast<int>(rng() % 3);
+            for (int u = 0; u < updates; u++) {
+                const int idx = static_cast<int>(rng() % count);
+                changed[idx] = true;
+                switch (rng() % 3) {
+                    case 0: {
+                        const Quatf q = RandomRotation(rng);
+                        skeleton.UpdateLocalRotation(q, idx);
+                        expected.Local[idx].Rotation = q;
+                        break;
+                    }
+                    case 1: {
+                        const Vector3f t = RandomTranslation(rng);
+                        skeleton.UpdateLocalTranslation(t, idx);
+                        expected.Local[idx].Translation = t;
+                        break;
+                    }
+                    default: {
+                        const Posef t = RandomPose(rng);
+                        skeleton.TransformLocal(t, idx);
+                        expected.Local[idx] = joints[idx].Pose * t;
+                        break;
+                    }
+                }
+            }
+
+            OVR_CHECK(WorldMatches(skeleton, expected));
+            bool localMatches = true;
+            for (int i = 0; i < count; i++) {
+                localMatches =
+                    localMatches && PosesEqual(skeleton.GetLocalSpacePoses()[i], expected.Local[i]);
+            }
+            OVR_CHECK(localMatches);
+
+            // a joint keeps its world pose unless it or one of its ancestors changed
+            bool cleanUnchanged = true;
+            for (int i = 0; i < count; i++) {
+                bool inChangedSubtree = false;
+                for (int j = i; j >= 0 && !inChangedSubtree; j = joints[j].ParentIndex) {
+                    inChangedSubtree = changed[j];
+                }
+                if (!inChangedSubtree) {
+                    cleanUnchanged = cleanUnchanged &&
+                        PosesEqual(skeleton.GetWorldSpacePoses()[i], before[i]);
+                }
+            }
+            OVR_CHECK(cleanUnchanged);
+        }
+    }
+}
+
+// TransformWorld places the joint at the given world pose relative to its parent's current
+// world pose, including changes to the parent that were not read yet.
+OVR_TEST(Skeleton, TransformWorld) {
+    std::mt19937 rng(22);
+    for (int repeat = 0; repeat < 20; repeat++) {
+        const int count = 1 + static_cast<int>(rng() % 84);
+        const std::vector<ovrJoint> joints = RandomJoints(rng, count);
+        ovrSkeleton skeleton;
+        skeleton.SetJoints(joints);
+        ovrPosefSkeleton expected(joints);
+
+        for (int step = 0; step < 20; step++) {
+            const int idx = static_cast<int>(rng() % count);
+            const int parent = joints[idx].ParentIndex;
+            if (parent >= 0 && rng() % 2 == 0) {
+                const Quatf q = RandomRotation(rng);
+                skeleton.UpdateLocalRotation(q, parent);
+                expected.Local[parent].Rotation = q;
+            }
+            const Posef t = RandomPose(rng);
+            skeleton.TransformWorld(t, idx);
+            expected.Local[idx] =
+                (parent < 0) ? t : expected.GetWorldSpacePoses()[parent].Inverted() * t;
+
+            OVR_CHECK(PosesNear(skeleton.GetWorldSpacePoses()[idx], t));
+            OVR_CHECK(WorldMatches(skeleton, expected));
+        }
+    }
+}
+
+OVR_TEST(Skeleton, UpdateLocalPoses) {
+    std::mt19937 rng(23);
+    const std::vector<ovrJoint> joints = RandomJoints(rng, 84);
+    ovrSkeleton skeleton;
+    skeleton.SetJoints(joints);
+    ovrPosefSkeleton expected(joints);
+    for (int frame = 0; frame < 5; frame++) {
+        for (Posef& pose : expected.Local) {
+            pose = RandomPose(rng);
+        }
+        skeleton.UpdateLocalPoses(expected.Local.data(), static_cast<int>(joints.size()));
+        OVR_CHECK(WorldMatches(skeleton, expected));
+        bool localMatches = true;
+        for (size_t i = 0; i < joints.size(); i++) {
+            localMatches =
+                localMatches && PosesEqual(skeleton.GetLocalSpacePoses()[i], expected.Local[i]);
+        }
+        OVR_CHECK(localMatches);
+    }
+}
+
+// Parents that are out of range or form a cycle count as roots.
+OVR_TEST(Skeleton, BrokenParentsAreRoots) {
+    std::mt19937 rng(24);
+    std::vector<ovrJoint> joints = RandomJoints(rng, 6);
+    joints[0].ParentIndex = 1;
+    joints[1].ParentIndex = 0;
+    joints[2].ParentIndex = 99;
+    ovrSkeleton skeleton;
+    skeleton.SetJoints(joints);
+    const std::vector<Posef>& world = skeleton.GetWorldSpacePoses();
+    OVR_CHECK(PosesEqual(world[0], joints[0].Pose));
+    OVR_CHECK(PosesEqual(world[1], joints[1].Pose));
+    OVR_CHECK(PosesEqual(world[2], joints[2].Pose));
+}
+
+// A 32-joint body with a 26-joint hand at each wrist, shaped like the body and hand tracking
+// skeletons. Parents are listed before their children, as the Posef chain needs.
+static std::vector<ovrJoint> BodyAndHands(std::mt19937& rng) {
+    std::vector<ovrJoint> joints;
+    const auto chain = [&](int parent, const int length) {
+        for (int i = 0; i < length; i++) {
+            joints.push_back(ovrJoint("joint", OVR::Vector4f(1.0f), RandomPose(rng), parent));
+            parent = static_cast<int>(joints.size()) - 1;
+        }
+        return parent;
+    };
+    const int hips = chain(-1, 1);
+    const int chest = chain(hips, 5);
+    const int head = chain(chest, 2);
+    for (int i = 0; i < 4; i++) {
+        chain(head, 1); // jaw, eyes and head end
+    }
+    int wrists[2];
+    for (int side = 0; side < 2; side++) {
+        wrists[side] = chain(chest, 5); // shoulder, upper arm, twist, lower arm and wrist
+        chain(hips, 5); // upper leg, lower leg, ankle, foot and toes
+    }
+    for (int side = 0; side < 2; side++) {
+        chain(wrists[side], 1); // palm
+        const int wrist = chain(wrists[side], 1);
+        chain(wrist, 4); // thumb
+        for (int finger = 0; finger < 4; finger++) {
+            chain(wrist, 5);
+        }
+    }
+    return joints;
+}
+
+// Driven a joint at a time the way ArmModel does and a whole pose at a time the way a tracker
+// does.
+OVR_BENCHMARK(Skeleton, VersusPosefChain) {
+    std::mt19937 rng(25);
+    const std::vector<ovrJoint> joints = BodyAndHands(rng);
+    OVR_CHECK(joints.size() == 84);
+    const int numJoints = static_cast<int>(joints.size());
+    std::vector<Quatf> rotations;
+    std::vector<Posef> poses;
+    for (int i = 0; i < numJoints; i++) {
+        rotations.push_back(RandomRotation(rng));
+        poses.push_back(RandomPose(rng));
+    }
+
+    ovrSkeleton skeleton;
+    skeleton.SetJoints(joints);
+    ovrPosefSkeleton chain(joints);
+    const int repeats = 2000;
+    float sink = 0.0f;
+
+    const auto report = [&](const char* name, const int ops, double ms, double chainMs) {
+        printf(
+            "%-32s skeleton %8.1f ns, Posef chain %8.1f ns (%.2fx)\n",
+            name,
+            ms * 1.0e6 / (repeats * ops),
+            chainMs * 1.0e6 / (repeats * ops),
+            chainMs / ms);
+    };
+
+    // one joint changes, then the world poses are read
+    double ms = OVRFW::Test::TimeBestOf(5, [&]() {
+        for (int r = 0; r < repeats; r++) {
+            for (int i = 0; i < numJoints; i++) {
+                skeleton.UpdateLocalRotation(rotations[(i + r) % numJoints], i);
+                sink += skeleton.GetWorldSpacePoses()[i].Translation.x;
+            }
+        }
+    });
+    double chainMs = OVRFW::Test::TimeBestOf(5, [&]() {
+        for (int r = 0; r < repeats; r++) {
+            for (int i = 0; i < numJoints; i++) {
+                chain.Local[i].Rotation = rotations[(i + r) % numJoints];
+                sink += chain.GetWorldSpacePoses()[i].Translation.x;
+            }
+        }
+    });
+    report("UpdateLocalRotation + read", numJoints, ms, chainMs);
+
+    ms = OVRFW::Test::TimeBestOf(5, [&]() {
+        for (int r = 0; r < repeats; r++) {
+            for (int i = 0; i < numJoints; i++) {
+                skeleton.TransformLocal(poses[(i + r) % numJoints], i);
+                sink += skeleton.GetWorldSpacePoses()[i].Translation.x;
+            }
+        }
+    });
+    chainMs = OVRFW::Test::TimeBestOf(5, [&]() {
+        for (int r = 0; r < repeats; r++) {
+            for (int i = 0; i < numJoints; i++) {
+                chain.Local[i] = chain.Joints[i].Pose * poses[(i + r) % numJoints];
+                sink += chain.GetWorldSpacePoses()[i].Translation.x;
+            }
+        }
+    });
+    report("TransformLocal + read", numJoints, ms, chainMs);
+
+    // every joint changes, then the world poses are read once
+    ms = OVRFW::Test::TimeBestOf(5, [&]() {
+        for (int r = 0; r < repeats; r++) {
+            for (int i = 0; i < numJoints; i++) {
+                skeleton.UpdateLocalRotation(rotations[(i + r) % numJoints], i);
+            }
+            sink += skeleton.GetWorldSpacePoses()[r % numJoints].Translation.x;
+        }
+    });
+    chainMs = OVRFW::Test::TimeBestOf(5, [&]() {
+        for (int r = 0; r < repeats; r++) {
+            for (int i = 0; i < numJoints; i++) {
+                chain.Local[i].Rotation = rotations[(i + r) % numJoints];
+            }
+            sink += chain.GetWorldSpacePoses()[r % numJoints].Translation.x;
+        }
+    });
+    report("all joints + read", 1, ms, chainMs);
+
+    ms = OVRFW::Test::TimeBestOf(5, [&]() {
+        for (int r = 0; r < repeats; r++) {
+            skeleton.UpdateLocalPoses(poses.data(), numJoints);
+            sink += skeleton.GetWorldSpacePoses()[r % numJoints].Translation.x;
+        }
+    });
+    chainMs = OVRFW::Test::TimeBestOf(5, [&]() {
+        for (int r = 0; r < repeats; r++) {
+            chain.Local = poses;
+            sink += chain.GetWorldSpacePoses()[r % numJoints].Translation.x;
+        }
+    });
+    report("UpdateLocalPoses + read", 1, ms, chainMs);
+
+    OVR_CHECK(std::isfinite(sink));
+}
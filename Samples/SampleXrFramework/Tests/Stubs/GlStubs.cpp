@@ -0,0 +1,444 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * Licensed under the Oculus SDK License Agreement (the "License");
+ * you may not use the Oculus SDK except in compliance with the License,
+ * which is provided at the time of installation or download, or which
+ * otherwise accompanies this software in either electronic or hard copy form.
+ *
+ * You may obtain a copy of the License at
+ * https://developer.oculus.com/licenses/oculussdk/
+ *
+ * Unless required by applicable law or agreed to in writing, the Oculus SDK
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/************************************************************************************
+
+Filename    :   GlStubs.cpp
+Content     :   Stand-ins for the framework's GL object functions, so the CPU side of the
+                renderers can be tested without a GL context.
+Language    :   C++
+
+Notes       :   Objects get non-zero names so they look valid and nothing is uploaded. The
+                stream buffer maps plain memory, which tests read back through
+                GetLastStreamAllocation(), and so do GlBuffers. Texture files are not
+                decoded, only recorded, and so are the textures created from them. The GL
+                calls that decide what is drawn are recorded for TakeGlCalls().
+
+*************************************************************************************/
+
+#include "../FrameworkTest.h"
+
+#include "Render/GlBuffer.h"
+#include "Render/GlGeometry.h"
+#include "Render/GlProgram.h"
+#include "Render/GlStreamBuffer.h"
+#include "Render/GlTexture.h"
+#include "OVR_FileSys.h"
+
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace OVRFW {
+namespace Test {
+static std::vector<ovrGlCall> GlCalls;
+
+static void RecordGlCall(
+    const char* function,
+    const int64_t a0 = 0,
+    const int64_t a1 = 0,
+    const int64_t a2 = 0,
+    const int64_t a3 = 0,
+    const int64_t a4 = 0) {
+    GlCalls.push_back({function, {a0, a1, a2, a3, a4}});
+}
+} // namespace Test
+} // namespace OVRFW
+
+using OVRFW::Test::RecordGlCall;
+
+// The GL calls the renderers make directly. The ones that decide what is drawn and with which
+// program, uniforms, textures and buffers are recorded. Only the integer arguments are kept.
+extern "C" {
+void glEnable(unsigned cap) {}
+void glDisable(unsigned cap) {}
+void glBlendFunc(unsigned sfactor, unsigned dfactor) {}
+void glBlendFuncSeparate(unsigned srcRGB, unsigned dstRGB, unsigned srcAlpha, unsigned dstAlpha) {}
+void glBlendEquation(unsigned mode) {}
+void glBlendEquationSeparate(unsigned modeRGB, unsigned modeAlpha) {}
+void glDepthFunc(unsigned func) {}
+void glDepthMask(unsigned char flag) {}
+void glDepthRangef(float n, float f) {}
+void glColorMask(unsigned char r, unsigned char g, unsigned char b, unsigned char a) {}
+void glFrontFace(unsigned mode) {}
+void glPolygonOffset(float factor, float units) {}
+void glLineWidth(float width) {}
+void glGetIntegerv(unsigned pname, int* data) {
+    // GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT is the only one asked for
+    *data = 256;
+}
+void glUseProgram(unsigned program) {
+    RecordGlCall("glUseProgram", program);
+}
+void glUniform1i(int location, int v0) {
+    RecordGlCall("glUniform1i", location, v0);
+}
+void glUniform1iv(int location, int count, const int* value) {
+    RecordGlCall("glUniform1iv", location, count);
+}
+void glUniform2iv(int location, int count, const int* value) {
+    RecordGlCall("glUniform2iv", location, count);
+}
+void glUniform3iv(int location, int count, const int* value) {
+    RecordGlCall("glUniform3iv", location, count);
+}
+void glUniform4iv(int location, int count, const int* value) {
+    RecordGlCall("glUniform4iv", location, count);
+}
+void glUniform1f(int location, float v0) {
+    RecordGlCall("glUniform1f", location);
+}
+void glUniform2fv(int location, int count, const float* value) {
+    RecordGlCall("glUniform2fv", location, count);
+}
+void glUniform3fv(int location, int count, const float* value) {
+    RecordGlCall("glUniform3fv", location, count);
+}
+void glUniform4fv(int location, int count, const float* value) {
+    RecordGlCall("glUniform4fv", location, count);
+}
+void glUniformMatrix4fv(int location, int count, unsigned char transpose, const float* value) {
+    RecordGlCall("glUniformMatrix4fv", location, count, transpose);
+}
+void glBindBufferRange(
+    unsigned target,
+    unsigned index,
+    unsigned buffer,
+    intptr_t offset,
+    intptr_t size) {
+    RecordGlCall("glBindBufferRange", target, index, buffer, offset, size);
+}
+void glBindBufferBase(unsigned target, unsigned index, unsigned buffer) {
+    RecordGlCall("glBindBufferBase", target, index, buffer);
+}
+void glActiveTexture(unsigned texture) {
+    RecordGlCall("glActiveTexture", texture);
+}
+void glBindTexture(unsigned target, unsigned texture) {
+    RecordGlCall("glBindTexture", target, texture);
+}
+void glDrawElements(unsigned mode, int count, unsigned type, const void* indices) {
+    RecordGlCall("glDrawElements", mode, count, type);
+}
+void glDrawElementsInstanced(
+    unsigned mode,
+    int count,
+    unsigned type,
+    const void* indices,
+    int instancecount) {
+    RecordGlCall("glDrawElementsInstanced", mode, count, type, instancecount);
+}
+bool GLCheckErrorsWithTitle(const char* logTitle) {
+    return false;
+}
+void glBindBuffer(unsigned target, unsigned buffer) {}
+void glBindVertexArray(unsigned array) {}
+void glEnableVertexAttribArray(unsigned index) {}
+void glVertexAttribDivisor(unsigned index, unsigned divisor) {}
+void glVertexAttribPointer(
+    unsigned index,
+    int size,
+    unsigned type,
+    unsigned char normalized,
+    int stride,
+    const void* pointer) {}
+}
+
+namespace OVRFW {
+
+static unsigned NextGlName() {
+    static unsigned name = 0;
+    return ++name;
+}
+
+GlProgram GlProgram::Build(
+    const char* vertexSrc,
+    const char* fragmentSrc,
+    const ovrProgramParm* parms,
+    const int numParms,
+    const int programVersion,
+    bool abortOnError) {
+    GlProgram program;
+    program.Program = NextGlName();
+    program.VertexShader = NextGlName();
+    program.FragmentShader = NextGlName();
+    return program;
+}
+
+void GlProgram::Free(GlProgram& program) {
+    program = GlProgram();
+}
+
+void ovrGraphicsCommand::BindUniformTextures() {
+    for (int i = 0; i < ovrUniform::MAX_UNIFORMS; ++i) {
+        const ovrUniform& uniform = Program.Uniforms[i];
+        if (uniform.Type == ovrProgramParmType::TEXTURE_SAMPLED) {
+            UniformData[i].Data = &Textures[uniform.Binding];
+        }
+    }
+}
+
+GlTexture LoadTextureFromBuffer(
+    const char* fileName,
+    const uint8_t* buffer,
+    size_t bufferSize,
+    const TextureFlags_t& flags,
+    int& width,
+    int& height) {
+    width = 256;
+    height = 256;
+    return GlTexture(NextGlName(), width, height);
+}
+
+GlTexture LoadTextureFromUri(
+    ovrFileSys& fileSys,
+    const char* uri,
+    const TextureFlags_t& flags,
+    int& width,
+    int& height) {
+    std::vector<uint8_t> buffer;
+    if (!fileSys.ReadFile(uri, buffer)) {
+        return GlTexture();
+    }
+    return LoadTextureFromBuffer(uri, buffer.data(), buffer.size(), flags, width, height);
+}
+
+GlTexture LoadRGBATextureFromMemory(
+    const uint8_t* texture,
+    const int width,
+    const int height,
+    const bool useSrgbFormat) {
+    return GlTexture(NextGlName(), width, height);
+}
+
+GlTexture LoadASTCTextureFromMemory(
+    const uint8_t* buffer,
+    const size_t bufferSize,
+    const int numPlanes,
+    const bool useSrgbFormat) {
+    return GlTexture(NextGlName(), 256, 256);
+}
+
+GlTexture::GlTexture(const unsigned texture_, const int w, const int h)
+    : texture(texture_), target(0), Width(w), Height(h) {}
+
+// Decoding runs on the worker threads.
+static std::mutex DecodedFilesMutex;
+static std::vector<Test::ovrDecodedFile> DecodedFiles;
+
+bool DecodeTextureFromBuffer(
+    const char* fileName,
+    const uint8_t* data,
+    const size_t size,
+    const std::shared_ptr<const void>& owner,
+    const TextureFlags_t& flags,
+    ovrDecodedTexture& decoded) {
+    decoded = ovrDecodedTexture();
+    if (fileName == nullptr || data == nullptr || size == 0) {
+        return false;
+    }
+    {
+        std::lock_guard<std::mutex> lock(DecodedFilesMutex);
+        DecodedFiles.push_back({fileName, data, size, std::this_thread::get_id()});
+    }
+    decoded.FileName = fileName;
+    decoded.Flags = flags;
+    decoded.File = data;
+    decoded.FileSize = size;
+    decoded.FileOwner = owner;
+    return true;
+}
+
+bool DecodeTextureFromBuffer(
+    const char* fileName,
+    std::vector<uint8_t> buffer,
+    const TextureFlags_t& flags,
+    ovrDecodedTexture& decoded) {
+    auto file = std::make_shared<std::vector<uint8_t>>(std::move(buffer));
+    return DecodeTextureFromBuffer(fileName, file->data(), file->size(), file, flags, decoded);
+}
+
+size_t ovrDecodedTexture::GetUploadSize() const {
+    return (Data != nullptr) ? DataSize : FileSize;
+}
+
+static std::vector<std::string> CreatedTextures;
+
+GlTexture CreateTextureFromDecoded(const ovrDecodedTexture& decoded) {
+    CreatedTextures.push_back(decoded.FileName);
+    return GlTexture(NextGlName(), 256, 256);
+}
+
+void MakeTextureClamped(GlTexture texid) {}
+void MakeTextureRepeat(GlTexture texid) {}
+void MakeTextureTrilinear(GlTexture texid) {}
+void MakeTextureLinear(GlTexture texId) {}
+void MakeTextureLinearNearest(GlTexture texId) {}
+void MakeTextureLodClamped(GlTexture texId, int maxLod) {}
+void MakeTextureAniso(GlTexture texId, float maxAniso) {}
+void FreeTexture(GlTexture texId) {}
+void DeleteTexture(GlTexture& texture) {
+    texture = GlTexture();
+}
+
+void GlGeometry::Create(
+    const VertexAttribs& attribs,
+    const std::vector<TriangleIndex>& indices,
+    const VertexLayout& layout) {
+    vertexBuffer = NextGlName();
+    indexBuffer = NextGlName();
+    vertexArrayObject = NextGlName();
+    vertexCount = static_cast<int>(attribs.position.size());
+    indexCount = static_cast<int>(indices.size());
+    localBounds.Clear();
+    for (const OVR::Vector3f& position : attribs.position) {
+        localBounds.AddPoint(position);
+    }
+}
+
+void GlGeometry::Create(
+    const VertexAttribs& attribs,
+    const std::vector<TriangleIndex32>& indices,
+    const VertexLayout& layout) {
+    vertexBuffer = NextGlName();
+    indexBuffer = NextGlName();
+    vertexArrayObject = NextGlName();
+    vertexCount = static_cast<int>(attribs.position.size());
+    indexCount = static_cast<int>(indices.size());
+    localBounds.Clear();
+    for (const OVR::Vector3f& position : attribs.position) {
+        localBounds.AddPoint(position);
+    }
+    indexType = kIndexTypeUnsignedInt;
+}
+
+// Without a driver limit meshes are never split.
+bool PreferSplitGeometry(const std::vector<GeometrySplit>& splits, const int vertexCount) {
+    return false;
+}
+
+void GlGeometry::Free() {
+    *this = GlGeometry();
+}
+
+// Only the last update is kept.
+static std::vector<uint8_t> VertexUpdate;
+static size_t VertexUpdateOffset = 0;
+
+void GlGeometry::UpdateVertexRange(const void* packed, const size_t offset, const size_t size) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(packed);
+    VertexUpdate.assign(bytes, bytes + size);
+    VertexUpdateOffset = offset;
+}
+
+GlGeometry FontGeometryCreate(fontVertex_t* verts, int numVerts, OVR::Bounds3f& localBounds) {
+    GlGeometry geo;
+    geo.vertexBuffer = NextGlName();
+    geo.indexBuffer = NextGlName();
+    geo.vertexCount = numVerts;
+    geo.indexCount = (numVerts / 2) * 3;
+    geo.localBounds = localBounds;
+    return geo;
+}
+
+void FontGeometryUpdate(GlGeometry& geo, fontVertex_t* verts, int numVerts, int numIndices) {
+    geo.indexCount = numIndices;
+}
+
+void FontGeometryBindStream(
+    GlGeometry& geo,
+    const uint32_t buffer,
+    const size_t offset,
+    int numIndices) {
+    geo.indexCount = numIndices;
+}
+
+GlStreamBuffer::GlStreamBuffer() : Buffer(0), FrameIndex(0), Mapped(false) {}
+
+// Each allocation replaces the previous one.
+static std::vector<uint8_t> StreamMemory;
+
+GlStreamBuffer::Allocation GlStreamBuffer::Map(const size_t size, const size_t alignment) {
+    StreamMemory.assign(size, 0);
+    Allocation allocation;
+    allocation.buffer = 1;
+    allocation.data = StreamMemory.data();
+    return allocation;
+}
+
+void GlStreamBuffer::Unmap() {}
+
+// Buffers keep their memory when unmapped, so tests can read back what was written.
+static std::map<unsigned, std::vector<uint8_t>> BufferMemory;
+
+GlBuffer::GlBuffer() : target(0), buffer(0), size(0) {}
+
+bool GlBuffer::Create(const GlBufferType_t type, const size_t dataSize, const void* data) {
+    buffer = NextGlName();
+    size = dataSize;
+    BufferMemory[buffer].assign(dataSize, 0);
+    return true;
+}
+
+void GlBuffer::Destroy() {
+    BufferMemory.erase(buffer);
+    buffer = 0;
+}
+
+void* GlBuffer::MapBuffer() const {
+    return BufferMemory[buffer].data();
+}
+
+void GlBuffer::UnmapBuffer() const {}
+
+namespace Test {
+const void* GetLastStreamAllocation() {
+    return StreamMemory.data();
+}
+
+const std::vector<uint8_t>& GetLastVertexUpdate(size_t& offset) {
+    offset = VertexUpdateOffset;
+    return VertexUpdate;
+}
+
+std::vector<ovrDecodedFile> TakeDecodedFiles() {
+    std::lock_guard<std::mutex> lock(DecodedFilesMutex);
+    return std::move(DecodedFiles);
+}
+
+std::vector<std::string> TakeCreatedTextures() {
+    return std::move(CreatedTextures);
+}
+
+std::vector<ovrGlCall> TakeGlCalls() {
+    return std::move(GlCalls);
+}
+
+const uint8_t* GetBufferMemory(const unsigned buffer) {
+    auto it = BufferMemory.find(buffer);
+    return (it != BufferMemory.end()) ? it->second.data() : nullptr;
+}
+} // namespace Test
+
+GlStreamBuffer& GetVertexStreamBuffer() {
+    static GlStreamBuffer streamBuffer;
+    return streamBuffer;
+}
+
+} // namespace OVRFW
@@ -0,0 +1,34 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * Licensed under the Oculus SDK License Agreement (the "License");
+ * you may not use the Oculus SDK except in compliance with the License,
+ * which is provided at the time of installation or download, or which
+ * otherwise accompanies this software in either electronic or hard copy form.
+ *
+ * You may obtain a copy of the License at
+ * https://developer.oculus.com/licenses/oculussdk/
+ *
+ * Unless required by applicable law or agreed to in writing, the Oculus SDK
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/************************************************************************************
+
+Filename    :   xlog.h
+Content     :   Stand-in for the folly logging macro OVR_LogUtils.h uses on Linux and Mac,
+                so the headless tests build without folly.
+Language    :   C++
+
+*************************************************************************************/
+
+#pragma once
+
+#include <cstdio>
+#include <string>
+
+#define XLOG(LEVEL, MESSAGE) \
+    ((void)fprintf(stderr, "[" #LEVEL "] %s\n", std::string(MESSAGE).c_str()))
@@ -0,0 +1,342 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * Licensed under the Oculus SDK License Agreement (the "License");
+ * you may not use the Oculus SDK except in compliance with the License,
+ * which is provided at the time of installation or download, or which
+ * otherwise accompanies this software in either electronic or hard copy form.
+ *
+ * You may obtain a copy of the License at
+ * https://developer.oculus.com/licenses/oculussdk/
+ *
+ * Unless required by applicable law or agreed to in writing, the Oculus SDK
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/************************************************************************************
+
+Filename    :   SurfaceRenderTests.cpp
+Content     :   Tests for how surface lists are split into instanced batches and drawn, and
+                the GL state changes the draws make.
+Language    :   C++
+
+*************************************************************************************/
+
+#include "FrameworkTest.h"
+
+#include "Render/SurfaceRender.h"
+
+#include <cstring>
+#include <map>
+#include <vector>
+
+using namespace OVRFW;
+using OVR::Matrix4f;
+
+static void MakeBatchable(ovrSurfaceDef& surface) {
+    surface.graphicsCommand.Program.Program = 1;
+    surface.graphicsCommand.Program.InstanceBatch.Location = 0;
+    surface.graphicsCommand.Program.InstanceMatrices.Location = 0;
+}
+
+static std::vector<ovrDrawSurface> MakeList(const std::vector<const ovrSurfaceDef*>& surfaces) {
+    std::vector<ovrDrawSurface> list(surfaces.size());
+    for (size_t i = 0; i < surfaces.size(); i++) {
+        list[i].surface = surfaces[i];
+    }
+    return list;
+}
+
+// Splits the list the way RenderSurfaceList does.
+static std::vector<int> BatchLengths(const std::vector<ovrDrawSurface>& list) {
+    std::vector<int> lengths;
+    for (int first = 0; first < static_cast<int>(list.size());) {
+        lengths.push_back(ovrSurfaceRender::BatchLength(list, first));
+        first += lengths.back();
+    }
+    return lengths;
+}
+
+OVR_TEST(SurfaceRender, ConsecutiveDrawsOfASurfaceBatch) {
+    ovrSurfaceDef a;
+    ovrSurfaceDef b;
+    MakeBatchable(a);
+    MakeBatchable(b);
+
+    // only consecutive draws merge, so the order of the list is kept
+    const std::vector<int> lengths = BatchLengths(MakeList({&a, &a, &a, &b, &b, &a, &b}));
+    OVR_CHECK((lengths == std::vector<int>{3, 2, 1, 1}));
+}
+
+OVR_TEST(SurfaceRender, UnbatchableSurfacesDrawAlone) {
+    ovrSurfaceDef plain; // the program doesn't read the batch matrices
+    ovrSurfaceDef instanced;
+    MakeBatchable(instanced);
+    instanced.numInstances = 4;
+    ovrSurfaceDef noMatrices;
+    MakeBatchable(noMatrices);
+    noMatrices.graphicsCommand.Program.InstanceMatrices.Location = -1;
+
+    const std::vector<int> lengths = BatchLengths(MakeList(
+        {&plain, &plain, &instanced, &instanced, &noMatrices, &noMatrices, nullptr, nullptr}));
+    OVR_CHECK((lengths == std::vector<int>(8, 1)));
+}
+
+OVR_TEST(SurfaceRender, BatchesAreLimitedToTheMatrixBlock) {
+    ovrSurfaceDef a;
+    MakeBatchable(a);
+    const int max = GlProgram::MAX_BATCH_INSTANCES;
+    const std::vector<const ovrSurfaceDef*> surfaces(max * 2 + 3, &a);
+
+    const std::vector<int> lengths = BatchLengths(MakeList(surfaces));
+    OVR_CHECK((lengths == std::vector<int>{max, max, 3}));
+}
+
+static const int64_t GL_UNIFORM_BUFFER_TARGET = 0x8A11;
+static const int INSTANCE_BATCH_LOCATION = 2;
+static const int INSTANCE_MATRICES_BINDING = 1;
+
+// A surface with the uniforms every program gets from the vertex header, set up the way
+// GlProgram::Build does it. Without the instance uniforms it stands for a program that doesn't
+// read its model matrix, so the compiler removed them.
+static void MakeDrawable(ovrSurfaceDef& surface, const unsigned program, const bool instanceBlock) {
+    GlProgram& p = surface.graphicsCommand.Program;
+    p.Program = program;
+    p.ModelMatrix.Location = 1;
+    p.SceneMatrices.Location = 0;
+    p.SceneMatrices.Binding = 0;
+    if (instanceBlock) {
+        p.InstanceBatch.Location = INSTANCE_BATCH_LOCATION;
+        p.InstanceMatrices.Location = 1;
+        p.InstanceMatrices.Binding = INSTANCE_MATRICES_BINDING;
+    }
+    surface.geo.indexCount = 36;
+}
+
+// A draw and the instance state GL sees for it.
+struct ovrRecordedDraw {
+    int instances = 1; // 0 for glDrawElements
+    bool haveRange = false; // a range is bound to the instance matrices binding
+    int64_t buffer = 0;
+    int64_t offset = 0;
+    int64_t size = 0;
+    int64_t instanceBatch = 0;
+    int rangeBinds = 0; // glBindBufferRange calls since the previous draw
+};
+
+static std::vector<ovrRecordedDraw> GetDraws(const std::vector<Test::ovrGlCall>& calls) {
+    std::vector<ovrRecordedDraw> draws;
+    ovrRecordedDraw state;
+    for (const Test::ovrGlCall& call : calls) {
+        if (call.function == "glBindBufferRange" && call.args[0] == GL_UNIFORM_BUFFER_TARGET &&
+            call.args[1] == INSTANCE_MATRICES_BINDING) {
+            state.haveRange = true;
+            state.buffer = call.args[2];
+            state.offset = call.args[3];
+            state.size = call.args[4];
+            state.rangeBinds++;
+        } else if (call.function == "glUniform1i" && call.args[0] == INSTANCE_BATCH_LOCATION) {
+            state.instanceBatch = call.args[1];
+        } else if (call.function == "glDrawElements") {
+            state.instances = 0;
+            draws.push_back(state);
+            state.rangeBinds = 0;
+        } else if (call.function == "glDrawElementsInstanced") {
+            state.instances = static_cast<int>(call.args[3]);
+            draws.push_back(state);
+            state.rangeBinds = 0;
+        }
+    }
+    // the batch flag must be off again once the list is drawn
+    draws.push_back(state);
+    draws.back().instances = -1;
+    return draws;
+}
+
+// The model matrices of a batch as the shader reads them from the instance matrices block.
+static bool BatchMatricesMatch(
+    const ovrRecordedDraw& draw,
+    const std::vector<ovrDrawSurface>& list,
+    const int first) {
+    const uint8_t* memory = Test::GetBufferMemory(static_cast<unsigned>(draw.buffer));
+    if (memory == nullptr) {
+        return false;
+    }
+    for (int i = 0; i < draw.instances; i++) {
+        const Matrix4f transposed = list[first + i].modelMatrix.Transposed();
+        const uint8_t* matrix = memory + draw.offset + i * sizeof(Matrix4f);
+        if (memcmp(matrix, &transposed, sizeof(Matrix4f)) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+OVR_TEST(SurfaceRender, BatchesDrawInstanced) {
+    ovrSurfaceRender render;
+    render.Init();
+    ovrSurfaceDef a;
+    ovrSurfaceDef b;
+    ovrSurfaceDef plain;
+    MakeDrawable(a, 1, true);
+    MakeDrawable(b, 2, true);
+    MakeDrawable(plain, 3, false);
+
+    std::vector<ovrDrawSurface> list = MakeList({&b, &a, &a, &a, &plain, &a, &a});
+    for (int i = 0; i < static_cast<int>(list.size()); i++) {
+        list[i].modelMatrix = Matrix4f::Translation(static_cast<float>(i), 1.0f, 2.0f);
+    }
+    // the matrices are read as arrays with one per view
+    const Matrix4f views[GlProgram::MAX_VIEWS];
+    Test::TakeGlCalls();
+    const ovrDrawCounters counters = render.RenderSurfaceList(list, views[0], views[0], 0);
+    const std::vector<ovrRecordedDraw> draws = GetDraws(Test::TakeGlCalls());
+
+    OVR_CHECK(counters.numDrawCalls == 4);
+    OVR_CHECK(counters.numBatchedDraws == 2);
+    OVR_CHECK(counters.numBatchedSurfaces == 5);
+    OVR_CHECK(draws.size() == 5);
+    if (draws.size() != 5) {
+        render.Shutdown();
+        return;
+    }
+    const int blockSize = GlProgram::INSTANCE_MATRICES_UBO_SIZE;
+
+    // the single draw of a program with the block still sees a whole block
+    OVR_CHECK(draws[0].instances == 0);
+    OVR_CHECK(draws[0].haveRange && draws[0].size == blockSize);
+    OVR_CHECK(draws[0].instanceBatch == 0);
+
+    OVR_CHECK(draws[1].instances == 3);
+    OVR_CHECK(draws[1].rangeBinds == 1 && draws[1].offset == 0 && draws[1].size == blockSize);
+    OVR_CHECK(draws[1].instanceBatch == 1);
+    OVR_CHECK(BatchMatricesMatch(draws[1], list, 1));
+
+    // a program without the block binds nothing and the batch flag was reset
+    OVR_CHECK(draws[2].instances == 0);
+    OVR_CHECK(draws[2].rangeBinds == 0);
+    OVR_CHECK(draws[2].instanceBatch == 0);
+
+    // the next batch starts at the next aligned offset of the same buffer
+    OVR_CHECK(draws[3].instances == 2);
+    OVR_CHECK(draws[3].rangeBinds == 1 && draws[3].offset == 256 && draws[3].size == blockSize);
+    OVR_CHECK(draws[3].buffer == draws[1].buffer);
+    OVR_CHECK(draws[3].instanceBatch == 1);
+    OVR_CHECK(BatchMatricesMatch(draws[3], list, 5));
+
+    OVR_CHECK(draws[4].instanceBatch == 0);
+    render.Shutdown();
+}
+
+OVR_TEST(SurfaceRender, SingleDrawsBindTheInstanceBlockOnce) {
+    ovrSurfaceRender render;
+    render.Init();
+    ovrSurfaceDef a;
+    ovrSurfaceDef b;
+    MakeDrawable(a, 1, true);
+    MakeDrawable(b, 2, true);
+
+    const std::vector<ovrDrawSurface> list = MakeList({&a, &b, &a, &b});
+    // the matrices are read as arrays with one per view
+    const Matrix4f views[GlProgram::MAX_VIEWS];
+    Test::TakeGlCalls();
+    const ovrDrawCounters counters = render.RenderSurfaceList(list, views[0], views[0], 0);
+    const std::vector<ovrRecordedDraw> draws = GetDraws(Test::TakeGlCalls());
+
+    OVR_CHECK(counters.numDrawCalls == 4 && counters.numBatchedDraws == 0);
+    OVR_CHECK(draws.size() == 5);
+    int rangeBinds = 0;
+    bool wholeBlocks = true;
+    for (size_t i = 0; i + 1 < draws.size(); i++) {
+        rangeBinds += draws[i].rangeBinds;
+        wholeBlocks = wholeBlocks && draws[i].instances == 0 && draws[i].haveRange &&
+            draws[i].size == GlProgram::INSTANCE_MATRICES_UBO_SIZE && draws[i].instanceBatch == 0;
+    }
+    OVR_CHECK(wholeBlocks);
+    OVR_CHECK(rangeBinds == 1);
+    render.Shutdown();
+}
+
+static int CountGlCalls(const std::vector<Test::ovrGlCall>& calls, const char* function) {
+    int count = 0;
+    for (const Test::ovrGlCall& call : calls) {
+        count += (call.function == function) ? 1 : 0;
+    }
+    return count;
+}
+
+// Four materials over two programs and two textures, drawn three times each in the interleaved
+// order a scene graph submits them, and then in DrawSortKey order.
+OVR_TEST(SurfaceRender, SortedListSkipsRedundantState) {
+    ovrSurfaceRender render;
+    render.Init();
+    GlTexture textures[2] = {GlTexture(10, 0, 4, 4), GlTexture(11, 0, 4, 4)};
+    OVR::Vector4f colors[4] = {
+        OVR::Vector4f(1.0f, 0.0f, 0.0f, 1.0f),
+        OVR::Vector4f(0.0f, 1.0f, 0.0f, 1.0f),
+        OVR::Vector4f(0.0f, 0.0f, 1.0f, 1.0f),
+        OVR::Vector4f(1.0f, 1.0f, 1.0f, 1.0f)};
+    ovrSurfaceDef materials[4];
+    for (int m = 0; m < 4; m++) {
+        ovrSurfaceDef& surface = materials[m];
+        MakeDrawable(surface, 1 + m % 2, false);
+        GlProgram& p = surface.graphicsCommand.Program;
+        p.Uniforms[0].Location = 3;
+        p.Uniforms[0].Type = ovrProgramParmType::FLOAT_VECTOR4;
+        p.Uniforms[1].Binding = 0;
+        p.Uniforms[1].Type = ovrProgramParmType::TEXTURE_SAMPLED;
+        surface.graphicsCommand.UniformData[0].Data = &colors[m];
+        surface.graphicsCommand.UniformData[1].Data = &textures[m / 2];
+    }
+
+    std::vector<ovrDrawSurface> submitted;
+    for (int i = 0; i < 12; i++) {
+        submitted.push_back(ovrDrawSurface(
+            Matrix4f::Translation(static_cast<float>(i), 0.0f, 0.0f), &materials[i % 4]));
+    }
+    std::vector<ovrDrawSortItem> items;
+    std::vector<ovrDrawSortItem> temp;
+    for (int i = 0; i < static_cast<int>(submitted.size()); i++) {
+        items.push_back({DrawSortKey(*submitted[i].surface, 0, i), i});
+    }
+    RadixSortDrawKeys(items, temp);
+    std::vector<ovrDrawSurface> sorted;
+    for (const ovrDrawSortItem& item : items) {
+        sorted.push_back(submitted[item.index]);
+    }
+
+    const Matrix4f views[GlProgram::MAX_VIEWS];
+    Test::TakeGlCalls();
+    const ovrDrawCounters before = render.RenderSurfaceList(submitted, views[0], views[0], 0);
+    const std::vector<Test::ovrGlCall> beforeCalls = Test::TakeGlCalls();
+    const ovrDrawCounters after = render.RenderSurfaceList(sorted, views[0], views[0], 0);
+    const std::vector<Test::ovrGlCall> afterCalls = Test::TakeGlCalls();
+
+    OVR_CHECK(before.numDrawCalls == 12 && after.numDrawCalls == 12);
+    OVR_CHECK(CountGlCalls(beforeCalls, "glDrawElements") == 12);
+    OVR_CHECK(CountGlCalls(afterCalls, "glDrawElements") == 12);
+
+    // The program changes on every submitted draw, and once in sorted order. Each program
+    // alternates between its two textures, and sorted it binds each once. The calls include
+    // the unbinds at the end of the list.
+    OVR_CHECK(before.numProgramBinds == 12 && CountGlCalls(beforeCalls, "glUseProgram") == 13);
+    OVR_CHECK(after.numProgramBinds == 2 && CountGlCalls(afterCalls, "glUseProgram") == 3);
+    OVR_CHECK(before.numTextureBinds == 6 && CountGlCalls(beforeCalls, "glBindTexture") == 7);
+    OVR_CHECK(after.numTextureBinds == 4 && CountGlCalls(afterCalls, "glBindTexture") == 5);
+
+    // each program alternates between two colors, so its shadow copy only helps once sorted
+    OVR_CHECK(before.numParameterUpdates == 12 && before.numParameterSkips == 0);
+    OVR_CHECK(CountGlCalls(beforeCalls, "glUniform4fv") == 12);
+    OVR_CHECK(after.numParameterUpdates == 4 && after.numParameterSkips == 8);
+    OVR_CHECK(CountGlCalls(afterCalls, "glUniform4fv") == 4);
+
+    // every surface has its own model matrix, and the scene matrices are bound once
+    OVR_CHECK(CountGlCalls(beforeCalls, "glUniformMatrix4fv") == 12);
+    OVR_CHECK(CountGlCalls(afterCalls, "glUniformMatrix4fv") == 12);
+    OVR_CHECK(before.numBufferBinds == 1 && CountGlCalls(beforeCalls, "glBindBufferBase") == 1);
+    OVR_CHECK(after.numBufferBinds == 1 && CountGlCalls(afterCalls, "glBindBufferBase") == 1);
+    render.Shutdown();
+}
@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * Licensed under the Oculus SDK License Agreement (the "License");
+ * you may not use the Oculus SDK except in compliance with the License,
+ * which is provided at the time of installation or download, or which
+ * otherwise accompanies this software in either electronic or hard copy form.
+ *
+ * You may obtain a copy of the License at
+ * https://developer.oculus.com/licenses/oculussdk/
+ *
+ * Unless required by applicable law or agreed to in writing, the Oculus SDK
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/************************************************************************************
+
+Filename    :   SystemTests.cpp
+Content     :   Tests for the worker pool behind ParallelFor.
+Language    :   C++
+
+*************************************************************************************/
+
+#include "FrameworkTest.h"
+
+#include "System.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace OVRFW;
+
+OVR_TEST(ParallelFor, RunsEveryIndexOnce) {
+    for (const int count : {0, 1, 7, 1000}) {
+        std::vector<std::atomic<int>> runs(count);
+        for (std::atomic<int>& r : runs) {
+            r = 0;
+        }
+        ParallelFor(count, [&](int index) { runs[index]++; });
+        for (const std::atomic<int>& r : runs) {
+            OVR_CHECK(r == 1);
+        }
+    }
+}
+
+OVR_TEST(ParallelFor, Nested) {
+    // the inner loops find the pool busy and run on the thread of the outer job
+    std::atomic<int> total(0);
+    ParallelFor(16, [&](int) { ParallelFor(16, [&](int index) { total += index; }); });
+    OVR_CHECK(total == 16 * (15 * 16 / 2));
+}
+
+OVR_TEST(ParallelFor, ConcurrentCallers) {
+    std::atomic<int> totals[4] = {};
+    std::vector<std::thread> callers;
+    for (int c = 0; c < 4; c++) {
+        callers.emplace_back([&totals, c]() {
+            for (int repeat = 0; repeat < 50; repeat++) {
+                ParallelFor(64, [&totals, c](int index) { totals[c] += index; });
+            }
+        });
+    }
+    for (std::thread& caller : callers) {
+        caller.join();
+    }
+    for (const std::atomic<int>& total : totals) {
+        OVR_CHECK(total == 50 * (63 * 64 / 2));
+    }
+}
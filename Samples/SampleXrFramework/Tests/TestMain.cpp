@@ -0,0 +1,222 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * Licensed under the Oculus SDK License Agreement (the "License");
+ * you may not use the Oculus SDK except in compliance with the License,
+ * which is provided at the time of installation or download, or which
+ * otherwise accompanies this software in either electronic or hard copy form.
+ *
+ * You may obtain a copy of the License at
+ * https://developer.oculus.com/licenses/oculussdk/
+ *
+ * Unless required by applicable law or agreed to in writing, the Oculus SDK
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/************************************************************************************
+
+Filename    :   TestMain.cpp
+Content     :   Runs the headless framework tests and benchmarks.
+Language    :   C++
+
+Usage       :   SampleXrFrameworkTests [--bench] [Suite|Suite.Name ...]
+
+                Without --bench the tests are run, with it the benchmarks are. Without
+                names everything of that kind is run. Returns 1 if any test failed.
+
+*************************************************************************************/
+
+#include "FrameworkTest.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <vector>
+
+namespace OVRFW {
+namespace Test {
+
+struct ovrTestEntry {
+    const char* name;
+    void (*function)();
+    bool isBenchmark;
+};
+
+static std::vector<ovrTestEntry>& GetTests() {
+    static std::vector<ovrTestEntry> tests;
+    return tests;
+}
+
+ovrTestRegistrar::ovrTestRegistrar(const char* name, void (*function)(), const bool isBenchmark) {
+    GetTests().push_back({name, function, isBenchmark});
+}
+
+static int FailureCount = 0;
+
+void ReportFailure(const char* file, const int line, const char* expression) {
+    printf("%s(%d): check failed: %s\n", file, line, expression);
+    FailureCount++;
+}
+
+static std::atomic<size_t> AllocatedBytes(0);
+static std::atomic<size_t> PeakAllocatedBytes(0);
+static std::atomic<uint64_t> AllocationCount(0);
+
+size_t GetAllocatedBytes() {
+    return AllocatedBytes;
+}
+
+size_t GetPeakAllocatedBytes() {
+    return PeakAllocatedBytes;
+}
+
+void ResetPeakAllocatedBytes() {
+    PeakAllocatedBytes = AllocatedBytes.load();
+}
+
+uint64_t GetAllocationCount() {
+    return AllocationCount;
+}
+
+double TimeBestOf(const int runs, const std::function<void()>& function) {
+    double best = 0.0;
+    for (int i = 0; i < runs; i++) {
+        const auto start = std::chrono::steady_clock::now();
+        function();
+        const auto end = std::chrono::steady_clock::now();
+        const double ms = std::chrono::duration<double, std::milli>(end - start).count();
+        best = (i == 0) ? ms : std::min(best, ms);
+    }
+    return best;
+}
+
+// Each allocation is prefixed with its size, so the heap use can be tracked on delete.
+static const size_t ALLOCATION_HEADER = alignof(std::max_align_t);
+
+static void* TrackedAllocate(size_t size) {
+    uint8_t* block = static_cast<uint8_t*>(malloc(size + ALLOCATION_HEADER));
+    if (block == nullptr) {
+        throw std::bad_alloc();
+    }
+    *reinterpret_cast<size_t*>(block) = size;
+    const size_t allocated = AllocatedBytes += size;
+    size_t peak = PeakAllocatedBytes;
+    while (allocated > peak && !PeakAllocatedBytes.compare_exchange_weak(peak, allocated)) {
+    }
+    AllocationCount++;
+    return block + ALLOCATION_HEADER;
+}
+
+static void TrackedFree(void* ptr) {
+    if (ptr == nullptr) {
+        return;
+    }
+    uint8_t* block = static_cast<uint8_t*>(ptr) - ALLOCATION_HEADER;
+    AllocatedBytes -= *reinterpret_cast<size_t*>(block);
+    free(block);
+}
+
+static bool IsSelected(const char* name, const std::vector<std::string>& filters) {
+    if (filters.empty()) {
+        return true;
+    }
+    const size_t suiteLength = strchr(name, '.') - name;
+    for (const std::string& filter : filters) {
+        if (filter == name || filter.compare(0, std::string::npos, name, suiteLength) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace Test
+} // namespace OVRFW
+
+void* operator new(size_t size) {
+    return OVRFW::Test::TrackedAllocate(size);
+}
+void* operator new[](size_t size) {
+    return OVRFW::Test::TrackedAllocate(size);
+}
+// std::stable_sort and others allocate with the nothrow forms, which must also be tracked
+// since the blocks come back through the operator delete below.
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    try {
+        return OVRFW::Test::TrackedAllocate(size);
+    } catch (const std::bad_alloc&) {
+        return nullptr;
+    }
+}
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+    try {
+        return OVRFW::Test::TrackedAllocate(size);
+    } catch (const std::bad_alloc&) {
+        return nullptr;
+    }
+}
+void operator delete(void* ptr) noexcept {
+    OVRFW::Test::TrackedFree(ptr);
+}
+void operator delete[](void* ptr) noexcept {
+    OVRFW::Test::TrackedFree(ptr);
+}
+void operator delete(void* ptr, size_t) noexcept {
+    OVRFW::Test::TrackedFree(ptr);
+}
+void operator delete[](void* ptr, size_t) noexcept {
+    OVRFW::Test::TrackedFree(ptr);
+}
+
+int main(int argc, char* argv[]) {
+    using namespace OVRFW::Test;
+
+    bool benchmarks = false;
+    std::vector<std::string> filters;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--bench") == 0) {
+            benchmarks = true;
+        } else {
+            filters.push_back(argv[i]);
+        }
+    }
+
+    std::vector<ovrTestEntry> tests = GetTests();
+    std::sort(tests.begin(), tests.end(), [](const ovrTestEntry& a, const ovrTestEntry& b) {
+        return strcmp(a.name, b.name) < 0;
+    });
+
+    int runCount = 0;
+    int failedCount = 0;
+    for (const ovrTestEntry& test : tests) {
+        if (test.isBenchmark != benchmarks || !IsSelected(test.name, filters)) {
+            continue;
+        }
+        printf("[ RUN    ] %s\n", test.name);
+        fflush(stdout);
+        const int failuresBefore = FailureCount;
+        test.function();
+        const bool passed = (FailureCount == failuresBefore);
+        printf("[ %s ] %s\n", passed ? "    OK" : "FAILED", test.name);
+        fflush(stdout);
+        runCount++;
+        failedCount += passed ? 0 : 1;
+    }
+
+    if (runCount == 0) {
+        printf("No %s matched.\n", benchmarks ? "benchmarks" : "tests");
+        return 1;
+    }
+    printf(
+        "%d of %d %s passed.\n",
+        runCount - failedCount,
+        runCount,
+        benchmarks ? "benchmarks" : "tests");
+    return (failedCount == 0) ? 0 : 1;
+}
@@ -0,0 +1,368 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * Licensed under the Oculus SDK License Agreement (the "License");
+ * you may not use the Oculus SDK except in compliance with the License,
+ * which is provided at the time of installation or download, or which
+ * otherwise accompanies this software in either electronic or hard copy form.
+ *
+ * You may obtain a copy of the License at
+ * https://developer.oculus.com/licenses/oculussdk/
+ *
+ * Unless required by applicable law or agreed to in writing, the Oculus SDK
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/************************************************************************************
+
+Filename    :   TextureManagerTests.cpp
+Content     :   Tests for the asynchronous texture loads of the texture manager.
+Language    :   C++
+
+Notes       :   The stubs record the decodes and the texture creation instead of doing them,
+                so the tests only see when and where the manager does its work.
+
+*************************************************************************************/
+
+#include "FrameworkTest.h"
+
+#include "Render/TextureManager.h"
+#include "OVR_FileSys.h"
+
+#include <chrono>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace OVRFW;
+
+class ovrTextureFileSys : public ovrFileSys {
+   public:
+    ovrStream* OpenStream(char const* uri, ovrStreamMode const mode) override {
+        return nullptr;
+    }
+    void CloseStream(ovrStream*& stream) override {}
+
+    bool ReadFile(char const* uri, std::vector<uint8_t>& outBuffer) override {
+        auto it = Files.find(uri);
+        if (it == Files.end()) {
+            return false;
+        }
+        outBuffer = it->second;
+        return true;
+    }
+
+    bool FileExists(char const* uri) override {
+        return Files.find(uri) != Files.end();
+    }
+    bool GetLocalPathForURI(char const* uri, std::string& outputPath) override {
+        return false;
+    }
+
+    std::map<std::string, std::vector<uint8_t>> Files;
+};
+
+// The results of the load callbacks, in the order they are called.
+struct ovrLoadResults {
+    std::vector<textureHandle_t> Handles;
+    std::vector<bool> Success;
+
+    ovrTextureManager::ovrTextureLoadCallback Callback() {
+        return [this](textureHandle_t const handle, bool const success) {
+            Handles.push_back(handle);
+            Success.push_back(success);
+        };
+    }
+};
+
+// Waits until the decode threads have decoded count files, or a few seconds have passed, then
+// gives them the time to queue the files for upload.
+static std::vector<Test::ovrDecodedFile> WaitForDecodes(const size_t count) {
+    std::vector<Test::ovrDecodedFile> decoded;
+    for (int i = 0; i < 5000 && decoded.size() < count; i++) {
+        std::vector<Test::ovrDecodedFile> files = Test::TakeDecodedFiles();
+        decoded.insert(decoded.end(), files.begin(), files.end());
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    return decoded;
+}
+
+OVR_TEST(TextureManager, DecodesOnTheDecodeThreads) {
+    Test::TakeDecodedFiles();
+    Test::TakeCreatedTextures();
+    ovrTextureManager* manager = ovrTextureManager::Create();
+    ovrLoadResults results;
+
+    std::vector<uint8_t> buffer(1000, 7);
+    const textureHandle_t handle = manager->LoadTextureAsync(
+        "buffer.png",
+        buffer.data(),
+        buffer.size(),
+        ovrTextureManager::FILTER_DEFAULT,
+        ovrTextureManager::WRAP_DEFAULT,
+        results.Callback());
+    // the buffer was copied
+    buffer.assign(buffer.size(), 0);
+    OVR_CHECK(handle.IsValid());
+    OVR_CHECK(manager->GetLoadState(handle) == ovrTextureManager::LOAD_STATE_PENDING);
+    const GlTexture placeholder = manager->GetGlTexture(handle);
+    OVR_CHECK(placeholder.IsValid());
+    OVR_CHECK(manager->GetTexture(handle).GetTexture().texture == placeholder.texture);
+    OVR_CHECK(manager->GetTextureHandle("buffer.png") == handle);
+
+    std::vector<Test::ovrDecodedFile> decoded = WaitForDecodes(1);
+    OVR_CHECK(decoded.size() == 1);
+    if (decoded.size() == 1) {
+        OVR_CHECK(decoded[0].name == "buffer.png" && decoded[0].size == 1000);
+        OVR_CHECK(decoded[0].thread != std::this_thread::get_id());
+        // the stub keeps the copy without decoding it
+        OVR_CHECK(decoded[0].data[0] == 7 && decoded[0].data[999] == 7);
+    }
+    // nothing is created until Update()
+    OVR_CHECK(Test::TakeCreatedTextures().empty());
+    OVR_CHECK(manager->GetLoadState(handle) == ovrTextureManager::LOAD_STATE_PENDING);
+
+    manager->Update();
+    OVR_CHECK(Test::TakeCreatedTextures() == std::vector<std::string>{"buffer.png"});
+    OVR_CHECK(manager->GetLoadState(handle) == ovrTextureManager::LOAD_STATE_LOADED);
+    OVR_CHECK(manager->GetGlTexture(handle).IsValid());
+    OVR_CHECK(manager->GetGlTexture(handle).texture != placeholder.texture);
+    OVR_CHECK(results.Handles == std::vector<textureHandle_t>{handle});
+    OVR_CHECK(results.Success == std::vector<bool>{true});
+
+    // files are read on the decode threads as well
+    ovrTextureFileSys fileSys;
+    fileSys.Files["apk:///file.png"] = std::vector<uint8_t>(500, 1);
+    const textureHandle_t fileHandle = manager->LoadTextureAsync(fileSys, "apk:///file.png");
+    decoded = WaitForDecodes(1);
+    OVR_CHECK(decoded.size() == 1);
+    if (decoded.size() == 1) {
+        OVR_CHECK(decoded[0].name == "apk:///file.png" && decoded[0].size == 500);
+        OVR_CHECK(decoded[0].thread != std::this_thread::get_id());
+    }
+    manager->Update();
+    OVR_CHECK(manager->GetLoadState(fileHandle) == ovrTextureManager::LOAD_STATE_LOADED);
+    OVR_CHECK(Test::TakeCreatedTextures() == std::vector<std::string>{"apk:///file.png"});
+
+    ovrTextureManager::Destroy(manager);
+}
+
+OVR_TEST(TextureManager, FailedLoadsCanBeRetried) {
+    Test::TakeDecodedFiles();
+    ovrTextureManager* manager = ovrTextureManager::Create();
+    ovrTextureFileSys fileSys;
+    ovrLoadResults results;
+
+    const textureHandle_t missing = manager->LoadTextureAsync(
+        fileSys,
+        "apk:///missing.png",
+        ovrTextureManager::FILTER_DEFAULT,
+        ovrTextureManager::WRAP_DEFAULT,
+        results.Callback());
+    OVR_CHECK(manager->GetLoadState(missing) == ovrTextureManager::LOAD_STATE_PENDING);
+    // nothing was decoded, so there is no decode to wait for
+    for (int i = 0; i < 5000 && results.Handles.empty(); i++) {
+        manager->Update();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    OVR_CHECK(results.Handles == std::vector<textureHandle_t>{missing});
+    OVR_CHECK(results.Success == std::vector<bool>{false});
+    OVR_CHECK(manager->GetLoadState(missing) == ovrTextureManager::LOAD_STATE_FAILED);
+    OVR_CHECK(!manager->GetGlTexture(missing).IsValid());
+    OVR_CHECK(!manager->GetTextureHandle("apk:///missing.png").IsValid());
+    OVR_CHECK(Test::TakeCreatedTextures().empty());
+
+    // a new load of the uri tries again, the failed handle stays allocated until it is freed
+    fileSys.Files["apk:///missing.png"] = std::vector<uint8_t>(100, 1);
+    const textureHandle_t retry = manager->LoadTextureAsync(fileSys, "apk:///missing.png");
+    OVR_CHECK(retry.IsValid() && !(retry == missing));
+    OVR_CHECK(WaitForDecodes(1).size() == 1);
+    manager->Update();
+    OVR_CHECK(manager->GetLoadState(retry) == ovrTextureManager::LOAD_STATE_LOADED);
+    OVR_CHECK(manager->GetLoadState(missing) == ovrTextureManager::LOAD_STATE_FAILED);
+    manager->FreeTexture(missing);
+    OVR_CHECK(manager->GetLoadState(missing) == ovrTextureManager::LOAD_STATE_INVALID);
+    OVR_CHECK(manager->GetTextureHandle("apk:///missing.png") == retry);
+    OVR_CHECK(results.Handles.size() == 1);
+    Test::TakeCreatedTextures();
+
+    ovrTextureManager::Destroy(manager);
+}
+
+OVR_TEST(TextureManager, FreeingCancelsThePendingLoad) {
+    Test::TakeDecodedFiles();
+    Test::TakeCreatedTextures();
+    ovrTextureManager* manager = ovrTextureManager::Create();
+    ovrLoadResults results;
+
+    const std::vector<uint8_t> buffer(1000, 1);
+    const textureHandle_t handle = manager->LoadTextureAsync(
+        "freed.png",
+        buffer.data(),
+        buffer.size(),
+        ovrTextureManager::FILTER_DEFAULT,
+        ovrTextureManager::WRAP_DEFAULT,
+        results.Callback());
+    manager->FreeTexture(handle);
+    OVR_CHECK(manager->GetLoadState(handle) == ovrTextureManager::LOAD_STATE_INVALID);
+    OVR_CHECK(!manager->GetGlTexture(handle).IsValid());
+    OVR_CHECK(!manager->GetTextureHandle("freed.png").IsValid());
+
+    OVR_CHECK(WaitForDecodes(1).size() == 1);
+    for (int i = 0; i < 3; i++) {
+        manager->Update();
+    }
+    OVR_CHECK(results.Handles.empty());
+    OVR_CHECK(Test::TakeCreatedTextures().empty());
+
+    // the freed slot is reused by the next load, which the stale job must not complete
+    const textureHandle_t reused = manager->LoadTextureAsync(
+        "reused.png",
+        buffer.data(),
+        buffer.size(),
+        ovrTextureManager::FILTER_DEFAULT,
+        ovrTextureManager::WRAP_DEFAULT,
+        results.Callback());
+    OVR_CHECK(WaitForDecodes(1).size() == 1);
+    manager->Update();
+    OVR_CHECK(Test::TakeCreatedTextures() == std::vector<std::string>{"reused.png"});
+    OVR_CHECK(results.Handles == std::vector<textureHandle_t>{reused});
+
+    // a callback queued for the next Update() is dropped with its texture
+    manager->LoadTextureAsync(
+        "reused.png",
+        buffer.data(),
+        buffer.size(),
+        ovrTextureManager::FILTER_DEFAULT,
+        ovrTextureManager::WRAP_DEFAULT,
+        results.Callback());
+    manager->FreeTexture(reused);
+    manager->Update();
+    OVR_CHECK(results.Handles.size() == 1);
+
+    ovrTextureManager::Destroy(manager);
+}
+
+OVR_TEST(TextureManager, CallbacksRunInUpdate) {
+    Test::TakeDecodedFiles();
+    ovrTextureManager* manager = ovrTextureManager::Create();
+    ovrLoadResults results;
+
+    const std::vector<uint8_t> buffer(1000, 1);
+    const textureHandle_t loaded = manager->LoadTexture("loaded.png", buffer.data(), buffer.size());
+    OVR_CHECK(manager->GetLoadState(loaded) == ovrTextureManager::LOAD_STATE_LOADED);
+
+    // already loaded: the callback waits for the next Update() like any other
+    const textureHandle_t again = manager->LoadTextureAsync(
+        "loaded.png",
+        buffer.data(),
+        buffer.size(),
+        ovrTextureManager::FILTER_DEFAULT,
+        ovrTextureManager::WRAP_DEFAULT,
+        results.Callback());
+    OVR_CHECK(again == loaded);
+    OVR_CHECK(results.Handles.empty());
+    manager->Update();
+    OVR_CHECK(results.Handles == std::vector<textureHandle_t>{loaded});
+    OVR_CHECK(results.Success == std::vector<bool>{true});
+    manager->Update();
+    OVR_CHECK(results.Handles.size() == 1);
+
+    // a synchronous load finishes a pending one at once, the callback still waits for Update()
+    const textureHandle_t pending = manager->LoadTextureAsync(
+        "pending.png",
+        buffer.data(),
+        buffer.size(),
+        ovrTextureManager::FILTER_DEFAULT,
+        ovrTextureManager::WRAP_DEFAULT,
+        results.Callback());
+    const textureHandle_t finished =
+        manager->LoadTexture("pending.png", buffer.data(), buffer.size());
+    OVR_CHECK(finished == pending);
+    OVR_CHECK(manager->GetLoadState(pending) == ovrTextureManager::LOAD_STATE_LOADED);
+    OVR_CHECK(results.Handles.size() == 1);
+    OVR_CHECK(WaitForDecodes(1).size() == 1);
+    manager->Update();
+    OVR_CHECK(results.Handles.size() == 2 && results.Handles[1] == pending);
+    OVR_CHECK(results.Success.size() == 2 && results.Success[1]);
+    // the decoded file of the finished load is dropped
+    OVR_CHECK(Test::TakeCreatedTextures().empty());
+
+    // a callback can start loads, their callbacks run in the Update() after
+    std::vector<textureHandle_t> chained;
+    const textureHandle_t first = manager->LoadTextureAsync(
+        "loaded.png",
+        buffer.data(),
+        buffer.size(),
+        ovrTextureManager::FILTER_DEFAULT,
+        ovrTextureManager::WRAP_DEFAULT,
+        [&](textureHandle_t const handle, bool const success) {
+            chained.push_back(handle);
+            manager->LoadTextureAsync(
+                "pending.png",
+                buffer.data(),
+                buffer.size(),
+                ovrTextureManager::FILTER_DEFAULT,
+                ovrTextureManager::WRAP_DEFAULT,
+                [&](textureHandle_t const handle, bool const success) {
+                    chained.push_back(handle);
+                });
+        });
+    OVR_CHECK(chained.empty());
+    manager->Update();
+    OVR_CHECK(chained == std::vector<textureHandle_t>{first});
+    manager->Update();
+    OVR_CHECK(chained == (std::vector<textureHandle_t>{first, pending}));
+
+    ovrTextureManager::Destroy(manager);
+}
+
+OVR_TEST(TextureManager, UploadsWithinTheBudget) {
+    Test::TakeDecodedFiles();
+    Test::TakeCreatedTextures();
+    ovrTextureManager* manager = ovrTextureManager::Create();
+    const size_t megabyte = 1024 * 1024;
+    const std::vector<uint8_t> buffer(3 * megabyte, 1);
+
+    // returns the number of textures each Update() creates until all count are loaded
+    const auto loadAll = [&](const char* prefix, const int count) {
+        std::vector<textureHandle_t> handles;
+        for (int i = 0; i < count; i++) {
+            const std::string uri = prefix + std::to_string(i) + ".png";
+            handles.push_back(manager->LoadTextureAsync(uri.c_str(), buffer.data(), buffer.size()));
+        }
+        WaitForDecodes(count);
+        std::vector<size_t> perUpdate;
+        for (int i = 0; i < 2 * count; i++) {
+            manager->Update();
+            const size_t created = Test::TakeCreatedTextures().size();
+            if (created == 0) {
+                break;
+            }
+            perUpdate.push_back(created);
+        }
+        int loaded = 0;
+        for (const textureHandle_t& handle : handles) {
+            loaded += (manager->GetLoadState(handle) == ovrTextureManager::LOAD_STATE_LOADED);
+        }
+        OVR_CHECK(loaded == count);
+        return perUpdate;
+    };
+
+    // 3 MB textures against the default 4 MB budget
+    OVR_CHECK(loadAll("a", 4) == (std::vector<size_t>{1, 1, 1, 1}));
+
+    manager->SetUploadBudget(10 * megabyte);
+    OVR_CHECK(loadAll("b", 7) == (std::vector<size_t>{3, 3, 1}));
+
+    // a texture over the budget is still created, alone
+    manager->SetUploadBudget(megabyte);
+    OVR_CHECK(loadAll("c", 2) == (std::vector<size_t>{1, 1}));
+
+    ovrTextureManager::Destroy(manager);
+}
@@ -0,0 +1,294 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * Licensed under the Oculus SDK License Agreement (the "License");
+ * you may not use the Oculus SDK except in compliance with the License,
+ * which is provided at the time of installation or download, or which
+ * otherwise accompanies this software in either electronic or hard copy form.
+ *
+ * You may obtain a copy of the License at
+ * https://developer.oculus.com/licenses/oculussdk/
+ *
+ * Unless required by applicable law or agreed to in writing, the Oculus SDK
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "SceneModelGeometry.h"
+
+#include <algorithm>
+#include <cmath>
+
+/*
+================================================================================
+
+ovrSceneRangeAllocator
+
+================================================================================
+*/
+
+uint32_t ovrSceneRangeAllocator::Allocate(const uint32_t count) {
+    for (size_t i = 0; i < FreeRanges_.size(); i++) {
+        Range& range = FreeRanges_[i];
+        if (range.Count >= count) {
+            const uint32_t first = range.First;
+            range.First += count;
+            range.Count -= count;
+            if (range.Count == 0) {
+                FreeRanges_.erase(FreeRanges_.begin() + i);
+            }
+            return first;
+        }
+    }
+    // Extend a free range at the end of the buffer rather than leaving it as a hole.
+    if (!FreeRanges_.empty() && FreeRanges_.back().First + FreeRanges_.back().Count == Size_) {
+        const uint32_t first = FreeRanges_.back().First;
+        FreeRanges_.pop_back();
+        Size_ = first + count;
+        return first;
+    }
+    const uint32_t first = Size_;
+    Size_ += count;
+    return first;
+}
+
+void ovrSceneRangeAllocator::Free(const uint32_t first, const uint32_t count) {
+    if (count == 0) {
+        return;
+    }
+    auto next = std::lower_bound(
+        FreeRanges_.begin(), FreeRanges_.end(), first, [](const Range& range, uint32_t value) {
+            return range.First < value;
+        });
+    next = FreeRanges_.insert(next, Range{first, count});
+    // Merge with the following range.
+    if (next + 1 != FreeRanges_.end() && next->First + next->Count == (next + 1)->First) {
+        next->Count += (next + 1)->Count;
+        FreeRanges_.erase(next + 1);
+    }
+    // Merge with the preceding range.
+    if (next != FreeRanges_.begin() && (next - 1)->First + (next - 1)->Count == next->First) {
+        (next - 1)->Count += next->Count;
+        next = FreeRanges_.erase(next) - 1;
+    }
+    // Give a free range at the end back to the buffer.
+    if (next + 1 == FreeRanges_.end() && next->First + next->Count == Size_) {
+        Size_ = next->First;
+        FreeRanges_.pop_back();
+    }
+}
+
+/*
+================================================================================
+
+Scene entity meshes
+
+================================================================================
+*/
+
+uint64_t HashSceneData(const void* data, const size_t size, const uint64_t seed) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    uint64_t hash = seed ^ 14695981039346656037ULL;
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ bytes[i]) * 1099511628211ULL;
+    }
+    return hash;
+}
+
+static ovrSceneVertex SceneVertex(const XrVector3f& position, const XrColor4f& color) {
+    auto toByte = [](const float c) {
+        return static_cast<uint8_t>(std::min(std::max(c, 0.0f), 1.0f) * 255.0f + 0.5f);
+    };
+    return ovrSceneVertex{
+        position, {toByte(color.r), toByte(color.g), toByte(color.b), toByte(color.a)}};
+}
+
+// Twice the signed area of the triangle, positive if counter-clockwise.
+static float Cross(const XrVector2f& a, const XrVector2f& b, const XrVector2f& c) {
+    return (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+}
+
+bool TriangulatePolygon(
+    const XrVector2f* points,
+    const uint32_t count,
+    const uint32_t baseIndex,
+    std::vector<uint32_t>& indices) {
+    if (count < 3) {
+        return false;
+    }
+
+    float area = 0.0f;
+    float extent = 0.0f;
+    for (uint32_t i = 0, j = count - 1; i < count; j = i++) {
+        area += points[j].x * points[i].y - points[i].x * points[j].y;
+        extent = std::max(extent, std::max(std::fabs(points[i].x), std::fabs(points[i].y)));
+    }
+    // Tolerance for collinear points, relative to the size of the polygon.
+    const float epsilon = 1e-6f * std::max(extent * extent, 1e-6f);
+    if (std::fabs(area) <= epsilon) {
+        return false;
+    }
+    // Orient every test as if the polygon were counter-clockwise.
+    const float orientation = (area > 0.0f) ? 1.0f : -1.0f;
+
+    std::vector<uint32_t> remaining(count);
+    for (uint32_t i = 0; i < count; i++) {
+        remaining[i] = i;
+    }
+
+    const size_t firstIndex = indices.size();
+    uint32_t current = 0;
+    uint32_t attempts = 0;
+    while (remaining.size() > 3) {
+        const uint32_t n = static_cast<uint32_t>(remaining.size());
+        if (attempts++ >= n) {
+            // No ear left, the polygon intersects itself. Fan the rest so it still draws.
+            for (uint32_t i = 1; i + 1 < n; i++) {
+                indices.push_back(baseIndex + remaining[0]);
+                indices.push_back(baseIndex + remaining[i]);
+                indices.push_back(baseIndex + remaining[i + 1]);
+            }
+            remaining.clear();
+            break;
+        }
+
+        current %= n;
+        const uint32_t prev = remaining[(current + n - 1) % n];
+        const uint32_t curr = remaining[current];
+        const uint32_t next = remaining[(current + 1) % n];
+        const XrVector2f& a = points[prev];
+        const XrVector2f& b = points[curr];
+        const XrVector2f& c = points[next];
+
+        const float cross = Cross(a, b, c) * orientation;
+        if (std::fabs(cross) <= epsilon) {
+            // Collinear or repeated vertex, drop it without emitting a triangle.
+            remaining.erase(remaining.begin() + current);
+            attempts = 0;
+            continue;
+        }
+        bool isEar = cross > 0.0f;
+        for (uint32_t i = 0; isEar && i < n; i++) {
+            const uint32_t other = remaining[i];
+            if (other == prev || other == curr || other == next) {
+                continue;
+            }
+            const XrVector2f& p = points[other];
+            const bool inside = Cross(a, b, p) * orientation >= 0.0f &&
+                Cross(b, c, p) * orientation >= 0.0f && Cross(c, a, p) * orientation >= 0.0f;
+            isEar = !inside;
+        }
+        if (!isEar) {
+            current++;
+            continue;
+        }
+
+        indices.push_back(baseIndex + prev);
+        indices.push_back(baseIndex + curr);
+        indices.push_back(baseIndex + next);
+        remaining.erase(remaining.begin() + current);
+        attempts = 0;
+    }
+    if (remaining.size() == 3) {
+        indices.push_back(baseIndex + remaining[0]);
+        indices.push_back(baseIndex + remaining[1]);
+        indices.push_back(baseIndex + remaining[2]);
+    }
+    return indices.size() > firstIndex;
+}
+
+void BuildPlaneMesh(
+    const XrVector2f* points,
+    const uint32_t count,
+    const XrColor4f& color,
+    ovrSceneMeshData& mesh) {
+    mesh.Clear();
+    if (!TriangulatePolygon(points, count, 0, mesh.Indices)) {
+        return;
+    }
+    mesh.Vertices.reserve(count);
+    for (uint32_t i = 0; i < count; i++) {
+        mesh.Vertices.push_back(SceneVertex(XrVector3f{points[i].x, points[i].y, 0.0f}, color));
+    }
+}
+
+void BuildVolumeMesh(
+    const XrRect3DfFB& boundingBox3D,
+    const XrColor4f& color,
+    ovrSceneMeshData& mesh) {
+    const XrOffset3DfFB& offset = boundingBox3D.offset;
+    const XrExtent3DfFB& extent = boundingBox3D.extent;
+    const XrVector3f corners[8] = {
+        {offset.x, offset.y, offset.z},
+        {offset.x + extent.width, offset.y, offset.z},
+        {offset.x + extent.width, offset.y + extent.height, offset.z},
+        {offset.x, offset.y + extent.height, offset.z},
+        {offset.x, offset.y, offset.z + extent.depth},
+        {offset.x + extent.width, offset.y, offset.z + extent.depth},
+        {offset.x + extent.width, offset.y + extent.height, offset.z + extent.depth},
+        {offset.x, offset.y + extent.height, offset.z + extent.depth}};
+    static const uint32_t kIndices[36] = {
+        0, 2, 1, 2, 0, 3, // bottom
+        4, 6, 5, 6, 4, 7, // top
+        0, 1, 4, 1, 5, 4, // front
+        1, 2, 5, 2, 6, 5, // right
+        2, 3, 6, 3, 7, 6, // back
+        3, 0, 7, 0, 4, 7 // left
+    };
+
+    mesh.Clear();
+    for (const XrVector3f& corner : corners) {
+        mesh.Vertices.push_back(SceneVertex(corner, color));
+    }
+    mesh.Indices.assign(kIndices, kIndices + 36);
+}
+
+void BuildWireframeMesh(const XrSpaceTriangleMeshMETA& triangleMesh, ovrSceneMeshData& mesh) {
+    static const XrColor4f kWhite = {1.0f, 1.0f, 1.0f, 1.0f};
+
+    mesh.Clear();
+    mesh.Vertices.reserve(triangleMesh.vertexCountOutput);
+    for (uint32_t i = 0; i < triangleMesh.vertexCountOutput; i++) {
+        mesh.Vertices.push_back(SceneVertex(triangleMesh.vertices[i], kWhite));
+    }
+    const uint32_t indexCount = triangleMesh.indexCountOutput - triangleMesh.indexCountOutput % 3;
+    mesh.Indices.reserve(indexCount * 2);
+    for (uint32_t i = 0; i < indexCount; i += 3) {
+        for (uint32_t j = 0; j < 3; ++j) {
+            mesh.Indices.push_back(triangleMesh.indices[i + j]);
+            mesh.Indices.push_back(triangleMesh.indices[i + (j + 1) % 3]);
+        }
+    }
+}
+
+void BuildRoomMesh(
+    const XrRoomMeshMETA& roomMesh,
+    const XrRoomMeshFaceIndicesMETA* faceIndices,
+    const XrColor4f* faceColors,
+    ovrSceneMeshData& mesh,
+    std::vector<ovrSceneIndexRange>& faceRanges) {
+    mesh.Clear();
+    faceRanges.clear();
+    // Faces do not share vertices because every face has its own color.
+    for (uint32_t f = 0; f < roomMesh.faceCountOutput; ++f) {
+        const XrRoomMeshFaceIndicesMETA& face = faceIndices[f];
+        const uint32_t firstIndex = static_cast<uint32_t>(mesh.Indices.size());
+        for (uint32_t i = 0; i + 2 < face.indexCountOutput; i += 3) {
+            const uint32_t* triangle = &face.indices[i];
+            if (triangle[0] >= roomMesh.vertexCountOutput ||
+                triangle[1] >= roomMesh.vertexCountOutput ||
+                triangle[2] >= roomMesh.vertexCountOutput) {
+                continue;
+            }
+            for (uint32_t j = 0; j < 3; ++j) {
+                mesh.Indices.push_back(static_cast<uint32_t>(mesh.Vertices.size()));
+                mesh.Vertices.push_back(
+                    SceneVertex(roomMesh.vertices[triangle[j]], faceColors[f]));
+            }
+        }
+        faceRanges.push_back(ovrSceneIndexRange{
+            firstIndex, static_cast<uint32_t>(mesh.Indices.size()) - firstIndex});
+    }
+}
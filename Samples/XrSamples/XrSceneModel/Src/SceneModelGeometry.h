@@ -0,0 +1,133 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * Licensed under the Oculus SDK License Agreement (the "License");
+ * you may not use the Oculus SDK except in compliance with the License,
+ * which is provided at the time of installation or download, or which
+ * otherwise accompanies this software in either electronic or hard copy form.
+ *
+ * You may obtain a copy of the License at
+ * https://developer.oculus.com/licenses/oculussdk/
+ *
+ * Unless required by applicable law or agreed to in writing, the Oculus SDK
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <openxr/openxr.h>
+#include <meta_openxr_preview/meta_spatial_entity_room_mesh.h>
+
+// All scene entity meshes share this vertex format so they can be sub-allocated from one
+// vertex buffer.
+struct ovrSceneVertex {
+    XrVector3f Position;
+    uint8_t Color[4];
+};
+
+// Vertices and indices of one scene entity mesh, before they are placed in the shared buffers.
+// Indices are relative to the first vertex of the mesh.
+struct ovrSceneMeshData {
+    void Clear() {
+        Vertices.clear();
+        Indices.clear();
+    }
+
+    std::vector<ovrSceneVertex> Vertices;
+    std::vector<uint32_t> Indices;
+};
+
+// Range of a packed index buffer that belongs to one face.
+struct ovrSceneIndexRange {
+    uint32_t FirstIndex;
+    uint32_t IndexCount;
+};
+
+// A room mesh built off the render thread, with the index range of every face.
+struct ovrRoomMeshData {
+    ovrSceneMeshData Mesh;
+    std::vector<ovrSceneIndexRange> FaceRanges;
+    uint64_t SourceHash = 0;
+};
+
+// First-fit allocator for element ranges of a buffer. Freed ranges are merged with their
+// neighbours and reused before the buffer grows.
+class ovrSceneRangeAllocator {
+   public:
+    void Clear() {
+        FreeRanges_.clear();
+        Size_ = 0;
+    }
+
+    // Returns the first element of the new range.
+    uint32_t Allocate(const uint32_t count);
+    void Free(const uint32_t first, const uint32_t count);
+
+    // One past the last element of any allocated range.
+    uint32_t Size() const {
+        return Size_;
+    }
+
+   private:
+    struct Range {
+        uint32_t First;
+        uint32_t Count;
+    };
+
+    std::vector<Range> FreeRanges_; // sorted by First, never adjacent
+    uint32_t Size_ = 0;
+};
+
+// Scratch buffers for the two-call OpenXR queries of the scene entities. They only grow, so
+// updating a room does not allocate once the largest mesh has been seen.
+struct ovrSceneQueryScratch {
+    std::vector<XrVector2f> BoundaryVertices;
+    std::vector<XrVector3f> MeshVertices;
+    std::vector<uint32_t> MeshIndices;
+    std::vector<XrVector3f> RoomMeshVertices;
+    std::vector<XrRoomMeshFaceMETA> RoomMeshFaces;
+    std::vector<XrRoomMeshFaceIndicesMETA> RoomMeshFaceIndices;
+    std::vector<uint32_t> RoomMeshIndices; // the indices of all faces, back to back
+    std::vector<XrColor4f> RoomMeshFaceColors;
+};
+
+// FNV-1a hash, used to detect scene entities whose source data did not change.
+uint64_t HashSceneData(const void* data, const size_t size, const uint64_t seed);
+
+// Triangulates a simple polygon by ear clipping and appends the triangles to indices, offset by
+// baseIndex. Unlike a triangle fan this is correct for concave boundaries. The triangles keep
+// the winding of the polygon. Returns false if the polygon is degenerate.
+bool TriangulatePolygon(
+    const XrVector2f* points,
+    const uint32_t count,
+    const uint32_t baseIndex,
+    std::vector<uint32_t>& indices);
+
+void BuildPlaneMesh(
+    const XrVector2f* points,
+    const uint32_t count,
+    const XrColor4f& color,
+    ovrSceneMeshData& mesh);
+
+void BuildVolumeMesh(
+    const XrRect3DfFB& boundingBox3D,
+    const XrColor4f& color,
+    ovrSceneMeshData& mesh);
+
+// Decomposes the triangles into lines to draw the mesh as a wireframe model with GL_LINES.
+void BuildWireframeMesh(const XrSpaceTriangleMeshMETA& triangleMesh, ovrSceneMeshData& mesh);
+
+// Appends one range to faceRanges per face, in face order.
+void BuildRoomMesh(
+    const XrRoomMeshMETA& roomMesh,
+    const XrRoomMeshFaceIndicesMETA* faceIndices,
+    const XrColor4f* faceColors,
+    ovrSceneMeshData& mesh,
+    std::vector<ovrSceneIndexRange>& faceRanges);
@@ -43,7 +43,9 @@ Copyright	:	Copyright (c) Facebook Technologies, LLC and its affiliates. All rig
 #include <android/input.h>
 #endif
 
+#include <algorithm>
 #include <atomic>
+#include <cstring>
 #include <thread>
 
 #if defined(ANDROID)
@@ -356,219 +358,121 @@ void ovrGeometry::CreateStage() {
     IsRenderable_ = true;
 }
 
-void ovrGeometry::CreatePlane(const std::vector<XrVector3f>& vertices, const XrColor4f& color) {
-    if (vertices.size() < 3) {
-        IsRenderable_ = false;
-        return;
+void ovrGeometry::Destroy() {
+    if (IndexBuffer_ != 0) {
+        GL(glDeleteBuffers(1, &IndexBuffer_));
     }
-
-    struct PlaneVertex {
-        XrVector3f position;
-        XrColor4f color;
-    };
-
-    std::vector<PlaneVertex> planeVertices;
-    planeVertices.reserve(vertices.size());
-    for (const auto& vertex : vertices) {
-        planeVertices.emplace_back(PlaneVertex{vertex, color});
+    if (VertexBuffer_ != 0) {
+        GL(glDeleteBuffers(1, &VertexBuffer_));
     }
-    VertexAttribs_[0].Index = VERTEX_ATTRIBUTE_LOCATION_POSITION;
-    VertexAttribs_[0].Size = 3;
-    VertexAttribs_[0].Type = GL_FLOAT;
-    VertexAttribs_[0].Normalized = false;
-    VertexAttribs_[0].Stride = sizeof(PlaneVertex);
-    VertexAttribs_[0].Pointer = (const GLvoid*)offsetof(PlaneVertex, position);
-
-    VertexAttribs_[1].Index = VERTEX_ATTRIBUTE_LOCATION_COLOR;
-    VertexAttribs_[1].Size = 4;
-    VertexAttribs_[1].Type = GL_FLOAT;
-    VertexAttribs_[1].Normalized = false;
-    VertexAttribs_[1].Stride = sizeof(PlaneVertex);
-    VertexAttribs_[1].Pointer = (const GLvoid*)offsetof(PlaneVertex, color);
+    Clear();
+}
 
-    if (VertexBuffer_ == 0) {
-        GL(glGenBuffers(1, &VertexBuffer_));
+void ovrGeometry::CreateVAO() {
+    if (VertexArrayObject_ == 0) {
+        GL(glGenVertexArrays(1, &VertexArrayObject_));
     }
+    GL(glBindVertexArray(VertexArrayObject_));
+
     GL(glBindBuffer(GL_ARRAY_BUFFER, VertexBuffer_));
-    GL(glBufferData(
-        GL_ARRAY_BUFFER,
-        sizeof(PlaneVertex) * planeVertices.size(),
-        planeVertices.data(),
-        GL_STATIC_DRAW));
-    GL(glBindBuffer(GL_ARRAY_BUFFER, 0));
-    // Render only front side of the plane to make sure plane direction is correct.
-    std::vector<unsigned short> indices;
-    const int numTriangles = vertices.size() - 2;
-    indices.reserve(numTriangles * 3);
-    for (int i = 0; i < numTriangles; ++i) {
-        indices.push_back(0);
-        indices.push_back(i + 1);
-        indices.push_back(i + 2);
+
+    for (int i = 0; i < MAX_VERTEX_ATTRIB_POINTERS; i++) {
+        if (VertexAttribs_[i].Index != -1) {
+            GL(glEnableVertexAttribArray(VertexAttribs_[i].Index));
+            GL(glVertexAttribPointer(
+                VertexAttribs_[i].Index,
+                VertexAttribs_[i].Size,
+                VertexAttribs_[i].Type,
+                VertexAttribs_[i].Normalized,
+                VertexAttribs_[i].Stride,
+                VertexAttribs_[i].Pointer));
+        }
     }
-    CreateIndexBuffer(indices);
-    // VAO buffer needs to be created per each plane.
-    CreateVAO();
 
-    IsRenderable_ = true;
+    GL(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, IndexBuffer_));
+
+    GL(glBindVertexArray(0));
 }
 
-void ovrGeometry::CreateVolume(const std::array<XrVector3f, 8>& vertices, const XrColor4f& color) {
-    struct VolumeVertices {
-        XrVector3f positions[8];
-        XrColor4f colors[8];
-    };
+void ovrGeometry::DestroyVAO() {
+    GL(glDeleteVertexArrays(1, &VertexArrayObject_));
+}
 
-    const VolumeVertices volumeVertices = {
-        {vertices[0],
-         vertices[1],
-         vertices[2],
-         vertices[3],
-         vertices[4],
-         vertices[5],
-         vertices[6],
-         vertices[7]},
-        {color, color, color, color, color, color, color, color}};
-    VertexAttribs_[0].Index = VERTEX_ATTRIBUTE_LOCATION_POSITION;
-    VertexAttribs_[0].Size = 3;
-    VertexAttribs_[0].Type = GL_FLOAT;
-    VertexAttribs_[0].Normalized = false;
-    VertexAttribs_[0].Stride = sizeof(volumeVertices.positions[0]);
-    VertexAttribs_[0].Pointer = (const GLvoid*)offsetof(VolumeVertices, positions);
+/*
+================================================================================
 
-    VertexAttribs_[1].Index = VERTEX_ATTRIBUTE_LOCATION_COLOR;
-    VertexAttribs_[1].Size = 4;
-    VertexAttribs_[1].Type = GL_FLOAT;
-    VertexAttribs_[1].Normalized = false;
-    VertexAttribs_[1].Stride = sizeof(volumeVertices.colors[0]);
-    VertexAttribs_[1].Pointer = (const GLvoid*)offsetof(VolumeVertices, colors);
+ovrSceneGeometryBuffer
 
-    GL(glGenBuffers(1, &VertexBuffer_));
-    GL(glBindBuffer(GL_ARRAY_BUFFER, VertexBuffer_));
-    GL(glBufferData(GL_ARRAY_BUFFER, sizeof(VolumeVertices), &volumeVertices, GL_STATIC_DRAW));
-    GL(glBindBuffer(GL_ARRAY_BUFFER, 0));
-    const std::vector<unsigned short> indices = {
-        0, 2, 1, 2, 0, 3, // bottom
-        4, 6, 5, 6, 4, 7, // top
-        0, 1, 4, 1, 5, 4, // front
-        1, 2, 5, 2, 6, 5, // right
-        2, 3, 6, 3, 7, 6, // back
-        3, 0, 7, 0, 4, 7 // left
-    };
-    CreateIndexBuffer(indices);
-    CreateVAO();
+================================================================================
+*/
 
-    IsRenderable_ = true;
+static constexpr uint32_t kInitialSceneVertices = 16 * 1024;
+static constexpr uint32_t kInitialSceneIndices = 48 * 1024;
+
+void ovrSceneGeometryBuffer::Clear() {
+    Scratch.Clear();
+    VertexRanges_.Clear();
+    IndexRanges_.Clear();
+    Vertices_.clear();
+    Indices_.clear();
+    VertexBufferSize_ = 0;
+    IndexBufferSize_ = 0;
+    VertexBuffer_ = 0;
+    IndexBuffer_ = 0;
+    VertexArrayObject_ = 0;
 }
 
-void ovrGeometry::CreateMesh(const XrSpaceTriangleMeshMETA& mesh) {
-    VertexAttribs_[0].Index = VERTEX_ATTRIBUTE_LOCATION_POSITION;
-    VertexAttribs_[0].Size = 3;
-    VertexAttribs_[0].Type = GL_FLOAT;
-    VertexAttribs_[0].Normalized = false;
-    VertexAttribs_[0].Stride = sizeof(XrVector3f);
-    VertexAttribs_[0].Pointer = (const GLvoid*)0;
+void ovrSceneGeometryBuffer::Create() {
+    Vertices_.resize(kInitialSceneVertices);
+    Indices_.resize(kInitialSceneIndices);
+    VertexBufferSize_ = kInitialSceneVertices;
+    IndexBufferSize_ = kInitialSceneIndices;
 
     GL(glGenBuffers(1, &VertexBuffer_));
     GL(glBindBuffer(GL_ARRAY_BUFFER, VertexBuffer_));
+    // Initialize the buffers from the copies so they match for the diffs.
     GL(glBufferData(
         GL_ARRAY_BUFFER,
-        mesh.vertexCountOutput * sizeof(XrVector3f),
-        mesh.vertices,
-        GL_STATIC_DRAW));
-    GL(glBindBuffer(GL_ARRAY_BUFFER, 0));
-
-    // Decompose triangles into lines to draw the mesh as a wireframe model with GL_LINES.
-    std::vector<uint32_t> indices;
-    indices.reserve(mesh.indexCountOutput * 2);
-    for (uint32_t i = 0; i < mesh.indexCountOutput; i += 3) {
-        for (uint32_t j = 0; j < 3; ++j) {
-            indices.push_back(mesh.indices[i + j]);
-            indices.push_back(mesh.indices[i + (j + 1) % 3]);
-        }
-    }
+        VertexBufferSize_ * sizeof(ovrSceneVertex),
+        Vertices_.data(),
+        GL_DYNAMIC_DRAW));
 
     GL(glGenBuffers(1, &IndexBuffer_));
+    GL(glGenVertexArrays(1, &VertexArrayObject_));
+    GL(glBindVertexArray(VertexArrayObject_));
     GL(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, IndexBuffer_));
     GL(glBufferData(
         GL_ELEMENT_ARRAY_BUFFER,
-        indices.size() * sizeof(uint32_t),
-        indices.data(),
-        GL_STATIC_DRAW));
-    GL(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0));
-    IndexCount_ = indices.size();
-
-    CreateVAO();
-
-    IsRenderable_ = true;
-}
-
-void ovrGeometry::CreateRoomMesh(
-    const XrRoomMeshMETA& roomMesh,
-    const std::vector<XrRoomMeshFaceIndicesMETA>& roomMeshFaceIndicesList,
-    const std::vector<XrColor4f>& colorList) {
-    if (roomMesh.vertexCountOutput == 0 || roomMesh.faceCountOutput == 0 ||
-        roomMesh.faceCountOutput != roomMeshFaceIndicesList.size() ||
-        roomMesh.faceCountOutput != colorList.size()) {
-        IsRenderable_ = false;
-        return;
-    }
-
-    struct ColoredVertex {
-        XrVector3f position;
-        XrColor4f color;
-    };
-
-    std::vector<ColoredVertex> vertices;
-    std::vector<uint32_t> indices;
-    uint32_t index = 0;
-    for (uint32_t f = 0; f < roomMesh.faceCountOutput; ++f) {
-        for (uint32_t i = 0; i < roomMeshFaceIndicesList[f].indexCountOutput; ++i) {
-            vertices.emplace_back(
-                ColoredVertex{roomMesh.vertices[roomMeshFaceIndicesList[f].indices[i]], colorList[f]});
-            indices.emplace_back(index++);
-        }
-    }
-
-    VertexAttribs_[0].Index = VERTEX_ATTRIBUTE_LOCATION_POSITION;
-    VertexAttribs_[0].Size = 3;
-    VertexAttribs_[0].Type = GL_FLOAT;
-    VertexAttribs_[0].Normalized = false;
-    VertexAttribs_[0].Stride = sizeof(ColoredVertex);
-    VertexAttribs_[0].Pointer = (const GLvoid*)offsetof(ColoredVertex, position);
-
-    VertexAttribs_[1].Index = VERTEX_ATTRIBUTE_LOCATION_COLOR;
-    VertexAttribs_[1].Size = 4;
-    VertexAttribs_[1].Type = GL_FLOAT;
-    VertexAttribs_[1].Normalized = false;
-    VertexAttribs_[1].Stride = sizeof(ColoredVertex);
-    VertexAttribs_[1].Pointer = (const GLvoid*)offsetof(ColoredVertex, color);
+        IndexBufferSize_ * sizeof(uint32_t),
+        Indices_.data(),
+        GL_DYNAMIC_DRAW));
+
+    GL(glEnableVertexAttribArray(VERTEX_ATTRIBUTE_LOCATION_POSITION));
+    GL(glVertexAttribPointer(
+        VERTEX_ATTRIBUTE_LOCATION_POSITION,
+        3,
+        GL_FLOAT,
+        false,
+        sizeof(ovrSceneVertex),
+        (const GLvoid*)offsetof(ovrSceneVertex, Position)));
+    GL(glEnableVertexAttribArray(VERTEX_ATTRIBUTE_LOCATION_COLOR));
+    GL(glVertexAttribPointer(
+        VERTEX_ATTRIBUTE_LOCATION_COLOR,
+        4,
+        GL_UNSIGNED_BYTE,
+        true,
+        sizeof(ovrSceneVertex),
+        (const GLvoid*)offsetof(ovrSceneVertex, Color)));
 
-    if (VertexBuffer_ == 0) {
-        GL(glGenBuffers(1, &VertexBuffer_));
-    }
-    GL(glBindBuffer(GL_ARRAY_BUFFER, VertexBuffer_));
-    GL(glBufferData(
-        GL_ARRAY_BUFFER, sizeof(ColoredVertex) * vertices.size(), vertices.data(), GL_STATIC_DRAW));
+    GL(glBindVertexArray(0));
     GL(glBindBuffer(GL_ARRAY_BUFFER, 0));
-
-    if (IndexBuffer_ == 0) {
-        GL(glGenBuffers(1, &IndexBuffer_));
-    }
-    GL(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, IndexBuffer_));
-    GL(glBufferData(
-        GL_ELEMENT_ARRAY_BUFFER,
-        sizeof(uint32_t) * indices.size(),
-        indices.data(),
-        GL_STATIC_DRAW));
     GL(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0));
-    IndexCount_ = indices.size();
-
-    CreateVAO();
-
-    IsRenderable_ = true;
 }
 
-void ovrGeometry::Destroy() {
+void ovrSceneGeometryBuffer::Destroy() {
+    if (VertexArrayObject_ != 0) {
+        GL(glDeleteVertexArrays(1, &VertexArrayObject_));
+    }
     if (IndexBuffer_ != 0) {
         GL(glDeleteBuffers(1, &IndexBuffer_));
     }
@@ -578,34 +482,109 @@ void ovrGeometry::Destroy() {
     Clear();
 }
 
-void ovrGeometry::CreateVAO() {
-    if (VertexArrayObject_ == 0) {
-        GL(glGenVertexArrays(1, &VertexArrayObject_));
+// Uploads the elements [first, end) of the copy, or all of it if the GL buffer has to grow.
+// Growing keeps the buffer name, so the VAO does not need to be rebuilt.
+template <typename T>
+static void UploadRange(
+    const GLenum target,
+    const GLuint buffer,
+    const std::vector<T>& elements,
+    uint32_t& bufferSize,
+    const uint32_t first,
+    const uint32_t end) {
+    if (first >= end && bufferSize >= elements.size()) {
+        return;
     }
-    GL(glBindVertexArray(VertexArrayObject_));
+    GL(glBindBuffer(target, buffer));
+    if (bufferSize < elements.size()) {
+        bufferSize = static_cast<uint32_t>(elements.size());
+        GL(glBufferData(target, bufferSize * sizeof(T), elements.data(), GL_DYNAMIC_DRAW));
+    } else {
+        GL(glBufferSubData(target, first * sizeof(T), (end - first) * sizeof(T), &elements[first]));
+    }
+    GL(glBindBuffer(target, 0));
+}
 
-    GL(glBindBuffer(GL_ARRAY_BUFFER, VertexBuffer_));
+// Grows the copy to hold size elements, doubling to keep the reallocations rare.
+template <typename T>
+static void ReserveElements(std::vector<T>& elements, const uint32_t size) {
+    if (size > elements.size()) {
+        elements.resize(std::max<size_t>(size, elements.size() * 2));
+    }
+}
 
-    for (int i = 0; i < MAX_VERTEX_ATTRIB_POINTERS; i++) {
-        if (VertexAttribs_[i].Index != -1) {
-            GL(glEnableVertexAttribArray(VertexAttribs_[i].Index));
-            GL(glVertexAttribPointer(
-                VertexAttribs_[i].Index,
-                VertexAttribs_[i].Size,
-                VertexAttribs_[i].Type,
-                VertexAttribs_[i].Normalized,
-                VertexAttribs_[i].Stride,
-                VertexAttribs_[i].Pointer));
+void ovrSceneGeometryBuffer::Update(
+    ovrSceneGeometry& geometry,
+    const GLenum mode,
+    const ovrSceneMeshData& mesh) {
+    if (mesh.Vertices.empty() || mesh.Indices.empty()) {
+        Free(geometry);
+        return;
+    }
+    // Leave room to grow so a slightly larger mesh next time is updated in place.
+    const uint32_t vertexCount = static_cast<uint32_t>(mesh.Vertices.size());
+    const uint32_t indexCount = static_cast<uint32_t>(mesh.Indices.size());
+    if (vertexCount > geometry.VertexCapacity) {
+        VertexRanges_.Free(geometry.FirstVertex, geometry.VertexCapacity);
+        geometry.VertexCapacity = vertexCount + vertexCount / 4;
+        geometry.FirstVertex = VertexRanges_.Allocate(geometry.VertexCapacity);
+    }
+    if (indexCount > geometry.IndexCapacity) {
+        IndexRanges_.Free(geometry.FirstIndex, geometry.IndexCapacity);
+        geometry.IndexCapacity = indexCount + indexCount / 4;
+        geometry.FirstIndex = IndexRanges_.Allocate(geometry.IndexCapacity);
+    }
+    ReserveElements(Vertices_, VertexRanges_.Size());
+    ReserveElements(Indices_, IndexRanges_.Size());
+
+    // Diff against the previous contents of the range and upload only the span that changed.
+    uint32_t firstVertex = UINT32_MAX;
+    uint32_t endVertex = 0;
+    for (uint32_t i = 0; i < vertexCount; i++) {
+        ovrSceneVertex& dst = Vertices_[geometry.FirstVertex + i];
+        if (memcmp(&dst, &mesh.Vertices[i], sizeof(ovrSceneVertex)) != 0) {
+            dst = mesh.Vertices[i];
+            firstVertex = std::min(firstVertex, geometry.FirstVertex + i);
+            endVertex = geometry.FirstVertex + i + 1;
         }
     }
+    uint32_t firstIndex = UINT32_MAX;
+    uint32_t endIndex = 0;
+    for (uint32_t i = 0; i < indexCount; i++) {
+        const uint32_t index = geometry.FirstVertex + mesh.Indices[i];
+        uint32_t& dst = Indices_[geometry.FirstIndex + i];
+        if (dst != index) {
+            dst = index;
+            firstIndex = std::min(firstIndex, geometry.FirstIndex + i);
+            endIndex = geometry.FirstIndex + i + 1;
+        }
+    }
+    UploadRange(
+        GL_ARRAY_BUFFER, VertexBuffer_, Vertices_, VertexBufferSize_, firstVertex, endVertex);
+    UploadRange(
+        GL_ELEMENT_ARRAY_BUFFER, IndexBuffer_, Indices_, IndexBufferSize_, firstIndex, endIndex);
 
-    GL(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, IndexBuffer_));
+    geometry.Mode = mode;
+    geometry.VertexCount = vertexCount;
+    geometry.IndexCount = indexCount;
+}
 
-    GL(glBindVertexArray(0));
+void ovrSceneGeometryBuffer::Free(ovrSceneGeometry& geometry) {
+    VertexRanges_.Free(geometry.FirstVertex, geometry.VertexCapacity);
+    IndexRanges_.Free(geometry.FirstIndex, geometry.IndexCapacity);
+    geometry = ovrSceneGeometry();
 }
 
-void ovrGeometry::DestroyVAO() {
-    GL(glDeleteVertexArrays(1, &VertexArrayObject_));
+void ovrSceneGeometryBuffer::BindVAO() const {
+    GL(glBindVertexArray(VertexArrayObject_));
+}
+
+void ovrSceneGeometryBuffer::Draw(const ovrSceneGeometry& geometry) const {
+    GL(glDrawElements(
+        geometry.Mode,
+        geometry.IndexCount,
+        GL_UNSIGNED_INT,
+        (const GLvoid*)(uintptr_t)(geometry.FirstIndex * sizeof(uint32_t))));
 }
 
 /*
@@ -906,24 +885,48 @@ ovrPlane
 
 ovrPlane::ovrPlane(const XrSpace space) : Space(space) {}
 
-void ovrPlane::Update(const XrRect2Df& boundingBox2D, const XrColor4f& color) {
+// Returns true if the source data hashed into hash differs from what the geometry was built from.
+static bool SourceChanged(ovrSceneGeometry& geometry, const uint64_t hash) {
+    if (geometry.IsRenderable() && geometry.SourceHash == hash) {
+        return false;
+    }
+    geometry.SourceHash = hash;
+    return true;
+}
+
+void ovrPlane::Update(
+    ovrSceneGeometryBuffer& buffer,
+    const XrRect2Df& boundingBox2D,
+    const XrColor4f& color) {
+    const uint64_t hash = HashSceneData(
+        &boundingBox2D, sizeof(boundingBox2D), HashSceneData(&color, sizeof(color), 0));
+    if (!SourceChanged(Geometry, hash)) {
+        return;
+    }
     const auto& offset = boundingBox2D.offset;
     const auto& extent = boundingBox2D.extent;
-    const std::vector<XrVector3f> vertices = {
-        XrVector3f{offset.x, offset.y, 0.0f},
-        XrVector3f{offset.x + extent.width, offset.y, 0.0f},
-        XrVector3f{offset.x + extent.width, offset.y + extent.height, 0.0f},
-        XrVector3f{offset.x, offset.y + extent.height, 0.0f}};
-    Geometry.CreatePlane(vertices, color);
+    const XrVector2f vertices[4] = {
+        XrVector2f{offset.x, offset.y},
+        XrVector2f{offset.x + extent.width, offset.y},
+        XrVector2f{offset.x + extent.width, offset.y + extent.height},
+        XrVector2f{offset.x, offset.y + extent.height}};
+    BuildPlaneMesh(vertices, 4, color, buffer.Scratch);
+    buffer.Update(Geometry, GL_TRIANGLES, buffer.Scratch);
 }
 
-void ovrPlane::Update(const XrBoundary2DFB& boundary2D, const XrColor4f& color) {
-    std::vector<XrVector3f> vertices;
-    vertices.reserve(boundary2D.vertexCountOutput);
-    for (uint32_t i = 0; i < boundary2D.vertexCountOutput; ++i) {
-        vertices.push_back(XrVector3f{boundary2D.vertices[i].x, boundary2D.vertices[i].y, 0.0f});
+void ovrPlane::Update(
+    ovrSceneGeometryBuffer& buffer,
+    const XrBoundary2DFB& boundary2D,
+    const XrColor4f& color) {
+    const uint64_t hash = HashSceneData(
+        boundary2D.vertices,
+        boundary2D.vertexCountOutput * sizeof(XrVector2f),
+        HashSceneData(&color, sizeof(color), 1));
+    if (!SourceChanged(Geometry, hash)) {
+        return;
     }
-    Geometry.CreatePlane(vertices, color);
+    BuildPlaneMesh(boundary2D.vertices, boundary2D.vertexCountOutput, color, buffer.Scratch);
+    buffer.Update(Geometry, GL_TRIANGLES, buffer.Scratch);
 }
 
 void ovrPlane::SetZOffset(const float zOffset) {
@@ -950,19 +953,17 @@ ovrVolume
 
 ovrVolume::ovrVolume(const XrSpace space) : Space(space){};
 
-void ovrVolume::Update(const XrRect3DfFB& boundingBox3D, const XrColor4f& color) {
-    const auto& offset = boundingBox3D.offset;
-    const auto& extent = boundingBox3D.extent;
-    const std::array<XrVector3f, 8> vertices = {
-        XrVector3f{offset.x, offset.y, offset.z},
-        XrVector3f{offset.x + extent.width, offset.y, offset.z},
-        XrVector3f{offset.x + extent.width, offset.y + extent.height, offset.z},
-        XrVector3f{offset.x, offset.y + extent.height, offset.z},
-        XrVector3f{offset.x, offset.y, offset.z + extent.depth},
-        XrVector3f{offset.x + extent.width, offset.y, offset.z + extent.depth},
-        XrVector3f{offset.x + extent.width, offset.y + extent.height, offset.z + extent.depth},
-        XrVector3f{offset.x, offset.y + extent.height, offset.z + extent.depth}};
-    Geometry.CreateVolume(vertices, color);
+void ovrVolume::Update(
+    ovrSceneGeometryBuffer& buffer,
+    const XrRect3DfFB& boundingBox3D,
+    const XrColor4f& color) {
+    const uint64_t hash = HashSceneData(
+        &boundingBox3D, sizeof(boundingBox3D), HashSceneData(&color, sizeof(color), 0));
+    if (!SourceChanged(Geometry, hash)) {
+        return;
+    }
+    BuildVolumeMesh(boundingBox3D, color, buffer.Scratch);
+    buffer.Update(Geometry, GL_TRIANGLES, buffer.Scratch);
 }
 
 void ovrVolume::SetPose(const XrPosef& T_World_Volume_Xr) {
@@ -985,8 +986,16 @@ ovrMesh
 
 ovrMesh::ovrMesh(const XrSpace space) : Space(space) {}
 
-void ovrMesh::Update(const XrSpaceTriangleMeshMETA& mesh) {
-    Geometry.CreateMesh(mesh);
+void ovrMesh::Update(ovrSceneGeometryBuffer& buffer, const XrSpaceTriangleMeshMETA& mesh) {
+    const uint64_t hash = HashSceneData(
+        mesh.indices,
+        mesh.indexCountOutput * sizeof(uint32_t),
+        HashSceneData(mesh.vertices, mesh.vertexCountOutput * sizeof(XrVector3f), 0));
+    if (!SourceChanged(Geometry, hash)) {
+        return;
+    }
+    BuildWireframeMesh(mesh, buffer.Scratch);
+    buffer.Update(Geometry, GL_LINES, buffer.Scratch);
 }
 
 void ovrMesh::SetPose(const XrPosef& T_World_Mesh_Xr) {
@@ -1009,11 +1018,12 @@ ovrRoomMesh
 
 ovrRoomMesh::ovrRoomMesh(const XrSpace space) : Space(space) {}
 
-void ovrRoomMesh::Update(
-    const XrRoomMeshMETA& roomMesh,
-    const std::vector<XrRoomMeshFaceIndicesMETA>& roomMeshFaceIndicesList,
-    const std::vector<XrColor4f>& colorList) {
-    Geometry.CreateRoomMesh(roomMesh, roomMeshFaceIndicesList, colorList);
+void ovrRoomMesh::Update(ovrSceneGeometryBuffer& buffer, ovrRoomMeshData& data) {
+    if (!SourceChanged(Geometry, data.SourceHash)) {
+        return;
+    }
+    buffer.Update(Geometry, GL_TRIANGLES, data.Mesh);
+    FaceRanges.swap(data.FaceRanges);
 }
 
 void ovrRoomMesh::SetPose(const XrPosef& T_World_RoomMesh_Xr) {
@@ -1050,28 +1060,14 @@ void ovrScene::Clear() {
     AxesProgram.Clear();
     Axes.Clear();
     PlaneProgram.Clear();
-    for (auto& plane : Planes) {
-        plane.Geometry.Clear();
-    }
     Planes.clear();
-
     VolumeProgram.Clear();
-    for (auto& volume : Volumes) {
-        volume.Geometry.Clear();
-    }
     Volumes.clear();
-
     MeshProgram.Clear();
-    for (auto& mesh : Meshes) {
-        mesh.Geometry.Clear();
-    }
     Meshes.clear();
-
     RoomMeshProgram.Clear();
-    for (auto& roomMesh : RoomMeshes) {
-        roomMesh.Geometry.Clear();
-    }
     RoomMeshes.clear();
+    SceneGeometry.Clear();
 }
 
 bool ovrScene::IsCreated() {
@@ -1098,6 +1094,25 @@ void ovrScene::DestroyVAOs() {
     }
 }
 
+void ovrScene::ClearEntities() {
+    for (auto& plane : Planes) {
+        SceneGeometry.Free(plane.Geometry);
+    }
+    Planes.clear();
+    for (auto& volume : Volumes) {
+        SceneGeometry.Free(volume.Geometry);
+    }
+    Volumes.clear();
+    for (auto& mesh : Meshes) {
+        SceneGeometry.Free(mesh.Geometry);
+    }
+    Meshes.clear();
+    for (auto& roomMesh : RoomMeshes) {
+        SceneGeometry.Free(roomMesh.Geometry);
+    }
+    RoomMeshes.clear();
+}
+
 void ovrScene::Create() {
     // Setup the scene matrices.
     GL(glGenBuffers(1, &SceneMatrices));
@@ -1122,6 +1137,9 @@ void ovrScene::Create() {
     }
     Axes.CreateAxes();
 
+    // Planes, volumes, meshes and room meshes share one vertex and index buffer.
+    SceneGeometry.Create();
+
     // Planes
     if (!PlaneProgram.Create(VERTEX_SHADER, FRAGMENT_SHADER)) {
         ALOGE("Failed to compile plane program!");
@@ -1158,19 +1176,12 @@ void ovrScene::Destroy() {
     AxesProgram.Destroy();
     Axes.Destroy();
 
+    ClearEntities();
     PlaneProgram.Destroy();
-    for (auto& plane : Planes) {
-        plane.Geometry.DestroyVAO();
-        plane.Geometry.Destroy();
-    }
-    Planes.clear();
-
     VolumeProgram.Destroy();
-    for (auto& volume : Volumes) {
-        volume.Geometry.DestroyVAO();
-        volume.Geometry.Destroy();
-    }
-    Volumes.clear();
+    MeshProgram.Destroy();
+    RoomMeshProgram.Destroy();
+    SceneGeometry.Destroy();
 }
 
 /*
@@ -1402,6 +1413,7 @@ void ovrAppRenderer::RenderFrame(const FrameIn& frameIn) {
     GL(glEnable(GL_BLEND));
     GL(glEnable(GL_CULL_FACE));
     GL(glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA));
+    Scene.SceneGeometry.BindVAO();
     for (const auto& plane : Scene.Planes) {
         if (!plane.IsRenderable()) {
             continue;
@@ -1417,10 +1429,9 @@ void ovrAppRenderer::RenderFrame(const FrameIn& frameIn) {
                 GL_TRUE,
                 &transform.M[0][0]));
         }
-        plane.Geometry.BindVAO();
-        GL(glDrawElements(GL_TRIANGLES, plane.Geometry.IndexCount(), GL_UNSIGNED_SHORT, nullptr));
-        GL(glBindVertexArray(0));
+        Scene.SceneGeometry.Draw(plane.Geometry);
     }
+    GL(glBindVertexArray(0));
     GL(glDisable(GL_CULL_FACE));
     GL(glDisable(GL_BLEND));
     GL(glUseProgram(0));
@@ -1469,6 +1480,7 @@ void ovrAppRenderer::RenderFrame(const FrameIn& frameIn) {
     }
     GL(glEnable(GL_BLEND));
     GL(glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA));
+    Scene.SceneGeometry.BindVAO();
     for (const auto& volume : Scene.Volumes) {
         if (!volume.IsRenderable()) {
             continue;
@@ -1481,10 +1493,9 @@ void ovrAppRenderer::RenderFrame(const FrameIn& frameIn) {
                 GL_TRUE,
                 &transform.M[0][0]));
         }
-        volume.Geometry.BindVAO();
-        GL(glDrawElements(GL_TRIANGLES, volume.Geometry.IndexCount(), GL_UNSIGNED_SHORT, nullptr));
-        GL(glBindVertexArray(0));
+        Scene.SceneGeometry.Draw(volume.Geometry);
     }
+    GL(glBindVertexArray(0));
     GL(glDisable(GL_BLEND));
     GL(glUseProgram(0));
 
@@ -1529,6 +1540,7 @@ void ovrAppRenderer::RenderFrame(const FrameIn& frameIn) {
     }
     GL(glEnable(GL_BLEND));
     GL(glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA));
+    Scene.SceneGeometry.BindVAO();
     for (const auto& mesh : Scene.Meshes) {
         if (!mesh.IsRenderable()) {
             continue;
@@ -1541,10 +1553,9 @@ void ovrAppRenderer::RenderFrame(const FrameIn& frameIn) {
                 GL_TRUE,
                 &transform.M[0][0]));
         }
-        mesh.Geometry.BindVAO();
-        GL(glDrawElements(GL_LINES, mesh.Geometry.IndexCount(), GL_UNSIGNED_INT, nullptr));
-        GL(glBindVertexArray(0));
+        Scene.SceneGeometry.Draw(mesh.Geometry);
     }
+    GL(glBindVertexArray(0));
     GL(glDisable(GL_BLEND));
     GL(glUseProgram(0));
 
@@ -1560,6 +1571,7 @@ void ovrAppRenderer::RenderFrame(const FrameIn& frameIn) {
     GL(glEnable(GL_BLEND));
     GL(glEnable(GL_CULL_FACE));
     GL(glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA));
+    Scene.SceneGeometry.BindVAO();
     for (const auto& roomMesh : Scene.RoomMeshes) {
         if (!roomMesh.IsRenderable()) {
             continue;
@@ -1572,10 +1584,9 @@ void ovrAppRenderer::RenderFrame(const FrameIn& frameIn) {
                 GL_TRUE,
                 &transform.M[0][0]));
         }
-        roomMesh.Geometry.BindVAO();
-        GL(glDrawElements(GL_TRIANGLES, roomMesh.Geometry.IndexCount(), GL_UNSIGNED_INT, nullptr));
-        GL(glBindVertexArray(0));
+        Scene.SceneGeometry.Draw(roomMesh.Geometry);
     }
+    GL(glBindVertexArray(0));
     GL(glDisable(GL_CULL_FACE));
     GL(glDisable(GL_BLEND));
     GL(glUseProgram(0));
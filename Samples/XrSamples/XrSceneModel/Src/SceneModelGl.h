@@ -45,19 +45,14 @@
 
 #include "OVR_Math.h"
 
+#include "SceneModelGeometry.h"
+
 #define NUM_EYES 2
 
 struct ovrGeometry {
     void Clear();
     void CreateAxes();
     void CreateStage();
-    void CreatePlane(const std::vector<XrVector3f>& vertices, const XrColor4f& color);
-    void CreateVolume(const std::array<XrVector3f, 8>& vertices, const XrColor4f& color);
-    void CreateMesh(const XrSpaceTriangleMeshMETA& mesh);
-    void CreateRoomMesh(
-        const XrRoomMeshMETA& roomMesh,
-        const std::vector<XrRoomMeshFaceIndicesMETA>& roomMeshFaceIndicesList,
-        const std::vector<XrColor4f>& colorList);
     void Destroy();
     void CreateVAO();
     void DestroyVAO();
@@ -96,6 +91,54 @@ struct ovrGeometry {
     bool IsRenderable_ = false;
 };
 
+// A scene entity mesh placed in the shared scene buffers. GLES 3.0 has no base vertex draws, so
+// the indices in the buffer already include FirstVertex.
+struct ovrSceneGeometry {
+    bool IsRenderable() const {
+        return IndexCount > 0;
+    }
+
+    GLenum Mode = GL_TRIANGLES;
+    uint32_t FirstVertex = 0;
+    uint32_t VertexCount = 0;
+    uint32_t VertexCapacity = 0;
+    uint32_t FirstIndex = 0;
+    uint32_t IndexCount = 0;
+    uint32_t IndexCapacity = 0;
+    uint64_t SourceHash = 0; // hash of the query results the mesh was built from
+};
+
+// One persistent vertex buffer and index buffer that all scene entity meshes are sub-allocated
+// from, so refreshing the room does not create buffers or VAOs.
+struct ovrSceneGeometryBuffer {
+    void Clear();
+    void Create();
+    void Destroy();
+
+    // Places the mesh in the range of the geometry. The range only moves if the mesh outgrew
+    // it, and only the vertices and indices that differ from the previous mesh are uploaded.
+    void Update(ovrSceneGeometry& geometry, const GLenum mode, const ovrSceneMeshData& mesh);
+    void Free(ovrSceneGeometry& geometry);
+
+    void BindVAO() const;
+    void Draw(const ovrSceneGeometry& geometry) const;
+
+    // Reused by the scene entities to build their meshes.
+    ovrSceneMeshData Scratch;
+
+   private:
+    ovrSceneRangeAllocator VertexRanges_;
+    ovrSceneRangeAllocator IndexRanges_;
+    // Copies of the buffer contents that new meshes are diffed against.
+    std::vector<ovrSceneVertex> Vertices_;
+    std::vector<uint32_t> Indices_;
+    uint32_t VertexBufferSize_ = 0; // elements allocated in the GL buffers
+    uint32_t IndexBufferSize_ = 0;
+    GLuint VertexBuffer_ = 0;
+    GLuint IndexBuffer_ = 0;
+    GLuint VertexArrayObject_ = 0;
+};
+
 struct ovrProgram {
     static constexpr int MAX_PROGRAM_UNIFORMS = 8;
     static constexpr int MAX_PROGRAM_TEXTURES = 8;
@@ -140,9 +183,15 @@ struct ovrFramebuffer {
 struct ovrPlane {
     explicit ovrPlane(const XrSpace space);
 
-    void Update(const XrRect2Df& boundingBox2D, const XrColor4f& color);
+    void Update(
+        ovrSceneGeometryBuffer& buffer,
+        const XrRect2Df& boundingBox2D,
+        const XrColor4f& color);
 
-    void Update(const XrBoundary2DFB& boundary2D, const XrColor4f& color);
+    void Update(
+        ovrSceneGeometryBuffer& buffer,
+        const XrBoundary2DFB& boundary2D,
+        const XrColor4f& color);
 
     void SetPose(const XrPosef& T_World_Plane);
 
@@ -160,7 +209,7 @@ struct ovrPlane {
 
     XrSpace Space;
     OVR::Posef T_World_Plane;
-    ovrGeometry Geometry;
+    ovrSceneGeometry Geometry;
     float ZOffset = 0.0f; // Z offset in the plane frame
 
    private:
@@ -171,7 +220,10 @@ struct ovrPlane {
 struct ovrVolume {
     explicit ovrVolume(const XrSpace space);
 
-    void Update(const XrRect3DfFB& boundingBox3D, const XrColor4f& color);
+    void Update(
+        ovrSceneGeometryBuffer& buffer,
+        const XrRect3DfFB& boundingBox3D,
+        const XrColor4f& color);
 
     void SetPose(const XrPosef& T_World_Volume);
 
@@ -187,7 +239,7 @@ struct ovrVolume {
 
     XrSpace Space;
     OVR::Posef T_World_Volume;
-    ovrGeometry Geometry;
+    ovrSceneGeometry Geometry;
 
    private:
     bool IsVisible_ = true;
@@ -197,7 +249,7 @@ struct ovrVolume {
 struct ovrMesh {
     explicit ovrMesh(const XrSpace space);
 
-    void Update(const XrSpaceTriangleMeshMETA& mesh);
+    void Update(ovrSceneGeometryBuffer& buffer, const XrSpaceTriangleMeshMETA& mesh);
 
     void SetPose(const XrPosef& T_World_Mesh);
 
@@ -213,7 +265,7 @@ struct ovrMesh {
 
     XrSpace Space;
     OVR::Posef T_World_Mesh;
-    ovrGeometry Geometry;
+    ovrSceneGeometry Geometry;
 
    private:
     bool IsVisible_ = true;
@@ -223,10 +275,9 @@ struct ovrMesh {
 struct ovrRoomMesh {
     explicit ovrRoomMesh(const XrSpace space);
 
-    void Update(
-        const XrRoomMeshMETA& roomMesh,
-        const std::vector<XrRoomMeshFaceIndicesMETA>& roomMeshFaceIndicesList,
-        const std::vector<XrColor4f>& colorList);
+    // Uploads a room mesh built by the room mesh thread. Takes over its face ranges and hands
+    // back the previous ones, so the buffers are reused.
+    void Update(ovrSceneGeometryBuffer& buffer, ovrRoomMeshData& data);
 
     void SetPose(const XrPosef& T_World_RoomMesh);
 
@@ -242,7 +293,8 @@ struct ovrRoomMesh {
 
     XrSpace Space;
     OVR::Posef T_World_RoomMesh;
-    ovrGeometry Geometry;
+    ovrSceneGeometry Geometry;
+    std::vector<ovrSceneIndexRange> FaceRanges; // index ranges of the faces in Geometry
 
    private:
     bool IsVisible_ = true;
@@ -258,6 +310,8 @@ struct ovrScene {
     void SetClearColor(const float* c);
     void CreateVAOs();
     void DestroyVAOs();
+    // Frees the geometry of all planes, volumes, meshes and room meshes and removes them.
+    void ClearEntities();
 
     void DestroyPlaneGeometries();
     void ClearPlaneGeometries();
@@ -289,6 +343,7 @@ struct ovrScene {
     ovrProgram VolumeProgram;
     ovrProgram MeshProgram;
     ovrProgram RoomMeshProgram;
+    ovrSceneGeometryBuffer SceneGeometry;
     float ClearColor[4];
 
     std::vector<ovrPlane> Planes;
@@ -29,6 +29,7 @@ Authors   :
 #include <stdlib.h>
 #include <stdbool.h>
 #include <string.h> // for memset
+#include <algorithm>
 #include <map>
 #include <math.h>
 #include <string>
@@ -42,10 +43,13 @@ Authors   :
 #include <android/log.h>
 #include <android/native_window_jni.h> // for native window JNI
 #include <android_native_app_glue.h>
-#else
-#include <thread>
 #endif
 
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
 #include <assert.h>
 
 #include "SceneModelHelpers.h"
@@ -226,6 +230,24 @@ XrColor4f GetColorForSemanticLabels(const std::string& labels) {
     return SemanticLabelToColorMap.at(firstLabel);
 }
 
+// Room mesh faces carry enum labels, so their colors are looked up by label instead of going
+// through the label strings for every face.
+XrColor4f GetColorForSemanticLabel(const XrSemanticLabelMETA label) {
+    static constexpr int kNumLabels = XR_SEMANTIC_LABEL_WINDOW_FRAME_META + 1;
+    struct ColorTable {
+        ColorTable() {
+            for (int i = 0; i < kNumLabels; i++) {
+                Colors[i] = GetColorForSemanticLabels(
+                    stringFromSemanticLabel(static_cast<XrSemanticLabelMETA>(i)));
+            }
+        }
+        XrColor4f Colors[kNumLabels];
+    };
+    static const ColorTable kTable;
+    const int index = static_cast<int>(label);
+    return kTable.Colors[(index >= 0 && index < kNumLabels) ? index : 0];
+}
+
 std::string BoundaryVisibilityToString(const XrBoundaryVisibilityMETA boundaryVisibility) {
     switch (boundaryVisibility) {
         case XR_BOUNDARY_VISIBILITY_NOT_SUPPRESSED_META:
@@ -544,6 +566,47 @@ struct ovrExtensionFunctionPointers {
     PFN_xrGetStationaryReferenceSpaceIdEXTX2 xrGetStationaryReferenceSpaceIdEXTX2 = nullptr;
 };
 
+// Queries and builds room meshes on a background thread, since large rooms have hundreds of
+// faces. The frame loop picks up the finished meshes with TakeResults() and uploads them.
+class ovrRoomMeshProcessor {
+   public:
+    struct Result {
+        XrSpace Space;
+        bool Succeeded;
+        ovrRoomMeshData Data;
+    };
+
+    ~ovrRoomMeshProcessor() {
+        Stop();
+    }
+
+    // Queues the room mesh of the space, unless it is already queued.
+    void Request(const ovrExtensionFunctionPointers& funPtrs, const XrSpace space);
+    // Swaps the finished results into results. Hand them back with Recycle() after use so
+    // their buffers are reused.
+    void TakeResults(std::vector<Result>& results);
+    void Recycle(std::vector<Result>& results);
+    // Waits for the room mesh in progress and stops the thread. Pending requests are dropped.
+    void Stop();
+
+   private:
+    void ThreadFunction();
+    bool Process(const XrSpace space, ovrRoomMeshData& data);
+
+    PFN_xrGetSpaceRoomMeshMETA GetSpaceRoomMesh_ = nullptr;
+    PFN_xrGetSpaceRoomMeshFaceIndicesMETA GetSpaceRoomMeshFaceIndices_ = nullptr;
+
+    std::thread Thread_;
+    std::mutex Mutex_; // guards the members below
+    std::condition_variable WorkAvailable_;
+    std::deque<XrSpace> Pending_;
+    std::vector<Result> Done_;
+    std::vector<Result> Free_;
+    bool Exit_ = false;
+
+    ovrSceneQueryScratch Scratch_; // only used by the thread
+};
+
 struct ovrApp {
     void Clear();
     void HandleSessionStateChanges(XrSessionState state);
@@ -619,6 +682,9 @@ struct ovrApp {
     OVR::Vector3f StageBounds;
     // Provided by SceneModelGl, which is not aware of VrApi or OpenXR
     ovrAppRenderer AppRenderer;
+    ovrSceneQueryScratch QueryScratch;
+    ovrRoomMeshProcessor RoomMeshProcessor;
+    std::vector<ovrRoomMeshProcessor::Result> RoomMeshResults;
 
     std::unordered_set<std::string> UuidSet;
 
@@ -877,29 +943,31 @@ bool UpdateOvrPlane(ovrApp& app, ovrPlane& plane) {
             ALOGE("Failed getting bounding box 2D!");
             return false;
         }
-        plane.Update(boundingBox2D, color);
+        plane.Update(app.AppRenderer.Scene.SceneGeometry, boundingBox2D, color);
         return true;
     } else if (app.CurrentPlaneVisualizationMode == ovrApp::PlaneVisualizationMode::Boundary) {
         XrResult res;
         XrBoundary2DFB boundary2D = {XR_TYPE_BOUNDARY_2D_FB, nullptr, 0};
+        auto& vertices = app.QueryScratch.BoundaryVertices;
 
         assert(app.FunPtrs.xrGetSpaceBoundary2DFB != nullptr);
-        // First call
-        OXR(res = app.FunPtrs.xrGetSpaceBoundary2DFB(app.Session, plane.Space, &boundary2D));
-        if (XR_FAILED(res)) {
-            ALOGE("Failed getting boundary 2D!");
-            return false;
-        }
-        // Second call
-        std::vector<XrVector2f> vertices(boundary2D.vertexCountOutput);
+        // Try the cached buffer first, and only fall back to the two-call idiom if the boundary
+        // has more vertices than any boundary before it.
         boundary2D.vertexCapacityInput = vertices.size();
         boundary2D.vertices = vertices.data();
-        OXR(res = app.FunPtrs.xrGetSpaceBoundary2DFB(app.Session, plane.Space, &boundary2D));
+        res = app.FunPtrs.xrGetSpaceBoundary2DFB(app.Session, plane.Space, &boundary2D);
+        if (res == XR_ERROR_SIZE_INSUFFICIENT ||
+            (XR_SUCCEEDED(res) && boundary2D.vertexCountOutput > boundary2D.vertexCapacityInput)) {
+            vertices.resize(boundary2D.vertexCountOutput);
+            boundary2D.vertexCapacityInput = vertices.size();
+            boundary2D.vertices = vertices.data();
+            OXR(res = app.FunPtrs.xrGetSpaceBoundary2DFB(app.Session, plane.Space, &boundary2D));
+        }
         if (XR_FAILED(res)) {
             ALOGE("Failed getting boundary 2D!");
             return false;
         }
-        plane.Update(boundary2D, color);
+        plane.Update(app.AppRenderer.Scene.SceneGeometry, boundary2D, color);
         return true;
     }
     return false;
@@ -916,7 +984,8 @@ bool UpdateOvrVolume(ovrApp& app, ovrVolume& volume) {
     }
     const auto labels = GetSemanticLabels(app, volume.Space);
 
-    volume.Update(boundingBox3D, GetColorForSemanticLabels(labels));
+    volume.Update(
+        app.AppRenderer.Scene.SceneGeometry, boundingBox3D, GetColorForSemanticLabels(labels));
     return true;
 }
 
@@ -924,33 +993,107 @@ bool UpdateOvrMesh(ovrApp& app, ovrMesh& mesh) {
     XrResult res;
     const XrSpaceTriangleMeshGetInfoMETA getInfo = {XR_TYPE_SPACE_TRIANGLE_MESH_GET_INFO_META};
     XrSpaceTriangleMeshMETA triangleMesh = {XR_TYPE_SPACE_TRIANGLE_MESH_META};
+    auto& vertices = app.QueryScratch.MeshVertices;
+    auto& indices = app.QueryScratch.MeshIndices;
     assert(app.FunPtrs.xrGetSpaceTriangleMeshMETA != nullptr);
-    // First call
-    OXR(res = app.FunPtrs.xrGetSpaceTriangleMeshMETA(mesh.Space, &getInfo, &triangleMesh));
-    if (XR_FAILED(res)) {
-        ALOGE("Failed getting triangle mesh!");
-        return false;
-    }
-    // Second call
-    std::vector<XrVector3f> vertices(triangleMesh.vertexCountOutput);
-    std::vector<uint32_t> indices(triangleMesh.indexCountOutput);
+    // Try the cached buffers first, and only fall back to the two-call idiom if they are too
+    // small for this mesh.
     triangleMesh.vertexCapacityInput = vertices.size();
     triangleMesh.vertices = vertices.data();
     triangleMesh.indexCapacityInput = indices.size();
     triangleMesh.indices = indices.data();
-    OXR(res = app.FunPtrs.xrGetSpaceTriangleMeshMETA(mesh.Space, &getInfo, &triangleMesh));
+    res = app.FunPtrs.xrGetSpaceTriangleMeshMETA(mesh.Space, &getInfo, &triangleMesh);
+    if (res == XR_ERROR_SIZE_INSUFFICIENT ||
+        (XR_SUCCEEDED(res) &&
+         (triangleMesh.vertexCountOutput > triangleMesh.vertexCapacityInput ||
+          triangleMesh.indexCountOutput > triangleMesh.indexCapacityInput))) {
+        vertices.resize(std::max<size_t>(vertices.size(), triangleMesh.vertexCountOutput));
+        indices.resize(std::max<size_t>(indices.size(), triangleMesh.indexCountOutput));
+        triangleMesh.vertexCapacityInput = vertices.size();
+        triangleMesh.vertices = vertices.data();
+        triangleMesh.indexCapacityInput = indices.size();
+        triangleMesh.indices = indices.data();
+        OXR(res = app.FunPtrs.xrGetSpaceTriangleMeshMETA(mesh.Space, &getInfo, &triangleMesh));
+    }
     if (XR_FAILED(res)) {
         ALOGE("Failed getting triangle mesh!");
         return false;
     }
-    mesh.Update(triangleMesh);
+    mesh.Update(app.AppRenderer.Scene.SceneGeometry, triangleMesh);
     return true;
 }
 
-bool UpdateOvrRoomMesh(ovrApp& app, ovrRoomMesh& room) {
-    assert(app.FunPtrs.xrGetSpaceRoomMeshMETA != nullptr);
-    assert(app.FunPtrs.xrGetSpaceRoomMeshFaceIndicesMETA != nullptr);
+void ovrRoomMeshProcessor::Request(
+    const ovrExtensionFunctionPointers& funPtrs,
+    const XrSpace space) {
+    std::lock_guard<std::mutex> lock(Mutex_);
+    if (!Thread_.joinable()) {
+        assert(funPtrs.xrGetSpaceRoomMeshMETA != nullptr);
+        assert(funPtrs.xrGetSpaceRoomMeshFaceIndicesMETA != nullptr);
+        GetSpaceRoomMesh_ = funPtrs.xrGetSpaceRoomMeshMETA;
+        GetSpaceRoomMeshFaceIndices_ = funPtrs.xrGetSpaceRoomMeshFaceIndicesMETA;
+        Exit_ = false;
+        Thread_ = std::thread(&ovrRoomMeshProcessor::ThreadFunction, this);
+    }
+    if (std::find(Pending_.begin(), Pending_.end(), space) == Pending_.end()) {
+        Pending_.push_back(space);
+        WorkAvailable_.notify_one();
+    }
+}
+
+void ovrRoomMeshProcessor::TakeResults(std::vector<Result>& results) {
+    std::lock_guard<std::mutex> lock(Mutex_);
+    results.swap(Done_);
+}
+
+void ovrRoomMeshProcessor::Recycle(std::vector<Result>& results) {
+    std::lock_guard<std::mutex> lock(Mutex_);
+    for (auto& result : results) {
+        Free_.push_back(std::move(result));
+    }
+    results.clear();
+}
+
+void ovrRoomMeshProcessor::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(Mutex_);
+        Exit_ = true;
+        Pending_.clear();
+        WorkAvailable_.notify_one();
+    }
+    if (Thread_.joinable()) {
+        Thread_.join();
+    }
+}
+
+void ovrRoomMeshProcessor::ThreadFunction() {
+#if defined(ANDROID)
+    prctl(PR_SET_NAME, (long)"RoomMeshes", 0, 0, 0);
+#endif
+    for (;;) {
+        Result result;
+        {
+            std::unique_lock<std::mutex> lock(Mutex_);
+            WorkAvailable_.wait(lock, [this] { return Exit_ || !Pending_.empty(); });
+            if (Exit_) {
+                return;
+            }
+            result.Space = Pending_.front();
+            Pending_.pop_front();
+            if (!Free_.empty()) {
+                result.Data = std::move(Free_.back().Data);
+                Free_.pop_back();
+            }
+        }
+
+        result.Succeeded = Process(result.Space, result.Data);
+
+        std::lock_guard<std::mutex> lock(Mutex_);
+        Done_.push_back(std::move(result));
+    }
+}
 
+bool ovrRoomMeshProcessor::Process(const XrSpace space, ovrRoomMeshData& data) {
     static const std::vector<XrSemanticLabelMETA> kRecognizedSemanticLabels = {
         XR_SEMANTIC_LABEL_FLOOR_META,
         XR_SEMANTIC_LABEL_CEILING_META,
@@ -968,60 +1111,127 @@ bool UpdateOvrRoomMesh(ovrApp& app, ovrRoomMesh& room) {
 
     XrResult res;
     XrRoomMeshMETA roomMesh = {XR_TYPE_ROOM_MESH_META};
-    // First call
-    OXR(res = app.FunPtrs.xrGetSpaceRoomMeshMETA(room.Space, &getInfo, &roomMesh));
-    if (XR_FAILED(res)) {
-        ALOGE("Failed getting room mesh!");
-        return false;
+    auto& scratch = Scratch_;
+    // Try the cached buffers first, and only fall back to the two-call idiom if they are too
+    // small for this room.
+    roomMesh.vertexCapacityInput = scratch.RoomMeshVertices.size();
+    roomMesh.vertices = scratch.RoomMeshVertices.data();
+    roomMesh.faceCapacityInput = scratch.RoomMeshFaces.size();
+    roomMesh.faces = scratch.RoomMeshFaces.data();
+    res = GetSpaceRoomMesh_(space, &getInfo, &roomMesh);
+    if (res == XR_ERROR_SIZE_INSUFFICIENT ||
+        (XR_SUCCEEDED(res) &&
+         (roomMesh.vertexCountOutput > roomMesh.vertexCapacityInput ||
+          roomMesh.faceCountOutput > roomMesh.faceCapacityInput))) {
+        scratch.RoomMeshVertices.resize(
+            std::max<size_t>(scratch.RoomMeshVertices.size(), roomMesh.vertexCountOutput));
+        scratch.RoomMeshFaces.resize(
+            std::max<size_t>(scratch.RoomMeshFaces.size(), roomMesh.faceCountOutput));
+        roomMesh.vertexCapacityInput = scratch.RoomMeshVertices.size();
+        roomMesh.vertices = scratch.RoomMeshVertices.data();
+        roomMesh.faceCapacityInput = scratch.RoomMeshFaces.size();
+        roomMesh.faces = scratch.RoomMeshFaces.data();
+        OXR(res = GetSpaceRoomMesh_(space, &getInfo, &roomMesh));
     }
-    // Second call
-    std::vector<XrVector3f> vertices(roomMesh.vertexCountOutput);
-    std::vector<XrRoomMeshFaceMETA> roomMeshFaces(
-        roomMesh.faceCountOutput, XrRoomMeshFaceMETA{});
-    roomMesh.vertexCapacityInput = vertices.size();
-    roomMesh.vertices = vertices.data();
-    roomMesh.faceCapacityInput = roomMeshFaces.size();
-    roomMesh.faces = roomMeshFaces.data();
-    OXR(res = app.FunPtrs.xrGetSpaceRoomMeshMETA(room.Space, &getInfo, &roomMesh));
     if (XR_FAILED(res)) {
         ALOGE("Failed getting room mesh!");
         return false;
     }
-
-    // Get all face indices
-    std::vector<XrRoomMeshFaceIndicesMETA> roomMeshFaceIndicesList(
-        roomMesh.faceCountOutput, XrRoomMeshFaceIndicesMETA{XR_TYPE_ROOM_MESH_FACE_INDICES_META});
-    std::vector<std::vector<uint32_t>> indicesList(
-        roomMesh.faceCountOutput, std::vector<uint32_t>{});
-    for (uint32_t f = 0; f < roomMesh.faceCountOutput; ++f) {
-        // First call
-        OXR(res = app.FunPtrs.xrGetSpaceRoomMeshFaceIndicesMETA(
-            room.Space, &roomMeshFaces[f].uuid, &roomMeshFaceIndicesList[f]));
-        if (XR_FAILED(res)) {
-            ALOGE("Failed getting room face indices!");
-            return false;
+    const uint32_t faceCount = roomMesh.faceCountOutput;
+
+    // Query every face straight into the free part of one packed index buffer, so a face takes a
+    // single call unless the buffer has to grow. The faces end up back to back, and their
+    // pointers are fixed up once all faces are in, because growing moves the buffer.
+    auto& faceIndices = scratch.RoomMeshFaceIndices;
+    auto& indices = scratch.RoomMeshIndices;
+    faceIndices.assign(faceCount, XrRoomMeshFaceIndicesMETA{XR_TYPE_ROOM_MESH_FACE_INDICES_META});
+    size_t usedIndexCount = 0;
+    for (uint32_t f = 0; f < faceCount; ++f) {
+        XrRoomMeshFaceIndicesMETA& face = faceIndices[f];
+        face.indexCapacityInput = indices.size() - usedIndexCount;
+        face.indices = indices.data() + usedIndexCount;
+        res = GetSpaceRoomMeshFaceIndices_(space, &scratch.RoomMeshFaces[f].uuid, &face);
+        if (res == XR_ERROR_SIZE_INSUFFICIENT ||
+            (XR_SUCCEEDED(res) && face.indexCountOutput > face.indexCapacityInput)) {
+            indices.resize(std::max(indices.size() * 2, usedIndexCount + face.indexCountOutput));
+            face.indexCapacityInput = indices.size() - usedIndexCount;
+            face.indices = indices.data() + usedIndexCount;
+            OXR(res = GetSpaceRoomMeshFaceIndices_(space, &scratch.RoomMeshFaces[f].uuid, &face));
         }
-        // Second call
-        indicesList[f].resize(roomMeshFaceIndicesList[f].indexCountOutput);
-        roomMeshFaceIndicesList[f].indexCapacityInput = indicesList[f].size();
-        roomMeshFaceIndicesList[f].indices = indicesList[f].data();
-        OXR(res = app.FunPtrs.xrGetSpaceRoomMeshFaceIndicesMETA(
-            room.Space, &roomMeshFaces[f].uuid, &roomMeshFaceIndicesList[f]));
         if (XR_FAILED(res)) {
             ALOGE("Failed getting room face indices!");
             return false;
         }
-    }
+        usedIndexCount += face.indexCountOutput;
+    }
+
+    scratch.RoomMeshFaceColors.resize(faceCount);
+    uint64_t hash = HashSceneData(
+        roomMesh.vertices, roomMesh.vertexCountOutput * sizeof(XrVector3f), 0);
+    uint32_t* faceStart = indices.data();
+    for (uint32_t f = 0; f < faceCount; ++f) {
+        XrRoomMeshFaceIndicesMETA& face = faceIndices[f];
+        face.indices = faceStart;
+        face.indexCapacityInput = face.indexCountOutput;
+        faceStart += face.indexCountOutput;
+        scratch.RoomMeshFaceColors[f] =
+            GetColorForSemanticLabel(scratch.RoomMeshFaces[f].semanticLabel);
+        hash = HashSceneData(face.indices, face.indexCountOutput * sizeof(uint32_t), hash);
+        hash = HashSceneData(&scratch.RoomMeshFaceColors[f], sizeof(XrColor4f), hash);
+    }
+
+    BuildRoomMesh(
+        roomMesh,
+        faceIndices.data(),
+        scratch.RoomMeshFaceColors.data(),
+        data.Mesh,
+        data.FaceRanges);
+    data.SourceHash = hash;
+    return true;
+}
+
+// Adds the room mesh without geometry and queues it for the room mesh thread. The geometry is
+// uploaded by ApplyRoomMeshResults() once the thread has built it.
+void RequestRoomMesh(ovrApp& app, const XrSpace space) {
+    auto& roomMeshes = app.AppRenderer.Scene.RoomMeshes;
+    const bool isKnown = std::any_of(
+        roomMeshes.begin(), roomMeshes.end(), [space](const ovrRoomMesh& roomMesh) {
+            return roomMesh.Space == space;
+        });
+    if (!isKnown) {
+        roomMeshes.emplace_back(space);
+    }
+    app.RoomMeshProcessor.Request(app.FunPtrs, space);
+}
 
-    // Get face colors
-    std::vector<XrColor4f> colorList(roomMesh.faceCountOutput);
-    for (uint32_t f = 0; f < roomMesh.faceCountOutput; ++f) {
-        colorList[f] = GetColorForSemanticLabels(
-            stringFromSemanticLabel(roomMeshFaces[f].semanticLabel));
+void ApplyRoomMeshResults(ovrApp& app) {
+    auto& results = app.RoomMeshResults;
+    app.RoomMeshProcessor.TakeResults(results);
+    if (results.empty()) {
+        return;
     }
 
-    room.Update(roomMesh, roomMeshFaceIndicesList, colorList);
-    return true;
+    auto& scene = app.AppRenderer.Scene;
+    auto& roomMeshes = scene.RoomMeshes;
+    for (auto& result : results) {
+        auto roomMesh = std::find_if(
+            roomMeshes.begin(), roomMeshes.end(), [&result](const ovrRoomMesh& roomMesh) {
+                return roomMesh.Space == result.Space;
+            });
+        if (roomMesh == roomMeshes.end()) {
+            // The scene was cleared while the room mesh was being built.
+            continue;
+        }
+        if (!result.Succeeded) {
+            // Keep showing the previous mesh if there is one.
+            if (!roomMesh->Geometry.IsRenderable()) {
+                roomMeshes.erase(roomMesh);
+            }
+            continue;
+        }
+        roomMesh->Update(scene.SceneGeometry, result.Data);
+    }
+    app.RoomMeshProcessor.Recycle(results);
 }
 
 void ovrApp::HandleXrEvents() {
@@ -1136,10 +1346,7 @@ void ovrApp::HandleXrEvents() {
                         }
                         if (IsComponentEnabled(
                                 setStatusComplete->space, XR_SPACE_COMPONENT_TYPE_ROOM_MESH_META)) {
-                            ovrRoomMesh roomMesh(setStatusComplete->space);
-                            if (UpdateOvrRoomMesh(*this, roomMesh)) {
-                                AppRenderer.Scene.RoomMeshes.emplace_back(roomMesh);
-                            }
+                            RequestRoomMesh(*this, setStatusComplete->space);
                         }
                     }
                 }
@@ -1213,10 +1420,7 @@ void ovrApp::HandleXrEvents() {
                             }
                             if (IsComponentEnabled(
                                     result.space, XR_SPACE_COMPONENT_TYPE_ROOM_MESH_META)) {
-                                ovrRoomMesh roomMesh(result.space);
-                                if (UpdateOvrRoomMesh(*this, roomMesh)) {
-                                    AppRenderer.Scene.RoomMeshes.emplace_back(roomMesh);
-                                }
+                                RequestRoomMesh(*this, result.space);
                             }
                         }
                     }
@@ -2247,29 +2451,7 @@ int main() {
 
         if (app.ClearScene) {
             // This is called after the app starts, or after Button X is pressed.
-            for (auto& plane : app.AppRenderer.Scene.Planes) {
-                plane.Geometry.DestroyVAO();
-                plane.Geometry.Destroy();
-            }
-            app.AppRenderer.Scene.Planes.clear();
-
-            for (auto& volume : app.AppRenderer.Scene.Volumes) {
-                volume.Geometry.DestroyVAO();
-                volume.Geometry.Destroy();
-            }
-            app.AppRenderer.Scene.Volumes.clear();
-
-            for (auto& mesh : app.AppRenderer.Scene.Meshes) {
-                mesh.Geometry.DestroyVAO();
-                mesh.Geometry.Destroy();
-            }
-            app.AppRenderer.Scene.Meshes.clear();
-
-            for (auto& roomMesh : app.AppRenderer.Scene.RoomMeshes) {
-                roomMesh.Geometry.DestroyVAO();
-                roomMesh.Geometry.Destroy();
-            }
-            app.AppRenderer.Scene.RoomMeshes.clear();
+            app.AppRenderer.Scene.ClearEntities();
 
             app.ClearScene = false;
 
@@ -2346,6 +2528,7 @@ int main() {
 
         UpdateSceneMeshes(app, frameState);
 
+        ApplyRoomMeshResults(app);
         UpdateSceneRoomMeshes(app, frameState);
 
         assert(input != nullptr);
@@ -2567,6 +2750,7 @@ int main() {
 
     delete input;
 
+    app.RoomMeshProcessor.Stop();
     app.AppRenderer.Destroy();
 
     DestroyPassthrough(app);
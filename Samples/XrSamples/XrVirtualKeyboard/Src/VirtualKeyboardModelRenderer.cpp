@@ -337,27 +337,7 @@ void VirtualKeyboardModelRenderer::SetAnimationState(int animationIndex, float f
 
 void VirtualKeyboardModelRenderer::UpdateSurfaceGeo() {
     for (auto nodeIndex : dirtyGeoNodeIndices_) {
-        OVRFW::ModelNodeState& nodeState = keyboardModelState_->nodeStates[nodeIndex];
-        std::vector<OVRFW::ModelSurface>& surfaces = nodeState.node->model->surfaces;
-        for (auto& surface : surfaces) {
-            OVRFW::VertexAttribs attribs = surface.attribs; // copy base values
-            for (int w = 0; w < static_cast<int>(nodeState.weights.size()); ++w) {
-                const auto& targetAttribs = surface.targets[w];
-                if (!targetAttribs.position.empty()) {
-                    float* original = (float*)attribs.position.data();
-                    float* target = (float*)targetAttribs.position.data();
-                    int posIndex = (w % 2) + (w / 2 * 3); // skip z
-                    original[posIndex] += target[posIndex] * nodeState.weights[w];
-                }
-                if (!targetAttribs.uv0.empty()) {
-                    float* original = (float*)attribs.uv0.data();
-                    float* target = (float*)targetAttribs.uv0.data();
-                    int uvIndex = w - 8; // 4 pairs of (x,y) for positions
-                    original[uvIndex] += target[uvIndex] * nodeState.weights[w];
-                }
-            }
-            surface.surfaceDef.geo.Update(attribs, false);
-        }
+        ApplyMorphTargets(keyboardModelState_->nodeStates[nodeIndex]);
     }
     dirtyGeoNodeIndices_.clear();
 }